@@ -0,0 +1,725 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "Archetype.hpp"
+#include "Utilities.hpp"
+
+
+#define CHUNK_COLUMN_ALIGNMENT      ( 16 )
+
+namespace ECS
+{
+static void                AllocateRow( const EntityId entity, const uint32_t archetype_index, ArchetypeStorage *storage, uint32_t *chunk_out, uint32_t *row_out );
+static uint32_t            CreateArchetype( const ArchetypeSignature signature, ArchetypeStorage *storage );
+static bool                EnsureLocation( const uint32_t id, ArchetypeStorage *storage );
+static uint32_t            FindArchetype( const ArchetypeSignature signature, ArchetypeStorage *storage );
+static ArchetypeLocation * GetLocation( const EntityId entity, const ArchetypeStorage *storage );
+static uint32_t            GetTransition( const uint32_t from, const ComponentClass cls, const bool is_attach, ArchetypeStorage *storage );
+static void                MoveEntity( const uint32_t to, ArchetypeLocation *location, ArchetypeStorage *storage );
+static void                RemoveRow( const uint32_t archetype_index, const uint32_t chunk, const uint32_t row, ArchetypeStorage *storage );
+
+
+/*******************************************************************
+*
+*   Archetype_AttachComponent()
+*
+*   DESCRIPTION:
+*       Attach the component class to the entity, moving the entity
+*       to the archetype with the class added.  If the entity
+*       already has the class, return the existing component.
+*       Structure-of-arrays classes have no component struct to
+*       return, so return NULL - use Archetype_GetField().
+*
+*       The returned pointer is valid until the next structural
+*       change to the storage.
+*
+*******************************************************************/
+
+void * Archetype_AttachComponent( const EntityId entity, const ComponentClass cls, ArchetypeStorage *storage )
+{
+debug_assert( storage->lock_count == 0 );
+if( entity.id_and_version == INVALID_ENTITY_ID
+ || !EnsureLocation( entity.u.id, storage ) )
+    {
+    debug_assert_always();
+    return( NULL );
+    }
+
+ArchetypeLocation *location = &storage->locations[ entity.u.id ];
+if( location->entity.id_and_version == INVALID_ENTITY_ID )
+    {
+    location->entity    = entity;
+    location->archetype = ARCHETYPE_INVALID;
+    }
+else if( location->entity.id_and_version != entity.id_and_version )
+    {
+    /* a previous version of this id was never removed */
+    debug_assert_always();
+    return( NULL );
+    }
+else if( test_bits( storage->archetypes[ location->archetype ].signature, Archetype_SignatureOf( cls ) ) )
+    {
+    return( Archetype_GetComponent( entity, cls, storage ) );
+    }
+
+MoveEntity( GetTransition( location->archetype, cls, true, storage ), location, storage );
+
+return( Archetype_GetComponent( entity, cls, storage ) );
+
+} /* Archetype_AttachComponent() */
+
+
+/*******************************************************************
+*
+*   Archetype_CreateCursor()
+*
+*   DESCRIPTION:
+*       Create a cursor over every entity which has all of the
+*       required component classes.
+*
+*******************************************************************/
+
+void Archetype_CreateCursor( const ArchetypeSignature required, const ArchetypeStorage *storage, ArchetypeCursor *out )
+{
+*out = {};
+out->required  = required;
+out->archetype = storage->archetype_count;
+
+} /* Archetype_CreateCursor() */
+
+
+/*******************************************************************
+*
+*   Archetype_CursorNext()
+*
+*   DESCRIPTION:
+*       Step the cursor to the next matching entity.
+*       Returns FALSE once every matching entity has been visited.
+*
+*******************************************************************/
+
+bool Archetype_CursorNext( ArchetypeCursor *cursor, const ArchetypeStorage *storage )
+{
+while( true )
+    {
+    if( cursor->row > 0 )
+        {
+        cursor->row--;
+        return( true );
+        }
+
+    if( cursor->chunk > 0 )
+        {
+        cursor->chunk--;
+        cursor->row = storage->archetypes[ cursor->archetype ].chunks[ cursor->chunk ]->count;
+        continue;
+        }
+
+    if( cursor->archetype == 0 )
+        {
+        return( false );
+        }
+
+    cursor->archetype--;
+    const Archetype *archetype = &storage->archetypes[ cursor->archetype ];
+    cursor->chunk = test_bits( archetype->signature, cursor->required ) ? archetype->chunk_count : 0;
+    }
+
+} /* Archetype_CursorNext() */
+
+
+/*******************************************************************
+*
+*   Archetype_DestroyStorage()
+*
+*   DESCRIPTION:
+*       Free the storage and return it to uninitialized.
+*
+*******************************************************************/
+
+void Archetype_DestroyStorage( ArchetypeStorage *storage )
+{
+for( uint32_t i = 0; i < storage->archetype_count; i++ )
+    {
+    Archetype *archetype = &storage->archetypes[ i ];
+    for( uint32_t j = 0; j < archetype->chunk_count; j++ )
+        {
+        Utilities_AlignedFree( archetype->chunks[ j ] );
+        }
+
+    free( archetype->chunks );
+    }
+
+free( storage->archetypes );
+free( storage->locations );
+*storage = {};
+
+} /* Archetype_DestroyStorage() */
+
+
+/*******************************************************************
+*
+*   Archetype_EntityHasComponent()
+*
+*   DESCRIPTION:
+*       Does the entity have the given component class?
+*
+*******************************************************************/
+
+bool Archetype_EntityHasComponent( const EntityId entity, const ComponentClass cls, const ArchetypeStorage *storage )
+{
+const ArchetypeLocation *location = GetLocation( entity, storage );
+if( !location )
+    {
+    return( false );
+    }
+
+return( test_bits( storage->archetypes[ location->archetype ].signature, Archetype_SignatureOf( cls ) ) );
+
+} /* Archetype_EntityHasComponent() */
+
+
+/*******************************************************************
+*
+*   Archetype_GetComponent()
+*
+*   DESCRIPTION:
+*       Get the entity's component, or NULL if it doesn't have one.
+*       Always NULL for structure-of-arrays classes.
+*
+*******************************************************************/
+
+void * Archetype_GetComponent( const EntityId entity, const ComponentClass cls, ArchetypeStorage *storage )
+{
+const ArchetypeLocation *location = GetLocation( entity, storage );
+if( !location
+ || GetComponentClassSoALayout( cls ) )
+    {
+    return( NULL );
+    }
+
+return( Archetype_GetChunkEntry( cls, 0, location->chunk, location->row, &storage->archetypes[ location->archetype ] ) );
+
+} /* Archetype_GetComponent() */
+
+
+/*******************************************************************
+*
+*   Archetype_GetField()
+*
+*   DESCRIPTION:
+*       Get the given field of the entity's structure-of-arrays
+*       component, or NULL if it doesn't have one.
+*
+*******************************************************************/
+
+void * Archetype_GetField( const EntityId entity, const ComponentClass cls, const uint8_t field, ArchetypeStorage *storage )
+{
+const ComponentClassSoALayout *layout = GetComponentClassSoALayout( cls );
+debug_assert( layout );
+
+const ArchetypeLocation *location = GetLocation( entity, storage );
+if( !location
+ || !layout
+ || field >= layout->field_count )
+    {
+    return( NULL );
+    }
+
+return( Archetype_GetChunkEntry( cls, field, location->chunk, location->row, &storage->archetypes[ location->archetype ] ) );
+
+} /* Archetype_GetField() */
+
+
+/*******************************************************************
+*
+*   Archetype_InitStorage()
+*
+*   DESCRIPTION:
+*       Initialize the storage as empty.  Nothing is allocated until
+*       the first component is attached.
+*
+*******************************************************************/
+
+void Archetype_InitStorage( ArchetypeStorage *storage )
+{
+*storage = {};
+for( uint32_t i = 0; i < cnt_of_array( storage->root_edges ); i++ )
+    {
+    storage->root_edges[ i ] = ARCHETYPE_INVALID;
+    }
+
+} /* Archetype_InitStorage() */
+
+
+/*******************************************************************
+*
+*   Archetype_RemoveComponent()
+*
+*   DESCRIPTION:
+*       Remove the component class from the entity, moving the
+*       entity to the archetype with the class taken away.
+*
+*******************************************************************/
+
+void Archetype_RemoveComponent( const EntityId entity, const ComponentClass cls, ArchetypeStorage *storage )
+{
+debug_assert( storage->lock_count == 0 );
+ArchetypeLocation *location = GetLocation( entity, storage );
+if( !location
+ || !test_bits( storage->archetypes[ location->archetype ].signature, Archetype_SignatureOf( cls ) ) )
+    {
+    return;
+    }
+
+MoveEntity( GetTransition( location->archetype, cls, false, storage ), location, storage );
+
+} /* Archetype_RemoveComponent() */
+
+
+/*******************************************************************
+*
+*   Archetype_RemoveEntity()
+*
+*   DESCRIPTION:
+*       Remove the entity and all of its components.
+*
+*******************************************************************/
+
+void Archetype_RemoveEntity( const EntityId entity, ArchetypeStorage *storage )
+{
+debug_assert( storage->lock_count == 0 );
+ArchetypeLocation *location = GetLocation( entity, storage );
+if( !location )
+    {
+    return;
+    }
+
+MoveEntity( ARCHETYPE_INVALID, location, storage );
+
+} /* Archetype_RemoveEntity() */
+
+
+/*******************************************************************
+*
+*   Archetype_ReportMetrics()
+*
+*   DESCRIPTION:
+*       Report the storage's memory usage and occupancy.
+*
+*******************************************************************/
+
+void Archetype_ReportMetrics( const ArchetypeStorage *storage, ArchetypeStorageMetrics *out )
+{
+*out = {};
+out->archetype_count = storage->archetype_count;
+out->memory_usage    = storage->archetype_capacity * sizeof(*storage->archetypes)
+                     + storage->location_capacity  * sizeof(*storage->locations);
+
+for( uint32_t i = 0; i < storage->archetype_count; i++ )
+    {
+    const Archetype *archetype = &storage->archetypes[ i ];
+    out->chunk_count  += archetype->chunk_count;
+    out->entity_count += archetype->entity_count;
+    out->memory_usage += archetype->chunk_count * archetype->chunk_size
+                       + archetype->chunk_array_capacity * sizeof(*archetype->chunks);
+    }
+
+} /* Archetype_ReportMetrics() */
+
+
+/*******************************************************************
+*
+*   AllocateRow()
+*
+*   DESCRIPTION:
+*       Append a zeroed row for the entity to the archetype's last
+*       chunk, starting a new chunk if it is full.
+*
+*******************************************************************/
+
+static void AllocateRow( const EntityId entity, const uint32_t archetype_index, ArchetypeStorage *storage, uint32_t *chunk_out, uint32_t *row_out )
+{
+Archetype *archetype = &storage->archetypes[ archetype_index ];
+if( archetype->chunk_count == 0
+ || archetype->chunks[ archetype->chunk_count - 1 ]->count >= archetype->chunk_capacity )
+    {
+    if( archetype->chunk_count >= archetype->chunk_array_capacity )
+        {
+        uint32_t new_capacity = Utilities_ClampToMinU32( 2 * archetype->chunk_array_capacity, 8 );
+        ArchetypeChunk **new_chunks = (ArchetypeChunk**)realloc( archetype->chunks, new_capacity * sizeof(*new_chunks) );
+        hard_assert( new_chunks );
+
+        archetype->chunks               = new_chunks;
+        archetype->chunk_array_capacity = new_capacity;
+        }
+
+    /* the column layout is aligned relative to the chunk base */
+    ArchetypeChunk *chunk = (ArchetypeChunk*)Utilities_AlignedAlloc( archetype->chunk_size, CHUNK_COLUMN_ALIGNMENT );
+    hard_assert( chunk );
+    debug_assert( ( (uintptr_t)chunk & ( CHUNK_COLUMN_ALIGNMENT - 1 ) ) == 0 );
+
+    chunk->count = 0;
+    archetype->chunks[ archetype->chunk_count++ ] = chunk;
+    }
+
+uint32_t chunk_index = archetype->chunk_count - 1;
+uint32_t row         = archetype->chunks[ chunk_index ]->count++;
+archetype->entity_count++;
+
+EntityId *entities = (EntityId*)( (uint8_t*)archetype->chunks[ chunk_index ] + archetype->entity_offset );
+entities[ row ] = entity;
+for( uint8_t i = 0; i < archetype->column_count; i++ )
+    {
+    memset( (uint8_t*)archetype->chunks[ chunk_index ] + archetype->column_offsets[ i ] + (size_t)row * archetype->column_sizes[ i ], 0, archetype->column_sizes[ i ] );
+    }
+
+*chunk_out = chunk_index;
+*row_out   = row;
+
+} /* AllocateRow() */
+
+
+/*******************************************************************
+*
+*   CreateArchetype()
+*
+*   DESCRIPTION:
+*       Create an empty archetype for the signature, and lay out its
+*       chunks.  Columns are ordered by class, and each is aligned
+*       for SIMD access.
+*       Returns the index of the new archetype.
+*
+*******************************************************************/
+
+static uint32_t CreateArchetype( const ArchetypeSignature signature, ArchetypeStorage *storage )
+{
+if( storage->archetype_count >= storage->archetype_capacity )
+    {
+    uint32_t new_capacity = Utilities_ClampToMinU32( 2 * storage->archetype_capacity, 16 );
+    Archetype *new_archetypes = (Archetype*)realloc( storage->archetypes, new_capacity * sizeof(*new_archetypes) );
+    hard_assert( new_archetypes );
+
+    storage->archetypes         = new_archetypes;
+    storage->archetype_capacity = new_capacity;
+    }
+
+uint32_t ret = storage->archetype_count++;
+Archetype *archetype = &storage->archetypes[ ret ];
+*archetype = {};
+archetype->signature = signature;
+for( uint32_t i = 0; i < COMPONENT_CNT; i++ )
+    {
+    archetype->first_column[ i ] = ARCHETYPE_NO_COLUMN;
+    archetype->add_edges[ i ]    = ARCHETYPE_INVALID;
+    archetype->remove_edges[ i ] = ARCHETYPE_INVALID;
+    }
+
+/* gather the columns */
+uint32_t row_size = sizeof(EntityId);
+for( uint32_t i = 0; i < COMPONENT_CNT; i++ )
+    {
+    ComponentClass cls = (ComponentClass)i;
+    if( !test_bits( signature, Archetype_SignatureOf( cls ) ) )
+        {
+        continue;
+        }
+
+    archetype->first_column[ i ] = archetype->column_count;
+
+    const ComponentClassSoALayout *layout = GetComponentClassSoALayout( cls );
+    uint8_t field_count = layout ? layout->field_count : 1;
+    for( uint8_t j = 0; j < field_count; j++ )
+        {
+        uint8_t column = archetype->column_count++;
+        archetype->column_classes[ column ] = cls;
+        archetype->column_sizes[ column ]   = (uint32_t)( layout ? layout->fields[ j ].size : GetComponentClassSize( cls ) );
+        row_size += archetype->column_sizes[ column ];
+        }
+    }
+
+/* fit as many rows as the chunk allows, leaving room to align every column */
+uint32_t header_size = (uint32_t)align_size_round_up( sizeof(ArchetypeChunk), CHUNK_COLUMN_ALIGNMENT );
+uint32_t padding     = ( archetype->column_count + 1 ) * CHUNK_COLUMN_ALIGNMENT;
+archetype->chunk_capacity = 1;
+if( header_size + padding + row_size < ARCHETYPE_CHUNK_SIZE )
+    {
+    archetype->chunk_capacity = ( ARCHETYPE_CHUNK_SIZE - header_size - padding ) / row_size;
+    }
+
+uint32_t offset = header_size;
+archetype->entity_offset = offset;
+offset += archetype->chunk_capacity * sizeof(EntityId);
+for( uint8_t i = 0; i < archetype->column_count; i++ )
+    {
+    offset = (uint32_t)align_size_round_up( offset, CHUNK_COLUMN_ALIGNMENT );
+    archetype->column_offsets[ i ] = offset;
+    offset += archetype->chunk_capacity * archetype->column_sizes[ i ];
+    }
+
+/* oversized components get a chunk of their own size */
+archetype->chunk_size = max_of_vals( offset, (uint32_t)ARCHETYPE_CHUNK_SIZE );
+
+return( ret );
+
+} /* CreateArchetype() */
+
+
+/*******************************************************************
+*
+*   EnsureLocation()
+*
+*   DESCRIPTION:
+*       Make sure the location table covers the given entity id.
+*       Returns FALSE if it could not be grown.
+*
+*******************************************************************/
+
+static bool EnsureLocation( const uint32_t id, ArchetypeStorage *storage )
+{
+if( id < storage->location_capacity )
+    {
+    return( true );
+    }
+
+uint32_t new_capacity = Utilities_ClampToMinU32( 2 * storage->location_capacity, 64 );
+new_capacity = max_of_vals( new_capacity, id + 1 );
+
+ArchetypeLocation *new_locations = (ArchetypeLocation*)realloc( storage->locations, new_capacity * sizeof(*new_locations) );
+if( !new_locations )
+    {
+    return( false );
+    }
+
+for( uint32_t i = storage->location_capacity; i < new_capacity; i++ )
+    {
+    new_locations[ i ].entity.id_and_version = INVALID_ENTITY_ID;
+    new_locations[ i ].archetype             = ARCHETYPE_INVALID;
+    }
+
+storage->locations         = new_locations;
+storage->location_capacity = new_capacity;
+
+return( true );
+
+} /* EnsureLocation() */
+
+
+/*******************************************************************
+*
+*   FindArchetype()
+*
+*   DESCRIPTION:
+*       Find the archetype with exactly the given signature,
+*       creating it if there isn't one yet.
+*
+*******************************************************************/
+
+static uint32_t FindArchetype( const ArchetypeSignature signature, ArchetypeStorage *storage )
+{
+for( uint32_t i = 0; i < storage->archetype_count; i++ )
+    {
+    if( storage->archetypes[ i ].signature == signature )
+        {
+        return( i );
+        }
+    }
+
+return( CreateArchetype( signature, storage ) );
+
+} /* FindArchetype() */
+
+
+/*******************************************************************
+*
+*   GetLocation()
+*
+*   DESCRIPTION:
+*       Get the entity's location, or NULL if it has no components.
+*
+*******************************************************************/
+
+static ArchetypeLocation * GetLocation( const EntityId entity, const ArchetypeStorage *storage )
+{
+if( entity.id_and_version == INVALID_ENTITY_ID
+ || entity.u.id >= storage->location_capacity )
+    {
+    return( NULL );
+    }
+
+ArchetypeLocation *ret = &storage->locations[ entity.u.id ];
+if( ret->entity.id_and_version != entity.id_and_version
+ || ret->archetype == ARCHETYPE_INVALID )
+    {
+    return( NULL );
+    }
+
+return( ret );
+
+} /* GetLocation() */
+
+
+/*******************************************************************
+*
+*   GetTransition()
+*
+*   DESCRIPTION:
+*       Get the archetype reached by attaching or removing the class
+*       from the given archetype, following the cached edge when
+*       there is one.  ARCHETYPE_INVALID stands for the empty set of
+*       classes in both directions.
+*
+*******************************************************************/
+
+static uint32_t GetTransition( const uint32_t from, const ComponentClass cls, const bool is_attach, ArchetypeStorage *storage )
+{
+uint32_t *edge = NULL;
+if( from == ARCHETYPE_INVALID )
+    {
+    debug_assert( is_attach );
+    edge = &storage->root_edges[ cls ];
+    }
+else
+    {
+    edge = is_attach ? &storage->archetypes[ from ].add_edges[ cls ] : &storage->archetypes[ from ].remove_edges[ cls ];
+    }
+
+if( *edge != ARCHETYPE_INVALID )
+    {
+    return( *edge );
+    }
+
+ArchetypeSignature signature = ( from == ARCHETYPE_INVALID ) ? 0 : storage->archetypes[ from ].signature;
+if( is_attach )
+    {
+    signature |= Archetype_SignatureOf( cls );
+    }
+else
+    {
+    signature &= ~Archetype_SignatureOf( cls );
+    }
+
+if( signature == 0 )
+    {
+    return( ARCHETYPE_INVALID );
+    }
+
+uint32_t ret = FindArchetype( signature, storage );
+
+/* creating the archetype may have moved the edge */
+if( from == ARCHETYPE_INVALID )
+    {
+    storage->root_edges[ cls ] = ret;
+    }
+else if( is_attach )
+    {
+    storage->archetypes[ from ].add_edges[ cls ] = ret;
+    }
+else
+    {
+    storage->archetypes[ from ].remove_edges[ cls ] = ret;
+    }
+
+return( ret );
+
+} /* GetTransition() */
+
+
+/*******************************************************************
+*
+*   MoveEntity()
+*
+*   DESCRIPTION:
+*       Move the entity to another archetype, carrying over the
+*       components the two share.  Moving to ARCHETYPE_INVALID
+*       drops every component.
+*
+*******************************************************************/
+
+static void MoveEntity( const uint32_t to, ArchetypeLocation *location, ArchetypeStorage *storage )
+{
+uint32_t from = location->archetype;
+if( to == ARCHETYPE_INVALID )
+    {
+    RemoveRow( from, location->chunk, location->row, storage );
+    location->entity.id_and_version = INVALID_ENTITY_ID;
+    location->archetype             = ARCHETYPE_INVALID;
+    return;
+    }
+
+uint32_t chunk;
+uint32_t row;
+AllocateRow( location->entity, to, storage, &chunk, &row );
+
+if( from != ARCHETYPE_INVALID )
+    {
+    const Archetype *src = &storage->archetypes[ from ];
+    const Archetype *dst = &storage->archetypes[ to ];
+    for( uint8_t i = 0; i < dst->column_count; i++ )
+        {
+        ComponentClass cls = dst->column_classes[ i ];
+        if( src->first_column[ cls ] == ARCHETYPE_NO_COLUMN )
+            {
+            continue;
+            }
+
+        uint8_t field = i - dst->first_column[ cls ];
+        memcpy( Archetype_GetChunkEntry( cls, field, chunk, row, dst ), Archetype_GetChunkEntry( cls, field, location->chunk, location->row, src ), dst->column_sizes[ i ] );
+        }
+
+    RemoveRow( from, location->chunk, location->row, storage );
+    }
+
+location->archetype = to;
+location->chunk     = chunk;
+location->row       = row;
+
+} /* MoveEntity() */
+
+
+/*******************************************************************
+*
+*   RemoveRow()
+*
+*   DESCRIPTION:
+*       Remove a row from the archetype by moving its last row into
+*       the hole, freeing the last chunk once it is empty.
+*
+*******************************************************************/
+
+static void RemoveRow( const uint32_t archetype_index, const uint32_t chunk, const uint32_t row, ArchetypeStorage *storage )
+{
+Archetype *archetype = &storage->archetypes[ archetype_index ];
+uint32_t last_chunk = archetype->chunk_count - 1;
+uint32_t last_row   = archetype->chunks[ last_chunk ]->count - 1;
+
+if( chunk != last_chunk
+ || row != last_row )
+    {
+    uint8_t *hole = (uint8_t*)archetype->chunks[ chunk ];
+    uint8_t *last = (uint8_t*)archetype->chunks[ last_chunk ];
+
+    EntityId moved = Archetype_GetChunkEntity( last_chunk, last_row, archetype );
+    ( (EntityId*)( hole + archetype->entity_offset ) )[ row ] = moved;
+    for( uint8_t i = 0; i < archetype->column_count; i++ )
+        {
+        size_t size = archetype->column_sizes[ i ];
+        memcpy( hole + archetype->column_offsets[ i ] + row * size, last + archetype->column_offsets[ i ] + last_row * size, size );
+        }
+
+    storage->locations[ moved.u.id ].chunk = chunk;
+    storage->locations[ moved.u.id ].row   = row;
+    }
+
+archetype->entity_count--;
+if( --archetype->chunks[ last_chunk ]->count == 0 )
+    {
+    Utilities_AlignedFree( archetype->chunks[ last_chunk ] );
+    archetype->chunk_count--;
+    }
+
+} /* RemoveRow() */
+
+
+} /* namespace ECS */
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ComponentClass.hpp"
+#include "Entity.hpp"
+#include "Utilities.hpp"
+
+#define ARCHETYPE_CHUNK_SIZE        ( 16 * 1024 )
+#define ARCHETYPE_INVALID           ( 0xffffffff )
+#define ARCHETYPE_NO_COLUMN         ( 0xff )
+#define ARCHETYPE_MAX_COLUMN_COUNT  ( COMPONENT_CNT * COMPONENT_MAX_SOA_FIELD_COUNT )
+
+namespace ECS
+{
+typedef uint32_t ArchetypeSignature;    /* one bit per component class */
+
+compiler_assert( COMPONENT_CNT <= 8 * sizeof(ArchetypeSignature), archetype_hpp );
+
+/*******************************************************************
+*
+*   ArchetypeChunk
+*
+*   DESCRIPTION:
+*       A fixed size block holding up to the archetype's chunk
+*       capacity of entities.  The header is followed by the entity
+*       ids, and then one column per component (or per field of a
+*       structure-of-arrays component), at the archetype's offsets.
+*
+*******************************************************************/
+
+typedef struct _ArchetypeChunk
+    {
+    uint32_t            count;
+    } ArchetypeChunk;
+
+/*******************************************************************
+*
+*   Archetype
+*
+*   DESCRIPTION:
+*       Every entity with exactly the archetype's set of component
+*       classes.  Entities are kept packed, so only the last chunk
+*       is ever partially filled.
+*
+*******************************************************************/
+
+typedef struct _Archetype
+    {
+    ArchetypeSignature  signature;
+    uint32_t            entity_count;
+    uint32_t            chunk_capacity;     /* entities per chunk */
+    uint32_t            chunk_size;
+    ArchetypeChunk    **chunks;
+    uint32_t            chunk_count;
+    uint32_t            chunk_array_capacity;
+    uint32_t            entity_offset;
+    uint8_t             column_count;
+    uint8_t             first_column[ COMPONENT_CNT ];
+    ComponentClass      column_classes[ ARCHETYPE_MAX_COLUMN_COUNT ];
+    uint32_t            column_offsets[ ARCHETYPE_MAX_COLUMN_COUNT ];
+    uint32_t            column_sizes[ ARCHETYPE_MAX_COLUMN_COUNT ];
+    uint32_t            add_edges[ COMPONENT_CNT ];     /* archetype after attaching the class */
+    uint32_t            remove_edges[ COMPONENT_CNT ];  /* archetype after removing the class  */
+    } Archetype;
+
+typedef struct _ArchetypeLocation
+    {
+    EntityId            entity;         /* INVALID_ENTITY_ID if the entity has no components */
+    uint32_t            archetype;
+    uint32_t            chunk;
+    uint32_t            row;
+    } ArchetypeLocation;
+
+typedef struct _ArchetypeStorage
+    {
+    Archetype          *archetypes;
+    uint32_t            archetype_count;
+    uint32_t            archetype_capacity;
+    ArchetypeLocation  *locations;      /* indexed by entity id */
+    uint32_t            location_capacity;
+    uint32_t            root_edges[ COMPONENT_CNT ];    /* archetype of just the class */
+    uint32_t            lock_count;     /* structural changes are illegal while iterating in parallel */
+    } ArchetypeStorage;
+
+/*******************************************************************
+*
+*   ArchetypeCursor
+*
+*   DESCRIPTION:
+*       Walks every entity in the archetypes which have all of the
+*       required classes, from the last archetype, chunk and row to
+*       the first.  Removing the entity at the cursor is safe.
+*
+*******************************************************************/
+
+typedef struct _ArchetypeCursor
+    {
+    ArchetypeSignature  required;
+    uint32_t            archetype;
+    uint32_t            chunk;
+    uint32_t            row;
+    } ArchetypeCursor;
+
+typedef struct _ArchetypeStorageMetrics
+    {
+    size_t              memory_usage;
+    uint32_t            archetype_count;
+    uint32_t            chunk_count;
+    uint32_t            entity_count;
+    } ArchetypeStorageMetrics;
+
+void *   Archetype_AttachComponent( const EntityId entity, const ComponentClass cls, ArchetypeStorage *storage );
+void     Archetype_CreateCursor( const ArchetypeSignature required, const ArchetypeStorage *storage, ArchetypeCursor *out );
+bool     Archetype_CursorNext( ArchetypeCursor *cursor, const ArchetypeStorage *storage );
+void     Archetype_DestroyStorage( ArchetypeStorage *storage );
+bool     Archetype_EntityHasComponent( const EntityId entity, const ComponentClass cls, const ArchetypeStorage *storage );
+void *   Archetype_GetComponent( const EntityId entity, const ComponentClass cls, ArchetypeStorage *storage );
+void *   Archetype_GetField( const EntityId entity, const ComponentClass cls, const uint8_t field, ArchetypeStorage *storage );
+void     Archetype_InitStorage( ArchetypeStorage *storage );
+void     Archetype_RemoveComponent( const EntityId entity, const ComponentClass cls, ArchetypeStorage *storage );
+void     Archetype_RemoveEntity( const EntityId entity, ArchetypeStorage *storage );
+void     Archetype_ReportMetrics( const ArchetypeStorage *storage, ArchetypeStorageMetrics *out );
+
+
+/*******************************************************************
+*
+*   Archetype_GetChunkEntry()
+*
+*   DESCRIPTION:
+*       Address the given column of a row in an archetype chunk.
+*       Returns NULL if the archetype doesn't have the class.
+*
+*******************************************************************/
+
+static inline void * Archetype_GetChunkEntry( const ComponentClass cls, const uint8_t field, const uint32_t chunk, const uint32_t row, const Archetype *archetype )
+{
+uint8_t column = archetype->first_column[ cls ];
+if( column == ARCHETYPE_NO_COLUMN )
+    {
+    return( NULL );
+    }
+
+column += field;
+return( (void*)( (uint8_t*)archetype->chunks[ chunk ] + archetype->column_offsets[ column ] + (size_t)row * archetype->column_sizes[ column ] ) );
+
+} /* Archetype_GetChunkEntry() */
+
+
+/*******************************************************************
+*
+*   Archetype_GetChunkEntity()
+*
+*   DESCRIPTION:
+*       Get the entity at the given row of an archetype chunk.
+*
+*******************************************************************/
+
+static inline EntityId Archetype_GetChunkEntity( const uint32_t chunk, const uint32_t row, const Archetype *archetype )
+{
+const EntityId *entities = (const EntityId*)( (const uint8_t*)archetype->chunks[ chunk ] + archetype->entity_offset );
+return( entities[ row ] );
+
+} /* Archetype_GetChunkEntity() */
+
+
+/*******************************************************************
+*
+*   Archetype_SignatureOf()
+*
+*   DESCRIPTION:
+*       Get the signature bit of a single component class.
+*
+*******************************************************************/
+
+static inline ArchetypeSignature Archetype_SignatureOf( const ComponentClass cls )
+{
+return( (ArchetypeSignature)1 << (uint32_t)cls );
+
+} /* Archetype_SignatureOf() */
+
+} /* namespace ECS */
@@ -1,11 +1,16 @@
+#define HAVE_STRUCT_TIMESPEC
+#include "pthread.h"
 
 #include <cassert>
 #include <cstdlib>
 
 #include "Command.hpp"
 #include "Math.hpp"
+#include "MessageQueue.hpp"
 #include "Universe.hpp"
-#include "NonOwningGroup.hpp"
+
+#define COMMAND_QUEUE_FRAME_CAPACITY \
+                                    ( 64 * 1024 )
 
 namespace ECS
 {
@@ -34,8 +39,8 @@ typedef struct _CommandSystem
     uint16_t            count;
     CommandProcessorsCache
                         cache[ PENDING_COMMAND_CLASS_COUNT ];
-    NonOwningGroupIterator
-                        group;
+    MessageQueue        queue;
+    pthread_mutex_t     queue_mutex;
     } CommandSystem;
 
 
@@ -142,6 +147,8 @@ else
     Math_BitArrayClear( interests->ba, command );
     }
 
+system->cache[ command ].needs_rebuild = true;
+
 } /* Command_AddCommandClass() */
 
 
@@ -162,6 +169,15 @@ component->ptr = (CommandSystem*)malloc( sizeof(CommandSystem) );
 
 CommandSystem *system = AsCommandSystem( universe );
 *system = {};
+ResetCache( system );
+
+/* systems may post commands from scheduler worker threads */
+do_debug_assert( !pthread_mutex_init( &system->queue_mutex, NULL ) );
+
+if( !MessageQueue_Init( PENDING_COMMAND_CLASS_COUNT, sizeof(PendingCommandComponent), COMMAND_QUEUE_FRAME_CAPACITY, &system->queue ) )
+    {
+    return( false );
+    }
 
 Universe_RegisterCommandProcessors( universe );
 
@@ -182,6 +198,8 @@ return( true );
 void Command_Destroy( ECS::Universe *universe )
 {
 SingletonCommandComponent *component = (SingletonCommandComponent*)Universe_GetSingletonComponent( COMPONENT_SINGLETON_COMMAND, universe );
+MessageQueue_Destroy( &AsCommandSystem( universe )->queue );
+pthread_mutex_destroy( &AsCommandSystem( universe )->queue_mutex );
 free( component->ptr );
 component->ptr = NULL;
 
@@ -201,31 +219,67 @@ void Command_DoFrame( float frame_delta, ECS::Universe *universe )
 {
 CommandSystem *system = AsCommandSystem( universe );
 
-ResetCache( system );
-
-/* process */
-NonOwningGroup_CreateIterator( universe, &system->group, NonOwningGroup_GroupIds( COMPONENT_PENDING_COMMAND ) );
+/* commands posted by the processors will be processed next frame */
+do_debug_assert( !pthread_mutex_lock( &system->queue_mutex ) );
+MessageQueue_Swap( &system->queue );
+do_debug_assert( !pthread_mutex_unlock( &system->queue_mutex ) );
 
-EntityId entity;
-PendingCommandComponent *component;
-while( NonOwningGroup_GetNext( &system->group, &entity, (void**)&component ) )
+for( uint32_t i = 0; i < PENDING_COMMAND_CLASS_COUNT; i++ )
     {
-    CommandProcessorsCache *cache = EnsureCacheForCommand( component->cls, system );
-    for( uint16_t i = 0; i < cache->count; i++ )
+    if( MessageQueue_GetReadCount( i, &system->queue ) == 0 )
         {
-        cache->processors[ i ]( component, universe );
+        continue;
+        }
+
+    CommandProcessorsCache *cache = EnsureCacheForCommand( (PendingCommandClass)i, system );
+
+    MessageQueueIterator iterator;
+    MessageQueue_CreateIterator( i, &system->queue, &iterator );
+
+    const PendingCommandComponent *command;
+    while( ( command = (PendingCommandComponent*)MessageQueue_GetNext( &iterator ) ) != NULL )
+        {
+        for( uint16_t j = 0; j < cache->count; j++ )
+            {
+            cache->processors[ j ]( command, universe );
+            }
         }
     }
 
-/* cleanup */
-ComponentRegistry *command_registry = Universe_GetComponentRegistry( COMPONENT_PENDING_COMMAND, universe );
-while( Component_GetComponentCount( command_registry ) > 0 )
+/* cleanup - destroy the requested entities as one batch */
+Universe_DestroyDeferredEntities( universe );
+
+} /* Command_DoFrame() */
+
+
+/*******************************************************************
+*
+*   Command_PostPending()
+*
+*   DESCRIPTION:
+*       Post a command to be handled at the end of the frame.
+*       Safe to call from any thread.
+*
+*******************************************************************/
+
+void Command_PostPending( const PendingCommandClass cls, const PendingCommandCommand *command, Universe *universe )
+{
+CommandSystem *system = AsCommandSystem( universe );
+
+do_debug_assert( !pthread_mutex_lock( &system->queue_mutex ) );
+PendingCommandComponent *component = (PendingCommandComponent*)MessageQueue_Enqueue( cls, &system->queue );
+if( component )
     {
-    EntityId to_destroy = Component_GetEntityAtDenseIndex( 0, command_registry );
-    Universe_DestroyEntity( to_destroy, universe );
+    component->cls = cls;
+    if( command )
+        {
+        component->u = *command;
+        }
     }
 
-} /* Command_DoFrame() */
+do_debug_assert( !pthread_mutex_unlock( &system->queue_mutex ) );
+
+} /* Command_PostPending() */
 
 
 /*******************************************************************
@@ -241,6 +295,7 @@ void Command_RegisterCommandProcessor( const CommandProcessor processor, Command
 {
 CommandSystem *system = AsCommandSystem( universe );
 system->processors[ processor ] = processor_proc;
+ResetCache( system );
 
 } /* Command_RegisterCommandProcessor() */
 
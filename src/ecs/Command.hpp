@@ -28,33 +28,10 @@ bool Command_Init( ECS::Universe *universe );
 void Command_Destroy( ECS::Universe *universe );
 void Command_DoFrame( float frame_delta, ECS::Universe *universe );
 void Command_AddCommandClass( const CommandProcessor processor, const PendingCommandClass command, CommandProcessorAction action, Universe *universe );
+void Command_PostPending( const PendingCommandClass cls, const PendingCommandCommand *command, Universe *universe );
 void Command_RegisterCommandProcessor( const CommandProcessor processor, CommandProcedure *processor_proc, Universe *universe );
 
 
-/*******************************************************************
-*
-*   Command_PostPending()
-*
-*   DESCRIPTION:
-*       Helper function to post a command to be handled at the end
-*       of the frame.
-*
-*******************************************************************/
-
-static inline void Command_PostPending( const PendingCommandClass cls, const PendingCommandCommand *command, Universe *universe )
-{
-EntityId entity = Universe_CreateNewEntity( universe );
-PendingCommandComponent *component = (PendingCommandComponent*)Universe_AttachComponentToEntity( entity, COMPONENT_PENDING_COMMAND, universe );
-
-component->cls = cls;
-if( command )
-    {
-    component->u = *command;
-    }
-
-} /* Command_PostPending() */
-
-
 /*******************************************************************
 *
 *   Command_MakeBindHotVarBool()
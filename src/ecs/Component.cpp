@@ -5,19 +5,85 @@
 
 #include "Component.hpp"
 #include "Entity.hpp"
+#include "FrameAllocator.hpp"
+#include "ThreadPool.hpp"
 #include "Utilities.hpp"
 
 
 #define REGISTRY_SWAP_STORAGE       ( 1 )
-#define INVALID_DENSE_INDEX         max_uint_value( *( (ComponentRegistry*)NULL )->sparse )
+#define INVALID_DENSE_INDEX         max_uint_value( uint32_t )
+#define SPARSE_PAGE_MASK            ( COMPONENT_SPARSE_PAGE_COUNT - 1 )
+#define COMPONENT_COLUMN_ALIGNMENT  ( 16 )
 
 namespace ECS
 {
-static void   EnsureStorageForEntity( const EntityId entity, ComponentRegistry *registry );
-static void   ExpandDenseAndStorage( const uint32_t new_size, ComponentRegistry *registry );
-static void   ExpandSparse( const uint32_t new_size, ComponentRegistry *registry );
-static void * GetStorageAtIndex( const uint32_t index, ComponentRegistry *registry );
-static void   SwapMemory( const size_t size, void *a, void *b, void *scratch );
+typedef struct _ComponentChunkJob
+    {
+    ComponentChunk     *chunk;
+    ComponentChunkProc *proc;
+    void               *user;
+    } ComponentChunkJob;
+
+static void     AppendJournal( const EntityId entity, const uint32_t frame, ComponentJournal *journal );
+static void     ChunkJob( void *user );
+static void     EnsureStorageForEntity( const EntityId entity, ComponentRegistry *registry );
+static void     ExpandDenseAndStorage( const uint32_t new_size, ComponentRegistry *registry );
+static void     ExpandSparse( const uint32_t new_page_count, ComponentRegistry *registry );
+static uint32_t FindJournalFrame( const uint32_t frame, const ComponentJournal *journal );
+static void *   GetColumnEntry( const uint8_t column, const uint32_t index, ComponentRegistry *registry );
+static void     MoveComponents( const uint32_t dst, const uint32_t src, const uint32_t count, ComponentRegistry *registry );
+static void     SetSparse( const uint32_t id, const uint32_t dense_index, ComponentRegistry *registry );
+static void     SwapComponents( const uint32_t dense_a, const uint32_t dense_b, ComponentRegistry *registry );
+static void     SwapMemory( const size_t size, void *a, void *b, void *scratch );
+static void     TrimJournal( const uint32_t oldest_frame, ComponentJournal *journal );
+
+/* every unallocated page shares this - it is never written */
+static uint32_t s_null_sparse_page[ COMPONENT_SPARSE_PAGE_COUNT ];
+
+
+/*******************************************************************
+*
+*   get_sparse()
+*
+*   DESCRIPTION:
+*       Look up the dense index for the given entity id, or
+*       INVALID_DENSE_INDEX if there is none.
+*
+*******************************************************************/
+
+static inline uint32_t get_sparse( const uint32_t id, const ComponentRegistry *registry )
+{
+uint32_t page = id >> COMPONENT_SPARSE_PAGE_SHIFT;
+if( page >= registry->sparse_page_count )
+    {
+    return( INVALID_DENSE_INDEX );
+    }
+
+/* empty entries are stored as zero, so wrap to invalid */
+return( registry->sparse_pages[ page ][ id & SPARSE_PAGE_MASK ] - 1 );
+
+}   /* get_sparse() */
+
+
+/*******************************************************************
+*
+*   set_change_frame()
+*
+*   DESCRIPTION:
+*       Record the frame the entry at the given dense index last
+*       changed on, raising its block's newest change frame to
+*       match.  Entries moved in from elsewhere may carry an older
+*       frame, so the block frame only ever goes up.
+*
+*******************************************************************/
+
+static inline void set_change_frame( const uint32_t dense_index, const uint32_t frame, ComponentRegistry *registry )
+{
+uint32_t *block_frame = &registry->block_frames[ dense_index >> COMPONENT_CHANGE_BLOCK_SHIFT ];
+registry->change_frames[ dense_index ] = frame;
+*block_frame = max_of_vals( *block_frame, frame );
+
+}   /* set_change_frame() */
 
 
 /*******************************************************************
@@ -26,11 +92,15 @@ static void   SwapMemory( const size_t size, void *a, void *b, void *scratch );
 *
 *   DESCRIPTION:
 *       Attach this registry's component to the given entity.
+*       Structure-of-arrays classes have no component struct to
+*       return, so return NULL - use Component_GetField() to fill
+*       the zeroed fields.
 *
 *******************************************************************/
 
 void * Component_AttachComponent( const EntityId entity, ComponentRegistry *registry )
 {
+debug_assert( registry->lock_count == 0 );
 if( Component_EntityHasComponent( entity, registry ) )
     {
     assert( false );
@@ -46,18 +116,104 @@ EnsureStorageForEntity( entity, registry );
 
 /* Add the new capacity and clear the storage */
 uint32_t new_dense = registry->dense_count;
-registry->sparse[ entity.u.id ] = new_dense;
+SetSparse( entity.u.id, new_dense, registry );
 registry->dense[ new_dense ] = entity;
+set_change_frame( new_dense, registry->frame, registry );
 registry->dense_count++;
+AppendJournal( entity, registry->frame, &registry->added );
 
-void *ret = GetStorageAtIndex( new_dense, registry );
-memset( ret, 0, registry->storage_stride );
+for( uint8_t i = 0; i < registry->column_count; i++ )
+    {
+    memset( GetColumnEntry( i, new_dense, registry ), 0, registry->column_sizes[ i ] );
+    }
 
-return( ret );
+return( registry->is_soa ? NULL : GetColumnEntry( 0, new_dense, registry ) );
 
 }   /* Component_AttachComponent() */
 
 
+/*******************************************************************
+*
+*   Component_BeginFrame()
+*
+*   DESCRIPTION:
+*       Set the frame number that changes are stamped with from now
+*       on, and forget journal entries from before the given oldest
+*       frame.  Frame numbers must never go backwards.
+*
+*******************************************************************/
+
+void Component_BeginFrame( const uint32_t frame, const uint32_t oldest_journal_frame, ComponentRegistry *registry )
+{
+debug_assert( frame >= registry->frame );
+registry->frame = frame;
+
+TrimJournal( oldest_journal_frame, &registry->added );
+TrimJournal( oldest_journal_frame, &registry->removed );
+
+}   /* Component_BeginFrame() */
+
+
+/*******************************************************************
+*
+*   Component_CreateChangedIterator()
+*
+*   DESCRIPTION:
+*       Create an iterator over the entities whose component was
+*       attached or mutably accessed on or after the given frame.
+*       Pass the frame the consumer last ran on - anything changed
+*       later in that same frame will be visited again rather than
+*       missed.
+*
+*       Each block of COMPONENT_CHANGE_BLOCK_SIZE entries keeps its
+*       newest change frame, so blocks with nothing new are skipped
+*       whole, and only the entries of changed blocks are tested.
+*
+*******************************************************************/
+
+void Component_CreateChangedIterator( const uint32_t since_frame, ComponentRegistry *registry, ComponentChangedIterator *out )
+{
+*out = {};
+out->registry    = registry;
+out->since_frame = since_frame;
+out->iterator    = registry->dense_count;
+
+}   /* Component_CreateChangedIterator() */
+
+
+/*******************************************************************
+*
+*   Component_DeferRemoveInChunk()
+*
+*   DESCRIPTION:
+*       Request the component at the given index within the chunk be
+*       removed once the parallel iteration has finished.  Only the
+*       job processing the chunk may call this.
+*
+*******************************************************************/
+
+void Component_DeferRemoveInChunk( const uint32_t index_in_chunk, ComponentChunk *chunk )
+{
+debug_assert( index_in_chunk < chunk->count );
+if( chunk->deferred_remove_count >= chunk->deferred_remove_capacity )
+    {
+    uint32_t new_capacity = Utilities_ClampToMinU32( 2 * chunk->deferred_remove_capacity, 16 );
+    uint32_t *new_removes = (uint32_t*)realloc( chunk->deferred_removes, new_capacity * sizeof(*new_removes) );
+    if( !new_removes )
+        {
+        hard_assert_always();
+        return;
+        }
+
+    chunk->deferred_removes         = new_removes;
+    chunk->deferred_remove_capacity = new_capacity;
+    }
+
+chunk->deferred_removes[ chunk->deferred_remove_count++ ] = chunk->first + index_in_chunk;
+
+}   /* Component_DeferRemoveInChunk() */
+
+
 /*******************************************************************
 *
 *   Component_DestroyRegistry()
@@ -70,9 +226,27 @@ return( ret );
 
 void Component_DestroyRegistry( ComponentRegistry *registry )
 {
-free( registry->sparse );
+for( uint32_t i = 0; i < registry->sparse_page_count; i++ )
+    {
+    if( registry->sparse_pages[ i ] != s_null_sparse_page )
+        {
+        free( registry->sparse_pages[ i ] );
+        }
+    }
+
+free( registry->sparse_pages );
+free( registry->sparse_page_live );
 free( registry->dense );
-free( registry->storage );
+for( uint8_t i = 0; i < registry->column_count; i++ )
+    {
+    Utilities_AlignedFree( registry->columns[ i ] );
+    }
+
+free( registry->change_frames );
+free( registry->block_frames );
+free( registry->added.entries );
+free( registry->removed.entries );
+
 *registry = {};
 
 }   /* Component_DestroyRegistry() */
@@ -90,20 +264,62 @@ free( registry->storage );
 
 bool Component_EntityHasComponent( const EntityId entity, const ComponentRegistry *registry )
 {
-if( entity.u.id >= registry->sparse_capacity )
+uint32_t dense_index = get_sparse( entity.u.id, registry );
+if( dense_index >= registry->dense_count )
     {
     return( false );
     }
 
-uint32_t dense_index = registry->sparse[ entity.u.id ];
-if( dense_index > registry->dense_count )
+return( registry->dense[ dense_index ].id_and_version == entity.id_and_version );
+
+}   /* Component_EntityHasComponent() */
+
+
+/*******************************************************************
+*
+*   Component_GetAddedSince()
+*
+*   DESCRIPTION:
+*       Get the journal of attaches made on or after the given frame,
+*       oldest first.  Returns the number of entries.  The entities
+*       may since have lost the component again, or been destroyed.
+*
+*******************************************************************/
+
+uint32_t Component_GetAddedSince( const uint32_t since_frame, const ComponentRegistry *registry, const ComponentJournalEntry **out )
+{
+uint32_t first = FindJournalFrame( since_frame, &registry->added );
+*out = &registry->added.entries[ first ];
+
+return( registry->added.count - first );
+
+}   /* Component_GetAddedSince() */
+
+
+/*******************************************************************
+*
+*   Component_GetColumn()
+*
+*   DESCRIPTION:
+*       Get the column holding the given field of a
+*       structure-of-arrays class.  Entries are indexed by dense
+*       index, so the column is valid for Component_GetComponentCount()
+*       entries, until the next structural change.
+*
+*******************************************************************/
+
+void * Component_GetColumn( const uint8_t field, ComponentRegistry *registry )
+{
+debug_assert( registry->is_soa );
+if( field >= registry->column_count )
     {
-    return( false );
+    debug_assert_always();
+    return( NULL );
     }
 
-return( registry->dense[ dense_index ].id_and_version == entity.id_and_version );
+return( (void*)registry->columns[ field ] );
 
-}   /* Component_EntityHasComponent() */
+}   /* Component_GetColumn() */
 
 
 /*******************************************************************
@@ -111,19 +327,21 @@ return( registry->dense[ dense_index ].id_and_version == entity.id_and_version )
 *   Component_GetComponent()
 *
 *   DESCRIPTION:
-*       Allocate the registry's initial empty sparse array and
-*       storage.
+*       Get the entity's component, or NULL if it doesn't have one.
+*       Only array-of-structures classes have a component struct,
+*       so this is always NULL for structure-of-arrays classes.
 *
 *******************************************************************/
 
 void * Component_GetComponent( const EntityId entity, ComponentRegistry *registry )
 {
-if( !Component_EntityHasComponent( entity, registry ) )
+if( registry->is_soa
+ || !Component_EntityHasComponent( entity, registry ) )
     {
     return( NULL );
     }
 
-return( GetStorageAtIndex( registry->sparse[ entity.u.id ], registry ) );
+return( GetColumnEntry( 0, get_sparse( entity.u.id, registry ), registry ) );
 
 }   /* Component_GetComponent() */
 
@@ -156,11 +374,57 @@ return( registry->dense_count );
 void * Component_GetComponentAtDenseIndex( const uint32_t dense_index, ComponentRegistry *registry )
 {
 debug_assert( dense_index < registry->dense_count );
-return( GetStorageAtIndex( dense_index, registry ) );
+debug_assert( !registry->is_soa );
+return( registry->is_soa ? NULL : GetColumnEntry( 0, dense_index, registry ) );
 
 }   /* Component_GetComponentAtDenseIndex() */
 
 
+/*******************************************************************
+*
+*   Component_GetComponentMut()
+*
+*   DESCRIPTION:
+*       Get the entity's component for writing, or NULL if it
+*       doesn't have one.  Marks the component changed on the
+*       current frame.
+*
+*******************************************************************/
+
+void * Component_GetComponentMut( const EntityId entity, ComponentRegistry *registry )
+{
+if( registry->is_soa
+ || !Component_EntityHasComponent( entity, registry ) )
+    {
+    return( NULL );
+    }
+
+uint32_t dense_index = get_sparse( entity.u.id, registry );
+set_change_frame( dense_index, registry->frame, registry );
+
+return( GetColumnEntry( 0, dense_index, registry ) );
+
+}   /* Component_GetComponentMut() */
+
+
+/*******************************************************************
+*
+*   Component_GetDenseIndex()
+*
+*   DESCRIPTION:
+*       Get the dense index of the given entity's component.  The
+*       entity must have a component in this registry.
+*
+*******************************************************************/
+
+uint32_t Component_GetDenseIndex( const EntityId entity, const ComponentRegistry *registry )
+{
+debug_assert( Component_EntityHasComponent( entity, registry ) );
+return( get_sparse( entity.u.id, registry ) );
+
+}   /* Component_GetDenseIndex() */
+
+
 /*******************************************************************
 *
 *   Component_GetEntityAtDenseIndex()
@@ -179,6 +443,119 @@ return( registry->dense[ dense_index ] );
 }   /* Component_GetEntityAtDenseIndex() */
 
 
+/*******************************************************************
+*
+*   Component_GetField()
+*
+*   DESCRIPTION:
+*       Get the given field of the entity's structure-of-arrays
+*       component, or NULL if it doesn't have one.
+*
+*******************************************************************/
+
+void * Component_GetField( const EntityId entity, const uint8_t field, ComponentRegistry *registry )
+{
+debug_assert( registry->is_soa );
+if( field >= registry->column_count
+ || !Component_EntityHasComponent( entity, registry ) )
+    {
+    return( NULL );
+    }
+
+return( GetColumnEntry( field, get_sparse( entity.u.id, registry ), registry ) );
+
+}   /* Component_GetField() */
+
+
+/*******************************************************************
+*
+*   Component_GetFieldMut()
+*
+*   DESCRIPTION:
+*       Get the given field of the entity's structure-of-arrays
+*       component for writing, or NULL if it doesn't have one.
+*       Marks the whole component changed on the current frame.
+*
+*******************************************************************/
+
+void * Component_GetFieldMut( const EntityId entity, const uint8_t field, ComponentRegistry *registry )
+{
+debug_assert( registry->is_soa );
+if( field >= registry->column_count
+ || !Component_EntityHasComponent( entity, registry ) )
+    {
+    return( NULL );
+    }
+
+uint32_t dense_index = get_sparse( entity.u.id, registry );
+set_change_frame( dense_index, registry->frame, registry );
+
+return( GetColumnEntry( field, dense_index, registry ) );
+
+}   /* Component_GetFieldMut() */
+
+
+/*******************************************************************
+*
+*   Component_GetNextChanged()
+*
+*   DESCRIPTION:
+*       Get the next entity whose component changed since the
+*       iterator's frame.
+*
+*******************************************************************/
+
+bool Component_GetNextChanged( ComponentChangedIterator *iterator, EntityId *next )
+{
+ComponentRegistry *registry = iterator->registry;
+
+/* entries may have been removed since the last step */
+iterator->iterator = min_of_vals( iterator->iterator, registry->dense_count );
+while( iterator->iterator > 0 )
+    {
+    uint32_t dense_index = iterator->iterator - 1;
+    if( registry->block_frames[ dense_index >> COMPONENT_CHANGE_BLOCK_SHIFT ] < iterator->since_frame )
+        {
+        /* nothing in this block changed, skip to the one below */
+        iterator->iterator = dense_index & ~( COMPONENT_CHANGE_BLOCK_SIZE - 1 );
+        continue;
+        }
+
+    iterator->iterator = dense_index;
+    if( registry->change_frames[ dense_index ] >= iterator->since_frame )
+        {
+        *next = registry->dense[ dense_index ];
+        return( true );
+        }
+    }
+
+next->id_and_version = INVALID_ENTITY_ID;
+return( false );
+
+}   /* Component_GetNextChanged() */
+
+
+/*******************************************************************
+*
+*   Component_GetRemovedSince()
+*
+*   DESCRIPTION:
+*       Get the journal of removes made on or after the given frame,
+*       oldest first.  Returns the number of entries.  The entities
+*       may since have had the component attached again.
+*
+*******************************************************************/
+
+uint32_t Component_GetRemovedSince( const uint32_t since_frame, const ComponentRegistry *registry, const ComponentJournalEntry **out )
+{
+uint32_t first = FindJournalFrame( since_frame, &registry->removed );
+*out = &registry->removed.entries[ first ];
+
+return( registry->removed.count - first );
+
+}   /* Component_GetRemovedSince() */
+
+
 /*******************************************************************
 *
 *   Component_InitRegistry()
@@ -195,9 +572,147 @@ void Component_InitRegistry( const size_t storage_stride, const ComponentClass c
 registry->storage_stride = storage_stride;
 registry->cls            = cls;
 
+const ComponentClassSoALayout *layout = GetComponentClassSoALayout( cls );
+if( layout )
+    {
+    registry->is_soa       = true;
+    registry->column_count = layout->field_count;
+    for( uint8_t i = 0; i < layout->field_count; i++ )
+        {
+        registry->column_sizes[ i ] = layout->fields[ i ].size;
+        }
+    }
+else
+    {
+    registry->column_count      = 1;
+    registry->column_sizes[ 0 ] = storage_stride;
+    }
+
 }   /* Entity_InitRegistry() */
 
 
+/*******************************************************************
+*
+*   Component_ParallelForEach()
+*
+*   DESCRIPTION:
+*       Split the registry's dense range into chunks, and run the
+*       procedure over each of them on the thread pool.  Returns
+*       once every chunk has been processed.
+*
+*       The registry is locked for the duration, so chunks may not
+*       attach or remove components directly - removals requested
+*       with Component_DeferRemoveInChunk() are applied as a single
+*       batch after the parallel section.  Removal bypasses the
+*       universe, so deferring a remove from a registry that is owned
+*       by a group or has remove listeners is a hard error - iterate
+*       those through NonOwningGroup_ParallelForEach() instead, whose
+*       removals go through the universe.
+*
+*******************************************************************/
+
+void Component_ParallelForEach( ComponentRegistry *registry, const uint32_t chunk_size, ComponentChunkProc *proc, void *user, ThreadPool *pool )
+{
+debug_assert( chunk_size > 0 );
+uint32_t count = registry->dense_count;
+if( count == 0 )
+    {
+    return;
+    }
+
+uint32_t chunk_count = ( count + chunk_size - 1 ) / chunk_size;
+FrameAllocatorMarker scope = FrameAllocator_BeginScope();
+ComponentChunk    *chunks = FrameAllocator_AllocateArray( ComponentChunk, chunk_count );
+ComponentChunkJob *jobs   = FrameAllocator_AllocateArray( ComponentChunkJob, chunk_count );
+
+registry->lock_count++;
+
+ThreadPoolCounter counter;
+ThreadPool_InitCounter( &counter );
+for( uint32_t i = 0; i < chunk_count; i++ )
+    {
+    ComponentChunk *chunk = &chunks[ i ];
+    *chunk = {};
+    chunk->registry      = registry;
+    chunk->first         = i * chunk_size;
+    chunk->count         = min_of_vals( chunk_size, count - chunk->first );
+    chunk->entities      = &registry->dense[ chunk->first ];
+    chunk->stride        = registry->storage_stride;
+    chunk->change_frames = &registry->change_frames[ chunk->first ];
+    chunk->frame         = registry->frame;
+    if( registry->is_soa )
+        {
+        for( uint8_t j = 0; j < registry->column_count; j++ )
+            {
+            chunk->columns[ j ] = (uint8_t*)GetColumnEntry( j, chunk->first, registry );
+            }
+        }
+    else
+        {
+        chunk->components = (uint8_t*)GetColumnEntry( 0, chunk->first, registry );
+        }
+
+    jobs[ i ].chunk = chunk;
+    jobs[ i ].proc  = proc;
+    jobs[ i ].user  = user;
+    ThreadPool_Submit( ChunkJob, &jobs[ i ], &counter, pool );
+    }
+
+ThreadPool_WaitForCounter( &counter, pool );
+registry->lock_count--;
+
+/* chunks may share blocks, so raise the block frames after the jobs rather than in them */
+for( uint32_t i = 0; i < chunk_count; i++ )
+    {
+    if( !chunks[ i ].is_changed )
+        {
+        continue;
+        }
+
+    uint32_t first_block = chunks[ i ].first >> COMPONENT_CHANGE_BLOCK_SHIFT;
+    uint32_t last_block  = ( chunks[ i ].first + chunks[ i ].count - 1 ) >> COMPONENT_CHANGE_BLOCK_SHIFT;
+    for( uint32_t j = first_block; j <= last_block; j++ )
+        {
+        registry->block_frames[ j ] = registry->frame;
+        }
+    }
+
+/* apply the deferred removals as one batch */
+uint32_t remove_count = 0;
+for( uint32_t i = 0; i < chunk_count; i++ )
+    {
+    remove_count += chunks[ i ].deferred_remove_count;
+    }
+
+if( remove_count > 0 )
+    {
+    /* no lifetime notifications or group packing on this path */
+    hard_assert( !registry->is_removal_observed );
+    uint32_t *removes = FrameAllocator_AllocateArray( uint32_t, remove_count );
+
+    uint32_t write = 0;
+    for( uint32_t i = 0; i < chunk_count; i++ )
+        {
+        if( chunks[ i ].deferred_remove_count > 0 )
+            {
+            memcpy( &removes[ write ], chunks[ i ].deferred_removes, chunks[ i ].deferred_remove_count * sizeof(*removes) );
+            write += chunks[ i ].deferred_remove_count;
+            }
+        }
+
+    Component_RemoveComponentsAtDenseIndices( removes, remove_count, registry );
+    }
+
+for( uint32_t i = 0; i < chunk_count; i++ )
+    {
+    free( chunks[ i ].deferred_removes );
+    }
+
+FrameAllocator_EndScope( scope );
+
+}   /* Component_ParallelForEach() */
+
+
 /*******************************************************************
 *
 *   Component_RemoveComponent()
@@ -209,6 +724,7 @@ registry->cls            = cls;
 
 void Component_RemoveComponent( const EntityId entity, ComponentRegistry *registry )
 {
+debug_assert( registry->lock_count == 0 );
 if( !Component_EntityHasComponent( entity, registry ) )
     {
     assert( false );
@@ -217,45 +733,234 @@ if( !Component_EntityHasComponent( entity, registry ) )
 
 /* swap-pack the dense array and storage */
 uint32_t sparse_remove = entity.u.id;
-uint32_t dense_remove  = registry->sparse[ entity.u.id ];
+uint32_t dense_remove  = get_sparse( entity.u.id, registry );
 uint32_t dense_swap    = registry->dense_count - 1;
 uint32_t sparse_swap   = registry->dense[ dense_swap ].u.id;
-assert( registry->sparse[ sparse_swap ] == dense_swap );
+assert( get_sparse( sparse_swap, registry ) == dense_swap );
 
-void *scratch = GetStorageAtIndex( registry->dense_storage_capacity, registry ); // TODO <MPA> - Rework this so we don't have to require scratch for singleton components which will never reach a size of more than 1
-SwapMemory( registry->storage_stride,  GetStorageAtIndex( dense_remove, registry ), GetStorageAtIndex( dense_swap, registry ), scratch );
-SwapMemory( sizeof(*registry->sparse), &registry->sparse[ sparse_remove ],          &registry->sparse[ sparse_swap ],          scratch );
-SwapMemory( sizeof(*registry->dense),  &registry->dense[ dense_remove ],            &registry->dense[ dense_swap ],            scratch );
+SwapComponents( dense_remove, dense_swap, registry );
 
+SetSparse( sparse_swap, dense_remove, registry );
+SetSparse( sparse_remove, INVALID_DENSE_INDEX, registry );
 registry->dense[ dense_swap ].id_and_version = INVALID_ENTITY_ID;
-registry->sparse[ sparse_remove ]            = INVALID_DENSE_INDEX;
 registry->dense_count--;
 
+AppendJournal( entity, registry->frame, &registry->removed );
+
 }   /* Component_RemoveComponent() */
 
 
+/*******************************************************************
+*
+*   Component_RemoveComponentsAtDenseIndices()
+*
+*   DESCRIPTION:
+*       Remove the components at each of the given dense indices,
+*       compacting the dense and storage arrays in a single pass.
+*       The surviving components keep their relative order.  The
+*       given indices must be unique, and will be radix sorted in
+*       place, so the cost stays linear in the removal count.
+*
+*******************************************************************/
+
+void Component_RemoveComponentsAtDenseIndices( uint32_t *dense_indices, const uint32_t count, ComponentRegistry *registry )
+{
+debug_assert( registry->lock_count == 0 );
+if( count == 0 )
+    {
+    return;
+    }
+
+FrameAllocatorMarker scope = FrameAllocator_BeginScope();
+Utilities_RadixSortU32Ascending( count, dense_indices, FrameAllocator_AllocateArray( uint32_t, count ) );
+FrameAllocator_EndScope( scope );
+debug_assert( dense_indices[ count - 1 ] < registry->dense_count );
+
+/* slide each run of survivors down over the removed slots */
+uint32_t write = dense_indices[ 0 ];
+for( uint32_t i = 0; i < count; i++ )
+    {
+    uint32_t dense_remove = dense_indices[ i ];
+    debug_assert( i == 0 || dense_remove > dense_indices[ i - 1 ] );
+    AppendJournal( registry->dense[ dense_remove ], registry->frame, &registry->removed );
+    SetSparse( registry->dense[ dense_remove ].u.id, INVALID_DENSE_INDEX, registry );
+
+    uint32_t run_start = dense_remove + 1;
+    uint32_t run_end   = ( i + 1 < count ) ? dense_indices[ i + 1 ] : registry->dense_count;
+    uint32_t run_count = run_end - run_start;
+    if( run_count == 0 )
+        {
+        continue;
+        }
+
+    MoveComponents( write, run_start, run_count, registry );
+    for( uint32_t j = write; j < write + run_count; j++ )
+        {
+        SetSparse( registry->dense[ j ].u.id, j, registry );
+        }
+
+    write += run_count;
+    }
+
+for( uint32_t i = write; i < registry->dense_count; i++ )
+    {
+    registry->dense[ i ].id_and_version = INVALID_ENTITY_ID;
+    }
+
+registry->dense_count = write;
+
+}   /* Component_RemoveComponentsAtDenseIndices() */
+
+
 /*******************************************************************
 *
 *   Component_ReportMetrics()
 *
 *   DESCRIPTION:
-*       Report the registry's technical metrics.
+*       Report the registry's technical metrics.  Alongside the
+*       memory actually used, report what an unpaged sparse array
+*       covering the same entity ids would have cost.
 *
 *******************************************************************/
 
-void Component_ReportMetrics( const ComponentRegistry *registry, size_t *memory_usage )
+void Component_ReportMetrics( const ComponentRegistry *registry, ComponentRegistryMetrics *out )
 {
+*out = {};
+for( uint32_t i = 0; i < registry->sparse_page_count; i++ )
+    {
+    if( registry->sparse_pages[ i ] != s_null_sparse_page )
+        {
+        out->sparse_pages_allocated++;
+        }
+    }
+
 /* memory usage */
-if( memory_usage )
+out->sparse_usage      = out->sparse_pages_allocated * sizeof(s_null_sparse_page)
+                       + registry->sparse_page_count * ( sizeof(*registry->sparse_pages) + sizeof(*registry->sparse_page_live) );
+out->flat_sparse_usage = registry->sparse_page_count * sizeof(s_null_sparse_page);
+out->memory_usage      = out->sparse_usage
+                       + registry->dense_storage_capacity * ( sizeof(*registry->dense) + sizeof(*registry->change_frames) )
+                       + ( ( registry->dense_storage_capacity + COMPONENT_CHANGE_BLOCK_SIZE - 1 ) >> COMPONENT_CHANGE_BLOCK_SHIFT ) * sizeof(*registry->block_frames)
+                       + ( registry->added.capacity + registry->removed.capacity ) * sizeof(ComponentJournalEntry);
+for( uint8_t i = 0; i < registry->column_count; i++ )
     {
-    *memory_usage = registry->sparse_capacity                                    * sizeof(*registry->sparse)
-                  + registry->dense_storage_capacity                             * sizeof(*registry->dense)
-                  + ( registry->dense_storage_capacity + REGISTRY_SWAP_STORAGE ) * registry->storage_stride;
+    out->memory_usage += ( registry->dense_storage_capacity + REGISTRY_SWAP_STORAGE ) * registry->column_sizes[ i ];
     }
 
 }   /* Component_ReportMetrics() */
 
 
+/*******************************************************************
+*
+*   Component_Reserve()
+*
+*   DESCRIPTION:
+*       Grow the dense array and storage columns to hold at least
+*       the given number of components, in a single reallocation.
+*
+*******************************************************************/
+
+void Component_Reserve( const uint32_t capacity, ComponentRegistry *registry )
+{
+debug_assert( registry->lock_count == 0 );
+if( capacity > registry->dense_storage_capacity )
+    {
+    ExpandDenseAndStorage( capacity, registry );
+    }
+
+}   /* Component_Reserve() */
+
+
+/*******************************************************************
+*
+*   Component_SwapDenseIndices()
+*
+*   DESCRIPTION:
+*       Swap the components (and their owning entities) at the two
+*       given dense indices.
+*
+*******************************************************************/
+
+void Component_SwapDenseIndices( const uint32_t dense_a, const uint32_t dense_b, ComponentRegistry *registry )
+{
+debug_assert( registry->lock_count == 0 );
+debug_assert( dense_a < registry->dense_count );
+debug_assert( dense_b < registry->dense_count );
+if( dense_a == dense_b )
+    {
+    return;
+    }
+
+uint32_t sparse_a = registry->dense[ dense_a ].u.id;
+uint32_t sparse_b = registry->dense[ dense_b ].u.id;
+
+SwapComponents( dense_a, dense_b, registry );
+
+SetSparse( sparse_a, dense_b, registry );
+SetSparse( sparse_b, dense_a, registry );
+
+}   /* Component_SwapDenseIndices() */
+
+
+/*******************************************************************
+*
+*   AppendJournal()
+*
+*   DESCRIPTION:
+*       Record an attach or remove of the entity's component.
+*
+*******************************************************************/
+
+static void AppendJournal( const EntityId entity, const uint32_t frame, ComponentJournal *journal )
+{
+if( journal->count >= journal->capacity
+ && journal->first > 0
+ && journal->first >= journal->capacity / 2 )
+    {
+    /* at least half is trimmed, so slide the rest down rather than grow */
+    journal->count -= journal->first;
+    memmove( journal->entries, &journal->entries[ journal->first ], journal->count * sizeof(*journal->entries) );
+    journal->first = 0;
+    }
+else if( journal->count >= journal->capacity )
+    {
+    uint32_t new_capacity = Utilities_ClampToMinU32( 2 * journal->capacity, 16 );
+    ComponentJournalEntry *new_entries = (ComponentJournalEntry*)realloc( journal->entries, new_capacity * sizeof(*new_entries) );
+    if( !new_entries )
+        {
+        hard_assert_always();
+        return;
+        }
+
+    journal->entries  = new_entries;
+    journal->capacity = new_capacity;
+    }
+
+debug_assert( journal->count == journal->first || journal->entries[ journal->count - 1 ].frame <= frame );
+journal->entries[ journal->count ].entity = entity;
+journal->entries[ journal->count ].frame  = frame;
+journal->count++;
+
+}   /* AppendJournal() */
+
+
+/*******************************************************************
+*
+*   ChunkJob()
+*
+*   DESCRIPTION:
+*       Thread pool entry point for a single chunk.
+*
+*******************************************************************/
+
+static void ChunkJob( void *user )
+{
+ComponentChunkJob *job = (ComponentChunkJob*)user;
+job->proc( job->chunk, job->user );
+
+}   /* ChunkJob() */
+
+
 /*******************************************************************
 *
 *   EnsureStorageForEntity()
@@ -268,11 +973,12 @@ if( memory_usage )
 
 static void EnsureStorageForEntity( const EntityId entity, ComponentRegistry *registry )
 {
-/* sparse */
-if( entity.u.id >= registry->sparse_capacity )
+/* sparse page directory - the pages themselves are allocated on first use */
+uint32_t page = entity.u.id >> COMPONENT_SPARSE_PAGE_SHIFT;
+if( page >= registry->sparse_page_count )
     {
-    uint32_t new_size = 2 * Utilities_ClampToMinU32( registry->sparse_capacity, entity.u.id + 1 );
-    ExpandSparse( new_size, registry );
+    uint32_t new_page_count = Utilities_ClampToMinU32( 2 * registry->sparse_page_count, page + 1 );
+    ExpandSparse( new_page_count, registry );
     }
 
 /* dense and storage */
@@ -298,20 +1004,53 @@ static void ExpandDenseAndStorage( const uint32_t new_size, ComponentRegistry *r
 {
 /* we are only ever allowed to grow, never shrink */
 assert( new_size > registry->dense_storage_capacity );
-EntityId *new_dense   = (EntityId*)realloc( registry->dense, sizeof(*new_dense) * new_size );
-uint8_t  *new_storage = (uint8_t*)realloc( registry->storage, registry->storage_stride * ( new_size + REGISTRY_SWAP_STORAGE ) );
+EntityId *new_dense = (EntityId*)realloc( registry->dense, sizeof(*new_dense) * new_size );
+if( !new_dense )
+    {
+    assert( false );
+    return;
+    }
+
+registry->dense = new_dense;
 
-if( !new_dense
- || !new_storage )
+uint32_t *new_change_frames = (uint32_t*)realloc( registry->change_frames, sizeof(*new_change_frames) * new_size );
+if( !new_change_frames )
     {
-    free( new_dense );
-    free( new_storage );
     assert( false );
     return;
     }
 
-registry->dense    = new_dense;
-registry->storage  = new_storage;
+registry->change_frames = new_change_frames;
+
+uint32_t block_count     = ( registry->dense_storage_capacity + COMPONENT_CHANGE_BLOCK_SIZE - 1 ) >> COMPONENT_CHANGE_BLOCK_SHIFT;
+uint32_t new_block_count = ( new_size + COMPONENT_CHANGE_BLOCK_SIZE - 1 ) >> COMPONENT_CHANGE_BLOCK_SHIFT;
+if( new_block_count > block_count )
+    {
+    uint32_t *new_block_frames = (uint32_t*)realloc( registry->block_frames, sizeof(*new_block_frames) * new_block_count );
+    if( !new_block_frames )
+        {
+        assert( false );
+        return;
+        }
+
+    memset( &new_block_frames[ block_count ], 0, sizeof(*new_block_frames) * ( new_block_count - block_count ) );
+    registry->block_frames = new_block_frames;
+    }
+
+for( uint8_t i = 0; i < registry->column_count; i++ )
+    {
+    /* each column gets one extra entry as swap scratch - malloc only promises 8 byte alignment on 32-bit */
+    size_t old_column_size = registry->columns[ i ] ? registry->column_sizes[ i ] * ( registry->dense_storage_capacity + REGISTRY_SWAP_STORAGE ) : 0;
+    uint8_t *new_column = (uint8_t*)Utilities_AlignedRealloc( registry->columns[ i ], old_column_size, registry->column_sizes[ i ] * ( new_size + REGISTRY_SWAP_STORAGE ), COMPONENT_COLUMN_ALIGNMENT );
+    if( !new_column )
+        {
+        assert( false );
+        return;
+        }
+
+    debug_assert( ( (uintptr_t)new_column & ( COMPONENT_COLUMN_ALIGNMENT - 1 ) ) == 0 );
+    registry->columns[ i ] = new_column;
+    }
 
 for( uint32_t i = registry->dense_storage_capacity; i < new_size; i++ )
     {
@@ -329,51 +1068,207 @@ registry->dense_storage_capacity = new_size;
 *   ExpandSparse()
 *
 *   DESCRIPTION:
-*       Enlarge the sparse by reallocating at a new size.
+*       Enlarge the sparse page directory by reallocating at a new
+*       size.  New pages all point at the null page.
 *
 *******************************************************************/
 
-static void ExpandSparse( const uint32_t new_size, ComponentRegistry *registry )
+static void ExpandSparse( const uint32_t new_page_count, ComponentRegistry *registry )
 {
 /* we are only ever allowed to grow, never shrink */
-assert( new_size > registry->sparse_capacity );
-uint32_t *new_sparse  = (uint32_t*)realloc( registry->sparse, sizeof(*new_sparse) * new_size );
+assert( new_page_count > registry->sparse_page_count );
+uint32_t **new_pages = (uint32_t**)realloc( registry->sparse_pages, sizeof(*new_pages) * new_page_count );
+if( !new_pages )
+    {
+    assert( false );
+    return;
+    }
 
-if( !new_sparse )
+registry->sparse_pages = new_pages;
+
+uint16_t *new_live = (uint16_t*)realloc( registry->sparse_page_live, sizeof(*new_live) * new_page_count );
+if( !new_live )
     {
-    free( new_sparse );
     assert( false );
     return;
     }
 
-registry->sparse = new_sparse;
+registry->sparse_page_live = new_live;
 
-for( uint32_t i = registry->sparse_capacity; i < new_size; i++ )
+for( uint32_t i = registry->sparse_page_count; i < new_page_count; i++ )
     {
-    /* mark the new unused dense entries as invalid */
-    registry->sparse[ i ] = INVALID_DENSE_INDEX;
+    registry->sparse_pages[ i ]     = s_null_sparse_page;
+    registry->sparse_page_live[ i ] = 0;
     }
 
-registry->sparse_capacity = new_size;
+registry->sparse_page_count = new_page_count;
 
 }   /* ExpandSparse() */
 
 
 /*******************************************************************
 *
-*   GetStorageAtIndex()
+*   FindJournalFrame()
+*
+*   DESCRIPTION:
+*       Find the index of the journal's first untrimmed entry made on
+*       or after the given frame, or the journal's count if there is
+*       none.
+*
+*******************************************************************/
+
+static uint32_t FindJournalFrame( const uint32_t frame, const ComponentJournal *journal )
+{
+uint32_t first = journal->first;
+uint32_t last  = journal->count;
+while( first < last )
+    {
+    uint32_t middle = first + ( last - first ) / 2;
+    if( journal->entries[ middle ].frame < frame )
+        {
+        first = middle + 1;
+        }
+    else
+        {
+        last = middle;
+        }
+    }
+
+return( first );
+
+}   /* FindJournalFrame() */
+
+
+/*******************************************************************
+*
+*   GetColumnEntry()
+*
+*   DESCRIPTION:
+*       Address the storage column entry for the given dense index.
+*
+*******************************************************************/
+
+static void * GetColumnEntry( const uint8_t column, const uint32_t index, ComponentRegistry *registry )
+{
+return( (void*)&registry->columns[ column ][ (size_t)index * registry->column_sizes[ column ] ] );
+
+}   /* GetColumnEntry() */
+
+
+/*******************************************************************
+*
+*   MoveComponents()
+*
+*   DESCRIPTION:
+*       Move a run of components (and their owning entities) to a
+*       new dense index.  The ranges may overlap.
+*
+*******************************************************************/
+
+static void MoveComponents( const uint32_t dst, const uint32_t src, const uint32_t count, ComponentRegistry *registry )
+{
+memmove( &registry->dense[ dst ], &registry->dense[ src ], count * sizeof(*registry->dense) );
+memmove( &registry->change_frames[ dst ], &registry->change_frames[ src ], count * sizeof(*registry->change_frames) );
+for( uint32_t i = dst; i < dst + count; i++ )
+    {
+    set_change_frame( i, registry->change_frames[ i ], registry );
+    }
+for( uint8_t i = 0; i < registry->column_count; i++ )
+    {
+    memmove( GetColumnEntry( i, dst, registry ), GetColumnEntry( i, src, registry ), count * registry->column_sizes[ i ] );
+    }
+
+}   /* MoveComponents() */
+
+
+/*******************************************************************
+*
+*   SetSparse()
 *
 *   DESCRIPTION:
-*       Address the component storage for the given dense index.
+*       Map the entity id to the given dense index, or clear it with
+*       INVALID_DENSE_INDEX.  Allocates the page on its first entity,
+*       and returns it to the null page when its last one leaves.
+*       The page directory must already cover the id.
 *
 *******************************************************************/
 
-static void * GetStorageAtIndex( const uint32_t index, ComponentRegistry *registry )
+static void SetSparse( const uint32_t id, const uint32_t dense_index, ComponentRegistry *registry )
 {
-uint32_t index_of_storage = index * (uint32_t)registry->storage_stride;
-return( (void*)&registry->storage[ index_of_storage ] );
+uint32_t page = id >> COMPONENT_SPARSE_PAGE_SHIFT;
+debug_assert( page < registry->sparse_page_count );
+
+uint32_t *entries = registry->sparse_pages[ page ];
+uint32_t  value   = dense_index + 1;
+if( entries == s_null_sparse_page )
+    {
+    if( dense_index == INVALID_DENSE_INDEX )
+        {
+        return;
+        }
+
+    entries = (uint32_t*)calloc( COMPONENT_SPARSE_PAGE_COUNT, sizeof(*entries) );
+    if( !entries )
+        {
+        hard_assert_always();
+        return;
+        }
+
+    registry->sparse_pages[ page ] = entries;
+    }
 
-}   /* GetStorageAtIndex() */
+uint32_t *entry = &entries[ id & SPARSE_PAGE_MASK ];
+if( *entry == 0
+ && value != 0 )
+    {
+    registry->sparse_page_live[ page ]++;
+    }
+else if( *entry != 0
+      && value == 0 )
+    {
+    debug_assert( registry->sparse_page_live[ page ] > 0 );
+    registry->sparse_page_live[ page ]--;
+    }
+
+*entry = value;
+
+if( registry->sparse_page_live[ page ] == 0 )
+    {
+    free( entries );
+    registry->sparse_pages[ page ] = s_null_sparse_page;
+    }
+
+}   /* SetSparse() */
+
+
+/*******************************************************************
+*
+*   SwapComponents()
+*
+*   DESCRIPTION:
+*       Swap the components (and their owning entities) at the two
+*       dense indices.  Does not touch the sparse array.
+*
+*******************************************************************/
+
+static void SwapComponents( const uint32_t dense_a, const uint32_t dense_b, ComponentRegistry *registry )
+{
+EntityId swap_entity = registry->dense[ dense_a ];
+registry->dense[ dense_a ] = registry->dense[ dense_b ];
+registry->dense[ dense_b ] = swap_entity;
+
+uint32_t swap_frame = registry->change_frames[ dense_a ];
+set_change_frame( dense_a, registry->change_frames[ dense_b ], registry );
+set_change_frame( dense_b, swap_frame, registry );
+
+for( uint8_t i = 0; i < registry->column_count; i++ )
+    {
+    // TODO <MPA> - Rework this so we don't have to require scratch for singleton components which will never reach a size of more than 1
+    void *scratch = GetColumnEntry( i, registry->dense_storage_capacity, registry );
+    SwapMemory( registry->column_sizes[ i ], GetColumnEntry( i, dense_a, registry ), GetColumnEntry( i, dense_b, registry ), scratch );
+    }
+
+}   /* SwapComponents() */
 
 
 /*******************************************************************
@@ -394,4 +1289,28 @@ memcpy( b, scratch, size );
 }   /* SwapMemory() */
 
 
+/*******************************************************************
+*
+*   TrimJournal()
+*
+*   DESCRIPTION:
+*       Drop the journal's entries from before the given frame.
+*       Only the first entry index moves - AppendJournal() reclaims
+*       the space once enough of it is trimmed.
+*
+*******************************************************************/
+
+static void TrimJournal( const uint32_t oldest_frame, ComponentJournal *journal )
+{
+journal->first = FindJournalFrame( oldest_frame, journal );
+if( journal->first == journal->count )
+    {
+    /* nothing left, so start over at the front */
+    journal->first = 0;
+    journal->count = 0;
+    }
+
+}   /* TrimJournal() */
+
+
 } /* namespace ECS */
\ No newline at end of file
@@ -4,32 +4,219 @@
 
 #include "ComponentClass.hpp"
 #include "Entity.hpp"
+#include "ThreadPool.hpp"
+
+#define COMPONENT_SPARSE_PAGE_SHIFT ( 10 )
+#define COMPONENT_SPARSE_PAGE_COUNT ( 1 << COMPONENT_SPARSE_PAGE_SHIFT )
+#define COMPONENT_CHANGE_BLOCK_SHIFT \
+                                    ( 6 )
+#define COMPONENT_CHANGE_BLOCK_SIZE ( 1 << COMPONENT_CHANGE_BLOCK_SHIFT )
 
 namespace ECS
 {
 
+/*******************************************************************
+*
+*   ComponentRegistry
+*
+*   DESCRIPTION:
+*       Sparse set of one component class.  The sparse array maps
+*       entity id to dense index, and is split into fixed size pages
+*       which are only allocated once they hold an entity.  Every
+*       other page points at a shared, read-only null page.
+*
+*       Component storage is a set of columns indexed by dense
+*       index.  Array-of-structures classes have a single column
+*       holding the whole component, and structure-of-arrays classes
+*       (see COMPONENT_CLASS_SOA_LAYOUTS) have one per field.
+*
+*       Each entry also records the frame it was last changed on -
+*       attached, or handed out by a mutable accessor - and every
+*       attach and remove is appended to a journal, so consumers can
+*       visit just what changed since they last ran.
+*
+*******************************************************************/
+
+typedef struct _ComponentJournalEntry
+    {
+    EntityId            entity;
+    uint32_t            frame;
+    } ComponentJournalEntry;
+
+typedef struct _ComponentJournal
+    {
+    ComponentJournalEntry
+                       *entries;        /* in frame order */
+    uint32_t            first;          /* entries before it have been trimmed */
+    uint32_t            count;
+    uint32_t            capacity;
+    } ComponentJournal;
+
 typedef struct _ComponentRegistry
     {
-    uint32_t            sparse_capacity;
-    uint32_t           *sparse;
+    uint32_t            sparse_page_count;
+    uint32_t          **sparse_pages;   /* dense index + 1 per entity id, 0 is empty */
+    uint16_t           *sparse_page_live;
     uint32_t            dense_storage_capacity;
     EntityId           *dense;
     uint32_t            dense_count;
-    uint8_t            *storage;
+    uint8_t            *columns[ COMPONENT_MAX_SOA_FIELD_COUNT ];
+    size_t              column_sizes[ COMPONENT_MAX_SOA_FIELD_COUNT ];
+    uint8_t             column_count;
+    bool                is_soa;
     size_t              storage_stride;
     ComponentClass      cls;
+    uint32_t            lock_count;     /* structural changes are illegal while iterating in parallel */
+    bool                is_removal_observed;    /* owned by a group or has remove listeners, see Component_ParallelForEach() */
+    uint32_t           *change_frames;  /* per dense index */
+    uint32_t           *block_frames;   /* newest change frame per COMPONENT_CHANGE_BLOCK_SIZE dense indices */
+    uint32_t            frame;          /* see Component_BeginFrame() */
+    ComponentJournal    added;
+    ComponentJournal    removed;
     } ComponentRegistry;
 
+/*******************************************************************
+*
+*   ComponentChangedIterator
+*
+*   DESCRIPTION:
+*       Walks the entities whose component changed on or after a
+*       given frame, from the last dense index to the first.
+*       Removing the component at the iterator is safe.
+*
+*******************************************************************/
+
+typedef struct _ComponentChangedIterator
+    {
+    ComponentRegistry  *registry;
+    uint32_t            since_frame;
+    uint32_t            iterator;       /* one past the next dense index to test */
+    } ComponentChangedIterator;
+
+typedef struct _ComponentChunk
+    {
+    ComponentRegistry  *registry;
+    const EntityId     *entities;
+    uint8_t            *components;     /* NULL for structure-of-arrays classes */
+    size_t              stride;
+    uint8_t            *columns[ COMPONENT_MAX_SOA_FIELD_COUNT ];
+    uint32_t           *change_frames;
+    uint32_t            frame;
+    bool                is_changed;     /* see Component_MarkChunkChanged() */
+    uint32_t            first;
+    uint32_t            count;
+    uint32_t           *deferred_removes;
+    uint32_t            deferred_remove_count;
+    uint32_t            deferred_remove_capacity;
+    } ComponentChunk;
+
+typedef void ComponentChunkProc( ComponentChunk *chunk, void *user );
+
+typedef struct _ComponentRegistryMetrics
+    {
+    size_t              memory_usage;
+    size_t              sparse_usage;       /* pages and page directory */
+    size_t              flat_sparse_usage;  /* an unpaged array over the same ids */
+    uint32_t            sparse_pages_allocated;
+    } ComponentRegistryMetrics;
+
     
 void *   Component_AttachComponent( const EntityId entity, ComponentRegistry *registry );
+void     Component_BeginFrame( const uint32_t frame, const uint32_t oldest_journal_frame, ComponentRegistry *registry );
+void     Component_CreateChangedIterator( const uint32_t since_frame, ComponentRegistry *registry, ComponentChangedIterator *out );
+void     Component_DeferRemoveInChunk( const uint32_t index_in_chunk, ComponentChunk *chunk );
 void     Component_DestroyRegistry( ComponentRegistry *registry );
 bool     Component_EntityHasComponent( const EntityId entity, const ComponentRegistry *registry );
+uint32_t Component_GetAddedSince( const uint32_t since_frame, const ComponentRegistry *registry, const ComponentJournalEntry **out );
+void *   Component_GetColumn( const uint8_t field, ComponentRegistry *registry );
 void *   Component_GetComponent( const EntityId entity, ComponentRegistry *registry );
 uint32_t Component_GetComponentCount( const ComponentRegistry *registry );
 void *   Component_GetComponentAtDenseIndex( const uint32_t dense_index, ComponentRegistry *registry );
+void *   Component_GetComponentMut( const EntityId entity, ComponentRegistry *registry );
+uint32_t Component_GetDenseIndex( const EntityId entity, const ComponentRegistry *registry );
 EntityId Component_GetEntityAtDenseIndex( const uint32_t dense_index, const ComponentRegistry *registry );
+void *   Component_GetField( const EntityId entity, const uint8_t field, ComponentRegistry *registry );
+void *   Component_GetFieldMut( const EntityId entity, const uint8_t field, ComponentRegistry *registry );
+bool     Component_GetNextChanged( ComponentChangedIterator *iterator, EntityId *next );
+uint32_t Component_GetRemovedSince( const uint32_t since_frame, const ComponentRegistry *registry, const ComponentJournalEntry **out );
 void     Component_InitRegistry( const size_t storage_stride, const ComponentClass cls, ComponentRegistry *registry );
+void     Component_ParallelForEach( ComponentRegistry *registry, const uint32_t chunk_size, ComponentChunkProc *proc, void *user, ThreadPool *pool );
 void     Component_RemoveComponent( const EntityId entity, ComponentRegistry *registry );
-void     Component_ReportMetrics( const ComponentRegistry *registry, size_t *memory_usage );
+void     Component_RemoveComponentsAtDenseIndices( uint32_t *dense_indices, const uint32_t count, ComponentRegistry *registry );
+void     Component_ReportMetrics( const ComponentRegistry *registry, ComponentRegistryMetrics *out );
+void     Component_Reserve( const uint32_t capacity, ComponentRegistry *registry );
+void     Component_SwapDenseIndices( const uint32_t dense_a, const uint32_t dense_b, ComponentRegistry *registry );
+
+
+/*******************************************************************
+*
+*   Component_GetChunkColumn()
+*
+*   DESCRIPTION:
+*       Get the start of a structure-of-arrays column within a chunk.
+*       Entry i of the column belongs to the chunk's entity i.
+*
+*******************************************************************/
+
+static inline void * Component_GetChunkColumn( const uint8_t field, const ComponentChunk *chunk )
+{
+debug_assert( field < COMPONENT_MAX_SOA_FIELD_COUNT && chunk->columns[ field ] );
+return( (void*)chunk->columns[ field ] );
+
+} /* Component_GetChunkColumn() */
+
+
+/*******************************************************************
+*
+*   Component_GetChunkComponent()
+*
+*   DESCRIPTION:
+*       Get the component at the given index within a chunk.
+*
+*******************************************************************/
+
+static inline void * Component_GetChunkComponent( const uint32_t index_in_chunk, const ComponentChunk *chunk )
+{
+debug_assert( chunk->components );
+return( (void*)( chunk->components + index_in_chunk * chunk->stride ) );
+
+} /* Component_GetChunkComponent() */
+
+
+/*******************************************************************
+*
+*   Component_GetChunkEntity()
+*
+*   DESCRIPTION:
+*       Get the entity owning the component at the given index within
+*       a chunk.
+*
+*******************************************************************/
+
+static inline EntityId Component_GetChunkEntity( const uint32_t index_in_chunk, const ComponentChunk *chunk )
+{
+return( chunk->entities[ index_in_chunk ] );
+
+} /* Component_GetChunkEntity() */
+
+
+/*******************************************************************
+*
+*   Component_MarkChunkChanged()
+*
+*   DESCRIPTION:
+*       Record that the job changed the component at the given index
+*       within a chunk.  Chunk memory is written directly, so jobs
+*       must do this themselves for changes to be tracked.
+*
+*******************************************************************/
+
+static inline void Component_MarkChunkChanged( const uint32_t index_in_chunk, ComponentChunk *chunk )
+{
+debug_assert( index_in_chunk < chunk->count );
+chunk->change_frames[ index_in_chunk ] = chunk->frame;
+chunk->is_changed = true;
+
+} /* Component_MarkChunkChanged() */
 
 } /* namespace ECS */
\ No newline at end of file
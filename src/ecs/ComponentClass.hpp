@@ -1,11 +1,13 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #include "AssetFile.hpp"
 #include "Entity.hpp"
 #include "Global.hpp"
 #include "Math.hpp"
+#include "StringIntern.hpp"
 #include "Utilities.hpp"
 
 namespace ECS
@@ -319,7 +321,11 @@ typedef struct
 
 /*******************************************************************
 *
-*   COMPONENT_EVENT_NOTIFICATION - EventNotificationComponent
+*   EventNotificationComponent
+*
+*   NOTE:
+*       Not attached to entities - carried by the Event system's
+*       message queue.
 *
 *******************************************************************/
 
@@ -364,13 +370,17 @@ typedef struct _EventNotificationComponent
 
 typedef struct _ModelComponent
     {
-    uint32_t            scene_name_hash;
+    StringId            scene_name_id;
     AssetFileNameString asset_name;
     } ModelComponent;
 
 /*******************************************************************
 *
-*   COMPONENT_PENDING_COMMAND - PendingCommandComponent
+*   PendingCommandComponent
+*
+*   NOTE:
+*       Not attached to entities - carried by the Command system's
+*       message queue.
 *
 *******************************************************************/
 
@@ -438,7 +448,7 @@ typedef struct _SceneComponent
     Float2              viewport_extent;
     uint64_t            draw_order;
     char                scene_name[ SCENE_COMPONENT_NAME_MAX_LEN ];
-    uint32_t            scene_name_hash;
+    StringId            scene_name_id;
     void               *render_state;
     } SceneComponent;
 
@@ -483,6 +493,16 @@ typedef struct _TransformComponent
     Float3              scale;
     } TransformComponent;
 
+/* columns of the structure-of-arrays storage (see COMPONENT_CLASS_SOA_LAYOUTS) */
+typedef enum _TransformComponentField
+    {
+    TRANSFORM_FIELD_POSITION,
+    TRANSFORM_FIELD_ROTATION,
+    TRANSFORM_FIELD_SCALE,
+    /* count */
+    TRANSFORM_FIELD_CNT
+    } TransformComponentField;
+
 /*******************************************************************
 *
 *   Component Classes
@@ -491,11 +511,9 @@ typedef struct _TransformComponent
 
 typedef enum
     {
-    COMPONENT_EVENT_NOTIFICATION,
     COMPONENT_HOT_VAR_BINDING,
     COMPONENT_HOT_VAR_DEFINITION,
     COMPONENT_MODEL,
-    COMPONENT_PENDING_COMMAND,
     COMPONENT_SCENE,
     COMPONENT_SINGLETON_COMMAND,
     COMPONENT_SINGLETON_CONTROLLER_INPUT,
@@ -520,11 +538,9 @@ typedef struct _ComponentClassSizes
 
 static const ComponentClassSizes COMPONENT_CLASS_SIZES[] =
     {
-    { COMPONENT_EVENT_NOTIFICATION,         sizeof( EventNotificationComponent )        },
     { COMPONENT_HOT_VAR_BINDING,            sizeof( HotVarBindingComponent )            },
     { COMPONENT_HOT_VAR_DEFINITION,         sizeof( HotVarDefinitionComponent )         },
     { COMPONENT_MODEL,                      sizeof( ModelComponent )                    },
-    { COMPONENT_PENDING_COMMAND,            sizeof( PendingCommandComponent )           },
     { COMPONENT_SCENE,                      sizeof( SceneComponent )                    },
     { COMPONENT_SINGLETON_COMMAND,          sizeof( SingletonCommandComponent )         },
     { COMPONENT_SINGLETON_CONTROLLER_INPUT, sizeof( SingletonControllerInputComponent ) },
@@ -540,6 +556,41 @@ static const ComponentClassSizes COMPONENT_CLASS_SIZES[] =
     };
 compiler_assert( cnt_of_array( COMPONENT_CLASS_SIZES ) == COMPONENT_CNT, component_class_hpp );
 
+/*******************************************************************
+*
+*   Structure-of-Arrays Layouts
+*
+*   DESCRIPTION:
+*       Component classes listed here opt in to structure-of-arrays
+*       storage - each field lives in its own column, indexed by
+*       dense index, so bulk kernels can stream a single field.
+*       These classes have no addressable component struct, so use
+*       the column/field accessors instead of Component_GetComponent.
+*
+*******************************************************************/
+
+#define COMPONENT_MAX_SOA_FIELD_COUNT                                     ( 4 )
+
+typedef struct _ComponentClassField
+    {
+    size_t              offset;
+    size_t              size;
+    } ComponentClassField;
+
+typedef struct _ComponentClassSoALayout
+    {
+    ComponentClass      cls;
+    uint8_t             field_count;
+    ComponentClassField fields[ COMPONENT_MAX_SOA_FIELD_COUNT ];
+    } ComponentClassSoALayout;
+
+static const ComponentClassSoALayout COMPONENT_CLASS_SOA_LAYOUTS[] =
+    {
+    { COMPONENT_TRANSFORM, TRANSFORM_FIELD_CNT, { { offsetof( TransformComponent, position ), sizeof( Float3 )     },
+                                                  { offsetof( TransformComponent, rotation ), sizeof( Quaternion ) },
+                                                  { offsetof( TransformComponent, scale ),    sizeof( Float3 )     } } }
+    };
+
 
 /*******************************************************************
 *
@@ -568,4 +619,29 @@ return( ret );
 }   /* GetComponentClassSize() */
 
 
+/*******************************************************************
+*
+*   GetComponentClassSoALayout()
+*
+*   DESCRIPTION:
+*       Get the component class's structure-of-arrays layout, or
+*       NULL if it is stored as an array-of-structures.
+*
+*******************************************************************/
+
+static inline const ComponentClassSoALayout * GetComponentClassSoALayout( const ComponentClass component )
+{
+for( uint32_t i = 0; i < cnt_of_array( COMPONENT_CLASS_SOA_LAYOUTS ); i++ )
+    {
+    if( COMPONENT_CLASS_SOA_LAYOUTS[ i ].cls == component )
+        {
+        return( &COMPONENT_CLASS_SOA_LAYOUTS[ i ] );
+        }
+    }
+
+return( NULL );
+
+}   /* GetComponentClassSoALayout() */
+
+
 } /* namespace ECS */
\ No newline at end of file
@@ -59,6 +59,11 @@ if( registry->dead_count > 0 )
     {
     registry->arr[ registry->last_dead ].u.id = entity.u.id;
     }
+else
+    {
+    /* dead pool was empty, so this becomes the next to recycle */
+    registry->next_recycle.u.id = entity.u.id;
+    }
 
 registry->arr[ entity.u.id ].u.version++;
 registry->last_dead = entity.u.id;
@@ -67,6 +72,26 @@ registry->dead_count++;
 }   /* Entity_DestroyEntity() */
 
 
+/*******************************************************************
+*
+*   Entity_DestroyEntities()
+*
+*   DESCRIPTION:
+*       Make each of the given entities dead, linking them all onto
+*       the end of the dead pool.
+*
+*******************************************************************/
+
+void Entity_DestroyEntities( const EntityId *entities, const uint32_t count, EntityRegistry *registry )
+{
+for( uint32_t i = 0; i < count; i++ )
+    {
+    Entity_DestroyEntity( entities[ i ], registry );
+    }
+
+}   /* Entity_DestroyEntities() */
+
+
 /*******************************************************************
 *
 *   Entity_DestroyRegistry()
@@ -30,6 +30,7 @@ typedef struct _EntityRegistry
 
 
 EntityId Entity_CreateEntity( EntityRegistry *registry );
+void     Entity_DestroyEntities( const EntityId *entities, const uint32_t count, EntityRegistry *registry );
 void     Entity_DestroyEntity( const EntityId entity, EntityRegistry *registry );
 void     Entity_DestroyRegistry( EntityRegistry *registry );
 bool     Entity_EntityIsAlive( const EntityId entity, const EntityRegistry *registry );
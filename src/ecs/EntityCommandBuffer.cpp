@@ -0,0 +1,610 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "EntityCommandBuffer.hpp"
+#include "FrameAllocator.hpp"
+#include "LinearAllocator.hpp"
+#include "Universe.hpp"
+#include "Utilities.hpp"
+
+
+#define COMMAND_ALIGNMENT           ( 16 )
+#define NO_LANE                     ( 0xffffffff )
+#define ALL_LANES                   ( ( ENTITY_COMMAND_BUFFER_MAX_LANE_COUNT == 64 ) ? ~(uint64_t)0 : ( ( (uint64_t)1 << ( ENTITY_COMMAND_BUFFER_MAX_LANE_COUNT % 64 ) ) - 1 ) )
+
+/* placeholder ids live at the top of the id space, out of reach of the entity registry */
+#define PLACEHOLDER_BIT             ( 1u << 25 )
+#define PLACEHOLDER_LANE_SHIFT      ( 19 )
+#define PLACEHOLDER_INDEX_MASK      ( ( 1u << PLACEHOLDER_LANE_SHIFT ) - 1 )
+
+namespace ECS
+{
+compiler_assert( ENTITY_COMMAND_BUFFER_MAX_LANE_COUNT <= ( PLACEHOLDER_BIT >> PLACEHOLDER_LANE_SHIFT ), entity_command_buffer_cpp );
+compiler_assert( ENTITY_COMMAND_BUFFER_MAX_LANE_COUNT <= 64, entity_command_buffer_cpp );
+
+typedef enum _EntityCommandType
+    {
+    ENTITY_COMMAND_CREATE,
+    ENTITY_COMMAND_DESTROY,
+    ENTITY_COMMAND_ATTACH,
+    ENTITY_COMMAND_REMOVE
+    } EntityCommandType;
+
+typedef struct _EntityCommand
+    {
+    struct _EntityCommand
+                       *next;
+    EntityCommandType   type;
+    ComponentClass      cls;
+    EntityId            entity;         /* real, or a placeholder from EntityCommandBuffer_CreateEntity() */
+    uint32_t            sort_key;
+    void               *value;          /* attach only */
+    } EntityCommand;
+
+typedef struct _EntityCommandBlock
+    {
+    struct _EntityCommandBlock
+                       *next;
+    LinearAllocator     allocator;
+    } EntityCommandBlock;
+
+/*******************************************************************
+*
+*   EntityCommandLane
+*
+*   DESCRIPTION:
+*       One recording thread's commands, and the arena they live
+*       in.  Blocks are kept across playbacks and reused.
+*
+*******************************************************************/
+
+typedef struct _EntityCommandLane
+    {
+    EntityCommandBlock *blocks;
+    EntityCommandBlock *current;
+    EntityCommand      *head;
+    EntityCommand      *tail;
+    uint32_t            count;
+    uint32_t            placeholder_count;
+    } EntityCommandLane;
+
+struct _EntityCommandBuffer
+    {
+    EntityCommandLane   lanes[ ENTITY_COMMAND_BUFFER_MAX_LANE_COUNT ];
+    };
+
+/* a thread's lane index, handed back to s_free_lanes when the thread exits */
+typedef struct _EntityCommandLaneLease
+    {
+    uint32_t            lane;
+    ~_EntityCommandLaneLease();
+    } EntityCommandLaneLease;
+
+static std::atomic<uint64_t>   s_free_lanes( ALL_LANES );  /* bit per lane index */
+static thread_local EntityCommandLaneLease
+                               s_lease = { NO_LANE };
+
+
+static void *            Allocate( const uint64_t size, EntityCommandLane *lane );
+static void              ApplyValue( const EntityId entity, const ComponentClass cls, const void *value, Universe *universe );
+static EntityCommandLane * GetLane( EntityCommandBuffer *buffer );
+static EntityCommand *   PushCommand( const EntityCommandType type, const uint32_t sort_key, const EntityId entity, const ComponentClass cls, EntityCommandBuffer *buffer );
+static void              ResetLane( EntityCommandLane *lane );
+
+
+/*******************************************************************
+*
+*   EntityCommandBuffer_AttachComponent()
+*
+*   DESCRIPTION:
+*       Record attaching a component to the entity, and return the
+*       zeroed value it will be attached with for the caller to
+*       fill.  Attaching a component the entity already has
+*       overwrites it with the value.  Structure-of-arrays classes
+*       are filled as their whole struct, and split at playback.
+*
+*******************************************************************/
+
+void * EntityCommandBuffer_AttachComponent( const uint32_t sort_key, const EntityId entity, const ComponentClass cls, EntityCommandBuffer *buffer )
+{
+EntityCommand *command = PushCommand( ENTITY_COMMAND_ATTACH, sort_key, entity, cls, buffer );
+if( !command )
+    {
+    return( NULL );
+    }
+
+size_t size = GetComponentClassSize( cls );
+command->value = Allocate( size, GetLane( buffer ) );
+if( !command->value )
+    {
+    hard_assert_always();
+    return( NULL );
+    }
+
+memset( command->value, 0, size );
+
+return( command->value );
+
+} /* EntityCommandBuffer_AttachComponent() */
+
+
+/*******************************************************************
+*
+*   EntityCommandBuffer_Create()
+*
+*   DESCRIPTION:
+*       Create an empty command buffer.
+*       Returns NULL if the buffer could not be created.
+*
+*******************************************************************/
+
+EntityCommandBuffer * EntityCommandBuffer_Create()
+{
+EntityCommandBuffer *ret = (EntityCommandBuffer*)calloc( 1, sizeof(EntityCommandBuffer) );
+debug_assert( ret );
+
+return( ret );
+
+} /* EntityCommandBuffer_Create() */
+
+
+/*******************************************************************
+*
+*   EntityCommandBuffer_CreateEntity()
+*
+*   DESCRIPTION:
+*       Record creating an entity.  The returned placeholder may be
+*       used in later commands in this buffer, and is replaced by
+*       the real entity at playback.  It means nothing to the
+*       universe.
+*
+*******************************************************************/
+
+EntityId EntityCommandBuffer_CreateEntity( const uint32_t sort_key, EntityCommandBuffer *buffer )
+{
+EntityCommandLane *lane = GetLane( buffer );
+hard_assert( lane->placeholder_count <= PLACEHOLDER_INDEX_MASK );
+
+EntityId ret = {};
+ret.u.id = PLACEHOLDER_BIT | ( ( s_lease.lane << PLACEHOLDER_LANE_SHIFT ) | lane->placeholder_count++ );
+
+PushCommand( ENTITY_COMMAND_CREATE, sort_key, ret, COMPONENT_CNT, buffer );
+
+return( ret );
+
+} /* EntityCommandBuffer_CreateEntity() */
+
+
+/*******************************************************************
+*
+*   EntityCommandBuffer_Destroy()
+*
+*   DESCRIPTION:
+*       Free the buffer, discarding any commands not played back.
+*
+*******************************************************************/
+
+void EntityCommandBuffer_Destroy( EntityCommandBuffer *buffer )
+{
+if( !buffer )
+    {
+    return;
+    }
+
+for( uint32_t i = 0; i < cnt_of_array( buffer->lanes ); i++ )
+    {
+    EntityCommandBlock *block = buffer->lanes[ i ].blocks;
+    while( block )
+        {
+        EntityCommandBlock *next = block->next;
+        free( block );
+        block = next;
+        }
+    }
+
+free( buffer );
+
+} /* EntityCommandBuffer_Destroy() */
+
+
+/*******************************************************************
+*
+*   EntityCommandBuffer_DestroyEntity()
+*
+*   DESCRIPTION:
+*       Record destroying the entity.  Destroys are applied as a
+*       single batch at the end of playback.
+*
+*******************************************************************/
+
+void EntityCommandBuffer_DestroyEntity( const uint32_t sort_key, const EntityId entity, EntityCommandBuffer *buffer )
+{
+PushCommand( ENTITY_COMMAND_DESTROY, sort_key, entity, COMPONENT_CNT, buffer );
+
+} /* EntityCommandBuffer_DestroyEntity() */
+
+
+/*******************************************************************
+*
+*   EntityCommandBuffer_GetCount()
+*
+*   DESCRIPTION:
+*       Get the number of recorded commands.  Only meaningful when
+*       no thread is recording.
+*
+*******************************************************************/
+
+uint32_t EntityCommandBuffer_GetCount( const EntityCommandBuffer *buffer )
+{
+uint32_t ret = 0;
+for( uint32_t i = 0; i < cnt_of_array( buffer->lanes ); i++ )
+    {
+    ret += buffer->lanes[ i ].count;
+    }
+
+return( ret );
+
+} /* EntityCommandBuffer_GetCount() */
+
+
+/*******************************************************************
+*
+*   EntityCommandBuffer_Playback()
+*
+*   DESCRIPTION:
+*       Apply every recorded command to the universe, and empty the
+*       buffer.  Must be called at a sync point, when no thread is
+*       recording or iterating.
+*
+*       Commands are sorted by key, then creates run first so every
+*       placeholder resolves, then attaches and removes run in
+*       order.  Each registry is grown once for all of its
+*       attaches, and the destroys are applied as one batch.
+*
+*******************************************************************/
+
+void EntityCommandBuffer_Playback( Universe *universe, EntityCommandBuffer *buffer )
+{
+uint32_t count = EntityCommandBuffer_GetCount( buffer );
+if( count == 0 )
+    {
+    return;
+    }
+
+uint32_t placeholder_first[ ENTITY_COMMAND_BUFFER_MAX_LANE_COUNT ];
+uint32_t placeholder_count = 0;
+for( uint32_t i = 0; i < cnt_of_array( buffer->lanes ); i++ )
+    {
+    placeholder_first[ i ] = placeholder_count;
+    placeholder_count += buffer->lanes[ i ].placeholder_count;
+    }
+
+FrameAllocatorMarker scope = FrameAllocator_BeginScope();
+EntityCommand **commands = FrameAllocator_AllocateArray( EntityCommand*, count );
+uint64_t       *keys     = FrameAllocator_AllocateArray( uint64_t, count );
+EntityId       *entities = FrameAllocator_AllocateArray( EntityId, placeholder_count + count );
+
+/* key is the sort key, then the recording order */
+uint32_t ordinal = 0;
+for( uint32_t i = 0; i < cnt_of_array( buffer->lanes ); i++ )
+    {
+    for( EntityCommand *command = buffer->lanes[ i ].head; command; command = command->next )
+        {
+        commands[ ordinal ] = command;
+        keys[ ordinal ]     = ( (uint64_t)command->sort_key << 32 ) | ordinal;
+        ordinal++;
+        }
+    }
+
+Utilities_ShellSortU64Ascending( count, keys );
+
+/* creates first, so later commands can name the new entities */
+EntityId *created = entities;
+uint32_t attach_counts[ COMPONENT_CNT ] = {};
+for( uint32_t i = 0; i < count; i++ )
+    {
+    EntityCommand *command = commands[ (uint32_t)keys[ i ] ];
+    if( command->type == ENTITY_COMMAND_CREATE )
+        {
+        uint32_t lane = ( command->entity.u.id & ~PLACEHOLDER_BIT ) >> PLACEHOLDER_LANE_SHIFT;
+        EntityId entity = Universe_CreateNewEntity( universe );
+        hard_assert( entity.u.id < PLACEHOLDER_BIT );
+
+        created[ placeholder_first[ lane ] + ( command->entity.u.id & PLACEHOLDER_INDEX_MASK ) ] = entity;
+        }
+    else if( command->type == ENTITY_COMMAND_ATTACH )
+        {
+        attach_counts[ command->cls ]++;
+        }
+    }
+
+/* grow each registry once, rather than doubling through the attaches */
+if( universe->storage == UNIVERSE_STORAGE_SPARSE_SET )
+    {
+    for( uint32_t i = 0; i < COMPONENT_CNT; i++ )
+        {
+        if( attach_counts[ i ] > 0 )
+            {
+            ComponentRegistry *registry = Universe_GetComponentRegistry( (ComponentClass)i, universe );
+            Component_Reserve( Component_GetComponentCount( registry ) + attach_counts[ i ], registry );
+            }
+        }
+    }
+
+EntityId *destroys = &entities[ placeholder_count ];
+uint32_t destroy_count = 0;
+for( uint32_t i = 0; i < count; i++ )
+    {
+    EntityCommand *command = commands[ (uint32_t)keys[ i ] ];
+    if( command->type == ENTITY_COMMAND_CREATE )
+        {
+        continue;
+        }
+
+    EntityId entity = command->entity;
+    if( entity.u.id & PLACEHOLDER_BIT )
+        {
+        uint32_t lane = ( entity.u.id & ~PLACEHOLDER_BIT ) >> PLACEHOLDER_LANE_SHIFT;
+        entity = created[ placeholder_first[ lane ] + ( entity.u.id & PLACEHOLDER_INDEX_MASK ) ];
+        }
+
+    if( !Universe_EntityIsAlive( entity, universe ) )
+        {
+        continue;
+        }
+
+    switch( command->type )
+        {
+        case ENTITY_COMMAND_DESTROY:
+            destroys[ destroy_count++ ] = entity;
+            break;
+
+        case ENTITY_COMMAND_ATTACH:
+            Universe_AttachComponentToEntity( entity, command->cls, universe );
+            ApplyValue( entity, command->cls, command->value, universe );
+            break;
+
+        case ENTITY_COMMAND_REMOVE:
+            Universe_RemoveComponentFromEntity( entity, command->cls, universe );
+            break;
+
+        default:
+            debug_assert_always();
+            break;
+        }
+    }
+
+Universe_DestroyEntities( destroys, destroy_count, universe );
+
+for( uint32_t i = 0; i < cnt_of_array( buffer->lanes ); i++ )
+    {
+    ResetLane( &buffer->lanes[ i ] );
+    }
+
+FrameAllocator_EndScope( scope );
+
+} /* EntityCommandBuffer_Playback() */
+
+
+/*******************************************************************
+*
+*   EntityCommandBuffer_RemoveComponent()
+*
+*   DESCRIPTION:
+*       Record removing a component from the entity.
+*
+*******************************************************************/
+
+void EntityCommandBuffer_RemoveComponent( const uint32_t sort_key, const EntityId entity, const ComponentClass cls, EntityCommandBuffer *buffer )
+{
+PushCommand( ENTITY_COMMAND_REMOVE, sort_key, entity, cls, buffer );
+
+} /* EntityCommandBuffer_RemoveComponent() */
+
+
+/*******************************************************************
+*
+*   Allocate()
+*
+*   DESCRIPTION:
+*       Allocate from the lane's arena, moving on to the next block
+*       (or a new one) when the current block is full.
+*
+*******************************************************************/
+
+static void * Allocate( const uint64_t size, EntityCommandLane *lane )
+{
+uint64_t needed = size + COMMAND_ALIGNMENT;
+while( lane->current
+    && lane->current->allocator.capacity - lane->current->allocator.head < needed )
+    {
+    lane->current = lane->current->next;
+    }
+
+if( !lane->current )
+    {
+    /* oversized values get a block of their own size */
+    uint64_t capacity = max_of_vals( (uint64_t)ENTITY_COMMAND_BUFFER_BLOCK_SIZE, needed );
+    EntityCommandBlock *block = (EntityCommandBlock*)malloc( sizeof(EntityCommandBlock) + capacity );
+    if( !block )
+        {
+        return( NULL );
+        }
+
+    LinearAllocator_InitAttached( capacity, block + 1, &block->allocator );
+    block->next  = lane->blocks;
+    lane->blocks = block;
+    lane->current = block;
+    }
+
+return( LinearAllocator_AllocateAligned( size, COMMAND_ALIGNMENT, &lane->current->allocator ) );
+
+} /* Allocate() */
+
+
+/*******************************************************************
+*
+*   ApplyValue()
+*
+*   DESCRIPTION:
+*       Copy a recorded value into the entity's component, field by
+*       field for structure-of-arrays classes.
+*
+*******************************************************************/
+
+static void ApplyValue( const EntityId entity, const ComponentClass cls, const void *value, Universe *universe )
+{
+const ComponentClassSoALayout *layout = GetComponentClassSoALayout( cls );
+if( !layout )
+    {
+    void *component = Universe_TryGetComponent( entity, cls, universe );
+    if( component )
+        {
+        memcpy( component, value, GetComponentClassSize( cls ) );
+        }
+
+    return;
+    }
+
+for( uint8_t i = 0; i < layout->field_count; i++ )
+    {
+    void *field = Universe_TryGetComponentField( entity, cls, i, universe );
+    if( field )
+        {
+        memcpy( field, (const uint8_t*)value + layout->fields[ i ].offset, layout->fields[ i ].size );
+        }
+    }
+
+} /* ApplyValue() */
+
+
+/*******************************************************************
+*
+*   GetLane()
+*
+*   DESCRIPTION:
+*       Get the calling thread's lane, assigning the thread the
+*       lowest free lane index on its first use of any buffer.
+*       Indices are recycled as threads exit, so only the threads
+*       alive at once are limited to
+*       ENTITY_COMMAND_BUFFER_MAX_LANE_COUNT.
+*
+*       A recycled lane may still hold the exited thread's commands
+*       in some buffer.  The new owner appends after them, which is
+*       safe - the old owner can no longer record.
+*
+*******************************************************************/
+
+static EntityCommandLane * GetLane( EntityCommandBuffer *buffer )
+{
+if( s_lease.lane == NO_LANE )
+    {
+    uint64_t free_lanes = s_free_lanes.load( std::memory_order_relaxed );
+    uint32_t lane;
+    do
+        {
+        hard_assert( free_lanes );
+        lane = 0;
+        while( !( free_lanes & ( (uint64_t)1 << lane ) ) )
+            {
+            lane++;
+            }
+        } while( !s_free_lanes.compare_exchange_weak( free_lanes, free_lanes & ~( (uint64_t)1 << lane ), std::memory_order_acquire, std::memory_order_relaxed ) );
+
+    s_lease.lane = lane;
+    }
+
+return( &buffer->lanes[ s_lease.lane ] );
+
+} /* GetLane() */
+
+
+/*******************************************************************
+*
+*   ~EntityCommandLaneLease()
+*
+*   DESCRIPTION:
+*       Return the exiting thread's lane index, if it took one.
+*
+*******************************************************************/
+
+_EntityCommandLaneLease::~_EntityCommandLaneLease()
+{
+if( lane != NO_LANE )
+    {
+    s_free_lanes.fetch_or( (uint64_t)1 << lane, std::memory_order_release );
+    }
+
+} /* ~EntityCommandLaneLease() */
+
+
+/*******************************************************************
+*
+*   PushCommand()
+*
+*   DESCRIPTION:
+*       Append a command to the calling thread's lane.
+*
+*******************************************************************/
+
+static EntityCommand * PushCommand( const EntityCommandType type, const uint32_t sort_key, const EntityId entity, const ComponentClass cls, EntityCommandBuffer *buffer )
+{
+EntityCommandLane *lane = GetLane( buffer );
+EntityCommand *ret = (EntityCommand*)Allocate( sizeof(EntityCommand), lane );
+if( !ret )
+    {
+    hard_assert_always();
+    return( NULL );
+    }
+
+*ret = {};
+ret->type     = type;
+ret->sort_key = sort_key;
+ret->entity   = entity;
+ret->cls      = cls;
+
+if( lane->tail )
+    {
+    lane->tail->next = ret;
+    }
+else
+    {
+    lane->head = ret;
+    }
+
+lane->tail = ret;
+lane->count++;
+
+return( ret );
+
+} /* PushCommand() */
+
+
+/*******************************************************************
+*
+*   ResetLane()
+*
+*   DESCRIPTION:
+*       Empty the lane, keeping its blocks for reuse.
+*
+*******************************************************************/
+
+static void ResetLane( EntityCommandLane *lane )
+{
+for( EntityCommandBlock *block = lane->blocks; block; block = block->next )
+    {
+    LinearAllocator_Reset( &block->allocator );
+    }
+
+lane->current           = lane->blocks;
+lane->head              = NULL;
+lane->tail              = NULL;
+lane->count             = 0;
+lane->placeholder_count = 0;
+
+} /* ResetLane() */
+
+
+} /* namespace ECS */
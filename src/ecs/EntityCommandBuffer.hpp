@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ComponentClass.hpp"
+#include "Entity.hpp"
+
+#define ENTITY_COMMAND_BUFFER_MAX_LANE_COUNT \
+                                    ( 64 )
+#define ENTITY_COMMAND_BUFFER_BLOCK_SIZE \
+                                    ( 16 * 1024 )
+
+namespace ECS
+{
+struct _Universe;
+
+/*******************************************************************
+*
+*   EntityCommandBuffer
+*
+*   DESCRIPTION:
+*       Records structural changes (create, destroy, attach,
+*       remove) to be applied to a universe later, at a sync point.
+*       Each recording thread gets its own lane with its own arena,
+*       so recording never takes a lock.  A thread's lane is freed
+*       when it exits; at most ENTITY_COMMAND_BUFFER_MAX_LANE_COUNT
+*       threads may record at once.
+*
+*       Playback is deterministic: commands are applied in order of
+*       their sort key, and in recording order within a key.  Give
+*       each job a unique sort key (such as its chunk index) so the
+*       order doesn't depend on which thread ran it.
+*
+*******************************************************************/
+
+struct _EntityCommandBuffer;
+typedef struct _EntityCommandBuffer EntityCommandBuffer;
+
+void *                EntityCommandBuffer_AttachComponent( const uint32_t sort_key, const EntityId entity, const ComponentClass cls, EntityCommandBuffer *buffer );
+EntityCommandBuffer * EntityCommandBuffer_Create();
+EntityId              EntityCommandBuffer_CreateEntity( const uint32_t sort_key, EntityCommandBuffer *buffer );
+void                  EntityCommandBuffer_Destroy( EntityCommandBuffer *buffer );
+void                  EntityCommandBuffer_DestroyEntity( const uint32_t sort_key, const EntityId entity, EntityCommandBuffer *buffer );
+uint32_t              EntityCommandBuffer_GetCount( const EntityCommandBuffer *buffer );
+void                  EntityCommandBuffer_Playback( _Universe *universe, EntityCommandBuffer *buffer );
+void                  EntityCommandBuffer_RemoveComponent( const uint32_t sort_key, const EntityId entity, const ComponentClass cls, EntityCommandBuffer *buffer );
+
+} /* namespace ECS */
@@ -1,12 +1,15 @@
+#define HAVE_STRUCT_TIMESPEC
+#include "pthread.h"
 
 #include <cassert>
 #include <cstdlib>
 
-#include "Command.hpp"
 #include "Event.hpp"
 #include "Math.hpp"
+#include "MessageQueue.hpp"
 #include "Universe.hpp"
-#include "NonOwningGroup.hpp"
+
+#define EVENT_QUEUE_FRAME_CAPACITY  ( 16 * 1024 )
 
 namespace ECS
 {
@@ -35,8 +38,8 @@ typedef struct _EventSystem
     uint16_t            count;
     EventInterestedPartiesCache
                         cache[ EVENT_NOTIFICATION_CLASS_COUNT ];
-    NonOwningGroupIterator
-                        group;
+    MessageQueue        queue;
+    pthread_mutex_t     queue_mutex;
     } EventSystem;
 
 
@@ -131,8 +134,12 @@ component->ptr = (EventSystem*)malloc( sizeof(EventSystem) );
 
 EventSystem *system = AsEventSystem( universe );
 *system = {};
+ResetCache( system );
 
-return( true );
+/* systems may enqueue events from scheduler worker threads */
+do_debug_assert( !pthread_mutex_init( &system->queue_mutex, NULL ) );
+
+return( MessageQueue_Init( EVENT_NOTIFICATION_CLASS_COUNT, sizeof(EventNotificationComponent), EVENT_QUEUE_FRAME_CAPACITY, &system->queue ) );
 
 } /* Event_Init() */
 
@@ -149,6 +156,8 @@ return( true );
 void Event_Destroy( Universe *universe )
 {
 SingletonEventComponent *component = (SingletonEventComponent*)Universe_GetSingletonComponent( COMPONENT_SINGLETON_EVENT, universe );
+MessageQueue_Destroy( &AsEventSystem( universe )->queue );
+pthread_mutex_destroy( &AsEventSystem( universe )->queue_mutex );
 free( component->ptr );
 component->ptr = NULL;
 
@@ -168,27 +177,67 @@ void Event_DoFrame( float frame_delta, Universe *universe )
 {
 EventSystem *system = AsEventSystem( universe );
 
-ResetCache( system );
-NonOwningGroup_CreateIterator( universe, &system->group, NonOwningGroup_GroupIds( COMPONENT_EVENT_NOTIFICATION ) );
+/* events enqueued by the listeners will be dispatched next frame */
+do_debug_assert( !pthread_mutex_lock( &system->queue_mutex ) );
+MessageQueue_Swap( &system->queue );
+do_debug_assert( !pthread_mutex_unlock( &system->queue_mutex ) );
 
-EntityId entity;
-EventNotificationComponent *component;
-while( NonOwningGroup_GetNext( &system->group, &entity, (void**)&component ) )
+for( uint32_t i = 0; i < EVENT_NOTIFICATION_CLASS_COUNT; i++ )
     {
-    EventInterestedPartiesCache *cache = EnsureCacheForEvent( component->cls, system );
-    for( uint16_t i = 0; i < cache->count; i++ )
+    if( MessageQueue_GetReadCount( i, &system->queue ) == 0 )
         {
-        cache->listeners[ i ]( component, universe );
+        continue;
         }
 
-    /* destroy the event */
-    PendingCommandCommand command;
-    Command_PostPending( PENDING_COMMAND_DESTROY_ENTITY, Command_MakeDestroyEntity( entity, &command ), universe );
+    /* dispatch the whole batch of this class to its listeners */
+    EventInterestedPartiesCache *cache = EnsureCacheForEvent( (EventNotificationClass)i, system );
+
+    MessageQueueIterator iterator;
+    MessageQueue_CreateIterator( i, &system->queue, &iterator );
+
+    const EventNotificationComponent *evt;
+    while( ( evt = (EventNotificationComponent*)MessageQueue_GetNext( &iterator ) ) != NULL )
+        {
+        for( uint16_t j = 0; j < cache->count; j++ )
+            {
+            cache->listeners[ j ]( evt, universe );
+            }
+        }
     }
 
 } /* Event_DoFrame() */
 
 
+/*******************************************************************
+*
+*   Event_Enqueue()
+*
+*   DESCRIPTION:
+*       Enqueue an event to be processed at the end of the frame.
+*       Safe to call from any thread.
+*
+*******************************************************************/
+
+void Event_Enqueue( const EventNotificationClass cls, const EventNotificationEvent *evt, Universe *universe )
+{
+EventSystem *system = AsEventSystem( universe );
+
+do_debug_assert( !pthread_mutex_lock( &system->queue_mutex ) );
+EventNotificationComponent *component = (EventNotificationComponent*)MessageQueue_Enqueue( cls, &system->queue );
+if( component )
+    {
+    component->cls = cls;
+    if( evt )
+        {
+        component->u   = *evt;
+        }
+    }
+
+do_debug_assert( !pthread_mutex_unlock( &system->queue_mutex ) );
+
+} /* Event_Enqueue() */
+
+
 /*******************************************************************
 *
 *   Event_ListenToEvent()
@@ -214,6 +263,8 @@ else
     Math_BitArrayClear( interests->ba, evt );
     }
 
+system->cache[ evt ].needs_rebuild = true;
+
 } /* Event_ListenToEvent() */
 
 
@@ -230,6 +281,7 @@ void Event_RegisterEventListener( const EventListener listener, EventProcedure *
 {
 EventSystem *system = AsEventSystem( universe );
 system->listeners[ listener ] = handler_proc;
+ResetCache( system );
 
 } /* Event_RegisterEventListener() */
 
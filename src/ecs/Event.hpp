@@ -24,34 +24,11 @@ typedef void EventProcedure( const ECS::EventNotificationComponent *evt, ECS::Un
 bool Event_Init( ECS::Universe *universe );
 void Event_Destroy( ECS::Universe *universe );
 void Event_DoFrame( float frame_delta, ECS::Universe *universe );
+void Event_Enqueue( const EventNotificationClass cls, const EventNotificationEvent *evt, Universe *universe );
 void Event_ListenToEvent( const EventListener listener, const EventNotificationClass evt, EventListenAction action, Universe *universe );
 void Event_RegisterEventListener( const EventListener listener, EventProcedure *handler_proc, Universe *universe );
 
 
-/*******************************************************************
-*
-*   Event_Enqueue()
-*
-*   DESCRIPTION:
-*       Helper function to enqueue an event to be processed at the
-*       end of the frame.
-*
-*******************************************************************/
-
-static inline void Event_Enqueue( const EventNotificationClass cls, const EventNotificationEvent *evt, Universe *universe )
-{
-EntityId entity = Universe_CreateNewEntity( universe );
-EventNotificationComponent *component = (EventNotificationComponent*)Universe_AttachComponentToEntity( entity, COMPONENT_EVENT_NOTIFICATION, universe );
-
-component->cls = cls;
-if( evt )
-    {
-    component->u   = *evt;
-    }
-
-} /* Event_Enqueue() */
-
-
 /*******************************************************************
 *
 *   Event_MakeChangeGameMainMode()
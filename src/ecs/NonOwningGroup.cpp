@@ -1,10 +1,25 @@
 #include <stdarg.h>
+#include <cstdlib>
+#include <cstring>
 
+#include "FrameAllocator.hpp"
 #include "NonOwningGroup.hpp"
+#include "ThreadPool.hpp"
 #include "Universe.hpp"
 
 namespace ECS
 {
+typedef struct _NonOwningGroupChunkJob
+    {
+    NonOwningGroupChunk
+                       *chunk;
+    NonOwningGroupForEachProc
+                       *proc;
+    void               *user;
+    } NonOwningGroupChunkJob;
+
+static void ChunkJob( void *user );
+
 
 /*******************************************************************
 *
@@ -28,10 +43,25 @@ out->universe    = universe;
 va_list va;
 va_start( va, component_count );
 
+if( universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    /* walk every archetype which has all the classes */
+    ArchetypeSignature required = 0;
+    for( uint8_t i = 0; i < out->num_classes; i++ )
+        {
+        out->classes[ i ] = (ComponentClass)va_arg( va, int );
+        required |= Archetype_SignatureOf( out->classes[ i ] );
+        }
+
+    Archetype_CreateCursor( required, &universe->archetypes, &out->cursor );
+    va_end( va );
+    return;
+    }
+
 bool first_class = true;
 for( uint8_t i = 0; i < out->num_classes; i++ )
 	{
-	ComponentClass component_class = va_arg( va, ComponentClass );
+	ComponentClass component_class = (ComponentClass)va_arg( va, int );
 	out->components[ i ] = Universe_GetComponentRegistry( component_class, universe );
 	uint32_t this_count = Component_GetComponentCount( out->components[ i ] );
 
@@ -51,17 +81,98 @@ va_end( va );
 } /* NonOwningGroup_CreateIterator() */
 
 
+/*******************************************************************
+*
+*   NonOwningGroup_DeferDestroyInChunk()
+*
+*   DESCRIPTION:
+*       Request the given entity be destroyed once the parallel
+*       iteration has finished.  Only the job processing the chunk
+*       may call this.
+*
+*******************************************************************/
+
+void NonOwningGroup_DeferDestroyInChunk( const EntityId entity, NonOwningGroupChunk *chunk )
+{
+if( chunk->deferred_destroy_count >= chunk->deferred_destroy_capacity )
+    {
+    uint32_t new_capacity = Utilities_ClampToMinU32( 2 * chunk->deferred_destroy_capacity, 16 );
+    EntityId *new_destroys = (EntityId*)realloc( chunk->deferred_destroys, new_capacity * sizeof(*new_destroys) );
+    if( !new_destroys )
+        {
+        hard_assert_always();
+        return;
+        }
+
+    chunk->deferred_destroys         = new_destroys;
+    chunk->deferred_destroy_capacity = new_capacity;
+    }
+
+chunk->deferred_destroys[ chunk->deferred_destroy_count++ ] = entity;
+
+} /* NonOwningGroup_DeferDestroyInChunk() */
+
+
+/*******************************************************************
+*
+*   NonOwningGroup_DeferRemoveInChunk()
+*
+*   DESCRIPTION:
+*       Request the given component be removed from the entity once
+*       the parallel iteration has finished.  Only the job
+*       processing the chunk may call this.
+*
+*******************************************************************/
+
+void NonOwningGroup_DeferRemoveInChunk( const EntityId entity, const ComponentClass cls, NonOwningGroupChunk *chunk )
+{
+if( chunk->deferred_remove_count >= chunk->deferred_remove_capacity )
+    {
+    uint32_t new_capacity = Utilities_ClampToMinU32( 2 * chunk->deferred_remove_capacity, 16 );
+    NonOwningGroupDeferredRemove *new_removes = (NonOwningGroupDeferredRemove*)realloc( chunk->deferred_removes, new_capacity * sizeof(*new_removes) );
+    if( !new_removes )
+        {
+        hard_assert_always();
+        return;
+        }
+
+    chunk->deferred_removes         = new_removes;
+    chunk->deferred_remove_capacity = new_capacity;
+    }
+
+NonOwningGroupDeferredRemove *remove = &chunk->deferred_removes[ chunk->deferred_remove_count++ ];
+remove->entity = entity;
+remove->cls    = cls;
+
+} /* NonOwningGroup_DeferRemoveInChunk() */
+
+
 /*******************************************************************
 *
 *   NonOwningGroup_GetComponent()
 *
 *   DESCRIPTION:
 *       Get the requested component pointed to by the iterator.
+*       Structure-of-arrays classes have no component to return,
+*       use Component_GetField() with the iterator's entity.
 *
 *******************************************************************/
 
 void * NonOwningGroup_GetComponent( const ComponentClass requested, const NonOwningGroupIterator *iterator )
 {
+if( iterator->universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    /* the cursor already knows the row */
+    const Archetype *archetype = &iterator->universe->archetypes.archetypes[ iterator->cursor.archetype ];
+    debug_assert( test_bits( archetype->signature, Archetype_SignatureOf( requested ) ) );
+    if( GetComponentClassSoALayout( requested ) )
+        {
+        return( NULL );
+        }
+
+    return( Archetype_GetChunkEntry( requested, 0, iterator->cursor.chunk, iterator->cursor.row, archetype ) );
+    }
+
 if( requested == iterator->classes[ iterator->control_component_index ] )
 	{
 	return( iterator->control_component_at_iterator );
@@ -118,12 +229,40 @@ if( component )
 iterator->entity_at_iterator.id_and_version = INVALID_ENTITY_ID;
 iterator->control_component_at_iterator = NULL;
 
+if( iterator->universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    if( !Archetype_CursorNext( &iterator->cursor, &iterator->universe->archetypes ) )
+        {
+        return( false );
+        }
+
+    /* every entity in a matching archetype is in the group */
+    const Archetype *archetype = &iterator->universe->archetypes.archetypes[ iterator->cursor.archetype ];
+    iterator->entity_at_iterator = Archetype_GetChunkEntity( iterator->cursor.chunk, iterator->cursor.row, archetype );
+    if( !GetComponentClassSoALayout( iterator->classes[ 0 ] ) )
+        {
+        iterator->control_component_at_iterator = Archetype_GetChunkEntry( iterator->classes[ 0 ], 0, iterator->cursor.chunk, iterator->cursor.row, archetype );
+        }
+
+    if( next )
+        {
+        *next = iterator->entity_at_iterator;
+        }
+
+    if( component )
+        {
+        *component = iterator->control_component_at_iterator;
+        }
+
+    return( true );
+    }
+
 ComponentRegistry *control_registry = iterator->components[ iterator->control_component_index ];
-for( ; iterator->iterator > 0 && !iterator->control_component_at_iterator; iterator->iterator-- )
+for( ; iterator->iterator > 0 && iterator->entity_at_iterator.id_and_version == INVALID_ENTITY_ID; iterator->iterator-- )
 	{
 	EntityId this_entity = Component_GetEntityAtDenseIndex( iterator->iterator - 1, control_registry );
 	debug_assert( this_entity.id_and_version != INVALID_ENTITY_ID );
-	void *this_component = Component_GetComponentAtDenseIndex( iterator->iterator - 1, control_registry );
+    void *this_component = control_registry->is_soa ? NULL : Component_GetComponentAtDenseIndex( iterator->iterator - 1, control_registry );
 
 	bool has_all_components = true;
 	for( uint8_t j = 0; j < iterator->num_classes; j++ )
@@ -160,5 +299,235 @@ return( iterator->entity_at_iterator.id_and_version != INVALID_ENTITY_ID );
 } /* NonOwningGroup_GetNext() */
 
 
+/*******************************************************************
+*
+*   NonOwningGroup_ParallelForEach()
+*
+*   DESCRIPTION:
+*       Split the group's control registry into chunks, and run the
+*       procedure for every matching entity on the thread pool.
+*       Returns once every chunk has been processed.
+*
+*       The group's registries are locked for the duration, so the
+*       procedure may not make structural changes directly.
+*       Removals and destroys requested through the chunk are
+*       applied after the parallel section, in chunk order.
+*
+*       With archetype storage each job is one archetype chunk, and
+*       the chunk size is ignored.
+*
+*******************************************************************/
+
+void NonOwningGroup_ParallelForEach( const NonOwningGroupIterator *iterator, const uint32_t chunk_size, NonOwningGroupForEachProc *proc, void *user, ThreadPool *pool )
+{
+debug_assert( chunk_size > 0 );
+bool is_archetype = ( iterator->universe->storage == UNIVERSE_STORAGE_ARCHETYPE );
+ArchetypeStorage *archetypes = &iterator->universe->archetypes;
+uint32_t count = iterator->control_class_component_count;
+
+uint32_t chunk_count = 0;
+if( is_archetype )
+    {
+    for( uint32_t i = 0; i < archetypes->archetype_count; i++ )
+        {
+        if( test_bits( archetypes->archetypes[ i ].signature, iterator->cursor.required ) )
+            {
+            chunk_count += archetypes->archetypes[ i ].chunk_count;
+            }
+        }
+    }
+else
+    {
+    chunk_count = ( count + chunk_size - 1 ) / chunk_size;
+    }
+
+if( chunk_count == 0 )
+    {
+    return;
+    }
+
+FrameAllocatorMarker scope = FrameAllocator_BeginScope();
+NonOwningGroupChunk    *chunks = FrameAllocator_AllocateArray( NonOwningGroupChunk, chunk_count );
+NonOwningGroupChunkJob *jobs   = FrameAllocator_AllocateArray( NonOwningGroupChunkJob, chunk_count );
+
+if( is_archetype )
+    {
+    archetypes->lock_count++;
+    }
+else
+    {
+    for( uint8_t i = 0; i < iterator->num_classes; i++ )
+        {
+        iterator->components[ i ]->lock_count++;
+        }
+    }
+
+ThreadPoolCounter counter;
+ThreadPool_InitCounter( &counter );
+uint32_t archetype_index = 0;
+uint32_t archetype_chunk = 0;
+for( uint32_t i = 0; i < chunk_count; i++ )
+    {
+    NonOwningGroupChunk *chunk = &chunks[ i ];
+    *chunk = {};
+    chunk->group = iterator;
+    if( is_archetype )
+        {
+        /* step to the next chunk of a matching archetype */
+        while( archetype_chunk >= archetypes->archetypes[ archetype_index ].chunk_count
+            || !test_bits( archetypes->archetypes[ archetype_index ].signature, iterator->cursor.required ) )
+            {
+            archetype_index++;
+            archetype_chunk = 0;
+            }
+
+        chunk->archetype       = archetype_index;
+        chunk->archetype_chunk = archetype_chunk++;
+        chunk->count           = archetypes->archetypes[ archetype_index ].chunks[ chunk->archetype_chunk ]->count;
+        }
+    else
+        {
+        chunk->first = i * chunk_size;
+        chunk->count = min_of_vals( chunk_size, count - chunk->first );
+        }
+
+    jobs[ i ].chunk = chunk;
+    jobs[ i ].proc  = proc;
+    jobs[ i ].user  = user;
+    ThreadPool_Submit( ChunkJob, &jobs[ i ], &counter, pool );
+    }
+
+ThreadPool_WaitForCounter( &counter, pool );
+
+if( is_archetype )
+    {
+    archetypes->lock_count--;
+    }
+else
+    {
+    for( uint8_t i = 0; i < iterator->num_classes; i++ )
+        {
+        iterator->components[ i ]->lock_count--;
+        }
+    }
+
+/* apply the deferred structural changes */
+uint32_t destroy_count = 0;
+for( uint32_t i = 0; i < chunk_count; i++ )
+    {
+    NonOwningGroupChunk *chunk = &chunks[ i ];
+    for( uint32_t j = 0; j < chunk->deferred_remove_count; j++ )
+        {
+        Universe_RemoveComponentFromEntity( chunk->deferred_removes[ j ].entity, chunk->deferred_removes[ j ].cls, iterator->universe );
+        }
+
+    destroy_count += chunk->deferred_destroy_count;
+    }
+
+if( destroy_count > 0 )
+    {
+    EntityId *destroys = FrameAllocator_AllocateArray( EntityId, destroy_count );
+
+    uint32_t write = 0;
+    for( uint32_t i = 0; i < chunk_count; i++ )
+        {
+        if( chunks[ i ].deferred_destroy_count > 0 )
+            {
+            memcpy( &destroys[ write ], chunks[ i ].deferred_destroys, chunks[ i ].deferred_destroy_count * sizeof(*destroys) );
+            write += chunks[ i ].deferred_destroy_count;
+            }
+        }
+
+    Universe_DestroyEntities( destroys, destroy_count, iterator->universe );
+    }
+
+for( uint32_t i = 0; i < chunk_count; i++ )
+    {
+    free( chunks[ i ].deferred_removes );
+    free( chunks[ i ].deferred_destroys );
+    }
+
+FrameAllocator_EndScope( scope );
+
+} /* NonOwningGroup_ParallelForEach() */
+
+
+/*******************************************************************
+*
+*   ChunkJob()
+*
+*   DESCRIPTION:
+*       Thread pool entry point for a single chunk.  Walk the chunk's
+*       range of the control registry, and run the procedure for the
+*       entities which have every component in the group.
+*
+*******************************************************************/
+
+static void ChunkJob( void *user )
+{
+NonOwningGroupChunkJob *job = (NonOwningGroupChunkJob*)user;
+NonOwningGroupChunk *chunk = job->chunk;
+const NonOwningGroupIterator *group = chunk->group;
+ComponentRegistry *control_registry = group->components[ group->control_component_index ];
+
+void *components[ MAX_NON_OWNING_GROUP_COMPONENT_COUNT ];
+if( group->universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    /* every row matches, so just walk the columns */
+    const Archetype *archetype = &group->universe->archetypes.archetypes[ chunk->archetype ];
+    uint8_t *columns[ MAX_NON_OWNING_GROUP_COMPONENT_COUNT ];
+    uint32_t strides[ MAX_NON_OWNING_GROUP_COMPONENT_COUNT ];
+    for( uint8_t j = 0; j < group->num_classes; j++ )
+        {
+        bool is_soa = ( GetComponentClassSoALayout( group->classes[ j ] ) != NULL );
+        columns[ j ] = is_soa ? NULL : (uint8_t*)Archetype_GetChunkEntry( group->classes[ j ], 0, chunk->archetype_chunk, 0, archetype );
+        strides[ j ] = is_soa ? 0 : archetype->column_sizes[ archetype->first_column[ group->classes[ j ] ] ];
+        }
+
+    for( uint32_t i = 0; i < chunk->count; i++ )
+        {
+        for( uint8_t j = 0; j < group->num_classes; j++ )
+            {
+            components[ j ] = columns[ j ] ? columns[ j ] + (size_t)i * strides[ j ] : NULL;
+            }
+
+        job->proc( Archetype_GetChunkEntity( chunk->archetype_chunk, i, archetype ), components, chunk, job->user );
+        }
+
+    return;
+    }
+
+for( uint32_t i = chunk->first; i < chunk->first + chunk->count; i++ )
+    {
+    EntityId entity = Component_GetEntityAtDenseIndex( i, control_registry );
+
+    bool has_all_components = true;
+    for( uint8_t j = 0; j < group->num_classes; j++ )
+        {
+        ComponentRegistry *registry = group->components[ j ];
+        if( j == group->control_component_index )
+            {
+            components[ j ] = registry->is_soa ? NULL : Component_GetComponentAtDenseIndex( i, registry );
+            continue;
+            }
+
+        if( !Component_EntityHasComponent( entity, registry ) )
+            {
+            /* this entity was missing a component */
+            has_all_components = false;
+            break;
+            }
+
+        components[ j ] = registry->is_soa ? NULL : Component_GetComponent( entity, registry );
+        }
+
+    if( has_all_components )
+        {
+        job->proc( entity, components, chunk, job->user );
+        }
+    }
+
+} /* ChunkJob() */
+
 
 } /* namespace ECS */
\ No newline at end of file
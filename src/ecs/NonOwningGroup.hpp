@@ -1,8 +1,10 @@
 #pragma once
 #include <cstdint>
 
+#include "Archetype.hpp"
 #include "ComponentClass.hpp"
 #include "Component.hpp"
+#include "ThreadPool.hpp"
 #include "Universe.hpp"
 #include "Utilities.hpp"
 
@@ -13,7 +15,7 @@ namespace ECS
 
 typedef struct _NonOwningGroupIterator
     {
-    ComponentRegistry  *components[ MAX_NON_OWNING_GROUP_COMPONENT_COUNT ];
+    ComponentRegistry  *components[ MAX_NON_OWNING_GROUP_COMPONENT_COUNT ];  /* sparse set storage only */
     ComponentClass      classes[ MAX_NON_OWNING_GROUP_COMPONENT_COUNT ];
     uint8_t             num_classes;
     uint8_t             control_component_index;
@@ -21,12 +23,42 @@ typedef struct _NonOwningGroupIterator
     uint32_t            iterator;
     EntityId            entity_at_iterator;
     void               *control_component_at_iterator;
+    ArchetypeCursor     cursor;         /* archetype storage only */
     Universe           *universe;
     } NonOwningGroupIterator;
 
+typedef struct _NonOwningGroupDeferredRemove
+    {
+    EntityId            entity;
+    ComponentClass      cls;
+    } NonOwningGroupDeferredRemove;
+
+typedef struct _NonOwningGroupChunk
+    {
+    const NonOwningGroupIterator
+                       *group;
+    uint32_t            first;          /* range of the control registry's dense array */
+    uint32_t            count;
+    uint32_t            archetype;      /* or the archetype chunk, with archetype storage */
+    uint32_t            archetype_chunk;
+    NonOwningGroupDeferredRemove
+                       *deferred_removes;
+    uint32_t            deferred_remove_count;
+    uint32_t            deferred_remove_capacity;
+    EntityId           *deferred_destroys;
+    uint32_t            deferred_destroy_count;
+    uint32_t            deferred_destroy_capacity;
+    } NonOwningGroupChunk;
+
+/* components are in the order the group's classes were given, NULL for structure-of-arrays classes */
+typedef void NonOwningGroupForEachProc( const EntityId entity, void **components, NonOwningGroupChunk *chunk, void *user );
+
 void   NonOwningGroup_CreateIterator( Universe *universe, NonOwningGroupIterator *out, uint8_t component_count, ... );
+void   NonOwningGroup_DeferDestroyInChunk( const EntityId entity, NonOwningGroupChunk *chunk );
+void   NonOwningGroup_DeferRemoveInChunk( const EntityId entity, const ComponentClass cls, NonOwningGroupChunk *chunk );
 void * NonOwningGroup_GetComponent( const ComponentClass requested, const NonOwningGroupIterator *iterator );
 bool   NonOwningGroup_GetNext( NonOwningGroupIterator *iterator, EntityId *next, void **component );
+void   NonOwningGroup_ParallelForEach( const NonOwningGroupIterator *iterator, const uint32_t chunk_size, NonOwningGroupForEachProc *proc, void *user, ThreadPool *pool );
 
 
 /*******************************************************************
@@ -0,0 +1,325 @@
+#include <stdarg.h>
+
+#include "OwningGroup.hpp"
+#include "Universe.hpp"
+
+namespace ECS
+{
+static bool IsEntityInGroup( const EntityId entity, const OwningGroup *group );
+static bool IsEntityMatchingGroup( const EntityId entity, const OwningGroup *group );
+static void PackEntity( const EntityId entity, OwningGroup *group );
+static void UnpackEntity( const EntityId entity, OwningGroup *group );
+
+
+/*******************************************************************
+*
+*   OwningGroup_Create()
+*
+*   DESCRIPTION:
+*       Create an owning group for the given component classes, and
+*       pack any existing entities which match it.  A component
+*       class may only be owned by a single group.
+*       Archetype storage already keeps matching entities packed,
+*       so owning groups are only available with sparse sets.
+*       Returns NULL if the group could not be created.
+*
+*******************************************************************/
+
+OwningGroup * OwningGroup_Create( _Universe *universe, uint8_t component_count, ... )
+{
+if( universe->storage != UNIVERSE_STORAGE_SPARSE_SET
+ || component_count < MIN_OWNING_GROUP_COMPONENT_COUNT
+ || component_count > MAX_OWNING_GROUP_COMPONENT_COUNT
+ || universe->owning_group_count >= cnt_of_array( universe->owning_groups ) )
+    {
+    debug_assert_always();
+    return( NULL );
+    }
+
+ComponentClass classes[ MAX_OWNING_GROUP_COMPONENT_COUNT ];
+
+va_list va;
+va_start( va, component_count );
+for( uint8_t i = 0; i < component_count; i++ )
+    {
+    classes[ i ] = (ComponentClass)va_arg( va, int );
+    }
+
+va_end( va );
+
+/* registries can only be owned once */
+for( uint8_t i = 0; i < component_count; i++ )
+    {
+    if( classes[ i ] < 0
+     || classes[ i ] >= COMPONENT_CNT
+     || universe->component_owners[ classes[ i ] ] != UNIVERSE_NO_OWNING_GROUP )
+        {
+        debug_assert_always();
+        return( NULL );
+        }
+    }
+
+uint8_t group_index = universe->owning_group_count++;
+OwningGroup *ret = &universe->owning_groups[ group_index ];
+*ret = {};
+ret->num_classes = component_count;
+
+uint8_t smallest = 0;
+for( uint8_t i = 0; i < ret->num_classes; i++ )
+    {
+    ret->classes[ i ]    = classes[ i ];
+    ret->components[ i ] = Universe_GetComponentRegistry( classes[ i ], universe );
+    universe->component_owners[ classes[ i ] ] = group_index;
+    ret->components[ i ]->is_removal_observed = true;
+
+    if( Component_GetComponentCount( ret->components[ i ] ) < Component_GetComponentCount( ret->components[ smallest ] ) )
+        {
+        smallest = i;
+        }
+    }
+
+/* pack the entities which already match, walking the smallest registry */
+ComponentRegistry *control_registry = ret->components[ smallest ];
+for( uint32_t i = 0; i < Component_GetComponentCount( control_registry ); i++ )
+    {
+    EntityId entity = Component_GetEntityAtDenseIndex( i, control_registry );
+    if( IsEntityMatchingGroup( entity, ret ) )
+        {
+        PackEntity( entity, ret );
+        }
+    }
+
+return( ret );
+
+} /* OwningGroup_Create() */
+
+
+/*******************************************************************
+*
+*   OwningGroup_CreateIterator()
+*
+*   DESCRIPTION:
+*       Create an iterator over the given owning group.  Iterator
+*       starts at the beginning of the iteration.
+*
+*******************************************************************/
+
+void OwningGroup_CreateIterator( OwningGroup *group, OwningGroupIterator *out )
+{
+*out = {};
+out->group    = group;
+out->iterator = group->length;
+out->entity_at_iterator.id_and_version = INVALID_ENTITY_ID;
+
+} /* OwningGroup_CreateIterator() */
+
+
+/*******************************************************************
+*
+*   OwningGroup_GetComponent()
+*
+*   DESCRIPTION:
+*       Get the requested component pointed to by the iterator.
+*       Since the group is packed, this is a direct dense index.
+*
+*******************************************************************/
+
+void * OwningGroup_GetComponent( const ComponentClass requested, const OwningGroupIterator *iterator )
+{
+const OwningGroup *group = iterator->group;
+for( uint8_t i = 0; i < group->num_classes; i++ )
+    {
+    if( group->classes[ i ] == requested )
+        {
+        return( Component_GetComponentAtDenseIndex( iterator->iterator, group->components[ i ] ) );
+        }
+    }
+
+debug_assert_always();
+return( NULL );
+
+} /* OwningGroup_GetComponent() */
+
+
+/*******************************************************************
+*
+*   OwningGroup_GetCount()
+*
+*   DESCRIPTION:
+*       Get the number of entities currently in the group.
+*
+*******************************************************************/
+
+uint32_t OwningGroup_GetCount( const OwningGroup *group )
+{
+return( group->length );
+
+} /* OwningGroup_GetCount() */
+
+
+/*******************************************************************
+*
+*   OwningGroup_GetNext()
+*
+*   DESCRIPTION:
+*       Get the next entity in the group.  Iteration walks the
+*       packed range backwards, so it is safe to remove a group
+*       component from the entity at the iterator.
+*
+*******************************************************************/
+
+bool OwningGroup_GetNext( OwningGroupIterator *iterator, EntityId *next )
+{
+iterator->entity_at_iterator.id_and_version = INVALID_ENTITY_ID;
+if( iterator->iterator > iterator->group->length )
+    {
+    /* group shrank underneath us */
+    iterator->iterator = iterator->group->length;
+    }
+
+if( iterator->iterator > 0 )
+    {
+    iterator->iterator--;
+    iterator->entity_at_iterator = Component_GetEntityAtDenseIndex( iterator->iterator, iterator->group->components[ 0 ] );
+    }
+
+if( next )
+    {
+    *next = iterator->entity_at_iterator;
+    }
+
+return( iterator->entity_at_iterator.id_and_version != INVALID_ENTITY_ID );
+
+} /* OwningGroup_GetNext() */
+
+
+/*******************************************************************
+*
+*   OwningGroup_OnComponentAttached()
+*
+*   DESCRIPTION:
+*       An owned component was just attached to the given entity.
+*       Pack the entity into the group if it now matches.
+*
+*******************************************************************/
+
+void OwningGroup_OnComponentAttached( const EntityId entity, OwningGroup *group )
+{
+if( IsEntityMatchingGroup( entity, group )
+ && !IsEntityInGroup( entity, group ) )
+    {
+    PackEntity( entity, group );
+    }
+
+} /* OwningGroup_OnComponentAttached() */
+
+
+/*******************************************************************
+*
+*   OwningGroup_OnComponentRemoving()
+*
+*   DESCRIPTION:
+*       An owned component is about to be removed from the given
+*       entity.  Unpack the entity from the group if it was in it.
+*
+*******************************************************************/
+
+void OwningGroup_OnComponentRemoving( const EntityId entity, OwningGroup *group )
+{
+if( IsEntityMatchingGroup( entity, group )
+ && IsEntityInGroup( entity, group ) )
+    {
+    UnpackEntity( entity, group );
+    }
+
+} /* OwningGroup_OnComponentRemoving() */
+
+
+/*******************************************************************
+*
+*   IsEntityInGroup()
+*
+*   DESCRIPTION:
+*       Is the given (matching) entity inside the packed range?
+*
+*******************************************************************/
+
+static bool IsEntityInGroup( const EntityId entity, const OwningGroup *group )
+{
+return( Component_GetDenseIndex( entity, group->components[ 0 ] ) < group->length );
+
+} /* IsEntityInGroup() */
+
+
+/*******************************************************************
+*
+*   IsEntityMatchingGroup()
+*
+*   DESCRIPTION:
+*       Does the given entity have every component in the group?
+*
+*******************************************************************/
+
+static bool IsEntityMatchingGroup( const EntityId entity, const OwningGroup *group )
+{
+for( uint8_t i = 0; i < group->num_classes; i++ )
+    {
+    if( !Component_EntityHasComponent( entity, group->components[ i ] ) )
+        {
+        return( false );
+        }
+    }
+
+return( true );
+
+} /* IsEntityMatchingGroup() */
+
+
+/*******************************************************************
+*
+*   PackEntity()
+*
+*   DESCRIPTION:
+*       Move the entity's components to the end of the packed range
+*       in every owned registry, and grow the range.
+*
+*******************************************************************/
+
+static void PackEntity( const EntityId entity, OwningGroup *group )
+{
+for( uint8_t i = 0; i < group->num_classes; i++ )
+    {
+    ComponentRegistry *registry = group->components[ i ];
+    Component_SwapDenseIndices( Component_GetDenseIndex( entity, registry ), group->length, registry );
+    }
+
+group->length++;
+
+} /* PackEntity() */
+
+
+/*******************************************************************
+*
+*   UnpackEntity()
+*
+*   DESCRIPTION:
+*       Move the entity's components to the last slot of the packed
+*       range in every owned registry, and shrink the range.
+*
+*******************************************************************/
+
+static void UnpackEntity( const EntityId entity, OwningGroup *group )
+{
+debug_assert( group->length > 0 );
+group->length--;
+
+for( uint8_t i = 0; i < group->num_classes; i++ )
+    {
+    ComponentRegistry *registry = group->components[ i ];
+    Component_SwapDenseIndices( Component_GetDenseIndex( entity, registry ), group->length, registry );
+    }
+
+} /* UnpackEntity() */
+
+
+} /* namespace ECS */
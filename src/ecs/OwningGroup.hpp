@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+
+#include "ComponentClass.hpp"
+#include "Component.hpp"
+#include "Entity.hpp"
+#include "Utilities.hpp"
+
+namespace ECS
+{
+#define MAX_OWNING_GROUP_COMPONENT_COUNT \
+                                    ( 4 )
+#define MIN_OWNING_GROUP_COMPONENT_COUNT \
+                                    ( 2 )
+
+struct _Universe;
+
+/*******************************************************************
+*
+*   OwningGroup
+*
+*   DESCRIPTION:
+*       A group which owns its component registries.  Entities which
+*       have every component in the group are kept packed at the
+*       front of each owned registry's dense and storage arrays, in
+*       the same order, so the first 'length' dense indices of every
+*       owned registry refer to the same entities.
+*
+*******************************************************************/
+
+typedef struct _OwningGroup
+    {
+    ComponentRegistry  *components[ MAX_OWNING_GROUP_COMPONENT_COUNT ];
+    ComponentClass      classes[ MAX_OWNING_GROUP_COMPONENT_COUNT ];
+    uint8_t             num_classes;
+    uint32_t            length;
+    } OwningGroup;
+
+typedef struct _OwningGroupIterator
+    {
+    OwningGroup        *group;
+    uint32_t            iterator;
+    EntityId            entity_at_iterator;
+    } OwningGroupIterator;
+
+OwningGroup * OwningGroup_Create( _Universe *universe, uint8_t component_count, ... );
+void          OwningGroup_CreateIterator( OwningGroup *group, OwningGroupIterator *out );
+void *        OwningGroup_GetComponent( const ComponentClass requested, const OwningGroupIterator *iterator );
+uint32_t      OwningGroup_GetCount( const OwningGroup *group );
+bool          OwningGroup_GetNext( OwningGroupIterator *iterator, EntityId *next );
+void          OwningGroup_OnComponentAttached( const EntityId entity, OwningGroup *group );
+void          OwningGroup_OnComponentRemoving( const EntityId entity, OwningGroup *group );
+
+
+/*******************************************************************
+*
+*   OwningGroup_GroupIds()
+*
+*   DESCRIPTION:
+*       Expand the given component class list to be prefixed by the
+*       count.
+*
+*******************************************************************/
+
+#define OwningGroup_GroupIds( ... ) \
+    expand_macro( cnt_of_va_args( __VA_ARGS__ ) ), __VA_ARGS__
+
+} /* namespace ECS */
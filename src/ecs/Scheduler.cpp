@@ -0,0 +1,479 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "EntityCommandBuffer.hpp"
+#include "Math.hpp"
+#include "Scheduler.hpp"
+#include "ThreadPool.hpp"
+#include "Utilities.hpp"
+
+namespace ECS
+{
+typedef uint32_t access_ba_type;
+
+#define ACCESS_ARRAY_COUNT \
+    MATH_BITARRAY_COUNT( access_ba_type, COMPONENT_CNT )
+
+compiler_assert( SCHEDULER_MAX_SYSTEM_COUNT <= 8 * sizeof(uint32_t), scheduler_cpp );
+
+typedef struct _SchedulerSystem
+    {
+    SchedulerSystemProc
+                       *proc;
+    SchedulerSystemFlags
+                        flags;
+    access_ba_type      reads[ ACCESS_ARRAY_COUNT ];
+    access_ba_type      writes[ ACCESS_ARRAY_COUNT ];
+    uint32_t            successors;         /* mask of systems waiting on this one */
+    uint32_t            predecessor_count;
+    std::atomic<uint32_t>
+                        remaining;          /* predecessors not yet finished this frame */
+    SchedulerSystemMetrics
+                        metrics;
+    struct _Scheduler  *scheduler;
+    } SchedulerSystem;
+
+struct _Scheduler
+    {
+    SchedulerSystem     systems[ SCHEDULER_MAX_SYSTEM_COUNT ];
+    uint32_t            count;
+    SchedulerMode       mode;
+    bool                needs_rebuild;
+    ThreadPool         *pool;
+    EntityCommandBuffer
+                       *command_buffer;
+    Universe           *universe;
+    float               frame_delta;
+    std::atomic<uint32_t>
+                        main_ready;         /* mask of main thread systems ready to run */
+    std::atomic<uint32_t>
+                        unfinished;
+    };
+
+
+static void BuildGraph( Scheduler *scheduler );
+static void DispatchSystem( SchedulerSystem *system );
+static bool IsConflicting( const SchedulerSystem *a, const SchedulerSystem *b );
+static void RunSystem( SchedulerSystem *system );
+static void SystemJob( void *user );
+
+
+/*******************************************************************
+*
+*   Scheduler_Create()
+*
+*   DESCRIPTION:
+*       Create a system scheduler for the given universe, backed by
+*       a thread pool with the given worker count, and a command
+*       buffer for the systems' structural changes.
+*       Returns NULL if the scheduler could not be created.
+*
+*******************************************************************/
+
+Scheduler * Scheduler_Create( const uint32_t worker_count, Universe *universe )
+{
+Scheduler *ret = (Scheduler*)calloc( 1, sizeof(Scheduler) );
+if( !ret )
+    {
+    debug_assert_always();
+    return( NULL );
+    }
+
+ret->universe = universe;
+ret->mode     = SCHEDULER_MODE_PARALLEL;
+ret->pool     = ThreadPool_Create( worker_count );
+ret->command_buffer = EntityCommandBuffer_Create();
+if( !ret->pool
+ || !ret->command_buffer )
+    {
+    ThreadPool_Destroy( ret->pool );
+    EntityCommandBuffer_Destroy( ret->command_buffer );
+    free( ret );
+    return( NULL );
+    }
+
+/* let systems share the pool for parallel iteration, and the command buffer for structural changes */
+universe->thread_pool    = ret->pool;
+universe->command_buffer = ret->command_buffer;
+
+return( ret );
+
+} /* Scheduler_Create() */
+
+
+/*******************************************************************
+*
+*   Scheduler_DeclareAccess()
+*
+*   DESCRIPTION:
+*       Declare that the given system reads or writes the given
+*       component class.  Systems which write a class another system
+*       reads or writes will never run at the same time, and keep
+*       their registration order.
+*
+*******************************************************************/
+
+void Scheduler_DeclareAccess( const SchedulerSystemId system, const ComponentClass component, const SchedulerAccess access, Scheduler *scheduler )
+{
+if( system >= scheduler->count
+ || component >= COMPONENT_CNT )
+    {
+    debug_assert_always();
+    return;
+    }
+
+SchedulerSystem *declaring = &scheduler->systems[ system ];
+if( access == SCHEDULER_ACCESS_WRITE )
+    {
+    Math_BitArraySet( declaring->writes, component );
+    }
+else
+    {
+    debug_assert( access == SCHEDULER_ACCESS_READ );
+    Math_BitArraySet( declaring->reads, component );
+    }
+
+scheduler->needs_rebuild = true;
+
+} /* Scheduler_DeclareAccess() */
+
+
+/*******************************************************************
+*
+*   Scheduler_Destroy()
+*
+*   DESCRIPTION:
+*       Destroy the scheduler, its thread pool and command buffer.
+*
+*******************************************************************/
+
+void Scheduler_Destroy( Scheduler *scheduler )
+{
+if( !scheduler )
+    {
+    return;
+    }
+
+if( scheduler->universe->thread_pool == scheduler->pool )
+    {
+    scheduler->universe->thread_pool = NULL;
+    }
+
+if( scheduler->universe->command_buffer == scheduler->command_buffer )
+    {
+    scheduler->universe->command_buffer = NULL;
+    }
+
+ThreadPool_Destroy( scheduler->pool );
+EntityCommandBuffer_Destroy( scheduler->command_buffer );
+free( scheduler );
+
+} /* Scheduler_Destroy() */
+
+
+/*******************************************************************
+*
+*   Scheduler_DoFrame()
+*
+*   DESCRIPTION:
+*       Run every registered system once.  In parallel mode, systems
+*       are started as soon as every earlier conflicting system has
+*       finished, and the calling thread runs the main thread
+*       systems and helps with the others until all are done.
+*
+*       Once every system has finished, the structural changes
+*       they recorded in the command buffer are played back.
+*
+*******************************************************************/
+
+void Scheduler_DoFrame( float frame_delta, Scheduler *scheduler )
+{
+scheduler->frame_delta = frame_delta;
+
+if( scheduler->mode == SCHEDULER_MODE_SINGLE_THREAD )
+    {
+    for( uint32_t i = 0; i < scheduler->count; i++ )
+        {
+        RunSystem( &scheduler->systems[ i ] );
+        }
+
+    EntityCommandBuffer_Playback( scheduler->universe, scheduler->command_buffer );
+    return;
+    }
+
+if( scheduler->needs_rebuild )
+    {
+    BuildGraph( scheduler );
+    }
+
+scheduler->main_ready.store( 0 );
+scheduler->unfinished.store( scheduler->count );
+for( uint32_t i = 0; i < scheduler->count; i++ )
+    {
+    scheduler->systems[ i ].remaining.store( scheduler->systems[ i ].predecessor_count );
+    }
+
+for( uint32_t i = 0; i < scheduler->count; i++ )
+    {
+    if( scheduler->systems[ i ].predecessor_count == 0 )
+        {
+        DispatchSystem( &scheduler->systems[ i ] );
+        }
+    }
+
+while( scheduler->unfinished.load() > 0 )
+    {
+    uint32_t ready = scheduler->main_ready.exchange( 0 );
+    if( ready )
+        {
+        for( uint32_t i = 0; i < scheduler->count; i++ )
+            {
+            if( ready & ( 1u << i ) )
+                {
+                RunSystem( &scheduler->systems[ i ] );
+                }
+            }
+
+        continue;
+        }
+
+    if( !ThreadPool_TryRunOne( scheduler->pool ) )
+        {
+        std::this_thread::yield();
+        }
+    }
+
+EntityCommandBuffer_Playback( scheduler->universe, scheduler->command_buffer );
+
+} /* Scheduler_DoFrame() */
+
+
+/*******************************************************************
+*
+*   Scheduler_RegisterSystem()
+*
+*   DESCRIPTION:
+*       Register a system to be run every frame.  Registration order
+*       is the order conflicting systems run in, and the order every
+*       system runs in single thread mode.
+*       Returns SCHEDULER_INVALID_SYSTEM if there is no room.
+*
+*******************************************************************/
+
+SchedulerSystemId Scheduler_RegisterSystem( const char *name, SchedulerSystemProc *proc, const SchedulerSystemFlags flags, Scheduler *scheduler )
+{
+if( scheduler->count >= cnt_of_array( scheduler->systems ) )
+    {
+    debug_assert_always();
+    return( SCHEDULER_INVALID_SYSTEM );
+    }
+
+SchedulerSystemId ret = scheduler->count++;
+SchedulerSystem *system = &scheduler->systems[ ret ];
+system->proc      = proc;
+system->flags     = flags;
+system->scheduler = scheduler;
+strncpy( system->metrics.name, name, cnt_of_array( system->metrics.name ) - 1 );
+
+scheduler->needs_rebuild = true;
+
+return( ret );
+
+} /* Scheduler_RegisterSystem() */
+
+
+/*******************************************************************
+*
+*   Scheduler_ReportMetrics()
+*
+*   DESCRIPTION:
+*       Copy out the per-system timings, in registration order.
+*       Returns the number of systems reported.
+*
+*******************************************************************/
+
+uint32_t Scheduler_ReportMetrics( const Scheduler *scheduler, SchedulerSystemMetrics *out, const uint32_t out_count )
+{
+uint32_t ret = min_of_vals( scheduler->count, out_count );
+for( uint32_t i = 0; i < ret; i++ )
+    {
+    out[ i ] = scheduler->systems[ i ].metrics;
+    }
+
+return( ret );
+
+} /* Scheduler_ReportMetrics() */
+
+
+/*******************************************************************
+*
+*   Scheduler_SetMode()
+*
+*   DESCRIPTION:
+*       Choose between parallel execution and deterministic single
+*       thread execution (useful for debugging).
+*
+*******************************************************************/
+
+void Scheduler_SetMode( const SchedulerMode mode, Scheduler *scheduler )
+{
+scheduler->mode = mode;
+
+} /* Scheduler_SetMode() */
+
+
+/*******************************************************************
+*
+*   BuildGraph()
+*
+*   DESCRIPTION:
+*       Build the dependency graph.  Each system depends on every
+*       earlier registered system it conflicts with.
+*
+*******************************************************************/
+
+static void BuildGraph( Scheduler *scheduler )
+{
+for( uint32_t i = 0; i < scheduler->count; i++ )
+    {
+    scheduler->systems[ i ].successors        = 0;
+    scheduler->systems[ i ].predecessor_count = 0;
+    }
+
+for( uint32_t i = 0; i < scheduler->count; i++ )
+    {
+    SchedulerSystem *later = &scheduler->systems[ i ];
+    for( uint32_t j = 0; j < i; j++ )
+        {
+        SchedulerSystem *earlier = &scheduler->systems[ j ];
+        if( IsConflicting( earlier, later ) )
+            {
+            earlier->successors |= ( 1u << i );
+            later->predecessor_count++;
+            }
+        }
+    }
+
+scheduler->needs_rebuild = false;
+
+} /* BuildGraph() */
+
+
+/*******************************************************************
+*
+*   DispatchSystem()
+*
+*   DESCRIPTION:
+*       The system's dependencies are met, so start it.
+*
+*******************************************************************/
+
+static void DispatchSystem( SchedulerSystem *system )
+{
+Scheduler *scheduler = system->scheduler;
+if( test_bits( system->flags, SCHEDULER_SYSTEM_FLAG_MAIN_THREAD ) )
+    {
+    uint32_t index = (uint32_t)( system - scheduler->systems );
+    scheduler->main_ready.fetch_or( 1u << index );
+    }
+else
+    {
+    ThreadPool_Submit( SystemJob, system, NULL, scheduler->pool );
+    }
+
+} /* DispatchSystem() */
+
+
+/*******************************************************************
+*
+*   IsConflicting()
+*
+*   DESCRIPTION:
+*       Can the two systems not run at the same time?
+*
+*******************************************************************/
+
+static bool IsConflicting( const SchedulerSystem *a, const SchedulerSystem *b )
+{
+if( test_any_bits( ( a->flags | b->flags ), SCHEDULER_SYSTEM_FLAG_STRUCTURAL ) )
+    {
+    return( true );
+    }
+
+for( uint32_t i = 0; i < ACCESS_ARRAY_COUNT; i++ )
+    {
+    if( ( a->writes[ i ] & ( b->reads[ i ] | b->writes[ i ] ) )
+     || ( b->writes[ i ] & a->reads[ i ] ) )
+        {
+        return( true );
+        }
+    }
+
+return( false );
+
+} /* IsConflicting() */
+
+
+/*******************************************************************
+*
+*   RunSystem()
+*
+*   DESCRIPTION:
+*       Run the system, time it, and release any systems which were
+*       waiting on it.
+*
+*******************************************************************/
+
+static void RunSystem( SchedulerSystem *system )
+{
+Scheduler *scheduler = system->scheduler;
+
+uint64_t start = Utilities_GetTimeNanoseconds();
+system->proc( scheduler->frame_delta, scheduler->universe );
+uint64_t elapsed = Utilities_GetTimeNanoseconds() - start;
+
+SchedulerSystemMetrics *metrics = &system->metrics;
+metrics->last_ns   = elapsed;
+metrics->max_ns    = max_of_vals( metrics->max_ns, elapsed );
+metrics->total_ns += elapsed;
+metrics->frame_count++;
+
+if( scheduler->mode == SCHEDULER_MODE_SINGLE_THREAD )
+    {
+    return;
+    }
+
+for( uint32_t i = 0; i < scheduler->count; i++ )
+    {
+    if( ( system->successors & ( 1u << i ) )
+     && scheduler->systems[ i ].remaining.fetch_sub( 1 ) == 1 )
+        {
+        DispatchSystem( &scheduler->systems[ i ] );
+        }
+    }
+
+scheduler->unfinished.fetch_sub( 1 );
+
+} /* RunSystem() */
+
+
+/*******************************************************************
+*
+*   SystemJob()
+*
+*   DESCRIPTION:
+*       Thread pool entry point for a system.
+*
+*******************************************************************/
+
+static void SystemJob( void *user )
+{
+RunSystem( (SchedulerSystem*)user );
+
+} /* SystemJob() */
+
+
+} /* namespace ECS */
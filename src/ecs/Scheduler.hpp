@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ComponentClass.hpp"
+#include "Universe.hpp"
+
+
+#define SCHEDULER_MAX_SYSTEM_COUNT  ( 32 )
+#define SCHEDULER_SYSTEM_NAME_MAX_LEN \
+                                    ( 32 )
+#define SCHEDULER_INVALID_SYSTEM    ( 0xffffffff )
+
+namespace ECS
+{
+typedef void SchedulerSystemProc( float frame_delta, Universe *universe );
+
+typedef uint32_t SchedulerSystemId;
+
+typedef enum _SchedulerMode
+    {
+    SCHEDULER_MODE_PARALLEL,        /* run non-conflicting systems on the thread pool */
+    SCHEDULER_MODE_SINGLE_THREAD    /* run every system in registration order         */
+    } SchedulerMode;
+
+typedef enum _SchedulerAccess
+    {
+    SCHEDULER_ACCESS_READ,
+    SCHEDULER_ACCESS_WRITE
+    } SchedulerAccess;
+
+typedef uint32_t SchedulerSystemFlags;
+enum
+    {
+    SCHEDULER_SYSTEM_FLAG_NONE        = 0,
+    SCHEDULER_SYSTEM_FLAG_MAIN_THREAD = 1 << 0, /* must run on the thread calling Scheduler_DoFrame */
+    SCHEDULER_SYSTEM_FLAG_STRUCTURAL  = 1 << 1  /* creates/destroys entities or attaches/removes components */
+    };
+
+typedef struct _SchedulerSystemMetrics
+    {
+    char                name[ SCHEDULER_SYSTEM_NAME_MAX_LEN ];
+    uint64_t            last_ns;
+    uint64_t            max_ns;
+    uint64_t            total_ns;
+    uint32_t            frame_count;
+    } SchedulerSystemMetrics;
+
+struct _Scheduler;
+typedef struct _Scheduler Scheduler;
+
+Scheduler *       Scheduler_Create( const uint32_t worker_count, Universe *universe );
+void              Scheduler_DeclareAccess( const SchedulerSystemId system, const ComponentClass component, const SchedulerAccess access, Scheduler *scheduler );
+void              Scheduler_Destroy( Scheduler *scheduler );
+void              Scheduler_DoFrame( float frame_delta, Scheduler *scheduler );
+SchedulerSystemId Scheduler_RegisterSystem( const char *name, SchedulerSystemProc *proc, const SchedulerSystemFlags flags, Scheduler *scheduler );
+uint32_t          Scheduler_ReportMetrics( const Scheduler *scheduler, SchedulerSystemMetrics *out, const uint32_t out_count );
+void              Scheduler_SetMode( const SchedulerMode mode, Scheduler *scheduler );
+
+} /* namespace ECS */
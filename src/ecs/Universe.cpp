@@ -1,17 +1,57 @@
 #include <cassert>
 #include <cstdint>
+#include <cstdlib>
 
 #include "Entity.hpp"
 #include "Command.hpp"
 #include "Component.hpp"
+#include "FrameAllocator.hpp"
 #include "Universe.hpp"
 #include "Utilities.hpp"
 
 namespace ECS
 {
+static void                      DestroyArchetypeEntity( const EntityId entity, Universe *universe );
 static ComponentRegistry *       GetComponentRegistry( const ComponentClass component, Universe *universe );
 static const ComponentRegistry * GetComponentRegistryConst( const ComponentClass component, const Universe *universe );
 static CommandProcedure          ProcessCommand;
+static uint32_t                  SortAndFilterVictims( const EntityId *entities, const uint32_t count, const Universe *universe, uint32_t *scratch, EntityId *out );
+
+
+/*******************************************************************
+*
+*   Universe_AdvanceFrame()
+*
+*   DESCRIPTION:
+*       Start a new frame of change tracking.  Component changes are
+*       stamped with the new frame number, and the registries keep
+*       their attach and remove journals for the last
+*       UNIVERSE_CHANGE_JOURNAL_FRAME_COUNT frames.
+*
+*       Archetype storage doesn't track changes.
+*
+*******************************************************************/
+
+void Universe_AdvanceFrame( Universe *universe )
+{
+universe->frame++;
+if( universe->storage != UNIVERSE_STORAGE_SPARSE_SET )
+    {
+    return;
+    }
+
+uint32_t oldest_journal_frame = 0;
+if( universe->frame >= UNIVERSE_CHANGE_JOURNAL_FRAME_COUNT )
+    {
+    oldest_journal_frame = universe->frame - UNIVERSE_CHANGE_JOURNAL_FRAME_COUNT + 1;
+    }
+
+for( uint32_t i = 0; i < cnt_of_array( universe->components ); i++ )
+    {
+    Component_BeginFrame( universe->frame, oldest_journal_frame, &universe->components[ i ] );
+    }
+
+}   /* Universe_AdvanceFrame() */
 
 
 /*******************************************************************
@@ -21,7 +61,11 @@ static CommandProcedure          ProcessCommand;
 *   DESCRIPTION:
 *       Attach the requested component to the entity.  If the entity
 *       already has this component attached, return the existing
-*       component instead.
+*       component instead.  Structure-of-arrays classes return NULL,
+*       see Universe_TryGetComponentField().
+*
+*       With archetype storage, the component moves whenever the
+*       entity's set of classes changes.
 *
 *******************************************************************/
 
@@ -33,12 +77,33 @@ if( !component_registry )
     return( NULL );
     }
 
-if( Component_EntityHasComponent( entity, component_registry ) )
+void *ret = NULL;
+if( universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    if( Archetype_EntityHasComponent( entity, component, &universe->archetypes ) )
+        {
+        return( Archetype_GetComponent( entity, component, &universe->archetypes ) );
+        }
+
+    ret = Archetype_AttachComponent( entity, component, &universe->archetypes );
+    }
+else
     {
-    return( Component_GetComponent( entity, component_registry ) );
+    if( Component_EntityHasComponent( entity, component_registry ) )
+        {
+        return( Component_GetComponent( entity, component_registry ) );
+        }
+
+    ret = Component_AttachComponent( entity, component_registry );
+    OwningGroup *owning_group = Universe_GetOwningGroup( component, universe );
+    if( owning_group )
+        {
+        /* packing may have moved the new component */
+        OwningGroup_OnComponentAttached( entity, owning_group );
+        ret = Component_GetComponent( entity, component_registry );
+        }
     }
 
-void *ret = Component_AttachComponent( entity, component_registry );
 ComponentLifetime *lifetime = &universe->lifetime[ component ];
 for( uint32_t i = 0; i < lifetime->notify_attach_count; i++ )
     {
@@ -84,11 +149,134 @@ for( uint32_t i = 0; i < cnt_of_array( universe->components ); i++ )
     Component_DestroyRegistry( &universe->components[ i ] );
     }
 
+Archetype_DestroyStorage( &universe->archetypes );
+free( universe->deferred_destroys );
 *universe = {};
 
 }   /* Universe_Destroy() */
 
 
+/*******************************************************************
+*
+*   Universe_DestroyDeferredEntities()
+*
+*   DESCRIPTION:
+*       Destroy all the entities which were deferred for
+*       destruction, as a single batch.
+*
+*******************************************************************/
+
+void Universe_DestroyDeferredEntities( Universe *universe )
+{
+if( universe->deferred_destroy_count == 0 )
+    {
+    return;
+    }
+
+uint32_t batch_count = universe->deferred_destroy_count;
+Universe_DestroyEntities( universe->deferred_destroys, batch_count, universe );
+
+/* keep any which were deferred by removal notifications during the batch */
+universe->deferred_destroy_count -= batch_count;
+memmove( universe->deferred_destroys, &universe->deferred_destroys[ batch_count ], universe->deferred_destroy_count * sizeof(*universe->deferred_destroys) );
+
+}   /* Universe_DestroyDeferredEntities() */
+
+
+/*******************************************************************
+*
+*   Universe_DestroyEntities()
+*
+*   DESCRIPTION:
+*       Destroy the given entities as a batch.  Each registry is
+*       compacted once for all of its victims, rather than
+*       swap-removing one component at a time.  Dead or repeated
+*       entities in the list are ignored.
+*
+*******************************************************************/
+
+void Universe_DestroyEntities( const EntityId *entities, const uint32_t count, Universe *universe )
+{
+if( count == 0 )
+    {
+    return;
+    }
+
+FrameAllocatorMarker scope = FrameAllocator_BeginScope();
+EntityId *victims       = FrameAllocator_AllocateArray( EntityId, count );
+uint32_t *dense_indices = FrameAllocator_AllocateArray( uint32_t, count );
+
+/* the dense indices aren't needed until the victims are sorted */
+uint32_t victim_count = SortAndFilterVictims( entities, count, universe, dense_indices, victims );
+if( universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    /* each victim leaves its archetype in one move */
+    for( uint32_t i = 0; i < victim_count; i++ )
+        {
+        DestroyArchetypeEntity( victims[ i ], universe );
+        }
+
+    Entity_DestroyEntities( victims, victim_count, &universe->entities );
+
+    FrameAllocator_EndScope( scope );
+    return;
+    }
+
+for( uint32_t i = 0; i < cnt_of_array( universe->components ); i++ )
+    {
+    ComponentClass     component          = (ComponentClass)i;
+    ComponentRegistry *component_registry = &universe->components[ i ];
+    if( Component_GetComponentCount( component_registry ) == 0 )
+        {
+        continue;
+        }
+
+    /* notify before anything moves */
+    ComponentLifetime *lifetime = &universe->lifetime[ component ];
+    for( uint32_t j = 0; lifetime->notify_remove_count > 0 && j < victim_count; j++ )
+        {
+        if( !Component_EntityHasComponent( victims[ j ], component_registry ) )
+            {
+            continue;
+            }
+
+        void *the_component = Component_GetComponent( victims[ j ], component_registry );
+
+        for( uint32_t k = 0; k < lifetime->notify_remove_count; k++ )
+            {
+            lifetime->notify_remove[ k ]( victims[ j ], component, the_component, universe );
+            }
+        }
+
+    OwningGroup *owning_group = Universe_GetOwningGroup( component, universe );
+    for( uint32_t j = 0; owning_group && j < victim_count; j++ )
+        {
+        if( Component_EntityHasComponent( victims[ j ], component_registry ) )
+            {
+            OwningGroup_OnComponentRemoving( victims[ j ], owning_group );
+            }
+        }
+
+    /* gather and compact */
+    uint32_t dense_count = 0;
+    for( uint32_t j = 0; j < victim_count; j++ )
+        {
+        if( Component_EntityHasComponent( victims[ j ], component_registry ) )
+            {
+            dense_indices[ dense_count++ ] = Component_GetDenseIndex( victims[ j ], component_registry );
+            }
+        }
+
+    Component_RemoveComponentsAtDenseIndices( dense_indices, dense_count, component_registry );
+    }
+
+Entity_DestroyEntities( victims, victim_count, &universe->entities );
+
+FrameAllocator_EndScope( scope );
+
+}   /* Universe_DestroyEntities() */
+
+
 /*******************************************************************
 *
 *   Universe_DestroyEntity()
@@ -101,9 +289,16 @@ for( uint32_t i = 0; i < cnt_of_array( universe->components ); i++ )
 
 void Universe_DestroyEntity( const EntityId entity, Universe *universe )
 {
-for( uint32_t i = 0; i < cnt_of_array( universe->components ); i++ )
+if( universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    DestroyArchetypeEntity( entity, universe );
+    }
+else
     {
-    Universe_RemoveComponentFromEntity( entity, (ComponentClass)i, universe );
+    for( uint32_t i = 0; i < cnt_of_array( universe->components ); i++ )
+        {
+        Universe_RemoveComponentFromEntity( entity, (ComponentClass)i, universe );
+        }
     }
 
 Entity_DestroyEntity( entity, &universe->entities );
@@ -111,6 +306,37 @@ Entity_DestroyEntity( entity, &universe->entities );
 }   /* Universe_DestroyEntity() */
 
 
+/*******************************************************************
+*
+*   Universe_DestroyEntityDeferred()
+*
+*   DESCRIPTION:
+*       Queue the given entity to be destroyed with the next batch
+*       in Universe_DestroyDeferredEntities().
+*
+*******************************************************************/
+
+void Universe_DestroyEntityDeferred( const EntityId entity, Universe *universe )
+{
+if( universe->deferred_destroy_count >= universe->deferred_destroy_capacity )
+    {
+    uint32_t new_capacity = Utilities_ClampToMinU32( 2 * universe->deferred_destroy_capacity, 64 );
+    EntityId *new_destroys = (EntityId*)realloc( universe->deferred_destroys, new_capacity * sizeof(*new_destroys) );
+    if( !new_destroys )
+        {
+        hard_assert_always();
+        return;
+        }
+
+    universe->deferred_destroys         = new_destroys;
+    universe->deferred_destroy_capacity = new_capacity;
+    }
+
+universe->deferred_destroys[ universe->deferred_destroy_count++ ] = entity;
+
+}   /* Universe_DestroyEntityDeferred() */
+
+
 /*******************************************************************
 *
 *   Universe_EntityHasComponent()
@@ -128,6 +354,11 @@ if( !component_registry )
     return( false );
     }
 
+if( universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    return( Archetype_EntityHasComponent( entity, component, &universe->archetypes ) );
+    }
+
 return( Component_EntityHasComponent( entity, component_registry ) );
 
 }   /* Universe_EntityHasComponent() */
@@ -154,12 +385,14 @@ return( Entity_EntityIsAlive( entity, &universe->entities ) );
 *   Universe_GetComponentRegistry()
 *
 *   DESCRIPTION:
-*       Get the requested component registry as read-only.
+*       Get the requested component registry.  Only sparse set
+*       universes store their components in registries.
 *
 *******************************************************************/
 
 ComponentRegistry * Universe_GetComponentRegistry( const ComponentClass component, Universe *universe )
 {
+debug_assert( universe->storage == UNIVERSE_STORAGE_SPARSE_SET );
 return( &universe->components[ component ] );
 
 }   /* Universe_GetComponentRegistry() */
@@ -176,11 +409,35 @@ return( &universe->components[ component ] );
 
 const ComponentRegistry * Universe_GetComponentRegistryConst( const ComponentClass component, const Universe *universe )
 {
+debug_assert( universe->storage == UNIVERSE_STORAGE_SPARSE_SET );
 return( &universe->components[ component ] );
 
 }   /* Universe_GetComponentRegistryConst() */
 
 
+/*******************************************************************
+*
+*   Universe_GetOwningGroup()
+*
+*   DESCRIPTION:
+*       Get the owning group which owns the given component class,
+*       or NULL if the class is not owned by a group.
+*
+*******************************************************************/
+
+OwningGroup * Universe_GetOwningGroup( const ComponentClass component, Universe *universe )
+{
+uint8_t owner = universe->component_owners[ component ];
+if( owner == UNIVERSE_NO_OWNING_GROUP )
+    {
+    return( NULL );
+    }
+
+return( &universe->owning_groups[ owner ] );
+
+}   /* Universe_GetOwningGroup() */
+
+
 /*******************************************************************
 *
 *   Universe_GetSingletonComponent()
@@ -217,14 +474,16 @@ return( ret );
 *
 *   DESCRIPTION:
 *       Initialize the given universe as empty and ready for
-*       business.
+*       business, storing its components in the given layout.
 *
 *******************************************************************/
 
-void Universe_Init( Universe *universe )
+void Universe_Init( const UniverseStorage storage, Universe *universe )
 {
 *universe = {};
+universe->storage = storage;
 Entity_InitRegistry( &universe->entities );
+Archetype_InitStorage( &universe->archetypes );
 
 for( uint32_t i = 0; i < cnt_of_array( universe->components ); i++ )
     {
@@ -236,6 +495,11 @@ for( uint32_t i = 0; i < cnt_of_array( universe->singleton_entities ); i++ )
     universe->singleton_entities[ i ].id_and_version = INVALID_ENTITY_ID;
     }
 
+for( uint32_t i = 0; i < cnt_of_array( universe->component_owners ); i++ )
+    {
+    universe->component_owners[ i ] = UNIVERSE_NO_OWNING_GROUP;
+    }
+
 }   /* Universe_Init() */
 
 
@@ -280,6 +544,7 @@ if( remove )
     {
     hard_assert( lifetime->notify_remove_count < cnt_of_array( lifetime->notify_remove ) );
     lifetime->notify_remove[lifetime->notify_remove_count++ ] = remove;
+    universe->components[ component ].is_removal_observed = true;
     }
 
 }   /* Universe_RegisterComponentLifetime() */
@@ -299,18 +564,30 @@ void Universe_RemoveComponentFromEntity( const EntityId entity, const ComponentC
 {
 ComponentRegistry *component_registry = GetComponentRegistry( component, universe );
 if( !component_registry
- || !Component_EntityHasComponent( entity, component_registry ) )
+ || !Universe_EntityHasComponent( entity, component, universe ) )
     {
     return;
     }
 
-void *the_component = Component_GetComponent( entity, component_registry );
+void *the_component = Universe_TryGetComponent( entity, component, universe );
 ComponentLifetime *lifetime = &universe->lifetime[ component ];
 for( uint32_t i = 0; i < lifetime->notify_remove_count; i++ )
     {
     lifetime->notify_remove[ i ]( entity, component, the_component, universe );
     }
 
+if( universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    Archetype_RemoveComponent( entity, component, &universe->archetypes );
+    return;
+    }
+
+OwningGroup *owning_group = Universe_GetOwningGroup( component, universe );
+if( owning_group )
+    {
+    OwningGroup_OnComponentRemoving( entity, owning_group );
+    }
+
 Component_RemoveComponent( entity, component_registry );
 
 }   /* Universe_RemoveComponentFromEntity() */
@@ -328,8 +605,15 @@ Component_RemoveComponent( entity, component_registry );
 void * Universe_TryGetComponent( const EntityId entity, const ComponentClass component, Universe *universe )
 {
 ComponentRegistry *component_registry = GetComponentRegistry( component, universe );
-if( !component_registry
- || !Component_EntityHasComponent( entity, component_registry ) )
+if( !component_registry )
+    {
+    return( NULL );
+    }
+else if( universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    return( Archetype_GetComponent( entity, component, &universe->archetypes ) );
+    }
+else if( !Component_EntityHasComponent( entity, component_registry ) )
     {
     return( NULL );
     }
@@ -339,6 +623,122 @@ return( Component_GetComponent( entity, component_registry ) );
 }   /* Universe_TryGetComponent() */
 
 
+/*******************************************************************
+*
+*   Universe_TryGetComponentField()
+*
+*   DESCRIPTION:
+*       Try to get the requested field of the entity's
+*       structure-of-arrays component.
+*
+*******************************************************************/
+
+void * Universe_TryGetComponentField( const EntityId entity, const ComponentClass component, const uint8_t field, Universe *universe )
+{
+ComponentRegistry *component_registry = GetComponentRegistry( component, universe );
+if( !component_registry )
+    {
+    return( NULL );
+    }
+else if( universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    return( Archetype_GetField( entity, component, field, &universe->archetypes ) );
+    }
+
+return( Component_GetField( entity, field, component_registry ) );
+
+}   /* Universe_TryGetComponentField() */
+
+
+/*******************************************************************
+*
+*   Universe_TryGetComponentFieldMut()
+*
+*   DESCRIPTION:
+*       Try to get the requested field of the entity's
+*       structure-of-arrays component for writing, marking the
+*       component changed.
+*
+*******************************************************************/
+
+void * Universe_TryGetComponentFieldMut( const EntityId entity, const ComponentClass component, const uint8_t field, Universe *universe )
+{
+ComponentRegistry *component_registry = GetComponentRegistry( component, universe );
+if( !component_registry )
+    {
+    return( NULL );
+    }
+else if( universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    return( Archetype_GetField( entity, component, field, &universe->archetypes ) );
+    }
+
+return( Component_GetFieldMut( entity, field, component_registry ) );
+
+}   /* Universe_TryGetComponentFieldMut() */
+
+
+/*******************************************************************
+*
+*   Universe_TryGetComponentMut()
+*
+*   DESCRIPTION:
+*       Try to get the requested component from the entity for
+*       writing, marking it changed.
+*
+*******************************************************************/
+
+void * Universe_TryGetComponentMut( const EntityId entity, const ComponentClass component, Universe *universe )
+{
+ComponentRegistry *component_registry = GetComponentRegistry( component, universe );
+if( !component_registry )
+    {
+    return( NULL );
+    }
+else if( universe->storage == UNIVERSE_STORAGE_ARCHETYPE )
+    {
+    return( Archetype_GetComponent( entity, component, &universe->archetypes ) );
+    }
+
+return( Component_GetComponentMut( entity, component_registry ) );
+
+}   /* Universe_TryGetComponentMut() */
+
+
+/*******************************************************************
+*
+*   DestroyArchetypeEntity()
+*
+*   DESCRIPTION:
+*       Notify the removal of each of the entity's components, then
+*       take it out of archetype storage in a single move.
+*
+*******************************************************************/
+
+static void DestroyArchetypeEntity( const EntityId entity, Universe *universe )
+{
+for( uint32_t i = 0; i < COMPONENT_CNT; i++ )
+    {
+    ComponentClass     component = (ComponentClass)i;
+    ComponentLifetime *lifetime  = &universe->lifetime[ component ];
+    if( lifetime->notify_remove_count == 0
+     || !Archetype_EntityHasComponent( entity, component, &universe->archetypes ) )
+        {
+        continue;
+        }
+
+    void *the_component = Archetype_GetComponent( entity, component, &universe->archetypes );
+    for( uint32_t j = 0; j < lifetime->notify_remove_count; j++ )
+        {
+        lifetime->notify_remove[ j ]( entity, component, the_component, universe );
+        }
+    }
+
+Archetype_RemoveEntity( entity, &universe->archetypes );
+
+}   /* DestroyArchetypeEntity() */
+
+
 /*******************************************************************
 *
 *   GetComponentRegistry()
@@ -397,7 +797,7 @@ static void ProcessCommand( const ECS::PendingCommandComponent *command, ECS::Un
 switch( command->cls )
     {
     case PENDING_COMMAND_DESTROY_ENTITY:
-        Universe_DestroyEntity( command->u.destroy_entity.entity, universe );
+        Universe_DestroyEntityDeferred( command->u.destroy_entity.entity, universe );
         break;
 
     default:
@@ -408,4 +808,38 @@ switch( command->cls )
 }   /* ProcessCommand() */
 
 
+/*******************************************************************
+*
+*   SortAndFilterVictims()
+*
+*   DESCRIPTION:
+*       Sort the given entities so repeats are adjacent, dropping
+*       any duplicates and any which are already dead.  Returns the
+*       count written.  The scratch array must hold count entries.
+*
+*******************************************************************/
+
+static uint32_t SortAndFilterVictims( const EntityId *entities, const uint32_t count, const Universe *universe, uint32_t *scratch, EntityId *out )
+{
+compiler_assert( sizeof( EntityId ) == sizeof( u32 ), universe_cpp );
+memcpy( out, entities, count * sizeof(*out) );
+Utilities_RadixSortU32Ascending( count, (uint32_t*)out, scratch );
+
+uint32_t ret = 0;
+for( uint32_t i = 0; i < count; i++ )
+    {
+    if( ( ret > 0 && out[ ret - 1 ].id_and_version == out[ i ].id_and_version )
+     || !Universe_EntityIsAlive( out[ i ], universe ) )
+        {
+        continue;
+        }
+
+    out[ ret++ ] = out[ i ];
+    }
+
+return( ret );
+
+}   /* SortAndFilterVictims() */
+
+
 } /* namespace ECS */
\ No newline at end of file
@@ -1,18 +1,34 @@
 #pragma once
 
+#include "Archetype.hpp"
 #include "Component.hpp"
 #include "ComponentClass.hpp"
 #include "Entity.hpp"
+#include "EntityCommandBuffer.hpp"
+#include "OwningGroup.hpp"
 
 
 #define UNIVERSE_MAX_ON_ATTACH_COMPONENT_PROC_COUNT \
                                     ( 4 )
 #define COMPONENT_MAX_ON_REMOVE_COMPONENT_PROC_COUNT \
                                     UNIVERSE_MAX_ON_ATTACH_COMPONENT_PROC_COUNT
+#define UNIVERSE_MAX_OWNING_GROUP_COUNT \
+                                    ( 4 )
+#define UNIVERSE_NO_OWNING_GROUP    ( 0xff )
+#define UNIVERSE_CHANGE_JOURNAL_FRAME_COUNT \
+                                    ( 8 )
 
 namespace ECS
 {
 struct _Universe;
+
+typedef enum _UniverseStorage
+    {
+    UNIVERSE_STORAGE_SPARSE_SET,    /* one sparse set registry per component class            */
+    UNIVERSE_STORAGE_ARCHETYPE      /* entities packed in chunks by their set of classes      */
+    } UniverseStorage;
+
+/* component is NULL for structure-of-arrays classes */
 typedef void UniverseComponentOnAttachProc( const EntityId entity, const ComponentClass cls, void *component, _Universe *universe );
 typedef void UniverseComponentOnRemoveProc( const EntityId entity, const ComponentClass cls, void *component, _Universe *universe );
 
@@ -28,25 +44,45 @@ typedef struct _ComponentLifetime
 
 typedef struct _Universe
     {
-    ComponentRegistry   components[ COMPONENT_CNT ];
+    UniverseStorage     storage;
+    ComponentRegistry   components[ COMPONENT_CNT ];    /* sparse set storage only */
+    ArchetypeStorage    archetypes;                     /* archetype storage only  */
     EntityRegistry      entities;
     EntityId            singleton_entities[ COMPONENT_CNT ];
     ComponentLifetime   lifetime[ COMPONENT_CNT ];
+    OwningGroup         owning_groups[ UNIVERSE_MAX_OWNING_GROUP_COUNT ];
+    uint8_t             owning_group_count;
+    uint8_t             component_owners[ COMPONENT_CNT ];
+    EntityId           *deferred_destroys;
+    uint32_t            deferred_destroy_count;
+    uint32_t            deferred_destroy_capacity;
+    ThreadPool         *thread_pool;    /* for parallel iteration, owned by the scheduler */
+    EntityCommandBuffer
+                       *command_buffer; /* played back after the systems, owned by the scheduler */
+    uint32_t            frame;          /* stamped on component changes, see Universe_AdvanceFrame() */
     } Universe;
 
+void                      Universe_AdvanceFrame( Universe *universe );
 void *                    Universe_AttachComponentToEntity( const EntityId entity, const ComponentClass component, Universe *universe );
 EntityId                  Universe_CreateNewEntity( Universe *universe );
 void                      Universe_Destroy( Universe *universe );
+void                      Universe_DestroyDeferredEntities( Universe *universe );
+void                      Universe_DestroyEntities( const EntityId *entities, const uint32_t count, Universe *universe );
 void                      Universe_DestroyEntity( const EntityId entity, Universe *universe );
+void                      Universe_DestroyEntityDeferred( const EntityId entity, Universe *universe );
 bool                      Universe_EntityHasComponent( const EntityId entity, const ComponentClass component, const Universe *universe );
 bool                      Universe_EntityIsAlive( const EntityId entity, const Universe *universe );
 ComponentRegistry *       Universe_GetComponentRegistry( const ComponentClass component, Universe *universe );
 const ComponentRegistry * Universe_GetComponentRegistryConst( const ComponentClass component, const Universe *universe );
+OwningGroup *             Universe_GetOwningGroup( const ComponentClass component, Universe *universe );
 void *                    Universe_GetSingletonComponent( const ComponentClass component, Universe *universe );
-void                      Universe_Init( Universe *universe );
+void                      Universe_Init( const UniverseStorage storage, Universe *universe );
 void                      Universe_RegisterCommandProcessors( Universe *universe );
 void                      Universe_RegisterComponentLifetime( const ComponentClass component, UniverseComponentOnAttachProc *attach, UniverseComponentOnRemoveProc *remove, Universe *universe );
 void                      Universe_RemoveComponentFromEntity( const EntityId entity, const ComponentClass component, Universe *universe );
 void *                    Universe_TryGetComponent( const EntityId entity, const ComponentClass component, Universe *universe );
+void *                    Universe_TryGetComponentField( const EntityId entity, const ComponentClass component, const uint8_t field, Universe *universe );
+void *                    Universe_TryGetComponentFieldMut( const EntityId entity, const ComponentClass component, const uint8_t field, Universe *universe );
+void *                    Universe_TryGetComponentMut( const EntityId entity, const ComponentClass component, Universe *universe );
 
 } /* namespace ECS */
\ No newline at end of file
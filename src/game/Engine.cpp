@@ -1,10 +1,14 @@
 #include "Command.hpp"
 #include "Engine.hpp"
 #include "Event.hpp"
+#include "FrameAllocator.hpp"
 #include "GameMode.hpp"
 #include "HotVars.hpp"
 #include "PlayerInput.hpp"
 #include "Render.hpp"
+#include "Scheduler.hpp"
+#include "StringIntern.hpp"
+#include "ThreadPool.hpp"
 #include "Universe.hpp"
 #include "Sound.hpp"
 
@@ -13,8 +17,10 @@ using namespace Game;
 
 
 static Universe the_universe;
+static Scheduler *the_scheduler;
 
 static void OnFirstFrame();
+static bool RegisterSystems();
 
 
 /*******************************************************************
@@ -44,7 +50,7 @@ Render_ChangeResolutions( width, height, &the_universe );
 
 bool Engine_Init( VkSurfaceKHR surface, VkInstance vulkan )
 {
-Universe_Init( &the_universe );
+Universe_Init( UNIVERSE_STORAGE_SPARSE_SET, &the_universe );
 
 if( !Command_Init( &the_universe ) )                 return( false );
 if( !Event_Init( &the_universe ) )                   return( false );
@@ -53,6 +59,7 @@ if( !Render_Init( surface, vulkan, &the_universe ) ) return( false );
 if( !Sound_Init( &the_universe ) )                   return( false );
 if( !PlayerInput_Init( &the_universe ) )             return( false );
 if( !GameMode_Init( &the_universe ) )                return( false );
+if( !RegisterSystems() )                             return( false );
 
 Event_DoFrame( 0.0f, &the_universe );
 Command_DoFrame( 0.0f, &the_universe );
@@ -74,20 +81,22 @@ return( true );
 void Engine_DoFrame( float frame_delta )
 {
 static bool is_first_frame = true;
+Universe_AdvanceFrame( &the_universe );
+
 if( is_first_frame )
     {
     OnFirstFrame();
     }
 
-GameMode_DoFrame( frame_delta, &the_universe );
-PlayerInput_DoFrame( frame_delta, &the_universe );
-Render_DoFrame( frame_delta, &the_universe );
-Sound_Update( frame_delta, &the_universe );
+Scheduler_DoFrame( frame_delta, the_scheduler );
 
-/* always last */
+/* always last, and always serial - every system has finished */
 Event_DoFrame( frame_delta, &the_universe );
 Command_DoFrame( frame_delta, &the_universe );
 
+/* every system has finished with its scratch memory */
+FrameAllocator_EndFrame();
+
 is_first_frame = false;
 } /* Engine_DoFrame() */
 
@@ -103,6 +112,9 @@ is_first_frame = false;
 
 bool Engine_Destroy()
 {
+Scheduler_Destroy( the_scheduler );
+the_scheduler = NULL;
+
 GameMode_Destroy( &the_universe );
 PlayerInput_Destroy( &the_universe );
 Render_Destroy( &the_universe );
@@ -110,6 +122,8 @@ Sound_Destroy ( &the_universe );
 Event_Destroy( &the_universe );
 Command_Destroy( &the_universe );
 Universe_Destroy( &the_universe );
+FrameAllocator_Destroy();
+StringIntern_Destroy();
 
 return( true );
 
@@ -134,16 +148,16 @@ static void OnFirstFrame()
     scene->viewport_top_left = Math_Float2Make( 0.0f, 0.0f );
     scene->viewport_extent   = Math_Float2Make( 1.0f, 1.0f );
     strcpy_s( scene->scene_name, cnt_of_array( scene->scene_name ), "test_scene" );
-    scene->scene_name_hash = Utilities_HashString2( scene->scene_name );
+    scene->scene_name_id = StringIntern_Intern2( scene->scene_name );
 
     EntityId model_test_entity = Universe_CreateNewEntity( &the_universe );
-    TransformComponent *transform = (TransformComponent*)Universe_AttachComponentToEntity( model_test_entity, COMPONENT_TRANSFORM, &the_universe );
-    transform->position = Math_Float3Make( 0.0f, 0.0f, 0.0f );
-    transform->rotation = QUATERNION_IDENTITY;
-    transform->scale    = Math_Float3Make( 1.0f, 1.0f, 1.0f );
+    Universe_AttachComponentToEntity( model_test_entity, COMPONENT_TRANSFORM, &the_universe );
+    *(Float3*)Universe_TryGetComponentFieldMut( model_test_entity, COMPONENT_TRANSFORM, TRANSFORM_FIELD_POSITION, &the_universe ) = Math_Float3Make( 0.0f, 0.0f, 0.0f );
+    *(Quaternion*)Universe_TryGetComponentFieldMut( model_test_entity, COMPONENT_TRANSFORM, TRANSFORM_FIELD_ROTATION, &the_universe ) = QUATERNION_IDENTITY;
+    *(Float3*)Universe_TryGetComponentFieldMut( model_test_entity, COMPONENT_TRANSFORM, TRANSFORM_FIELD_SCALE, &the_universe ) = Math_Float3Make( 1.0f, 1.0f, 1.0f );
 
     //ModelComponent *model = Render_LoadModel( "model_fmod_splash", model_test_entity, &the_universe );
-    //model->scene_name_hash = scene->scene_name_hash;
+    //model->scene_name_id = scene->scene_name_id;
     }
 
 //    {
@@ -155,4 +169,50 @@ static void OnFirstFrame()
 //    }
 //// TODO <MPA> - Testing grounds, remove later
 
-} /* OnFirstFrame() */
\ No newline at end of file
+} /* OnFirstFrame() */
+
+
+/*******************************************************************
+*
+*   RegisterSystems()
+*
+*   DESCRIPTION:
+*       Register the per-frame systems with the scheduler, along
+*       with the component classes each of them touches.
+*       Registration order is the order conflicting systems run in.
+*
+*******************************************************************/
+
+static bool RegisterSystems()
+{
+the_scheduler = Scheduler_Create( THREAD_POOL_DEFAULT_WORKER_COUNT, &the_universe );
+if( !the_scheduler )
+    {
+    return( false );
+    }
+
+SchedulerSystemId game_mode = Scheduler_RegisterSystem( "GameMode", GameMode_DoFrame, SCHEDULER_SYSTEM_FLAG_NONE, the_scheduler );
+Scheduler_DeclareAccess( game_mode, COMPONENT_SINGLETON_GAME_MODE, SCHEDULER_ACCESS_WRITE, the_scheduler );
+
+/* GameInput is polled on the window thread */
+SchedulerSystemId player_input = Scheduler_RegisterSystem( "PlayerInput", PlayerInput_DoFrame, SCHEDULER_SYSTEM_FLAG_MAIN_THREAD, the_scheduler );
+Scheduler_DeclareAccess( player_input, COMPONENT_SINGLETON_CONTROLLER_INPUT, SCHEDULER_ACCESS_WRITE, the_scheduler );
+Scheduler_DeclareAccess( player_input, COMPONENT_SINGLETON_KEYBOARD_INPUT,   SCHEDULER_ACCESS_WRITE, the_scheduler );
+Scheduler_DeclareAccess( player_input, COMPONENT_SINGLETON_PLAYER_INPUT,     SCHEDULER_ACCESS_WRITE, the_scheduler );
+
+/* presents to the window surface */
+SchedulerSystemId render = Scheduler_RegisterSystem( "Render", Render_DoFrame, SCHEDULER_SYSTEM_FLAG_MAIN_THREAD, the_scheduler );
+Scheduler_DeclareAccess( render, COMPONENT_SCENE,            SCHEDULER_ACCESS_READ,  the_scheduler );
+Scheduler_DeclareAccess( render, COMPONENT_MODEL,            SCHEDULER_ACCESS_READ,  the_scheduler );
+Scheduler_DeclareAccess( render, COMPONENT_TRANSFORM,        SCHEDULER_ACCESS_READ,  the_scheduler );
+Scheduler_DeclareAccess( render, COMPONENT_SINGLETON_RENDER, SCHEDULER_ACCESS_WRITE, the_scheduler );
+
+/* attaches sound components, so it must run alone */
+SchedulerSystemId sound = Scheduler_RegisterSystem( "Sound", Sound_Update, SCHEDULER_SYSTEM_FLAG_STRUCTURAL, the_scheduler );
+Scheduler_DeclareAccess( sound, COMPONENT_SINGLETON_CONTROLLER_INPUT, SCHEDULER_ACCESS_READ,  the_scheduler );
+Scheduler_DeclareAccess( sound, COMPONENT_SINGLETON_SOUND_SYSTEM,     SCHEDULER_ACCESS_WRITE, the_scheduler );
+Scheduler_DeclareAccess( sound, COMPONENT_SOUNDS,                     SCHEDULER_ACCESS_WRITE, the_scheduler );
+
+return( true );
+
+} /* RegisterSystems() */
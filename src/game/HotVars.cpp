@@ -4,8 +4,12 @@
 
 #include "Command.hpp"
 #include "Event.hpp"
-#include "HashMap.hpp"
+#include "FileView.hpp"
+#include "FlatHashMap.hpp"
+#include "FrameAllocator.hpp"
 #include "NonOwningGroup.hpp"
+#include "SlabAllocator.hpp"
+#include "StringIntern.hpp"
 #include "Universe.hpp"
 #include "Utilities.hpp"
 
@@ -18,11 +22,10 @@ using namespace ECS;
 #define LINE_BUFFER_LENGTH          ( 200 )
 #define DEFINITIONS_MAX_CNT         ( 150 )
 #define BINDINGS_MAX_CNT            ( 150 )
+#define NAME_SLOT_SIZE              ( 64 )      /* longer names fall back to malloc */
 
 const char *ROOT_DIRECTORY_NAME = ":/";
 
-HASH_MAP_IMPLEMENT( NameHashMap, DEFINITIONS_MAX_CNT, EntityId );
-
 namespace Game
 {
 
@@ -34,7 +37,8 @@ typedef struct _HotVarsState
     Universe           *universe;
     NonOwningGroupIterator
                         group;
-    NameHashMap         names;
+    FlatHashMap         names;          /* interned StringId to EntityId */
+    SlabAllocator       name_slots;     /* storage for names up to NAME_SLOT_SIZE */
     EntityId            current_parse_directory;
     } HotVarsState;
 
@@ -56,9 +60,14 @@ return( (HotVarsState *)component->ptr );
 } /* AsHotVarsState() */
 
 
+static char *                        AllocName( const uint32_t sz, HotVarsState *system );
 static void                          Bind( const HotVarBinding *request, HotVarsState *system );
+static void                          DeleteName( const char *name, const uint32_t length, HotVarsState *system );
 static void                          DropDefinitions( HotVarsState *system );
 static EntityId *                    FindDirectoryFromName( const char *name, HotVarsState *system );
+static EntityId *                    FindName( const char *name, const uint32_t length, HotVarsState *system );
+static void                          FreeName( const char *name, const uint32_t sz, HotVarsState *system );
+static void                          InsertName( const char *name, const uint32_t length, const EntityId entity, HotVarsState *system );
 static UniverseComponentOnRemoveProc OnRemoveComponent;
 static void                          ParseDirectory( HotVarsState *system );
 static void                          ParseKeyValuePair( HotVarsState *system );
@@ -97,7 +106,9 @@ Command_AddCommandClass( COMMAND_PROCESSOR_HOT_VARS, PENDING_COMMAND_SAVE_HOT_VA
 Universe_RegisterComponentLifetime( COMPONENT_HOT_VAR_DEFINITION, nullptr, OnRemoveComponent, universe );
 Universe_RegisterComponentLifetime( COMPONENT_HOT_VAR_BINDING,    nullptr, OnRemoveComponent, universe );
 
-HashMap_InitImplementation( &system->names );
+/* handles are unique, so they are the whole key */
+FlatHashMap_Init( DEFINITIONS_MAX_CNT, 0, sizeof(EntityId), NULL, &system->names );
+SlabAllocator_Init( NAME_SLOT_SIZE, 1, DEFINITIONS_MAX_CNT, SLAB_ALLOCATOR_FLAG_NONE, &system->name_slots );
 
 /* find the file location */
 strcpy( system->file_path, IN_DEPLOY_PATH HOTVAR_FILENAME );
@@ -135,6 +146,28 @@ return( true );
 } /* HotVars_Init() */
 
 
+/*******************************************************************
+*
+*   AllocName()
+*
+*   DESCRIPTION:
+*       Allocate storage for a name of the given size in bytes.  Free
+*       it with FreeName(), passing the same size.
+*
+*******************************************************************/
+
+static char * AllocName( const uint32_t sz, HotVarsState *system )
+{
+if( sz <= NAME_SLOT_SIZE )
+    {
+    return( SlabAllocator_New( char, &system->name_slots ) );
+    }
+
+return( (char*)malloc( sz ) );
+
+}   /* AllocName() */
+
+
 /*******************************************************************
 *
 *   Bind()
@@ -154,8 +187,7 @@ if( !pdirectory )
     return;
     }
 
-u32 keycode = Utilities_HashString( request->name, strlen( request->name ) );
-EntityId *pentity = (EntityId*)HashMap_At( keycode, &system->names.map );
+EntityId *pentity = FindName( request->name, (uint32_t)strlen( request->name ), system );
 if( !pentity )
     {
     /* no definition exists for this binding request */
@@ -204,7 +236,7 @@ if( sanity )
     }
 
 HotVarBindingComponent *binding = (HotVarBindingComponent*)Universe_AttachComponentToEntity( *pentity, COMPONENT_HOT_VAR_BINDING, system->universe );
-char *name = (char*)malloc( strlen( request->name ) + 1 );
+char *name = AllocName( (uint32_t)strlen( request->name ) + 1, system );
 if( !name )
     {
     hard_assert_always();
@@ -222,6 +254,26 @@ UpdateBindingFromDefinition( definition, binding );
 } /* Bind() */
 
 
+/*******************************************************************
+*
+*   DeleteName()
+*
+*   DESCRIPTION:
+*       Forget the entity of the given name.
+*
+*******************************************************************/
+
+static void DeleteName( const char *name, const uint32_t length, HotVarsState *system )
+{
+StringId id = StringIntern_Find( name, length );
+if( id != STRING_ID_INVALID )
+    {
+    FlatHashMap_Delete( id, NULL, NULL, &system->names );
+    }
+
+}   /* DeleteName() */
+
+
 /*******************************************************************
 *
 *   DropDefinitions()
@@ -239,13 +291,17 @@ EntityId entity;
 HotVarDefinitionComponent *definition;
 while( NonOwningGroup_GetNext( &system->group, &entity, (void**)&definition))
     {
-    u32 keycode = Utilities_HashString( definition->name, strlen( definition->name ) );
-    Universe_RemoveComponentFromEntity( entity, COMPONENT_HOT_VAR_DEFINITION, system->universe );
+    /* the name is freed with the definition, so forget it first */
     HotVarBindingComponent *binding = (HotVarBindingComponent*)Universe_TryGetComponent( entity, COMPONENT_HOT_VAR_BINDING, system->universe );
+    if( !binding )
+        {
+        DeleteName( definition->name, (uint32_t)strlen( definition->name ), system );
+        }
+
+    Universe_RemoveComponentFromEntity( entity, COMPONENT_HOT_VAR_DEFINITION, system->universe );
     if( !binding )
         {
         Universe_DestroyEntity( entity, system->universe );
-        HashMap_Delete( keycode, &system->names.map );
         }    
     }
 
@@ -284,12 +340,76 @@ if( !length )
     return( nullptr );
     }
 
-u32 keycode = Utilities_HashString( name, length );
-return( (EntityId*)HashMap_At( keycode, &system->names.map ) );
+return( FindName( name, (uint32_t)length, system ) );
 
 }    /* FindDirectoryFromName() */
 
 
+/*******************************************************************
+*
+*   FindName()
+*
+*   DESCRIPTION:
+*       Find the entity of the given name in our name map.  The
+*       pointer is only valid until the map next changes.
+*
+*******************************************************************/
+
+static EntityId * FindName( const char *name, const uint32_t length, HotVarsState *system )
+{
+StringId id = StringIntern_Find( name, length );
+if( id == STRING_ID_INVALID )
+    {
+    return( nullptr );
+    }
+
+return( (EntityId*)FlatHashMap_At( id, NULL, &system->names ) );
+
+}   /* FindName() */
+
+
+/*******************************************************************
+*
+*   FreeName()
+*
+*   DESCRIPTION:
+*       Free a name allocated by AllocName().
+*
+*******************************************************************/
+
+static void FreeName( const char *name, const uint32_t sz, HotVarsState *system )
+{
+if( sz <= NAME_SLOT_SIZE )
+    {
+    SlabAllocator_Free( (void*)name, &system->name_slots );
+    }
+else
+    {
+    free( (void*)name );
+    }
+
+}   /* FreeName() */
+
+
+/*******************************************************************
+*
+*   InsertName()
+*
+*   DESCRIPTION:
+*       Map the given name to its entity, by its interned handle,
+*       so names which hash alike never alias.
+*
+*******************************************************************/
+
+static void InsertName( const char *name, const uint32_t length, const EntityId entity, HotVarsState *system )
+{
+StringId id = StringIntern_Intern( name, length );
+debug_assert( !FlatHashMap_At( id, NULL, &system->names ) );
+FlatHashMap_Insert( id, NULL, &entity, &system->names );
+
+}   /* InsertName() */
+
+
 /*******************************************************************
 *
 *   OnRemoveComponent()
@@ -306,14 +426,14 @@ switch( cls )
     case COMPONENT_HOT_VAR_BINDING:
         {
         HotVarBindingComponent *bind = (HotVarBindingComponent*)component;
-        free( (void*)bind->binding.name );
+        FreeName( bind->binding.name, (uint32_t)strlen( bind->binding.name ) + 1, AsHotVarsState( universe ) );
         break;
         }
 
     case COMPONENT_HOT_VAR_DEFINITION:
         {
         HotVarDefinitionComponent *def = (HotVarDefinitionComponent*)component;
-        free( (void*)def->name );
+        FreeName( def->name, (uint32_t)strlen( def->name ) + 1, AsHotVarsState( universe ) );
         break;
         }
 
@@ -386,8 +506,7 @@ while( name_length > 1
     name_length--;
     }
 
-u32 keycode = Utilities_HashString( &system->line_buffer[ caret ], name_length );
-EntityId *pentity = (EntityId*)HashMap_At( keycode, &system->names.map );
+EntityId *pentity = FindName( &system->line_buffer[ caret ], (uint32_t)name_length, system );
 if( pentity )
     {
     system->current_parse_directory = *pentity;
@@ -400,7 +519,7 @@ if( pentity )
     }
 
 /* add the definition */
-char *name = (char*)malloc( name_length + 1 );
+char *name = AllocName( (uint32_t)name_length + 1, system );
 if( !name )
     {
     hard_assert_always();
@@ -410,10 +529,12 @@ if( !name )
 if( !pentity )
     {
     system->current_parse_directory = Universe_CreateNewEntity( system->universe );
-    HashMap_Insert( keycode, &system->current_parse_directory, &system->names.map );
+    InsertName( &system->line_buffer[ caret ], (uint32_t)name_length, system->current_parse_directory, system );
     }
 
-strcpy( name, &system->line_buffer[ caret ] );
+/* copy the trimmed name, so it frees with the size it was allocated with */
+memcpy( name, &system->line_buffer[ caret ], name_length );
+name[ name_length ] = 0;
 
 HotVarDefinitionComponent *def = (HotVarDefinitionComponent*)Universe_AttachComponentToEntity( system->current_parse_directory, COMPONENT_HOT_VAR_DEFINITION, system->universe );
 def->type = HOT_VARS_DIRECTORY;
@@ -564,27 +685,26 @@ if( !dir )
     }
 
 /* add the definition */
-int name_length = (int)strlen( dir->name ) + 1/* slash */ + (int)strlen( key_str );
+bool needs_slash = strlen( dir->name ) > 1;
+int name_length = (int)strlen( dir->name ) + ( needs_slash ? 1 : 0 ) + (int)strlen( key_str );
 int buffer_length = name_length + 1;
-char *name = (char*)malloc( buffer_length );
+char *name = AllocName( (uint32_t)buffer_length, system );
 if( !name )
     {
     hard_assert_always();
     return;
     }
 
-if( strlen( dir->name ) > 1 )
+if( needs_slash )
     {
     sprintf_s( name, buffer_length, "%s/%s", dir->name, key_str );
     }
 else
     {
     sprintf_s( name, buffer_length, "%s%s", dir->name, key_str );
-    name_length--;
     }
     
-u32 keycode       = Utilities_HashString( name, name_length );
-EntityId *pentity = (EntityId*)HashMap_At( keycode, &system->names.map );
+EntityId *pentity = FindName( name, (uint32_t)name_length, system );
 EntityId entity;
 if( pentity )
     {
@@ -617,14 +737,14 @@ if( pentity )
                 }
             }
 
-        free( name );
+        FreeName( name, (uint32_t)buffer_length, system );
         return;
         }
     }
 else
     {
     entity = Universe_CreateNewEntity( system->universe );
-    HashMap_Insert( keycode, &entity, &system->names.map );
+    InsertName( name, (uint32_t)name_length, entity, system );
     }
 
 HotVarDefinitionComponent *def = (HotVarDefinitionComponent*)Universe_AttachComponentToEntity( entity, COMPONENT_HOT_VAR_DEFINITION, system->universe );
@@ -694,11 +814,11 @@ strcpy( system->line_buffer, ROOT_DIRECTORY_NAME );
 ParseDirectory( system );
 
 /* parse the file */
-int file_sz = 0;
-char *file_buffer = Utilities_ReadWholeTextFile( system->file_path, &file_sz );
+FileView file = {};
+FileView_Open( system->file_path, &file );
 
 int caret = 0;
-while( Utilities_ReadLineFromBuffer( &caret, file_buffer, file_sz, system->line_buffer, LINE_BUFFER_LENGTH ) )
+while( Utilities_ReadLineFromBuffer( &caret, file.data, (int)file.size, system->line_buffer, LINE_BUFFER_LENGTH ) )
     {
     if( !strlen( system->line_buffer )
      || system->line_buffer[ 0 ] == '#' )
@@ -717,8 +837,7 @@ while( Utilities_ReadLineFromBuffer( &caret, file_buffer, file_sz, system->line_
         }
     }
 
-free( file_buffer );
-file_buffer = nullptr;
+FileView_Close( &file );
 
 /* update the bindings */
 NonOwningGroup_CreateIterator( system->universe, &system->group, NonOwningGroup_GroupIds( COMPONENT_HOT_VAR_BINDING, COMPONENT_HOT_VAR_DEFINITION ) );
@@ -751,8 +870,7 @@ static void SaveBoundValuesToFile( HotVarsState *system )
     fwrite( "\n", 1, 1, _fhnd )
 
 /* set the root directory as current */
-u32 keycode = Utilities_HashString( &ROOT_DIRECTORY_NAME[ 1 ], strlen( &ROOT_DIRECTORY_NAME[1] ) );
-EntityId *pdir = (EntityId*)HashMap_At( keycode, &system->names.map );
+EntityId *pdir = FindName( &ROOT_DIRECTORY_NAME[ 1 ], (uint32_t)strlen( &ROOT_DIRECTORY_NAME[ 1 ] ), system );
 if( !pdir )
     {
     /* we've not loaded for some reason - critical error */
@@ -764,10 +882,9 @@ system->current_parse_directory = *pdir;
 HotVarDefinitionComponent *current_parse_directory = (HotVarDefinitionComponent*)Universe_TryGetComponent( system->current_parse_directory, COMPONENT_HOT_VAR_DEFINITION, system->universe );
 int current_parse_directory_len = (int)strlen( current_parse_directory->name );
 
-/* read the file to buffer */
-int file_sz = 0;
-char *file_buffer = Utilities_ReadWholeTextFile( system->file_path, &file_sz );
-if( !file_buffer )
+/* open the file - it must be closed before it's replaced */
+FileView file = {};
+if( !FileView_Open( system->file_path, &file ) )
     {
     debug_assert_always();
     return;
@@ -788,13 +905,13 @@ FILE *fhnd = fopen( system->temp_file_path, "w" );
 if( !fhnd )
     {
     debug_assert_always();
-    free( file_buffer );
+    FileView_Close( &file );
     return;
     }
 
 /* parse the hot var file and write it to temp w/ new values */
 int file_caret = 0;
-while( Utilities_ReadLineFromBuffer( &file_caret, file_buffer, file_sz, system->line_buffer, LINE_BUFFER_LENGTH ) )
+while( Utilities_ReadLineFromBuffer( &file_caret, file.data, (int)file.size, system->line_buffer, LINE_BUFFER_LENGTH ) )
     {
     if( !strlen( system->line_buffer ) )
         {
@@ -831,13 +948,12 @@ while( Utilities_ReadLineFromBuffer( &file_caret, file_buffer, file_sz, system->
                     {
                     /* find the directory and set it current */
                     name_parsed = true;
-                    u32 dir_keycode = Utilities_HashString( &system->line_buffer[ 1 ], name_length );
-                    EntityId *pentity = (EntityId*)HashMap_At( dir_keycode, &system->names.map );
+                    EntityId *pentity = FindName( &system->line_buffer[ 1 ], (uint32_t)name_length, system );
                     if( !pentity )
                         {
                         /* crtical error! */
                         debug_assert_always();
-                        free( file_buffer );
+                        FileView_Close( &file );
                         fclose( fhnd );
                         return;
                         }
@@ -848,7 +964,7 @@ while( Utilities_ReadLineFromBuffer( &file_caret, file_buffer, file_sz, system->
                         {
                         /* crtical error! */
                         debug_assert_always();
-                        free( file_buffer );
+                        FileView_Close( &file );
                         fclose( fhnd );
                         return;
                         }
@@ -866,7 +982,7 @@ while( Utilities_ReadLineFromBuffer( &file_caret, file_buffer, file_sz, system->
         if( !Utilities_StrContainsStr( system->line_buffer, false, " " ) )
             {
             debug_assert_always();
-            free( file_buffer );
+            FileView_Close( &file );
             fclose( fhnd );
             return;
             }
@@ -891,7 +1007,8 @@ while( Utilities_ReadLineFromBuffer( &file_caret, file_buffer, file_sz, system->
                     /* find the definition by its name and write the current value to file */
                     name_parsed = true;
                     u32 malloc_len = current_parse_directory_len + 1/* slash */ + name_length + 1/* null */;
-                    char *full_name = (char*)malloc( malloc_len );
+                    FrameAllocatorMarker scope = FrameAllocator_BeginScope();
+                    char *full_name = FrameAllocator_AllocateArray( char, malloc_len );
                     if( current_parse_directory_len > 1 )
                         {
                         sprintf( full_name, "%s/%s", current_parse_directory->name, system->line_buffer );
@@ -901,14 +1018,13 @@ while( Utilities_ReadLineFromBuffer( &file_caret, file_buffer, file_sz, system->
                         sprintf( full_name, "%s%s", current_parse_directory->name, system->line_buffer );
                         }
 
-                    u32 name_keycode = Utilities_HashString( full_name, strlen( full_name ) );
-                    free( full_name );
-                    EntityId *pentity = (EntityId*)HashMap_At( name_keycode, &system->names.map );
+                    EntityId *pentity = FindName( full_name, (uint32_t)strlen( full_name ), system );
+                    FrameAllocator_EndScope( scope );
                     if( !pentity )
                         {
                         /* crtical error! */
                         debug_assert_always();
-                        free( file_buffer );
+                        FileView_Close( &file );
                         fclose( fhnd );
                         return;
                         }
@@ -918,7 +1034,7 @@ while( Utilities_ReadLineFromBuffer( &file_caret, file_buffer, file_sz, system->
                         {
                         /* crtical error! */
                         debug_assert_always();
-                        free( file_buffer );
+                        FileView_Close( &file );
                         fclose( fhnd );
                         return;
                         }
@@ -945,7 +1061,7 @@ while( Utilities_ReadLineFromBuffer( &file_caret, file_buffer, file_sz, system->
                         {
                         /* crtical error! */
                         debug_assert_always();
-                        free( file_buffer );
+                        FileView_Close( &file );
                         fclose( fhnd );
                         return;
                         }
@@ -972,7 +1088,8 @@ while( Utilities_ReadLineFromBuffer( &file_caret, file_buffer, file_sz, system->
         }
     }
 
-/* close the temp file, and rename it to overwrite the existing file */
+/* close the files, and rename the temp file to overwrite the existing one */
+FileView_Close( &file );
 fclose( fhnd );
 fhnd = nullptr;
 do_debug_assert( !remove( system->file_path ) );
@@ -1004,8 +1121,7 @@ if( !pdirectory )
     return;
     }
 
-u32 keycode = Utilities_HashString( request->name, strlen( request->name ) );
-EntityId *pentity = (EntityId*)HashMap_At( keycode, &system->names.map );
+EntityId *pentity = FindName( request->name, (uint32_t)strlen( request->name ), system );
 if( !pentity )
     {
     /* no binding existed */
@@ -199,6 +199,8 @@ typedef struct
     VKN_logical_device_type
                         logical;
     VKN_memory_type     memory;
+    VKN_memory_defrag_type
+                        defrag;
     VKN_staging_type    staging;
     VKN_arena_type      permanent_arena;
     VKN_arena_word_type arena_memory[ PERMANENT_ARENA_SZ / sizeof( VKN_arena_word_type ) ];
@@ -636,6 +638,7 @@ for( int i = 0; i < cnt_of_array( engine->frames ); i++ )
 
 VKN_release_command_pool( engine->logical.logical, NULL, &engine->command_pool );
 DestroySwapChain( engine );
+VKN_memory_defrag_destroy( NULL, &engine->defrag );
 VKN_staging_destroy( NULL, &engine->staging );
 VKN_memory_destroy( NULL, &engine->memory );
 
@@ -774,6 +777,7 @@ VKN_features_type *features = VKN_arena_allocate_struct( VKN_features_type, scra
 VKN_return_bfail( features );
 
 clr_struct( features );
+features->v1_2.timelineSemaphore = VK_TRUE;
 features->v1_3.dynamicRendering = VK_TRUE;
 features->extended_dynamic_state.extendedDynamicState = VK_TRUE;
 
@@ -781,6 +785,7 @@ VKN_physical_device_init_builder( instance, surface, VKN_MIN_VERSION, physical_b
     set_required_device_class( VKN_PHYSICAL_DEVICE_BUILD_DEVICE_CLASS_HARDWARE, physical_build )->
     add_extension( VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME, physical_build )->
     add_extension( VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME, physical_build )->
+    add_optional_extension( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, physical_build )->
     set_required_features( features, physical_build );
 
 VKN_return_bfail( VKN_physical_device_create( physical_build, &engine->physical ) );
@@ -799,7 +804,8 @@ VKN_logical_device_init_builder( engine->physical.physical_device,
                                  engine->physical.queue_families.queue_families,
                                  engine->physical.queue_families.count,
                                  logical_build )->
-    require_graphics_queue( FALSE, FALSE, logical_build );
+    require_graphics_queue( FALSE, FALSE, logical_build )->
+    require_transfer_queue( FALSE, TRUE, logical_build );
 
 VKN_return_bfail( VKN_logical_device_create( logical_build, &engine->logical ) );
 logical_build = nullptr;
@@ -908,22 +914,41 @@ VKN_return_bfail( memory_build );
 VKN_memory_init_builder( instance,
                          engine->logical.physical,
                          engine->logical.logical,
-                         memory_build );
+                         memory_build )->
+    set_device_extensions( engine->physical.extensions.names,
+                           engine->physical.extensions.count,
+                           memory_build );
 
 VKN_return_bfail( VKN_memory_create( memory_build, &engine->memory ) );
 
 memory_build = nullptr;
 VKN_arena_rewind( scratch );
 
+/* defragmenter - copies on the graphics queue, which orders them after the uploads and before any use of the moved resources */
+VKN_memory_defrag_build_type *defrag_build = VKN_arena_allocate_struct( VKN_memory_defrag_build_type, scratch );
+VKN_return_bfail( defrag_build );
+
+VKN_memory_defrag_init_builder( engine->logical.logical,
+                                engine->logical.graphics.queue,
+                                engine->logical.graphics.family,
+                                &engine->memory,
+                                defrag_build );
+
+VKN_return_bfail( VKN_memory_defrag_create( defrag_build, &engine->defrag ) );
+
+defrag_build = nullptr;
+VKN_arena_rewind( scratch );
+
 /* staging */
 VKN_staging_build_type *staging_build = VKN_arena_allocate_struct( VKN_staging_build_type, scratch );
 VKN_return_bfail( staging_build );
 
 VKN_staging_init_builder( engine->logical.logical,
-                          engine->logical.graphics.queue,
-                          engine->logical.graphics.family,
+                          engine->logical.transfer.queue,
+                          engine->logical.transfer.family,
                           &engine->memory,
-                          staging_build );
+                          staging_build )->
+    set_acquire_family( engine->logical.graphics.family, staging_build );
 
 VKN_staging_create( staging_build, &engine->staging );
 
@@ -945,7 +970,10 @@ VKN_buffer_index_init_builder( engine->logical.logical,
 VKN_buffer_vertex_init_builder( engine->logical.logical,
                                 &engine->physical.props,
                                 &engine->memory,
-                                &engine->builders.vertex_buffer );
+                                &engine->builders.vertex_buffer )->
+    add_sharing_family( engine->logical.graphics.family, &engine->builders.vertex_buffer )->
+    add_sharing_family( engine->logical.transfer.family, &engine->builders.vertex_buffer )->
+    set_relocatable( true, &engine->builders.vertex_buffer );
 
 VKN_buffer_uniform_init_builder( engine->logical.logical,
                                  &engine->physical.props,
@@ -1188,6 +1216,7 @@ VKN_goto_fail( vkResetCommandBuffer( frame->end_prepend_commands, 0 ), begin_fra
 VKN_arena_rewind( &frame->arena );
 frame->releaser.i->flush( &frame->releaser );
 engine->memory.i->begin_frame( &engine->memory );
+engine->defrag.i->begin_frame( &frame->releaser, &engine->defrag );
 engine->transitioner.obj.i->begin_frame( &engine->transitioner.obj );
 //while( canvas->current_frame->image_frees )
 //    {
@@ -1632,12 +1661,12 @@ begin_frame_fail:
 //clr_array( draw_order );
 //while( NonOwningGroup_GetNext( &engine->group, NULL, (void**)&seen_scene ) )
 //    {
-//    debug_assert( HashMap_At( seen_scene->scene_name_hash, map ) == NULL );
+//    debug_assert( HashMap_At( seen_scene->scene_name_id, map ) == NULL );
 //    
 //    Scene::Scene *render_scene = (Scene::Scene*)seen_scene->render_state;
 //    Scene::Scene_BeginFrame( seen_scene->viewport_extent, render_scene );
 //
-//    hard_assert( HashMap_Insert( seen_scene->scene_name_hash, &seen_scene, map ) != NULL );
+//    hard_assert( HashMap_Insert( seen_scene->scene_name_id, &seen_scene, map ) != NULL );
 //    draw_order[ map->size - 1 ] = seen_scene;
 //    }
 //
@@ -1656,7 +1685,7 @@ begin_frame_fail:
 //    Float4x4 mtx_world;
 //    Math_Float4x4TransformSpin( transform->position, transform->rotation, transform->scale, &mtx_world );
 //
-//    SceneComponent *home_scene = *(SceneComponent**)HashMap_At( model->scene_name_hash, map ); // TODO <MPA> - Do we want an entity to be able to belong to more than one scene?
+//    SceneComponent *home_scene = *(SceneComponent**)HashMap_At( model->scene_name_id, map ); // TODO <MPA> - Do we want an entity to be able to belong to more than one scene?
 //    Scene::Scene_RegisterObject( model->asset_name.str, model, &mtx_world, (Scene::Scene*)home_scene->render_state );
 //    }
 //
@@ -1805,6 +1834,8 @@ VkCommandBuffer *submits = nullptr;
 Frame *frame = nullptr;
 VkImageMemoryBarrier barrier = {};
 VkSubmitInfo submit = {};
+VkTimelineSemaphoreSubmitInfo submit_timeline = {};
+VKN_staging_wait_type staging_wait = {};
 VkPresentInfoKHR present = {};
 
 /* +submit */
@@ -1814,7 +1845,7 @@ VkPresentInfoKHR present = {};
 LockMutex( &engine->access.n.memory );
 
 frame = engine->current_frame;
-engine->staging.i->flush( &engine->staging );
+VKN_goto_bfail( engine->staging.i->flush( &engine->staging ), end_frame_fail );
 
 /* build array of command buffers to submit */
 //for( context = canvas->current_frame->context_frees; context; context = context->next, submit_cnt++ );
@@ -1825,6 +1856,9 @@ submit_cnt = 0;
 submits[ submit_cnt++ ] = frame->end_prepend_commands;
 VKN_goto_fail( vkBeginCommandBuffer( frame->end_prepend_commands, &begin_info ), end_frame_fail );
 
+/* take ownership of the uploads flushed above */
+engine->staging.i->acquire( frame->end_prepend_commands, &staging_wait, &engine->staging );
+
 //for( context = canvas->current_frame->context_frees; context; context = context->next )
 //    {
 //    if( context == canvas->current_frame->context_frees )
@@ -1882,6 +1916,18 @@ submit.pCommandBuffers      = submits;
 submit.signalSemaphoreCount = 1;
 submit.pSignalSemaphores    = &frame->render;
 
+if( staging_wait.value )
+    {
+    submit_timeline.sType                   = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    submit_timeline.waitSemaphoreValueCount = 1;
+    submit_timeline.pWaitSemaphoreValues    = &staging_wait.value;
+
+    submit.pNext              = &submit_timeline;
+    submit.waitSemaphoreCount = 1;
+    submit.pWaitSemaphores    = &staging_wait.semaphore;
+    submit.pWaitDstStageMask  = &staging_wait.stages;
+    }
+
 VKN_goto_fail( vkQueueSubmit( engine->logical.graphics.queue, 1, &submit, frame->fence ), end_frame_fail );
 
 present.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
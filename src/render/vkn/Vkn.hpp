@@ -12,6 +12,7 @@
 #include "VknImage.hpp"
 #include "VknInstance.hpp"
 #include "VknMemory.hpp"
+#include "VknMemoryDefrag.hpp"
 #include "VknLogicalDevice.hpp"
 #include "VknPhysicalDevice.hpp"
 #include "VknPipelineGraphics.hpp"
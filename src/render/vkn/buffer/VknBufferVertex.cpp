@@ -17,10 +17,19 @@ static void add_sharing_family_safe
                        *builder     /* vertex buffer builder        */
     );
 
+static bool create_object
+    (
+    const VKN_buffer_vertex_type
+                       *buffer,     /* vertex buffer                */
+    VkBuffer           *object      /* output new buffer object     */
+    );
+
 static VKN_buffer_vertex_get_proc_type get;
 static VKN_buffer_vertex_map_proc_type map;
+static VKN_memory_relocate_proc_type relocate;
 static VKN_buffer_vertex_build_reset_proc_type reset;
 static VKN_buffer_vertex_build_set_allocation_callbacks_proc_type set_allocation_callbacks;
+static VKN_buffer_vertex_build_set_relocatable_proc_type set_relocatable;
 static VKN_buffer_vertex_unmap_proc_type unmap;
 
 
@@ -30,7 +39,8 @@ static VKN_buffer_vertex_unmap_proc_type unmap;
 *       VKN_buffer_vertex_create
 *
 *   DESCRIPTION:
-*       Create a vertex buffer.
+*       Create a vertex buffer.  A relocatable buffer must stay at
+*       the same address until destroyed.
 *
 *********************************************************************/
 
@@ -53,11 +63,6 @@ static const VKN_buffer_vertex_api_type API =
     unmap
     };
 
-/*----------------------------------------------------------
-Local variables
-----------------------------------------------------------*/
-VkBufferCreateInfo      ci_buffer;  /* buffer create info           */
-
 clr_struct( buffer );
 buffer->i = &API;
 
@@ -66,21 +71,12 @@ buffer->state.allocator        = builder->state.allocator;;
 buffer->state.upload_alignment = builder->state.upload_alignment;
 buffer->state.memory           = builder->state.memory;
 buffer->state.size             = size;
+buffer->state.families         = builder->state.families;
 
 /*----------------------------------------------------------
 Create the buffer
 ----------------------------------------------------------*/
-clr_struct( &ci_buffer );
-ci_buffer.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-ci_buffer.flags                 = 0;
-ci_buffer.size                  = size;
-ci_buffer.usage                 = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
-                                | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-ci_buffer.sharingMode           = ( builder->state.families.count > 1 ) ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-ci_buffer.queueFamilyIndexCount = builder->state.families.count;
-ci_buffer.pQueueFamilyIndices   = (uint32_t*)&builder->state.families.indices;
-
-if( VKN_failed( vkCreateBuffer( buffer->state.logical, &ci_buffer, buffer->state.allocator, &buffer->state.object ) )
+if( !create_object( buffer, &buffer->state.object )
  || !buffer->state.memory->i->create_buffer_memory( buffer->state.object, VKN_MEMORY_HEAP_USAGE_DEFAULT, buffer->state.memory, &buffer->state.allocation ) )
     {
     debug_assert_always();
@@ -88,6 +84,11 @@ if( VKN_failed( vkCreateBuffer( buffer->state.logical, &ci_buffer, buffer->state
     return( FALSE );
     }
 
+if( builder->state.is_relocatable )
+    {
+    buffer->state.memory->i->set_relocatable( relocate, buffer, buffer->state.memory, &buffer->state.allocation );
+    }
+
 return( TRUE );
 
 }   /* VKN_buffer_vertex_create() */
@@ -112,6 +113,11 @@ void VKN_buffer_vertex_destroy
 {
 VKN_releaser_auto_mini_begin( releaser, use );
 use->i->release_buffer( buffer->state.logical, buffer->state.allocator, buffer->state.object, use );
+if( buffer->state.moving )
+    {
+    use->i->release_buffer( buffer->state.logical, buffer->state.allocator, buffer->state.moving, use );
+    }
+
 if( buffer->state.memory )
     {
     buffer->state.memory->i->deallocate( buffer->state.memory, &buffer->state.allocation );
@@ -151,7 +157,8 @@ static const VKN_buffer_vertex_build_config_type CONFIG =
     {
     add_sharing_family,
     reset,
-    set_allocation_callbacks
+    set_allocation_callbacks,
+    set_relocatable
     };
 
 /*----------------------------------------------------------
@@ -245,6 +252,41 @@ builder->state.families.indices[ builder->state.families.count++ ] = index;
 }   /* add_sharing_family_safe() */
 
 
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       create_object
+*
+*********************************************************************/
+
+static bool create_object
+    (
+    const VKN_buffer_vertex_type
+                       *buffer,     /* vertex buffer                */
+    VkBuffer           *object      /* output new buffer object     */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VkBufferCreateInfo      ci_buffer;  /* buffer create info           */
+
+clr_struct( &ci_buffer );
+ci_buffer.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+ci_buffer.flags                 = 0;
+ci_buffer.size                  = buffer->state.size;
+ci_buffer.usage                 = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+                                | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                                | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+ci_buffer.sharingMode           = ( buffer->state.families.count > 1 ) ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+ci_buffer.queueFamilyIndexCount = buffer->state.families.count;
+ci_buffer.pQueueFamilyIndices   = (uint32_t*)&buffer->state.families.indices;
+
+return( !VKN_failed( vkCreateBuffer( buffer->state.logical, &ci_buffer, buffer->state.allocator, object ) ) );
+
+}   /* create_object() */
+
+
 /*********************************************************************
 *
 *   PROCEDURE NAME:
@@ -268,6 +310,11 @@ return( buffer->state.object );
 *   PROCEDURE NAME:
 *       map
 *
+*   DESCRIPTION:
+*       Map the buffer for an upload.  Returns NULL while the
+*       defragmenter is moving it, as the move would lose the
+*       upload; try again next frame.
+*
 *********************************************************************/
 
 static void * map
@@ -282,6 +329,11 @@ if( buffer->state.is_mapped )
     return( buffer->state.upload.mapping );
     }
 
+if( buffer->state.moving )
+    {
+    return( NULL );
+    }
+
 buffer->state.upload    = staging->i->upload( buffer->state.size, buffer->state.upload_alignment, staging );
 buffer->state.is_mapped = TRUE;
     
@@ -290,6 +342,88 @@ return( buffer->state.upload.mapping );
 }   /* map() */
 
 
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       relocate
+*
+*   DESCRIPTION:
+*       Move the buffer for the defragmenter: create a twin at the
+*       new memory and copy to it, then swap to it once the copy
+*       is done.  A buffer mapped for an upload stays put.
+*
+*********************************************************************/
+
+static bool relocate
+    (
+    const VKN_memory_relocate_stage_type
+                        stage,      /* step of the move             */
+    const VKN_memory_allocation_type
+                       *moved_to,   /* memory being moved to        */
+    const VkCommandBuffer
+                        commands,   /* copy commands, on BEGIN      */
+    VKN_releaser_type  *releaser,   /* releases replaced resources  */
+    void               *user        /* vertex buffer being moved    */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_buffer_vertex_type *buffer;     /* vertex buffer being moved    */
+VkBufferCopy            copy;       /* copy details                 */
+VkBuffer                released;   /* buffer no longer needed      */
+
+buffer = (VKN_buffer_vertex_type *)user;
+switch( stage )
+    {
+    case VKN_MEMORY_RELOCATE_BEGIN:
+        if( buffer->state.is_mapped
+         || !create_object( buffer, &buffer->state.moving ) )
+            {
+            return( FALSE );
+            }
+
+        if( VKN_failed( vkBindBufferMemory( buffer->state.logical, buffer->state.moving, moved_to->memory, moved_to->offset ) ) )
+            {
+            vkDestroyBuffer( buffer->state.logical, buffer->state.moving, buffer->state.allocator );
+            buffer->state.moving = VK_NULL_HANDLE;
+            return( FALSE );
+            }
+
+        clr_struct( &copy );
+        copy.size = buffer->state.size;
+
+        vkCmdCopyBuffer( commands, buffer->state.object, buffer->state.moving, 1, &copy );
+        return( TRUE );
+
+    case VKN_MEMORY_RELOCATE_COMMIT:
+        released = buffer->state.object;
+        buffer->state.object = buffer->state.moving;
+        break;
+
+    case VKN_MEMORY_RELOCATE_CANCEL:
+        released = buffer->state.moving;
+        break;
+
+    default:
+        debug_assert_always();
+        return( FALSE );
+    }
+
+/*----------------------------------------------------------
+Release the old buffer once this frame is done with it
+----------------------------------------------------------*/
+buffer->state.moving = VK_NULL_HANDLE;
+
+VKN_releaser_auto_mini_begin( releaser, use );
+use->i->release_buffer( buffer->state.logical, buffer->state.allocator, released, use );
+VKN_releaser_auto_mini_end( use );
+
+return( TRUE );
+
+}   /* relocate() */
+
+
 /*********************************************************************
 *
 *   PROCEDURE NAME:
@@ -332,6 +466,32 @@ return( builder->config );
 }   /* set_allocation_callbacks() */
 
 
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       set_relocatable
+*
+*   DESCRIPTION:
+*       Let the memory defragmenter move the buffers.  They must
+*       be shared with the defragmenter's queue family.
+*
+*********************************************************************/
+
+static VKN_BUFFER_VERTEX_CONFIG_API set_relocatable
+    (
+    const bool          is_relocatable,
+                                    /* may the defragmenter move it?*/
+    struct _VKN_buffer_vertex_build_type
+                       *builder     /* vertex buffer builder        */
+    )
+{
+builder->state.is_relocatable = is_relocatable;
+
+return( builder->config );
+
+}   /* set_relocatable() */
+
+
 /*********************************************************************
 *
 *   PROCEDURE NAME:
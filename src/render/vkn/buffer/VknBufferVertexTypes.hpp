@@ -34,6 +34,14 @@ typedef VKN_BUFFER_VERTEX_CONFIG_API VKN_buffer_vertex_build_set_allocation_call
                        *builder     /* vertex buffer builder        */
     );
 
+typedef VKN_BUFFER_VERTEX_CONFIG_API VKN_buffer_vertex_build_set_relocatable_proc_type
+    (
+    const bool          is_relocatable,
+                                    /* may the defragmenter move it?*/
+    struct _VKN_buffer_vertex_build_type
+                       *builder     /* vertex buffer builder        */
+    );
+
 typedef struct _VKN_buffer_vertex_build_config_type
     {
     VKN_buffer_vertex_build_add_sharing_family_proc_type
@@ -42,6 +50,8 @@ typedef struct _VKN_buffer_vertex_build_config_type
                        *reset;
     VKN_buffer_vertex_build_set_allocation_callbacks_proc_type
                        *set_allocation_callbacks;
+    VKN_buffer_vertex_build_set_relocatable_proc_type
+                       *set_relocatable;
 
     } VKN_buffer_vertex_build_config_type;
 
@@ -54,6 +64,8 @@ typedef struct
 
 typedef struct
     {
+    bool                is_relocatable : 1;
+                                    /* may the defragmenter move it?*/
     u8                  upload_alignment;
                                     /* required alignment for upload*/
     VKN_memory_type    *memory;     /* memory allocator             */
@@ -107,6 +119,7 @@ typedef struct
     u8                  upload_alignment;
     u32                 size;
     VkBuffer            object;
+    VkBuffer            moving;     /* buffer being moved to        */
     VkDevice            logical;
     const VkAllocationCallbacks
                        *allocator;
@@ -115,6 +128,8 @@ typedef struct
                         allocation;
     VKN_staging_upload_instruct_type
                         upload;
+    VKN_buffer_vertex_build_family_indices_type
+                        families;   /* queue families               */
     } VKN_buffer_vertex_state_type;
 
 typedef struct _VKN_buffer_vertex_type
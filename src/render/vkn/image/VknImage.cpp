@@ -22,6 +22,13 @@ static const VkFormat SUPPORTED_FORMATS[] =
     };
 compiler_assert( cnt_of_array( SUPPORTED_FORMATS ) == VKN_IMAGE_MAX_TEXTURE_FORMAT_CNT, VKN_IMAGE_C );
 
+typedef struct
+    {
+    u32                 width;      /* data buffer width            */
+    u32                 row_size;   /* size of a data buffer row    */
+    VKN_image_type     *image;      /* image being loaded           */
+    } load_piece_type;
+
 
 /*********************************************************************
 *
@@ -352,6 +359,7 @@ static VkImageViewType get_type_of_image_view
     );
 
 static VKN_image_load_proc_type load;
+static VKN_staging_record_proc_type record_load_piece;
 static VKN_image_build_reset_proc_type reset;
 static VKN_image_build_set_addressing_proc_type set_addressing;
 static VKN_image_build_set_allocation_callbacks_proc_type set_allocation_callbacks;
@@ -1179,7 +1187,7 @@ return( ret );
 *
 *********************************************************************/
 
-static void load
+static VKN_staging_ticket_type load
     (
     const void         *data,       /* raw linear image data        */
     const u32           offset_x,   /* x offset in data buffer      */
@@ -1194,86 +1202,22 @@ static void load
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VkBufferImageCopy       copy;       /* copy definition              */
-VkExtent2D              copy_extent;/* mip copy extent              */
-u32                     i;          /* loop counter                 */
-VKN_staging_upload_instruct_type
-                        instruct;   /* upload instructions          */
-u32                     size;       /* copy size                    */
+load_piece_type         piece;      /* how to copy each piece       */
 VkImageMemoryBarrier    to_read;    /* transition to shader read    */
-VkImageMemoryBarrier    to_transfer;/* transition to transfer target*/
 
 debug_assert( offset_x + width  >= image->extent.width );
 debug_assert( offset_y + height >= image->extent.height );
 
 /*----------------------------------------------------------
-Upload the image to staging
+Upload the image to staging, in whole rows so pieces can be
+copied as they are staged.  Offsets are kept a multiple of
+four, as transfer-only queues require.
 ----------------------------------------------------------*/
-size = width * height * get_format_bit_count( image->format ) / 8;
-instruct = staging->i->upload( size, image->upload_alignment, staging );
-memcpy( instruct.mapping, data, size );
-
-/*----------------------------------------------------------
-Transition image to transfer target
-----------------------------------------------------------*/
-clr_struct( &to_transfer );
-to_transfer.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-to_transfer.srcAccessMask                   = VK_ACCESS_SHADER_READ_BIT;
-to_transfer.dstAccessMask                   = VK_ACCESS_TRANSFER_WRITE_BIT;
-to_transfer.oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
-to_transfer.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-to_transfer.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-to_transfer.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-to_transfer.image                           = image->image;
-to_transfer.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-to_transfer.subresourceRange.baseMipLevel   = 0;
-to_transfer.subresourceRange.levelCount     = image->mip_levels;
-to_transfer.subresourceRange.baseArrayLayer = 0;
-to_transfer.subresourceRange.layerCount     = 1;
-
-vkCmdPipelineBarrier( instruct.commands,
-                      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                      VK_PIPELINE_STAGE_TRANSFER_BIT,
-                      0, /* flags */
-                      0,
-                      NULL,
-                      0,
-                      NULL,
-                      1,
-                      &to_transfer );
-
-/*----------------------------------------------------------
-Copy image from staging to image memory
-----------------------------------------------------------*/
-copy_extent.width  = image->extent.width;
-copy_extent.height = image->extent.height;
-
-for( i = 0; i < image->mip_levels; i++ )
-    {
-    clr_struct( &copy );
-    copy.bufferOffset                    = instruct.offset;
-    copy.bufferRowLength                 = width;
-    copy.bufferImageHeight               = height;
-    copy.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-    copy.imageSubresource.mipLevel       = i;
-    copy.imageSubresource.baseArrayLayer = 0;
-    copy.imageSubresource.layerCount     = 1;
-    copy.imageOffset.x                   = 0;
-    copy.imageOffset.y                   = 0;
-    copy.imageExtent.width               = copy_extent.width;
-    copy.imageExtent.height              = copy_extent.height;
-    copy.imageExtent.depth               = 1;
-
-    vkCmdCopyBufferToImage( instruct.commands,
-                            instruct.buffer,
-                            image->image,
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                            1,
-                            &copy );
+piece.width    = width;
+piece.row_size = width * get_format_bit_count( image->format ) / 8;
+piece.image    = image;
 
-    copy_extent.width  >>= 1;
-    copy_extent.height >>= 1;
-    }
+staging->i->upload_split( data, piece.row_size * height, piece.row_size, (u32)VKN_size_max( image->upload_alignment, 4 ), record_load_piece, &piece, staging );
 
 /*----------------------------------------------------------
 Transition image to shader read resource
@@ -1293,20 +1237,120 @@ to_read.subresourceRange.levelCount     = image->mip_levels;
 to_read.subresourceRange.baseArrayLayer = 0;
 to_read.subresourceRange.layerCount     = 1;
 
-vkCmdPipelineBarrier( instruct.commands,
-                      VK_PIPELINE_STAGE_TRANSFER_BIT,
-                      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                      0, /* flags */
-                      0,
-                      NULL,
-                      0,
-                      NULL,
-                      1,
-                      &to_read );
+return( staging->i->release_image( &to_read, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, staging ) );
 
 }   /* load() */
 
 
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       record_load_piece
+*
+*   DESCRIPTION:
+*       Record the copy of a staged band of rows into each mip
+*       level, transitioning the image before the first band.
+*
+*********************************************************************/
+
+static void record_load_piece
+    (
+    const VKN_staging_upload_instruct_type
+                       *instruct,   /* where the piece was staged   */
+    const u32           data_offset,/* piece's offset in the data   */
+    const u32           size,       /* size of the piece            */
+    void               *user        /* caller's data                */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VkBufferImageCopy       copy;       /* copy definition              */
+VkExtent2D              copy_extent;/* mip copy extent              */
+u32                     first_row;  /* first row in the piece       */
+u32                     i;          /* loop counter                 */
+u32                     last_row;   /* row after the piece          */
+load_piece_type        *piece;      /* how to copy the piece        */
+VkImageMemoryBarrier    to_transfer;/* transition to transfer target*/
+
+piece     = (load_piece_type*)user;
+first_row = data_offset / piece->row_size;
+last_row  = first_row + size / piece->row_size;
+
+/*----------------------------------------------------------
+Transition image to transfer target.  The old contents are
+discarded, so nothing earlier need finish first.
+----------------------------------------------------------*/
+if( data_offset == 0 )
+    {
+    clr_struct( &to_transfer );
+    to_transfer.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    to_transfer.srcAccessMask                   = 0;
+    to_transfer.dstAccessMask                   = VK_ACCESS_TRANSFER_WRITE_BIT;
+    to_transfer.oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
+    to_transfer.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    to_transfer.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.image                           = piece->image->image;
+    to_transfer.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    to_transfer.subresourceRange.baseMipLevel   = 0;
+    to_transfer.subresourceRange.levelCount     = piece->image->mip_levels;
+    to_transfer.subresourceRange.baseArrayLayer = 0;
+    to_transfer.subresourceRange.layerCount     = 1;
+
+    vkCmdPipelineBarrier( instruct->commands,
+                          VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          0, /* flags */
+                          0,
+                          NULL,
+                          0,
+                          NULL,
+                          1,
+                          &to_transfer );
+    }
+
+/*----------------------------------------------------------
+Copy the piece's rows from staging to each mip level which
+reaches them
+----------------------------------------------------------*/
+copy_extent.width  = piece->image->extent.width;
+copy_extent.height = piece->image->extent.height;
+
+for( i = 0; i < piece->image->mip_levels; i++ )
+    {
+    if( copy_extent.width
+     && copy_extent.height > first_row )
+        {
+        clr_struct( &copy );
+        copy.bufferOffset                    = instruct->offset;
+        copy.bufferRowLength                 = piece->width;
+        copy.bufferImageHeight               = last_row - first_row;
+        copy.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.imageSubresource.mipLevel       = i;
+        copy.imageSubresource.baseArrayLayer = 0;
+        copy.imageSubresource.layerCount     = 1;
+        copy.imageOffset.x                   = 0;
+        copy.imageOffset.y                   = (s32)first_row;
+        copy.imageExtent.width               = copy_extent.width;
+        copy.imageExtent.height              = min_of_vals( copy_extent.height, last_row ) - first_row;
+        copy.imageExtent.depth               = 1;
+
+        vkCmdCopyBufferToImage( instruct->commands,
+                                instruct->buffer,
+                                piece->image->image,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                1,
+                                &copy );
+        }
+
+    copy_extent.width  >>= 1;
+    copy_extent.height >>= 1;
+    }
+
+}   /* record_load_piece() */
+
+
 /*********************************************************************
 *
 *   PROCEDURE NAME:
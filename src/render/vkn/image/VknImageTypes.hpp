@@ -233,7 +233,7 @@ typedef struct _VKN_image_build_type
                         state;      /* builder state                */
     } VKN_image_build_type;
 
-typedef void VKN_image_load_proc_type
+typedef VKN_staging_ticket_type VKN_image_load_proc_type
     (
     const void         *data,       /* raw linear image data        */
     const u32           offset_x,   /* x offset in data buffer      */
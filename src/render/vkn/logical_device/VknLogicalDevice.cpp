@@ -582,11 +582,15 @@ const VkQueueFamilyProperties
 u32                     i;          /* loop counter                 */
 u32                     ret;        /* return family index          */
 
+/*----------------------------------------------------------
+Graphics and compute families can transfer even if they
+don't report it
+----------------------------------------------------------*/
 ret = VKN_INVALID_FAMILY_INDEX;
 for( i = 0; ret == VKN_INVALID_FAMILY_INDEX && i < builder->state.queue_families.count; i++ )
     {
     family = &builder->state.queue_families.queue_families[ i ];
-    if( test_bits( family->queueFlags, VK_QUEUE_TRANSFER_BIT ) )
+    if( test_any_bits( family->queueFlags, VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT ) )
         {
         ret = i;
         }
@@ -7,9 +7,12 @@
 #include "VknMemory.hpp"
 #include "VknMemoryTypes.hpp"
 #include "VknReleaser.hpp"
+#include "VknTlsf.hpp"
 
 
 #define VULKAN_BLOCK_SZ             ( 64 )
+#define BLOCKS_PER_SLAB             ( 256 )
+#define POOLS_PER_SLAB              ( 8 )
 
 
 /*********************************************************************
@@ -40,62 +43,21 @@ return( ret );
 }   /* count_bits() */
 
 
-/*********************************************************************
-*
-*   PROCEDURE NAME:
-*       find_block_by_id
-*
-*********************************************************************/
-
-static __inline VKN_memory_block_type * find_block_by_id
-    (
-    const u32           id,         /* block id                     */
-    VKN_memory_pool_type
-                       *pool        /* owning pool                  */
-    )
-{
-/*----------------------------------------------------------
-Local variables
-----------------------------------------------------------*/
-VKN_memory_block_type  *ret;        /* return block                 */
-
-for( ret = pool->head_blocks; ret && ret->block_id != id; ret = ret->next );
-
-return( ret );
-
-}   /* find_block_by_id() */
-
-
-/*********************************************************************
-*
-*   PROCEDURE NAME:
-*       find_pool_by_id
-*
-*********************************************************************/
-
-static __inline VKN_memory_pool_type * find_pool_by_id
-    (
-    const u32           id,         /* pool id                      */
-    VKN_memory_type    *allocator   /* owning allocator             */
-    )
-{
-/*----------------------------------------------------------
-Local variables
-----------------------------------------------------------*/
-VKN_memory_pool_type   *ret;        /* return pool                  */
-
-for( ret = allocator->state.head_pools; ret && ret->pool_id != id; ret = ret->next );
-
-return( ret );
-
-}   /* find_pool_by_id() */
-
-
 static VKN_memory_allocate_proc_type allocate;
 
-static VKN_memory_block_type * allocate_block
+static bool allocate_for_resource
     (
-    VKN_memory_type    *allocator   /* from which to allocate       */
+    const VkMemoryRequirements
+                       *required,   /* memory requirements          */
+    const VkMemoryDedicatedRequirements
+                       *dedicated,  /* dedicated allocation hints   */
+    const VkBuffer      buffer,     /* buffer to back, or null      */
+    const VkImage       image,      /* image to back, or null       */
+    const VKN_memory_heap_usage_type
+                        usage,      /* how memory is to be used     */
+    VKN_memory_type    *allocator,  /* memory allocator             */
+    VKN_memory_allocation_type
+                       *allocation  /* output new allocation        */
     );
 
 static bool allocate_from_pool
@@ -133,18 +95,22 @@ static VkDeviceSize calculate_min_alignment
                        *allocator   /* allocator                    */
     );
 
-static VkDeviceSize calculate_pool_min_block_size
+static VkDeviceSize calculate_pool_size_for_heap
     (
-    const VkDeviceSize  pool_size,  /* the size of the pool         */
-    VkDeviceSize        min_alignment,
-                                    /* minimum alignment for pool   */
-    const u32           max_allocations
-                                    /* maximum allocations allowed  */
+    const VkDeviceSize  heap_size   /* size of device heap          */
     );
 
-static VkDeviceSize calculate_pool_size_for_heap
+static bool choose_memory_type
     (
-    const VkDeviceSize  heap_size   /* size of device heap          */
+    const VKN_memory_heap_usage_type
+                        usage,      /* how memory is to be used     */
+    const VKN_memory_priority_type
+                        priority,   /* eviction class               */
+    const VkDeviceSize  size,       /* memory size needed           */
+    const u32           memory_bits,/* memory type indices as bits  */
+    const VKN_memory_type
+                       *allocator,  /* memory allocator             */
+    u32                *memory_index/* output memory type index     */
     );
 
 static VKN_memory_create_buffer_memory_proc_type create_buffer_memory;
@@ -154,7 +120,13 @@ static VKN_memory_pool_type * create_new_pool
     (
     const VKN_memory_heap_usage_type
                         usage,      /* how memory is to be used     */
+    const VKN_memory_priority_type
+                        priority,   /* eviction class               */
+    const VkDeviceSize  size,       /* memory size needed           */
     const u32           memory_bits,/* memory type indices as bits  */
+    const VkMemoryDedicatedAllocateInfo
+                       *dedicated,  /* resource to dedicate to, or  */
+                                    /* NULL for a shared pool       */
     struct _VKN_memory_type
                        *allocator   /* memory allocator             */
     );
@@ -171,23 +143,51 @@ static bool find_memory_type_for_usage
     u32                *memory_index/* output memory type index     */
     );
 
-static void free_block
+static void free_pool
     (
-    VKN_memory_block_type
-                       *to_free,    /* block to free                */
     VKN_memory_pool_type
-                       *pool,       /* owning pool                  */
+                       *to_free,    /* pool to free                 */
     VKN_memory_type    *allocator   /* from which to allocate       */
     );
 
-static void free_pool
+static VKN_memory_get_budget_report_proc_type get_budget_report;
+
+static u32 get_heap_memory_bits
+    (
+    const u32           heap_index, /* heap to get memory types of  */
+    const VKN_memory_type
+                       *allocator   /* memory allocator             */
+    );
+
+static VkDeviceSize get_heap_remaining
+    (
+    const u32           heap_index, /* heap to check                */
+    const VKN_memory_type
+                       *allocator   /* memory allocator             */
+    );
+
+static VkDeviceSize get_heap_usage
+    (
+    const u32           heap_index, /* heap to check                */
+    const VKN_memory_type
+                       *allocator   /* memory allocator             */
+    );
+
+static void refresh_budget
+    (
+    VKN_memory_type    *allocator   /* memory allocator             */
+    );
+
+static void release_pool
     (
     VKN_memory_pool_type
-                       *to_free,    /* pool to free                 */
-    VKN_memory_type    *allocator   /* from which to allocate       */
+                       *to_release, /* unlinked pool to release     */
+    VKN_memory_type    *allocator   /* owning allocator             */
     );
 
 static VKN_memory_build_set_allocation_callbacks_proc_type set_allocation_callbacks;
+static VKN_memory_build_set_device_extensions_proc_type set_device_extensions;
+static VKN_memory_set_relocatable_proc_type set_relocatable;
 
 
 /*********************************************************************
@@ -216,13 +216,17 @@ static const VKN_memory_api_type API =
     begin_frame,
     create_buffer_memory,
     create_image_memory,
-    deallocate
+    deallocate,
+    get_budget_report,
+    set_relocatable
     };
 
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
 u32                     i;          /* loop counter                 */
+u32                     memory_index;
+                                    /* memory type index            */
 
 /*----------------------------------------------------------
 Create the allocator
@@ -230,36 +234,46 @@ Create the allocator
 clr_struct( allocator );
 allocator->i = &API;
 
+allocator->state.physical     = builder->state.physical;
 allocator->state.logical      = builder->state.logical;
 allocator->state.next_pool_id = 1;
 allocator->state.is_discrete  = builder->state.props.deviceType != VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU;
+allocator->state.has_memory_budget     = builder->state.has_memory_budget;
 allocator->state.noncoherent_atom_size = builder->state.props.limits.nonCoherentAtomSize;
 
 vkGetPhysicalDeviceMemoryProperties( builder->state.physical, &allocator->state.memory_props );
-compiler_assert( cnt_of_array( allocator->state.heap_remaining )
+compiler_assert( cnt_of_array( allocator->state.heap_budget )
               == cnt_of_array( allocator->state.memory_props.memoryHeaps ), VKN_MEMORY_C );
 for( i = 0; i < allocator->state.memory_props.memoryHeapCount; i++ )
     {
-    allocator->state.heap_remaining[ i ] = allocator->state.memory_props.memoryHeaps[ i ].size;
     allocator->state.heap_pool_size[ i ] = calculate_pool_size_for_heap( allocator->state.memory_props.memoryHeaps[ i ].size );
     }
 
 /*----------------------------------------------------------
-Initialize pool list
+Note the heap each usage would have, for the budget report
 ----------------------------------------------------------*/
-allocator->state.free_pools = allocator->state.pools;
-for( i = 0; i < cnt_of_array( allocator->state.pools ) - 1; i++ )
+for( i = 0; i < cnt_of_array( allocator->state.usage_heap ); i++ )
     {
-    allocator->state.pools[ i ].next = &allocator->state.pools[ i + 1 ];
+    if( find_memory_type_for_usage( (VKN_memory_heap_usage_type)i, max_uint_value( u32 ), allocator, &memory_index ) )
+        {
+        allocator->state.usage_heap[ i ] = allocator->state.memory_props.memoryTypes[ memory_index ].heapIndex;
+        }
     }
 
+refresh_budget( allocator );
+
 /*----------------------------------------------------------
-Initialize blocks list
+Initialize pool and block storage
 ----------------------------------------------------------*/
-allocator->state.free_blocks = allocator->state.blocks;
-for( i = 0; i < cnt_of_array( allocator->state.blocks ) - 1; i++ )
+if( !SlabAllocator_InitForType( VKN_memory_pool_type, POOLS_PER_SLAB, SLAB_ALLOCATOR_FLAG_NONE, &allocator->state.pool_slab ) )
+    {
+    return( FALSE );
+    }
+
+if( !SlabAllocator_InitForType( VKN_tlsf_block_type, BLOCKS_PER_SLAB, SLAB_ALLOCATOR_FLAG_NONE, &allocator->state.block_slab ) )
     {
-    allocator->state.blocks[ i ].next = &allocator->state.blocks[ i + 1 ];
+    SlabAllocator_Destroy( &allocator->state.pool_slab );
+    return( FALSE );
     }
 
 return( TRUE );
@@ -287,9 +301,33 @@ void VKN_memory_destroy
 Local variables
 ----------------------------------------------------------*/
 VKN_memory_pool_type   *pool;       /* pool iterator                */
+u32                     i;          /* loop counter                 */
 
 VKN_releaser_auto_mini_begin( releaser, use );
 
+/*----------------------------------------------------------
+Retired and dedicated pools still hold their memory, so put
+them back with the rest
+----------------------------------------------------------*/
+for( i = 0; i < cnt_of_array( allocator->state.retired ); i++ )
+    {
+    while( allocator->state.retired[ i ] )
+        {
+        pool = allocator->state.retired[ i ];
+        allocator->state.retired[ i ] = pool->next;
+        pool->next = allocator->state.head_pools;
+        allocator->state.head_pools = pool;
+        }
+    }
+
+while( allocator->state.head_dedicated )
+    {
+    pool = allocator->state.head_dedicated;
+    allocator->state.head_dedicated = pool->next;
+    pool->next = allocator->state.head_pools;
+    allocator->state.head_pools = pool;
+    }
+
 /*----------------------------------------------------------
 Unmap and free all the memory
 ----------------------------------------------------------*/
@@ -304,6 +342,9 @@ for( pool = allocator->state.head_pools; pool; pool = pool->next )
     }
 
 VKN_releaser_auto_mini_end( use );
+
+SlabAllocator_Destroy( &allocator->state.block_slab );
+SlabAllocator_Destroy( &allocator->state.pool_slab );
 clr_struct( allocator );
 
 }   /* VKN_memory_destroy() */
@@ -334,7 +375,8 @@ Local constants
 ----------------------------------------------------------*/
 static const VKN_memory_build_config_type CONFIG =
     {
-    set_allocation_callbacks
+    set_allocation_callbacks,
+    set_device_extensions
     };
 
 clr_struct( builder );
@@ -384,6 +426,7 @@ Try to allocate from existing pools
 for( pool = allocator->state.head_pools; pool; pool = pool->next )
     {
     if( pool->usage != usage
+     || pool->is_evacuating
      || !test_any_bits( memory_bits, shift_bits( 1, pool->memory_index ) ) )
         {
         continue;
@@ -402,9 +445,15 @@ for( pool = allocator->state.head_pools; pool; pool = pool->next )
     }
 
 /*----------------------------------------------------------
-No pools sufficed, so try creating a new one for this usage
+No pools sufficed, so try creating a new one for this usage.
+Host-visible pools are the first to leave a heap over budget.
 ----------------------------------------------------------*/
-pool = create_new_pool( usage, memory_bits, allocator );
+pool = create_new_pool( usage,
+                        usage == VKN_MEMORY_HEAP_USAGE_DEFAULT ? VKN_MEMORY_PRIORITY_NORMAL : VKN_MEMORY_PRIORITY_LOW,
+                        size,
+                        memory_bits,
+                        NULL,
+                        allocator );
 if( !pool )
     {
     return( FALSE );
@@ -418,33 +467,94 @@ return( allocate_from_pool( size, alignment, pool, allocator, allocation ) );
 /*********************************************************************
 *
 *   PROCEDURE NAME:
-*       allocate_block
+*       allocate_for_resource
+*
+*   DESCRIPTION:
+*       Allocate memory for a buffer or image.  Those the driver
+*       wants alone, or that would take much of a pool, get memory
+*       of their own.
 *
 *********************************************************************/
 
-static VKN_memory_block_type * allocate_block
+static bool allocate_for_resource
     (
-    VKN_memory_type    *allocator   /* from which to allocate       */
+    const VkMemoryRequirements
+                       *required,   /* memory requirements          */
+    const VkMemoryDedicatedRequirements
+                       *dedicated,  /* dedicated allocation hints   */
+    const VkBuffer      buffer,     /* buffer to back, or null      */
+    const VkImage       image,      /* image to back, or null       */
+    const VKN_memory_heap_usage_type
+                        usage,      /* how memory is to be used     */
+    VKN_memory_type    *allocator,  /* memory allocator             */
+    VKN_memory_allocation_type
+                       *allocation  /* output new allocation        */
     )
 {
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VKN_memory_block_type  *ret;        /* return allocated block       */
+VkMemoryDedicatedAllocateInfo
+                        ci_dedicated;
+                                    /* dedicated allocation info    */
+bool                    is_dedicated;
+                                    /* give it its own memory?      */
+u32                     memory_index;
+                                    /* memory type index            */
+VKN_memory_pool_type   *pool;       /* dedicated pool               */
 
-ret = allocator->state.free_blocks;
-if( !ret )
+/*----------------------------------------------------------
+Decide whether it gets its own memory
+----------------------------------------------------------*/
+is_dedicated = dedicated->requiresDedicatedAllocation
+            || dedicated->prefersDedicatedAllocation;
+
+if( !is_dedicated
+ && find_memory_type_for_usage( usage, required->memoryTypeBits, allocator, &memory_index ) )
     {
-    return( NULL );
+    is_dedicated = 2 * required->size > allocator->state.heap_pool_size[ allocator->state.memory_props.memoryTypes[ memory_index ].heapIndex ];
     }
 
-allocator->state.free_blocks = ret->next;
-ret->next        = NULL;
-ret->block_id    = allocator->state.next_block_id++;
+if( !is_dedicated )
+    {
+    return( allocator->i->allocate( (u32)required->size, (u32)required->alignment, required->memoryTypeBits, usage, allocator, allocation ) );
+    }
 
-return( ret );
+/*----------------------------------------------------------
+Create a pool for just this resource.  Its one block is at
+offset zero, which suits any alignment.
+----------------------------------------------------------*/
+clr_struct( allocation );
+clr_struct( &ci_dedicated );
+ci_dedicated.sType  = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+ci_dedicated.buffer = buffer;
+ci_dedicated.image  = image;
+
+pool = create_new_pool( usage, VKN_MEMORY_PRIORITY_HIGH, required->size, required->memoryTypeBits, &ci_dedicated, allocator );
+if( pool
+ && allocate_from_pool( (u32)required->size, 0, pool, allocator, allocation ) )
+    {
+    allocation->alignment = (u32)required->alignment;
+    return( TRUE );
+    }
+
+if( pool )
+    {
+    debug_assert_always();
+    free_pool( pool, allocator );
+    }
+
+/*----------------------------------------------------------
+Share a pool if the driver allows it
+----------------------------------------------------------*/
+if( dedicated->requiresDedicatedAllocation )
+    {
+    return( FALSE );
+    }
+
+return( allocator->i->allocate( (u32)required->size, (u32)required->alignment, required->memoryTypeBits, usage, allocator, allocation ) );
 
-}   /* allocate_block() */
+}   /* allocate_for_resource() */
 
 
 /*********************************************************************
@@ -465,14 +575,13 @@ Local variables
 VKN_memory_pool_type
                        *ret;        /* return allocated pool        */
 
-ret = allocator->state.free_pools;
+ret = SlabAllocator_New( VKN_memory_pool_type, &allocator->state.pool_slab );
 if( !ret )
     {
     return( NULL );
     }
 
-allocator->state.free_pools = ret->next;
-ret->next = NULL;
+clr_struct( ret );
 
 return( ret );
 
@@ -500,39 +609,12 @@ static bool allocate_from_pool
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VKN_memory_block_type  *block;      /* allocate from this block     */
-VkDeviceSize            block_size; /* block size to use            */
-VkDeviceSize            padding;    /* wasted alignment space       */
-VkDeviceSize            required_alignment;
-                                    /* required in particular pool  */
-VkDeviceSize            required_size;
-                                    /* required in particular block */
-VKN_memory_block_type  *split;      /* newly split unused block     */
+VKN_tlsf_block_type    *block;      /* allocated block              */
 
 /*----------------------------------------------------------
-Find an free block that is sufficient size
+Take a block of just the required size from the pool
 ----------------------------------------------------------*/
-required_alignment = VKN_size_max( alignment, pool->min_alignment );
-for( block = pool->head_blocks; block; block = block->next )
-    {
-    if( block->is_utilized )
-        {
-        continue;
-        }
-
-    padding = VKN_size_round_up_mult( block->offset, required_alignment ) - block->offset;
-    required_size = size + padding;
-    if( block->size < required_size )
-        {
-        continue;
-        }
-
-    /*------------------------------------------------------
-    Allocate from this block
-    ------------------------------------------------------*/
-    break;
-    }
-
+block = VKN_tlsf_allocate( size, VKN_size_max( alignment, pool->min_alignment ), &pool->tlsf );
 if( !block )
     {
     /*------------------------------------------------------
@@ -544,60 +626,22 @@ if( !block )
 /*----------------------------------------------------------
 Make the allocation
 ----------------------------------------------------------*/
-block->is_utilized = TRUE;
-
-allocation->pool_id  = pool->pool_id;
-allocation->block_id = block->block_id;
-allocation->offset   = block->offset + padding;
-allocation->size     = size;
-allocation->memory   = pool->memory;
-allocation->mapping  = pool->mapping + allocation->offset;
-
-/*----------------------------------------------------------
-Look to split off any unused space at the end of the block
-----------------------------------------------------------*/
-block_size = VKN_size_min_power_of_two( required_size );
-if( block->size < block_size
- && block->size - block_size < pool->min_block_size )
-    {
-    /*------------------------------------------------------
-    Too small to split, we're done
-    ------------------------------------------------------*/
-    return( TRUE );
-    }
-
-split = allocate_block( allocator );
-if( !split )
-    {
-    /*------------------------------------------------------
-    Out of allocations, that's fine
-    ------------------------------------------------------*/
-    return( TRUE );
-    }
-
-/*----------------------------------------------------------
-Fill out the split and link it after the block
-----------------------------------------------------------*/
-split->pool_id = pool->pool_id;
-split->size    = block->size - block_size;
-split->offset  = block->offset + block_size;
-split->next    = block->next;
-split->prev    = block;
-
-/*----------------------------------------------------------
-Update the block now to account for the split
-----------------------------------------------------------*/
-block->size -= split->size;
-if( block->next )
-    {
-    block->next->prev = split;
-    }
-
-block->next = split;
+block->block_id       = allocator->state.next_block_id++;
+block->user           = NULL;
+block->is_being_moved = FALSE;
+
+allocation->block     = block;
+allocation->block_id  = block->block_id;
+allocation->offset    = block->offset;
+allocation->size      = size;
+allocation->alignment = alignment;
+allocation->priority  = pool->priority;
+allocation->memory    = pool->memory;
+allocation->mapping   = pool->mapping + allocation->offset;
 
 return( TRUE );
 
-}   /* allocate_pool() */
+}   /* allocate_from_pool() */
 
 
 /*********************************************************************
@@ -616,9 +660,10 @@ static void begin_frame
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VKN_memory_block_type **frame;     /* frame destruction            */
-VKN_memory_pool_type   *pool;      /* owning pool                  */
-VKN_memory_block_type  *to_destroy;/* destruction iterator         */
+VKN_tlsf_block_type   **frame;     /* frame destruction            */
+VKN_memory_pool_type  **link;      /* dedicated pool link          */
+VKN_memory_pool_type   *pool;      /* retired or dedicated pool    */
+VKN_tlsf_block_type    *to_destroy;/* destruction iterator         */
 
 /*----------------------------------------------------------
 Increment the frame counter
@@ -627,76 +672,48 @@ allocator->state.frame_index++;
 allocator->state.frame_index %= cnt_of_array( allocator->state.to_destroy );
 
 /*----------------------------------------------------------
-Merge any unused blocks with their neighbor when possible
+The GPU is done with this frame's blocks, so free them.  Each
+merges with its free neighbors as it goes.
 ----------------------------------------------------------*/
-pool = NULL;
 frame = &allocator->state.to_destroy[ allocator->state.frame_index ];
 for( to_destroy = *frame; to_destroy; to_destroy = *frame )
     {
-    /*------------------------------------------------------
-    Unlink from destruction list
-    ------------------------------------------------------*/
-    *frame = to_destroy->next_destroy;
-    to_destroy->next_destroy = NULL;
+    *frame = to_destroy->next_pending;
+    VKN_tlsf_free( to_destroy );
+    }
 
-    /*------------------------------------------------------
-    Obtain the owning pool
-    ------------------------------------------------------*/
-    if( !pool
-     || pool->pool_id != to_destroy->pool_id )
-        {
-        pool = find_pool_by_id( to_destroy->pool_id, allocator );
-        }
+/*----------------------------------------------------------
+Likewise the GPU is done with this frame's retired pools, so
+give their memory back to the device
+----------------------------------------------------------*/
+while( allocator->state.retired[ allocator->state.frame_index ] )
+    {
+    pool = allocator->state.retired[ allocator->state.frame_index ];
+    allocator->state.retired[ allocator->state.frame_index ] = pool->next;
+    release_pool( pool, allocator );
+    }
 
-    if( !pool )
+/*----------------------------------------------------------
+Release dedicated memory whose resource was just freed
+----------------------------------------------------------*/
+for( link = &allocator->state.head_dedicated; *link; )
+    {
+    pool = *link;
+    if( pool->tlsf.free_size != pool->tlsf.size )
         {
-        /*--------------------------------------------------
-        State is corrupted
-        --------------------------------------------------*/
-        debug_assert_always();
+        link = &pool->next;
         continue;
         }
 
-    /*------------------------------------------------------
-    Merge with 'previous'.  Important that this block
-    survives and 'previous' is freed, in order to ensure we
-    can process our 'next' neighbor.
-    ------------------------------------------------------*/
-    if( to_destroy->prev
-     && !to_destroy->prev->is_utilized )
-        {
-        debug_assert( !to_destroy->prev->is_being_freed );
-        to_destroy->size += to_destroy->prev->size;
-        to_destroy->offset = to_destroy->prev->offset;
-        free_block( to_destroy->prev, pool, allocator );
-        }
-
-    /*------------------------------------------------------
-    Merge with 'next'.  Important that this block is freed
-    and 'next' survives, in order to ensure validity of the
-    destroy list.
-    ------------------------------------------------------*/
-    if( to_destroy->next
-     && !to_destroy->next->is_utilized )
-        {
-        to_destroy->next->size += to_destroy->size;
-        to_destroy->next->offset = to_destroy->offset;
-        to_destroy->is_utilized = FALSE;
-        free_block( to_destroy, pool, allocator );
-        to_destroy = NULL;
-        }
-
-    /*------------------------------------------------------
-    If block still exists, mark it as empty and ready for
-    new allocations.
-    ------------------------------------------------------*/
-    if( to_destroy )
-        {
-        to_destroy->is_utilized = FALSE;
-        to_destroy->is_being_freed = FALSE;
-        }
+    *link = pool->next;
+    release_pool( pool, allocator );
     }
 
+/*----------------------------------------------------------
+Catch up with what the rest of the system is using
+----------------------------------------------------------*/
+refresh_budget( allocator );
+
 }   /* begin_frame() */
 
 
@@ -770,52 +787,6 @@ return( ret );
 }   /* calculate_min_alignment() */
 
 
-/*********************************************************************
-*
-*   PROCEDURE NAME:
-*       calculate_pool_min_block_size
-*
-*********************************************************************/
-
-static VkDeviceSize calculate_pool_min_block_size
-    (
-    const VkDeviceSize  pool_size,  /* the size of the pool         */
-    VkDeviceSize        min_alignment,
-                                    /* minimum alignment for pool   */
-    const u32           max_allocations
-                                    /* maximum allocations allowed  */
-    )
-{
-/*----------------------------------------------------------
-Local variables
-----------------------------------------------------------*/
-u32                     max_splits; /* max number of splits allowed */
-VkDeviceSize            ret;        /* return smallest block size   */
-
-/*----------------------------------------------------------
-Determine how many splits we can do before exceeding the max
-number of allocations allowed
-----------------------------------------------------------*/
-max_splits = 1;
-while( pool_size > ( 2 * max_splits ) )
-    {
-    max_splits *= 2;
-    }
-
-max_splits -= 1;
-
-/*----------------------------------------------------------
-Now split the pool that many times to obtain the minimum
-block size
-----------------------------------------------------------*/
-ret = pool_size >> max_splits;
-ret = VKN_size_max( min_alignment, ret );
-
-return( ret );
-
-}   /* calculate_pool_min_block_size() */
-
-
 /*********************************************************************
 *
 *   PROCEDURE NAME:
@@ -857,46 +828,142 @@ return( ret );
 /*********************************************************************
 *
 *   PROCEDURE NAME:
-*       create_buffer_memory
+*       choose_memory_type
+*
+*   DESCRIPTION:
+*       Choose the memory type for new memory.  The type best for the
+*       usage is taken if its heap is within budget, else the best on
+*       a heap that is.  High priority memory never moves heaps, and
+*       low priority memory leaves a reserve for the rest.  If no
+*       heap has room, stay on the best and let the driver page.
 *
 *********************************************************************/
 
-static bool create_buffer_memory
+static bool choose_memory_type
     (
-    const VkBuffer      buffer,     /* for which to create memory   */
     const VKN_memory_heap_usage_type
                         usage,      /* how memory is to be used     */
-    struct _VKN_memory_type
+    const VKN_memory_priority_type
+                        priority,   /* eviction class               */
+    const VkDeviceSize  size,       /* memory size needed           */
+    const u32           memory_bits,/* memory type indices as bits  */
+    const VKN_memory_type
                        *allocator,  /* memory allocator             */
-    VKN_memory_allocation_type
-                       *allocation  /* output new memory allocation */
+    u32                *memory_index/* output memory type index     */
     )
 {
+/*----------------------------------------------------------
+Local literals
+----------------------------------------------------------*/
+#define LOW_PRIORITY_RESERVE_DIV    ( 8 )
+
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VkMemoryRequirements    required;   /* memory requirements          */
+u32                     candidate;  /* memory type being considered */
+u32                     candidates; /* memory types not yet refused */
+u32                     heap_index; /* heap of candidate            */
+VkDeviceSize            needed;     /* budget the memory needs      */
 
-if( buffer == VK_NULL_HANDLE )
+if( !find_memory_type_for_usage( usage, memory_bits, allocator, memory_index ) )
     {
     return( FALSE );
     }
 
-/*----------------------------------------------------------
-Get the memory requirements and allocate
-----------------------------------------------------------*/
-vkGetBufferMemoryRequirements( allocator->state.logical, buffer, &required );
-if( !allocator->i->allocate( (u32)required.size, (u32)required.alignment, required.memoryTypeBits, usage, allocator, allocation ) )
+if( priority == VKN_MEMORY_PRIORITY_HIGH )
     {
-    return( FALSE );
+    return( TRUE );
     }
 
 /*----------------------------------------------------------
-Now bind the device memory to the buffer
+Try each heap, from best to worst for the usage
 ----------------------------------------------------------*/
-if( VKN_failed( vkBindBufferMemory( allocator->state.logical, buffer, allocation->memory, allocation->offset ) ) )
+candidate  = *memory_index;
+candidates = memory_bits;
+do
     {
-    allocator->i->deallocate( allocator, allocation );
+    heap_index = allocator->state.memory_props.memoryTypes[ candidate ].heapIndex;
+
+    needed = size;
+    if( priority == VKN_MEMORY_PRIORITY_LOW )
+        {
+        needed += allocator->state.heap_budget[ heap_index ] / LOW_PRIORITY_RESERVE_DIV;
+        }
+
+    if( get_heap_remaining( heap_index, allocator ) >= needed )
+        {
+        *memory_index = candidate;
+        return( TRUE );
+        }
+
+    clear_bits( candidates, get_heap_memory_bits( heap_index, allocator ) );
+    }
+while( find_memory_type_for_usage( usage, candidates, allocator, &candidate ) );
+
+return( TRUE );
+
+#undef LOW_PRIORITY_RESERVE_DIV
+}   /* choose_memory_type() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       create_buffer_memory
+*
+*********************************************************************/
+
+static bool create_buffer_memory
+    (
+    const VkBuffer      buffer,     /* for which to create memory   */
+    const VKN_memory_heap_usage_type
+                        usage,      /* how memory is to be used     */
+    struct _VKN_memory_type
+                       *allocator,  /* memory allocator             */
+    VKN_memory_allocation_type
+                       *allocation  /* output new memory allocation */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VkMemoryDedicatedRequirements
+                        dedicated;  /* dedicated allocation hints   */
+VkBufferMemoryRequirementsInfo2
+                        info;       /* requirements query           */
+VkMemoryRequirements2   required;   /* memory requirements          */
+
+if( buffer == VK_NULL_HANDLE )
+    {
+    return( FALSE );
+    }
+
+/*----------------------------------------------------------
+Get the memory requirements and allocate
+----------------------------------------------------------*/
+clr_struct( &dedicated );
+dedicated.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+clr_struct( &info );
+info.sType  = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+info.buffer = buffer;
+
+clr_struct( &required );
+required.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+required.pNext = &dedicated;
+
+vkGetBufferMemoryRequirements2( allocator->state.logical, &info, &required );
+if( !allocate_for_resource( &required.memoryRequirements, &dedicated, buffer, VK_NULL_HANDLE, usage, allocator, allocation ) )
+    {
+    return( FALSE );
+    }
+
+/*----------------------------------------------------------
+Now bind the device memory to the buffer
+----------------------------------------------------------*/
+if( VKN_failed( vkBindBufferMemory( allocator->state.logical, buffer, allocation->memory, allocation->offset ) ) )
+    {
+    allocator->i->deallocate( allocator, allocation );
     return( FALSE );
     }
 
@@ -926,7 +993,11 @@ static bool create_image_memory
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VkMemoryRequirements    required;   /* memory requirements          */
+VkMemoryDedicatedRequirements
+                        dedicated;  /* dedicated allocation hints   */
+VkImageMemoryRequirementsInfo2
+                        info;       /* requirements query           */
+VkMemoryRequirements2   required;   /* memory requirements          */
 
 if( image == VK_NULL_HANDLE )
     {
@@ -936,8 +1007,19 @@ if( image == VK_NULL_HANDLE )
 /*----------------------------------------------------------
 Get the memory requirements and allocate
 ----------------------------------------------------------*/
-vkGetImageMemoryRequirements( allocator->state.logical, image, &required );
-if( !allocator->i->allocate( (u32)required.size, (u32)required.alignment, required.memoryTypeBits, usage, allocator, allocation ) )
+clr_struct( &dedicated );
+dedicated.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+clr_struct( &info );
+info.sType  = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+info.image  = image;
+
+clr_struct( &required );
+required.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+required.pNext = &dedicated;
+
+vkGetImageMemoryRequirements2( allocator->state.logical, &info, &required );
+if( !allocate_for_resource( &required.memoryRequirements, &dedicated, VK_NULL_HANDLE, image, usage, allocator, allocation ) )
     {
     return( FALSE );
     }
@@ -967,7 +1049,13 @@ static VKN_memory_pool_type * create_new_pool
     (
     const VKN_memory_heap_usage_type
                         usage,      /* how memory is to be used     */
+    const VKN_memory_priority_type
+                        priority,   /* eviction class               */
+    const VkDeviceSize  size,       /* memory size needed           */
     const u32           memory_bits,/* memory type indices as bits  */
+    const VkMemoryDedicatedAllocateInfo
+                       *dedicated,  /* resource to dedicate to, or  */
+                                    /* NULL for a shared pool       */
     struct _VKN_memory_type
                        *allocator   /* memory allocator             */
     )
@@ -975,83 +1063,102 @@ static VKN_memory_pool_type * create_new_pool
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VKN_memory_block_type  *block;      /* initial entire pool block    */
 VkMemoryAllocateInfo    ci_memory;  /* memory create info           */
+VkDeviceSize            granularity;/* smallest block in the pool   */
 u32                     heap_index; /* heap supporting memory type  */
+VKN_memory_pool_type  **head;       /* list to link the pool into   */
 VkDeviceMemory          memory;     /* handle to device memory      */
 u32                     memory_index;
                                     /* memory type index            */
+VkDeviceSize            min_size;   /* smallest pool to try         */
 VkDeviceSize            pool_size;  /* size of pool to create       */
+VkDeviceSize            remaining;  /* budget left in the heap      */
 VKN_memory_pool_type   *ret;        /* return new pool              */
 
 /*----------------------------------------------------------
-Determine if we can create a pool
+Determine where to create the pool
 ----------------------------------------------------------*/
-if( !find_memory_type_for_usage( usage, memory_bits, allocator, &memory_index ) )
+if( !choose_memory_type( usage, priority, size, memory_bits, allocator, &memory_index ) )
     {
     return( NULL );
     }
 
-heap_index = allocator->state.memory_props.memoryTypes[ memory_index ].heapIndex;
-pool_size  = allocator->state.heap_pool_size[ heap_index ];
+heap_index  = allocator->state.memory_props.memoryTypes[ memory_index ].heapIndex;
+granularity = VKN_size_max( VULKAN_BLOCK_SZ, calculate_min_alignment( memory_index, allocator ) );
 
-if( allocator->state.heap_remaining[ heap_index ] < pool_size )
+/*----------------------------------------------------------
+Determine the pool size.  Dedicated memory is exactly the
+resource's size, and shared pools shrink to fit the budget.
+----------------------------------------------------------*/
+pool_size = size;
+min_size  = size;
+if( !dedicated )
     {
-    return( NULL );
+    min_size  = VKN_size_round_up_mult( size, granularity );
+    pool_size = allocator->state.heap_pool_size[ heap_index ];
+    remaining = get_heap_remaining( heap_index, allocator );
+    if( remaining < pool_size )
+        {
+        pool_size = VKN_size_round_down_mult( remaining, granularity );
+        }
+
+    pool_size = VKN_size_max( pool_size, min_size );
     }
 
 /*----------------------------------------------------------
-Allocate the new pool and block, and link them
+Request the memory from vulkan.  If the heap is full, try
+smaller shared pools, down to one just holding the allocation.
 ----------------------------------------------------------*/
-ret = allocate_pool( allocator );
-if( !ret )
+clr_struct( &ci_memory );
+ci_memory.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+ci_memory.pNext           = dedicated;
+ci_memory.allocationSize  = pool_size;
+ci_memory.memoryTypeIndex = memory_index;
+while( VKN_failed( vkAllocateMemory( allocator->state.logical, &ci_memory, NULL, &memory ) ) )
     {
-    /*------------------------------------------------------
-    Out of unused pools
-    ------------------------------------------------------*/
-    return( NULL );
-    }
-
-ret->pool_id = allocator->state.next_pool_id++;
+    if( ci_memory.allocationSize <= min_size )
+        {
+        debug_assert_always();
+        return( NULL );
+        }
 
-block = allocate_block( allocator );
-if( !block )
-    {
-    /*------------------------------------------------------
-    Out of unused blocks
-    ------------------------------------------------------*/
-    free_pool( ret, allocator );
-    return( NULL );
+    ci_memory.allocationSize = VKN_size_max( VKN_size_round_down_mult( ci_memory.allocationSize / 2, granularity ), min_size );
     }
 
-ret->next = allocator->state.head_pools;
-allocator->state.head_pools = ret;
-
-ret->head_blocks = block;
+pool_size = ci_memory.allocationSize;
+allocator->state.heap_allocated[ heap_index ] += pool_size;
 
 /*----------------------------------------------------------
-Determine the final pool size, and request the memory from
-vulkan
+Allocate the new pool and its suballocator, and link it.  A
+dedicated pool's one block covers it, rounded up.
 ----------------------------------------------------------*/
-if( allocator->state.heap_remaining[ heap_index ] < 2 * pool_size )
+ret = allocate_pool( allocator );
+if( !ret )
     {
-    /*------------------------------------------------------
-    Grab any crumbs so we utilize it all
-    ------------------------------------------------------*/
-    pool_size = allocator->state.heap_remaining[ heap_index ];
+    allocator->state.heap_allocated[ heap_index ] -= pool_size;
+    VKN_release_memory( allocator->state.logical, allocator->state.allocator, &memory );
+    return( NULL );
     }
 
-clr_struct( &ci_memory );
-ci_memory.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-ci_memory.allocationSize  = pool_size;
-ci_memory.memoryTypeIndex = memory_index;
-if( VKN_failed( vkAllocateMemory( allocator->state.logical, &ci_memory, NULL, &memory ) ) )
+ret->pool_id       = allocator->state.next_pool_id++;
+ret->min_alignment = calculate_min_alignment( memory_index, allocator );
+ret->is_dedicated  = ( dedicated != NULL );
+ret->memory_index  = memory_index;
+ret->usage         = usage;
+ret->priority      = priority;
+ret->memory        = memory;
+ret->size          = pool_size;
+
+if( !VKN_tlsf_create( VKN_size_round_up_mult( pool_size, granularity ), granularity, &allocator->state.block_slab, &ret->tlsf ) )
     {
-    debug_assert_always();
-    free_pool( ret, allocator );
+    release_pool( ret, allocator );
     return( NULL );
     }
 
+head = ret->is_dedicated ? &allocator->state.head_dedicated : &allocator->state.head_pools;
+ret->next = *head;
+*head = ret;
+
 /*----------------------------------------------------------
 Map the memory if CPU needs to access it
 ----------------------------------------------------------*/
@@ -1061,27 +1168,12 @@ if( usage == VKN_MEMORY_HEAP_USAGE_UPLOAD
     if( VKN_failed( vkMapMemory( allocator->state.logical, memory, 0, pool_size, 0, (void**)&ret->mapping ) ) )
         {
         debug_assert_always();
+        ret->mapping = NULL;
         free_pool( ret, allocator );
         return( NULL );
         }
     }
 
-/*----------------------------------------------------------
-Fill out the initial block
-----------------------------------------------------------*/
-block->pool_id = ret->pool_id;
-block->size    = pool_size;
-
-/*----------------------------------------------------------
-Fill out rest of the pool
-----------------------------------------------------------*/
-ret->memory_index   = memory_index;
-ret->usage          = usage;
-ret->memory         = memory;
-ret->size           = pool_size;
-ret->min_alignment  = calculate_min_alignment( memory_index, allocator );
-ret->min_block_size = calculate_pool_min_block_size( pool_size, ret->min_alignment, cnt_of_array( allocator->state.blocks ) );
-
 return( ret );
 
 }   /* create_new_pool() */
@@ -1105,52 +1197,41 @@ static void deallocate
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VKN_memory_block_type **head;       /* working block head           */
-VKN_memory_block_type  *block;      /* allocation owning block      */
-VKN_memory_pool_type   *pool;       /* allocation owning pool       */
+VKN_tlsf_block_type    *block;      /* allocation owning block      */
 
 /*----------------------------------------------------------
-Find the block, but don't remove it from the used list
+Check the block is still the one allocated
 ----------------------------------------------------------*/
-pool = find_pool_by_id( allocation->pool_id, allocator );
-if( !pool )
+block = allocation->block;
+if( !block
+ || block->block_id != allocation->block_id
+ || block->is_free
+ || block->is_being_freed )
     {
     debug_assert_always();
     return;
     }
 
-block = find_block_by_id( allocation->block_id, pool );
-if( !block )
-    {
-    debug_assert_always();
-    return;
-    }
+debug_assert( allocation->offset == block->offset );
+debug_assert( allocation->size <= block->size );
 
-if( !block->is_utilized
- || block->is_being_freed )
+block->is_being_freed = TRUE;
+block->user           = NULL;
+if( block->is_being_moved )
     {
-    debug_assert_always();
+    /*------------------------------------------------------
+    The defragmenter's copy may still be reading it, so the
+    defragmenter frees it when the copy is done
+    ------------------------------------------------------*/
+    clr_struct( allocation );
     return;
     }
 
-block->is_being_freed = TRUE;
-debug_assert( allocation->offset >= block->offset );
-debug_assert( allocation->size + ( allocation->offset - block->offset ) <= block->size );
-
 /*----------------------------------------------------------
-Keep destruction list in order by pool id (major) and memory
-offset (minor) in order to facilitate merges during
-begin_frame()
+Free it once the GPU is done with this frame
 ----------------------------------------------------------*/
-for( head = &allocator->state.to_destroy[ allocator->state.frame_index ];
-     (*head)
-  && ( (*head)->pool_id < block->pool_id
-    || ( (*head)->pool_id == block->pool_id
-      && (*head)->offset < block->offset ) );
-     head = &(*head)->next_destroy );
-
-block->next_destroy = *head;
-*head = block;
+block->next_pending = allocator->state.to_destroy[ allocator->state.frame_index ];
+allocator->state.to_destroy[ allocator->state.frame_index ] = block;
 
 clr_struct( allocation );
 
@@ -1243,90 +1324,303 @@ return( best_score > 0 );
 /*********************************************************************
 *
 *   PROCEDURE NAME:
-*       free_block
+*       free_pool
 *
 *********************************************************************/
 
-static void free_block
+static void free_pool
     (
-    VKN_memory_block_type
-                       *to_free,    /* block to free                */
     VKN_memory_pool_type
-                       *pool,       /* owning pool                  */
+                       *to_free,    /* pool to free                 */
     VKN_memory_type    *allocator   /* from which to allocate       */
     )
 {
-debug_assert( !to_free->is_utilized );
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_memory_pool_type  **head;       /* used head                    */
 
 /*----------------------------------------------------------
 Unlink the pool from the used pools
 ----------------------------------------------------------*/
-if( to_free->prev )
+head = to_free->is_dedicated ? &allocator->state.head_dedicated : &allocator->state.head_pools;
+for( ; *head != to_free; head = &(*head)->next );
+*head = to_free->next;
+
+/*----------------------------------------------------------
+Give back its memory and return it to free pools
+----------------------------------------------------------*/
+release_pool( to_free, allocator );
+
+}   /* free_pool() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       get_budget_report
+*
+*   DESCRIPTION:
+*       Report each heap usage's memory against the budget of the
+*       heap it prefers.  Cheap enough to poll every frame, e.g. to
+*       throttle streaming as the headroom runs out.
+*
+*********************************************************************/
+
+static void get_budget_report
+    (
+    const struct _VKN_memory_type
+                       *allocator,  /* memory allocator             */
+    VKN_memory_budget_report_type
+                       *report      /* output budget report         */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_memory_budget_type *budget;     /* usage's budget               */
+u32                     i;          /* loop counter                 */
+const VKN_memory_pool_type
+                       *pool;       /* pool iterator                */
+const VKN_memory_pool_type
+                       *lists[ 2 ]; /* pool lists to report on      */
+
+clr_struct( report );
+
+/*----------------------------------------------------------
+Fill in the heap each usage prefers
+----------------------------------------------------------*/
+for( i = 0; i < cnt_of_array( report->usages ); i++ )
     {
-    to_free->prev->next = to_free->next;
+    budget = &report->usages[ i ];
+    budget->heap_index = allocator->state.usage_heap[ i ];
+    budget->budget     = allocator->state.heap_budget[ budget->heap_index ];
+    budget->usage      = get_heap_usage( budget->heap_index, allocator );
+    budget->headroom   = get_heap_remaining( budget->heap_index, allocator );
     }
-else
+
+/*----------------------------------------------------------
+Add up the pools of each usage
+----------------------------------------------------------*/
+lists[ 0 ] = allocator->state.head_pools;
+lists[ 1 ] = allocator->state.head_dedicated;
+for( i = 0; i < cnt_of_array( lists ); i++ )
     {
-    pool->head_blocks = to_free->next;
+    for( pool = lists[ i ]; pool; pool = pool->next )
+        {
+        budget = &report->usages[ pool->usage ];
+        budget->allocated += pool->size;
+        budget->used      += VKN_size_min( pool->size, pool->tlsf.size - pool->tlsf.free_size );
+        budget->priority_size[ pool->priority ] += pool->size;
+
+        if( pool->is_dedicated )
+            {
+            budget->dedicated += pool->size;
+            }
+
+        if( allocator->state.memory_props.memoryTypes[ pool->memory_index ].heapIndex != budget->heap_index )
+            {
+            budget->spilled += pool->size;
+            }
+        }
     }
 
-if( to_free->next )
+}   /* get_budget_report() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       get_heap_memory_bits
+*
+*********************************************************************/
+
+static u32 get_heap_memory_bits
+    (
+    const u32           heap_index, /* heap to get memory types of  */
+    const VKN_memory_type
+                       *allocator   /* memory allocator             */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+u32                     i;          /* loop counter                 */
+u32                     ret;        /* return memory types as bits  */
+
+ret = 0;
+for( i = 0; i < allocator->state.memory_props.memoryTypeCount; i++ )
     {
-    to_free->next->prev = to_free->prev;
+    if( allocator->state.memory_props.memoryTypes[ i ].heapIndex == heap_index )
+        {
+        set_bits( ret, shift_bits( 1, i ) );
+        }
     }
 
+return( ret );
+
+}   /* get_heap_memory_bits() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       get_heap_remaining
+*
+*********************************************************************/
+
+static VkDeviceSize get_heap_remaining
+    (
+    const u32           heap_index, /* heap to check                */
+    const VKN_memory_type
+                       *allocator   /* memory allocator             */
+    )
+{
 /*----------------------------------------------------------
-Clear it and return to free blocks
+Local variables
 ----------------------------------------------------------*/
-clr_struct( to_free );
-to_free->next = allocator->state.free_blocks;
-allocator->state.free_blocks = to_free;
+VkDeviceSize            usage;      /* heap usage                   */
+
+usage = get_heap_usage( heap_index, allocator );
+if( usage >= allocator->state.heap_budget[ heap_index ] )
+    {
+    return( 0 );
+    }
 
-}   /* free_block() */
+return( allocator->state.heap_budget[ heap_index ] - usage );
+
+}   /* get_heap_remaining() */
 
 
 /*********************************************************************
 *
 *   PROCEDURE NAME:
-*       free_pool
+*       get_heap_usage
+*
+*   DESCRIPTION:
+*       Get the process's usage of the heap.  The driver's figure is
+*       from the last query, so adjust it by what this allocator has
+*       allocated and released since.
 *
 *********************************************************************/
 
-static void free_pool
+static VkDeviceSize get_heap_usage
     (
-    VKN_memory_pool_type
-                       *to_free,    /* pool to free                 */
-    VKN_memory_type    *allocator   /* from which to allocate       */
+    const u32           heap_index, /* heap to check                */
+    const VKN_memory_type
+                       *allocator   /* memory allocator             */
     )
 {
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VKN_memory_block_type  *block;      /* head block                   */
-VKN_memory_pool_type  **head;       /* used head                    */
+VkDeviceSize            allocated;  /* allocated now                */
+VkDeviceSize            queried;    /* allocated at last query      */
+VkDeviceSize            usage;      /* usage at last query          */
+
+allocated = allocator->state.heap_allocated[ heap_index ];
+if( !allocator->state.has_memory_budget )
+    {
+    return( allocated );
+    }
+
+queried = allocator->state.heap_queried[ heap_index ];
+usage   = allocator->state.heap_usage[ heap_index ];
+if( allocated >= queried )
+    {
+    return( usage + ( allocated - queried ) );
+    }
+
+return( usage - VKN_size_min( usage, queried - allocated ) );
+
+}   /* get_heap_usage() */
+
 
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       refresh_budget
+*
+*   DESCRIPTION:
+*       Query the heap budgets and usages.  Without
+*       VK_EXT_memory_budget, assume a share of each heap is ours.
+*
+*********************************************************************/
+
+static void refresh_budget
+    (
+    VKN_memory_type    *allocator   /* memory allocator             */
+    )
+{
 /*----------------------------------------------------------
-Unlink the pool from the used pools
+Local literals
 ----------------------------------------------------------*/
-for( head = &allocator->state.head_pools; *head != to_free; head = &(*head)->next );
-*head = to_free->next;
+#define FALLBACK_BUDGET_PERCENT     ( 80 )
 
 /*----------------------------------------------------------
-Free all the blocks
+Local variables
 ----------------------------------------------------------*/
-for( block = to_free->head_blocks; block; block = to_free->head_blocks )
+VkPhysicalDeviceMemoryBudgetPropertiesEXT
+                        budget;     /* heap budgets                 */
+u32                     i;          /* loop counter                 */
+VkPhysicalDeviceMemoryProperties2
+                        props;      /* memory properties            */
+
+if( !allocator->state.has_memory_budget )
     {
-    free_block( block, to_free, allocator );
+    for( i = 0; i < allocator->state.memory_props.memoryHeapCount; i++ )
+        {
+        allocator->state.heap_budget[ i ] = allocator->state.memory_props.memoryHeaps[ i ].size / 100 * FALLBACK_BUDGET_PERCENT;
+        }
+
+    return;
     }
 
-/*----------------------------------------------------------
-Clear it and return to free pools
-----------------------------------------------------------*/
-clr_struct( to_free );
-to_free->next = allocator->state.free_pools;
-allocator->state.free_pools = to_free;
+clr_struct( &budget );
+budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
 
-}   /* free_pool() */
+clr_struct( &props );
+props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+props.pNext = &budget;
+
+vkGetPhysicalDeviceMemoryProperties2( allocator->state.physical, &props );
+for( i = 0; i < allocator->state.memory_props.memoryHeapCount; i++ )
+    {
+    allocator->state.heap_budget[ i ]  = budget.heapBudget[ i ];
+    allocator->state.heap_usage[ i ]   = budget.heapUsage[ i ];
+    allocator->state.heap_queried[ i ] = allocator->state.heap_allocated[ i ];
+    }
+
+#undef FALLBACK_BUDGET_PERCENT
+}   /* refresh_budget() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       release_pool
+*
+*********************************************************************/
+
+static void release_pool
+    (
+    VKN_memory_pool_type
+                       *to_release, /* unlinked pool to release     */
+    VKN_memory_type    *allocator   /* owning allocator             */
+    )
+{
+if( to_release->mapping )
+    {
+    vkUnmapMemory( allocator->state.logical, to_release->memory );
+    }
+
+allocator->state.heap_allocated[ allocator->state.memory_props.memoryTypes[ to_release->memory_index ].heapIndex ] -= to_release->size;
+VKN_release_memory( allocator->state.logical, allocator->state.allocator, &to_release->memory );
+
+VKN_tlsf_destroy( &to_release->tlsf );
+SlabAllocator_Free( to_release, &allocator->state.pool_slab );
+
+}   /* release_pool() */
 
 
 /*********************************************************************
@@ -1349,3 +1643,82 @@ builder->state.allocator = allocator;
 return( builder->config );
 
 }   /* set_allocation_callbacks() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       set_device_extensions
+*
+*********************************************************************/
+
+static VKN_MEMORY_CONFIG_API set_device_extensions
+    (
+    const char * const *extensions, /* enabled extension names      */
+    const u32           extension_cnt,
+                                    /* number of extension names    */
+    struct _VKN_memory_build_type
+                       *builder     /* memory allocator builder     */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+u32                     i;          /* loop counter                 */
+
+builder->state.has_memory_budget = FALSE;
+for( i = 0; i < extension_cnt; i++ )
+    {
+    if( !strcmp( extensions[ i ], VK_EXT_MEMORY_BUDGET_EXTENSION_NAME ) )
+        {
+        builder->state.has_memory_budget = TRUE;
+        }
+    }
+
+return( builder->config );
+
+}   /* set_device_extensions() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       set_relocatable
+*
+*   DESCRIPTION:
+*       Let the defragmenter move the allocation, calling relocate
+*       to move the holder's resource with it.  The allocation
+*       record must stay at the same address until deallocated.
+*
+*********************************************************************/
+
+static void set_relocatable
+    (
+    VKN_memory_relocate_proc_type
+                       *relocate,   /* move callback, NULL to pin   */
+    void               *user,       /* holder's data for relocate   */
+    struct _VKN_memory_type
+                       *allocator,  /* memory allocator             */
+    VKN_memory_allocation_type
+                       *allocation  /* allocation to make movable   */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_tlsf_block_type    *block;      /* allocation owning block      */
+
+block = allocation->block;
+if( !block
+ || block->block_id != allocation->block_id
+ || block->is_being_freed )
+    {
+    debug_assert_always();
+    return;
+    }
+
+allocation->relocate      = relocate;
+allocation->relocate_user = user;
+block->user               = relocate ? allocation : NULL;
+
+}   /* set_relocatable() */
@@ -0,0 +1,1059 @@
+#include "Global.hpp"
+#include "SlabAllocator.hpp"
+#include "Utilities.hpp"
+
+#include "VknCommon.hpp"
+#include "VknMemoryDefrag.hpp"
+#include "VknReleaser.hpp"
+#include "VknTlsf.hpp"
+
+
+#define MOVES_PER_SLAB              ( 64 )
+#define RETRY_FRAMES                ( 60 )
+
+
+static bool allocate_destination
+    (
+    const VKN_memory_allocation_type
+                       *from,       /* allocation to move           */
+    const VKN_memory_pool_type
+                       *source,     /* pool being evacuated         */
+    VKN_memory_type    *memory,     /* memory allocator             */
+    VKN_memory_allocation_type
+                       *to          /* output new allocation        */
+    );
+
+static VKN_memory_defrag_begin_frame_proc_type begin_frame;
+
+static void defer_free
+    (
+    VKN_tlsf_block_type
+                       *block,      /* block to free                */
+    VKN_memory_type    *memory      /* memory allocator             */
+    );
+
+static void end_pass
+    (
+    const u32           idle_frames,/* frames before the next pass  */
+    VKN_memory_defrag_type
+                       *defrag      /* defragmenter                 */
+    );
+
+static VKN_memory_pool_type * find_source
+    (
+    VKN_memory_type    *memory,     /* memory allocator             */
+    const u32           sparse_percent
+                                    /* most used to evacuate a pool */
+    );
+
+static void finish_moves
+    (
+    VKN_releaser_type  *releaser,   /* release buffer for old       */
+    VKN_memory_defrag_type
+                       *defrag      /* defragmenter                 */
+    );
+
+static VKN_memory_defrag_get_report_proc_type get_report;
+
+static void measure
+    (
+    const VKN_memory_type
+                       *memory,     /* memory allocator             */
+    VKN_memory_fragmentation_type
+                       *out         /* output fragmentation         */
+    );
+
+static bool record_moves
+    (
+    VKN_releaser_type  *releaser,   /* release buffer for cancels   */
+    VKN_memory_defrag_type
+                       *defrag      /* defragmenter                 */
+    );
+
+static void retire_pool
+    (
+    VKN_memory_pool_type
+                       *pool,       /* empty pool to retire         */
+    VKN_memory_type    *memory      /* memory allocator             */
+    );
+
+static VKN_memory_defrag_build_set_allocation_callbacks_proc_type set_allocation_callbacks;
+static VKN_memory_defrag_build_set_frame_budget_proc_type set_frame_budget;
+static VKN_memory_defrag_build_set_sparse_percent_proc_type set_sparse_percent;
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       VKN_memory_defrag_create
+*
+*   DESCRIPTION:
+*       Create a memory defragmenter via the given builder.
+*
+*********************************************************************/
+
+bool VKN_memory_defrag_create
+    (
+    const VKN_memory_defrag_build_type
+                       *builder,    /* defragmenter builder         */
+    VKN_memory_defrag_type
+                       *defrag      /* output new defragmenter      */
+    )
+{
+/*----------------------------------------------------------
+Local constants
+----------------------------------------------------------*/
+static const VKN_memory_defrag_api_type API =
+    {
+    begin_frame,
+    get_report
+    };
+
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VkCommandBufferAllocateInfo
+                        ci_command; /* command buffer create info   */
+VkFenceCreateInfo       ci_fence;   /* fence create info            */
+VkCommandPoolCreateInfo ci_pool;    /* command pool create info     */
+
+/*----------------------------------------------------------
+Create the defragmenter
+----------------------------------------------------------*/
+clr_struct( defrag );
+defrag->i = &API;
+
+defrag->state.logical        = builder->state.logical;
+defrag->state.allocator      = builder->state.allocator;
+defrag->state.queue          = builder->state.queue;
+defrag->state.queue_index    = builder->state.queue_index;
+defrag->state.memory         = builder->state.memory;
+defrag->state.frame_budget   = builder->state.frame_budget;
+defrag->state.sparse_percent = builder->state.sparse_percent;
+
+if( !SlabAllocator_InitForType( VKN_memory_defrag_move_type, MOVES_PER_SLAB, SLAB_ALLOCATOR_FLAG_NONE, &defrag->state.move_slab ) )
+    {
+    clr_struct( defrag );
+    return( FALSE );
+    }
+
+/*----------------------------------------------------------
+Create command pool, command buffer, and fence
+----------------------------------------------------------*/
+clr_struct( &ci_pool );
+ci_pool.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+ci_pool.queueFamilyIndex = builder->state.queue_index;
+ci_pool.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+if( VKN_failed( vkCreateCommandPool( defrag->state.logical, &ci_pool, defrag->state.allocator, &defrag->state.command_pool ) ) )
+    {
+    VKN_memory_defrag_destroy( NULL, defrag );
+    return( FALSE );
+    }
+
+clr_struct( &ci_command );
+ci_command.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+ci_command.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+ci_command.commandBufferCount = 1;
+ci_command.commandPool        = defrag->state.command_pool;
+
+clr_struct( &ci_fence );
+ci_fence.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+if( VKN_failed( vkAllocateCommandBuffers( defrag->state.logical, &ci_command, &defrag->state.commands ) )
+ || VKN_failed( vkCreateFence( defrag->state.logical, &ci_fence, defrag->state.allocator, &defrag->state.fence ) ) )
+    {
+    VKN_memory_defrag_destroy( NULL, defrag );
+    return( FALSE );
+    }
+
+VKN_name_object( defrag->state.logical, defrag->state.commands, VK_OBJECT_TYPE_COMMAND_BUFFER, "Defrag_CmdBuff" );
+VKN_name_object( defrag->state.logical, defrag->state.fence,    VK_OBJECT_TYPE_FENCE,          "Defrag_Fence" );
+
+return( TRUE );
+
+}   /* VKN_memory_defrag_create() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       VKN_memory_defrag_destroy
+*
+*   DESCRIPTION:
+*       Destroy the given memory defragmenter, finishing any moves
+*       in-flight.
+*
+*********************************************************************/
+
+void VKN_memory_defrag_destroy
+    (
+    VKN_releaser_type  *releaser,   /* release buffer               */
+    VKN_memory_defrag_type
+                       *defrag      /* defragmenter to destroy      */
+    )
+{
+/*----------------------------------------------------------
+Wait for the copies, and hand the moved memory to its holders
+----------------------------------------------------------*/
+if( defrag->state.in_flight )
+    {
+    if( VKN_failed( vkWaitForFences( defrag->state.logical, 1, &defrag->state.fence, VK_FALSE, VKN_WAIT_INFINITE ) ) )
+        {
+        debug_assert_always();
+        }
+
+    finish_moves( releaser, defrag );
+    }
+
+if( defrag->state.source )
+    {
+    end_pass( 0, defrag );
+    }
+
+VKN_releaser_auto_mini_begin( releaser, use );
+use->i->release_command_pool( defrag->state.logical, defrag->state.allocator, defrag->state.command_pool, use )->
+        release_command_buffer( defrag->state.logical, defrag->state.command_pool, defrag->state.commands, use )->
+        release_fence( defrag->state.logical, defrag->state.allocator, defrag->state.fence, use );
+VKN_releaser_auto_mini_end( use );
+
+SlabAllocator_Destroy( &defrag->state.move_slab );
+clr_struct( defrag );
+
+}   /* VKN_memory_defrag_destroy() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       VKN_memory_defrag_init_builder
+*
+*   DESCRIPTION:
+*       Initialize a memory defragmenter builder.
+*
+*********************************************************************/
+
+VKN_MEMORY_DEFRAG_CONFIG_API VKN_memory_defrag_init_builder
+    (
+    const VkDevice      logical,    /* associated logical device    */
+    const VkQueue       queue,      /* queue on which to copy       */
+    const u32           queue_index,/* family index of copy queue   */
+    VKN_memory_type    *memory,     /* memory allocator             */
+    VKN_memory_defrag_build_type
+                       *builder     /* defragmenter builder         */
+    )
+{
+/*----------------------------------------------------------
+Local literals
+----------------------------------------------------------*/
+#define DEFAULT_FRAME_BUDGET        ( 8 * 1024 * 1024 )
+#define DEFAULT_SPARSE_PERCENT      ( 25 )
+
+/*----------------------------------------------------------
+Local constants
+----------------------------------------------------------*/
+static const VKN_memory_defrag_build_config_type CONFIG =
+    {
+    set_allocation_callbacks,
+    set_frame_budget,
+    set_sparse_percent
+    };
+
+clr_struct( builder );
+builder->config = &CONFIG;
+
+builder->state.logical        = logical;
+builder->state.queue          = queue;
+builder->state.queue_index    = queue_index;
+builder->state.memory         = memory;
+builder->state.frame_budget   = DEFAULT_FRAME_BUDGET;
+builder->state.sparse_percent = DEFAULT_SPARSE_PERCENT;
+
+return( builder->config );
+
+#undef DEFAULT_FRAME_BUDGET
+#undef DEFAULT_SPARSE_PERCENT
+}   /* VKN_memory_defrag_init_builder() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       allocate_destination
+*
+*   DESCRIPTION:
+*       Allocate room for the given allocation in the fullest
+*       compatible pool that can take it, other than the one being
+*       evacuated.
+*
+*********************************************************************/
+
+static bool allocate_destination
+    (
+    const VKN_memory_allocation_type
+                       *from,       /* allocation to move           */
+    const VKN_memory_pool_type
+                       *source,     /* pool being evacuated         */
+    VKN_memory_type    *memory,     /* memory allocator             */
+    VKN_memory_allocation_type
+                       *to          /* output new allocation        */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_tlsf_block_type    *block;      /* new block                    */
+bool                    is_past;    /* is pool after the last tried */
+VKN_memory_pool_type   *pool;       /* pool iterator                */
+VKN_memory_pool_type   *tried;      /* last pool tried              */
+VKN_memory_pool_type   *try_pool;   /* fullest pool not yet tried   */
+
+clr_struct( to );
+
+/*----------------------------------------------------------
+Try pools from fullest to emptiest, so the moves pack the
+memory rather than spread it.  Pools with the same free size
+are tried in list order, so each is tried once.
+----------------------------------------------------------*/
+block = NULL;
+tried = NULL;
+while( !block )
+    {
+    try_pool = NULL;
+    is_past  = FALSE;
+    for( pool = memory->state.head_pools; pool; pool = pool->next )
+        {
+        if( pool == tried )
+            {
+            is_past = TRUE;
+            continue;
+            }
+
+        if( pool == source
+         || pool->is_evacuating
+         || pool->memory_index != source->memory_index
+         || pool->usage != source->usage
+         || pool->tlsf.free_size < from->size
+         || ( tried
+           && ( pool->tlsf.free_size < tried->tlsf.free_size
+             || ( pool->tlsf.free_size == tried->tlsf.free_size
+               && !is_past ) ) )
+         || ( try_pool
+           && try_pool->tlsf.free_size <= pool->tlsf.free_size ) )
+            {
+            continue;
+            }
+
+        try_pool = pool;
+        }
+
+    if( !try_pool )
+        {
+        return( FALSE );
+        }
+
+    tried = try_pool;
+    block = VKN_tlsf_allocate( from->size, VKN_size_max( from->alignment, try_pool->min_alignment ), &try_pool->tlsf );
+    }
+
+/*----------------------------------------------------------
+Fill out the allocation as allocate() would
+----------------------------------------------------------*/
+block->block_id       = memory->state.next_block_id++;
+block->user           = NULL;
+block->is_being_moved = FALSE;
+
+to->block         = block;
+to->block_id      = block->block_id;
+to->offset        = block->offset;
+to->size          = from->size;
+to->alignment     = from->alignment;
+to->priority      = try_pool->priority;
+to->memory        = try_pool->memory;
+to->mapping       = try_pool->mapping + to->offset;
+to->relocate      = from->relocate;
+to->relocate_user = from->relocate_user;
+
+return( TRUE );
+
+}   /* allocate_destination() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       begin_frame
+*
+*   DESCRIPTION:
+*       Advance the defragmenter by one frame.  Call after the
+*       memory allocator's begin_frame(), once the frame's slot is
+*       free, with that frame's release buffer for the resources
+*       the moves replace.
+*
+*       The copies are ordered by their queue alone: submit them
+*       on the queue which uses the resources, after the submits
+*       which wait on their uploads.  Their first barrier waits
+*       for those writes, and their last makes the copies visible
+*       to every later submit.  Holders see COMMIT only after the
+*       host has waited for the copies, before any submit uses the
+*       new resources.
+*
+*********************************************************************/
+
+static void begin_frame
+    (
+    VKN_releaser_type  *releaser,   /* this frame's release buffer  */
+    struct _VKN_memory_defrag_type
+                       *defrag      /* defragmenter                 */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VkResult                status;     /* fence status                 */
+
+/*----------------------------------------------------------
+Hand over the last batch once its copies are done.  Only one
+batch is in-flight at a time, which paces moves to the budget.
+----------------------------------------------------------*/
+if( defrag->state.in_flight )
+    {
+    status = vkGetFenceStatus( defrag->state.logical, defrag->state.fence );
+    if( status == VK_NOT_READY )
+        {
+        return;
+        }
+
+    debug_assert( status == VK_SUCCESS );
+    finish_moves( releaser, defrag );
+    measure( defrag->state.memory, &defrag->state.report.after );
+    }
+
+if( defrag->state.idle_frames )
+    {
+    defrag->state.idle_frames--;
+    return;
+    }
+
+/*----------------------------------------------------------
+Start a new pass on the sparsest pool worth emptying
+----------------------------------------------------------*/
+if( !defrag->state.source )
+    {
+    defrag->state.source = find_source( defrag->state.memory, defrag->state.sparse_percent );
+    if( !defrag->state.source )
+        {
+        defrag->state.idle_frames = RETRY_FRAMES;
+        return;
+        }
+
+    defrag->state.source->is_evacuating = TRUE;
+
+    clr_struct( &defrag->state.report );
+    measure( defrag->state.memory, &defrag->state.report.before );
+    defrag->state.report.after = defrag->state.report.before;
+    }
+
+/*----------------------------------------------------------
+Once every block has been moved and freed through the frame
+ring, the pool is empty and can go
+----------------------------------------------------------*/
+if( defrag->state.source->tlsf.free_size == defrag->state.source->tlsf.size )
+    {
+    retire_pool( defrag->state.source, defrag->state.memory );
+    defrag->state.source = NULL;
+    defrag->state.report.retire_cnt++;
+    measure( defrag->state.memory, &defrag->state.report.after );
+    return;
+    }
+
+if( !record_moves( releaser, defrag ) )
+    {
+    /*------------------------------------------------------
+    Pool can't be emptied for now.  Let it serve allocations
+    again and look elsewhere later.
+    ------------------------------------------------------*/
+    end_pass( RETRY_FRAMES, defrag );
+    }
+
+}   /* begin_frame() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       defer_free
+*
+*   DESCRIPTION:
+*       Free the block once the GPU is done with this frame, the
+*       same as deallocate().
+*
+*********************************************************************/
+
+static void defer_free
+    (
+    VKN_tlsf_block_type
+                       *block,      /* block to free                */
+    VKN_memory_type    *memory      /* memory allocator             */
+    )
+{
+block->is_being_freed = TRUE;
+block->is_being_moved = FALSE;
+block->user           = NULL;
+block->next_pending   = memory->state.to_destroy[ memory->state.frame_index ];
+memory->state.to_destroy[ memory->state.frame_index ] = block;
+
+}   /* defer_free() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       end_pass
+*
+*********************************************************************/
+
+static void end_pass
+    (
+    const u32           idle_frames,/* frames before the next pass  */
+    VKN_memory_defrag_type
+                       *defrag      /* defragmenter                 */
+    )
+{
+defrag->state.source->is_evacuating = FALSE;
+defrag->state.source      = NULL;
+defrag->state.idle_frames = idle_frames;
+
+}   /* end_pass() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       find_source
+*
+*   DESCRIPTION:
+*       Find the sparsest pool under the threshold whose
+*       allocations are all movable and fit in its sibling pools.
+*
+*********************************************************************/
+
+static VKN_memory_pool_type * find_source
+    (
+    VKN_memory_type    *memory,     /* memory allocator             */
+    const u32           sparse_percent
+                                    /* most used to evacuate a pool */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+const VKN_tlsf_block_type
+                       *block;      /* block iterator               */
+VKN_memory_pool_type   *pool;       /* pool iterator                */
+VKN_memory_pool_type   *ret;        /* return sparsest pool         */
+VkDeviceSize            room;       /* free size of sibling pools   */
+VKN_memory_pool_type   *sibling;    /* sibling pool iterator        */
+u32                     sibling_cnt;/* pools it could move to       */
+VkDeviceSize            used;       /* used size of pool            */
+
+ret = NULL;
+for( pool = memory->state.head_pools; pool; pool = pool->next )
+    {
+    used = pool->tlsf.size - pool->tlsf.free_size;
+    if( used * 100 > pool->tlsf.size * sparse_percent
+     || ( ret
+       && ret->tlsf.size - ret->tlsf.free_size <= used ) )
+        {
+        continue;
+        }
+
+    /*------------------------------------------------------
+    Every live allocation must be movable
+    ------------------------------------------------------*/
+    for( block = pool->tlsf.head_blocks; block; block = block->next )
+        {
+        if( !block->is_free
+         && !block->is_being_freed
+         && !block->user )
+            {
+            break;
+            }
+        }
+
+    if( block )
+        {
+        continue;
+        }
+
+    /*------------------------------------------------------
+    Its siblings must have room for it with a pool's worth to
+    spare, else the next loads would just create it again
+    ------------------------------------------------------*/
+    room        = 0;
+    sibling_cnt = 0;
+    for( sibling = memory->state.head_pools; sibling; sibling = sibling->next )
+        {
+        if( sibling != pool
+         && !sibling->is_evacuating
+         && sibling->memory_index == pool->memory_index
+         && sibling->usage == pool->usage )
+            {
+            room += sibling->tlsf.free_size;
+            sibling_cnt++;
+            }
+        }
+
+    if( sibling_cnt
+     && room >= used + pool->tlsf.size )
+        {
+        ret = pool;
+        }
+    }
+
+return( ret );
+
+}   /* find_source() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       finish_moves
+*
+*   DESCRIPTION:
+*       The batch's copies are done.  Patch each holder to its new
+*       memory and free the old through the frame ring.
+*
+*********************************************************************/
+
+static void finish_moves
+    (
+    VKN_releaser_type  *releaser,   /* release buffer for old       */
+    VKN_memory_defrag_type
+                       *defrag      /* defragmenter                 */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_memory_allocation_type
+                       *holder;     /* holder's allocation record   */
+VKN_memory_defrag_move_type
+                       *move;       /* move iterator                */
+
+if( VKN_failed( vkResetFences( defrag->state.logical, 1, &defrag->state.fence ) ) )
+    {
+    debug_assert_always();
+    }
+
+defrag->state.in_flight = FALSE;
+
+for( move = defrag->state.moves; move; move = defrag->state.moves )
+    {
+    defrag->state.moves = move->next;
+
+    holder = (VKN_memory_allocation_type *)move->from->user;
+    if( !holder )
+        {
+        /*--------------------------------------------------
+        Holder deallocated it mid-move, and has released the
+        resource it made on BEGIN.  Drop both blocks.
+        --------------------------------------------------*/
+        defer_free( move->from, defrag->state.memory );
+        defer_free( move->to.block, defrag->state.memory );
+        }
+    else
+        {
+        /*--------------------------------------------------
+        Point the holder at the new memory, and let it adopt
+        the resource it bound there
+        --------------------------------------------------*/
+        debug_assert( holder->block == move->from );
+        defer_free( move->from, defrag->state.memory );
+
+        *holder = move->to;
+        holder->block->user = holder;
+        holder->relocate( VKN_MEMORY_RELOCATE_COMMIT, holder, VK_NULL_HANDLE, releaser, holder->relocate_user );
+
+        defrag->state.report.move_cnt++;
+        defrag->state.report.moved_size += holder->size;
+        }
+
+    SlabAllocator_Free( move, &defrag->state.move_slab );
+    }
+
+}   /* finish_moves() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       get_report
+*
+*********************************************************************/
+
+static void get_report
+    (
+    const struct _VKN_memory_defrag_type
+                       *defrag,     /* defragmenter                 */
+    VKN_memory_defrag_report_type
+                       *report      /* output current pass report   */
+    )
+{
+*report = defrag->state.report;
+
+}   /* get_report() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       measure
+*
+*********************************************************************/
+
+static void measure
+    (
+    const VKN_memory_type
+                       *memory,     /* memory allocator             */
+    VKN_memory_fragmentation_type
+                       *out         /* output fragmentation         */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VkDeviceSize            largest_sum;/* each pool's largest free     */
+const VKN_memory_pool_type
+                       *pool;       /* pool iterator                */
+VKN_tlsf_stats_type     stats;      /* pool statistics              */
+
+clr_struct( out );
+largest_sum = 0;
+for( pool = memory->state.head_pools; pool; pool = pool->next )
+    {
+    VKN_tlsf_get_stats( &pool->tlsf, &stats );
+
+    out->pool_cnt++;
+    out->free_block_cnt += stats.free_block_cnt;
+    out->size           += stats.size;
+    out->free_size      += stats.free_size;
+    largest_sum         += stats.largest_free_size;
+    out->largest_free_size = VKN_size_max( out->largest_free_size, stats.largest_free_size );
+    }
+
+if( out->free_size )
+    {
+    out->fragmentation = 1.0f - (float)largest_sum / (float)out->free_size;
+    }
+
+}   /* measure() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       record_moves
+*
+*   DESCRIPTION:
+*       Move up to a frame's budget of allocations out of the pool
+*       being evacuated, and submit the copies.  Returns FALSE if
+*       the pool can't be emptied.
+*
+*********************************************************************/
+
+static bool record_moves
+    (
+    VKN_releaser_type  *releaser,   /* release buffer for cancels   */
+    VKN_memory_defrag_type
+                       *defrag      /* defragmenter                 */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VkCommandBufferBeginInfo
+                        begin;      /* begin command writing        */
+VKN_tlsf_block_type    *block;      /* block iterator               */
+VKN_memory_allocation_type
+                       *holder;     /* holder's allocation record   */
+bool                    is_recording;
+                                    /* has the batch begun?         */
+VkMemoryBarrier         mem_barrier;/* global memory barrier        */
+VKN_memory_defrag_move_type
+                       *move;       /* new move                     */
+VkDeviceSize            moved;      /* bytes moved this frame       */
+bool                    ret;        /* return pool can be emptied   */
+VkSubmitInfo            submit;     /* queue submission info        */
+
+clr_struct( &begin );
+begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+/*----------------------------------------------------------
+Move the live blocks in address order.  The first always goes
+so a block bigger than the budget still moves.
+----------------------------------------------------------*/
+ret          = TRUE;
+is_recording = FALSE;
+moved        = 0;
+for( block = defrag->state.source->tlsf.head_blocks; block; block = block->next )
+    {
+    if( block->is_free
+     || block->is_being_freed
+     || block->is_being_moved )
+        {
+        continue;
+        }
+
+    holder = (VKN_memory_allocation_type *)block->user;
+    if( !holder )
+        {
+        /*--------------------------------------------------
+        Pinned since the pass began
+        --------------------------------------------------*/
+        ret = FALSE;
+        break;
+        }
+
+    if( moved
+     && moved + holder->size > defrag->state.frame_budget )
+        {
+        break;
+        }
+
+    move = SlabAllocator_New( VKN_memory_defrag_move_type, &defrag->state.move_slab );
+    if( !move )
+        {
+        break;
+        }
+
+    if( !allocate_destination( holder, defrag->state.source, defrag->state.memory, &move->to ) )
+        {
+        SlabAllocator_Free( move, &defrag->state.move_slab );
+        ret = FALSE;
+        break;
+        }
+
+    if( !is_recording )
+        {
+        if( VKN_failed( vkBeginCommandBuffer( defrag->state.commands, &begin ) ) )
+            {
+            debug_assert_always();
+            VKN_tlsf_free( move->to.block );
+            SlabAllocator_Free( move, &defrag->state.move_slab );
+            ret = FALSE;
+            break;
+            }
+
+        is_recording = TRUE;
+
+        /*--------------------------------------------------
+        Wait for earlier writes to the resources, e.g. their
+        uploads, which the submits before this one waited on
+        --------------------------------------------------*/
+        clr_struct( &mem_barrier );
+        mem_barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        mem_barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        mem_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT
+                                  | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier( defrag->state.commands,
+                              VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              0,/* flags */
+                              1,
+                              &mem_barrier,
+                              0,
+                              NULL,/* buffer barriers */
+                              0,
+                              NULL );/* image barriers */
+        }
+
+    /*------------------------------------------------------
+    Holder binds a new resource at the new memory, and records
+    the copy to it
+    ------------------------------------------------------*/
+    if( !holder->relocate( VKN_MEMORY_RELOCATE_BEGIN, &move->to, defrag->state.commands, releaser, holder->relocate_user ) )
+        {
+        VKN_tlsf_free( move->to.block );
+        SlabAllocator_Free( move, &defrag->state.move_slab );
+        ret = FALSE;
+        break;
+        }
+
+    block->is_being_moved = TRUE;
+    move->from = block;
+    move->next = defrag->state.moves;
+    defrag->state.moves = move;
+
+    moved += holder->size;
+    }
+
+if( !defrag->state.moves )
+    {
+    /*------------------------------------------------------
+    The first holder refused its move, so don't leave the
+    command buffer recording
+    ------------------------------------------------------*/
+    if( is_recording
+     && VKN_failed( vkResetCommandBuffer( defrag->state.commands, 0 ) ) )
+        {
+        debug_assert_always();
+        }
+
+    return( ret );
+    }
+
+/*----------------------------------------------------------
+Make the copies visible to whatever reads the resources next
+----------------------------------------------------------*/
+clr_struct( &mem_barrier );
+mem_barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+mem_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+mem_barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT
+                          | VK_ACCESS_MEMORY_WRITE_BIT;
+
+vkCmdPipelineBarrier( defrag->state.commands,
+                      VK_PIPELINE_STAGE_TRANSFER_BIT,
+                      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                      0,/* flags */
+                      1,
+                      &mem_barrier,
+                      0,
+                      NULL,/* buffer barriers */
+                      0,
+                      NULL );/* image barriers */
+
+/*----------------------------------------------------------
+Submit
+----------------------------------------------------------*/
+clr_struct( &submit );
+submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+submit.commandBufferCount = 1;
+submit.pCommandBuffers    = &defrag->state.commands;
+
+if( VKN_failed( vkEndCommandBuffer( defrag->state.commands ) )
+ || VKN_failed( vkQueueSubmit( defrag->state.queue, 1, &submit, defrag->state.fence ) ) )
+    {
+    /*------------------------------------------------------
+    Nothing was copied, so undo the batch
+    ------------------------------------------------------*/
+    debug_assert_always();
+    for( move = defrag->state.moves; move; move = defrag->state.moves )
+        {
+        defrag->state.moves = move->next;
+
+        holder = (VKN_memory_allocation_type *)move->from->user;
+        holder->relocate( VKN_MEMORY_RELOCATE_CANCEL, &move->to, VK_NULL_HANDLE, releaser, holder->relocate_user );
+
+        move->from->is_being_moved = FALSE;
+        VKN_tlsf_free( move->to.block );
+        SlabAllocator_Free( move, &defrag->state.move_slab );
+        }
+
+    return( FALSE );
+    }
+
+defrag->state.in_flight = TRUE;
+
+return( ret );
+
+}   /* record_moves() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       retire_pool
+*
+*   DESCRIPTION:
+*       Take the empty pool out of service, and free its memory
+*       once the GPU is done with this frame.
+*
+*********************************************************************/
+
+static void retire_pool
+    (
+    VKN_memory_pool_type
+                       *pool,       /* empty pool to retire         */
+    VKN_memory_type    *memory      /* memory allocator             */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_memory_pool_type  **head;       /* used head                    */
+
+for( head = &memory->state.head_pools; *head != pool; head = &(*head)->next );
+*head = pool->next;
+
+pool->next = memory->state.retired[ memory->state.frame_index ];
+memory->state.retired[ memory->state.frame_index ] = pool;
+
+}   /* retire_pool() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       set_allocation_callbacks
+*
+*********************************************************************/
+
+static VKN_MEMORY_DEFRAG_CONFIG_API set_allocation_callbacks
+    (
+    VkAllocationCallbacks
+                       *allocator,  /* custom allocator             */
+    struct _VKN_memory_defrag_build_type
+                       *builder     /* defragmenter builder         */
+    )
+{
+builder->state.allocator = allocator;
+
+return( builder->config );
+
+}   /* set_allocation_callbacks() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       set_frame_budget
+*
+*********************************************************************/
+
+static VKN_MEMORY_DEFRAG_CONFIG_API set_frame_budget
+    (
+    const VkDeviceSize  budget,     /* most bytes to move per frame */
+    struct _VKN_memory_defrag_build_type
+                       *builder     /* defragmenter builder         */
+    )
+{
+builder->state.frame_budget = budget;
+
+return( builder->config );
+
+}   /* set_frame_budget() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       set_sparse_percent
+*
+*********************************************************************/
+
+static VKN_MEMORY_DEFRAG_CONFIG_API set_sparse_percent
+    (
+    const u32           percent,    /* most used to evacuate a pool */
+    struct _VKN_memory_defrag_build_type
+                       *builder     /* defragmenter builder         */
+    )
+{
+builder->state.sparse_percent = percent;
+
+return( builder->config );
+
+}   /* set_sparse_percent() */
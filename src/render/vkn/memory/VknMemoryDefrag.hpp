@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Global.hpp"
+
+#include "VknMemoryDefragTypes.hpp"
+#include "VknMemoryTypes.hpp"
+#include "VknReleaserTypes.hpp"
+
+
+bool VKN_memory_defrag_create
+    (
+    const VKN_memory_defrag_build_type
+                       *builder,    /* defragmenter builder         */
+    VKN_memory_defrag_type
+                       *defrag      /* output new defragmenter      */
+    );
+
+void VKN_memory_defrag_destroy
+    (
+    VKN_releaser_type  *releaser,   /* release buffer               */
+    VKN_memory_defrag_type
+                       *defrag      /* defragmenter to destroy      */
+    );
+
+VKN_MEMORY_DEFRAG_CONFIG_API VKN_memory_defrag_init_builder
+    (
+    const VkDevice      logical,    /* associated logical device    */
+    const VkQueue       queue,      /* queue on which to copy       */
+    const u32           queue_index,/* family index of copy queue   */
+    VKN_memory_type    *memory,     /* memory allocator             */
+    VKN_memory_defrag_build_type
+                       *builder     /* defragmenter builder         */
+    );
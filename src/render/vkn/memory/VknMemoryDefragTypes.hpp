@@ -0,0 +1,164 @@
+#pragma once
+
+#include "Global.hpp"
+#include "SlabAllocator.hpp"
+
+#include "VknCommon.hpp"
+#include "VknMemoryTypes.hpp"
+#include "VknReleaserTypes.hpp"
+
+
+#define VKN_MEMORY_DEFRAG_CONFIG_API \
+                                    const struct _VKN_memory_defrag_build_config_type *
+
+
+typedef VKN_MEMORY_DEFRAG_CONFIG_API VKN_memory_defrag_build_set_allocation_callbacks_proc_type
+    (
+    VkAllocationCallbacks
+                       *allocator,  /* custom allocator             */
+    struct _VKN_memory_defrag_build_type
+                       *builder     /* defragmenter builder         */
+    );
+
+typedef VKN_MEMORY_DEFRAG_CONFIG_API VKN_memory_defrag_build_set_frame_budget_proc_type
+    (
+    const VkDeviceSize  budget,     /* most bytes to move per frame */
+    struct _VKN_memory_defrag_build_type
+                       *builder     /* defragmenter builder         */
+    );
+
+typedef VKN_MEMORY_DEFRAG_CONFIG_API VKN_memory_defrag_build_set_sparse_percent_proc_type
+    (
+    const u32           percent,    /* most used to evacuate a pool */
+    struct _VKN_memory_defrag_build_type
+                       *builder     /* defragmenter builder         */
+    );
+
+typedef struct _VKN_memory_defrag_build_config_type
+    {
+    VKN_memory_defrag_build_set_allocation_callbacks_proc_type
+                       *set_allocation_callbacks;
+                                    /* set custom allocator         */
+    VKN_memory_defrag_build_set_frame_budget_proc_type
+                       *set_frame_budget;
+                                    /* set bytes moved per frame    */
+    VKN_memory_defrag_build_set_sparse_percent_proc_type
+                       *set_sparse_percent;
+                                    /* set sparse pool threshold    */
+    } VKN_memory_defrag_build_config_type;
+
+typedef struct
+    {
+    u32                 queue_index;/* family index of submit queue */
+    u32                 sparse_percent;
+                                    /* most used to evacuate a pool */
+    VkAllocationCallbacks
+                       *allocator;  /* custom allocator             */
+    VKN_memory_type    *memory;     /* device memory allocator      */
+    VkDevice            logical;    /* logical device               */
+    VkQueue             queue;      /* queue on which to copy       */
+    VkDeviceSize        frame_budget;
+                                    /* most bytes to move per frame */
+    } VKN_memory_defrag_build_state_type;
+
+typedef struct _VKN_memory_defrag_build_type
+    {
+    VKN_memory_defrag_build_state_type
+                        state;      /* builder state                */
+    const VKN_memory_defrag_build_config_type
+                       *config;     /* configuration interface      */
+    } VKN_memory_defrag_build_type;
+
+typedef struct
+    {
+    u32                 pool_cnt;   /* pools in use                 */
+    u32                 free_block_cnt;
+                                    /* free blocks in all pools     */
+    VkDeviceSize        size;       /* memory in all pools          */
+    VkDeviceSize        free_size;  /* free memory in all pools     */
+    VkDeviceSize        largest_free_size;
+                                    /* largest single free block    */
+    float               fragmentation;
+                                    /* share of free memory outside */
+                                    /* each pool's largest block    */
+    } VKN_memory_fragmentation_type;
+
+typedef struct
+    {
+    u32                 move_cnt;   /* allocations moved            */
+    u32                 retire_cnt; /* pools emptied and freed      */
+    VkDeviceSize        moved_size; /* bytes moved                  */
+    VKN_memory_fragmentation_type
+                        before;     /* when this pass began         */
+    VKN_memory_fragmentation_type
+                        after;      /* after the latest moves       */
+    } VKN_memory_defrag_report_type;
+
+typedef void VKN_memory_defrag_begin_frame_proc_type
+    (
+    VKN_releaser_type  *releaser,   /* this frame's release buffer  */
+    struct _VKN_memory_defrag_type
+                       *defrag      /* defragmenter                 */
+    );
+
+typedef void VKN_memory_defrag_get_report_proc_type
+    (
+    const struct _VKN_memory_defrag_type
+                       *defrag,     /* defragmenter                 */
+    VKN_memory_defrag_report_type
+                       *report      /* output current pass report   */
+    );
+
+typedef struct
+    {
+    VKN_memory_defrag_begin_frame_proc_type
+                       *begin_frame;/* move this frame's budget     */
+    VKN_memory_defrag_get_report_proc_type
+                       *get_report; /* report on the current pass   */
+    } VKN_memory_defrag_api_type;
+
+typedef struct _VKN_memory_defrag_move_type
+    {
+    VKN_tlsf_block_type
+                       *from;       /* block being moved            */
+    VKN_memory_allocation_type
+                        to;         /* memory being moved to        */
+    struct _VKN_memory_defrag_move_type
+                       *next;       /* next move in the batch       */
+    } VKN_memory_defrag_move_type;
+
+typedef struct
+    {
+    bool                in_flight : 1;
+                                    /* are the copies in-flight?    */
+    u32                 queue_index;/* family index of submit queue */
+    u32                 sparse_percent;
+                                    /* most used to evacuate a pool */
+    u32                 idle_frames;/* frames before the next pass  */
+    VkAllocationCallbacks
+                       *allocator;  /* custom allocator             */
+    VKN_memory_type    *memory;     /* device memory allocator      */
+    VkDevice            logical;    /* logical device               */
+    VkQueue             queue;      /* queue on which to copy       */
+    VkDeviceSize        frame_budget;
+                                    /* most bytes to move per frame */
+    VkCommandPool       command_pool;
+                                    /* command buffer pool          */
+    VkCommandBuffer     commands;   /* copy commands                */
+    VkFence             fence;      /* copies finished fence        */
+    VKN_memory_pool_type
+                       *source;     /* pool being evacuated         */
+    VKN_memory_defrag_move_type
+                       *moves;      /* moves in-flight              */
+    SlabAllocator       move_slab;  /* move storage                 */
+    VKN_memory_defrag_report_type
+                        report;     /* current pass report          */
+    } VKN_memory_defrag_state_type;
+
+typedef struct _VKN_memory_defrag_type
+    {
+    const VKN_memory_defrag_api_type
+                       *i;          /* defragmenter interface       */
+    VKN_memory_defrag_state_type
+                        state;      /* defragmenter state           */
+    } VKN_memory_defrag_type;
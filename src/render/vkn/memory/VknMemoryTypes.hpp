@@ -1,13 +1,13 @@
 #pragma once
 
 #include "Global.hpp"
+#include "SlabAllocator.hpp"
 
 #include "VknCommon.hpp"
+#include "VknReleaserTypes.hpp"
+#include "VknTlsfTypes.hpp"
 
 
-#define VKN_MEMORY_MAX_BLOCK_CNT    ( 2000 )
-#define VKN_MEMORY_MAX_POOL_CNT     ( 20 )
-
 #define VKN_MEMORY_CONFIG_API       const struct _VKN_memory_build_config_type *
 
 typedef enum
@@ -19,6 +19,17 @@ typedef enum
     VKN_MEMORY_HEAP_USAGE_CNT
     } VKN_memory_heap_usage_type;
 
+typedef enum
+    {
+    VKN_MEMORY_PRIORITY_LOW,        /* host-visible pools, first to */
+                                    /* leave a heap over budget     */
+    VKN_MEMORY_PRIORITY_NORMAL,     /* shared device pools          */
+    VKN_MEMORY_PRIORITY_HIGH,       /* dedicated allocations, kept  */
+                                    /* even over budget             */
+    /* count */
+    VKN_MEMORY_PRIORITY_CNT
+    } VKN_memory_priority_type;
+
 
 typedef VKN_MEMORY_CONFIG_API VKN_memory_build_set_allocation_callbacks_proc_type
     (
@@ -28,15 +39,29 @@ typedef VKN_MEMORY_CONFIG_API VKN_memory_build_set_allocation_callbacks_proc_typ
                        *builder     /* memory allocator builder     */
     );
 
+typedef VKN_MEMORY_CONFIG_API VKN_memory_build_set_device_extensions_proc_type
+    (
+    const char * const *extensions, /* enabled extension names      */
+    const u32           extension_cnt,
+                                    /* number of extension names    */
+    struct _VKN_memory_build_type
+                       *builder     /* memory allocator builder     */
+    );
+
 typedef struct _VKN_memory_build_config_type
     {
     VKN_memory_build_set_allocation_callbacks_proc_type
                        *set_allocation_callbacks;
                                     /* set custom allocator         */
+    VKN_memory_build_set_device_extensions_proc_type
+                       *set_device_extensions;
+                                    /* set enabled device extensions*/
     } VKN_memory_build_config_type;
 
 typedef struct
     {
+    bool                has_memory_budget : 1;
+                                    /* VK_EXT_memory_budget enabled?*/
     VkInstance          instance;   /* associated Vulkan instance   */
     VkPhysicalDevice    physical;   /* associated physical device   */
     VkDevice            logical;    /* associated logical device    */
@@ -54,16 +79,49 @@ typedef struct _VKN_memory_build_type
                        *config;     /* configuration interface      */
     } VKN_memory_build_type;
 
+typedef enum
+    {
+    VKN_MEMORY_RELOCATE_BEGIN,      /* create and bind resource at  */
+                                    /* new memory, record its copy  */
+    VKN_MEMORY_RELOCATE_COMMIT,     /* copy done, adopt the new     */
+                                    /* resource and free the old    */
+    VKN_MEMORY_RELOCATE_CANCEL,     /* copy abandoned, free the new */
+                                    /* resource                     */
+    /* count */
+    VKN_MEMORY_RELOCATE_CNT
+    } VKN_memory_relocate_stage_type;
+
+
+typedef bool VKN_memory_relocate_proc_type
+    (
+    const VKN_memory_relocate_stage_type
+                        stage,      /* step of the move             */
+    const struct _VKN_memory_allocation_type
+                       *moved_to,   /* memory being moved to        */
+    const VkCommandBuffer
+                        commands,   /* copy commands, on BEGIN      */
+    VKN_releaser_type  *releaser,   /* releases replaced resources  */
+    void               *user        /* holder's data                */
+    );
+
 typedef struct _VKN_memory_allocation_type
     {
-    u32                 pool_id;    /* pool to which this belongs   */
-    u32                 block_id;   /* block to which this belongs  */
+    VKN_tlsf_block_type
+                       *block;      /* block to which this belongs  */
+    u32                 block_id;   /* id of block when allocated   */
     u32                 size;       /* allocation size              */
+    u32                 alignment;  /* allocation alignment         */
+    VKN_memory_priority_type
+                        priority;   /* eviction class               */
     VkDeviceSize        offset;     /* memory offset                */
     char               *mapping;    /* host mapping                 */
     struct _VKN_memory_allocation_type
                        *next;       /* deferred destruction         */
     VkDeviceMemory      memory;     /* memory allocation            */
+    VKN_memory_relocate_proc_type
+                       *relocate;   /* moves holder's resource      */
+    void               *relocate_user;
+                                    /* holder's data for relocate   */
     } VKN_memory_allocation_type;
 
 typedef bool VKN_memory_allocate_proc_type
@@ -115,6 +173,47 @@ typedef void VKN_memory_deallocate_proc_type
                        *allocation  /* allocation to deallocate     */
     );
 
+typedef void VKN_memory_set_relocatable_proc_type
+    (
+    VKN_memory_relocate_proc_type
+                       *relocate,   /* move callback, NULL to pin   */
+    void               *user,       /* holder's data for relocate   */
+    struct _VKN_memory_type
+                       *allocator,  /* memory allocator             */
+    VKN_memory_allocation_type
+                       *allocation  /* allocation to make movable   */
+    );
+
+typedef struct
+    {
+    u32                 heap_index; /* heap the usage prefers       */
+    VkDeviceSize        budget;     /* heap budget for this process */
+    VkDeviceSize        usage;      /* heap usage by this process   */
+    VkDeviceSize        headroom;   /* budget left in the heap      */
+    VkDeviceSize        allocated;  /* memory held for the usage... */
+    VkDeviceSize        used;       /* ...of which is allocated...  */
+    VkDeviceSize        spilled;    /* ...of which is outside the   */
+                                    /* preferred heap               */
+    VkDeviceSize        dedicated;  /* ...of which is dedicated     */
+    VkDeviceSize        priority_size[ VKN_MEMORY_PRIORITY_CNT ];
+                                    /* memory held by eviction class*/
+    } VKN_memory_budget_type;
+
+typedef struct
+    {
+    VKN_memory_budget_type
+                        usages[ VKN_MEMORY_HEAP_USAGE_CNT ];
+                                    /* budget for each heap usage   */
+    } VKN_memory_budget_report_type;
+
+typedef void VKN_memory_get_budget_report_proc_type
+    (
+    const struct _VKN_memory_type
+                       *allocator,  /* memory allocator             */
+    VKN_memory_budget_report_type
+                       *report      /* output budget report         */
+    );
+
 typedef struct
     {
     VKN_memory_allocate_proc_type
@@ -129,80 +228,79 @@ typedef struct
                                     /* back image w/ device memory  */
     VKN_memory_deallocate_proc_type
                        *deallocate; /* free an allocation           */
+    VKN_memory_get_budget_report_proc_type
+                       *get_budget_report;
+                                    /* report memory against budget */
+    VKN_memory_set_relocatable_proc_type
+                       *set_relocatable;
+                                    /* let defragmenter move it     */
     } VKN_memory_api_type;
 
-typedef struct _VKN_memory_block_type
-    {
-    bool                is_utilized : 1;
-                                    /* is this block being used?    */
-    bool                is_being_freed : 1;
-                                    /* is block being freed?        */
-    u32                 block_id;   /* unique block identifier      */
-    u32                 pool_id;    /* owning pool identifier       */
-    struct _VKN_memory_block_type
-                       *prev;       /* previous block               */
-    struct _VKN_memory_block_type
-                       *next;       /* next block                   */
-    struct _VKN_memory_block_type
-                       *next_destroy;
-                                    /* destruction ordered by offset*/
-    VkDeviceSize        offset;     /* memory offset                */
-    VkDeviceSize        size;       /* memory size                  */
-    } VKN_memory_block_type;
-
 typedef struct _VKN_memory_pool_type
     {
+    bool                is_evacuating : 1;
+                                    /* being emptied by defragmenter*/
+    bool                is_dedicated : 1;
+                                    /* holds a single resource?     */
     u32                 pool_id;    /* unique pool identifier       */
     u32                 memory_index;
                                     /* memory type index            */
     struct _VKN_memory_pool_type
                        *next;       /* next pool                    */
     char               *mapping;    /* host mapping                 */
-    VKN_memory_block_type
-                       *head_blocks;/* used blocks                  */
+    VKN_tlsf_type       tlsf;       /* suballocator                 */
     VKN_memory_heap_usage_type
                         usage;      /* how this pool is to be used  */
+    VKN_memory_priority_type
+                        priority;   /* eviction class               */
     VkDeviceMemory      memory;     /* memory allocation            */
     VkDeviceSize        size;       /* memory size                  */
     VkDeviceSize        min_alignment;
                                     /* minimum alignment for pool   */
-    VkDeviceSize        min_block_size;
-                                    /* minimum block size allowed   */
     } VKN_memory_pool_type;
 
 typedef struct
     {
     bool                is_discrete : 1;
                                     /* GPU is discrete?             */
+    bool                has_memory_budget : 1;
+                                    /* VK_EXT_memory_budget enabled?*/
     u8                  frame_index;/* current frame index          */
     u32                 next_pool_id;
                                     /* id of the next pool          */
     u32                 next_block_id;
                                     /* id of the next block         */
+    VkPhysicalDevice    physical;   /* physical device              */
     VkDevice            logical;    /* logical device               */
     const VkAllocationCallbacks
                        *allocator;  /* allocation callbacks         */
-    VKN_memory_pool_type
-                       *free_pools; /* unused pools                 */
+    SlabAllocator       pool_slab;  /* pool storage                 */
     VKN_memory_pool_type
                        *head_pools; /* used pools                   */
-    VKN_memory_block_type
-                       *free_blocks;/* unused blocks                */
-    VKN_memory_block_type
+    VKN_memory_pool_type
+                       *head_dedicated;
+                                    /* dedicated allocation pools   */
+    SlabAllocator       block_slab; /* block storage, for all pools */
+    VKN_tlsf_block_type
                        *to_destroy[ VKN_FRAME_CNT ];
                                     /* deferred destruction         */
-    VkDeviceSize        heap_remaining[ VK_MAX_MEMORY_HEAPS ];
-                                    /* remaining heap sizes         */
+    VKN_memory_pool_type
+                       *retired[ VKN_FRAME_CNT ];
+                                    /* deferred pool destruction    */
+    VkDeviceSize        heap_budget[ VK_MAX_MEMORY_HEAPS ];
+                                    /* heap budgets at last query   */
+    VkDeviceSize        heap_usage[ VK_MAX_MEMORY_HEAPS ];
+                                    /* heap usages at last query    */
+    VkDeviceSize        heap_allocated[ VK_MAX_MEMORY_HEAPS ];
+                                    /* memory this allocator holds  */
+    VkDeviceSize        heap_queried[ VK_MAX_MEMORY_HEAPS ];
+                                    /* heap_allocated at last query */
+    u32                 usage_heap[ VKN_MEMORY_HEAP_USAGE_CNT ];
+                                    /* heap each usage prefers      */
     VkDeviceSize        heap_pool_size[ VK_MAX_MEMORY_HEAPS ];
                                     /* pool size for each heap      */
     VkDeviceSize        noncoherent_atom_size;
                                     /* smallest block size          */
-    VKN_memory_block_type
-                        blocks[ VKN_MEMORY_MAX_BLOCK_CNT ];
-                                    /* block storage                */
-    VKN_memory_pool_type
-                        pools[ VKN_MEMORY_MAX_POOL_CNT ];
-                                    /* pool storage                 */
     VkPhysicalDeviceMemoryProperties/* device memory properties     */
                         memory_props;
     } VKN_memory_state_type;
@@ -0,0 +1,705 @@
+#include <cstring>
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+#include "Global.hpp"
+#include "SlabAllocator.hpp"
+#include "Utilities.hpp"
+
+#include "VknTlsf.hpp"
+#include "VknTlsfTypes.hpp"
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       highest_bit
+*
+*********************************************************************/
+
+static __inline u32 highest_bit
+    (
+    const u64           mask        /* non-zero bits to scan        */
+    )
+{
+#if defined( _MSC_VER )
+unsigned long           index;      /* bit index                    */
+
+_BitScanReverse64( &index, mask );
+return( (u32)index );
+#else
+return( (u32)( 63 - __builtin_clzll( mask ) ) );
+#endif
+
+}   /* highest_bit() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       lowest_bit
+*
+*********************************************************************/
+
+static __inline u32 lowest_bit
+    (
+    const u64           mask        /* non-zero bits to scan        */
+    )
+{
+#if defined( _MSC_VER )
+unsigned long           index;      /* bit index                    */
+
+_BitScanForward64( &index, mask );
+return( (u32)index );
+#else
+return( (u32)__builtin_ctzll( mask ) );
+#endif
+
+}   /* lowest_bit() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       get_size_class
+*
+*   DESCRIPTION:
+*       Get the first and second level indices of the size class
+*       holding the given size.  Sizes below VKN_TLSF_SL_CNT get a
+*       class each, and every power of two above is split into
+*       VKN_TLSF_SL_CNT classes.
+*
+*********************************************************************/
+
+static __inline void get_size_class
+    (
+    const u64           size,       /* size to classify             */
+    u32                *fl,         /* output first level index     */
+    u32                *sl          /* output second level index    */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+u32                     msb;        /* highest set bit of size      */
+
+if( size < VKN_TLSF_SL_CNT )
+    {
+    *fl = 0;
+    *sl = (u32)size;
+    return;
+    }
+
+msb = highest_bit( size );
+*fl = msb - VKN_TLSF_SL_LOG2 + 1;
+*sl = (u32)( size >> ( msb - VKN_TLSF_SL_LOG2 ) ) - VKN_TLSF_SL_CNT;
+
+}   /* get_size_class() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       find_free
+*
+*   DESCRIPTION:
+*       Find the first free block of the smallest size class at or
+*       above the given one, by the bitmaps.
+*
+*********************************************************************/
+
+static __inline VKN_tlsf_block_type * find_free
+    (
+    u32                 fl,         /* first level index            */
+    u32                 sl,         /* second level index           */
+    const VKN_tlsf_type
+                       *tlsf        /* allocator to search          */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+u64                     fl_map;     /* usable first levels          */
+u32                     sl_map;     /* usable second levels         */
+
+sl_map = tlsf->sl_bitmap[ fl ] & ( ~0u << sl );
+if( !sl_map )
+    {
+    fl_map = tlsf->fl_bitmap & ( ~0ull << ( fl + 1 ) );
+    if( !fl_map )
+        {
+        return( NULL );
+        }
+
+    fl = lowest_bit( fl_map );
+    sl_map = tlsf->sl_bitmap[ fl ];
+    }
+
+return( tlsf->free_lists[ fl ][ lowest_bit( sl_map ) ] );
+
+}   /* find_free() */
+
+
+static VKN_tlsf_block_type * create_block
+    (
+    VKN_tlsf_type      *tlsf        /* owning allocator             */
+    );
+
+static void destroy_block
+    (
+    VKN_tlsf_block_type
+                       *block       /* block to destroy             */
+    );
+
+static void insert_free
+    (
+    VKN_tlsf_block_type
+                       *block       /* block to make free           */
+    );
+
+static void remove_free
+    (
+    VKN_tlsf_block_type
+                       *block       /* free block to take           */
+    );
+
+static void split_block
+    (
+    const u64           size,       /* size of the lower part       */
+    VKN_tlsf_block_type
+                       *block,      /* block to split               */
+    VKN_tlsf_block_type
+                       *upper       /* output upper part            */
+    );
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       VKN_tlsf_allocate
+*
+*   DESCRIPTION:
+*       Allocate a block of the given size and alignment, in constant
+*       time.  The block taken is the first in a size class whose
+*       every block fits, so no list is searched.  Returns NULL if
+*       no such block is found.
+*
+*********************************************************************/
+
+VKN_tlsf_block_type * VKN_tlsf_allocate
+    (
+    const u64           size,       /* required allocation size     */
+    const u64           alignment,  /* required allocation alignment*/
+    VKN_tlsf_type      *tlsf        /* from which to allocate       */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+u64                     block_alignment;
+                                    /* alignment to give            */
+u64                     block_size; /* size to give                 */
+u32                     fl;         /* first level index            */
+u64                     class_size; /* size rounded up to a class   */
+VKN_tlsf_block_type    *lower;      /* split off alignment padding  */
+u64                     padding;    /* wasted alignment space       */
+VKN_tlsf_block_type    *ret;        /* return allocated block       */
+u64                     search_size;/* size every block must have   */
+u32                     sl;         /* second level index           */
+VKN_tlsf_block_type    *upper;      /* split off unused space       */
+
+/*----------------------------------------------------------
+Find the size every block in a usable class must have.  Sizes
+and offsets are multiples of the granularity, so aligning wastes
+at most the alignment less the granularity.
+----------------------------------------------------------*/
+block_size      = align_size_round_up( size ? size : 1, tlsf->granularity );
+block_alignment = alignment > tlsf->granularity ? alignment : tlsf->granularity;
+debug_assert( !( block_alignment & ( block_alignment - 1 ) ) );
+
+search_size = block_size + block_alignment - tlsf->granularity;
+if( search_size > tlsf->size )
+    {
+    return( NULL );
+    }
+
+/*----------------------------------------------------------
+Take the first block of the smallest class above the size, as
+any of its blocks will do.  Failing that, try the first block of
+the size's own class, which might be big enough.
+----------------------------------------------------------*/
+ret = NULL;
+class_size = search_size;
+if( class_size >= VKN_TLSF_SL_CNT )
+    {
+    class_size += shift_bits64( highest_bit( class_size ) - VKN_TLSF_SL_LOG2, 0 );
+    }
+
+get_size_class( class_size, &fl, &sl );
+if( fl < VKN_TLSF_FL_CNT )
+    {
+    ret = find_free( fl, sl, tlsf );
+    }
+
+if( !ret )
+    {
+    get_size_class( search_size, &fl, &sl );
+    ret = tlsf->free_lists[ fl ][ sl ];
+    }
+
+if( !ret )
+    {
+    return( NULL );
+    }
+
+padding = align_size_round_up( ret->offset, block_alignment ) - ret->offset;
+if( ret->size < padding + block_size )
+    {
+    return( NULL );
+    }
+
+/*----------------------------------------------------------
+Get the blocks for any splits up front, so failing to get one
+leaves the free lists untouched
+----------------------------------------------------------*/
+lower = NULL;
+upper = NULL;
+if( padding )
+    {
+    lower = create_block( tlsf );
+    }
+
+if( ret->size > padding + block_size )
+    {
+    upper = create_block( tlsf );
+    }
+
+if( ( padding && !lower )
+ || ( ret->size > padding + block_size && !upper ) )
+    {
+    if( lower )
+        {
+        destroy_block( lower );
+        }
+
+    if( upper )
+        {
+        destroy_block( upper );
+        }
+
+    return( NULL );
+    }
+
+/*----------------------------------------------------------
+Take the block, and give back the padding and unused space
+----------------------------------------------------------*/
+remove_free( ret );
+if( lower )
+    {
+    split_block( padding, ret, lower );
+    insert_free( ret );
+    ret = lower;
+    }
+
+if( upper )
+    {
+    split_block( block_size, ret, upper );
+    insert_free( upper );
+    }
+
+ret->is_free = false;
+ret->next_pending = NULL;
+debug_assert( !( ret->offset & ( block_alignment - 1 ) ) );
+
+return( ret );
+
+}   /* VKN_tlsf_allocate() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       VKN_tlsf_create
+*
+*   DESCRIPTION:
+*       Create an allocator for the given size of memory, as one
+*       free block.  Block bookkeeping lives in the given slab, which
+*       may be shared between allocators.
+*
+*********************************************************************/
+
+bool VKN_tlsf_create
+    (
+    const u64           size,       /* size of memory to manage     */
+    const u64           granularity,/* smallest block, power of two */
+    SlabAllocator      *block_slab, /* block storage                */
+    VKN_tlsf_type      *tlsf        /* output new allocator         */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_tlsf_block_type    *block;      /* initial whole memory block   */
+
+debug_assert( granularity && !( granularity & ( granularity - 1 ) ) );
+
+clr_struct( tlsf );
+tlsf->size        = align_size_round_down( size, granularity );
+tlsf->granularity = granularity;
+tlsf->block_slab  = block_slab;
+if( !tlsf->size
+ || tlsf->size >= ( 1ull << VKN_TLSF_MAX_SIZE_LOG2 ) )
+    {
+    return( false );
+    }
+
+block = create_block( tlsf );
+if( !block )
+    {
+    return( false );
+    }
+
+block->size = tlsf->size;
+tlsf->head_blocks = block;
+insert_free( block );
+
+return( true );
+
+}   /* VKN_tlsf_create() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       VKN_tlsf_destroy
+*
+*   DESCRIPTION:
+*       Destroy the given allocator, returning all its blocks to the
+*       slab, whether they're free or not.
+*
+*********************************************************************/
+
+void VKN_tlsf_destroy
+    (
+    VKN_tlsf_type      *tlsf        /* allocator to destroy         */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_tlsf_block_type    *block;      /* block iterator               */
+VKN_tlsf_block_type    *next;       /* next block                   */
+
+for( block = tlsf->head_blocks; block; block = next )
+    {
+    next = block->next;
+    destroy_block( block );
+    }
+
+clr_struct( tlsf );
+
+}   /* VKN_tlsf_destroy() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       VKN_tlsf_free
+*
+*   DESCRIPTION:
+*       Free an allocated block, in constant time.  It merges with
+*       any free block on either side, so no two free blocks are
+*       ever neighbors.
+*
+*********************************************************************/
+
+void VKN_tlsf_free
+    (
+    VKN_tlsf_block_type
+                       *block       /* allocated block to free      */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_tlsf_block_type    *neighbor;   /* block to merge               */
+
+debug_assert( !block->is_free );
+block->is_being_freed = false;
+
+/*----------------------------------------------------------
+Merge with the block below, which survives
+----------------------------------------------------------*/
+neighbor = block->prev;
+if( neighbor
+ && neighbor->is_free )
+    {
+    remove_free( neighbor );
+    neighbor->size += block->size;
+    neighbor->next = block->next;
+    if( block->next )
+        {
+        block->next->prev = neighbor;
+        }
+
+    destroy_block( block );
+    block = neighbor;
+    }
+
+/*----------------------------------------------------------
+Merge with the block above
+----------------------------------------------------------*/
+neighbor = block->next;
+if( neighbor
+ && neighbor->is_free )
+    {
+    remove_free( neighbor );
+    block->size += neighbor->size;
+    block->next = neighbor->next;
+    if( neighbor->next )
+        {
+        neighbor->next->prev = block;
+        }
+
+    destroy_block( neighbor );
+    }
+
+insert_free( block );
+
+}   /* VKN_tlsf_free() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       VKN_tlsf_get_stats
+*
+*   DESCRIPTION:
+*       Get the allocator's usage and fragmentation.  Only the class
+*       of the largest free blocks is searched.
+*
+*********************************************************************/
+
+void VKN_tlsf_get_stats
+    (
+    const VKN_tlsf_type
+                       *tlsf,       /* allocator                    */
+    VKN_tlsf_stats_type
+                       *stats       /* output statistics            */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+const VKN_tlsf_block_type
+                       *block;      /* block iterator               */
+u32                     fl;         /* first level index            */
+
+clr_struct( stats );
+stats->size           = tlsf->size;
+stats->free_size      = tlsf->free_size;
+stats->block_cnt      = tlsf->block_cnt;
+stats->free_block_cnt = tlsf->free_block_cnt;
+
+if( !tlsf->fl_bitmap )
+    {
+    return;
+    }
+
+fl = highest_bit( tlsf->fl_bitmap );
+for( block = tlsf->free_lists[ fl ][ highest_bit( tlsf->sl_bitmap[ fl ] ) ]; block; block = block->list.next )
+    {
+    stats->largest_free_size = block->size > stats->largest_free_size ? block->size : stats->largest_free_size;
+    }
+
+}   /* VKN_tlsf_get_stats() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       create_block
+*
+*********************************************************************/
+
+static VKN_tlsf_block_type * create_block
+    (
+    VKN_tlsf_type      *tlsf        /* owning allocator             */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_tlsf_block_type    *ret;        /* return new block             */
+
+ret = SlabAllocator_New( VKN_tlsf_block_type, tlsf->block_slab );
+if( !ret )
+    {
+    return( NULL );
+    }
+
+clr_struct( ret );
+ret->tlsf = tlsf;
+tlsf->block_cnt++;
+
+return( ret );
+
+}   /* create_block() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       destroy_block
+*
+*********************************************************************/
+
+static void destroy_block
+    (
+    VKN_tlsf_block_type
+                       *block       /* block to destroy             */
+    )
+{
+block->tlsf->block_cnt--;
+SlabAllocator_Free( block, block->tlsf->block_slab );
+
+}   /* destroy_block() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       insert_free
+*
+*********************************************************************/
+
+static void insert_free
+    (
+    VKN_tlsf_block_type
+                       *block       /* block to make free           */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+u32                     fl;         /* first level index            */
+VKN_tlsf_block_type   **head;       /* size class list              */
+u32                     sl;         /* second level index           */
+VKN_tlsf_type          *tlsf;       /* owning allocator             */
+
+tlsf = block->tlsf;
+get_size_class( block->size, &fl, &sl );
+debug_assert( fl < VKN_TLSF_FL_CNT );
+
+head = &tlsf->free_lists[ fl ][ sl ];
+block->is_free   = true;
+block->list.prev = NULL;
+block->list.next = *head;
+if( *head )
+    {
+    (*head)->list.prev = block;
+    }
+
+*head = block;
+
+tlsf->sl_bitmap[ fl ] |= 1u << sl;
+tlsf->fl_bitmap       |= 1ull << fl;
+tlsf->free_size       += block->size;
+tlsf->free_block_cnt++;
+
+}   /* insert_free() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       remove_free
+*
+*********************************************************************/
+
+static void remove_free
+    (
+    VKN_tlsf_block_type
+                       *block       /* free block to take           */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+u32                     fl;         /* first level index            */
+u32                     sl;         /* second level index           */
+VKN_tlsf_type          *tlsf;       /* owning allocator             */
+
+debug_assert( block->is_free );
+tlsf = block->tlsf;
+get_size_class( block->size, &fl, &sl );
+
+if( block->list.prev )
+    {
+    block->list.prev->list.next = block->list.next;
+    }
+else
+    {
+    tlsf->free_lists[ fl ][ sl ] = block->list.next;
+    }
+
+if( block->list.next )
+    {
+    block->list.next->list.prev = block->list.prev;
+    }
+
+/*----------------------------------------------------------
+Clear the bitmaps when the class empties
+----------------------------------------------------------*/
+if( !tlsf->free_lists[ fl ][ sl ] )
+    {
+    tlsf->sl_bitmap[ fl ] &= ~( 1u << sl );
+    if( !tlsf->sl_bitmap[ fl ] )
+        {
+        tlsf->fl_bitmap &= ~( 1ull << fl );
+        }
+    }
+
+block->is_free   = false;
+block->list.prev = NULL;
+block->list.next = NULL;
+tlsf->free_size -= block->size;
+tlsf->free_block_cnt--;
+
+}   /* remove_free() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       split_block
+*
+*********************************************************************/
+
+static void split_block
+    (
+    const u64           size,       /* size of the lower part       */
+    VKN_tlsf_block_type
+                       *block,      /* block to split               */
+    VKN_tlsf_block_type
+                       *upper       /* output upper part            */
+    )
+{
+debug_assert( !block->is_free );
+debug_assert( size < block->size );
+
+upper->offset = block->offset + size;
+upper->size   = block->size - size;
+upper->prev   = block;
+upper->next   = block->next;
+if( block->next )
+    {
+    block->next->prev = upper;
+    }
+
+block->next = upper;
+block->size = size;
+
+}   /* split_block() */
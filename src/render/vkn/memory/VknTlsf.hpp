@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Global.hpp"
+#include "SlabAllocator.hpp"
+
+#include "VknTlsfTypes.hpp"
+
+
+VKN_tlsf_block_type * VKN_tlsf_allocate
+    (
+    const u64           size,       /* required allocation size     */
+    const u64           alignment,  /* required allocation alignment*/
+    VKN_tlsf_type      *tlsf        /* from which to allocate       */
+    );
+
+bool VKN_tlsf_create
+    (
+    const u64           size,       /* size of memory to manage     */
+    const u64           granularity,/* smallest block, power of two */
+    SlabAllocator      *block_slab, /* block storage                */
+    VKN_tlsf_type      *tlsf        /* output new allocator         */
+    );
+
+void VKN_tlsf_destroy
+    (
+    VKN_tlsf_type      *tlsf        /* allocator to destroy         */
+    );
+
+void VKN_tlsf_free
+    (
+    VKN_tlsf_block_type
+                       *block       /* allocated block to free      */
+    );
+
+void VKN_tlsf_get_stats
+    (
+    const VKN_tlsf_type
+                       *tlsf,       /* allocator                    */
+    VKN_tlsf_stats_type
+                       *stats       /* output statistics            */
+    );
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Global.hpp"
+#include "SlabAllocator.hpp"
+
+
+#define VKN_TLSF_SL_LOG2            ( 5 )
+#define VKN_TLSF_SL_CNT             ( 1 << VKN_TLSF_SL_LOG2 )
+                                    /* lists per power of two       */
+#define VKN_TLSF_MAX_SIZE_LOG2      ( 40 )
+#define VKN_TLSF_FL_CNT             ( VKN_TLSF_MAX_SIZE_LOG2 - VKN_TLSF_SL_LOG2 + 1 )
+                                    /* first level size classes     */
+
+typedef struct _VKN_tlsf_block_type
+    {
+    bool                is_free : 1;/* is this block unused?        */
+    bool                is_being_freed : 1;
+                                    /* owner is deferring its free  */
+    bool                is_being_moved : 1;
+                                    /* owner is relocating it       */
+    u32                 block_id;   /* owner's allocation identifier*/
+    void               *user;       /* owner's data                 */
+    struct _VKN_tlsf_type
+                       *tlsf;       /* owning allocator             */
+    struct _VKN_tlsf_block_type
+                       *prev;       /* block just below this one    */
+    struct _VKN_tlsf_block_type
+                       *next;       /* block just above this one    */
+    union
+        {
+        struct
+            {
+            struct _VKN_tlsf_block_type
+                       *prev;       /* previous in size class list  */
+            struct _VKN_tlsf_block_type
+                       *next;       /* next in size class list      */
+            } list;                 /* links while free             */
+        struct _VKN_tlsf_block_type
+                       *next_pending;
+                                    /* owner's list while used      */
+        };
+    u64                 offset;     /* memory offset                */
+    u64                 size;       /* memory size                  */
+    } VKN_tlsf_block_type;
+
+typedef struct _VKN_tlsf_type
+    {
+    u64                 size;       /* managed size                 */
+    u64                 granularity;/* power of two all sizes and   */
+                                    /* offsets are a multiple of    */
+    u64                 free_size;  /* total size of free blocks    */
+    u32                 block_cnt;  /* used and free blocks         */
+    u32                 free_block_cnt;
+                                    /* free blocks                  */
+    u64                 fl_bitmap;  /* first levels with free blocks*/
+    u32                 sl_bitmap[ VKN_TLSF_FL_CNT ];
+                                    /* second levels with free      */
+                                    /* blocks, for each first level */
+    VKN_tlsf_block_type
+                       *free_lists[ VKN_TLSF_FL_CNT ][ VKN_TLSF_SL_CNT ];
+                                    /* free blocks by size class    */
+    VKN_tlsf_block_type
+                       *head_blocks;/* block at offset zero         */
+    SlabAllocator      *block_slab; /* block storage                */
+    } VKN_tlsf_type;
+
+typedef struct
+    {
+    u64                 size;       /* managed size                 */
+    u64                 free_size;  /* total size of free blocks    */
+    u64                 largest_free_size;
+                                    /* largest single free block    */
+    u32                 block_cnt;  /* used and free blocks         */
+    u32                 free_block_cnt;
+                                    /* free blocks                  */
+    } VKN_tlsf_stats_type;
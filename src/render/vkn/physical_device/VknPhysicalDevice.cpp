@@ -219,6 +219,7 @@ for( i = 0; i < cnt_of_array( elements ); i++ )
     
 
 static VKN_physical_device_build_add_extension_proc_type add_extension;
+static VKN_physical_device_build_add_optional_extension_proc_type add_optional_extension;
 
 static bool add_extension_safe
     (
@@ -296,6 +297,8 @@ Local variables
 u32                     best_device;/* index of best device         */
 u32                     best_score; /* score of best device         */
 u32                     i;          /* loop counter                 */
+VKN_physical_device_extensions_type
+                        optional;   /* optional extension to check  */
 u32                     score;      /* score of working device      */
 
 /*----------------------------------------------------------
@@ -342,6 +345,20 @@ device->memory_props    = builder->state.found_devices.memory_props[ best_device
 device->features        = builder->state.found_devices.features[ best_device ];
 device->extensions      = builder->state.extensions;
 
+/*----------------------------------------------------------
+Enable the optional extensions the device supports
+----------------------------------------------------------*/
+clr_struct( &optional );
+optional.count = 1;
+for( i = 0; i < builder->state.optional_extensions.count; i++ )
+    {
+    optional.names[ 0 ] = builder->state.optional_extensions.names[ i ];
+    if( is_extensions_supported( &builder->state.found_devices.extensions[ best_device ], &optional ) )
+        {
+        add_extension_safe( optional.names[ 0 ], &device->extensions );
+        }
+    }
+
 link_features( &device->features );
 
 return( TRUE );
@@ -375,6 +392,7 @@ Local constants
 static const VKN_physical_device_build_config_type CONFIG =
     {
     add_extension,
+    add_optional_extension,
     set_min_memory,
     set_required_device_class,
     set_required_features
@@ -425,6 +443,31 @@ return( builder->config );
 }   /* add_extension() */
 
 
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       add_optional_extension
+*
+*   DESCRIPTION:
+*       Add an extension to enable if the chosen device supports it.
+*       It plays no part in choosing the device.
+*
+*********************************************************************/
+
+static VKN_PHYSICAL_DEVICE_CONFIG_API add_optional_extension
+    (
+    const char         *name,       /* extension name               */
+    struct _VKN_physical_device_build_type
+                       *builder     /* physical device builder      */
+    )
+{
+add_extension_safe( name, &builder->state.optional_extensions );
+
+return( builder->config );
+
+}   /* add_optional_extension() */
+
+
 /*********************************************************************
 *
 *   PROCEDURE NAME:
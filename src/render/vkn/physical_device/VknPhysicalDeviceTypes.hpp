@@ -39,6 +39,13 @@ typedef VKN_PHYSICAL_DEVICE_CONFIG_API VKN_physical_device_build_add_extension_p
                        *builder     /* physical device builder      */
     );
 
+typedef VKN_PHYSICAL_DEVICE_CONFIG_API VKN_physical_device_build_add_optional_extension_proc_type
+    (
+    const char         *name,       /* extension name               */
+    struct _VKN_physical_device_build_type
+                       *builder     /* physical device builder      */
+    );
+
 typedef VKN_PHYSICAL_DEVICE_CONFIG_API VKN_physical_device_build_set_min_memory_proc_type
     (
     const VkDeviceSize  size,       /* memory size                  */
@@ -67,6 +74,9 @@ typedef struct _VKN_physical_device_build_config_type
     VKN_physical_device_build_add_extension_proc_type
                        *add_extension;
                                     /* add requested extension      */
+    VKN_physical_device_build_add_optional_extension_proc_type
+                       *add_optional_extension;
+                                    /* add extension used if found  */
     VKN_physical_device_build_set_min_memory_proc_type
                        *set_min_memory;
                                     /* set required minimum memory  */
@@ -154,6 +164,9 @@ typedef struct
                                     /* supported extensions         */
     VKN_physical_device_extensions_type
                         extensions; /* user required extensions     */
+    VKN_physical_device_extensions_type
+                        optional_extensions;
+                                    /* user optional extensions     */
     VKN_features_type   features;   /* user required features       */
     } VKN_physical_device_build_state_type;
 
@@ -178,5 +191,6 @@ typedef struct
                         memory_props;
     VKN_features_type   features;   /* device features to enable    */
     VKN_physical_device_extensions_type
-                        extensions; /* required extensions          */
+                        extensions; /* required extensions, and     */
+                                    /* optional ones supported      */
     } VKN_physical_device_type;
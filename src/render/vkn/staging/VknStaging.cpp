@@ -6,6 +6,7 @@
 #include "VknStaging.hpp"
 
 
+static VKN_staging_acquire_proc_type acquire;
 static VKN_staging_build_add_sharing_family_proc_type add_sharing_family;
 
 static void add_sharing_family_safe
@@ -15,16 +16,52 @@ static void add_sharing_family_safe
                        *builder     /* staging builder              */
     );
 
-static void block_for_frame
+static void advance
     (
-    VKN_staging_frame_type
-                       *frame,      /* frame to block for           */
+    const VKN_staging_ticket_type
+                        completed,  /* last batch finished          */
+    VKN_staging_type   *staging     /* resource staging             */
+    );
+
+static bool begin_batch
+    (
+    const bool          can_wait,   /* may we block for a batch?    */
     VKN_staging_type   *staging     /* resource staging             */
     );
 
 static VKN_staging_flush_proc_type flush;
-static VKN_staging_build_set_frame_size_proc_type set_frame_size;
+static VKN_staging_get_wait_proc_type get_wait;
+static VKN_staging_is_complete_proc_type is_complete;
+
+static void poll
+    (
+    VKN_staging_type   *staging     /* resource staging             */
+    );
+
+static VKN_staging_release_image_proc_type release_image;
+
+static bool reserve
+    (
+    const u32           size,       /* size of the upload           */
+    const u32           alignment,  /* alignment of the upload      */
+    const bool          can_wait,   /* may we block for space?      */
+    VKN_staging_type   *staging,    /* resource staging             */
+    VKN_staging_upload_instruct_type
+                       *instruct    /* output upload instructions   */
+    );
+
+static VKN_staging_build_set_acquire_family_proc_type set_acquire_family;
+static VKN_staging_build_set_ring_size_proc_type set_ring_size;
+static VKN_staging_upload_proc_type try_upload;
 static VKN_staging_upload_proc_type upload;
+static VKN_staging_upload_split_proc_type upload_split;
+
+static bool wait_for
+    (
+    const VKN_staging_ticket_type
+                        ticket,     /* batch to wait for            */
+    VKN_staging_type   *staging     /* resource staging             */
+    );
 
 
 /*********************************************************************
@@ -44,26 +81,37 @@ bool VKN_staging_create
     VKN_staging_type   *staging     /* output new resource staging  */
     )
 {
+/*----------------------------------------------------------
+Local literals
+----------------------------------------------------------*/
+#define ACQUIRES_PER_SLAB           ( 64 )
+
 /*----------------------------------------------------------
 Local constants
 ----------------------------------------------------------*/
 static const VKN_staging_api_type API =
     {
+    acquire,
     flush,
-    upload
+    get_wait,
+    is_complete,
+    release_image,
+    try_upload,
+    upload,
+    upload_split
     };
 
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VkCommandBufferBeginInfo
-                        begin_info; /* begin command buffer         */
 VkBufferCreateInfo      ci_buffer;  /* buffer create info           */
 VkCommandPoolCreateInfo ci_pool;    /* command pool create info     */
 VkCommandBufferAllocateInfo
                         ci_command; /* command buffer create info   */
-VkFenceCreateInfo       ci_fence;   /* fence create info            */
-VKN_staging_frame_type *frame;      /* working frame                */
+VkSemaphoreCreateInfo   ci_semaphore;
+                                    /* semaphore create info        */
+VkSemaphoreTypeCreateInfo
+                        ci_type;    /* timeline semaphore info      */
 u32                     i;          /* loop counter                 */
 
 /*----------------------------------------------------------
@@ -72,12 +120,19 @@ Create the resource staging object
 clr_struct( staging );
 staging->i = &API;
 
-staging->state.logical         = builder->state.logical;
-staging->state.allocator       = builder->state.allocator;
-staging->state.queue           = builder->state.queue;
-staging->state.queue_index     = builder->state.queue_index;
-staging->state.memory          = builder->state.memory;
-staging->state.buffer_frame_sz = builder->state.buffer_frame_sz;
+staging->state.logical       = builder->state.logical;
+staging->state.allocator     = builder->state.allocator;
+staging->state.queue         = builder->state.queue;
+staging->state.queue_index   = builder->state.queue_index;
+staging->state.acquire_index = builder->state.acquire_index;
+staging->state.memory        = builder->state.memory;
+staging->state.ring_sz       = builder->state.ring_sz;
+
+if( !SlabAllocator_InitForType( VKN_staging_acquire_type, ACQUIRES_PER_SLAB, SLAB_ALLOCATOR_FLAG_NONE, &staging->state.acquire_slab ) )
+    {
+    clr_struct( staging );
+    return( FALSE );
+    }
 
 /*----------------------------------------------------------
 Create command pool
@@ -94,12 +149,30 @@ if( VKN_failed( vkCreateCommandPool( builder->state.logical, &ci_pool, builder->
     }
 
 /*----------------------------------------------------------
-Create frames
+Create the timeline which each batch signals when finished
+----------------------------------------------------------*/
+clr_struct( &ci_type );
+ci_type.sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+ci_type.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+ci_type.initialValue  = 0;
+
+clr_struct( &ci_semaphore );
+ci_semaphore.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+ci_semaphore.pNext = &ci_type;
+
+if( VKN_failed( vkCreateSemaphore( staging->state.logical, &ci_semaphore, staging->state.allocator, &staging->state.timeline ) ) )
+    {
+    VKN_staging_destroy( NULL, staging );
+    return( FALSE );
+    }
+
+/*----------------------------------------------------------
+Create the upload ring
 ----------------------------------------------------------*/
 clr_struct( &ci_buffer );
 ci_buffer.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 ci_buffer.usage                 = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-ci_buffer.size                  = builder->state.buffer_frame_sz;
+ci_buffer.size                  = builder->state.ring_sz;
 ci_buffer.pQueueFamilyIndices   = builder->state.families.indices;
 ci_buffer.queueFamilyIndexCount = builder->state.families.count;
 ci_buffer.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
@@ -108,43 +181,40 @@ if( builder->state.families.count > 1 )
     ci_buffer.sharingMode = VK_SHARING_MODE_CONCURRENT;
     }
 
+if( VKN_failed( vkCreateBuffer( staging->state.logical, &ci_buffer, staging->state.allocator, &staging->state.buffer ) )
+ || !staging->state.memory->i->create_buffer_memory( staging->state.buffer, VKN_MEMORY_HEAP_USAGE_UPLOAD, staging->state.memory, &staging->state.allocation )
+ || !staging->state.allocation.mapping )
+    {
+    VKN_staging_destroy( NULL, staging );
+    return( FALSE );
+    }
+
+VKN_name_object( staging->state.logical, staging->state.timeline, VK_OBJECT_TYPE_SEMAPHORE, "Staging_Timeline" );
+VKN_name_object( staging->state.logical, staging->state.buffer,   VK_OBJECT_TYPE_BUFFER,    "Staging_Ring" );
+
+/*----------------------------------------------------------
+Create batches
+----------------------------------------------------------*/
 clr_struct( &ci_command );
 ci_command.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 ci_command.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 ci_command.commandBufferCount = 1;
 ci_command.commandPool        = staging->state.command_pool;
 
-clr_struct( &ci_fence );
-ci_fence.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-
-clr_struct( &begin_info );
-begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-for( i = 0; i < cnt_of_array( staging->state.frames ); i++ )
+for( i = 0; i < cnt_of_array( staging->state.batches ); i++ )
     {
-    frame = &staging->state.frames[ i ];
-
-    /*----------------------------------------------------------
-    Command buffer, fence, and upload buffer
-    ----------------------------------------------------------*/
-    if( VKN_failed( vkAllocateCommandBuffers( staging->state.logical, &ci_command, &frame->commands ) )
-     || VKN_failed( vkCreateFence( staging->state.logical, &ci_fence, staging->state.allocator, &frame->fence ) )
-     || VKN_failed( vkCreateBuffer( staging->state.logical, &ci_buffer, staging->state.allocator, &frame->buffer ) )
-     || !staging->state.memory->i->create_buffer_memory( frame->buffer, VKN_MEMORY_HEAP_USAGE_UPLOAD, staging->state.memory, &frame->allocation ) )
+    if( VKN_failed( vkAllocateCommandBuffers( staging->state.logical, &ci_command, &staging->state.batches[ i ].commands ) ) )
         {
         VKN_staging_destroy( NULL, staging );
         return( FALSE );
         }
 
-    vkBeginCommandBuffer( staging->state.frames[ i ].commands, &begin_info );
-    VKN_name_object( staging->state.logical, frame->commands, VK_OBJECT_TYPE_COMMAND_BUFFER, "Staging_CmdBuff[%d]", i );
-    VKN_name_object( staging->state.logical, frame->fence,    VK_OBJECT_TYPE_FENCE,          "Staging_Fence[%d]", i );
-    VKN_name_object( staging->state.logical, frame->buffer,   VK_OBJECT_TYPE_BUFFER,         "Staging_Buffer[%d]", i );
+    VKN_name_object( staging->state.logical, staging->state.batches[ i ].commands, VK_OBJECT_TYPE_COMMAND_BUFFER, "Staging_CmdBuff[%d]", i );
     }
 
 return( TRUE );
 
+#undef ACQUIRES_PER_SLAB
 }   /* VKN_staging_create() */
 
 
@@ -154,7 +224,8 @@ return( TRUE );
 *       VKN_staging_destroy
 *
 *   DESCRIPTION:
-*       Destroy the given resource staging.
+*       Destroy the given resource staging, finishing any uploads
+*       in-flight.
 *
 *********************************************************************/
 
@@ -167,27 +238,28 @@ void VKN_staging_destroy
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VKN_staging_frame_type *frame;      /* working frame                */
 u32                     i;          /* loop counter                 */
 
+wait_for( staging->state.submitted, staging );
+
 VKN_releaser_auto_mini_begin( releaser, use );
-use->i->release_command_pool( staging->state.logical, staging->state.allocator, staging->state.command_pool, use );
-for( i = 0; i < cnt_of_array( staging->state.frames ); i++ )
+use->i->release_command_pool( staging->state.logical, staging->state.allocator, staging->state.command_pool, use )->
+        release_semaphore( staging->state.logical, staging->state.allocator, staging->state.timeline, use )->
+        release_buffer( staging->state.logical, staging->state.allocator, staging->state.buffer, use );
+for( i = 0; i < cnt_of_array( staging->state.batches ); i++ )
     {
-    frame = &staging->state.frames[ i ];
-    use->i->release_command_buffer( staging->state.logical, staging->state.command_pool, frame->commands, use )->
-            release_fence( staging->state.logical, staging->state.allocator, frame->fence, use )->
-            release_buffer( staging->state.logical, staging->state.allocator, frame->buffer, use );
+    use->i->release_command_buffer( staging->state.logical, staging->state.command_pool, staging->state.batches[ i ].commands, use );
+    }
 
-    block_for_frame( frame, staging );
-    if( staging->state.memory
-     && staging->state.memory->i )
-        {
-        staging->state.memory->i->deallocate( staging->state.memory, &frame->allocation );
-        }
+if( staging->state.memory
+ && staging->state.memory->i
+ && staging->state.allocation.block )
+    {
+    staging->state.memory->i->deallocate( staging->state.memory, &staging->state.allocation );
     }
 
 VKN_releaser_auto_mini_end( use );
+SlabAllocator_Destroy( &staging->state.acquire_slab );
 clr_struct( staging );
 
 }   /* VKN_staging_destroy() */
@@ -199,7 +271,9 @@ clr_struct( staging );
 *       VKN_staging_init_builder
 *
 *   DESCRIPTION:
-*       Initialize a resource staging builder.
+*       Initialize a resource staging builder.  Uploads are used by
+*       the submit queue's family unless another is set with
+*       set_acquire_family.
 *
 *********************************************************************/
 
@@ -216,7 +290,7 @@ VKN_STAGING_CONFIG_API VKN_staging_init_builder
 /*----------------------------------------------------------
 Local literals
 ----------------------------------------------------------*/
-#define DEFAULT_FRAME_SZ           ( 2 * 1024 * 1024 )
+#define DEFAULT_RING_SZ             ( 8 * 1024 * 1024 )
 
 /*----------------------------------------------------------
 Local constants
@@ -224,26 +298,118 @@ Local constants
 static const VKN_staging_build_config_type CONFIG =
     {
     add_sharing_family,
-    set_frame_size
+    set_acquire_family,
+    set_ring_size
     };
 
 clr_struct( builder );
 builder->config = &CONFIG;
 
-builder->state.logical         = logical;
-builder->state.memory          = memory;
-builder->state.buffer_frame_sz = DEFAULT_FRAME_SZ;
-builder->state.queue           = queue;
-builder->state.queue_index     = queue_index;
+builder->state.logical       = logical;
+builder->state.memory        = memory;
+builder->state.ring_sz       = DEFAULT_RING_SZ;
+builder->state.queue         = queue;
+builder->state.queue_index   = queue_index;
+builder->state.acquire_index = queue_index;
 
 add_sharing_family_safe( builder->state.queue_index, builder );
 
 return( builder->config );
 
-#undef DEFAULT_FRAME_SZ
+#undef DEFAULT_RING_SZ
 }   /* VKN_staging_init_builder() */
 
 
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       acquire
+*
+*   DESCRIPTION:
+*       Record the acquire half of each image ownership transfer
+*       submitted so far, and output what the acquiring submit
+*       must wait on.  Call after flush, on the acquire family.
+*
+*********************************************************************/
+
+static void acquire
+    (
+    VkCommandBuffer     commands,   /* acquiring family's commands  */
+    VKN_staging_wait_type
+                       *wait,       /* output wait for the submit   */
+    struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VkImageMemoryBarrier    barriers[ 16 ];
+                                    /* barriers to record together  */
+u32                     count;      /* barriers gathered            */
+VkPipelineStageFlags    dst_stages; /* stages gathered barriers use */
+VKN_staging_acquire_type
+                       *pending;    /* acquire being recorded       */
+
+clr_struct( wait );
+wait->semaphore = staging->state.timeline;
+wait->stages    = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+/*----------------------------------------------------------
+With one family, queue order already covers the uploads
+----------------------------------------------------------*/
+if( staging->state.queue_index == staging->state.acquire_index )
+    {
+    return;
+    }
+
+if( staging->state.submitted > staging->state.acquired )
+    {
+    wait->value = staging->state.submitted;
+    staging->state.acquired = staging->state.submitted;
+    }
+
+/*----------------------------------------------------------
+Record the acquires whose release has been submitted
+----------------------------------------------------------*/
+count      = 0;
+dst_stages = 0;
+while( staging->state.head_acquires
+    && staging->state.head_acquires->ticket <= staging->state.submitted )
+    {
+    pending = staging->state.head_acquires;
+    staging->state.head_acquires = pending->next;
+    if( !staging->state.head_acquires )
+        {
+        staging->state.tail_acquires = NULL;
+        }
+
+    barriers[ count++ ] = pending->barrier;
+    dst_stages |= pending->dst_stages;
+    SlabAllocator_Free( pending, &staging->state.acquire_slab );
+
+    if( count == cnt_of_array( barriers )
+     || !staging->state.head_acquires
+     || staging->state.head_acquires->ticket > staging->state.submitted )
+        {
+        vkCmdPipelineBarrier( commands,
+                              VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                              dst_stages,
+                              0,/* flags */
+                              0,
+                              NULL,/* memory barriers */
+                              0,
+                              NULL,/* buffer barriers */
+                              count,
+                              barriers );
+        count      = 0;
+        dst_stages = 0;
+        }
+    }
+
+}   /* acquire() */
+
+
 /*********************************************************************
 *
 *   PROCEDURE NAME:
@@ -323,14 +489,47 @@ builder->state.families.indices[ builder->state.families.count++ ] = index;
 /*********************************************************************
 *
 *   PROCEDURE NAME:
-*       block_for_frame
+*       advance
+*
+*   DESCRIPTION:
+*       Release the ring space of each batch up to the given one.
+*       Batches finish in submission order, so the tail only ever
+*       moves forward.  A batch which reserved nothing may end
+*       before the tail, if the empty ring restarted after it.
+*
+*********************************************************************/
+
+static void advance
+    (
+    const VKN_staging_ticket_type
+                        completed,  /* last batch finished          */
+    VKN_staging_type   *staging     /* resource staging             */
+    )
+{
+while( staging->state.completed < completed
+    && staging->state.completed < staging->state.submitted )
+    {
+    staging->state.completed++;
+    staging->state.tail = VKN_size_max( staging->state.tail, staging->state.batches[ staging->state.completed % cnt_of_array( staging->state.batches ) ].ring_end );
+    }
+
+}   /* advance() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       begin_batch
+*
+*   DESCRIPTION:
+*       Begin recording the next batch, if not already.  Its
+*       command buffer must have finished its previous batch.
 *
 *********************************************************************/
 
-static void block_for_frame
+static bool begin_batch
     (
-    VKN_staging_frame_type
-                       *frame,      /* frame to block for           */
+    const bool          can_wait,   /* may we block for a batch?    */
     VKN_staging_type   *staging     /* resource staging             */
     )
 {
@@ -339,51 +538,59 @@ Local variables
 ----------------------------------------------------------*/
 VkCommandBufferBeginInfo
                         begin;      /* begin command writing        */
+VKN_staging_batch_type *batch;      /* batch to begin               */
 VkMemoryBarrier         mem_barrier;/* global memory barrier        */
 
-if( !frame->in_flight )
+if( staging->state.is_recording )
     {
-    return;
+    return( TRUE );
     }
 
 /*----------------------------------------------------------
-Wait for frame to finish
+Wait for the batch's previous use to finish
 ----------------------------------------------------------*/
-if( VKN_failed( vkWaitForFences( staging->state.logical, 1, &frame->fence, VK_FALSE, VKN_WAIT_INFINITE ) ) )
+batch = &staging->state.batches[ ( staging->state.submitted + 1 ) % cnt_of_array( staging->state.batches ) ];
+if( batch->ticket > staging->state.completed )
     {
-    debug_assert_always();
+    poll( staging );
     }
 
-if( VKN_failed( vkResetFences( staging->state.logical, 1, &frame->fence ) ) )
+if( batch->ticket > staging->state.completed )
     {
-    debug_assert_always();
+    VKN_return_bfail( can_wait );
+    VKN_return_bfail( wait_for( batch->ticket, staging ) );
     }
 
-frame->in_flight = FALSE;
-frame->caret     = 0;
-
 /*----------------------------------------------------------
-Begin commands for this frame
+Begin commands for this batch
 ----------------------------------------------------------*/
 clr_struct( &begin );
 begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-if( VKN_failed( vkBeginCommandBuffer( frame->commands, &begin ) ) )
-    {
-    debug_assert_always();
-    }
+VKN_return_fail( vkBeginCommandBuffer( batch->commands, &begin ) );
+
+batch->ticket = staging->state.submitted + 1;
+staging->state.is_recording = TRUE;
 
 /*----------------------------------------------------------
 Insert a barrier at the beginning of the commands to block
-vertex/index reads until the transfer is finished
+vertex/index reads until the transfer is finished.  Another
+family's reads can't be ordered with a barrier, so there the
+user must retire a resource before uploading over it.
 ----------------------------------------------------------*/
+if( staging->state.queue_index != staging->state.acquire_index )
+    {
+    return( TRUE );
+    }
+
 clr_struct( &mem_barrier );
 mem_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
 mem_barrier.srcAccessMask = VK_ACCESS_INDEX_READ_BIT
                           | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
 mem_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 
-vkCmdPipelineBarrier( frame->commands,
+vkCmdPipelineBarrier( batch->commands,
                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
                       VK_PIPELINE_STAGE_TRANSFER_BIT,
                       0,/* flags */
@@ -394,7 +601,9 @@ vkCmdPipelineBarrier( frame->commands,
                       0,
                       NULL );/* image barriers */
 
-}   /* block_for_frame() */
+return( TRUE );
+
+}   /* begin_batch() */
 
 
 /*********************************************************************
@@ -402,9 +611,14 @@ vkCmdPipelineBarrier( frame->commands,
 *   PROCEDURE NAME:
 *       flush
 *
+*   DESCRIPTION:
+*       Submit the batch being recorded.  If that fails, the batch
+*       is dropped: its uploads never happen, its ring space is
+*       reused, and its image releases are never acquired.
+*
 *********************************************************************/
 
-static void flush
+static bool flush
     (
     struct _VKN_staging_type
                        *staging     /* resource staging to flush   */
@@ -413,123 +627,547 @@ static void flush
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VKN_staging_frame_type *frame;      /* working frame                */
+VKN_staging_batch_type *batch;      /* batch being submitted        */
 VkMemoryBarrier         mem_barrier;/* global memory barrier        */
 VkMappedMemoryRange     mem_range;  /* mapped memory to flush       */
+VKN_staging_acquire_type
+                       *kept;       /* last acquire still pending   */
+VKN_staging_acquire_type
+                       *pending;    /* acquire of a dropped release */
 VkSubmitInfo            submit;     /* queue submission info        */
+VkTimelineSemaphoreSubmitInfo
+                        submit_timeline;
+                                    /* value the batch signals      */
 
 /*----------------------------------------------------------
-Check if the current frame is empty or has already been
-submitted
+Check if there is anything to submit
 ----------------------------------------------------------*/
-frame = &staging->state.frames[ staging->state.frame_num ];
-if( !frame->caret
- || frame->in_flight )
+if( !staging->state.is_recording )
     {
-    /*------------------------------------------------------
-    Either we can't, or don't want to submit this frame, so
-    ignore
-    ------------------------------------------------------*/
-    return;
+    return( TRUE );
     }
 
+batch = &staging->state.batches[ ( staging->state.submitted + 1 ) % cnt_of_array( staging->state.batches ) ];
+
 /*----------------------------------------------------------
-Common wisdom in the graphics community is that no drivers 
-support fine-grained barriers at the per-buffer level 
-(VkBufferMemoryBarrier), and thus internally issue a global 
+Common wisdom in the graphics community is that no drivers
+support fine-grained barriers at the per-buffer level
+(VkBufferMemoryBarrier), and thus internally issue a global
 memory barrier.
 
-To avoid thrashing the pipelines we always submit a global 
-memory barrier here for buffer reads, to allow forgoing 
-VkBufferMemoryBarrier in callers (which would just issue 
+To avoid thrashing the pipelines we always submit a global
+memory barrier here for buffer reads, to allow forgoing
+VkBufferMemoryBarrier in callers (which would just issue
 repeat global memory barriers).
 
 Even though not every transfer will contain buffer uploads,
-let's do the work once here regardless.
+let's do the work once here regardless.  For another family
+the semaphore wait makes the writes visible instead, and the
+buffers must be shared with it.
 ----------------------------------------------------------*/
-clr_struct( &mem_barrier );
-mem_barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-mem_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-mem_barrier.dstAccessMask = VK_ACCESS_INDEX_READ_BIT
-                          | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+if( staging->state.queue_index == staging->state.acquire_index )
+    {
+    clr_struct( &mem_barrier );
+    mem_barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    mem_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    mem_barrier.dstAccessMask = VK_ACCESS_INDEX_READ_BIT
+                              | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+    vkCmdPipelineBarrier( batch->commands,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                          0,/* flags */
+                          1,
+                          &mem_barrier,
+                          0,
+                          NULL,/* buffer barriers */
+                          0,
+                          NULL );/* image barriers */
+    }
+
+VKN_goto_fail( vkEndCommandBuffer( batch->commands ), flush_fail );
+
+/*----------------------------------------------------------
+Make the writes available.  We use flush memory here to
+guarantee cache is written, but we could optimize perf in
+the future by exposing host coherency via the allocation
+record, and take advantage of write-combines.
+----------------------------------------------------------*/
+clr_struct( &mem_range );
+mem_range.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+mem_range.memory = staging->state.allocation.memory;
+mem_range.offset = staging->state.allocation.offset;
+mem_range.size   = staging->state.allocation.size;
+
+VKN_goto_fail( vkFlushMappedMemoryRanges( staging->state.logical, 1, &mem_range ), flush_fail );
+
+/*----------------------------------------------------------
+Submit, signaling the batch's ticket on the timeline
+----------------------------------------------------------*/
+clr_struct( &submit_timeline );
+submit_timeline.sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+submit_timeline.signalSemaphoreValueCount = 1;
+submit_timeline.pSignalSemaphoreValues    = &batch->ticket;
+
+clr_struct( &submit );
+submit.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+submit.pNext                = &submit_timeline;
+submit.commandBufferCount   = 1;
+submit.pCommandBuffers      = &batch->commands;
+submit.signalSemaphoreCount = 1;
+submit.pSignalSemaphores    = &staging->state.timeline;
+
+VKN_goto_fail( vkQueueSubmit( staging->state.queue, 1, &submit, VK_NULL_HANDLE ), flush_fail );
+
+batch->ring_end = staging->state.head;
+staging->state.submitted    = batch->ticket;
+staging->state.is_recording = FALSE;
+
+return( TRUE );
+
+/*----------------------------------------------------------
+Drop the batch, leaving its command buffer idle.  Its ring
+space follows the last batch submitted, or the restart point
+if the ring restarted since.  Pending acquires are in ticket
+order, so the batch's releases are at the end.
+----------------------------------------------------------*/
+flush_fail:
+    {
+    vkResetCommandBuffer( batch->commands, 0 );
+    batch->ticket               = 0;
+    staging->state.head         = VKN_size_max( staging->state.tail, staging->state.batches[ staging->state.submitted % cnt_of_array( staging->state.batches ) ].ring_end );
+    staging->state.is_recording = FALSE;
+
+    kept = NULL;
+    for( pending = staging->state.head_acquires; pending && pending->ticket <= staging->state.submitted; pending = pending->next )
+        {
+        kept = pending;
+        }
+
+    if( kept )
+        {
+        kept->next = NULL;
+        }
+    else
+        {
+        staging->state.head_acquires = NULL;
+        }
+
+    staging->state.tail_acquires = kept;
+    while( pending )
+        {
+        kept = pending->next;
+        SlabAllocator_Free( pending, &staging->state.acquire_slab );
+        pending = kept;
+        }
+
+    return( FALSE );
+    }
+
+}   /* flush() */
+
 
-vkCmdPipelineBarrier( frame->commands,
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       get_wait
+*
+*   DESCRIPTION:
+*       Get the semaphore and value a submit must wait on to use
+*       an upload.  The upload must have been flushed.
+*
+*********************************************************************/
+
+static void get_wait
+    (
+    const VKN_staging_ticket_type
+                        ticket,     /* upload to wait for           */
+    VKN_staging_wait_type
+                       *wait,       /* output wait for a submit     */
+    const struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    )
+{
+debug_assert( ticket <= staging->state.submitted );
+
+clr_struct( wait );
+wait->semaphore = staging->state.timeline;
+wait->value     = ticket;
+wait->stages    = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+}   /* get_wait() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       is_complete
+*
+*********************************************************************/
+
+static bool is_complete
+    (
+    const VKN_staging_ticket_type
+                        ticket,     /* upload to check              */
+    struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    )
+{
+if( ticket > staging->state.completed
+ && ticket <= staging->state.submitted )
+    {
+    poll( staging );
+    }
+
+return( ticket <= staging->state.completed );
+
+}   /* is_complete() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       poll
+*
+*********************************************************************/
+
+static void poll
+    (
+    VKN_staging_type   *staging     /* resource staging             */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+u64                     value;      /* timeline's current value     */
+
+if( staging->state.completed == staging->state.submitted )
+    {
+    return;
+    }
+
+if( VKN_failed( vkGetSemaphoreCounterValue( staging->state.logical, staging->state.timeline, &value ) ) )
+    {
+    debug_assert_always();
+    return;
+    }
+
+advance( value, staging );
+
+}   /* poll() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       release_image
+*
+*   DESCRIPTION:
+*       Record the given transition after an image's upload.  For
+*       another acquire family, this releases the image, and the
+*       matching acquire is recorded by acquire.  Returns 0 if
+*       no batch could be begun.
+*
+*********************************************************************/
+
+static VKN_staging_ticket_type release_image
+    (
+    const VkImageMemoryBarrier
+                       *barrier,    /* transition after the upload  */
+    const VkPipelineStageFlags
+                        dst_stages, /* stages which use the image   */
+    struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_staging_acquire_type
+                       *pending;    /* acquire to record later      */
+VkImageMemoryBarrier    release;    /* release barrier              */
+VkCommandBuffer         commands;   /* batch's commands             */
+
+if( !begin_batch( TRUE, staging ) )
+    {
+    return( 0 );
+    }
+
+commands = staging->state.batches[ ( staging->state.submitted + 1 ) % cnt_of_array( staging->state.batches ) ].commands;
+
+/*----------------------------------------------------------
+One family transitions the image in place
+----------------------------------------------------------*/
+release = *barrier;
+release.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+release.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+if( staging->state.queue_index == staging->state.acquire_index )
+    {
+    vkCmdPipelineBarrier( commands,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          dst_stages,
+                          0,/* flags */
+                          0,
+                          NULL,/* memory barriers */
+                          0,
+                          NULL,/* buffer barriers */
+                          1,
+                          &release );
+
+    return( staging->state.submitted + 1 );
+    }
+
+/*----------------------------------------------------------
+Otherwise release it here, and remember the acquire
+----------------------------------------------------------*/
+release.srcQueueFamilyIndex = staging->state.queue_index;
+release.dstQueueFamilyIndex = staging->state.acquire_index;
+release.dstAccessMask       = 0;
+
+vkCmdPipelineBarrier( commands,
                       VK_PIPELINE_STAGE_TRANSFER_BIT,
-                      VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
                       0,/* flags */
-                      1,
-                      &mem_barrier,
                       0,
-                      NULL,/* buffer barriers */
+                      NULL,/* memory barriers */
                       0,
-                      NULL );/* image barriers */
+                      NULL,/* buffer barriers */
+                      1,
+                      &release );
 
-if( VKN_failed( vkEndCommandBuffer( frame->commands ) ) )
+pending = SlabAllocator_New( VKN_staging_acquire_type, &staging->state.acquire_slab );
+if( !pending )
     {
     debug_assert_always();
+    return( staging->state.submitted + 1 );
+    }
+
+clr_struct( pending );
+pending->ticket     = staging->state.submitted + 1;
+pending->dst_stages = dst_stages;
+pending->barrier    = release;
+pending->barrier.srcAccessMask = 0;
+pending->barrier.dstAccessMask = barrier->dstAccessMask;
+
+if( staging->state.tail_acquires )
+    {
+    staging->state.tail_acquires->next = pending;
     }
-                     
+else
+    {
+    staging->state.head_acquires = pending;
+    }
+
+staging->state.tail_acquires = pending;
+
+return( pending->ticket );
+
+}   /* release_image() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       reserve
+*
+*   DESCRIPTION:
+*       Reserve contiguous space at the head of the ring.  Space is
+*       released as the batches which used it finish.  When full,
+*       either fail, or submit and wait for the oldest batch.
+*
+*********************************************************************/
+
+static bool reserve
+    (
+    const u32           size,       /* size of the upload           */
+    const u32           alignment,  /* alignment of the upload      */
+    const bool          can_wait,   /* may we block for space?      */
+    VKN_staging_type   *staging,    /* resource staging             */
+    VKN_staging_upload_instruct_type
+                       *instruct    /* output upload instructions   */
+    )
+{
 /*----------------------------------------------------------
-Make the writes available.  We use flush memory here to
-guarantee cache is written, but we could optimize perf in
-the future by exposing host coherency via the allocation
-record, and take advantage of write-combines.
+Local variables
 ----------------------------------------------------------*/
-clr_struct( &mem_range );
-mem_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-mem_range.memory = frame->allocation.memory;
-mem_range.offset = frame->allocation.offset;
-mem_range.size   = frame->allocation.size;
+VkDeviceSize            at;         /* head's offset in the ring    */
+VkDeviceSize            needed;     /* ring used, with padding      */
+VkDeviceSize            start;      /* aligned start of the upload  */
 
-if( VKN_failed( vkFlushMappedMemoryRanges( staging->state.logical, 1, &mem_range ) ) )
+clr_struct( instruct );
+if( staging->state.ring_sz < size )
     {
+    /*------------------------------------------------------
+    Would never be able to satisfy this request, even with
+    an empty ring
+    ------------------------------------------------------*/
     debug_assert_always();
+    return( FALSE );
     }
 
 /*----------------------------------------------------------
-Submit
+Find room, wrapping to the start of the ring if the upload
+doesn't fit before its end
 ----------------------------------------------------------*/
-clr_struct( &submit );
-submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-submit.commandBufferCount = 1;
-submit.pCommandBuffers    = &frame->commands; 
+for( ;; )
+    {
+    /*------------------------------------------------------
+    An empty ring restarts at its beginning.  Wrapping from
+    the middle can need more than the whole ring, which no
+    amount of waiting would free.
+    ------------------------------------------------------*/
+    if( staging->state.head == staging->state.tail )
+        {
+        staging->state.head = VKN_size_round_up_mult( staging->state.head, staging->state.ring_sz );
+        staging->state.tail = staging->state.head;
+        }
 
-if( VKN_failed( vkQueueSubmit( staging->state.queue, 1, &submit, frame->fence ) ) )
+    at     = staging->state.head % staging->state.ring_sz;
+    start  = VKN_size_round_up_mult( at, VKN_size_max( alignment, 1 ) );
+    needed = start - at + size;
+    if( start + size > staging->state.ring_sz )
+        {
+        start  = 0;
+        needed = staging->state.ring_sz - at + size;
+        }
+
+    if( staging->state.ring_sz - ( staging->state.head - staging->state.tail ) >= needed )
+        {
+        break;
+        }
+
+    poll( staging );
+    if( staging->state.ring_sz - ( staging->state.head - staging->state.tail ) >= needed )
+        {
+        break;
+        }
+
+    if( !can_wait )
+        {
+        return( FALSE );
+        }
+
+    /*------------------------------------------------------
+    Wait for the oldest batch, submitting the current one if
+    it holds the rest of the ring
+    ------------------------------------------------------*/
+    if( staging->state.completed == staging->state.submitted )
+        {
+        VKN_return_bfail( flush( staging ) );
+        }
+
+    if( staging->state.completed == staging->state.submitted )
+        {
+        /*--------------------------------------------------
+        Nothing in flight to wait for
+        --------------------------------------------------*/
+        debug_assert_always();
+        return( FALSE );
+        }
+
+    VKN_return_bfail( wait_for( staging->state.completed + 1, staging ) );
+    }
+
+if( !begin_batch( can_wait, staging ) )
     {
-    debug_assert_always();
+    return( FALSE );
     }
 
-frame->in_flight = TRUE;
+staging->state.head += needed;
 
 /*----------------------------------------------------------
-Advance to the next frame
+Fill out the instructions
 ----------------------------------------------------------*/
-staging->state.frame_num++;
-staging->state.frame_num %= cnt_of_array( staging->state.frames );
+instruct->ticket   = staging->state.submitted + 1;
+instruct->commands = staging->state.batches[ instruct->ticket % cnt_of_array( staging->state.batches ) ].commands;
+instruct->buffer   = staging->state.buffer;
+instruct->offset   = (u32)start;
+instruct->mapping  = &staging->state.allocation.mapping[ start ];
 
-}   /* flush() */
+return( TRUE );
+
+}   /* reserve() */
 
 
 /*********************************************************************
 *
 *   PROCEDURE NAME:
-*       set_frame_size
+*       set_acquire_family
+*
+*   DESCRIPTION:
+*       Set the queue family which uses the uploads.  If it isn't
+*       the submit queue's, images change owner through
+*       release_image and acquire, and buffers must be shared
+*       with both families.
 *
 *********************************************************************/
 
-static VKN_STAGING_CONFIG_API set_frame_size
+static VKN_STAGING_CONFIG_API set_acquire_family
     (
-    const u32           per_frame_sz,
-                                    /* buffer size of each frame    */
+    const u32           index,      /* family using the uploads     */
     struct _VKN_staging_build_type
                        *builder     /* staging builder              */
     )
 {
-builder->state.buffer_frame_sz = per_frame_sz;
+builder->state.acquire_index = index;
 
 return( builder->config );
 
-}   /* set_frame_size() */
+}   /* set_acquire_family() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       set_ring_size
+*
+*********************************************************************/
+
+static VKN_STAGING_CONFIG_API set_ring_size
+    (
+    const u32           ring_sz,    /* size of the upload ring      */
+    struct _VKN_staging_build_type
+                       *builder     /* staging builder              */
+    )
+{
+builder->state.ring_sz = ring_sz;
+
+return( builder->config );
+
+}   /* set_ring_size() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       try_upload
+*
+*   DESCRIPTION:
+*       Upload a resource if the ring has room now.  Otherwise the
+*       instructions are empty, and the caller may try again once
+*       earlier uploads finish.
+*
+*********************************************************************/
+
+static VKN_staging_upload_instruct_type try_upload
+    (
+    const u32           size,       /* size of the upload           */
+    const u32           alignment,  /* alignment of the upload      */
+    struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    )
+{
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+VKN_staging_upload_instruct_type
+                        ret;        /* return instructions          */
+
+reserve( size, alignment, FALSE, staging, &ret );
+
+return( ret );
+
+}   /* try_upload() */
 
 
 /*********************************************************************
@@ -537,6 +1175,10 @@ return( builder->config );
 *   PROCEDURE NAME:
 *       upload
 *
+*   DESCRIPTION:
+*       Upload a resource, waiting for earlier uploads to finish if
+*       the ring is full.
+*
 *********************************************************************/
 
 static VKN_staging_upload_instruct_type upload
@@ -550,69 +1192,130 @@ static VKN_staging_upload_instruct_type upload
 /*----------------------------------------------------------
 Local variables
 ----------------------------------------------------------*/
-VKN_staging_frame_type *frame;      /* working frame                */
-VkDeviceSize            padding;    /* wasted alignment space       */
-VkDeviceSize            required_size;
-                                    /* used sized after alignment   */
 VKN_staging_upload_instruct_type
                         ret;        /* return instructions          */
 
+reserve( size, alignment, TRUE, staging, &ret );
+
+return( ret );
+
+}   /* upload() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       upload_split
+*
+*   DESCRIPTION:
+*       Upload data of any size, in pieces of at most a quarter of
+*       the ring so earlier pieces transfer while later ones are
+*       copied in.  Returns the ticket of the last piece.
+*
+*********************************************************************/
+
+static VKN_staging_ticket_type upload_split
+    (
+    const void         *data,       /* data to upload               */
+    const u32           size,       /* size of the data             */
+    const u32           granularity,/* pieces are a multiple of this*/
+    const u32           alignment,  /* alignment of each piece      */
+    VKN_staging_record_proc_type
+                       *record,     /* records each piece's copy    */
+    void               *user,       /* caller's data for record     */
+    struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    )
+{
+/*----------------------------------------------------------
+Local literals
+----------------------------------------------------------*/
+#define PIECES_PER_RING             ( 4 )
+
+/*----------------------------------------------------------
+Local variables
+----------------------------------------------------------*/
+u32                     data_offset;/* offset of the working piece  */
+VKN_staging_upload_instruct_type
+                        instruct;   /* piece's upload instructions  */
+u32                     max_piece;  /* largest piece to upload      */
+u32                     piece;      /* size of the working piece    */
+VKN_staging_ticket_type ret;        /* return last piece's ticket   */
+
 /*----------------------------------------------------------
-Validate the request
+Determine the piece size
 ----------------------------------------------------------*/
-clr_struct( &ret );
-if( staging->state.buffer_frame_sz < size )
+ret       = 0;
+max_piece = VKN_size_max( granularity, 1 );
+max_piece = (u32)VKN_size_max( VKN_size_round_down_mult( staging->state.ring_sz / PIECES_PER_RING, max_piece ), max_piece );
+if( max_piece > staging->state.ring_sz )
     {
-    /*------------------------------------------------------
-    Would never be able to satisfy this request, even with
-    an empty buffer
-    ------------------------------------------------------*/
     debug_assert_always();
     return( ret );
     }
 
 /*----------------------------------------------------------
-Determine if the allocation will fit in the current frame
+Stage each piece, and let the caller record its copy
 ----------------------------------------------------------*/
-frame         = &staging->state.frames[ staging->state.frame_num ];
-padding       = VKN_size_round_up_mult( frame->caret, alignment ) - frame->caret;
-required_size = padding + size;
-
-if( !frame->in_flight
- && staging->state.buffer_frame_sz < frame->caret + (u32)required_size )
+for( data_offset = 0; data_offset < size; data_offset += piece )
     {
-    /*------------------------------------------------------
-    Submit the current frame and advance to the next
-    ------------------------------------------------------*/
-    flush( staging );
-    padding = 0;
-    required_size = size;
-    }
+    piece = min_of_vals( max_piece, size - data_offset );
+    if( !reserve( piece, alignment, TRUE, staging, &instruct ) )
+        {
+        debug_assert_always();
+        return( ret );
+        }
 
-frame = &staging->state.frames[ staging->state.frame_num ];
-if( frame->in_flight )
-    {
-    /*------------------------------------------------------
-    Current frame still in-flight.  Wait for it to finish.
-    ------------------------------------------------------*/
-    block_for_frame( frame, staging );
+    memcpy( instruct.mapping, (const u8*)data + data_offset, piece );
+    record( &instruct, data_offset, piece, user );
+    ret = instruct.ticket;
     }
 
-frame->caret += (u32)padding;
+return( ret );
 
-/*----------------------------------------------------------
-Fill out the instructions
-----------------------------------------------------------*/
-ret.commands = frame->commands;
-ret.buffer   = frame->buffer;
-ret.offset   = frame->caret;
-ret.mapping  = &frame->allocation.mapping[ frame->caret ];
+#undef PIECES_PER_RING
+}   /* upload_split() */
+
+
+/*********************************************************************
+*
+*   PROCEDURE NAME:
+*       wait_for
+*
+*   DESCRIPTION:
+*       Block until the given batch finishes.  Only done when the
+*       ring or the batches are exhausted, or on destroy.
+*
+*********************************************************************/
 
+static bool wait_for
+    (
+    const VKN_staging_ticket_type
+                        ticket,     /* batch to wait for            */
+    VKN_staging_type   *staging     /* resource staging             */
+    )
+{
 /*----------------------------------------------------------
-Advance
+Local variables
 ----------------------------------------------------------*/
-frame->caret += size;
+VkSemaphoreWaitInfo     wait_info;  /* semaphore wait info          */
 
-return( ret );
+if( ticket <= staging->state.completed )
+    {
+    return( TRUE );
+    }
 
-}   /* upload() */
+debug_assert( ticket <= staging->state.submitted );
+
+clr_struct( &wait_info );
+wait_info.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+wait_info.semaphoreCount = 1;
+wait_info.pSemaphores    = &staging->state.timeline;
+wait_info.pValues        = &ticket;
+
+VKN_return_fail( vkWaitSemaphores( staging->state.logical, &wait_info, VKN_WAIT_INFINITE ) );
+advance( ticket, staging );
+
+return( TRUE );
+
+}   /* wait_for() */
@@ -3,6 +3,7 @@
 #include "Global.hpp"
 
 #include "VknMemoryTypes.hpp"
+#include "VknReleaserTypes.hpp"
 #include "VknStagingTypes.hpp"
 
 
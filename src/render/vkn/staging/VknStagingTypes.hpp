@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Global.hpp"
+#include "SlabAllocator.hpp"
 
 #include "VknCommon.hpp"
 #include "VknMemoryTypes.hpp"
@@ -8,10 +9,15 @@
 
 #define VKN_STAGING_MAX_SHARING_FAMILY_CNT \
                                     ( 3 )
+#define VKN_STAGING_BATCH_CNT       ( 8 )
+                                    /* most submissions in-flight   */
 
 #define VKN_STAGING_CONFIG_API      const struct _VKN_staging_build_config_type *
 
 
+typedef u64 VKN_staging_ticket_type;/* timeline value which signals */
+                                    /* an upload's completion       */
+
 typedef VKN_STAGING_CONFIG_API VKN_staging_build_add_sharing_family_proc_type
     (
     const u32           index,      /* family index to share with   */
@@ -19,10 +25,16 @@ typedef VKN_STAGING_CONFIG_API VKN_staging_build_add_sharing_family_proc_type
                        *builder     /* staging builder              */
     );
 
-typedef VKN_STAGING_CONFIG_API VKN_staging_build_set_frame_size_proc_type
+typedef VKN_STAGING_CONFIG_API VKN_staging_build_set_acquire_family_proc_type
+    (
+    const u32           index,      /* family using the uploads     */
+    struct _VKN_staging_build_type
+                       *builder     /* staging builder              */
+    );
+
+typedef VKN_STAGING_CONFIG_API VKN_staging_build_set_ring_size_proc_type
     (
-    const u32           per_frame_sz,
-                                    /* buffer size of each frame    */
+    const u32           ring_sz,    /* size of the upload ring      */
     struct _VKN_staging_build_type
                        *builder     /* staging builder              */
     );
@@ -32,9 +44,12 @@ typedef struct _VKN_staging_build_config_type
     VKN_staging_build_add_sharing_family_proc_type
                        *add_sharing_family;
                                     /* add family to share with     */
-    VKN_staging_build_set_frame_size_proc_type
-                       *set_frame_size;
-                                    /* set frames' buffer size      */
+    VKN_staging_build_set_acquire_family_proc_type
+                       *set_acquire_family;
+                                    /* set family using the uploads */
+    VKN_staging_build_set_ring_size_proc_type
+                       *set_ring_size;
+                                    /* set upload ring size         */
     } VKN_staging_build_config_type;
 
 typedef struct
@@ -47,13 +62,14 @@ typedef struct
 typedef struct
     {
     u32                 queue_index;/* family index of submit queue */
+    u32                 acquire_index;
+                                    /* family index using uploads   */
+    u32                 ring_sz;    /* size of the upload ring      */
     VkAllocationCallbacks
                        *allocator;  /* custom allocator             */
     VKN_memory_type    *memory;     /* device memory allocator      */
     VkDevice            logical;    /* logical device               */
     VkQueue             queue;      /* queue on which to submit     */
-    VkDeviceSize        buffer_frame_sz;
-                                    /* size of each buffer frame    */
     VKN_staging_build_family_indices_type
                         families;   /* queue families               */
     } VKN_staging_build_state_type;
@@ -68,18 +84,74 @@ typedef struct _VKN_staging_build_type
 
 typedef struct
     {
+    VKN_staging_ticket_type
+                        ticket;     /* completion of this upload    */
     u32                 offset;     /* offset into the buffer       */
     char               *mapping;    /* where data should go         */
     VkBuffer            buffer;     /* buffer which to use          */
     VkCommandBuffer     commands;   /* command buffer to use        */
     } VKN_staging_upload_instruct_type;
 
-typedef void VKN_staging_flush_proc_type
+typedef struct
+    {
+    VkSemaphore         semaphore;  /* timeline semaphore           */
+    u64                 value;      /* value to wait for, or 0      */
+    VkPipelineStageFlags
+                        stages;     /* stages which must wait       */
+    } VKN_staging_wait_type;
+
+typedef void VKN_staging_record_proc_type
+    (
+    const VKN_staging_upload_instruct_type
+                       *instruct,   /* where the piece was staged   */
+    const u32           data_offset,/* piece's offset in the data   */
+    const u32           size,       /* size of the piece            */
+    void               *user        /* caller's data                */
+    );
+
+typedef void VKN_staging_acquire_proc_type
+    (
+    VkCommandBuffer     commands,   /* acquiring family's commands  */
+    VKN_staging_wait_type
+                       *wait,       /* output wait for the submit   */
+    struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    );
+
+typedef bool VKN_staging_flush_proc_type
     (
     struct _VKN_staging_type
                        *staging     /* resource staging to flush   */
     );
 
+typedef void VKN_staging_get_wait_proc_type
+    (
+    const VKN_staging_ticket_type
+                        ticket,     /* upload to wait for           */
+    VKN_staging_wait_type
+                       *wait,       /* output wait for a submit     */
+    const struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    );
+
+typedef bool VKN_staging_is_complete_proc_type
+    (
+    const VKN_staging_ticket_type
+                        ticket,     /* upload to check              */
+    struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    );
+
+typedef VKN_staging_ticket_type VKN_staging_release_image_proc_type
+    (
+    const VkImageMemoryBarrier
+                       *barrier,    /* transition after the upload  */
+    const VkPipelineStageFlags
+                        dst_stages, /* stages which use the image   */
+    struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    );
+
 typedef VKN_staging_upload_instruct_type VKN_staging_upload_proc_type
     (
     const u32           size,       /* size of the upload           */
@@ -88,40 +160,99 @@ typedef VKN_staging_upload_instruct_type VKN_staging_upload_proc_type
                        *staging     /* resource staging             */
     );
 
+typedef VKN_staging_ticket_type VKN_staging_upload_split_proc_type
+    (
+    const void         *data,       /* data to upload               */
+    const u32           size,       /* size of the data             */
+    const u32           granularity,/* pieces are a multiple of this*/
+    const u32           alignment,  /* alignment of each piece      */
+    VKN_staging_record_proc_type
+                       *record,     /* records each piece's copy    */
+    void               *user,       /* caller's data for record     */
+    struct _VKN_staging_type
+                       *staging     /* resource staging             */
+    );
+
 typedef struct
     {
+    VKN_staging_acquire_proc_type
+                       *acquire;    /* take ownership of uploads    */
     VKN_staging_flush_proc_type
                        *flush;      /* flush the upload queue       */
+    VKN_staging_get_wait_proc_type
+                       *get_wait;   /* get semaphore for a ticket   */
+    VKN_staging_is_complete_proc_type
+                       *is_complete;/* has the upload finished?     */
+    VKN_staging_release_image_proc_type
+                       *release_image;
+                                    /* hand an image to its users   */
+    VKN_staging_upload_proc_type
+                       *try_upload; /* upload without waiting       */
     VKN_staging_upload_proc_type
                        *upload;     /* upload a resource            */
+    VKN_staging_upload_split_proc_type
+                       *upload_split;
+                                    /* upload data of any size      */
     } VKN_staging_api_type;
 
 typedef struct
     {
-    bool                in_flight;  /* is the buffer in-flight?     */
-    u32                 caret;      /* current buffer write start   */
-    VkBuffer            buffer;     /* buffer object                */
+    VKN_staging_ticket_type
+                        ticket;     /* value signaled on completion */
+    u64                 ring_end;   /* ring head when submitted     */
     VkCommandBuffer     commands;   /* command buffer object        */
-    VkFence             fence;      /* fence object                 */
-    VKN_memory_allocation_type
-                        allocation; /* device memory                */
-    } VKN_staging_frame_type;
+    } VKN_staging_batch_type;
+
+typedef struct _VKN_staging_acquire_type
+    {
+    VKN_staging_ticket_type
+                        ticket;     /* batch which released it      */
+    VkPipelineStageFlags
+                        dst_stages; /* stages which use the image   */
+    VkImageMemoryBarrier
+                        barrier;    /* acquire barrier              */
+    struct _VKN_staging_acquire_type
+                       *next;       /* next acquire in the list     */
+    } VKN_staging_acquire_type;
 
 typedef struct
     {
-    u32                 frame_num;  /* current frame number         */
+    bool                is_recording : 1;
+                                    /* does the batch have commands?*/
     u32                 queue_index;/* family index of submit queue */
+    u32                 acquire_index;
+                                    /* family index using uploads   */
+    u32                 ring_sz;    /* size of the upload ring      */
     VkAllocationCallbacks
                        *allocator;  /* custom allocator             */
     VKN_memory_type    *memory;     /* device memory allocator      */
-    VkDeviceSize        buffer_frame_sz;
-                                    /* size of each buffer frame    */
     VkDevice            logical;    /* logical device               */
     VkQueue             queue;      /* queue on which to submit     */
     VkCommandPool       command_pool;
                                     /* command buffer pool          */
-    VKN_staging_frame_type          /* frame state                  */
-                        frames[ VKN_FRAME_CNT ];
+    VkSemaphore         timeline;   /* signals finished batches     */
+    VkBuffer            buffer;     /* upload ring buffer           */
+    VKN_memory_allocation_type
+                        allocation; /* upload ring memory           */
+    u64                 head;       /* bytes ever reserved          */
+    u64                 tail;       /* bytes ever released          */
+    VKN_staging_ticket_type
+                        submitted;  /* last batch submitted         */
+    VKN_staging_ticket_type
+                        completed;  /* last batch known finished    */
+    VKN_staging_ticket_type
+                        acquired;   /* last batch acquire waited on */
+    VKN_staging_batch_type
+                        batches[ VKN_STAGING_BATCH_CNT ];
+                                    /* batches by ticket            */
+    VKN_staging_acquire_type
+                       *head_acquires;
+                                    /* acquires, oldest first       */
+    VKN_staging_acquire_type
+                       *tail_acquires;
+                                    /* newest acquire               */
+    SlabAllocator       acquire_slab;
+                                    /* acquire storage              */
     } VKN_staging_state_type;
 
 typedef struct _VKN_staging_type
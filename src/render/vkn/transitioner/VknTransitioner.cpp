@@ -25,11 +25,10 @@ Local variables
 VKN_transitioner_barrier_type
                        *ret;        /* return barrier record        */
 
-ret = transitioner->state.barrier_free;
+ret = SlabAllocator_New( VKN_transitioner_barrier_type, &transitioner->state.barrier_slab );
 if( ret )
     {
-    transitioner->state.barrier_free = ret->next;
-    ret->next = NULL;
+    clr_struct( ret );
     }
 
 return( ret );
@@ -56,11 +55,10 @@ Local variables
 VKN_transitioner_resource_type
                        *ret;        /* return resource record       */
 
-ret = transitioner->state.resource_free;
+ret = SlabAllocator_New( VKN_transitioner_resource_type, &transitioner->state.resource_slab );
 if( ret )
     {
-    transitioner->state.resource_free = ret->next;
-    ret->next = NULL;
+    clr_struct( ret );
     ret->all_subresources = VK_IMAGE_LAYOUT_MAX_ENUM;
     }
 
@@ -88,11 +86,10 @@ Local variables
 VKN_transitioner_subresource_type
                        *ret;        /* return subresource record    */
 
-ret = transitioner->state.subresource_free;
+ret = SlabAllocator_New( VKN_transitioner_subresource_type, &transitioner->state.subresource_slab );
 if( ret )
     {
-    transitioner->state.subresource_free = ret->next;
-    ret->next = NULL;
+    clr_struct( ret );
     ret->state = VK_IMAGE_LAYOUT_MAX_ENUM;
     }
 
@@ -148,9 +145,7 @@ static __inline void free_barrier
 {
 *head = to_free->next;
 
-clr_struct( to_free );
-to_free->next = transitioner->state.barrier_free;
-transitioner->state.barrier_free = to_free;
+SlabAllocator_Free( to_free, &transitioner->state.barrier_slab );
 
 }   /* free_barrier() */
 
@@ -388,26 +383,9 @@ transitioner->i = &API;
 
 transitioner->state.is_master = is_master;
 
-for( i = 0; i < barrier_capacity; i++ )
-    {
-    clr_struct( &barriers[ i ] );
-    barriers[ i ].next = transitioner->state.barrier_free;
-    transitioner->state.barrier_free = &barriers[ i ];
-    }
-    
-for( i = 0; i < resource_capacity; i++ )
-    {
-    clr_struct( &resources[ i ] );
-    resources[ i ].next = transitioner->state.resource_free;
-    transitioner->state.resource_free = &resources[ i ];
-    }
-    
-for( i = 0; i < subresource_capacity; i++ )
-    {
-    clr_struct( &subresources[ i ] );
-    subresources[ i ].next = transitioner->state.subresource_free;
-    transitioner->state.subresource_free = &subresources[ i ];
-    }
+SlabAllocator_InitAttached( sizeof( *barriers ), barrier_capacity, barriers, SLAB_ALLOCATOR_FLAG_NONE, &transitioner->state.barrier_slab );
+SlabAllocator_InitAttached( sizeof( *resources ), resource_capacity, resources, SLAB_ALLOCATOR_FLAG_NONE, &transitioner->state.resource_slab );
+SlabAllocator_InitAttached( sizeof( *subresources ), subresource_capacity, subresources, SLAB_ALLOCATOR_FLAG_NONE, &transitioner->state.subresource_slab );
 
 /*----------------------------------------------------------
 Master-specific
@@ -892,8 +870,7 @@ while( to_free->subresources )
     free_subresource( to_free->subresources, &to_free->subresources, transitioner );
     }
 
-clr_struct( to_free );
-push_resource( to_free, &transitioner->state.resource_free );
+SlabAllocator_Free( to_free, &transitioner->state.resource_slab );
 
 }   /* free_resource() */
 
@@ -916,8 +893,7 @@ static void free_subresource
     )
 {
 *head = to_free->next;
-clr_struct( to_free );
-push_subresource( to_free, &transitioner->state.subresource_free );
+SlabAllocator_Free( to_free, &transitioner->state.subresource_slab );
 
 }   /* free_subresource() */
 
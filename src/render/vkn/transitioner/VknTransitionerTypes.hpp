@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Global.hpp"
+#include "SlabAllocator.hpp"
 
 #include "VknCommon.hpp"
 
@@ -127,13 +128,12 @@ typedef struct
     bool                is_master : 1;
                                     /* is this the master ledger?   */
     u32                 frame_num;  /* current frame index          */
-    VKN_transitioner_subresource_type
-                       *subresource_free;
+    SlabAllocator       subresource_slab;
                                     /* free subresource records     */
-    VKN_transitioner_resource_type  /* free resource records        */
-                       *resource_free;
-    VKN_transitioner_barrier_type   /* free barrier records         */
-                       *barrier_free;
+    SlabAllocator       resource_slab;
+                                    /* free resource records        */
+    SlabAllocator       barrier_slab;
+                                    /* free barrier records         */
     VKN_transitioner_resource_type
                        *resources;  /* used resource records        */
     VKN_transitioner_barrier_type
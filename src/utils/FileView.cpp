@@ -0,0 +1,214 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined( _WIN32 )
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "FileView.hpp"
+#include "Utilities.hpp"
+
+
+static bool MapWholeFile( const char *file_path, FileView *view );
+static bool ReadWholeFile( const char *file_path, FileView *view );
+
+
+/*******************************************************************
+*
+*   FileView_Close()
+*
+*   DESCRIPTION:
+*       Release a file view.
+*
+*******************************************************************/
+
+void FileView_Close( FileView *view )
+{
+if( view->is_mapped )
+    {
+#if defined( _WIN32 )
+    UnmapViewOfFile( view->data );
+    CloseHandle( (HANDLE)view->mapping );
+    CloseHandle( (HANDLE)view->file );
+#else
+    munmap( (void*)view->data, (size_t)view->size );
+#endif
+    }
+else if( view->size )
+    {
+    free( (void*)view->data );
+    }
+
+*view = {};
+
+} /* FileView_Close() */
+
+
+/*******************************************************************
+*
+*   FileView_Open()
+*
+*   DESCRIPTION:
+*       Open a read-only view of the given file.  Returns FALSE if
+*       the file couldn't be opened.  An empty file gives an empty
+*       view.
+*
+*******************************************************************/
+
+bool FileView_Open( const char *file_path, FileView *view )
+{
+hard_assert( file_path );
+*view = {};
+
+if( MapWholeFile( file_path, view ) )
+    {
+    return( true );
+    }
+
+return( ReadWholeFile( file_path, view ) );
+
+} /* FileView_Open() */
+
+
+/*******************************************************************
+*
+*   MapWholeFile()
+*
+*   DESCRIPTION:
+*       Memory map the whole file.  Fails for empty files, which
+*       can't be mapped.
+*
+*******************************************************************/
+
+static bool MapWholeFile( const char *file_path, FileView *view )
+{
+#if defined( _WIN32 )
+HANDLE file = CreateFileA( file_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+if( file == INVALID_HANDLE_VALUE )
+    {
+    return( false );
+    }
+
+LARGE_INTEGER size;
+if( !GetFileSizeEx( file, &size )
+ || size.QuadPart <= 0 )
+    {
+    CloseHandle( file );
+    return( false );
+    }
+
+HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+if( !mapping )
+    {
+    CloseHandle( file );
+    return( false );
+    }
+
+const void *data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+if( !data )
+    {
+    CloseHandle( mapping );
+    CloseHandle( file );
+    return( false );
+    }
+
+view->file    = (void*)file;
+view->mapping = (void*)mapping;
+view->size    = (uint64_t)size.QuadPart;
+
+#else
+int file = open( file_path, O_RDONLY );
+if( file < 0 )
+    {
+    return( false );
+    }
+
+struct stat info;
+if( fstat( file, &info )
+ || info.st_size <= 0 )
+    {
+    close( file );
+    return( false );
+    }
+
+void *data = mmap( NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+
+/* the mapping holds its own reference to the file */
+close( file );
+if( data == MAP_FAILED )
+    {
+    return( false );
+    }
+
+view->size = (uint64_t)info.st_size;
+
+#endif
+view->data      = (const char*)data;
+view->is_mapped = true;
+
+return( true );
+
+} /* MapWholeFile() */
+
+
+/*******************************************************************
+*
+*   ReadWholeFile()
+*
+*   DESCRIPTION:
+*       Read the whole file into a new buffer, in one read.
+*
+*******************************************************************/
+
+static bool ReadWholeFile( const char *file_path, FileView *view )
+{
+/* binary mode, so the size from the end offset matches what is read */
+FILE *fhnd = fopen( file_path, "rb" );
+if( !fhnd )
+    {
+    return( false );
+    }
+
+long file_sz = -1;
+if( !fseek( fhnd, 0, SEEK_END ) )
+    {
+    file_sz = ftell( fhnd );
+    rewind( fhnd );
+    }
+
+if( file_sz <= 0 )
+    {
+    fclose( fhnd );
+    view->data = "";
+    return( file_sz == 0 );
+    }
+
+char *data = (char*)malloc( (size_t)file_sz );
+if( !data )
+    {
+    fclose( fhnd );
+    hard_assert_always();
+    return( false );
+    }
+
+size_t read_sz = fread( data, 1, (size_t)file_sz, fhnd );
+fclose( fhnd );
+if( read_sz != (size_t)file_sz )
+    {
+    free( data );
+    return( false );
+    }
+
+view->data = data;
+view->size = (uint64_t)file_sz;
+
+return( true );
+
+} /* ReadWholeFile() */
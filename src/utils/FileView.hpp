@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+
+#include "Utilities.hpp"
+
+
+/*******************************************************************
+*
+*   FileView
+*
+*   DESCRIPTION:
+*       Read-only view of a whole file.  The file is memory mapped
+*       where the platform allows it, so opening a view costs no
+*       copy, and pages are only read as they're touched.  If the
+*       file can't be mapped it's read into a buffer in one call.
+*
+*       The view holds the file's bytes exactly - line endings are
+*       not translated, and the data is not null terminated.  A
+*       mapped file can't be deleted or replaced (on Windows) until
+*       its view is closed.
+*
+*******************************************************************/
+
+typedef struct _FileView
+    {
+    const char         *data;
+    uint64_t            size;
+    bool                is_mapped;
+    void               *file;           /* platform file handle, when mapped */
+    void               *mapping;        /* platform mapping handle, when mapped */
+    } FileView;
+
+
+void FileView_Close( FileView *view );
+bool FileView_Open( const char *file_path, FileView *view );
@@ -0,0 +1,731 @@
+#include <cstdlib>
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define FLAT_HASH_MAP_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+#include "FlatHashMap.hpp"
+#include "Utilities.hpp"
+
+
+#define CONTROL_EMPTY               ( 0x80 )
+#define CONTROL_DELETED             ( 0xfe )
+#define INVALID_SLOT                max_uint_value( uint32_t )
+#define MAX_LOAD_NUMERATOR          ( 7 )   /* grow past 7/8 full, counting deleted slots */
+#define MAX_LOAD_DENOMINATOR        ( 8 )
+#define ARRAY_ALIGNMENT             ( 16 )
+
+compiler_assert( FLAT_HASH_MAP_GROUP_WIDTH == 16, flat_hash_map_cpp );
+
+static void     AllocateTable( const uint32_t capacity, const FlatHashMap *map, FlatHashMapTable *table );
+static void     EraseSlot( const uint32_t slot, FlatHashMapTable *table );
+static uint32_t FindFreeSlot( const uint32_t mixed, const FlatHashMapTable *table );
+static uint32_t FindSlot( const uint32_t hash, const void *key, const FlatHashMap *map, const FlatHashMapTable *table, uint32_t *out_probe_groups );
+static void     FinishMigration( FlatHashMap *map );
+static void     FreeTable( FlatHashMapTable *table );
+static void     Grow( FlatHashMap *map );
+static uint32_t MatchByte( const uint8_t *group, const uint8_t value );
+static uint32_t MatchEmptyOrDeleted( const uint8_t *group );
+static void     MigrateSlots( const uint32_t count, FlatHashMap *map );
+static uint32_t WriteSlot( const uint32_t hash, const void *key, const void *value, const FlatHashMap *map, FlatHashMapTable *table );
+
+
+/*******************************************************************
+*
+*   get_key()
+*
+*   DESCRIPTION:
+*       Address the stored key of the given slot.
+*
+*******************************************************************/
+
+static inline void * get_key( const uint32_t slot, const FlatHashMap *map, const FlatHashMapTable *table )
+{
+return( (void*)&table->keys[ (size_t)slot * map->key_size ] );
+
+} /* get_key() */
+
+
+/*******************************************************************
+*
+*   get_value()
+*
+*   DESCRIPTION:
+*       Address the stored value of the given slot.
+*
+*******************************************************************/
+
+static inline void * get_value( const uint32_t slot, const FlatHashMap *map, const FlatHashMapTable *table )
+{
+return( (void*)&table->values[ (size_t)slot * map->value_stride ] );
+
+} /* get_value() */
+
+
+/*******************************************************************
+*
+*   lowest_bit_index()
+*
+*   DESCRIPTION:
+*       Get the index of the lowest set bit of a non-zero mask.
+*
+*******************************************************************/
+
+static inline uint32_t lowest_bit_index( const uint32_t mask )
+{
+#if defined( _MSC_VER )
+unsigned long index;
+_BitScanForward( &index, mask );
+return( (uint32_t)index );
+#else
+return( (uint32_t)__builtin_ctz( mask ) );
+#endif
+
+} /* lowest_bit_index() */
+
+
+/*******************************************************************
+*
+*   mix_hash()
+*
+*   DESCRIPTION:
+*       Scramble the caller's hash so every bit depends on every
+*       input bit.  The top bits pick the first group to probe, and
+*       the low 7 bits are stored in the slot's control byte.
+*
+*******************************************************************/
+
+static inline uint32_t mix_hash( uint32_t hash )
+{
+hash ^= hash >> 16;
+hash *= 0x85ebca6b;
+hash ^= hash >> 13;
+hash *= 0xc2b2ae35;
+hash ^= hash >> 16;
+
+return( hash );
+
+} /* mix_hash() */
+
+
+/*******************************************************************
+*
+*   FlatHashMap_At()
+*
+*   DESCRIPTION:
+*       Get the value storage at the given hash and key, or NULL if
+*       there is none.  The key is ignored for hash only maps.
+*
+*******************************************************************/
+
+void * FlatHashMap_At( const uint32_t hash, const void *key, FlatHashMap *map )
+{
+uint32_t slot = FindSlot( hash, key, map, &map->table, NULL );
+if( slot != INVALID_SLOT )
+    {
+    return( get_value( slot, map, &map->table ) );
+    }
+
+if( map->old.controls )
+    {
+    slot = FindSlot( hash, key, map, &map->old, NULL );
+    if( slot != INVALID_SLOT )
+        {
+        return( get_value( slot, map, &map->old ) );
+        }
+    }
+
+return( NULL );
+
+} /* FlatHashMap_At() */
+
+
+/*******************************************************************
+*
+*   FlatHashMap_Clear()
+*
+*   DESCRIPTION:
+*       Clear the map of values, keeping its current capacity.
+*
+*******************************************************************/
+
+void FlatHashMap_Clear( FlatHashMap *map )
+{
+FreeTable( &map->old );
+map->migrate_cursor = 0;
+
+memset( map->table.controls, CONTROL_EMPTY, map->table.capacity );
+map->table.size          = 0;
+map->table.deleted_count = 0;
+
+} /* FlatHashMap_Clear() */
+
+
+/*******************************************************************
+*
+*   FlatHashMap_Delete()
+*
+*   DESCRIPTION:
+*       Delete the given key from the map.  If given, the stored key
+*       is copied out first, so the caller can free anything it
+*       owns.  Returns TRUE if the key was found.
+*
+*******************************************************************/
+
+bool FlatHashMap_Delete( const uint32_t hash, const void *key, void *out_key, FlatHashMap *map )
+{
+MigrateSlots( FLAT_HASH_MAP_MIGRATE_STEP, map );
+
+FlatHashMapTable *table = &map->table;
+uint32_t slot = FindSlot( hash, key, map, table, NULL );
+if( slot == INVALID_SLOT
+ && map->old.controls )
+    {
+    table = &map->old;
+    slot  = FindSlot( hash, key, map, table, NULL );
+    }
+
+if( slot == INVALID_SLOT )
+    {
+    return( false );
+    }
+
+if( out_key
+ && map->key_size )
+    {
+    memcpy( out_key, get_key( slot, map, table ), map->key_size );
+    }
+
+EraseSlot( slot, table );
+return( true );
+
+} /* FlatHashMap_Delete() */
+
+
+/*******************************************************************
+*
+*   FlatHashMap_Destroy()
+*
+*   DESCRIPTION:
+*       Free the map's tables and return it to uninitialized.
+*
+*******************************************************************/
+
+void FlatHashMap_Destroy( FlatHashMap *map )
+{
+FreeTable( &map->table );
+FreeTable( &map->old );
+*map = {};
+
+} /* FlatHashMap_Destroy() */
+
+
+/*******************************************************************
+*
+*   FlatHashMap_GetCount()
+*
+*   DESCRIPTION:
+*       Get the number of keys in the map.
+*
+*******************************************************************/
+
+uint32_t FlatHashMap_GetCount( const FlatHashMap *map )
+{
+return( map->table.size + map->old.size );
+
+} /* FlatHashMap_GetCount() */
+
+
+/*******************************************************************
+*
+*   FlatHashMap_Init()
+*
+*   DESCRIPTION:
+*       Initialize the given hash map, sized to hold the given
+*       number of keys before it first grows.  A key size of zero
+*       makes the caller's hash the whole key.
+*
+*******************************************************************/
+
+void FlatHashMap_Init( const uint32_t capacity, const size_t key_size, const size_t value_stride, FlatHashMapKeyEqualProc *key_equal, FlatHashMap *map )
+{
+*map = {};
+map->key_size     = key_size;
+map->value_stride = value_stride;
+map->key_equal    = key_equal;
+
+uint32_t table_capacity = FLAT_HASH_MAP_GROUP_WIDTH;
+while( (uint64_t)table_capacity * MAX_LOAD_NUMERATOR < (uint64_t)capacity * MAX_LOAD_DENOMINATOR )
+    {
+    table_capacity *= 2;
+    }
+
+AllocateTable( table_capacity, map, &map->table );
+
+} /* FlatHashMap_Init() */
+
+
+/*******************************************************************
+*
+*   FlatHashMap_Insert()
+*
+*   DESCRIPTION:
+*       Insert the given value into the map, overwriting any value
+*       already at the key.  A NULL value zeroes new storage, and
+*       leaves existing storage alone.
+*
+*******************************************************************/
+
+void * FlatHashMap_Insert( const uint32_t hash, const void *key, const void *value, FlatHashMap *map )
+{
+MigrateSlots( FLAT_HASH_MAP_MIGRATE_STEP, map );
+
+FlatHashMapTable *table = &map->table;
+uint32_t slot = FindSlot( hash, key, map, table, NULL );
+if( slot == INVALID_SLOT
+ && map->old.controls )
+    {
+    table = &map->old;
+    slot  = FindSlot( hash, key, map, table, NULL );
+    }
+
+if( slot != INVALID_SLOT )
+    {
+    /* key already existed, so overwrite */
+    void *storage = get_value( slot, map, table );
+    if( value )
+        {
+        memcpy( storage, value, map->value_stride );
+        }
+
+    return( storage );
+    }
+
+if( (uint64_t)( map->table.size + map->table.deleted_count + 1 ) * MAX_LOAD_DENOMINATOR > (uint64_t)map->table.capacity * MAX_LOAD_NUMERATOR )
+    {
+    Grow( map );
+    }
+
+slot = WriteSlot( hash, key, value, map, &map->table );
+return( get_value( slot, map, &map->table ) );
+
+} /* FlatHashMap_Insert() */
+
+
+/*******************************************************************
+*
+*   FlatHashMap_ReportMetrics()
+*
+*   DESCRIPTION:
+*       Report the map's technical metrics.  Probe lengths are
+*       measured by looking every key up again.
+*
+*******************************************************************/
+
+void FlatHashMap_ReportMetrics( const FlatHashMap *map, FlatHashMapMetrics *out )
+{
+*out = {};
+out->size          = FlatHashMap_GetCount( map );
+out->capacity      = map->table.capacity + map->old.capacity;
+out->deleted_count = map->table.deleted_count + map->old.deleted_count;
+out->load_factor   = out->capacity ? (float)out->size / (float)out->capacity : 0.0f;
+
+const FlatHashMapTable *tables[] = { &map->table, &map->old };
+uint64_t total_probe_groups = 0;
+for( uint32_t i = 0; i < cnt_of_array( tables ); i++ )
+    {
+    const FlatHashMapTable *table = tables[ i ];
+    out->memory_usage += table->capacity * ( sizeof(*table->controls) + sizeof(*table->hashes) + map->key_size + map->value_stride );
+    for( uint32_t slot = 0; slot < table->capacity; slot++ )
+        {
+        if( table->controls[ slot ] & CONTROL_EMPTY )
+            {
+            continue;
+            }
+
+        uint32_t probe_groups = 0;
+        do_debug_assert( FindSlot( table->hashes[ slot ], get_key( slot, map, table ), map, table, &probe_groups ) == slot );
+        total_probe_groups    += probe_groups;
+        out->max_probe_groups  = max_of_vals( out->max_probe_groups, probe_groups );
+        }
+    }
+
+if( out->size )
+    {
+    out->average_probe_groups = (float)total_probe_groups / (float)out->size;
+    }
+
+} /* FlatHashMap_ReportMetrics() */
+
+
+/*******************************************************************
+*
+*   AllocateTable()
+*
+*   DESCRIPTION:
+*       Allocate an empty table of the given capacity, with all of
+*       its arrays in one block.
+*
+*******************************************************************/
+
+static void AllocateTable( const uint32_t capacity, const FlatHashMap *map, FlatHashMapTable *table )
+{
+debug_assert( capacity >= FLAT_HASH_MAP_GROUP_WIDTH && ( capacity & ( capacity - 1 ) ) == 0 );
+size_t values_size   = (size_t)align_size_round_up( (size_t)capacity * map->value_stride, ARRAY_ALIGNMENT );
+size_t keys_size     = (size_t)align_size_round_up( (size_t)capacity * map->key_size, ARRAY_ALIGNMENT );
+size_t hashes_size   = (size_t)capacity * sizeof(*table->hashes);
+size_t controls_size = (size_t)capacity;
+
+uint8_t *block = (uint8_t*)malloc( values_size + keys_size + hashes_size + controls_size );
+if( !block )
+    {
+    hard_assert_always();
+    return;
+    }
+
+*table = {};
+table->capacity = capacity;
+table->values   = block;
+table->keys     = block + values_size;
+table->hashes   = (uint32_t*)( block + values_size + keys_size );
+table->controls = block + values_size + keys_size + hashes_size;
+memset( table->controls, CONTROL_EMPTY, controls_size );
+
+} /* AllocateTable() */
+
+
+/*******************************************************************
+*
+*   EraseSlot()
+*
+*   DESCRIPTION:
+*       Erase the given slot.  Probes stop at the first group with an
+*       empty slot, so the slot can only be made empty again if its
+*       group already has one - otherwise it must be marked deleted
+*       so probes which passed through the full group keep going.
+*
+*******************************************************************/
+
+static void EraseSlot( const uint32_t slot, FlatHashMapTable *table )
+{
+const uint8_t *group = &table->controls[ slot & ~( FLAT_HASH_MAP_GROUP_WIDTH - 1 ) ];
+if( MatchByte( group, CONTROL_EMPTY ) )
+    {
+    table->controls[ slot ] = CONTROL_EMPTY;
+    }
+else
+    {
+    table->controls[ slot ] = CONTROL_DELETED;
+    table->deleted_count++;
+    }
+
+table->size--;
+
+} /* EraseSlot() */
+
+
+/*******************************************************************
+*
+*   FindFreeSlot()
+*
+*   DESCRIPTION:
+*       Find the first empty or deleted slot along the probe
+*       sequence of the given mixed hash.
+*
+*******************************************************************/
+
+static uint32_t FindFreeSlot( const uint32_t mixed, const FlatHashMapTable *table )
+{
+uint32_t group_mask = table->capacity / FLAT_HASH_MAP_GROUP_WIDTH - 1;
+uint32_t group      = ( mixed >> 7 ) & group_mask;
+for( uint32_t probe = 0; probe <= group_mask; probe++ )
+    {
+    /* triangular steps visit every group of a power-of-two table */
+    uint32_t first = group * FLAT_HASH_MAP_GROUP_WIDTH;
+    uint32_t match = MatchEmptyOrDeleted( &table->controls[ first ] );
+    if( match )
+        {
+        return( first + lowest_bit_index( match ) );
+        }
+
+    group = ( group + probe + 1 ) & group_mask;
+    }
+
+hard_assert_always();
+return( INVALID_SLOT );
+
+} /* FindFreeSlot() */
+
+
+/*******************************************************************
+*
+*   FindSlot()
+*
+*   DESCRIPTION:
+*       Find the slot holding the given hash and key in a table, or
+*       INVALID_SLOT.  Optionally report the number of groups
+*       visited.
+*
+*******************************************************************/
+
+static uint32_t FindSlot( const uint32_t hash, const void *key, const FlatHashMap *map, const FlatHashMapTable *table, uint32_t *out_probe_groups )
+{
+if( table->size == 0 )
+    {
+    return( INVALID_SLOT );
+    }
+
+uint32_t mixed      = mix_hash( hash );
+uint8_t  tag        = (uint8_t)( mixed & 0x7f );
+uint32_t group_mask = table->capacity / FLAT_HASH_MAP_GROUP_WIDTH - 1;
+uint32_t group      = ( mixed >> 7 ) & group_mask;
+for( uint32_t probe = 0; probe <= group_mask; probe++ )
+    {
+    if( out_probe_groups )
+        {
+        *out_probe_groups = probe + 1;
+        }
+
+    uint32_t first = group * FLAT_HASH_MAP_GROUP_WIDTH;
+    const uint8_t *controls = &table->controls[ first ];
+    for( uint32_t match = MatchByte( controls, tag ); match; match &= match - 1 )
+        {
+        uint32_t slot = first + lowest_bit_index( match );
+        if( table->hashes[ slot ] != hash )
+            {
+            continue;
+            }
+
+        if( map->key_size == 0 )
+            {
+            return( slot );
+            }
+
+        const void *stored = get_key( slot, map, table );
+        if( map->key_equal ? map->key_equal( stored, key ) : memcmp( stored, key, map->key_size ) == 0 )
+            {
+            return( slot );
+            }
+        }
+
+    if( MatchByte( controls, CONTROL_EMPTY ) )
+        {
+        /* the key would have been placed in this group */
+        return( INVALID_SLOT );
+        }
+
+    group = ( group + probe + 1 ) & group_mask;
+    }
+
+return( INVALID_SLOT );
+
+} /* FindSlot() */
+
+
+/*******************************************************************
+*
+*   FinishMigration()
+*
+*   DESCRIPTION:
+*       Move every remaining slot of the outgrown table.
+*
+*******************************************************************/
+
+static void FinishMigration( FlatHashMap *map )
+{
+if( map->old.controls )
+    {
+    MigrateSlots( map->old.capacity - map->migrate_cursor, map );
+    }
+
+} /* FinishMigration() */
+
+
+/*******************************************************************
+*
+*   FreeTable()
+*
+*   DESCRIPTION:
+*       Free the given table's block.  The values array is first.
+*
+*******************************************************************/
+
+static void FreeTable( FlatHashMapTable *table )
+{
+free( table->values );
+*table = {};
+
+} /* FreeTable() */
+
+
+/*******************************************************************
+*
+*   Grow()
+*
+*   DESCRIPTION:
+*       Start migrating to a fresh table.  Tables which are mostly
+*       deleted slots are rehashed at the same capacity, and the
+*       rest double.
+*
+*******************************************************************/
+
+static void Grow( FlatHashMap *map )
+{
+FinishMigration( map );
+
+uint32_t new_capacity = map->table.capacity;
+if( map->table.size >= map->table.capacity / 2 )
+    {
+    new_capacity *= 2;
+    }
+
+map->old = map->table;
+AllocateTable( new_capacity, map, &map->table );
+map->migrate_cursor = 0;
+
+} /* Grow() */
+
+
+/*******************************************************************
+*
+*   MatchByte()
+*
+*   DESCRIPTION:
+*       Get a mask of the control bytes in the group equal to the
+*       given value, bit i for slot i.
+*
+*******************************************************************/
+
+static uint32_t MatchByte( const uint8_t *group, const uint8_t value )
+{
+#if defined( FLAT_HASH_MAP_USE_SSE2 )
+__m128i controls = _mm_loadu_si128( (const __m128i*)group );
+return( (uint32_t)_mm_movemask_epi8( _mm_cmpeq_epi8( controls, _mm_set1_epi8( (char)value ) ) ) );
+#else
+uint32_t ret = 0;
+for( uint32_t i = 0; i < FLAT_HASH_MAP_GROUP_WIDTH; i++ )
+    {
+    ret |= (uint32_t)( group[ i ] == value ) << i;
+    }
+
+return( ret );
+#endif
+
+} /* MatchByte() */
+
+
+/*******************************************************************
+*
+*   MatchEmptyOrDeleted()
+*
+*   DESCRIPTION:
+*       Get a mask of the free slots in the group.  Only the empty
+*       and deleted control bytes have their high bit set.
+*
+*******************************************************************/
+
+static uint32_t MatchEmptyOrDeleted( const uint8_t *group )
+{
+#if defined( FLAT_HASH_MAP_USE_SSE2 )
+return( (uint32_t)_mm_movemask_epi8( _mm_loadu_si128( (const __m128i*)group ) ) );
+#else
+uint32_t ret = 0;
+for( uint32_t i = 0; i < FLAT_HASH_MAP_GROUP_WIDTH; i++ )
+    {
+    ret |= (uint32_t)( group[ i ] >> 7 ) << i;
+    }
+
+return( ret );
+#endif
+
+} /* MatchEmptyOrDeleted() */
+
+
+/*******************************************************************
+*
+*   MigrateSlots()
+*
+*   DESCRIPTION:
+*       Move up to the given number of slots from the outgrown table
+*       to the current one, and free the outgrown table once it has
+*       been emptied.
+*
+*******************************************************************/
+
+static void MigrateSlots( const uint32_t count, FlatHashMap *map )
+{
+FlatHashMapTable *old = &map->old;
+if( !old->controls )
+    {
+    return;
+    }
+
+uint32_t end = min_of_vals( map->migrate_cursor + count, old->capacity );
+for( ; map->migrate_cursor < end; map->migrate_cursor++ )
+    {
+    uint32_t slot = map->migrate_cursor;
+    if( old->controls[ slot ] & CONTROL_EMPTY )
+        {
+        continue;
+        }
+
+    WriteSlot( old->hashes[ slot ], get_key( slot, map, old ), get_value( slot, map, old ), map, &map->table );
+    old->controls[ slot ] = CONTROL_DELETED;
+    old->size--;
+    }
+
+if( map->migrate_cursor >= old->capacity
+ || old->size == 0 )
+    {
+    FreeTable( old );
+    map->migrate_cursor = 0;
+    }
+
+} /* MigrateSlots() */
+
+
+/*******************************************************************
+*
+*   WriteSlot()
+*
+*   DESCRIPTION:
+*       Store a key known not to be in the table in its first free
+*       slot.  Returns the slot.
+*
+*******************************************************************/
+
+static uint32_t WriteSlot( const uint32_t hash, const void *key, const void *value, const FlatHashMap *map, FlatHashMapTable *table )
+{
+uint32_t mixed = mix_hash( hash );
+uint32_t slot  = FindFreeSlot( mixed, table );
+if( table->controls[ slot ] == CONTROL_DELETED )
+    {
+    table->deleted_count--;
+    }
+
+table->controls[ slot ] = (uint8_t)( mixed & 0x7f );
+table->hashes[ slot ]   = hash;
+if( map->key_size )
+    {
+    memcpy( get_key( slot, map, table ), key, map->key_size );
+    }
+
+if( value )
+    {
+    memcpy( get_value( slot, map, table ), value, map->value_stride );
+    }
+else
+    {
+    memset( get_value( slot, map, table ), 0, map->value_stride );
+    }
+
+table->size++;
+return( slot );
+
+} /* WriteSlot() */
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+
+#include "Utilities.hpp"
+
+
+#define FLAT_HASH_MAP_GROUP_WIDTH   ( 16 )
+#define FLAT_HASH_MAP_MIGRATE_STEP  ( 2 * FLAT_HASH_MAP_GROUP_WIDTH )
+
+/* compare two stored keys - NULL compares the key bytes */
+typedef bool FlatHashMapKeyEqualProc( const void *a, const void *b );
+
+/*******************************************************************
+*
+*   FlatHashMapTable
+*
+*   DESCRIPTION:
+*       One power-of-two sized slot table.  Each slot has a control
+*       byte - empty, deleted, or the low 7 bits of its hash - and
+*       the control bytes of a group of FLAT_HASH_MAP_GROUP_WIDTH
+*       slots are matched against a probe in a single compare.
+*       Hashes, keys and values are stored in their own arrays, so
+*       probing only touches the control bytes and the hashes of
+*       candidate slots.
+*
+*******************************************************************/
+
+typedef struct _FlatHashMapTable
+    {
+    uint8_t            *controls;
+    uint32_t           *hashes;
+    uint8_t            *keys;
+    uint8_t            *values;
+    uint32_t            capacity;       /* a power of two, and a whole number of groups */
+    uint32_t            size;
+    uint32_t            deleted_count;
+    } FlatHashMapTable;
+
+/*******************************************************************
+*
+*   FlatHashMap
+*
+*   DESCRIPTION:
+*       Open addressed hash map which grows as needed.  Growing is
+*       incremental - the outgrown table is kept alongside the new
+*       one, and a few of its slots are moved over on each insert
+*       and delete, so no single call pays for the whole rehash.
+*       Deleted slots are reclaimed by the same rehash.
+*
+*       Keys are either just the caller's 32-bit hash (a key size of
+*       zero, like HashMap), or a fixed size key stored in full and
+*       compared on every hash match, so colliding hashes never
+*       alias each other.  Keys that own memory (such as string
+*       pointers) stay owned by the caller.
+*
+*       Value pointers are only valid until the next insert or
+*       delete.
+*
+*******************************************************************/
+
+typedef struct _FlatHashMap
+    {
+    FlatHashMapTable    table;
+    FlatHashMapTable    old;            /* outgrown table being migrated, while growing */
+    uint32_t            migrate_cursor; /* next slot of the old table to migrate */
+    size_t              key_size;
+    size_t              value_stride;
+    FlatHashMapKeyEqualProc
+                       *key_equal;
+    } FlatHashMap;
+
+typedef struct _FlatHashMapMetrics
+    {
+    size_t              memory_usage;
+    uint32_t            size;
+    uint32_t            capacity;
+    uint32_t            deleted_count;
+    float               load_factor;
+    float               average_probe_groups;   /* groups visited to find each key */
+    uint32_t            max_probe_groups;
+    } FlatHashMapMetrics;
+
+
+void *   FlatHashMap_At( const uint32_t hash, const void *key, FlatHashMap *map );
+void     FlatHashMap_Clear( FlatHashMap *map );
+bool     FlatHashMap_Delete( const uint32_t hash, const void *key, void *out_key, FlatHashMap *map );
+void     FlatHashMap_Destroy( FlatHashMap *map );
+uint32_t FlatHashMap_GetCount( const FlatHashMap *map );
+void     FlatHashMap_Init( const uint32_t capacity, const size_t key_size, const size_t value_stride, FlatHashMapKeyEqualProc *key_equal, FlatHashMap *map );
+void *   FlatHashMap_Insert( const uint32_t hash, const void *key, const void *value, FlatHashMap *map );
+void     FlatHashMap_ReportMetrics( const FlatHashMap *map, FlatHashMapMetrics *out );
@@ -0,0 +1,424 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include "FrameAllocator.hpp"
+#include "LinearAllocator.hpp"
+#include "Utilities.hpp"
+
+
+#define NO_SLOT                     ( 0xffffffff )
+#define ALL_SLOTS                   ( ( FRAME_ALLOCATOR_MAX_THREAD_COUNT == 64 ) ? ~(uint64_t)0 : ( ( (uint64_t)1 << ( FRAME_ALLOCATOR_MAX_THREAD_COUNT % 64 ) ) - 1 ) )
+compiler_assert( FRAME_ALLOCATOR_MAX_THREAD_COUNT <= 64, frame_allocator_cpp );
+
+typedef struct _FrameAllocatorThread
+    {
+    FrameAllocatorPage *first;
+    FrameAllocatorPage *current;
+    uint32_t            scope_depth;
+    uint64_t            high_water;             /* this frame */
+    uint32_t            overflow_page_count;    /* this frame */
+    } FrameAllocatorThread;
+
+/* a thread's slot index, handed back to s_free_slots when the thread exits */
+typedef struct _FrameAllocatorSlotLease
+    {
+    uint32_t            slot;
+    uint32_t            generation;
+    ~_FrameAllocatorSlotLease();
+    } FrameAllocatorSlotLease;
+
+static FrameAllocatorPage *   CreatePage( const uint64_t capacity );
+static void                   FreePages( FrameAllocatorPage *page );
+static FrameAllocatorThread * GetThread();
+static FrameAllocatorPage *   NextPage( const uint64_t sz, const uint64_t alignment, FrameAllocatorThread *thread );
+
+static std::atomic<FrameAllocatorThread*>
+                                      s_threads[ FRAME_ALLOCATOR_MAX_THREAD_COUNT ];    /* NULL until a slot's first thread is ready, then kept for the slot's next owner */
+static std::atomic<uint64_t>          s_free_slots( ALL_SLOTS );    /* bit per slot */
+static std::atomic<uint32_t>          s_generation( 1 );    /* bumped on destroy, to orphan the thread locals */
+static FrameAllocatorStats            s_stats;
+static thread_local FrameAllocatorThread
+                                     *s_thread;
+static thread_local uint32_t          s_thread_generation;
+static thread_local FrameAllocatorSlotLease
+                                      s_lease = { NO_SLOT, 0 };
+
+
+/*******************************************************************
+*
+*   fits_in_page()
+*
+*   DESCRIPTION:
+*       Can the page's allocator satisfy the aligned allocation?
+*
+*******************************************************************/
+
+static inline bool fits_in_page( const uint64_t sz, const uint64_t alignment, const FrameAllocatorPage *page )
+{
+const LinearAllocator *allocator = &page->allocator;
+uint64_t adjust = align_adjust( &allocator->pool[ allocator->head ], alignment );
+
+return( sz + adjust <= allocator->capacity - allocator->head );
+
+} /* fits_in_page() */
+
+
+/*******************************************************************
+*
+*   FrameAllocator_Allocate()
+*
+*   DESCRIPTION:
+*       Allocate from the calling thread's frame allocator.  The
+*       memory is valid until the enclosing scope ends, or the frame
+*       does.
+*
+*******************************************************************/
+
+void * FrameAllocator_Allocate( const uint64_t sz, const uint64_t alignment )
+{
+FrameAllocatorThread *thread = GetThread();
+FrameAllocatorPage   *page   = thread->current;
+if( !fits_in_page( sz, alignment, page ) )
+    {
+    page = NextPage( sz, alignment, thread );
+    }
+
+void *ret = LinearAllocator_AllocateAligned( sz, alignment, &page->allocator );
+thread->high_water = max_of_vals( thread->high_water, page->offset + page->allocator.head );
+
+return( ret );
+
+} /* FrameAllocator_Allocate() */
+
+
+/*******************************************************************
+*
+*   FrameAllocator_BeginScope()
+*
+*   DESCRIPTION:
+*       Mark the calling thread's frame allocator, to be rewound by
+*       FrameAllocator_EndScope().
+*
+*******************************************************************/
+
+FrameAllocatorMarker FrameAllocator_BeginScope()
+{
+FrameAllocatorThread *thread = GetThread();
+
+FrameAllocatorMarker ret = {};
+ret.page  = thread->current;
+ret.token = LinearAllocator_GetResetToken( &thread->current->allocator );
+ret.depth = thread->scope_depth++;
+
+return( ret );
+
+} /* FrameAllocator_BeginScope() */
+
+
+/*******************************************************************
+*
+*   FrameAllocator_Destroy()
+*
+*   DESCRIPTION:
+*       Free every thread's pages.  No thread may be using its
+*       allocator.
+*
+*******************************************************************/
+
+void FrameAllocator_Destroy()
+{
+for( uint32_t i = 0; i < FRAME_ALLOCATOR_MAX_THREAD_COUNT; i++ )
+    {
+    FrameAllocatorThread *thread = s_threads[ i ].exchange( NULL, std::memory_order_acquire );
+    if( thread )
+        {
+        FreePages( thread->first );
+        free( thread );
+        }
+    }
+
+s_free_slots = ALL_SLOTS;
+s_generation++;
+s_stats = {};
+
+} /* FrameAllocator_Destroy() */
+
+
+/*******************************************************************
+*
+*   FrameAllocator_EndFrame()
+*
+*   DESCRIPTION:
+*       Rewind every thread's frame allocator, and record the
+*       frame's statistics.  Threads which overflowed their first
+*       page get a single page big enough for the whole chain.
+*
+*******************************************************************/
+
+void FrameAllocator_EndFrame()
+{
+uint64_t frame_high_water    = 0;
+uint64_t reserved            = 0;
+uint32_t page_count          = 0;
+uint32_t overflow_page_count = 0;
+uint32_t ready_count         = 0;
+
+for( uint32_t i = 0; i < FRAME_ALLOCATOR_MAX_THREAD_COUNT; i++ )
+    {
+    /* a slot claimed by a thread still creating its allocator has nothing to rewind */
+    FrameAllocatorThread *thread = s_threads[ i ].load( std::memory_order_acquire );
+    if( !thread )
+        {
+        continue;
+        }
+
+    debug_assert( thread->scope_depth == 0 );
+    ready_count++;
+
+    frame_high_water    += thread->high_water;
+    overflow_page_count += thread->overflow_page_count;
+
+    if( thread->first->next )
+        {
+        uint64_t capacity = 0;
+        for( FrameAllocatorPage *page = thread->first; page; page = page->next )
+            {
+            capacity += page->allocator.capacity;
+            }
+
+        FreePages( thread->first );
+        thread->first = CreatePage( align_size_round_up( capacity, FRAME_ALLOCATOR_PAGE_SIZE ) );
+        }
+
+    LinearAllocator_ResetByToken( thread->first->start, &thread->first->allocator );
+    thread->current             = thread->first;
+    thread->high_water          = 0;
+    thread->overflow_page_count = 0;
+
+    reserved += thread->first->allocator.capacity;
+    page_count++;
+    }
+
+s_stats.frame_high_water    = frame_high_water;
+s_stats.peak_high_water     = max_of_vals( s_stats.peak_high_water, frame_high_water );
+s_stats.reserved            = reserved;
+s_stats.thread_count        = ready_count;
+s_stats.page_count          = page_count;
+s_stats.overflow_page_count = overflow_page_count;
+s_stats.frame_count++;
+
+} /* FrameAllocator_EndFrame() */
+
+
+/*******************************************************************
+*
+*   FrameAllocator_EndScope()
+*
+*   DESCRIPTION:
+*       Rewind the calling thread's frame allocator to the given
+*       marker.  Scopes must end in the reverse order they began.
+*
+*******************************************************************/
+
+void FrameAllocator_EndScope( const FrameAllocatorMarker marker )
+{
+FrameAllocatorThread *thread = GetThread();
+debug_assert( thread->scope_depth == marker.depth + 1 );
+thread->scope_depth = marker.depth;
+
+/* later pages in the chain are rewound when they are next used */
+thread->current = marker.page;
+LinearAllocator_ResetByToken( marker.token, &marker.page->allocator );
+
+} /* FrameAllocator_EndScope() */
+
+
+/*******************************************************************
+*
+*   FrameAllocator_GetStats()
+*
+*   DESCRIPTION:
+*       Get the statistics recorded by the last
+*       FrameAllocator_EndFrame().
+*
+*******************************************************************/
+
+void FrameAllocator_GetStats( FrameAllocatorStats *out )
+{
+*out = s_stats;
+
+} /* FrameAllocator_GetStats() */
+
+
+/*******************************************************************
+*
+*   CreatePage()
+*
+*   DESCRIPTION:
+*       Allocate an empty page, with its pool right after the
+*       header.
+*
+*******************************************************************/
+
+static FrameAllocatorPage * CreatePage( const uint64_t capacity )
+{
+FrameAllocatorPage *page = (FrameAllocatorPage*)malloc( sizeof(FrameAllocatorPage) + capacity );
+if( !page )
+    {
+    hard_assert_always();
+    return( NULL );
+    }
+
+*page = {};
+LinearAllocator_InitAttached( capacity, page + 1, &page->allocator );
+page->start = LinearAllocator_GetResetToken( &page->allocator );
+
+return( page );
+
+} /* CreatePage() */
+
+
+/*******************************************************************
+*
+*   FreePages()
+*
+*   DESCRIPTION:
+*       Free the given page, and every page after it in its chain.
+*
+*******************************************************************/
+
+static void FreePages( FrameAllocatorPage *page )
+{
+while( page )
+    {
+    FrameAllocatorPage *next = page->next;
+    free( page );
+    page = next;
+    }
+
+} /* FreePages() */
+
+
+/*******************************************************************
+*
+*   GetThread()
+*
+*   DESCRIPTION:
+*       Get the calling thread's frame allocator, claiming the
+*       lowest free slot on first use.  Slots are returned as
+*       threads exit, and keep their allocator for the next thread
+*       to claim them, so only the threads alive at once are
+*       limited to FRAME_ALLOCATOR_MAX_THREAD_COUNT.
+*
+*******************************************************************/
+
+static FrameAllocatorThread * GetThread()
+{
+uint32_t generation = s_generation.load( std::memory_order_relaxed );
+if( s_thread
+ && s_thread_generation == generation )
+    {
+    return( s_thread );
+    }
+
+uint64_t free_slots = s_free_slots.load( std::memory_order_relaxed );
+uint32_t index;
+do
+    {
+    hard_assert( free_slots );
+    index = 0;
+    while( !( free_slots & ( (uint64_t)1 << index ) ) )
+        {
+        index++;
+        }
+    } while( !s_free_slots.compare_exchange_weak( free_slots, free_slots & ~( (uint64_t)1 << index ), std::memory_order_acquire, std::memory_order_relaxed ) );
+
+s_lease.slot       = index;
+s_lease.generation = generation;
+
+FrameAllocatorThread *thread = s_threads[ index ].load( std::memory_order_acquire );
+if( !thread )
+    {
+    thread = (FrameAllocatorThread*)malloc( sizeof(FrameAllocatorThread) );
+    hard_assert( thread );
+    *thread = {};
+    thread->first   = CreatePage( FRAME_ALLOCATOR_PAGE_SIZE );
+    thread->current = thread->first;
+
+    /* publish only once the allocator is built, EndFrame may be reading the slots */
+    s_threads[ index ].store( thread, std::memory_order_release );
+    }
+
+s_thread            = thread;
+s_thread_generation = generation;
+
+return( thread );
+
+} /* GetThread() */
+
+
+/*******************************************************************
+*
+*   ~FrameAllocatorSlotLease()
+*
+*   DESCRIPTION:
+*       Return the exiting thread's slot, unless the allocator was
+*       destroyed since it was claimed.
+*
+*******************************************************************/
+
+_FrameAllocatorSlotLease::~_FrameAllocatorSlotLease()
+{
+if( slot != NO_SLOT
+ && generation == s_generation.load( std::memory_order_relaxed ) )
+    {
+    debug_assert( s_threads[ slot ].load( std::memory_order_relaxed )->scope_depth == 0 );
+    s_free_slots.fetch_or( (uint64_t)1 << slot, std::memory_order_release );
+    }
+
+} /* ~FrameAllocatorSlotLease() */
+
+
+/*******************************************************************
+*
+*   NextPage()
+*
+*   DESCRIPTION:
+*       Move the thread on to the next page in its chain which can
+*       hold the allocation, adding one if there isn't one.
+*
+*******************************************************************/
+
+static FrameAllocatorPage * NextPage( const uint64_t sz, const uint64_t alignment, FrameAllocatorThread *thread )
+{
+FrameAllocatorPage *current = thread->current;
+FrameAllocatorPage *next    = current->next;
+if( next )
+    {
+    LinearAllocator_ResetByToken( next->start, &next->allocator );
+    }
+
+if( !next
+ || !fits_in_page( sz, alignment, next ) )
+    {
+    /* link a new page in after the current one */
+    uint64_t capacity = max_of_vals( (uint64_t)FRAME_ALLOCATOR_PAGE_SIZE, sz + alignment );
+    FrameAllocatorPage *page = CreatePage( capacity );
+    page->next    = next;
+    current->next = page;
+    next          = page;
+
+    thread->overflow_page_count++;
+    }
+
+next->offset = current->offset + current->allocator.capacity;
+for( FrameAllocatorPage *page = next; page->next; page = page->next )
+    {
+    page->next->offset = page->offset + page->allocator.capacity;
+    }
+
+thread->current = next;
+return( next );
+
+} /* NextPage() */
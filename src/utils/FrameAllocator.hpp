@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+
+#include "LinearAllocator.hpp"
+#include "Utilities.hpp"
+
+#define FRAME_ALLOCATOR_PAGE_SIZE   ( 256 * 1024 )
+#define FRAME_ALLOCATOR_MAX_THREAD_COUNT \
+                                    ( 64 )
+#define FRAME_ALLOCATOR_DEFAULT_ALIGNMENT \
+                                    ( 16 )
+
+/*******************************************************************
+*
+*   FrameAllocator
+*
+*   DESCRIPTION:
+*       Per-thread scratch memory for the current frame.  Each
+*       thread bump allocates from its own chain of pages, so
+*       allocating never takes a lock.  When a page fills, the next
+*       one in the chain is used (or added), rather than failing.
+*
+*       Scopes nest like a stack.  Ending a scope rewinds the
+*       thread's allocator to where the scope began, so scratch used
+*       by a function doesn't outlive it:
+*
+*           FrameAllocatorMarker scope = FrameAllocator_BeginScope();
+*           Float2 *verts = FrameAllocator_AllocateArray( Float2, count );
+*           ...
+*           FrameAllocator_EndScope( scope );
+*
+*       FrameAllocator_EndFrame() rewinds every thread at once.  It
+*       must be called when no other thread is using its allocator,
+*       and every scope has ended.  A thread which needed more than
+*       one page has its chain merged into a single larger page, so
+*       it stops overflowing after the first frame.
+*
+*       Threads are expected to be long lived (the main thread and
+*       the thread pool's workers) - a thread's pages are kept until
+*       FrameAllocator_Destroy(), even after it exits.
+*
+*******************************************************************/
+
+typedef struct _FrameAllocatorPage
+    {
+    struct _FrameAllocatorPage
+                       *next;
+    uint64_t            offset;         /* bytes in the pages before this one */
+    LinearAllocator     allocator;
+    LinearAllocatorResetToken
+                        start;
+    } FrameAllocatorPage;
+
+typedef struct _FrameAllocatorMarker
+    {
+    FrameAllocatorPage *page;
+    LinearAllocatorResetToken
+                        token;
+    uint32_t            depth;
+    } FrameAllocatorMarker;
+
+typedef struct _FrameAllocatorStats
+    {
+    uint64_t            frame_high_water;       /* most used at once during the last frame, summed over threads */
+    uint64_t            peak_high_water;        /* largest frame high water so far */
+    uint64_t            reserved;               /* bytes of pages held by every thread */
+    uint32_t            frame_count;
+    uint32_t            thread_count;           /* allocators held, including ones kept from exited threads */
+    uint32_t            page_count;
+    uint32_t            overflow_page_count;    /* pages added during the last frame */
+    } FrameAllocatorStats;
+
+void *               FrameAllocator_Allocate( const uint64_t sz, const uint64_t alignment );
+FrameAllocatorMarker FrameAllocator_BeginScope();
+void                 FrameAllocator_Destroy();
+void                 FrameAllocator_EndFrame();
+void                 FrameAllocator_EndScope( const FrameAllocatorMarker marker );
+void                 FrameAllocator_GetStats( FrameAllocatorStats *out );
+
+
+/*******************************************************************
+*
+*   FrameAllocator_AllocateArray()
+*
+*   DESCRIPTION:
+*       Allocate an array of the given type from the calling
+*       thread's frame allocator.
+*
+*******************************************************************/
+
+#define FrameAllocator_AllocateArray( _type, _count ) \
+    (_type*)FrameAllocator_Allocate( (uint64_t)(_count) * sizeof(_type), max_of_vals( (uint64_t)alignof( _type ), (uint64_t)FRAME_ALLOCATOR_DEFAULT_ALIGNMENT ) )
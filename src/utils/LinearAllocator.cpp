@@ -1,3 +1,4 @@
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
@@ -6,6 +7,9 @@
 #include "LinearAllocator.hpp"
 #include "Utilities.hpp"
 
+compiler_assert( sizeof( std::atomic<uint64_t> ) == sizeof( uint64_t ), LinearAllocator_cpp );
+compiler_assert( sizeof( std::atomic<uint32_t> ) == sizeof( uint32_t ), LinearAllocator_cpp );
+
 
 /*******************************************************************
 *
@@ -18,6 +22,12 @@
 
 static inline uint64_t get_free_bytes( const LinearAllocator *allocator )
 {
+if( allocator->head >= allocator->capacity )
+    {
+    /* a failed concurrent allocation may leave the head past the end */
+    return( 0 );
+    }
+
 return( allocator->capacity - allocator->head );
 
 } /* get_free_bytes() */
@@ -64,6 +74,11 @@ uint64_t allocation_sz = sz + adjust;
 
 void *ret = allocate( allocation_sz, allocator );
 debug_assert( ret != NULL );
+if( ret )
+    {
+    /* skip the padding */
+    ret = (uint8_t*)ret + adjust;
+    }
 
 allocator->allocations_cnt++;
 return( ret );
@@ -71,6 +86,50 @@ return( ret );
 } /* LinearAllocator_AllocateAligned() */
 
 
+/*******************************************************************
+*
+*   LinearAllocator_AllocateConcurrent()
+*
+*   DESCRIPTION:
+*       Create an aligned allocation which may race with other
+*       concurrent allocations from the same allocator.  The head is
+*       claimed with a single atomic add, so the worst case padding
+*       for the alignment is reserved up front.  Returns NULL when
+*       the allocator is out of space.
+*
+*       Nothing else (serial allocations, resets, tokens) may use the
+*       allocator while concurrent allocations are in flight.
+*
+*******************************************************************/
+
+void * LinearAllocator_AllocateConcurrent( const uint64_t sz, const uint64_t alignment, LinearAllocator *allocator )
+{
+debug_assert( alignment > 0 );
+uint64_t reserve_sz = sz + alignment - 1;
+if( sz > allocator->capacity
+ || reserve_sz > allocator->capacity )
+    {
+    return( NULL );
+    }
+
+std::atomic<uint64_t> *head = reinterpret_cast<std::atomic<uint64_t>*>( &allocator->head );
+uint64_t start = head->fetch_add( reserve_sz, std::memory_order_relaxed );
+if( start > allocator->capacity - reserve_sz )
+    {
+    /* give the space back if no one has allocated since */
+    uint64_t expected = start + reserve_sz;
+    head->compare_exchange_strong( expected, start, std::memory_order_relaxed );
+    return( NULL );
+    }
+
+reinterpret_cast<std::atomic<uint32_t>*>( &allocator->allocations_cnt )->fetch_add( 1, std::memory_order_relaxed );
+
+uint8_t *ret = &allocator->pool[ start ];
+return( ret + align_adjust( ret, alignment ) );
+
+} /* LinearAllocator_AllocateConcurrent() */
+
+
 /*******************************************************************
 *
 *   LinearAllocator_Destroy()
@@ -25,6 +25,7 @@ typedef struct _LinearAllocatorResetToken
     
 void *                    LinearAllocator_Allocate( const uint64_t sz, LinearAllocator *allocator );
 void *                    LinearAllocator_AllocateAligned( const uint64_t sz, const uint64_t alignment, LinearAllocator *allocator );
+void *                    LinearAllocator_AllocateConcurrent( const uint64_t sz, const uint64_t alignment, LinearAllocator *allocator );
 void                      LinearAllocator_Destroy( LinearAllocator *allocator );
 void                      LinearAllocator_InitDetached( const uint64_t capacity, LinearAllocator *allocator );
 LinearAllocatorResetToken LinearAllocator_GetResetToken( LinearAllocator *allocator );
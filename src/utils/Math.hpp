@@ -1,11 +1,37 @@
 #pragma once
 #include <climits>
+#include <cstddef>
 #include <cstdint>
 
+/* vector backend, picked at compile time - see MathSimd.hpp.  MSVC has no SSE4.1 switch (or macro), so its x64 builds assume it */
+#if !defined( MATH_SCALAR )
+#if defined( __AVX__ )
+#define MATH_USE_SSE4
+#define MATH_USE_AVX
+#include <immintrin.h>
+#elif defined( __SSE4_1__ ) \
+   || ( defined( _MSC_VER ) && defined( _M_X64 ) )
+#define MATH_USE_SSE4
+#include <smmintrin.h>
+#endif
+#endif
+
 
 #define NUM_BITS_PER_BYTE \
     CHAR_BIT
 
+#define MATH_TRANSFORM_NO_PARENT \
+    UINT32_MAX
+
+/* point set reductions - sets this big are split across the thread pool, in jobs of this many points */
+#define MATH_PARALLEL_MIN_POINT_CNT \
+    ( 256 * 1024 )
+#define MATH_PARALLEL_JOB_POINT_CNT \
+    ( 64 * 1024 )
+
+struct _ThreadPool;
+typedef struct _ThreadPool ThreadPool;
+
 typedef union _Float2
     {
     float f[ 2 ];
@@ -27,7 +53,8 @@ typedef union _Float3
         } v;
     } Float3;
 
-typedef union _Float4
+/* 16 byte aligned, and passed in a single vector register where there is one */
+typedef union alignas( 16 ) _Float4
     {
     float f[ 4 ];
     struct
@@ -37,6 +64,9 @@ typedef union _Float4
         float           z;
         float           w;
         } v;
+#if defined( MATH_USE_SSE4 )
+    __m128              m;
+#endif
     } Float4;
 
 typedef Float4 Quaternion;
@@ -72,7 +102,7 @@ typedef union _Float3x3
         } n;
     } Float3x3;
 
-typedef union _Float4x4
+typedef union alignas( 16 ) _Float4x4
     {
     float f[ 4 ][ 4 ];
     struct
@@ -174,6 +204,9 @@ return( ret );
 } /* Math_Float4Make() */
 
 
+#include "MathSimd.hpp"
+
+
 typedef struct _BoundingBoxAA2D
 {
     Float2   center;
@@ -212,6 +245,21 @@ typedef struct _BoundingBoxCapsule2D
 
 }BoundingBoxCapsule2D;
 
+/* many bounding volumes, stored as columns so they can be tested a lane at a time */
+typedef struct _BoundingBoxAA3DArray
+    {
+    const float        *center[ 3 ];        /* x, y and z columns */
+    const float        *half_extent[ 3 ];
+    uint32_t            count;
+    } BoundingBoxAA3DArray;
+
+typedef struct _BoundingBoxSphere3DArray
+    {
+    const float        *center[ 3 ];        /* x, y and z columns */
+    const float        *radius;
+    uint32_t            count;
+    } BoundingBoxSphere3DArray;
+
 
 
 
@@ -224,6 +272,7 @@ float Math_floatMean( const float *array_of_floats, const int num_of_floats, con
 float Math_floatStandardDeviation( const float *array_of_floats, const int num_of_floats, const float mean_value, const size_t stride );
 void Math_Float2CoVarianceMatrix2x2( const Float2 *points, const uint32_t num_of_points, Float2x2 *output );
 void Math_Float3CoVarianceMatrix3x3( const Float3 *points, const int num_of_points, Float3x3 *output );
+void Math_Float3CoVarianceMatrix3x3Strided( const Float3 *points, const uint32_t num_of_points, const size_t stride, ThreadPool *pool, Float3 *output_mean, Float3x3 *output );
 void Math_Float2EigenDecomposition( const Float2 *array_of_points, const uint32_t number_of_points, const float tolerance, const uint32_t size_of_output_arrays, float *output_eigenvalues, Float2 *output_eigenvectors, Float2 *output_vector_origin );
 bool Math_Float3EigenDecomposition( const Float3 *array_of_points, const uint32_t number_of_points, const float tolerance, const uint32_t max_iterations, const uint32_t size_of_output_arrays, float *output_eigenvalues, Float3 *output_eigenvectors, Float3 *output_vector_origin );
 
@@ -232,28 +281,18 @@ bool Math_Float3EigenDecomposition( const Float3 *array_of_points, const uint32_
 /* Vector Math Functions*/
 /**************************/
 
+/* the Float3 and Float4 arithmetic, dot, cross and magnitude functions are inline, in MathSimd.hpp */
+
 Float2 Math_Float2Addition( const Float2 A, const Float2 B );
-Float3 Math_Float3Addition( const Float3 A, const Float3 B );
-Float4 Math_Float4Addition( const Float4 A, const Float4 B );
 
 Float2 Math_Float2Subtraction( const Float2 A, const Float2 B );
-Float3 Math_Float3Subtraction( const Float3 A, const Float3 B );
-Float4 Math_Float4Subtraction( const Float4 A, const Float4 B );
 
 Float2 Math_Float2ScalarMultiply( const Float2 A, const float scalar );
-Float3 Math_Float3ScalarMultiply( const Float3 A, const float scalar );
-Float4 Math_Float4ScalarMultiply( const Float4 A, const float scalar );
 
 Float2 Math_Float2Negative( const Float2 A );
-Float3 Math_Float3Negative( const Float3 A );
-Float4 Math_Float4Negative( const Float4 A );
 
 float Math_Float2DotProduct( const Float2 A, const Float2 B );
-float Math_Float3DotProduct( const Float3 A, const Float3 B );
-float Math_Float4DotProduct( const Float4 A, const Float4 B );
-
 
-Float3 Math_Float3CrossProduct( const Float3 A, const Float3 B );
 /* TODO Add 4D cross product function */
 
 float Math_Float2PseudoCrossProduct( const Float2 A, const Float2 B );
@@ -264,24 +303,18 @@ float Math_Float3BoxProduct( const Float3 A, const Float3 B, const Float3 C );
 /* TODO Add 4D box product */
 
 Float2 Math_Float2HadamardProduct( const Float2 a, const Float2 b );
-Float3 Math_Float3HadamardProduct( const Float3 a, const Float3 b );
-Float4 Math_Float4HadamardProduct( const Float4 a, const Float4 b );
 
 Float2 Math_Float2TripleProduct( const Float2 A, const Float2 B, const Float2 C );
 Float3 Math_Float3TripleProduct( const Float3 A, const Float3 B, const Float3 C );
-Float4 Math_Float4TripleProduct( const Float4 A, const Float4 B, const Float4 C );
+/* Math_Float4TripleProduct() is inline, in MathSimd.hpp */
 
 float Math_Float2Magnitude( const Float2 A );
-float Math_Float3Magnitude( const Float3 A );
-float Math_Float4Magnitude( const Float4 A );
 
 float Math_Float2SquareMagnitude( const Float2 A );
-float Math_Float3SquareMagnitude( const Float3 A );
-float Math_Float4SquareMagnitude( const Float4 A );
 
 float Math_Float2AngleBetween( const Float2 A, const Float2 B );
 float Math_Float3AngleBetween( const Float3 A, const Float3 B );
-float Math_Float4AngleBetween( const Float4 A, const Float4 B );
+/* Math_Float4AngleBetween() is inline, in MathSimd.hpp */
 
 bool Math_Float2IsAngleObtuse( const Float2 A, const Float2 B );
 bool Math_Float3IsAngleObtuse( const Float3 A, const Float3 B );
@@ -296,12 +329,8 @@ bool Math_Float3IsAnglePerpendicular( const Float3 A, const Float3 B );
 bool Math_Float4IsAnglePerpendicular( const Float4 A, const Float4 B );
 
 float Math_Float2DistanceBetween( const Float2 A, const Float2 B );
-float Math_Float3DistanceBetween( const Float3 A, const Float3 B );
-float Math_Float4DistanceBetween( const Float4 A, const Float4 B );
 
 float Math_Float2SquaredDistanceBetween( const Float2 A, const Float2 B );
-float Math_Float3SquaredDistanceBetween( const Float3 A, const Float3 B );
-float Math_Float4SquaredDistanceBetween( const Float4 A, const Float4 B );
 
 void Math_Float2ProjectionofPointOntoLineSegment( const Float2 line_segmentA, const Float2 line_segmentB, const Float2 test_point, Float2 *output_point, float *distance_from_A );
 void Math_Float3ProjectionofPointOntoLineSegment( const Float3 line_segmentA, const Float3 line_segmentB, const Float3 test_point, Float3 *output_point, float *distance_from_A );
@@ -316,7 +345,8 @@ bool Math_Float3LineSegmentIntersection( const Float3 A, const Float3 B, const F
 /*****************************/
 /* Quaternion Math Functions */
 /*****************************/
-void Math_QuaternionToFloat4x4( const Quaternion in, Float4x4 *out );
+
+/* Math_QuaternionToFloat4x4() is inline, in MathSimd.hpp */
 
 
 /*****************************/
@@ -330,11 +360,13 @@ void Math_Float4x4MakeTranslateFromFloat3( const Float3 translation, Float4x4 *o
 
 void Math_Float3x3MakeRotation( const float theta, Float3x3 *out );
 
+/* Math_Float4x4MultiplyByFloat4x4() and Math_Float4x4TransformSpin() are inline, in MathSimd.hpp */
+void Math_Float4x4TransformSpinBatch( const Float3 *translation, const Quaternion *rotation, const Float3 *scale, const uint32_t count, Float4x4 *out );
+void Math_Float4x4TransformSpinHierarchy( const Float3 *translation, const Quaternion *rotation, const Float3 *scale, const uint32_t *parent, const uint32_t count, Float4x4 *out );
+
 void Math_Float3x3MultiplyByFloat3x3( const Float3x3 *a, const Float3x3 *b, Float3x3 *out );
-void Math_Float4x4MultiplyByFloat4x4( const Float4x4 *a, const Float4x4 *b, Float4x4 *out );
 
 void Math_Float3x3TransformSpin( const Float2 translation, const float rotation, const Float2 scale, Float3x3 *out );
-void Math_Float4x4TransformSpin( const Float3 translation, const Quaternion rotation, const Float3 scale, Float4x4 *out );
 void Math_Float2x2ScalebyFloat( const Float2x2 *input_matrix, const float scale, Float2x2 *output_matrix );
 void Math_Float3x3ScalebyFloat( const Float3x3 *input_matrix, const float scale, Float3x3 *output_matrix );
 void Math_Float4x4ScalebyFloat( const Float4x4 *input_matrix, const float scale, Float4x4 *output_matrix );
@@ -358,12 +390,39 @@ void Math_Float3x3MatrixFromVectors( const Float3 vector_A, const Float3 vector_
 void Math_Float2x2EigenValuesVectors( const Float2x2 *input_matrix, const float tolerance, const uint32_t output_capacity, float *output_eigenvalues, Float2 *output_eigenvectors );
 bool Math_Float3x3EigenValuesVectors( const Float3x3 *input_matrix, const uint32_t max_iterations, const float tolerance, const uint32_t output_capacity, float *output_eigenvalues, Float3 *output_eigenvectors );
 
+/*************************/
+/*  Collision Functions  */
+/*************************/
+
+float Math_Float2CollisionPointToLineDistance( const Float2 line_origin, const Float2 line_normal_vector, const Float2 test_point );
+float Math_Float3CollisionPointToPlaneDistance( const Float3 plane_origin, const Float3 plane_normal_vector, const Float3 test_point );
+Float2 Math_Float2CollisionPointToLineNearestPointOnLine( const Float2 line_origin, const Float2 line_normal_vector, const Float2 test_point );
+Float3 Math_Float3CollisionPointToPlaneNearestPointOnPlane( const Float3 plane_origin, const Float3 plane_normal_vector, const Float3 test_point );
+bool Math_Float2CollisionPointToAABB( const Float2 test_point, const BoundingBoxAA2D bounding_box );
+bool Math_Float3CollisionPointToAABB( const Float3 test_point, const BoundingBoxAA3D bounding_box );
+bool Math_Float2CollisionPointToSphereBB( const Float2 test_point, const BoundingBoxSphere2D bounding_box );
+bool Math_Float3CollisionPointToSphereBB( const Float3 test_point, const BoundingBoxSphere3D bounding_box );
+bool Math_Float2CollisionAABBToAABB( const BoundingBoxAA2D bounding_box_A, const BoundingBoxAA2D bounding_box_B );
+bool Math_Float3CollisionAABBToAABB( const BoundingBoxAA3D bounding_box_A, const BoundingBoxAA3D bounding_box_B );
+bool Math_Float2CollisionAABBToSphereBB( const BoundingBoxAA2D bounding_box, const BoundingBoxSphere2D bounding_sphere );
+bool Math_Float3CollisionAABBToSphereBB( const BoundingBoxAA3D bounding_box, const BoundingBoxSphere3D bounding_sphere );
+bool Math_Float2CollisionAABBToSphereBBDoTheyIntersect( const BoundingBoxSphere2D bounding_sphere_A, const BoundingBoxSphere2D bounding_sphere_B );
+bool Math_Float3CollisionAABBToSphereBBDoTheyIntersect( const BoundingBoxSphere3D bounding_sphere_A, const BoundingBoxSphere3D bounding_sphere_B );
+
+/* hit bits are packed as by Math_BitArraySet(), in uint32_t words */
+void Math_Float3CollisionAABBToAABBBatch( const BoundingBoxAA3D bounding_box, const BoundingBoxAA3DArray *bounding_boxes, uint32_t *hits );
+void Math_Float3CollisionAABBToSphereBBBatch( const BoundingBoxAA3D bounding_box, const BoundingBoxSphere3DArray *bounding_spheres, uint32_t *hits );
+void Math_Float3CollisionAABBToAABBAllPairs( const BoundingBoxAA3DArray *bounding_boxes_A, const BoundingBoxAA3DArray *bounding_boxes_B, uint32_t *hits );
+void Math_Float3CollisionAABBToSphereBBAllPairs( const BoundingBoxAA3DArray *bounding_boxes, const BoundingBoxSphere3DArray *bounding_spheres, uint32_t *hits );
+
 /*************************/
 /* Bounding Box Functions */
 /*************************/
 
 void Math_GenerateAxisAlignedBoundingBox2D(const Float2 *vertices, const int num_of_vertices, BoundingBoxAA2D *bounding_box );
 void Math_GenerateAxisAlignedBoundingBox3D( const Float3 *vertices, const int num_of_vertices, BoundingBoxAA3D *bounding_box );
+void Math_GenerateAxisAlignedBoundingBox3DStrided( const Float3 *vertices, const uint32_t num_of_vertices, const size_t stride, ThreadPool *pool, BoundingBoxAA3D *bounding_box );
+void Math_Float3MinMax( const Float3 *points, const uint32_t num_of_points, const size_t stride, ThreadPool *pool, Float3 *output_min, Float3 *output_max );
 void Math_GenerateBoundingBoxSpherefromAABB2D( const BoundingBoxAA2D *AABB_bounding_box, BoundingBoxSphere2D *bounding_sphere );
 void Math_GenerateBoundingBoxSpherefromAABB3D( const BoundingBoxAA3D *AABB_bounding_box, BoundingBoxSphere3D *bounding_sphere );
 void Math_GenerateCapsuleBoundingBox2D( const Float2 *vertices, const uint32_t num_of_vertices, const float tolerance, BoundingBoxCapsule2D *bounding_box );
@@ -1,9 +1,22 @@
 #include <cstdio>
 
+#include "FrameAllocator.hpp"
 #include "Math.hpp"
+#include "ThreadPool.hpp"
 #include "Utilities.hpp"
 
 
+typedef struct _MinMaxRange
+    {
+    const uint8_t      *points;
+    uint32_t            count;
+    size_t              stride;
+    bool                has_last;       /* holds the last point of the array, which can't be over-read */
+    Float3              min;
+    Float3              max;
+    } MinMaxRange;
+
+static void MinMaxJob( void *user );
 void Math_TightenCapsuleBB2DEndpoints( const Float2 *vertices, const uint32_t num_of_vertices, const Float2 *eigenvectors, const float bounding_sphere_radius, const bool point_A, Float2 *bounding_box_point );
 
 /*******************************************************************
@@ -77,64 +90,111 @@ void Math_GenerateAxisAlignedBoundingBox2D(const Float2 *vertices, const int num
 
 void Math_GenerateAxisAlignedBoundingBox3D( const Float3 *vertices, const int num_of_vertices, BoundingBoxAA3D *bounding_box )
 {
+Math_GenerateAxisAlignedBoundingBox3DStrided( vertices, (uint32_t)num_of_vertices, 0, NULL, bounding_box );
 
-    bounding_box->center = {};
-    bounding_box->half_extent = {};
+} /* Math_GenerateAxisAlignedBoundingBox3D() */
 
-    float min_x = vertices[0].v.x;
-    float max_x = vertices[0].v.x;
-    float min_y = vertices[0].v.y;
-    float max_y = vertices[0].v.y;
-    float min_z = vertices[0].v.z;
-    float max_z = vertices[0].v.z;
 
-    // crudely find the max and min values for x and y
-    for( int i = 1; i < num_of_vertices; i++ )
+/*******************************************************************
+*
+*   Math_GenerateAxisAlignedBoundingBox3DStrided()
+*
+*   DESCRIPTION:
+*       Generate an AABB bounding box for vertices that are stride
+*       bytes apart, such as the positions in an interleaved vertex
+*       buffer.  Pass 0 for stride if the vertices are packed.
+*       Large vertex sets are split across the pool, which may be
+*       NULL.
+*
+*******************************************************************/
+
+void Math_GenerateAxisAlignedBoundingBox3DStrided( const Float3 *vertices, const uint32_t num_of_vertices, const size_t stride, ThreadPool *pool, BoundingBoxAA3D *bounding_box )
+{
+Float3 min;
+Float3 max;
+Math_Float3MinMax( vertices, num_of_vertices, stride, pool, &min, &max );
+
+for( uint32_t i = 0; i < 3; i++ )
     {
-        if( vertices[i].v.x < min_x )
-        {
-            min_x = vertices[i].v.x;
-        }
-        else if( vertices[i].v.x > max_x )
-        {
-            max_x = vertices[i].v.x;
-        }
+    float half_extent = 0.5f * ( max.f[ i ] - min.f[ i ] );
+    bounding_box->center.f[ i ]      = min.f[ i ] + half_extent;
+    bounding_box->half_extent.f[ i ] = half_extent;
+    }
 
-        if( vertices[i].v.y < min_y )
-        {
-            min_y = vertices[i].v.y;
-        }
-        else if( vertices[i].v.y > max_y )
-        {
-            max_y = vertices[i].v.y;
-        }
+} /* Math_GenerateAxisAlignedBoundingBox3DStrided() */
 
-        if( vertices[i].v.z < min_z )
-        {
-            min_y = vertices[i].v.z;
-        }
-        else if( vertices[i].v.z > max_z )
-        {
-            max_y = vertices[i].v.z;
-        }
 
+/*******************************************************************
+*
+*   Math_Float3MinMax()
+*
+*   DESCRIPTION:
+*       Find the per-component minimum and maximum of points that
+*       are stride bytes apart (0 if packed).  Sets of at least
+*       MATH_PARALLEL_MIN_POINT_CNT points are split across the
+*       pool, if there is one.
+*
+*******************************************************************/
+
+void Math_Float3MinMax( const Float3 *points, const uint32_t num_of_points, const size_t stride, ThreadPool *pool, Float3 *output_min, Float3 *output_max )
+{
+debug_assert( num_of_points > 0 );
+size_t the_stride = stride ? stride : sizeof(*points);
+debug_assert( the_stride >= sizeof(*points) );
+
+uint32_t job_count = ( num_of_points + MATH_PARALLEL_JOB_POINT_CNT - 1 ) / MATH_PARALLEL_JOB_POINT_CNT;
+if( job_count == 1 )
+    {
+    MinMaxRange range = {};
+    range.points   = (const uint8_t*)points;
+    range.count    = num_of_points;
+    range.stride   = the_stride;
+    range.has_last = true;
+    MinMaxJob( &range );
+
+    *output_min = range.min;
+    *output_max = range.max;
+    return;
     }
 
-    // find midpoint between max and min
-    float size_x = 0.5f * (max_x - min_x);
-    float size_y = 0.5f * (max_y - min_y);
-    float size_z = 0.5f * (max_z - min_z);
+if( num_of_points < MATH_PARALLEL_MIN_POINT_CNT )
+    {
+    pool = NULL;
+    }
 
-    //output to the component
-    bounding_box->center.v.x = min_x + size_x;
-    bounding_box->center.v.y = min_y + size_y;
-    bounding_box->center.v.z = min_z + size_z;
-    bounding_box->half_extent.v.x = size_x;
-    bounding_box->half_extent.v.y = size_y;
-    bounding_box->half_extent.v.z = size_z;
+FrameAllocatorMarker scope = FrameAllocator_BeginScope();
+MinMaxRange *ranges = FrameAllocator_AllocateArray( MinMaxRange, job_count );
+
+ThreadPoolCounter counter;
+ThreadPool_InitCounter( &counter );
+for( uint32_t i = 0; i < job_count; i++ )
+    {
+    uint32_t first = i * MATH_PARALLEL_JOB_POINT_CNT;
+    MinMaxRange *range = &ranges[ i ];
+    *range = {};
+    range->points   = (const uint8_t*)points + first * the_stride;
+    range->count    = min_of_vals( MATH_PARALLEL_JOB_POINT_CNT, num_of_points - first );
+    range->stride   = the_stride;
+    range->has_last = ( i == job_count - 1 );
+    ThreadPool_Submit( MinMaxJob, range, &counter, pool );
+    }
 
+ThreadPool_WaitForCounter( &counter, pool );
 
-}/* Math_GenerateAxisAlignedBoundingBox3D()*/
+*output_min = ranges[ 0 ].min;
+*output_max = ranges[ 0 ].max;
+for( uint32_t i = 1; i < job_count; i++ )
+    {
+    for( uint32_t j = 0; j < 3; j++ )
+        {
+        output_min->f[ j ] = min_of_vals( output_min->f[ j ], ranges[ i ].min.f[ j ] );
+        output_max->f[ j ] = max_of_vals( output_max->f[ j ], ranges[ i ].max.f[ j ] );
+        }
+    }
+
+FrameAllocator_EndScope( scope );
+
+} /* Math_Float3MinMax() */
 
 
 /*******************************************************************
@@ -334,42 +394,25 @@ for( uint32_t i = 1; i < 4; i++ )
     }
 }
 
-Float2 *test_verts = (Float2 *)malloc( num_of_vertices * sizeof( Float2 ) );
-uint32_t dummy_index = 0;
-
+// find the furthest vertex inside the dummy AABB from the new capsule sphere center, in one pass
+Float2 max_vert = {};
+float max_dsq = 0.0;
+float dum_val = 0.0;
 for( uint32_t i = 0; i < num_of_vertices; i++ )
 {
-    if( vertices[i].v.x < dummy_min_x )
+    if( vertices[i].v.x < dummy_min_x
+     || vertices[i].v.x > dummy_max_x
+     || vertices[i].v.y < dummy_min_y
+     || vertices[i].v.y > dummy_max_y )
     {
         continue;
     }
-    else if( vertices[i].v.x > dummy_max_x )
-    {
-        continue;
-    }
-    else if( vertices[i].v.y < dummy_min_y )
-    {
-        continue;
-    }
-    else if( vertices[i].v.y > dummy_max_y )
-    {
-        continue;
-    }
-    test_verts[dummy_index] = vertices[i];
-    dummy_index++;
-}
 
-// find the furthest test_vert from the new capsule sphere center
-uint32_t max_index = 0;
-float max_dsq = 0.0;
-float dum_val = 0.0;
-for( uint32_t i = 0; i < dummy_index; i++ )
-{
-    dum_val = Math_Float2SquareMagnitude( Math_Float2Subtraction( test_verts[i], P_prime ) );
+    dum_val = Math_Float2SquareMagnitude( Math_Float2Subtraction( vertices[i], P_prime ) );
     if( dum_val > max_dsq )
     {
         max_dsq = dum_val;
-        max_index = i;
+        max_vert = vertices[i];
     }
 }
 
@@ -378,8 +421,8 @@ if( max_dsq > (bounding_sphere_radius * bounding_sphere_radius) )
     float alpha = 0.0;
     float beta = 0.0;
 
-    beta = Math_Float2DotProduct( Math_Float2Subtraction( P_prime, test_verts[max_index] ), eigenvectors[0] );
-    alpha = Math_Float2DotProduct( Math_Float2Subtraction( P_prime, test_verts[max_index] ), eigenvectors[1] );
+    beta = Math_Float2DotProduct( Math_Float2Subtraction( P_prime, max_vert ), eigenvectors[0] );
+    alpha = Math_Float2DotProduct( Math_Float2Subtraction( P_prime, max_vert ), eigenvectors[1] );
 
     switch( point_A )
         {
@@ -393,8 +436,71 @@ if( max_dsq > (bounding_sphere_radius * bounding_sphere_radius) )
 
 }
 
+}/* Math_TightenCapsuleBB2DEndpoints() */
+
+
+/*******************************************************************
+*
+*   MinMaxJob()
+*
+*   DESCRIPTION:
+*       Find the minimum and maximum of one range of points.  Four
+*       running minimums and maximums are kept, so the loads aren't
+*       held up by the chain of compares.
+*
+*******************************************************************/
+
+static void MinMaxJob( void *user )
+{
+MinMaxRange *range = (MinMaxRange*)user;
+debug_assert( range->count > 0 );
+
+#define point_at( _i ) \
+    ( (const Float3*)( range->points + (size_t)( _i ) * range->stride ) )
+
+#if defined( MATH_USE_SSE4 )
+uint32_t safe_count = range->count - ( range->has_last ? 1 : 0 );
+__m128 first = math_load_point( point_at( 0 ), safe_count == 0 );
 
+__m128 lo[ 4 ] = { first, first, first, first };
+__m128 hi[ 4 ] = { first, first, first, first };
 
-free( test_verts );
+uint32_t i = 0;
+for( ; i + 4 <= safe_count; i += 4 )
+    {
+    for( uint32_t j = 0; j < 4; j++ )
+        {
+        __m128 point = _mm_loadu_ps( point_at( i + j )->f );
+        lo[ j ] = _mm_min_ps( lo[ j ], point );
+        hi[ j ] = _mm_max_ps( hi[ j ], point );
+        }
+    }
+
+for( ; i < range->count; i++ )
+    {
+    __m128 point = math_load_point( point_at( i ), i >= safe_count );
+    lo[ 0 ] = _mm_min_ps( lo[ 0 ], point );
+    hi[ 0 ] = _mm_max_ps( hi[ 0 ], point );
+    }
+
+Float4 min = math_make_float4( _mm_min_ps( _mm_min_ps( lo[ 0 ], lo[ 1 ] ), _mm_min_ps( lo[ 2 ], lo[ 3 ] ) ) );
+Float4 max = math_make_float4( _mm_max_ps( _mm_max_ps( hi[ 0 ], hi[ 1 ] ), _mm_max_ps( hi[ 2 ], hi[ 3 ] ) ) );
+range->min = Math_Float3Make( min.v.x, min.v.y, min.v.z );
+range->max = Math_Float3Make( max.v.x, max.v.y, max.v.z );
+
+#else
+range->min = *point_at( 0 );
+range->max = *point_at( 0 );
+for( uint32_t i = 1; i < range->count; i++ )
+    {
+    const Float3 *point = point_at( i );
+    for( uint32_t j = 0; j < 3; j++ )
+        {
+        range->min.f[ j ] = min_of_vals( range->min.f[ j ], point->f[ j ] );
+        range->max.f[ j ] = max_of_vals( range->max.f[ j ], point->f[ j ] );
+        }
+    }
 
-}/* Math_TightenCapsuleBB2DEndpoints() */
\ No newline at end of file
+#endif
+#undef point_at
+} /* MinMaxJob() */
@@ -1,7 +1,234 @@
+#include <cfloat>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include "Math.hpp"
+#include "Utilities.hpp"
+
+#define HIT_WORD_BIT_CNT            ( 32 )      /* boxes per hit word, and per tile of the all pairs tests */
+#define TILE_CHUNK_CNT              ( 64 )      /* tiles whose bounds are held at once */
+#define TILE_MARGIN                 ( 4.0f * FLT_EPSILON )
+                                                /* relative padding on tile bounds, so rounding never culls a hit */
+compiler_assert( TILE_CHUNK_CNT <= 8 * sizeof(uint64_t), math_collision_cpp );
+
+/* a lane per box - eight under AVX, four under SSE4.1 */
+#if defined( MATH_USE_AVX )
+#define BATCH_WIDTH                 ( 8 )
+typedef __m256 Lanes;
+#define lanes_abs( _v )             _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), _v )
+#define lanes_add                   _mm256_add_ps
+#define lanes_and                   _mm256_and_ps
+#define lanes_load                  _mm256_loadu_ps
+#define lanes_mask                  _mm256_movemask_ps
+#define lanes_not_greater( _a, _b ) _mm256_cmp_ps( _a, _b, _CMP_NGT_UQ )
+#define lanes_set1                  _mm256_set1_ps
+#define lanes_sub                   _mm256_sub_ps
+#elif defined( MATH_USE_SSE4 )
+#define BATCH_WIDTH                 ( 4 )
+typedef __m128 Lanes;
+#define lanes_abs( _v )             _mm_andnot_ps( _mm_set1_ps( -0.0f ), _v )
+#define lanes_add                   _mm_add_ps
+#define lanes_and                   _mm_and_ps
+#define lanes_load                  _mm_loadu_ps
+#define lanes_mask                  _mm_movemask_ps
+#define lanes_not_greater( _a, _b ) _mm_cmpngt_ps( _a, _b )
+#define lanes_set1                  _mm_set1_ps
+#define lanes_sub                   _mm_sub_ps
+#endif
+
+typedef struct _BoxQuery
+    {
+    BoundingBoxAA3D     box;
+    Float3              lo;             /* padded bounds, for testing against tiles */
+    Float3              hi;
+#if defined( MATH_USE_SSE4 )
+    Lanes               center[ 3 ];    /* the box, in every lane */
+    Lanes               half_extent[ 3 ];
+#endif
+    } BoxQuery;
+
+typedef struct _TileBounds
+    {
+    Float3              lo;             /* padded */
+    Float3              hi;
+    } TileBounds;
+
+static void TestAllPairs( const BoundingBoxAA3DArray *boxes_a, const BoundingBoxAA3DArray *boxes_b, uint32_t *hits );
+static void TestBatch( const BoundingBoxAA3D box, const BoundingBoxAA3DArray *boxes, uint32_t *hits );
+
+
+/*******************************************************************
+*
+*   box_hit()
+*
+*   DESCRIPTION:
+*       Do the query box and a box of the array intersect?  The same
+*       test as Math_Float3CollisionAABBToAABB().
+*
+*******************************************************************/
+
+static inline bool box_hit( const BoxQuery *query, const BoundingBoxAA3DArray *boxes, const uint32_t index )
+{
+for( uint32_t i = 0; i < 3; i++ )
+    {
+    if( fabsf( query->box.center.f[ i ] - boxes->center[ i ][ index ] ) > ( query->box.half_extent.f[ i ] + boxes->half_extent[ i ][ index ] ) )
+        {
+        return( false );
+        }
+    }
+
+return( true );
+
+} /* box_hit() */
+
+
+/*******************************************************************
+*
+*   box_overlaps_tile()
+*
+*   DESCRIPTION:
+*       Might the query box intersect any box of the tile?
+*
+*******************************************************************/
+
+static inline bool box_overlaps_tile( const BoxQuery *query, const TileBounds *tile )
+{
+return( query->lo.v.x <= tile->hi.v.x && tile->lo.v.x <= query->hi.v.x
+     && query->lo.v.y <= tile->hi.v.y && tile->lo.v.y <= query->hi.v.y
+     && query->lo.v.z <= tile->hi.v.z && tile->lo.v.z <= query->hi.v.z );
+
+} /* box_overlaps_tile() */
+
+
+/*******************************************************************
+*
+*   make_query()
+*
+*   DESCRIPTION:
+*       Set up a box to be tested against many.
+*
+*******************************************************************/
+
+static inline void make_query( const BoundingBoxAA3D box, BoxQuery *query )
+{
+query->box = box;
+for( uint32_t i = 0; i < 3; i++ )
+    {
+    float pad = ( fabsf( box.center.f[ i ] ) + box.half_extent.f[ i ] ) * TILE_MARGIN;
+    query->lo.f[ i ] = box.center.f[ i ] - box.half_extent.f[ i ] - pad;
+    query->hi.f[ i ] = box.center.f[ i ] + box.half_extent.f[ i ] + pad;
+#if defined( MATH_USE_SSE4 )
+    query->center[ i ]      = lanes_set1( box.center.f[ i ] );
+    query->half_extent[ i ] = lanes_set1( box.half_extent.f[ i ] );
+#endif
+    }
+
+} /* make_query() */
+
+
+/*******************************************************************
+*
+*   make_tile_bounds()
+*
+*   DESCRIPTION:
+*       Bound the tile of boxes starting at first, padded so that
+*       a box the exact test would hit is never outside it.
+*
+*******************************************************************/
+
+static inline void make_tile_bounds( const BoundingBoxAA3DArray *boxes, const uint32_t first, TileBounds *tile )
+{
+uint32_t end = min_of_vals( first + HIT_WORD_BIT_CNT, boxes->count );
+for( uint32_t i = 0; i < 3; i++ )
+    {
+    float lo = boxes->center[ i ][ first ] - boxes->half_extent[ i ][ first ];
+    float hi = boxes->center[ i ][ first ] + boxes->half_extent[ i ][ first ];
+    for( uint32_t j = first + 1; j < end; j++ )
+        {
+        lo = min_of_vals( lo, boxes->center[ i ][ j ] - boxes->half_extent[ i ][ j ] );
+        hi = max_of_vals( hi, boxes->center[ i ][ j ] + boxes->half_extent[ i ][ j ] );
+        }
+
+    float pad = max_of_vals( fabsf( lo ), fabsf( hi ) ) * TILE_MARGIN;
+    tile->lo.f[ i ] = lo - pad;
+    tile->hi.f[ i ] = hi + pad;
+    }
+
+} /* make_tile_bounds() */
+
+
+/*******************************************************************
+*
+*   sphere_columns()
+*
+*   DESCRIPTION:
+*       View spheres as the boxes which bound them, which is how
+*       Math_Float3CollisionAABBToSphereBB() tests them.
+*
+*******************************************************************/
+
+static inline BoundingBoxAA3DArray sphere_columns( const BoundingBoxSphere3DArray *spheres )
+{
+BoundingBoxAA3DArray ret;
+for( uint32_t i = 0; i < 3; i++ )
+    {
+    ret.center[ i ]      = spheres->center[ i ];
+    ret.half_extent[ i ] = spheres->radius;
+    }
+
+ret.count = spheres->count;
+
+return( ret );
+
+} /* sphere_columns() */
+
+
+/*******************************************************************
+*
+*   test_word()
+*
+*   DESCRIPTION:
+*       Test the query box against the boxes of one hit word,
+*       starting at first, a lane at a time.
+*
+*******************************************************************/
+
+static inline uint32_t test_word( const BoxQuery *query, const BoundingBoxAA3DArray *boxes, const uint32_t first )
+{
+uint32_t cnt  = min_of_vals( boxes->count - first, (uint32_t)HIT_WORD_BIT_CNT );
+uint32_t bits = 0;
+uint32_t i    = 0;
+
+#if defined( MATH_USE_SSE4 )
+for( ; i + BATCH_WIDTH <= cnt; i += BATCH_WIDTH )
+    {
+    Lanes hit = lanes_set1( 0.0f );
+    for( uint32_t j = 0; j < 3; j++ )
+        {
+        Lanes distance = lanes_abs( lanes_sub( query->center[ j ], lanes_load( &boxes->center[ j ][ first + i ] ) ) );
+        Lanes reach    = lanes_add( query->half_extent[ j ], lanes_load( &boxes->half_extent[ j ][ first + i ] ) );
+        Lanes axis_hit = lanes_not_greater( distance, reach );
+        hit = j ? lanes_and( hit, axis_hit ) : axis_hit;
+        }
+
+    bits |= (uint32_t)lanes_mask( hit ) << i;
+    }
+
+#endif
+for( ; i < cnt; i++ )
+    {
+    if( box_hit( query, boxes, first + i ) )
+        {
+        bits |= 1u << i;
+        }
+    }
+
+return( bits );
+
+} /* test_word() */
+
 
 
 /*******************************************************************
@@ -348,4 +575,184 @@ bool Math_Float3CollisionAABBToSphereBBDoTheyIntersect( const BoundingBoxSphere3
 
     return true;
 
-}/* Math_Float3CollisionAABBToSphereBBDoTheyIntersect() */
\ No newline at end of file
+}/* Math_Float3CollisionAABBToSphereBBDoTheyIntersect() */
+
+
+/*******************************************************************
+*
+*   Math_Float3CollisionAABBToAABBAllPairs()
+*
+*   DESCRIPTION:
+*       Test every box of A against every box of B.  hits gets a row
+*       of MATH_BITARRAY_COUNT( uint32_t, B count ) words for each
+*       box of A, with the bits set for the boxes of B it intersects,
+*       as by Math_Float3CollisionAABBToAABB().  Boxes are tested in
+*       tiles of 32, and tiles whose bounds are apart are skipped.
+*       Pass the same array twice for every pair within one set.
+*
+*******************************************************************/
+
+void Math_Float3CollisionAABBToAABBAllPairs( const BoundingBoxAA3DArray *bounding_boxes_A, const BoundingBoxAA3DArray *bounding_boxes_B, uint32_t *hits )
+{
+TestAllPairs( bounding_boxes_A, bounding_boxes_B, hits );
+
+} /* Math_Float3CollisionAABBToAABBAllPairs() */
+
+
+/*******************************************************************
+*
+*   Math_Float3CollisionAABBToAABBBatch()
+*
+*   DESCRIPTION:
+*       Test a box against an array of boxes, setting the bit in hits
+*       of each one it intersects, as by
+*       Math_Float3CollisionAABBToAABB().  hits must hold
+*       MATH_BITARRAY_COUNT( uint32_t, count ) words.
+*
+*******************************************************************/
+
+void Math_Float3CollisionAABBToAABBBatch( const BoundingBoxAA3D bounding_box, const BoundingBoxAA3DArray *bounding_boxes, uint32_t *hits )
+{
+TestBatch( bounding_box, bounding_boxes, hits );
+
+} /* Math_Float3CollisionAABBToAABBBatch() */
+
+
+/*******************************************************************
+*
+*   Math_Float3CollisionAABBToSphereBBAllPairs()
+*
+*   DESCRIPTION:
+*       Math_Float3CollisionAABBToAABBAllPairs() for boxes against
+*       spheres, with the test of Math_Float3CollisionAABBToSphereBB().
+*
+*******************************************************************/
+
+void Math_Float3CollisionAABBToSphereBBAllPairs( const BoundingBoxAA3DArray *bounding_boxes, const BoundingBoxSphere3DArray *bounding_spheres, uint32_t *hits )
+{
+BoundingBoxAA3DArray spheres = sphere_columns( bounding_spheres );
+TestAllPairs( bounding_boxes, &spheres, hits );
+
+} /* Math_Float3CollisionAABBToSphereBBAllPairs() */
+
+
+/*******************************************************************
+*
+*   Math_Float3CollisionAABBToSphereBBBatch()
+*
+*   DESCRIPTION:
+*       Math_Float3CollisionAABBToAABBBatch() for a box against
+*       spheres, with the test of Math_Float3CollisionAABBToSphereBB().
+*
+*******************************************************************/
+
+void Math_Float3CollisionAABBToSphereBBBatch( const BoundingBoxAA3D bounding_box, const BoundingBoxSphere3DArray *bounding_spheres, uint32_t *hits )
+{
+BoundingBoxAA3DArray spheres = sphere_columns( bounding_spheres );
+TestBatch( bounding_box, &spheres, hits );
+
+} /* Math_Float3CollisionAABBToSphereBBBatch() */
+
+
+/*******************************************************************
+*
+*   TestAllPairs()
+*
+*   DESCRIPTION:
+*       Test every box of A against every box of B, a chunk of B's
+*       tiles at a time.  A tile of A is first tested against each
+*       tile bound, then each of its boxes, so the lanes only run
+*       where boxes might meet.
+*
+*******************************************************************/
+
+static void TestAllPairs( const BoundingBoxAA3DArray *boxes_a, const BoundingBoxAA3DArray *boxes_b, uint32_t *hits )
+{
+if( !boxes_a->count
+ || !boxes_b->count )
+    {
+    return;
+    }
+
+uint32_t   row_word_cnt = MATH_BITARRAY_COUNT( uint32_t, boxes_b->count );
+TileBounds tiles_b[ TILE_CHUNK_CNT ];
+
+for( uint32_t first_word = 0; first_word < row_word_cnt; first_word += TILE_CHUNK_CNT )
+    {
+    uint32_t chunk_cnt = min_of_vals( row_word_cnt - first_word, (uint32_t)TILE_CHUNK_CNT );
+    for( uint32_t i = 0; i < chunk_cnt; i++ )
+        {
+        make_tile_bounds( boxes_b, ( first_word + i ) * HIT_WORD_BIT_CNT, &tiles_b[ i ] );
+        }
+
+    for( uint32_t first_a = 0; first_a < boxes_a->count; first_a += HIT_WORD_BIT_CNT )
+        {
+        TileBounds tile_a;
+        make_tile_bounds( boxes_a, first_a, &tile_a );
+
+        uint64_t tile_hits = 0;
+        for( uint32_t i = 0; i < chunk_cnt; i++ )
+            {
+            if( tile_a.lo.v.x <= tiles_b[ i ].hi.v.x && tiles_b[ i ].lo.v.x <= tile_a.hi.v.x
+             && tile_a.lo.v.y <= tiles_b[ i ].hi.v.y && tiles_b[ i ].lo.v.y <= tile_a.hi.v.y
+             && tile_a.lo.v.z <= tiles_b[ i ].hi.v.z && tiles_b[ i ].lo.v.z <= tile_a.hi.v.z )
+                {
+                tile_hits |= (uint64_t)1 << i;
+                }
+            }
+
+        uint32_t end_a = min_of_vals( first_a + HIT_WORD_BIT_CNT, boxes_a->count );
+        for( uint32_t a = first_a; a < end_a; a++ )
+            {
+            uint32_t *row = &hits[ (size_t)a * row_word_cnt + first_word ];
+            if( !tile_hits )
+                {
+                memset( row, 0, chunk_cnt * sizeof( *row ) );
+                continue;
+                }
+
+            BoundingBoxAA3D box;
+            for( uint32_t j = 0; j < 3; j++ )
+                {
+                box.center.f[ j ]      = boxes_a->center[ j ][ a ];
+                box.half_extent.f[ j ] = boxes_a->half_extent[ j ][ a ];
+                }
+
+            BoxQuery query;
+            make_query( box, &query );
+            for( uint32_t i = 0; i < chunk_cnt; i++ )
+                {
+                row[ i ] = 0;
+                if( ( tile_hits >> i ) & 1
+                 && box_overlaps_tile( &query, &tiles_b[ i ] ) )
+                    {
+                    row[ i ] = test_word( &query, boxes_b, ( first_word + i ) * HIT_WORD_BIT_CNT );
+                    }
+                }
+            }
+        }
+    }
+
+} /* TestAllPairs() */
+
+
+/*******************************************************************
+*
+*   TestBatch()
+*
+*   DESCRIPTION:
+*       Test a box against an array of boxes, a hit word at a time.
+*
+*******************************************************************/
+
+static void TestBatch( const BoundingBoxAA3D box, const BoundingBoxAA3DArray *boxes, uint32_t *hits )
+{
+BoxQuery query;
+make_query( box, &query );
+
+for( uint32_t first = 0; first < boxes->count; first += HIT_WORD_BIT_CNT )
+    {
+    hits[ first / HIT_WORD_BIT_CNT ] = test_word( &query, boxes, first );
+    }
+
+} /* TestBatch() */
@@ -10,6 +10,33 @@ void Math_Float3x3TransformToSymmetricTridiagonalMatrix( const Float3x3 *input_m
 bool Math_Float3x3DominateEigenValueVector( const Float3x3 *input_matrix, const uint32_t max_iterations, const float tolerance, float *output_eigenvalue, Float3 *output_eigenvector );
 void Math_Float3x3NextDominateEigenValueVector( const Float3x3 *input_matrix, const float tolerance, const float dominate_eigenvalue, const Float3 dominate_eigenvector, float *output_eigenvalue, Float3 *output_eigenvector );
 
+#define HIERARCHY_BLOCK_CNT         ( 256 )     /* transforms built before their parents are applied, so they're still in cache */
+
+/* a batch is held as lanes, one transform per lane - under AVX the upper 128 bits are the four transforms after the lower */
+#if defined( MATH_USE_AVX )
+#define BATCH_WIDTH                 ( 8 )
+typedef __m256 Lanes;
+#define lanes_add                   _mm256_add_ps
+#define lanes_load( _lo, _hi )      _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( _lo ) ), _mm_loadu_ps( _hi ), 1 )
+#define lanes_mul                   _mm256_mul_ps
+#define lanes_set1                  _mm256_set1_ps
+#define lanes_shuffle               _mm256_shuffle_ps
+#define lanes_sub                   _mm256_sub_ps
+#define lanes_unpackhi              _mm256_unpackhi_ps
+#define lanes_unpacklo              _mm256_unpacklo_ps
+#elif defined( MATH_USE_SSE4 )
+#define BATCH_WIDTH                 ( 4 )
+typedef __m128 Lanes;
+#define lanes_add                   _mm_add_ps
+#define lanes_load( _lo, _hi )      _mm_loadu_ps( _lo )
+#define lanes_mul                   _mm_mul_ps
+#define lanes_set1                  _mm_set1_ps
+#define lanes_shuffle               _mm_shuffle_ps
+#define lanes_sub                   _mm_sub_ps
+#define lanes_unpackhi              _mm_unpackhi_ps
+#define lanes_unpacklo              _mm_unpacklo_ps
+#endif
+
 
 
 /*******************************************************************
@@ -190,102 +217,279 @@ Float3 Math_Float3x3MultiplyByFloat3( const Float3x3 *A, const Float3 *x )
 
 /*******************************************************************
 *
-*   Math_Float4x4MultiplyByFloat4x4()
+*   Math_Float3x3TransformSpin()
 *
 *   DESCRIPTION:
-*        Calculate C = A x B
+*       Calculate M = S x R x T
 *
 *******************************************************************/
 
-void Math_Float4x4MultiplyByFloat4x4( const Float4x4 *a, const Float4x4 *b, Float4x4 *out )
+void Math_Float3x3TransformSpin( const Float2 translation, const float rotation, const Float2 scale, Float3x3 *out )
 {
-Float4x4 temp;
-temp.n._11 =   a->n._11 * b->n._11 + a->n._12 * b->n._12 + a->n._13 * b->n._13 + a->n._14 * b->n._14;
-temp.n._12 =   a->n._11 * b->n._21 + a->n._12 * b->n._22 + a->n._13 * b->n._23 + a->n._14 * b->n._24;
-temp.n._13 =   a->n._11 * b->n._31 + a->n._12 * b->n._32 + a->n._13 * b->n._33 + a->n._14 * b->n._34;
-temp.n._14 =   a->n._11 * b->n._41 + a->n._12 * b->n._42 + a->n._13 * b->n._43 + a->n._14 * b->n._44;
+/* load rotation */
+Math_Float3x3MakeRotation( rotation, out );
 
-temp.n._21 =   a->n._21 * b->n._11 + a->n._22 * b->n._12 + a->n._23 * b->n._13 + a->n._24 * b->n._14;
-temp.n._22 =   a->n._21 * b->n._21 + a->n._22 * b->n._22 + a->n._23 * b->n._23 + a->n._24 * b->n._24;
-temp.n._23 =   a->n._21 * b->n._31 + a->n._22 * b->n._32 + a->n._23 * b->n._33 + a->n._24 * b->n._34;
-temp.n._24 =   a->n._21 * b->n._41 + a->n._22 * b->n._42 + a->n._23 * b->n._43 + a->n._24 * b->n._44;
+/* scale */
+out->n._11 *= scale.v.x;
+out->n._21 *= scale.v.x;
 
-temp.n._31 =   a->n._31 * b->n._11 + a->n._32 * b->n._12 + a->n._33 * b->n._13 + a->n._34 * b->n._14;
-temp.n._32 =   a->n._31 * b->n._21 + a->n._32 * b->n._22 + a->n._33 * b->n._23 + a->n._34 * b->n._24;
-temp.n._33 =   a->n._31 * b->n._31 + a->n._32 * b->n._32 + a->n._33 * b->n._33 + a->n._34 * b->n._34;
-temp.n._34 =   a->n._31 * b->n._41 + a->n._32 * b->n._42 + a->n._33 * b->n._43 + a->n._34 * b->n._44;
+out->n._12 *= scale.v.y;
+out->n._22 *= scale.v.y;
 
-temp.n._41 =   a->n._41 * b->n._11 + a->n._42 * b->n._12 + a->n._43 * b->n._13 + a->n._44 * b->n._14;
-temp.n._42 =   a->n._41 * b->n._21 + a->n._42 * b->n._22 + a->n._43 * b->n._23 + a->n._44 * b->n._24;
-temp.n._43 =   a->n._41 * b->n._31 + a->n._42 * b->n._32 + a->n._43 * b->n._33 + a->n._44 * b->n._34;
-temp.n._44 =   a->n._41 * b->n._41 + a->n._42 * b->n._42 + a->n._43 * b->n._43 + a->n._44 * b->n._44;
+/* translate */
+out->n._13 = translation.v.x;
+out->n._23 = translation.v.y;
 
-*out = temp;
+} /*  Math_Float3x3TransformSpin() */
+
+
+#if defined( MATH_USE_SSE4 )
+/*******************************************************************
+*
+*   lanes_transpose()
+*
+*   DESCRIPTION:
+*       Transpose each group's 4x4 block of lanes.
+*
+*******************************************************************/
+
+static inline void lanes_transpose( Lanes v[ 4 ] )
+{
+Lanes t0 = lanes_unpacklo( v[ 0 ], v[ 1 ] );
+Lanes t1 = lanes_unpacklo( v[ 2 ], v[ 3 ] );
+Lanes t2 = lanes_unpackhi( v[ 0 ], v[ 1 ] );
+Lanes t3 = lanes_unpackhi( v[ 2 ], v[ 3 ] );
+
+v[ 0 ] = lanes_shuffle( t0, t1, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+v[ 1 ] = lanes_shuffle( t0, t1, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+v[ 2 ] = lanes_shuffle( t2, t3, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+v[ 3 ] = lanes_shuffle( t2, t3, _MM_SHUFFLE( 3, 2, 3, 2 ) );
 
-} /*  Math_Float4x4MultiplyByFloat4x4() */
+} /* lanes_transpose() */
 
 
 /*******************************************************************
 *
-*   Math_Float3x3TransformSpin()
+*   load_float3_lanes()
 *
 *   DESCRIPTION:
-*       Calculate M = S x R x T
+*       Load a batch of Float3s as x, y and z lanes.
 *
 *******************************************************************/
 
-void Math_Float3x3TransformSpin( const Float2 translation, const float rotation, const Float2 scale, Float3x3 *out )
+static inline void load_float3_lanes( const Float3 *in, Lanes out[ 3 ] )
 {
-/* load rotation */
-Math_Float3x3MakeRotation( rotation, out );
+/* per group: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 */
+Lanes a = lanes_load( &in[ 0 ].v.x, &in[ 4 ].v.x );
+Lanes b = lanes_load( &in[ 1 ].v.y, &in[ 5 ].v.y );
+Lanes c = lanes_load( &in[ 2 ].v.z, &in[ 6 ].v.z );
 
-/* scale */
-out->n._11 *= scale.v.x;
-out->n._21 *= scale.v.x;
+Lanes b2c1 = lanes_shuffle( b, c, _MM_SHUFFLE( 1, 1, 2, 2 ) );
+out[ 0 ] = lanes_shuffle( a, b2c1, _MM_SHUFFLE( 2, 0, 3, 0 ) );
 
-out->n._12 *= scale.v.y;
-out->n._22 *= scale.v.y;
+Lanes a1b0 = lanes_shuffle( a, b, _MM_SHUFFLE( 0, 0, 1, 1 ) );
+Lanes b3c2 = lanes_shuffle( b, c, _MM_SHUFFLE( 2, 2, 3, 3 ) );
+out[ 1 ] = lanes_shuffle( a1b0, b3c2, _MM_SHUFFLE( 2, 0, 2, 0 ) );
 
-/* translate */
-out->n._13 = translation.v.x;
-out->n._23 = translation.v.y;
+Lanes a2b1 = lanes_shuffle( a, b, _MM_SHUFFLE( 1, 1, 2, 2 ) );
+Lanes c0c3 = lanes_shuffle( c, c, _MM_SHUFFLE( 3, 3, 0, 0 ) );
+out[ 2 ] = lanes_shuffle( a2b1, c0c3, _MM_SHUFFLE( 2, 0, 2, 0 ) );
 
-} /*  Math_Float3x3TransformSpin() */
+} /* load_float3_lanes() */
 
 
 /*******************************************************************
 *
-*   Math_Float4x4TransformSpin()
+*   load_quaternion_lanes()
 *
 *   DESCRIPTION:
-*       Calculate M = S x R x T
+*       Load a batch of quaternions as x, y, z and w lanes.
 *
 *******************************************************************/
 
-void Math_Float4x4TransformSpin( const Float3 translation, const Quaternion rotation, const Float3 scale, Float4x4 *out )
+static inline void load_quaternion_lanes( const Quaternion *in, Lanes out[ 4 ] )
 {
-/* load rotation */
-Math_QuaternionToFloat4x4( rotation, out );
+for( int i = 0; i < 4; i++ )
+    {
+    out[ i ] = lanes_load( in[ i ].f, in[ 4 + i ].f );
+    }
 
-/* scale */
-out->n._11 *= scale.v.x;
-out->n._21 *= scale.v.x;
-out->n._31 *= scale.v.x;
+lanes_transpose( out );
 
-out->n._12 *= scale.v.y;
-out->n._22 *= scale.v.y;
-out->n._32 *= scale.v.y;
+} /* load_quaternion_lanes() */
 
-out->n._13 *= scale.v.z;
-out->n._23 *= scale.v.z;
-out->n._33 *= scale.v.z;
 
-/* translate */
-out->n._14 = translation.v.x;
-out->n._24 = translation.v.y;
-out->n._34 = translation.v.z;
+/*******************************************************************
+*
+*   store_transform_lanes()
+*
+*   DESCRIPTION:
+*       Store a batch of transforms, given the first three rows of
+*       each as lanes - rows[ 4 * row + column ].  Under AVX each
+*       store is two rows of one transform.
+*
+*******************************************************************/
+
+static inline void store_transform_lanes( Lanes rows[ 12 ], Float4x4 *out )
+{
+for( int row = 0; row < 3; row++ )
+    {
+    lanes_transpose( &rows[ 4 * row ] );
+    }
+
+#if defined( MATH_USE_AVX )
+/* permute2f128 immediate: 0x20 joins the lower halves, 0x31 the upper */
+__m256 last_row = _mm256_setr_ps( 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f );
+for( int i = 0; i < 4; i++ )
+    {
+    _mm256_storeu_ps( out[ i ].f[ 0 ],     _mm256_permute2f128_ps( rows[ i ], rows[ 4 + i ], 0x20 ) );
+    _mm256_storeu_ps( out[ 4 + i ].f[ 0 ], _mm256_permute2f128_ps( rows[ i ], rows[ 4 + i ], 0x31 ) );
+    _mm256_storeu_ps( out[ i ].f[ 2 ],     _mm256_blend_ps( rows[ 8 + i ], last_row, 0xf0 ) );
+    _mm256_storeu_ps( out[ 4 + i ].f[ 2 ], _mm256_permute2f128_ps( rows[ 8 + i ], last_row, 0x31 ) );
+    }
+
+#else
+__m128 last_row = _mm_setr_ps( 0.0f, 0.0f, 0.0f, 1.0f );
+for( int i = 0; i < 4; i++ )
+    {
+    _mm_storeu_ps( out[ i ].f[ 0 ], rows[ i ] );
+    _mm_storeu_ps( out[ i ].f[ 1 ], rows[ 4 + i ] );
+    _mm_storeu_ps( out[ i ].f[ 2 ], rows[ 8 + i ] );
+    _mm_storeu_ps( out[ i ].f[ 3 ], last_row );
+    }
+
+#endif
+} /* store_transform_lanes() */
+
+
+/*******************************************************************
+*
+*   transform_spin_lanes()
+*
+*   DESCRIPTION:
+*       Math_Float4x4TransformSpin() for a batch of transforms held
+*       as lanes, with the same operations in the same order.
+*
+*******************************************************************/
+
+static inline void transform_spin_lanes( const Lanes t[ 3 ], const Lanes q[ 4 ], const Lanes s[ 3 ], Lanes out[ 12 ] )
+{
+Lanes x2 = lanes_add( q[ 0 ], q[ 0 ] );
+Lanes y2 = lanes_add( q[ 1 ], q[ 1 ] );
+Lanes z2 = lanes_add( q[ 2 ], q[ 2 ] );
+
+Lanes xx = lanes_mul( q[ 0 ], x2 );
+Lanes yy = lanes_mul( q[ 1 ], y2 );
+Lanes zz = lanes_mul( q[ 2 ], z2 );
+Lanes xy = lanes_mul( q[ 0 ], y2 );
+Lanes xz = lanes_mul( q[ 0 ], z2 );
+Lanes yz = lanes_mul( q[ 1 ], z2 );
+Lanes wx = lanes_mul( q[ 3 ], x2 );
+Lanes wy = lanes_mul( q[ 3 ], y2 );
+Lanes wz = lanes_mul( q[ 3 ], z2 );
+
+Lanes one = lanes_set1( 1.0f );
+
+out[ 0 ]  = lanes_mul( lanes_sub( lanes_sub( one, yy ), zz ), s[ 0 ] );
+out[ 1 ]  = lanes_mul( lanes_sub( xy, wz ), s[ 1 ] );
+out[ 2 ]  = lanes_mul( lanes_add( xz, wy ), s[ 2 ] );
+out[ 3 ]  = t[ 0 ];
+
+out[ 4 ]  = lanes_mul( lanes_add( xy, wz ), s[ 0 ] );
+out[ 5 ]  = lanes_mul( lanes_sub( lanes_sub( one, xx ), zz ), s[ 1 ] );
+out[ 6 ]  = lanes_mul( lanes_sub( yz, wx ), s[ 2 ] );
+out[ 7 ]  = t[ 1 ];
+
+out[ 8 ]  = lanes_mul( lanes_sub( xz, wy ), s[ 0 ] );
+out[ 9 ]  = lanes_mul( lanes_add( yz, wx ), s[ 1 ] );
+out[ 10 ] = lanes_mul( lanes_sub( lanes_sub( one, xx ), yy ), s[ 2 ] );
+out[ 11 ] = t[ 2 ];
+
+} /* transform_spin_lanes() */
+
+
+#endif /* MATH_USE_SSE4 */
+
+
+/*******************************************************************
+*
+*   Math_Float4x4TransformSpinBatch()
+*
+*   DESCRIPTION:
+*       Math_Float4x4TransformSpin() for count transforms, given as
+*       separate arrays of translations, rotations and scales (the
+*       columns of TransformComponent).  Four transforms are built
+*       at a time under SSE4.1, and eight under AVX, giving the same
+*       matrices as building them one at a time.
+*
+*******************************************************************/
+
+void Math_Float4x4TransformSpinBatch( const Float3 *translation, const Quaternion *rotation, const Float3 *scale, const uint32_t count, Float4x4 *out )
+{
+uint32_t i = 0;
+
+#if defined( MATH_USE_SSE4 )
+for( ; i + BATCH_WIDTH <= count; i += BATCH_WIDTH )
+    {
+    Lanes t[ 3 ];
+    Lanes q[ 4 ];
+    Lanes s[ 3 ];
+    Lanes m[ 12 ];
+    load_float3_lanes( &translation[ i ], t );
+    load_quaternion_lanes( &rotation[ i ], q );
+    load_float3_lanes( &scale[ i ], s );
+
+    transform_spin_lanes( t, q, s, m );
+    store_transform_lanes( m, &out[ i ] );
+    }
+
+#endif
+for( ; i < count; i++ )
+    {
+    Math_Float4x4TransformSpin( translation[ i ], rotation[ i ], scale[ i ], &out[ i ] );
+    }
+
+} /*  Math_Float4x4TransformSpinBatch() */
+
+
+/*******************************************************************
+*
+*   Math_Float4x4TransformSpinHierarchy()
+*
+*   DESCRIPTION:
+*       Build world transforms for a hierarchy.  Each local transform
+*       is built as by Math_Float4x4TransformSpinBatch(), then applied
+*       to its parent's world transform.  parent[ i ] is the index of
+*       transform i's parent, or MATH_TRANSFORM_NO_PARENT for a root.
+*       Parents must come before their children.
+*
+*******************************************************************/
+
+void Math_Float4x4TransformSpinHierarchy( const Float3 *translation, const Quaternion *rotation, const Float3 *scale, const uint32_t *parent, const uint32_t count, Float4x4 *out )
+{
+for( uint32_t first = 0; first < count; first += HIERARCHY_BLOCK_CNT )
+    {
+    uint32_t block_cnt = count - first;
+    if( block_cnt > HIERARCHY_BLOCK_CNT )
+        {
+        block_cnt = HIERARCHY_BLOCK_CNT;
+        }
+
+    Math_Float4x4TransformSpinBatch( &translation[ first ], &rotation[ first ], &scale[ first ], block_cnt, &out[ first ] );
+
+    for( uint32_t i = first; i < first + block_cnt; i++ )
+        {
+        if( parent[ i ] == MATH_TRANSFORM_NO_PARENT )
+            {
+            continue;
+            }
+
+        debug_assert( parent[ i ] < i );
+        Math_Float4x4MultiplyByFloat4x4( &out[ parent[ i ] ], &out[ i ], &out[ i ] );
+        }
+    }
 
-} /*  Math_Float4x4TransformSpin() */
+} /*  Math_Float4x4TransformSpinHierarchy() */
 
 
 /*******************************************************************
@@ -0,0 +1,727 @@
+#pragma once
+#include <math.h>
+
+/*******************************************************************
+*
+*   Math backend
+*
+*   DESCRIPTION:
+*       Inline versions of the hot vector and matrix operations.
+*       The backend is picked at compile time (in Math.hpp) - SSE4.1
+*       when the target has it, with the matrix product done two
+*       rows at a time under AVX, and plain scalar code otherwise.
+*       Defining MATH_SCALAR forces the scalar build, which is the
+*       reference the vector builds are tested against (see
+*       tools/MathCheck).
+*
+*       Float3 stays scalar in every build - packing 12 bytes into a
+*       register and back costs more than the three operations.
+*
+*       Every build adds and multiplies in the same order, so
+*       without FMA contraction the vector builds match the scalar
+*       one bit for bit.
+*
+*       Only included by Math.hpp.
+*
+*******************************************************************/
+
+#if defined( MATH_USE_SSE4 )
+/*******************************************************************
+*
+*   math_make_float4()
+*
+*   DESCRIPTION:
+*       Wrap a register as a Float4.
+*
+*******************************************************************/
+
+static inline Float4 math_make_float4( const __m128 a )
+{
+Float4 ret;
+ret.m = a;
+
+return( ret );
+
+} /* math_make_float4() */
+
+
+/*******************************************************************
+*
+*   math_load_point()
+*
+*   DESCRIPTION:
+*       Load a point's x, y and z.  If it isn't the last point of
+*       its array this is one load, and w is whatever follows it.
+*
+*******************************************************************/
+
+static inline __m128 math_load_point( const Float3 *point, const bool is_last )
+{
+if( is_last )
+    {
+    return( _mm_setr_ps( point->v.x, point->v.y, point->v.z, 0.0f ) );
+    }
+
+return( _mm_loadu_ps( point->f ) );
+
+} /* math_load_point() */
+
+#endif
+
+
+/*******************************************************************
+*
+*   Math_Float3Addition()
+*
+*   DESCRIPTION:
+*       Adds two 3D vectors together.
+*
+*******************************************************************/
+
+static inline Float3 Math_Float3Addition( const Float3 A, const Float3 B )
+{
+Float3 ret;
+ret.v.x = A.v.x + B.v.x;
+ret.v.y = A.v.y + B.v.y;
+ret.v.z = A.v.z + B.v.z;
+
+return( ret );
+
+} /* Math_Float3Addition() */
+
+
+/*******************************************************************
+*
+*   Math_Float3Subtraction()
+*
+*   DESCRIPTION:
+*       Subtract B from A.
+*
+*******************************************************************/
+
+static inline Float3 Math_Float3Subtraction( const Float3 A, const Float3 B )
+{
+Float3 ret;
+ret.v.x = A.v.x - B.v.x;
+ret.v.y = A.v.y - B.v.y;
+ret.v.z = A.v.z - B.v.z;
+
+return( ret );
+
+} /* Math_Float3Subtraction() */
+
+
+/*******************************************************************
+*
+*   Math_Float3ScalarMultiply()
+*
+*   DESCRIPTION:
+*       Applies a scalar to the vector.
+*
+*******************************************************************/
+
+static inline Float3 Math_Float3ScalarMultiply( const Float3 A, const float scalar )
+{
+Float3 ret;
+ret.v.x = A.v.x * scalar;
+ret.v.y = A.v.y * scalar;
+ret.v.z = A.v.z * scalar;
+
+return( ret );
+
+} /* Math_Float3ScalarMultiply() */
+
+
+/*******************************************************************
+*
+*   Math_Float3Negative()
+*
+*   DESCRIPTION:
+*       The vector going in the opposite direction.
+*
+*******************************************************************/
+
+static inline Float3 Math_Float3Negative( const Float3 A )
+{
+Float3 ret;
+ret.v.x = -A.v.x;
+ret.v.y = -A.v.y;
+ret.v.z = -A.v.z;
+
+return( ret );
+
+} /* Math_Float3Negative() */
+
+
+/*******************************************************************
+*
+*   Math_Float3HadamardProduct()
+*
+*   DESCRIPTION:
+*       The component-wise product of two vectors.
+*
+*******************************************************************/
+
+static inline Float3 Math_Float3HadamardProduct( const Float3 A, const Float3 B )
+{
+Float3 ret;
+ret.v.x = A.v.x * B.v.x;
+ret.v.y = A.v.y * B.v.y;
+ret.v.z = A.v.z * B.v.z;
+
+return( ret );
+
+} /* Math_Float3HadamardProduct() */
+
+
+/*******************************************************************
+*
+*   Math_Float3DotProduct()
+*
+*   DESCRIPTION:
+*       The dot product of two vectors.
+*
+*******************************************************************/
+
+static inline float Math_Float3DotProduct( const Float3 A, const Float3 B )
+{
+return( A.v.x * B.v.x + A.v.y * B.v.y + A.v.z * B.v.z );
+
+} /* Math_Float3DotProduct() */
+
+
+/*******************************************************************
+*
+*   Math_Float3CrossProduct()
+*
+*   DESCRIPTION:
+*       The cross product A x B.
+*
+*******************************************************************/
+
+static inline Float3 Math_Float3CrossProduct( const Float3 A, const Float3 B )
+{
+Float3 ret;
+ret.v.x = A.v.y * B.v.z - A.v.z * B.v.y;
+ret.v.y = A.v.z * B.v.x - A.v.x * B.v.z;
+ret.v.z = A.v.x * B.v.y - A.v.y * B.v.x;
+
+return( ret );
+
+} /* Math_Float3CrossProduct() */
+
+
+/*******************************************************************
+*
+*   Math_Float3SquareMagnitude()
+*
+*   DESCRIPTION:
+*       The squared length of the vector.
+*
+*******************************************************************/
+
+static inline float Math_Float3SquareMagnitude( const Float3 A )
+{
+return( Math_Float3DotProduct( A, A ) );
+
+} /* Math_Float3SquareMagnitude() */
+
+
+/*******************************************************************
+*
+*   Math_Float3Magnitude()
+*
+*   DESCRIPTION:
+*       The length of the vector.
+*
+*******************************************************************/
+
+static inline float Math_Float3Magnitude( const Float3 A )
+{
+return( sqrtf( Math_Float3DotProduct( A, A ) ) );
+
+} /* Math_Float3Magnitude() */
+
+
+/*******************************************************************
+*
+*   Math_Float3SquaredDistanceBetween()
+*
+*   DESCRIPTION:
+*       The squared length of B - A.
+*
+*******************************************************************/
+
+static inline float Math_Float3SquaredDistanceBetween( const Float3 A, const Float3 B )
+{
+return( Math_Float3SquareMagnitude( Math_Float3Subtraction( B, A ) ) );
+
+} /* Math_Float3SquaredDistanceBetween() */
+
+
+/*******************************************************************
+*
+*   Math_Float3DistanceBetween()
+*
+*   DESCRIPTION:
+*       The length of B - A.
+*
+*******************************************************************/
+
+static inline float Math_Float3DistanceBetween( const Float3 A, const Float3 B )
+{
+return( Math_Float3Magnitude( Math_Float3Subtraction( B, A ) ) );
+
+} /* Math_Float3DistanceBetween() */
+
+
+/*******************************************************************
+*
+*   Math_Float4Addition()
+*
+*   DESCRIPTION:
+*       Adds two 4D vectors together.
+*
+*******************************************************************/
+
+static inline Float4 Math_Float4Addition( const Float4 A, const Float4 B )
+{
+#if defined( MATH_USE_SSE4 )
+return( math_make_float4( _mm_add_ps( A.m, B.m ) ) );
+
+#else
+Float4 ret;
+for( int i = 0; i < 4; i++ )
+    {
+    ret.f[ i ] = A.f[ i ] + B.f[ i ];
+    }
+
+return( ret );
+
+#endif
+} /* Math_Float4Addition() */
+
+
+/*******************************************************************
+*
+*   Math_Float4Subtraction()
+*
+*   DESCRIPTION:
+*       Subtract B from A.
+*
+*******************************************************************/
+
+static inline Float4 Math_Float4Subtraction( const Float4 A, const Float4 B )
+{
+#if defined( MATH_USE_SSE4 )
+return( math_make_float4( _mm_sub_ps( A.m, B.m ) ) );
+
+#else
+Float4 ret;
+for( int i = 0; i < 4; i++ )
+    {
+    ret.f[ i ] = A.f[ i ] - B.f[ i ];
+    }
+
+return( ret );
+
+#endif
+} /* Math_Float4Subtraction() */
+
+
+/*******************************************************************
+*
+*   Math_Float4ScalarMultiply()
+*
+*   DESCRIPTION:
+*       Applies a scalar to the vector.
+*
+*******************************************************************/
+
+static inline Float4 Math_Float4ScalarMultiply( const Float4 A, const float scalar )
+{
+#if defined( MATH_USE_SSE4 )
+return( math_make_float4( _mm_mul_ps( A.m, _mm_set1_ps( scalar ) ) ) );
+
+#else
+Float4 ret;
+for( int i = 0; i < 4; i++ )
+    {
+    ret.f[ i ] = A.f[ i ] * scalar;
+    }
+
+return( ret );
+
+#endif
+} /* Math_Float4ScalarMultiply() */
+
+
+/*******************************************************************
+*
+*   Math_Float4Negative()
+*
+*   DESCRIPTION:
+*       The vector going in the opposite direction.
+*
+*******************************************************************/
+
+static inline Float4 Math_Float4Negative( const Float4 A )
+{
+#if defined( MATH_USE_SSE4 )
+return( math_make_float4( _mm_xor_ps( A.m, _mm_set1_ps( -0.0f ) ) ) );
+
+#else
+Float4 ret;
+for( int i = 0; i < 4; i++ )
+    {
+    ret.f[ i ] = -A.f[ i ];
+    }
+
+return( ret );
+
+#endif
+} /* Math_Float4Negative() */
+
+
+/*******************************************************************
+*
+*   Math_Float4HadamardProduct()
+*
+*   DESCRIPTION:
+*       The component-wise product of two vectors.
+*
+*******************************************************************/
+
+static inline Float4 Math_Float4HadamardProduct( const Float4 A, const Float4 B )
+{
+#if defined( MATH_USE_SSE4 )
+return( math_make_float4( _mm_mul_ps( A.m, B.m ) ) );
+
+#else
+Float4 ret;
+for( int i = 0; i < 4; i++ )
+    {
+    ret.f[ i ] = A.f[ i ] * B.f[ i ];
+    }
+
+return( ret );
+
+#endif
+} /* Math_Float4HadamardProduct() */
+
+
+/*******************************************************************
+*
+*   Math_Float4DotProduct()
+*
+*   DESCRIPTION:
+*       The dot product of two vectors.
+*
+*******************************************************************/
+
+static inline float Math_Float4DotProduct( const Float4 A, const Float4 B )
+{
+#if defined( MATH_USE_SSE4 )
+/* summed in order, like the scalar build */
+__m128 products = _mm_mul_ps( A.m, B.m );
+__m128 sum = _mm_add_ss( products, _mm_shuffle_ps( products, products, _MM_SHUFFLE( 1, 1, 1, 1 ) ) );
+sum = _mm_add_ss( sum, _mm_movehl_ps( products, products ) );
+sum = _mm_add_ss( sum, _mm_shuffle_ps( products, products, _MM_SHUFFLE( 3, 3, 3, 3 ) ) );
+
+return( _mm_cvtss_f32( sum ) );
+
+#else
+return( A.v.x * B.v.x + A.v.y * B.v.y + A.v.z * B.v.z + A.v.w * B.v.w );
+
+#endif
+} /* Math_Float4DotProduct() */
+
+
+/*******************************************************************
+*
+*   Math_Float4SquareMagnitude()
+*
+*   DESCRIPTION:
+*       The squared length of the vector.
+*
+*******************************************************************/
+
+static inline float Math_Float4SquareMagnitude( const Float4 A )
+{
+return( Math_Float4DotProduct( A, A ) );
+
+} /* Math_Float4SquareMagnitude() */
+
+
+/*******************************************************************
+*
+*   Math_Float4Magnitude()
+*
+*   DESCRIPTION:
+*       The length of the vector.
+*
+*******************************************************************/
+
+static inline float Math_Float4Magnitude( const Float4 A )
+{
+return( sqrtf( Math_Float4DotProduct( A, A ) ) );
+
+} /* Math_Float4Magnitude() */
+
+
+/*******************************************************************
+*
+*   Math_Float4SquaredDistanceBetween()
+*
+*   DESCRIPTION:
+*       The squared length of B - A.
+*
+*******************************************************************/
+
+static inline float Math_Float4SquaredDistanceBetween( const Float4 A, const Float4 B )
+{
+return( Math_Float4SquareMagnitude( Math_Float4Subtraction( B, A ) ) );
+
+} /* Math_Float4SquaredDistanceBetween() */
+
+
+/*******************************************************************
+*
+*   Math_Float4DistanceBetween()
+*
+*   DESCRIPTION:
+*       The length of B - A.
+*
+*******************************************************************/
+
+static inline float Math_Float4DistanceBetween( const Float4 A, const Float4 B )
+{
+return( Math_Float4Magnitude( Math_Float4Subtraction( B, A ) ) );
+
+} /* Math_Float4DistanceBetween() */
+
+
+/*******************************************************************
+*
+*   Math_Float4TripleProduct()
+*
+*   DESCRIPTION:
+*       The triple product A x (B x C).  Inline so its arguments stay
+*       in registers - passed by value to an out of line function,
+*       a Float4 gets split and has to be rebuilt through memory.
+*
+*******************************************************************/
+
+static inline Float4 Math_Float4TripleProduct( const Float4 A, const Float4 B, const Float4 C )
+{
+float scalar1 = Math_Float4DotProduct( A, C );
+float scalar2 = Math_Float4DotProduct( A, B );
+
+return( Math_Float4Subtraction( Math_Float4ScalarMultiply( B, scalar1 ), Math_Float4ScalarMultiply( C, scalar2 ) ) );
+
+} /* Math_Float4TripleProduct() */
+
+
+/*******************************************************************
+*
+*   Math_Float4AngleBetween()
+*
+*   DESCRIPTION:
+*       The angle between two vectors.  Inline for the same reason.
+*
+*******************************************************************/
+
+static inline float Math_Float4AngleBetween( const Float4 A, const Float4 B )
+{
+float magA = Math_Float4Magnitude( A );
+float magB = Math_Float4Magnitude( B );
+
+return( (float)acos( Math_Float4DotProduct( A, B ) / ( magA * magB ) ) );
+
+} /* Math_Float4AngleBetween() */
+
+
+/*******************************************************************
+*
+*   Math_Float4x4MultiplyByFloat4x4()
+*
+*   DESCRIPTION:
+*       Calculate C = A x B.  The output may alias either input.
+*
+*******************************************************************/
+
+static inline void Math_Float4x4MultiplyByFloat4x4( const Float4x4 *a, const Float4x4 *b, Float4x4 *out )
+{
+#if defined( MATH_USE_AVX )
+/* each row of C is the rows of B weighted by a row of A - two rows of C at a time */
+__m256 b0 = _mm256_broadcast_ps( (const __m128*)b->f[ 0 ] );
+__m256 b1 = _mm256_broadcast_ps( (const __m128*)b->f[ 1 ] );
+__m256 b2 = _mm256_broadcast_ps( (const __m128*)b->f[ 2 ] );
+__m256 b3 = _mm256_broadcast_ps( (const __m128*)b->f[ 3 ] );
+__m256 a01 = _mm256_loadu_ps( a->f[ 0 ] );
+__m256 a23 = _mm256_loadu_ps( a->f[ 2 ] );
+
+__m256 c01 = _mm256_mul_ps( _mm256_shuffle_ps( a01, a01, _MM_SHUFFLE( 0, 0, 0, 0 ) ), b0 );
+c01 = _mm256_add_ps( c01, _mm256_mul_ps( _mm256_shuffle_ps( a01, a01, _MM_SHUFFLE( 1, 1, 1, 1 ) ), b1 ) );
+c01 = _mm256_add_ps( c01, _mm256_mul_ps( _mm256_shuffle_ps( a01, a01, _MM_SHUFFLE( 2, 2, 2, 2 ) ), b2 ) );
+c01 = _mm256_add_ps( c01, _mm256_mul_ps( _mm256_shuffle_ps( a01, a01, _MM_SHUFFLE( 3, 3, 3, 3 ) ), b3 ) );
+
+__m256 c23 = _mm256_mul_ps( _mm256_shuffle_ps( a23, a23, _MM_SHUFFLE( 0, 0, 0, 0 ) ), b0 );
+c23 = _mm256_add_ps( c23, _mm256_mul_ps( _mm256_shuffle_ps( a23, a23, _MM_SHUFFLE( 1, 1, 1, 1 ) ), b1 ) );
+c23 = _mm256_add_ps( c23, _mm256_mul_ps( _mm256_shuffle_ps( a23, a23, _MM_SHUFFLE( 2, 2, 2, 2 ) ), b2 ) );
+c23 = _mm256_add_ps( c23, _mm256_mul_ps( _mm256_shuffle_ps( a23, a23, _MM_SHUFFLE( 3, 3, 3, 3 ) ), b3 ) );
+
+_mm256_storeu_ps( out->f[ 0 ], c01 );
+_mm256_storeu_ps( out->f[ 2 ], c23 );
+
+#elif defined( MATH_USE_SSE4 )
+__m128 b0 = _mm_loadu_ps( b->f[ 0 ] );
+__m128 b1 = _mm_loadu_ps( b->f[ 1 ] );
+__m128 b2 = _mm_loadu_ps( b->f[ 2 ] );
+__m128 b3 = _mm_loadu_ps( b->f[ 3 ] );
+
+__m128 c[ 4 ];
+for( int i = 0; i < 4; i++ )
+    {
+    __m128 row = _mm_loadu_ps( a->f[ i ] );
+    c[ i ] = _mm_mul_ps( _mm_shuffle_ps( row, row, _MM_SHUFFLE( 0, 0, 0, 0 ) ), b0 );
+    c[ i ] = _mm_add_ps( c[ i ], _mm_mul_ps( _mm_shuffle_ps( row, row, _MM_SHUFFLE( 1, 1, 1, 1 ) ), b1 ) );
+    c[ i ] = _mm_add_ps( c[ i ], _mm_mul_ps( _mm_shuffle_ps( row, row, _MM_SHUFFLE( 2, 2, 2, 2 ) ), b2 ) );
+    c[ i ] = _mm_add_ps( c[ i ], _mm_mul_ps( _mm_shuffle_ps( row, row, _MM_SHUFFLE( 3, 3, 3, 3 ) ), b3 ) );
+    }
+
+for( int i = 0; i < 4; i++ )
+    {
+    _mm_storeu_ps( out->f[ i ], c[ i ] );
+    }
+
+#else
+Float4x4 temp;
+for( int i = 0; i < 4; i++ )
+    {
+    for( int j = 0; j < 4; j++ )
+        {
+        temp.f[ i ][ j ] = a->f[ i ][ 0 ] * b->f[ 0 ][ j ]
+                         + a->f[ i ][ 1 ] * b->f[ 1 ][ j ]
+                         + a->f[ i ][ 2 ] * b->f[ 2 ][ j ]
+                         + a->f[ i ][ 3 ] * b->f[ 3 ][ j ];
+        }
+    }
+
+*out = temp;
+
+#endif
+} /* Math_Float4x4MultiplyByFloat4x4() */
+
+
+/*******************************************************************
+*
+*   Math_QuaternionToFloat4x4()
+*
+*   DESCRIPTION:
+*       Convert a unit quaternion (x, y, z, w) to a 4x4 rotation
+*       matrix, for column vectors.
+*
+*******************************************************************/
+
+static inline void Math_QuaternionToFloat4x4( const Quaternion in, Float4x4 *out )
+{
+#if defined( MATH_USE_SSE4 )
+__m128 q  = in.m;
+__m128 q2 = _mm_add_ps( q, q );
+
+/* 1 - 2yy - 2zz, 1 - 2xx - 2zz, 1 - 2xx - 2yy */
+__m128 squares  = _mm_mul_ps( q, q2 );
+__m128 diagonal = _mm_sub_ps( _mm_setr_ps( 1.0f, 1.0f, 1.0f, 0.0f ), _mm_shuffle_ps( squares, squares, _MM_SHUFFLE( 3, 0, 0, 1 ) ) );
+diagonal = _mm_sub_ps( diagonal, _mm_shuffle_ps( squares, squares, _MM_SHUFFLE( 3, 1, 2, 2 ) ) );
+
+/* 2xz, 2xy, 2yz, and 2wy, 2wz, 2wx */
+__m128 cross = _mm_mul_ps( _mm_shuffle_ps( q, q, _MM_SHUFFLE( 3, 1, 0, 0 ) ), _mm_shuffle_ps( q2, q2, _MM_SHUFFLE( 3, 2, 1, 2 ) ) );
+__m128 by_w  = _mm_mul_ps( _mm_shuffle_ps( q, q, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _mm_shuffle_ps( q2, q2, _MM_SHUFFLE( 3, 0, 2, 1 ) ) );
+__m128 sum   = _mm_add_ps( cross, by_w );
+__m128 diff  = _mm_sub_ps( cross, by_w );
+
+/* insert_ps immediate: source element << 6 | destination << 4 | lanes to zero */
+__m128 row0 = _mm_insert_ps( diagonal, diff, ( 1 << 6 ) | ( 1 << 4 ) | 0x8 );
+row0 = _mm_insert_ps( row0, sum, ( 0 << 6 ) | ( 2 << 4 ) );
+__m128 row1 = _mm_insert_ps( diagonal, sum, ( 1 << 6 ) | ( 0 << 4 ) | 0x8 );
+row1 = _mm_insert_ps( row1, diff, ( 2 << 6 ) | ( 2 << 4 ) );
+__m128 row2 = _mm_insert_ps( diagonal, diff, ( 0 << 6 ) | ( 0 << 4 ) | 0x8 );
+row2 = _mm_insert_ps( row2, sum, ( 2 << 6 ) | ( 1 << 4 ) );
+
+_mm_storeu_ps( out->f[ 0 ], row0 );
+_mm_storeu_ps( out->f[ 1 ], row1 );
+_mm_storeu_ps( out->f[ 2 ], row2 );
+_mm_storeu_ps( out->f[ 3 ], _mm_setr_ps( 0.0f, 0.0f, 0.0f, 1.0f ) );
+
+#else
+float x2 = in.v.x + in.v.x;
+float y2 = in.v.y + in.v.y;
+float z2 = in.v.z + in.v.z;
+
+float xx = in.v.x * x2;
+float yy = in.v.y * y2;
+float zz = in.v.z * z2;
+float xy = in.v.x * y2;
+float xz = in.v.x * z2;
+float yz = in.v.y * z2;
+float wx = in.v.w * x2;
+float wy = in.v.w * y2;
+float wz = in.v.w * z2;
+
+out->n._11 = 1.0f - yy - zz;
+out->n._12 = xy - wz;
+out->n._13 = xz + wy;
+out->n._14 = 0.0f;
+
+out->n._21 = xy + wz;
+out->n._22 = 1.0f - xx - zz;
+out->n._23 = yz - wx;
+out->n._24 = 0.0f;
+
+out->n._31 = xz - wy;
+out->n._32 = yz + wx;
+out->n._33 = 1.0f - xx - yy;
+out->n._34 = 0.0f;
+
+out->n._41 = 0.0f;
+out->n._42 = 0.0f;
+out->n._43 = 0.0f;
+out->n._44 = 1.0f;
+
+#endif
+} /* Math_QuaternionToFloat4x4() */
+
+
+/*******************************************************************
+*
+*   Math_Float4x4TransformSpin()
+*
+*   DESCRIPTION:
+*       Calculate M = T x R x S, for column vectors.
+*
+*******************************************************************/
+
+static inline void Math_Float4x4TransformSpin( const Float3 translation, const Quaternion rotation, const Float3 scale, Float4x4 *out )
+{
+Math_QuaternionToFloat4x4( rotation, out );
+
+#if defined( MATH_USE_SSE4 )
+__m128 s = _mm_setr_ps( scale.v.x, scale.v.y, scale.v.z, 0.0f );
+for( int i = 0; i < 3; i++ )
+    {
+    __m128 row = _mm_mul_ps( _mm_loadu_ps( out->f[ i ] ), s );
+    _mm_storeu_ps( out->f[ i ], _mm_blend_ps( row, _mm_set1_ps( translation.f[ i ] ), 0x8 ) );
+    }
+
+#else
+for( int i = 0; i < 3; i++ )
+    {
+    out->f[ i ][ 0 ] *= scale.v.x;
+    out->f[ i ][ 1 ] *= scale.v.y;
+    out->f[ i ][ 2 ] *= scale.v.z;
+    out->f[ i ][ 3 ]  = translation.f[ i ];
+    }
+
+#endif
+} /* Math_Float4x4TransformSpin() */
@@ -1,9 +1,28 @@
 #include <math.h>
 #include <cstdlib>
 
+#include "FrameAllocator.hpp"
 #include "Math.hpp"
+#include "ThreadPool.hpp"
 #include "Utilities.hpp"
 
+
+#define SUM_BLOCK_CNT               ( 4096 )    /* points summed in float before adding to the double totals */
+
+typedef struct _CoVarianceRange
+    {
+    const uint8_t      *points;
+    uint32_t            count;
+    size_t              stride;
+    bool                has_last;       /* holds the last point of the array, which can't be over-read */
+    Float3              mean;           /* of the whole array, for the spread pass */
+    double              sums[ 3 ];      /* x, y, z */
+    double              spreads[ 6 ];   /* xx, yy, zz, xy, yz, zx, about the mean */
+    } CoVarianceRange;
+
+static void SpreadJob( void *user );
+static void SumJob( void *user );
+
 /*******************************************************************
 *
 *   Math_floatMean()
@@ -129,51 +148,113 @@ void Math_Float2CoVarianceMatrix2x2( const Float2 *points, const uint32_t num_of
 
 void Math_Float3CoVarianceMatrix3x3( const Float3 *points, const int num_of_points, Float3x3 *output )
 {
+Math_Float3CoVarianceMatrix3x3Strided( points, (uint32_t)num_of_points, 0, NULL, NULL, output );
 
-    float mean_x = Math_floatMean( &points->v.x, num_of_points, sizeof( *points ) );
-    float mean_y = Math_floatMean( &points->v.y, num_of_points, sizeof( *points ) );
-    float mean_z = Math_floatMean( &points->v.z, num_of_points, sizeof( *points ) );
+} /* Math_Float3CoVarianceMatrix3x3() */
 
-    float sumX_variance = 0.0f;
-    float sumY_variance = 0.0f;
-    float sumZ_variance = 0.0f;
-    float sum_XYcovariance = 0.0f;
-    float sum_XZcovariance = 0.0f;
-    float sum_YZcovariance = 0.0f;
 
-    for( int k = 0; k < num_of_points; k++ )
+/*******************************************************************
+*
+*   Math_Float3CoVarianceMatrix3x3Strided()
+*
+*   DESCRIPTION:
+*       Calculate the 3x3 covariance matrix, and optionally the
+*       mean, of points that are stride bytes apart (0 if packed).
+*       Sets of at least MATH_PARALLEL_MIN_POINT_CNT points are
+*       split across the pool, if there is one.  The points are
+*       always split and summed the same way, so the result doesn't
+*       depend on the pool.
+*
+*******************************************************************/
+
+void Math_Float3CoVarianceMatrix3x3Strided( const Float3 *points, const uint32_t num_of_points, const size_t stride, ThreadPool *pool, Float3 *output_mean, Float3x3 *output )
+{
+debug_assert( num_of_points > 1 );
+size_t the_stride = stride ? stride : sizeof(*points);
+debug_assert( the_stride >= sizeof(*points) );
+
+if( num_of_points < MATH_PARALLEL_MIN_POINT_CNT )
     {
-        sumX_variance    = sumX_variance    + (points[k].v.x - mean_x) * (points[k].v.x - mean_x);
-        sumY_variance    = sumY_variance    + (points[k].v.y - mean_y) * (points[k].v.y - mean_y);
-        sumZ_variance    = sumZ_variance    + (points[k].v.z - mean_z) * (points[k].v.y - mean_z);
-        sum_XYcovariance = sum_XYcovariance + (points[k].v.x - mean_x) * (points[k].v.y - mean_y);
-        sum_XZcovariance = sum_XZcovariance + (points[k].v.x - mean_x) * (points[k].v.z - mean_z);
-        sum_YZcovariance = sum_YZcovariance + (points[k].v.y - mean_y) * (points[k].v.z - mean_z);
+    pool = NULL;
     }
 
-    float scale = 1 / ((float)num_of_points - 1.0f);
+uint32_t job_count = ( num_of_points + MATH_PARALLEL_JOB_POINT_CNT - 1 ) / MATH_PARALLEL_JOB_POINT_CNT;
+FrameAllocatorMarker scope = FrameAllocator_BeginScope();
+CoVarianceRange *ranges = FrameAllocator_AllocateArray( CoVarianceRange, job_count );
 
-    sumX_variance    = scale * sumX_variance;
-    sumY_variance    = scale * sumY_variance;
-    sum_XYcovariance = scale * sum_XYcovariance;
-    sum_XZcovariance = scale * sum_XZcovariance;
-    sum_YZcovariance = scale * sum_YZcovariance;
+/* find the mean */
+ThreadPoolCounter counter;
+ThreadPool_InitCounter( &counter );
+for( uint32_t i = 0; i < job_count; i++ )
+    {
+    uint32_t first = i * MATH_PARALLEL_JOB_POINT_CNT;
+    CoVarianceRange *range = &ranges[ i ];
+    *range = {};
+    range->points   = (const uint8_t*)points + first * the_stride;
+    range->count    = min_of_vals( MATH_PARALLEL_JOB_POINT_CNT, num_of_points - first );
+    range->stride   = the_stride;
+    range->has_last = ( i == job_count - 1 );
+    ThreadPool_Submit( SumJob, range, &counter, pool );
+    }
 
-    output->n._11 = sumX_variance;
-    output->n._22 = sumY_variance;
-    output->n._33 = sumZ_variance;
+ThreadPool_WaitForCounter( &counter, pool );
 
-    output->n._12 = sum_XYcovariance;
-    output->n._21 = sum_XYcovariance;
+double sums[ 3 ] = {};
+for( uint32_t i = 0; i < job_count; i++ )
+    {
+    for( uint32_t j = 0; j < 3; j++ )
+        {
+        sums[ j ] += ranges[ i ].sums[ j ];
+        }
+    }
 
-    output->n._13 = sum_XZcovariance;
-    output->n._31 = sum_XZcovariance;
+Float3 mean;
+for( uint32_t j = 0; j < 3; j++ )
+    {
+    mean.f[ j ] = (float)( sums[ j ] / num_of_points );
+    }
 
-    output->n._23 = sum_YZcovariance;
-    output->n._32 = sum_YZcovariance;
+/* then the spread about it */
+for( uint32_t i = 0; i < job_count; i++ )
+    {
+    ranges[ i ].mean = mean;
+    ThreadPool_Submit( SpreadJob, &ranges[ i ], &counter, pool );
+    }
 
+ThreadPool_WaitForCounter( &counter, pool );
 
-}/*Math_Float3CoVarianceMatrix3x3() */
+double spreads[ 6 ] = {};
+for( uint32_t i = 0; i < job_count; i++ )
+    {
+    for( uint32_t j = 0; j < 6; j++ )
+        {
+        spreads[ j ] += ranges[ i ].spreads[ j ];
+        }
+    }
+
+FrameAllocator_EndScope( scope );
+
+double scale = 1.0 / ( (double)num_of_points - 1.0 );
+
+output->n._11 = (float)( scale * spreads[ 0 ] );
+output->n._22 = (float)( scale * spreads[ 1 ] );
+output->n._33 = (float)( scale * spreads[ 2 ] );
+
+output->n._12 = (float)( scale * spreads[ 3 ] );
+output->n._21 = output->n._12;
+
+output->n._23 = (float)( scale * spreads[ 4 ] );
+output->n._32 = output->n._23;
+
+output->n._13 = (float)( scale * spreads[ 5 ] );
+output->n._31 = output->n._13;
+
+if( output_mean )
+    {
+    *output_mean = mean;
+    }
+
+} /* Math_Float3CoVarianceMatrix3x3Strided() */
 
 
 
@@ -235,7 +316,7 @@ bool Math_Float3EigenDecomposition( const Float3 *array_of_points, const uint32_
     debug_assert( size_of_output_arrays >= 3 );
     Float3x3 covariance_matrix = {};
 
-    Math_Float3CoVarianceMatrix3x3( array_of_points, number_of_points, &covariance_matrix );
+    Math_Float3CoVarianceMatrix3x3Strided( array_of_points, number_of_points, 0, NULL, output_vector_origin, &covariance_matrix );
     if(!Math_Float3x3EigenValuesVectors( &covariance_matrix,max_iterations, tolerance, size_of_output_arrays, output_eigenvalues, output_eigenvectors ))
     {
         return false;
@@ -250,12 +331,6 @@ bool Math_Float3EigenDecomposition( const Float3 *array_of_points, const uint32_
         }
     }
 
-    // calculate the array of points origin
-    for( uint32_t i = 0; i < 3; i++ )
-    {
-        output_vector_origin->f[i] = Math_floatMean(&array_of_points->f[i], number_of_points, sizeof(*array_of_points));
-    }
-    
     // apply the origin to the eiganvector
     for( uint32_t i = 0; i < 3; i++ )
     {
@@ -264,3 +339,156 @@ bool Math_Float3EigenDecomposition( const Float3 *array_of_points, const uint32_
 
     return true;
 }/* Math_Float3EigenDecomposition()*/
+
+
+/*******************************************************************
+*
+*   SpreadJob()
+*
+*   DESCRIPTION:
+*       Sum the products of one range of points' offsets from the
+*       mean.
+*
+*******************************************************************/
+
+static void SpreadJob( void *user )
+{
+CoVarianceRange *range = (CoVarianceRange*)user;
+
+#define point_at( _i ) \
+    ( (const Float3*)( range->points + (size_t)( _i ) * range->stride ) )
+
+#if defined( MATH_USE_SSE4 )
+uint32_t safe_count = range->count - ( range->has_last ? 1 : 0 );
+__m128 mean = _mm_setr_ps( range->mean.v.x, range->mean.v.y, range->mean.v.z, 0.0f );
+
+for( uint32_t block = 0; block < range->count; block += SUM_BLOCK_CNT )
+    {
+    uint32_t end = min_of_vals( block + SUM_BLOCK_CNT, range->count );
+
+    /* xx, yy, zz and xy, yz, zx - two running sums of each, so the adds overlap */
+    __m128 squares[ 2 ] = { _mm_setzero_ps(), _mm_setzero_ps() };
+    __m128 crosses[ 2 ] = { _mm_setzero_ps(), _mm_setzero_ps() };
+
+    uint32_t i = block;
+    for( ; i + 2 <= end && i + 2 <= safe_count; i += 2 )
+        {
+        for( uint32_t j = 0; j < 2; j++ )
+            {
+            __m128 offset = _mm_sub_ps( _mm_loadu_ps( point_at( i + j )->f ), mean );
+            __m128 rotate = _mm_shuffle_ps( offset, offset, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+            squares[ j ] = _mm_add_ps( squares[ j ], _mm_mul_ps( offset, offset ) );
+            crosses[ j ] = _mm_add_ps( crosses[ j ], _mm_mul_ps( offset, rotate ) );
+            }
+        }
+
+    for( ; i < end; i++ )
+        {
+        __m128 offset = _mm_sub_ps( math_load_point( point_at( i ), i >= safe_count ), mean );
+        __m128 rotate = _mm_shuffle_ps( offset, offset, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+        squares[ 0 ] = _mm_add_ps( squares[ 0 ], _mm_mul_ps( offset, offset ) );
+        crosses[ 0 ] = _mm_add_ps( crosses[ 0 ], _mm_mul_ps( offset, rotate ) );
+        }
+
+    Float4 square_sum = math_make_float4( _mm_add_ps( squares[ 0 ], squares[ 1 ] ) );
+    Float4 cross_sum  = math_make_float4( _mm_add_ps( crosses[ 0 ], crosses[ 1 ] ) );
+    for( uint32_t j = 0; j < 3; j++ )
+        {
+        range->spreads[ j ]     += square_sum.f[ j ];
+        range->spreads[ 3 + j ] += cross_sum.f[ j ];
+        }
+    }
+
+#else
+for( uint32_t block = 0; block < range->count; block += SUM_BLOCK_CNT )
+    {
+    uint32_t end = min_of_vals( block + SUM_BLOCK_CNT, range->count );
+    float block_spreads[ 6 ] = {};
+    for( uint32_t i = block; i < end; i++ )
+        {
+        Float3 offset = Math_Float3Subtraction( *point_at( i ), range->mean );
+        block_spreads[ 0 ] += offset.v.x * offset.v.x;
+        block_spreads[ 1 ] += offset.v.y * offset.v.y;
+        block_spreads[ 2 ] += offset.v.z * offset.v.z;
+        block_spreads[ 3 ] += offset.v.x * offset.v.y;
+        block_spreads[ 4 ] += offset.v.y * offset.v.z;
+        block_spreads[ 5 ] += offset.v.z * offset.v.x;
+        }
+
+    for( uint32_t j = 0; j < 6; j++ )
+        {
+        range->spreads[ j ] += block_spreads[ j ];
+        }
+    }
+
+#endif
+#undef point_at
+} /* SpreadJob() */
+
+
+/*******************************************************************
+*
+*   SumJob()
+*
+*   DESCRIPTION:
+*       Sum one range of points.
+*
+*******************************************************************/
+
+static void SumJob( void *user )
+{
+CoVarianceRange *range = (CoVarianceRange*)user;
+
+#define point_at( _i ) \
+    ( (const Float3*)( range->points + (size_t)( _i ) * range->stride ) )
+
+#if defined( MATH_USE_SSE4 )
+uint32_t safe_count = range->count - ( range->has_last ? 1 : 0 );
+
+for( uint32_t block = 0; block < range->count; block += SUM_BLOCK_CNT )
+    {
+    uint32_t end = min_of_vals( block + SUM_BLOCK_CNT, range->count );
+
+    /* four running sums, so the loads aren't held up by the chain of adds */
+    __m128 sums[ 4 ] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+
+    uint32_t i = block;
+    for( ; i + 4 <= end && i + 4 <= safe_count; i += 4 )
+        {
+        for( uint32_t j = 0; j < 4; j++ )
+            {
+            sums[ j ] = _mm_add_ps( sums[ j ], _mm_loadu_ps( point_at( i + j )->f ) );
+            }
+        }
+
+    for( ; i < end; i++ )
+        {
+        sums[ 0 ] = _mm_add_ps( sums[ 0 ], math_load_point( point_at( i ), i >= safe_count ) );
+        }
+
+    Float4 sum = math_make_float4( _mm_add_ps( _mm_add_ps( sums[ 0 ], sums[ 1 ] ), _mm_add_ps( sums[ 2 ], sums[ 3 ] ) ) );
+    for( uint32_t j = 0; j < 3; j++ )
+        {
+        range->sums[ j ] += sum.f[ j ];
+        }
+    }
+
+#else
+for( uint32_t block = 0; block < range->count; block += SUM_BLOCK_CNT )
+    {
+    uint32_t end = min_of_vals( block + SUM_BLOCK_CNT, range->count );
+    Float3 sum = {};
+    for( uint32_t i = block; i < end; i++ )
+        {
+        sum = Math_Float3Addition( sum, *point_at( i ) );
+        }
+
+    for( uint32_t j = 0; j < 3; j++ )
+        {
+        range->sums[ j ] += sum.f[ j ];
+        }
+    }
+
+#endif
+#undef point_at
+} /* SumJob() */
@@ -47,90 +47,6 @@ Float2 Math_Float2Subtraction( const Float2 A, const Float2 B)
 } /*  Math_Float2Subtraction() */
 
 
-/*******************************************************************
-*
-*   Math_Float3Addition()
-*
-*   DESCRIPTION:
-*       Adds two 3D vectors together.
-*
-*******************************************************************/
-
-Float3 Math_Float3Addition( const Float3 A, const Float3 B)
-{
-    Float3 C = {};
-    for( uint32_t i = 0; i < cnt_of_array( C.f ); i++ )
-    {
-        C.f[i] = A.f[i] + B.f[i];
-    }
-    return C;
-
-} /*  Math_Float3Addition() */
-
-
-/*******************************************************************
-*
-*   Math_Float3Subtraction()
-*
-*   DESCRIPTION:
-*       subtract two 3D vectors together.
-*
-*******************************************************************/
-
-Float3 Math_Float3Subtraction( const Float3 A, const Float3 B)
-{
-    Float3 C = {};
-    for( uint32_t i = 0; i < cnt_of_array( C.f ); i++ )
-    {
-        C.f[i] = A.f[i] - B.f[i];
-    }
-    return C;
-
-} /*  Math_Float3Subtraction() */
-
-
-/*******************************************************************
-*
-*   Math_Float4Addition()
-*
-*   DESCRIPTION:
-*       Adds two 4D vectors together.
-*
-*******************************************************************/
-
-Float4 Math_Float4Addition( const Float4 A, const Float4 B )
-{
-    Float4 C = {};
-    for( uint32_t i = 0; i < cnt_of_array( C.f ); i++ )
-    {
-        C.f[i] = A.f[i] + B.f[i];
-    }
-    return C;
-
-} /*  Math_Float4Addition() */
-
-
-/*******************************************************************
-*
-*   Math_Float4Subtraction()
-*
-*   DESCRIPTION:
-*       subtract two 4D vectors together.
-*
-*******************************************************************/
-
-Float4 Math_Float4Subtraction( const Float4 A, const Float4 B)
-{
-    Float4 C = {};
-    for( uint32_t i = 0; i < cnt_of_array( C.f ); i++ )
-    {
-        C.f[i] = A.f[i] - B.f[i];
-    }
-    return C;
-
-} /*  Math_Float4Subtraction() */
-
-
 /*******************************************************************
 *
 *   Math_Float2ScalarMultiply()
@@ -152,49 +68,6 @@ Float2 Math_Float2ScalarMultiply(const Float2 A, const float scalar )
 } /*  Math_Float2ScalarMultiply() */
 
 
-/*******************************************************************
-*
-*   Math_Float3ScalarMultiply()
-*
-*   DESCRIPTION:
-*       Applys a scaler to the vector
-*
-*******************************************************************/
-
-Float3 Math_Float3ScalarMultiply( const Float3 A, const float scalar )
-{
-    Float3 B = {};
-    for( uint32_t i = 0; i < cnt_of_array( B.f ); i++ )
-    {
-        B.f[i] = A.f[i] * scalar;
-    }
-    return B;
-
-} /*  Math_Float3ScalarMultiply() */
-
-
-/*******************************************************************
-*
-*   Math_Float4ScalarMultiply()
-*
-*   DESCRIPTION:
-*       Applys a scaler to the vector
-*
-*******************************************************************/
-
-Float4 Math_Float4ScalarMultiply( const Float4 A, const float scalar )
-{
-Float4 B = {};
-for( uint32_t i = 0; i < cnt_of_array( B.f ); i++ )
-    {
-    B.f[i] = A.f[i] * scalar;
-    }
-	
-return B;
-
-} /*  Math_Float4ScalarMultiply() */
-
-
 /*******************************************************************
 *
 *   Math_Float2Negative()
@@ -216,51 +89,6 @@ return( b );
 } /*  Math_Float2Negative() */
 
 
-/*******************************************************************
-*
-*   Math_Float3Negative()
-*
-*   DESCRIPTION:
-*       Calculates the negative of the vector.
-*       This is the vector going in the oposite direction
-*
-*******************************************************************/
-
-Float3 Math_Float3Negative( const Float3 a )
-{
-Float3 b;
-b.v.x = -a.v.x;
-b.v.y = -a.v.y;
-b.v.z = -a.v.z;
-
-return( b );
-
-} /*  Math_Float3Negative() */
-
-
-/*******************************************************************
-*
-*   Math_Float4Negative()
-*
-*   DESCRIPTION:
-*       Calculates the negative of the vector.  
-*       This is the vector going in the oposite direction
-*
-*******************************************************************/
-
-Float4 Math_Float4Negative( const Float4 A )
-{
-Float4 B;
-B.v.x = -A.v.x;
-B.v.y = -A.v.y;
-B.v.z = -A.v.z;
-B.v.w = -A.v.w;
-
-return B;
-
-} /*  Math_Float4Negative() */
-
-
 /*******************************************************************
 *
 *   Math_Float2DotProduct()
@@ -277,38 +105,6 @@ return (A.v.x * B.v.x + A.v.y * B.v.y);
 } /*  Math_Float2DotProduct() */
 
 
-/*******************************************************************
-*
-*   Math_Float3DotProduct()
-*
-*   DESCRIPTION:
-*       Calculates the dot product between the two vectors
-*
-*******************************************************************/
-
-float Math_Float3DotProduct( const Float3 A, const Float3 B )
-{
-return (A.v.x * B.v.x + A.v.y * B.v.y + A.v.z * B.v.z);
-
-} /*  Math_Float3DotProduct() */
-
-
-/*******************************************************************
-*
-*   Math_Float4DotProduct()
-*
-*   DESCRIPTION:
-*       Calculates the dot product between the two vectors
-*
-*******************************************************************/
-
-float Math_Float4DotProduct( const Float4 A, const Float4 B )
-{
-return (A.v.x * B.v.x + A.v.y * B.v.y + A.v.z * B.v.z + A.v.w * B.v.w);
-
-} /*  Math_Float3DotProduct() */
-
-
 /*******************************************************************
 *
 *   Math_Float2PseudoCrossProduct()
@@ -331,30 +127,6 @@ return (Math_Float2DotProduct(C,A));
 } /*  Math_Float2PseudoCrossProduct() */
 
 
-/*******************************************************************
-*
-*   Math_Float3CrossProduct()
-*
-*   DESCRIPTION:
-*       Calculates the cross product between the two vectors
-*
-*******************************************************************/
-
-Float3 Math_Float3CrossProduct( const Float3 A, const Float3 B )
-{
-Float3 C = {};
-float t1 = A.v.x - B.v.y;
-float t2 = B.v.y + B.v.z;
-float t3 = A.v.x * B.v.z;
-float t4 = t1*t2 - t3;
-C.v.x = B.v.y * (t1 - A.v.z) - t4;
-C.v.y = A.v.z * B.v.x - t3;
-C.v.z = t4 - A.v.y * ( B.v.x - t2);
-return C;
-
-} /*  Math_Float3CrossProduct() */
-
-
 /*******************************************************************
 *
 *   Math_Float3CrossProductMagnitude()
@@ -434,42 +206,6 @@ return( ret );
 } /*  Math_Float2HadamardProduct() */
 
 
-/*******************************************************************
-*
-*   Math_Float3HadamardProduct()
-*
-*   DESCRIPTION:
-*       Calculate the component-wise produt of two vectors.
-*
-*******************************************************************/
-
-Float3 Math_Float3HadamardProduct( const Float3 a, const Float3 b )
-{
-Float3 ret = Math_Float3Make( a.v.x * b.v.x, a.v.y * b.v.y, a.v.z * b.v.z );
-
-return( ret );
-
-} /*  Math_Float3HadamardProduct() */
-
-
-/*******************************************************************
-*
-*   Math_Float4HadamardProduct()
-*
-*   DESCRIPTION:
-*       Calculate the component-wise produt of two vectors.
-*
-*******************************************************************/
-
-Float4 Math_Float4HadamardProduct( const Float4 a, const Float4 b )
-{
-Float4 ret = Math_Float4Make( a.v.x * b.v.x, a.v.y * b.v.y, a.v.z * b.v.z, a.v.w * b.v.w );
-
-return( ret );
-
-} /*  Math_Float4HadamardProduct() */
-
-
 /*******************************************************************
 *
 *   Math_Float2TripleProduct()
@@ -512,27 +248,6 @@ return (Math_Float3Subtraction( modB, modC ));
 } /*  Math_Float3TripleProduct() */
 
 
-/*******************************************************************
-*
-*   Math_Float4TripleProduct()
-*
-*   DESCRIPTION:
-*       Calculates the triple product for three vectors A x (B x C)
-*
-*******************************************************************/
-
-Float4 Math_Float4TripleProduct( const Float4 A, const Float4 B, const Float4 C )
-{
-float scalar1 = Math_Float4DotProduct( A, C );
-float scalar2 = Math_Float4DotProduct( A, B );
-Float4 modB = Math_Float4ScalarMultiply( B, scalar1 );
-Float4 modC = Math_Float4ScalarMultiply( C, scalar2 );
-
-return (Math_Float4Subtraction( modB, modC ));
-
-} /*  Math_Float4TripleProduct() */
-
-
 /*******************************************************************
 *
 *   Math_Float2Magnitude()
@@ -549,38 +264,6 @@ return ((float) sqrt( Math_Float2DotProduct( A, A )));
 } /*  Math_Float2Magnitude */
 
 
-/*******************************************************************
-*
-*   Math_Float3Magnitude()
-*
-*   DESCRIPTION:
-*       calculates the magnetude or length of the vector
-*
-*******************************************************************/
-
-float Math_Float3Magnitude( const Float3 A )
-{
-return ((float)sqrt( Math_Float3DotProduct( A, A ) ));
-
-} /*  Math_Float3Magnitude */
-
-
-/*******************************************************************
-*
-*   Math_Float4Magnitude()
-*
-*   DESCRIPTION:
-*       calculates the magnetude or length of the vector
-*
-*******************************************************************/
-
-float Math_Float4Magnitude( const Float4 A )
-{
-return ((float) sqrt( Math_Float4DotProduct( A, A ) ));
-
-} /*  Math_Float4Magnitude */
-
-
 /*******************************************************************
 *
 *   Math_Float2SquareMagnitude()
@@ -597,38 +280,6 @@ return ( Math_Float2DotProduct( A, A ) );
 } /*  Math_Float2SquareMagnitude */
 
 
-/*******************************************************************
-*
-*   Math_Float3SquareMagnitude()
-*
-*   DESCRIPTION:
-*       calculates the magnetude^2 of the vector
-*
-*******************************************************************/
-
-float Math_Float3SquareMagnitude( const Float3 A )
-{
-return (Math_Float3DotProduct( A, A ) );
-
-} /*  Math_Float3SquareMagnitude */
-
-
-/*******************************************************************
-*
-*   Math_Float4SquareMagnitude()
-*
-*   DESCRIPTION:
-*       calculates the magnetude^2 of the vector
-*
-*******************************************************************/
-
-float Math_Float4SquareMagnitude( const Float4 A )
-{
-return ( Math_Float4DotProduct( A, A ) );
-
-} /*  Math_Float4SquareMagnitude */
-
-
 /*******************************************************************
 *
 *   Math_Float2AngleBetween()
@@ -669,26 +320,6 @@ float Math_Float3AngleBetween( const Float3 A, const Float3 B )
 } /*  Math_Float3AngleBetween() */
 
 
-/*******************************************************************
-*
-*   Math_Float4AngleBetween()
-*
-*   DESCRIPTION:
-*       Calculates the angle between the two vectors
-*
-*******************************************************************/
-
-float Math_Float4AngleBetween( const Float4 A, const Float4 B )
-{
-    float magA = Math_Float4Magnitude( A );
-    float magB = Math_Float4Magnitude( B );
-    float AdotB = Math_Float4DotProduct( A, B );
-
-    return ((float) acos( AdotB / (magA * magB) ));
-
-} /*  Math_Float4AngleBetween() */
-
-
 /*******************************************************************
 *
 *   Math_Float2IsAngleObtuse()
@@ -888,44 +519,6 @@ float Math_Float2DistanceBetween( const Float2 A, const Float2 B )
 } /*  Math_Float2DistanceBetween() */
 
 
-/*******************************************************************
-*
-*   Math_Float3DistanceBetween()
-*
-*   DESCRIPTION:
-*        Calculate the magnitude of the B - A vector
-*
-*******************************************************************/
-
-float Math_Float3DistanceBetween( const Float3 A, const Float3 B )
-{
-    Float3 C = {};
-    C = Math_Float3Subtraction( B, A );
-
-    return (Math_Float3Magnitude( C ));
-
-} /*  Math_Float3DistanceBetween() */
-
-
-/*******************************************************************
-*
-*   Math_Float4DistanceBetween()
-*
-*   DESCRIPTION:
-*        Calculate the magnitude of the B - A vector
-*
-*******************************************************************/
-
-float Math_Float4DistanceBetween( const Float4 A, const Float4 B )
-{
-    Float4 C = {};
-    C = Math_Float4Subtraction( B, A );
-
-    return (Math_Float4Magnitude( C ));
-
-} /*  Math_Float4DistanceBetween() */
-
-
 /*******************************************************************
 *
 *   Math_Float2SquaredDistanceBetween()
@@ -945,45 +538,6 @@ float Math_Float2SquaredDistanceBetween( const Float2 A, const Float2 B )
 } /*  Math_Float2SquaredDistanceBetween() */
 
 
-/*******************************************************************
-*
-*   Math_Float3SquaredDistanceBetween()
-*
-*   DESCRIPTION:
-*        Calculate the magnitude^2 of the B - A vector
-*
-*******************************************************************/
-
-float Math_Float3SquaredDistanceBetween( const Float3 A, const Float3 B )
-{
-    Float3 C = {};
-    C = Math_Float3Subtraction( B, A );
-
-    return (Math_Float3SquareMagnitude( C ));
-
-} /*  Math_Float3SquaredDistanceBetween() */
-
-
-/*******************************************************************
-*
-*   Math_Float4SquaredDistanceBetween()
-*
-*   DESCRIPTION:
-*        Calculate the magnitude^2 of the B - A vector
-*
-*******************************************************************/
-
-float Math_Float4SquaredDistanceBetween( const Float4 A, const Float4 B )
-{
-    Float4 C = {};
-    C = Math_Float4Subtraction( B, A );
-
-    return (Math_Float4SquareMagnitude( C ));
-
-} /*  Math_Float4SquaredDistanceBetween() */
-
-
-
 /*******************************************************************
 *
 *   Math_Float2ProjectionofPointOntoLineSegment()
@@ -0,0 +1,340 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "LinearAllocator.hpp"
+#include "MessageQueue.hpp"
+#include "Utilities.hpp"
+
+
+#define BLOCK_HEADER_SZ             ( ( sizeof(MessageQueueBlock) + MESSAGE_QUEUE_MESSAGE_ALIGNMENT - 1 ) & ~( MESSAGE_QUEUE_MESSAGE_ALIGNMENT - 1 ) )
+#define GROWTH_GRANULARITY          ( 4096 )
+
+
+static MessageQueueBlock * AllocateBlock( const MessageQueue *queue, MessageQueueBuffer *buffer );
+static void                ResetBuffer( MessageQueueBuffer *buffer );
+
+
+/*******************************************************************
+*
+*   get_block_sz()
+*
+*   DESCRIPTION:
+*       Get the size of a block, including its header.
+*
+*******************************************************************/
+
+static inline uint64_t get_block_sz( const MessageQueue *queue )
+{
+return( BLOCK_HEADER_SZ + MESSAGE_QUEUE_BLOCK_MESSAGE_COUNT * queue->message_stride );
+
+} /* get_block_sz() */
+
+
+/*******************************************************************
+*
+*   get_message_at()
+*
+*   DESCRIPTION:
+*       Address the message at the given index in a block.
+*
+*******************************************************************/
+
+static inline void * get_message_at( const uint32_t index, const size_t message_stride, const MessageQueueBlock *block )
+{
+return( (void*)( (uint8_t*)block + BLOCK_HEADER_SZ + index * message_stride ) );
+
+} /* get_message_at() */
+
+
+/*******************************************************************
+*
+*   MessageQueue_CreateIterator()
+*
+*   DESCRIPTION:
+*       Create an iterator over the given class's messages in the
+*       read buffer (the messages enqueued before the last swap).
+*
+*******************************************************************/
+
+void MessageQueue_CreateIterator( const uint32_t cls, const MessageQueue *queue, MessageQueueIterator *out )
+{
+debug_assert( cls < queue->class_count );
+const MessageQueueBuffer *read = &queue->buffers[ queue->write_buffer ^ 1 ];
+
+*out = {};
+out->block          = read->heads[ cls ];
+out->message_stride = queue->message_stride;
+
+} /* MessageQueue_CreateIterator() */
+
+
+/*******************************************************************
+*
+*   MessageQueue_Destroy()
+*
+*   DESCRIPTION:
+*       Free the queue's resources and return it to uninitialized.
+*
+*******************************************************************/
+
+void MessageQueue_Destroy( MessageQueue *queue )
+{
+for( uint32_t i = 0; i < cnt_of_array( queue->buffers ); i++ )
+    {
+    ResetBuffer( &queue->buffers[ i ] );
+    LinearAllocator_Destroy( &queue->buffers[ i ].allocator );
+    }
+
+*queue = {};
+
+} /* MessageQueue_Destroy() */
+
+
+/*******************************************************************
+*
+*   MessageQueue_Enqueue()
+*
+*   DESCRIPTION:
+*       Enqueue a new message of the given class into the write
+*       buffer, and return its zeroed storage for the caller to
+*       fill.  The message will be readable after the next swap.
+*
+*******************************************************************/
+
+void * MessageQueue_Enqueue( const uint32_t cls, MessageQueue *queue )
+{
+debug_assert( cls < queue->class_count );
+MessageQueueBuffer *write = &queue->buffers[ queue->write_buffer ];
+
+MessageQueueBlock *tail = write->tails[ cls ];
+if( !tail
+ || tail->count >= MESSAGE_QUEUE_BLOCK_MESSAGE_COUNT )
+    {
+    MessageQueueBlock *block = AllocateBlock( queue, write );
+    if( !block )
+        {
+        return( NULL );
+        }
+
+    if( tail )
+        {
+        tail->next = block;
+        }
+    else
+        {
+        write->heads[ cls ] = block;
+        }
+
+    write->tails[ cls ] = block;
+    tail = block;
+    }
+
+void *ret = get_message_at( tail->count++, queue->message_stride, tail );
+memset( ret, 0, queue->message_stride );
+write->counts[ cls ]++;
+
+return( ret );
+
+} /* MessageQueue_Enqueue() */
+
+
+/*******************************************************************
+*
+*   MessageQueue_GetNext()
+*
+*   DESCRIPTION:
+*       Get the next message from the iterator, or NULL if there
+*       are no more.
+*
+*******************************************************************/
+
+void * MessageQueue_GetNext( MessageQueueIterator *iterator )
+{
+while( iterator->block
+    && iterator->index >= iterator->block->count )
+    {
+    iterator->block = iterator->block->next;
+    iterator->index = 0;
+    }
+
+if( !iterator->block )
+    {
+    return( NULL );
+    }
+
+return( get_message_at( iterator->index++, iterator->message_stride, iterator->block ) );
+
+} /* MessageQueue_GetNext() */
+
+
+/*******************************************************************
+*
+*   MessageQueue_GetReadCount()
+*
+*   DESCRIPTION:
+*       Get the number of messages of the given class available in
+*       the read buffer.
+*
+*******************************************************************/
+
+uint32_t MessageQueue_GetReadCount( const uint32_t cls, const MessageQueue *queue )
+{
+debug_assert( cls < queue->class_count );
+return( queue->buffers[ queue->write_buffer ^ 1 ].counts[ cls ] );
+
+} /* MessageQueue_GetReadCount() */
+
+
+/*******************************************************************
+*
+*   MessageQueue_Init()
+*
+*   DESCRIPTION:
+*       Initialize a double-buffered message queue, bucketing the
+*       messages by class.  Each buffer starts with the given
+*       capacity, and grows at swap if a frame overflowed it.
+*       Messages are padded out to MESSAGE_QUEUE_MESSAGE_ALIGNMENT,
+*       so any type up to that alignment may be stored.
+*       Returns TRUE if the queue successfully initialized.
+*
+*******************************************************************/
+
+bool MessageQueue_Init( const uint32_t class_count, const size_t message_stride, const uint64_t frame_capacity, MessageQueue *queue )
+{
+*queue = {};
+if( class_count > MESSAGE_QUEUE_MAX_CLASS_COUNT )
+    {
+    debug_assert_always();
+    return( false );
+    }
+
+queue->class_count    = class_count;
+queue->message_stride = align_size_round_up( message_stride, MESSAGE_QUEUE_MESSAGE_ALIGNMENT );
+
+for( uint32_t i = 0; i < cnt_of_array( queue->buffers ); i++ )
+    {
+    if( !LinearAllocator_Init( frame_capacity, &queue->buffers[ i ].allocator ) )
+        {
+        MessageQueue_Destroy( queue );
+        return( false );
+        }
+    }
+
+return( true );
+
+} /* MessageQueue_Init() */
+
+
+/*******************************************************************
+*
+*   MessageQueue_Swap()
+*
+*   DESCRIPTION:
+*       Make the messages written since the last swap readable, and
+*       reset the other buffer to receive new messages.
+*
+*******************************************************************/
+
+void MessageQueue_Swap( MessageQueue *queue )
+{
+MessageQueueBuffer *written = &queue->buffers[ queue->write_buffer ];
+uint64_t written_sz = written->allocator.head + written->overflow_sz;
+queue->high_water = max_of_vals( queue->high_water, written_sz );
+
+queue->write_buffer ^= 1;
+MessageQueueBuffer *write = &queue->buffers[ queue->write_buffer ];
+
+/* grow the buffer if a previous frame spilled into the heap */
+if( write->overflow_sz > 0 )
+    {
+    uint64_t new_capacity = align_size_round_up( write->allocator.capacity + write->overflow_sz, GROWTH_GRANULARITY );
+    LinearAllocator grown;
+    if( LinearAllocator_Init( new_capacity, &grown ) )
+        {
+        LinearAllocator_Destroy( &write->allocator );
+        write->allocator = grown;
+        }
+    }
+
+ResetBuffer( write );
+
+} /* MessageQueue_Swap() */
+
+
+/*******************************************************************
+*
+*   AllocateBlock()
+*
+*   DESCRIPTION:
+*       Allocate a new empty block from the buffer's frame storage,
+*       falling back to the heap when the frame storage is full.
+*
+*******************************************************************/
+
+static MessageQueueBlock * AllocateBlock( const MessageQueue *queue, MessageQueueBuffer *buffer )
+{
+uint64_t block_sz = get_block_sz( queue );
+
+MessageQueueBlock *ret = NULL;
+if( buffer->allocator.capacity - buffer->allocator.head >= block_sz + MESSAGE_QUEUE_MESSAGE_ALIGNMENT )
+    {
+    ret = (MessageQueueBlock*)LinearAllocator_AllocateAligned( block_sz, MESSAGE_QUEUE_MESSAGE_ALIGNMENT, &buffer->allocator );
+    }
+
+if( !ret )
+    {
+    /* malloc aligns for max_align_t already */
+    ret = (MessageQueueBlock*)malloc( block_sz );
+    if( !ret )
+        {
+        debug_assert_always();
+        return( NULL );
+        }
+
+    ret->next_overflow = buffer->overflow;
+    buffer->overflow = ret;
+    buffer->overflow_sz += block_sz;
+    }
+else
+    {
+    ret->next_overflow = NULL;
+    }
+
+ret->next  = NULL;
+ret->count = 0;
+
+return( ret );
+
+} /* AllocateBlock() */
+
+
+/*******************************************************************
+*
+*   ResetBuffer()
+*
+*   DESCRIPTION:
+*       Empty the buffer, releasing any heap overflow blocks.
+*
+*******************************************************************/
+
+static void ResetBuffer( MessageQueueBuffer *buffer )
+{
+while( buffer->overflow )
+    {
+    MessageQueueBlock *next = buffer->overflow->next_overflow;
+    free( buffer->overflow );
+    buffer->overflow = next;
+    }
+
+buffer->overflow_sz = 0;
+clr_array( buffer->heads );
+clr_array( buffer->tails );
+clr_array( buffer->counts );
+
+if( buffer->allocator.pool )
+    {
+    LinearAllocator_Reset( &buffer->allocator );
+    }
+
+} /* ResetBuffer() */
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "LinearAllocator.hpp"
+
+
+#define MESSAGE_QUEUE_MAX_CLASS_COUNT \
+                                    ( 32 )
+#define MESSAGE_QUEUE_BLOCK_MESSAGE_COUNT \
+                                    ( 32 )
+#define MESSAGE_QUEUE_BUFFER_COUNT  ( 2 )
+#define MESSAGE_QUEUE_MESSAGE_ALIGNMENT \
+                                    ( alignof( max_align_t ) )  /* every message is aligned to this */
+
+typedef struct _MessageQueueBlock
+    {
+    struct _MessageQueueBlock
+                       *next;
+    struct _MessageQueueBlock
+                       *next_overflow;
+    uint32_t            count;
+    uint32_t            pad;
+    } MessageQueueBlock;
+
+typedef struct _MessageQueueBuffer
+    {
+    LinearAllocator     allocator;
+    MessageQueueBlock  *heads[ MESSAGE_QUEUE_MAX_CLASS_COUNT ];
+    MessageQueueBlock  *tails[ MESSAGE_QUEUE_MAX_CLASS_COUNT ];
+    uint32_t            counts[ MESSAGE_QUEUE_MAX_CLASS_COUNT ];
+    MessageQueueBlock  *overflow;
+    uint64_t            overflow_sz;
+    } MessageQueueBuffer;
+
+typedef struct _MessageQueue
+    {
+    MessageQueueBuffer  buffers[ MESSAGE_QUEUE_BUFFER_COUNT ];
+    uint8_t             write_buffer;
+    uint32_t            class_count;
+    size_t              message_stride;
+    uint64_t            high_water;
+    } MessageQueue;
+
+typedef struct _MessageQueueIterator
+    {
+    const MessageQueueBlock
+                       *block;
+    uint32_t            index;
+    size_t              message_stride;
+    } MessageQueueIterator;
+
+
+void     MessageQueue_CreateIterator( const uint32_t cls, const MessageQueue *queue, MessageQueueIterator *out );
+void     MessageQueue_Destroy( MessageQueue *queue );
+void *   MessageQueue_Enqueue( const uint32_t cls, MessageQueue *queue );
+uint32_t MessageQueue_GetReadCount( const uint32_t cls, const MessageQueue *queue );
+void *   MessageQueue_GetNext( MessageQueueIterator *iterator );
+bool     MessageQueue_Init( const uint32_t class_count, const size_t message_stride, const uint64_t frame_capacity, MessageQueue *queue );
+void     MessageQueue_Swap( MessageQueue *queue );
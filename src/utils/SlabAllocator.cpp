@@ -0,0 +1,455 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "SlabAllocator.hpp"
+#include "Utilities.hpp"
+
+
+static SlabAllocatorSlab * CreateSlab( SlabAllocator *allocator );
+#if defined( _DEBUG )
+static SlabAllocatorSlab * FindSlab( const void *object, const SlabAllocator *allocator );
+#endif
+static SlabAllocatorLeakProc
+                           PrintLeak;
+
+
+/*******************************************************************
+*
+*   get_carve_slab()
+*
+*   DESCRIPTION:
+*       Get the slab new objects are carved from.
+*
+*******************************************************************/
+
+static inline SlabAllocatorSlab * get_carve_slab( const SlabAllocator *allocator )
+{
+if( allocator->is_attached )
+    {
+    return( (SlabAllocatorSlab*)&allocator->attached );
+    }
+
+return( allocator->carve_slab );
+
+} /* get_carve_slab() */
+
+
+/*******************************************************************
+*
+*   get_first_slab()
+*
+*   DESCRIPTION:
+*       Get the newest slab.  An attached allocator's only slab is
+*       kept in the allocator (not linked), so it can be copied.
+*
+*******************************************************************/
+
+static inline SlabAllocatorSlab * get_first_slab( const SlabAllocator *allocator )
+{
+if( allocator->is_attached )
+    {
+    return( (SlabAllocatorSlab*)&allocator->attached );
+    }
+
+return( allocator->slabs );
+
+} /* get_first_slab() */
+
+
+/*******************************************************************
+*
+*   get_next_free()
+*
+*   DESCRIPTION:
+*       Get the free object linked after the given one.
+*
+*******************************************************************/
+
+static inline void * get_next_free( const void *object )
+{
+void *ret;
+memcpy( &ret, object, sizeof(ret) );
+
+return( ret );
+
+} /* get_next_free() */
+
+
+/*******************************************************************
+*
+*   set_next_free()
+*
+*   DESCRIPTION:
+*       Link the free object after the given one.
+*
+*******************************************************************/
+
+static inline void set_next_free( void *object, void *next )
+{
+memcpy( object, &next, sizeof(next) );
+
+} /* set_next_free() */
+
+
+/*******************************************************************
+*
+*   SlabAllocator_Allocate()
+*
+*   DESCRIPTION:
+*       Allocate an object.  Returns NULL if an attached allocator is
+*       used up, or a new slab couldn't be allocated.
+*
+*******************************************************************/
+
+void * SlabAllocator_Allocate( SlabAllocator *allocator )
+{
+uint8_t *ret = (uint8_t*)allocator->free_list;
+if( ret )
+    {
+    allocator->free_list = get_next_free( ret );
+    debug_if( test_bits( allocator->flags, SLAB_ALLOCATOR_FLAG_POISON ),
+        for( uint32_t i = sizeof(void*); i < allocator->object_size; i++ )
+            {
+            /* written to after it was freed */
+            debug_assert( ret[ i ] == SLAB_ALLOCATOR_POISON_BYTE );
+            }
+        );
+    }
+else
+    {
+    SlabAllocatorSlab *slab = get_carve_slab( allocator );
+    if( slab
+     && slab->carved_count == slab->capacity
+     && slab->next
+     && !slab->next->carved_count )
+        {
+        /* reset slabs are reused before any are added */
+        slab = slab->next;
+        allocator->carve_slab = slab;
+        }
+
+    if( !slab
+     || slab->carved_count == slab->capacity )
+        {
+        slab = CreateSlab( allocator );
+        if( !slab )
+            {
+            return( NULL );
+            }
+        }
+
+    ret = &slab->objects[ (size_t)slab->carved_count++ * allocator->stride ];
+    }
+
+allocator->live_count++;
+allocator->peak_live_count = max_of_vals( allocator->peak_live_count, allocator->live_count );
+
+return( ret );
+
+} /* SlabAllocator_Allocate() */
+
+
+/*******************************************************************
+*
+*   SlabAllocator_Destroy()
+*
+*   DESCRIPTION:
+*       Free the allocator's slabs, reporting any objects still
+*       allocated if asked to.
+*
+*******************************************************************/
+
+void SlabAllocator_Destroy( SlabAllocator *allocator )
+{
+if( test_bits( allocator->flags, SLAB_ALLOCATOR_FLAG_REPORT_LEAKS )
+ && allocator->live_count )
+    {
+    printf( "SlabAllocator: %u object(s) of %u bytes leaked\n", allocator->live_count, allocator->object_size );
+    SlabAllocator_ReportLeaks( allocator, PrintLeak, NULL );
+    }
+
+if( !allocator->is_attached )
+    {
+    SlabAllocatorSlab *slab = allocator->slabs;
+    while( slab )
+        {
+        SlabAllocatorSlab *next = slab->next;
+        free( slab );
+        slab = next;
+        }
+    }
+
+*allocator = {};
+
+} /* SlabAllocator_Destroy() */
+
+
+/*******************************************************************
+*
+*   SlabAllocator_Free()
+*
+*   DESCRIPTION:
+*       Return an object to the allocator.
+*
+*******************************************************************/
+
+void SlabAllocator_Free( void *object, SlabAllocator *allocator )
+{
+if( !object )
+    {
+    return;
+    }
+
+debug_assert( allocator->live_count );
+debug_assert( FindSlab( object, allocator ) );
+if( test_bits( allocator->flags, SLAB_ALLOCATOR_FLAG_POISON ) )
+    {
+    memset( object, SLAB_ALLOCATOR_POISON_BYTE, allocator->object_size );
+    }
+
+set_next_free( object, allocator->free_list );
+allocator->free_list = object;
+allocator->live_count--;
+
+} /* SlabAllocator_Free() */
+
+
+/*******************************************************************
+*
+*   SlabAllocator_Init()
+*
+*   DESCRIPTION:
+*       Initialize an owned slab allocator, which adds slabs of the
+*       given number of objects as it needs them.
+*
+*******************************************************************/
+
+bool SlabAllocator_Init( const uint32_t object_size, const uint32_t object_alignment, const uint32_t objects_per_slab, const SlabAllocatorFlags flags, SlabAllocator *allocator )
+{
+*allocator = {};
+if( !object_size
+ || !objects_per_slab
+ || ( object_alignment & ( object_alignment - 1 ) ) )
+    {
+    debug_assert_always();
+    return( false );
+    }
+
+/* every object must be able to hold the free list link */
+uint32_t alignment = max_of_vals( object_alignment, (uint32_t)alignof(void*) );
+uint32_t stride    = (uint32_t)align_size_round_up( max_of_vals( object_size, (uint32_t)sizeof(void*) ), alignment );
+if( test_bits( flags, SLAB_ALLOCATOR_FLAG_CACHE_ALIGN ) )
+    {
+    stride = (uint32_t)align_size_round_up( stride, SLAB_ALLOCATOR_CACHE_LINE_SIZE );
+    }
+
+allocator->object_size      = object_size;
+allocator->object_alignment = alignment;
+allocator->stride           = stride;
+allocator->objects_per_slab = objects_per_slab;
+allocator->flags            = flags;
+
+return( true );
+
+} /* SlabAllocator_Init() */
+
+
+/*******************************************************************
+*
+*   SlabAllocator_InitAttached()
+*
+*   DESCRIPTION:
+*       Initialize a slab allocator over a caller provided array of
+*       objects.  The array must outlive the allocator.
+*
+*******************************************************************/
+
+bool SlabAllocator_InitAttached( const uint32_t object_size, const uint32_t count, void *objects, const SlabAllocatorFlags flags, SlabAllocator *allocator )
+{
+*allocator = {};
+if( ( !objects && count )
+ || object_size < sizeof(void*) )
+    {
+    debug_assert_always();
+    return( false );
+    }
+
+allocator->object_size      = object_size;
+allocator->object_alignment = 1;
+allocator->stride           = object_size;
+allocator->objects_per_slab = count;
+allocator->flags            = flags & ~SLAB_ALLOCATOR_FLAG_CACHE_ALIGN;
+allocator->is_attached      = true;
+
+allocator->attached.objects  = (uint8_t*)objects;
+allocator->attached.capacity = count;
+allocator->slab_count        = 1;
+
+return( true );
+
+} /* SlabAllocator_InitAttached() */
+
+
+/*******************************************************************
+*
+*   SlabAllocator_Reset()
+*
+*   DESCRIPTION:
+*       Free every object at once, keeping the slabs.  Carving
+*       starts over from the newest slab and walks down to the
+*       oldest before any slab is added.
+*
+*******************************************************************/
+
+void SlabAllocator_Reset( SlabAllocator *allocator )
+{
+for( SlabAllocatorSlab *slab = get_first_slab( allocator ); slab; slab = slab->next )
+    {
+    slab->carved_count = 0;
+    }
+
+allocator->carve_slab = allocator->slabs;
+allocator->free_list  = NULL;
+allocator->live_count = 0;
+
+} /* SlabAllocator_Reset() */
+
+
+/*******************************************************************
+*
+*   SlabAllocator_ReportLeaks()
+*
+*   DESCRIPTION:
+*       Call the given procedure with each object still allocated.
+*       Slow - meant for shutdown and debugging.
+*
+*******************************************************************/
+
+void SlabAllocator_ReportLeaks( const SlabAllocator *allocator, SlabAllocatorLeakProc *proc, void *user )
+{
+for( const SlabAllocatorSlab *slab = get_first_slab( allocator ); slab; slab = slab->next )
+    {
+    if( !slab->carved_count )
+        {
+        continue;
+        }
+
+    /* mark the slab's free objects */
+    uint8_t *is_free = (uint8_t*)calloc( slab->carved_count, sizeof(*is_free) );
+    if( !is_free )
+        {
+        debug_assert_always();
+        return;
+        }
+
+    const uint8_t *end = &slab->objects[ (size_t)slab->carved_count * allocator->stride ];
+    for( const uint8_t *object = (const uint8_t*)allocator->free_list; object; object = (const uint8_t*)get_next_free( object ) )
+        {
+        if( object >= slab->objects
+         && object < end )
+            {
+            is_free[ ( object - slab->objects ) / allocator->stride ] = 1;
+            }
+        }
+
+    for( uint32_t i = 0; i < slab->carved_count; i++ )
+        {
+        if( !is_free[ i ] )
+            {
+            proc( &slab->objects[ (size_t)i * allocator->stride ], user );
+            }
+        }
+
+    free( is_free );
+    }
+
+} /* SlabAllocator_ReportLeaks() */
+
+
+/*******************************************************************
+*
+*   CreateSlab()
+*
+*   DESCRIPTION:
+*       Add an empty slab to the front of an owned allocator, with
+*       its objects starting on a cache line after the header.
+*
+*******************************************************************/
+
+static SlabAllocatorSlab * CreateSlab( SlabAllocator *allocator )
+{
+if( allocator->is_attached )
+    {
+    return( NULL );
+    }
+
+uint32_t alignment = max_of_vals( allocator->object_alignment, (uint32_t)SLAB_ALLOCATOR_CACHE_LINE_SIZE );
+size_t   sz        = sizeof(SlabAllocatorSlab) + ( alignment - 1 ) + (size_t)allocator->objects_per_slab * allocator->stride;
+SlabAllocatorSlab *slab = (SlabAllocatorSlab*)malloc( sz );
+if( !slab )
+    {
+    debug_assert_always();
+    return( NULL );
+    }
+
+uint8_t *objects = (uint8_t*)( slab + 1 );
+slab->next         = allocator->slabs;
+slab->objects      = objects + align_adjust( objects, alignment );
+slab->capacity     = allocator->objects_per_slab;
+slab->carved_count = 0;
+
+allocator->slabs      = slab;
+allocator->carve_slab = slab;
+allocator->slab_count++;
+
+return( slab );
+
+} /* CreateSlab() */
+
+
+#if defined( _DEBUG )
+/*******************************************************************
+*
+*   FindSlab()
+*
+*   DESCRIPTION:
+*       Find the slab holding the given object, if it belongs to the
+*       allocator and is on an object boundary.
+*
+*******************************************************************/
+
+static SlabAllocatorSlab * FindSlab( const void *object, const SlabAllocator *allocator )
+{
+const uint8_t *ptr = (const uint8_t*)object;
+for( SlabAllocatorSlab *slab = get_first_slab( allocator ); slab; slab = slab->next )
+    {
+    if( ptr >= slab->objects
+     && ptr < &slab->objects[ (size_t)slab->carved_count * allocator->stride ] )
+        {
+        return( ( ( ptr - slab->objects ) % allocator->stride ) ? NULL : slab );
+        }
+    }
+
+return( NULL );
+
+} /* FindSlab() */
+#endif
+
+
+/*******************************************************************
+*
+*   PrintLeak()
+*
+*   DESCRIPTION:
+*       Report a leaked object.
+*
+*******************************************************************/
+
+static void PrintLeak( const void *object, void *user )
+{
+(void)user;
+printf( "SlabAllocator:     leaked %p\n", object );
+
+} /* PrintLeak() */
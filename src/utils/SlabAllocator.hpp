@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+
+#include "Utilities.hpp"
+
+
+#define SLAB_ALLOCATOR_CACHE_LINE_SIZE \
+                                    ( 64 )
+#define SLAB_ALLOCATOR_POISON_BYTE  ( 0xdd )
+
+typedef uint32_t SlabAllocatorFlags;
+enum
+    {
+    SLAB_ALLOCATOR_FLAG_NONE        = 0,
+    SLAB_ALLOCATOR_FLAG_CACHE_ALIGN = 1 << 0,   /* round each object up to whole cache lines */
+    SLAB_ALLOCATOR_FLAG_POISON      = 1 << 1,   /* fill freed objects, and check them when reused */
+    SLAB_ALLOCATOR_FLAG_REPORT_LEAKS
+                                    = 1 << 2    /* report live objects on destroy */
+    };
+
+/* called with each object still allocated */
+typedef void SlabAllocatorLeakProc( const void *object, void *user );
+
+/*******************************************************************
+*
+*   SlabAllocatorSlab
+*
+*   DESCRIPTION:
+*       One run of objects.  Objects start on a cache line, and are
+*       only carved off the end of the run as needed, so a new slab
+*       costs nothing until it is used.
+*
+*******************************************************************/
+
+typedef struct _SlabAllocatorSlab
+    {
+    struct _SlabAllocatorSlab
+                       *next;
+    uint8_t            *objects;
+    uint32_t            capacity;
+    uint32_t            carved_count;
+    } SlabAllocatorSlab;
+
+/*******************************************************************
+*
+*   SlabAllocator
+*
+*   DESCRIPTION:
+*       Fixed size object allocator.  Freed objects are linked
+*       through their own first bytes, so allocating and freeing are
+*       both O(1) and need no bookkeeping memory.
+*
+*       An owned allocator adds a slab whenever it runs out.  An
+*       attached allocator carves objects from a single caller
+*       provided array, and fails (returns NULL) once it is used up,
+*       like the static free lists it replaces.
+*
+*       Objects are returned uninitialized.
+*
+*******************************************************************/
+
+typedef struct _SlabAllocator
+    {
+    void               *free_list;
+    SlabAllocatorSlab  *slabs;          /* newest first */
+    SlabAllocatorSlab  *carve_slab;     /* owned slab objects are carved from - slabs after it are all full, or all empty after a reset */
+    SlabAllocatorSlab   attached;       /* the only slab of an attached allocator */
+    uint32_t            object_size;
+    uint32_t            object_alignment;
+    uint32_t            stride;
+    uint32_t            objects_per_slab;
+    uint32_t            slab_count;
+    uint32_t            live_count;
+    uint32_t            peak_live_count;
+    SlabAllocatorFlags  flags;
+    bool                is_attached;
+    } SlabAllocator;
+
+
+void * SlabAllocator_Allocate( SlabAllocator *allocator );
+void   SlabAllocator_Destroy( SlabAllocator *allocator );
+void   SlabAllocator_Free( void *object, SlabAllocator *allocator );
+bool   SlabAllocator_Init( const uint32_t object_size, const uint32_t object_alignment, const uint32_t objects_per_slab, const SlabAllocatorFlags flags, SlabAllocator *allocator );
+bool   SlabAllocator_InitAttached( const uint32_t object_size, const uint32_t count, void *objects, const SlabAllocatorFlags flags, SlabAllocator *allocator );
+void   SlabAllocator_Reset( SlabAllocator *allocator );
+void   SlabAllocator_ReportLeaks( const SlabAllocator *allocator, SlabAllocatorLeakProc *proc, void *user );
+
+
+/*******************************************************************
+*
+*   SlabAllocator_InitForType()
+*
+*   DESCRIPTION:
+*       Initialize an owned slab allocator for the given type.
+*
+*******************************************************************/
+
+#define SlabAllocator_InitForType( _type, _objects_per_slab, _flags, _allocator ) \
+    SlabAllocator_Init( sizeof(_type), alignof(_type), (_objects_per_slab), (_flags), (_allocator) )
+
+
+/*******************************************************************
+*
+*   SlabAllocator_InitAttachedArray()
+*
+*   DESCRIPTION:
+*       Initialize a slab allocator over the given array of objects.
+*
+*******************************************************************/
+
+#define SlabAllocator_InitAttachedArray( _arr, _flags, _allocator ) \
+    SlabAllocator_InitAttached( sizeof(*(_arr)), cnt_of_array( _arr ), (_arr), (_flags), (_allocator) )
+
+
+/*******************************************************************
+*
+*   SlabAllocator_New()
+*
+*   DESCRIPTION:
+*       Allocate an object of the given type.
+*
+*******************************************************************/
+
+#define SlabAllocator_New( _type, _allocator ) \
+    (_type*)SlabAllocator_Allocate( _allocator )
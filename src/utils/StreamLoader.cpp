@@ -0,0 +1,2021 @@
+#define HAVE_STRUCT_TIMESPEC
+#include "pthread.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined( _WIN32 )
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined( __linux__ )
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+#include "StreamLoader.hpp"
+#include "Utilities.hpp"
+
+
+#define LANDING_ALIGNMENT           ( 64 )
+#define NO_SLOT                     ( 0xffffffff )
+#define WAKE_TOKEN                  ( 0xffffffffffffffff )
+#define SLOT_MASK                   ( 0xffffffff )
+
+compiler_assert( STREAM_LOADER_MAX_READ_DEPTH >= STREAM_LOADER_DEFAULT_READ_DEPTH, stream_loader_cpp );
+compiler_assert( STREAM_LOADER_DEFAULT_LANDING_SIZE % LANDING_ALIGNMENT == 0, stream_loader_cpp );
+
+#if defined( _WIN32 )
+typedef HANDLE PlatformFile;
+#define INVALID_PLATFORM_FILE       INVALID_HANDLE_VALUE
+#else
+typedef int PlatformFile;
+#define INVALID_PLATFORM_FILE       ( -1 )
+#endif
+
+typedef struct _StreamSlot
+    {
+    StreamLoaderRequest request;
+    StreamLoaderStatus  status;
+    uint32_t            generation;
+    uint32_t            heap_index;     /* position in the queue, while QUEUED */
+    uint32_t            next;           /* free or ready list link */
+    uint32_t            read_done;      /* bytes read so far */
+    uint64_t            sequence;       /* submit order, to break priority ties */
+    uint64_t            landing_at;     /* payload's offset in the landing memory */
+    uint64_t            landing_order;  /* reservation's place in the release order */
+    uint64_t            submit_ns;
+    uint64_t            issue_ns;
+    bool                is_canceled;    /* canceled while READING */
+    bool                is_delivering;  /* being handed to its done proc */
+    } StreamSlot;
+
+/*******************************************************************
+*
+*   LandingReservation
+*
+*   DESCRIPTION:
+*       Landing memory is a ring.  Reads finish, and are polled, out
+*       of order, so each reservation is marked when released and
+*       the tail only moves past a run of released reservations.
+*
+*******************************************************************/
+
+typedef struct _LandingReservation
+    {
+    uint64_t            end;            /* ring head after the reservation */
+    bool                is_released;
+    } LandingReservation;
+
+typedef struct _IoIssue
+    {
+    uint32_t            slot;
+    PlatformFile        file;
+    uint64_t            offset;
+    uint8_t            *buffer;
+    uint32_t            size;
+    } IoIssue;
+
+typedef struct _IoCompletion
+    {
+    uint32_t            slot;
+    int64_t             result;         /* bytes read, or negative on error */
+    } IoCompletion;
+
+/*******************************************************************
+*
+*   IoBackend
+*
+*   DESCRIPTION:
+*       Platform read queue, only touched by the I/O thread (other
+*       than IoWake()).  Completions that are known as soon as a
+*       read is issued - every read of the blocking backend, and
+*       reads which fail to issue - wait in 'pending'.
+*
+*******************************************************************/
+
+typedef struct _IoBackend
+    {
+    StreamLoaderBackend kind;
+    IoCompletion        pending[ STREAM_LOADER_MAX_READ_DEPTH ];
+    uint32_t            pending_count;
+#if defined( _WIN32 )
+    HANDLE              port;
+    OVERLAPPED          overlapped[ STREAM_LOADER_MAX_REQUEST_COUNT ];
+#elif defined( __linux__ )
+    int                 ring;
+    int                 wake;           /* eventfd which IoWake() signals */
+    uint32_t            unsubmitted;
+    void               *sq_map;
+    size_t              sq_map_sz;
+    void               *cq_map;
+    size_t              cq_map_sz;
+    struct io_uring_sqe
+                       *sqes;
+    size_t              sqes_sz;
+    uint32_t           *sq_head;
+    uint32_t           *sq_tail;
+    uint32_t           *sq_mask;
+    uint32_t           *sq_array;
+    uint32_t           *cq_head;
+    uint32_t           *cq_tail;
+    uint32_t           *cq_mask;
+    struct io_uring_cqe
+                       *cqes;
+    struct iovec        iovecs[ STREAM_LOADER_MAX_REQUEST_COUNT ];
+#endif
+    } IoBackend;
+
+struct _StreamLoader
+    {
+    pthread_t           thread;
+    pthread_mutex_t     mutex;
+    pthread_cond_t      cond;
+    bool                is_thread_running;
+    bool                is_shutting_down;
+    bool                is_waiting_io;      /* I/O thread is blocked on the backend */
+    bool                is_polling;
+    uint32_t            read_depth;
+    uint32_t            in_flight;
+    uint64_t            busy_start_ns;
+    uint64_t            next_sequence;
+
+    PlatformFile        files[ STREAM_LOADER_MAX_FILE_COUNT ];
+
+    StreamSlot          slots[ STREAM_LOADER_MAX_REQUEST_COUNT ];
+    uint32_t            free_head;
+    uint32_t            ready_head;         /* finished requests, oldest first */
+    uint32_t            ready_tail;
+    uint32_t            queue[ STREAM_LOADER_MAX_REQUEST_COUNT ];
+    uint32_t            queue_count;        /* binary max-heap of QUEUED slots */
+    uint32_t            reissues[ STREAM_LOADER_MAX_READ_DEPTH ];
+    uint32_t            reissue_count;      /* short reads to continue */
+
+    uint8_t            *landing;
+    uint64_t            landing_sz;
+    uint64_t            landing_head;
+    uint64_t            landing_tail;
+    LandingReservation  landing_orders[ STREAM_LOADER_MAX_REQUEST_COUNT ];
+    uint64_t            landing_order_head;
+    uint64_t            landing_order_tail;
+
+    StreamLoaderStats   stats;
+    IoBackend           io;
+    };
+
+
+static void         AddReady( const uint32_t slot_index, StreamLoader *loader );
+static void         BeginRead( StreamLoader *loader );
+static void         EndRead( StreamLoader *loader );
+static void         FinishRead( const IoCompletion *completion, StreamLoader *loader );
+static void         FreeLanding( uint8_t *landing, const uint64_t size, const bool is_pinned );
+static void         FreeSlot( const uint32_t slot_index, StreamLoader *loader );
+static bool         HeapIsBefore( const uint32_t a, const uint32_t b, const StreamLoader *loader );
+static void         HeapPush( const uint32_t slot_index, StreamLoader *loader );
+static void         HeapRemove( const uint32_t heap_index, StreamLoader *loader );
+static void         HeapSift( uint32_t heap_index, StreamLoader *loader );
+static void         HeapSwap( const uint32_t a, const uint32_t b, StreamLoader *loader );
+static void         HistogramRecord( const uint64_t value, StreamLoaderHistogram *histogram );
+static void         IoClose( const PlatformFile file );
+static void         IoDestroy( IoBackend *io );
+static bool         IoInit( const uint32_t read_depth, IoBackend *io );
+static void         IoIssueRead( const IoIssue *issue, IoBackend *io );
+static void *       IoMain( void *arg );
+static PlatformFile IoOpen( const char *file_path, const StreamLoaderFile file, IoBackend *io );
+static uint32_t     IoWait( const bool is_blocking, const PlatformFile *files, IoBackend *io, IoCompletion *completions );
+static void         IoWake( IoBackend *io );
+static void         Kick( StreamLoader *loader );
+static StreamSlot * LookupSlot( const StreamLoaderHandle handle, StreamLoader *loader );
+static uint8_t *    MakeLanding( const uint64_t size, bool *is_pinned );
+static void         MakeIssue( const uint32_t slot_index, const StreamLoader *loader, IoIssue *out );
+static void         ReleaseLanding( StreamSlot *slot, StreamLoader *loader );
+static bool         ReserveLanding( const uint32_t size, StreamSlot *slot, StreamLoader *loader );
+
+
+/*******************************************************************
+*
+*   StreamLoader_Cancel()
+*
+*   DESCRIPTION:
+*       Cancel a request.  A queued request is dropped without being
+*       read, a request being read is dropped once the read
+*       finishes, and a ready payload's landing memory is released.
+*       The done proc is still called, by a later poll, with the
+*       CANCELED status.
+*       Returns FALSE if the request has already finished, failed,
+*       or is being delivered.
+*
+*******************************************************************/
+
+bool StreamLoader_Cancel( const StreamLoaderHandle handle, StreamLoader *loader )
+{
+bool ret = false;
+do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+
+StreamSlot *slot = LookupSlot( handle, loader );
+if( slot
+ && !slot->is_delivering )
+    {
+    switch( slot->status )
+        {
+        case STREAM_LOADER_STATUS_QUEUED:
+            HeapRemove( slot->heap_index, loader );
+            slot->status = STREAM_LOADER_STATUS_CANCELED;
+            AddReady( (uint32_t)( handle & SLOT_MASK ), loader );
+            ret = true;
+            break;
+
+        case STREAM_LOADER_STATUS_READING:
+            slot->is_canceled = true;
+            ret = true;
+            break;
+
+        case STREAM_LOADER_STATUS_READY:
+            slot->status = STREAM_LOADER_STATUS_CANCELED;
+            ReleaseLanding( slot, loader );
+            Kick( loader );
+            ret = true;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+return( ret );
+
+} /* StreamLoader_Cancel() */
+
+
+/*******************************************************************
+*
+*   StreamLoader_CloseFile()
+*
+*   DESCRIPTION:
+*       Close a file opened by StreamLoader_OpenFile().  Every
+*       request on the file must have been delivered first.
+*
+*******************************************************************/
+
+void StreamLoader_CloseFile( const StreamLoaderFile file, StreamLoader *loader )
+{
+if( file >= cnt_of_array( loader->files ) )
+    {
+    return;
+    }
+
+do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+debug_if( true,
+    for( uint32_t i = 0; i < cnt_of_array( loader->slots ); i++ )
+        {
+        debug_assert( loader->slots[ i ].status == STREAM_LOADER_STATUS_NONE
+                   || loader->slots[ i ].request.file != file );
+        }
+    );
+
+PlatformFile platform_file = loader->files[ file ];
+loader->files[ file ] = INVALID_PLATFORM_FILE;
+do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+if( platform_file != INVALID_PLATFORM_FILE )
+    {
+    IoClose( platform_file );
+    }
+
+} /* StreamLoader_CloseFile() */
+
+
+/*******************************************************************
+*
+*   StreamLoader_Create()
+*
+*   DESCRIPTION:
+*       Create a streaming loader, with its own I/O thread.
+*
+*       'read_depth' is the most reads in flight at once (zero for
+*       the default).  'landing_size' is the size of the pinned
+*       memory that reads land in (zero for the default), and
+*       bounds the largest request.  Payloads hold their landing
+*       memory until they are polled, so it also bounds how far
+*       reading can run ahead of the consumer.
+*
+*       On Linux reads go through io_uring, falling back to pread
+*       if the kernel doesn't allow it.  On Windows they are
+*       overlapped reads on a completion port.
+*
+*******************************************************************/
+
+StreamLoader * StreamLoader_Create( const uint32_t read_depth, const uint32_t landing_size )
+{
+StreamLoader *ret = (StreamLoader*)calloc( 1, sizeof(StreamLoader) );
+if( !ret )
+    {
+    debug_assert_always();
+    return( NULL );
+    }
+
+ret->read_depth = read_depth ? min_of_vals( read_depth, (uint32_t)STREAM_LOADER_MAX_READ_DEPTH ) : STREAM_LOADER_DEFAULT_READ_DEPTH;
+ret->landing_sz = align_size_round_up( landing_size ? landing_size : STREAM_LOADER_DEFAULT_LANDING_SIZE, LANDING_ALIGNMENT );
+ret->free_head  = NO_SLOT;
+ret->ready_head = NO_SLOT;
+ret->ready_tail = NO_SLOT;
+
+for( uint32_t i = 0; i < cnt_of_array( ret->files ); i++ )
+    {
+    ret->files[ i ] = INVALID_PLATFORM_FILE;
+    }
+
+for( uint32_t i = cnt_of_array( ret->slots ); i > 0; i-- )
+    {
+    ret->slots[ i - 1 ].generation = 1;
+    ret->slots[ i - 1 ].next       = ret->free_head;
+    ret->free_head = i - 1;
+    }
+
+ret->landing = MakeLanding( ret->landing_sz, &ret->stats.is_landing_pinned );
+if( !ret->landing )
+    {
+    debug_assert_always();
+    free( ret );
+    return( NULL );
+    }
+
+if( !IoInit( ret->read_depth, &ret->io ) )
+    {
+    debug_assert_always();
+    FreeLanding( ret->landing, ret->landing_sz, ret->stats.is_landing_pinned );
+    free( ret );
+    return( NULL );
+    }
+
+ret->stats.backend = ret->io.kind;
+if( ret->io.kind == STREAM_LOADER_BACKEND_BLOCKING )
+    {
+    /* each read blocks the I/O thread, so take one at a time to keep to the priority order */
+    ret->read_depth = 1;
+    }
+
+do_debug_assert( !pthread_mutex_init( &ret->mutex, NULL ) );
+do_debug_assert( !pthread_cond_init( &ret->cond, NULL ) );
+if( pthread_create( &ret->thread, NULL, IoMain, ret ) )
+    {
+    debug_assert_always();
+    StreamLoader_Destroy( ret );
+    return( NULL );
+    }
+
+ret->is_thread_running = true;
+
+return( ret );
+
+} /* StreamLoader_Create() */
+
+
+/*******************************************************************
+*
+*   StreamLoader_Destroy()
+*
+*   DESCRIPTION:
+*       Wait for the reads in flight, stop the I/O thread, close the
+*       files, and free the loader.  Requests which haven't been
+*       delivered are abandoned without calling their done procs.
+*
+*******************************************************************/
+
+void StreamLoader_Destroy( StreamLoader *loader )
+{
+if( !loader )
+    {
+    return;
+    }
+
+if( loader->is_thread_running )
+    {
+    do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+    loader->is_shutting_down = true;
+    Kick( loader );
+    do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+    pthread_join( loader->thread, NULL );
+    }
+
+for( uint32_t i = 0; i < cnt_of_array( loader->files ); i++ )
+    {
+    if( loader->files[ i ] != INVALID_PLATFORM_FILE )
+        {
+        IoClose( loader->files[ i ] );
+        }
+    }
+
+IoDestroy( &loader->io );
+FreeLanding( loader->landing, loader->landing_sz, loader->stats.is_landing_pinned );
+
+pthread_cond_destroy( &loader->cond );
+pthread_mutex_destroy( &loader->mutex );
+
+free( loader );
+
+} /* StreamLoader_Destroy() */
+
+
+/*******************************************************************
+*
+*   StreamLoader_GetStatus()
+*
+*   DESCRIPTION:
+*       Get a request's status.  Once a request has been delivered
+*       its handle is stale, and the status is NONE.
+*
+*******************************************************************/
+
+StreamLoaderStatus StreamLoader_GetStatus( const StreamLoaderHandle handle, StreamLoader *loader )
+{
+do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+StreamSlot *slot = LookupSlot( handle, loader );
+StreamLoaderStatus ret = slot ? slot->status : (StreamLoaderStatus)STREAM_LOADER_STATUS_NONE;
+do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+return( ret );
+
+} /* StreamLoader_GetStatus() */
+
+
+/*******************************************************************
+*
+*   StreamLoader_GetStats()
+*
+*   DESCRIPTION:
+*       Get a snapshot of the loader's counters and histograms.
+*
+*******************************************************************/
+
+void StreamLoader_GetStats( StreamLoader *loader, StreamLoaderStats *out )
+{
+do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+*out = loader->stats;
+if( loader->in_flight )
+    {
+    out->busy_ns += Utilities_GetTimeNanoseconds() - loader->busy_start_ns;
+    }
+
+do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+} /* StreamLoader_GetStats() */
+
+
+/*******************************************************************
+*
+*   StreamLoader_HistogramPercentile()
+*
+*   DESCRIPTION:
+*       Get an upper bound on the given fraction of the samples,
+*       e.g. 0.99 for the 99th percentile.  The bound is the top of
+*       the bucket the percentile falls in, capped at the largest
+*       sample.
+*
+*******************************************************************/
+
+uint64_t StreamLoader_HistogramPercentile( const StreamLoaderHistogram *histogram, const float fraction )
+{
+if( histogram->sample_count == 0 )
+    {
+    return( 0 );
+    }
+
+uint64_t target = (uint64_t)( (double)fraction * (double)histogram->sample_count + 0.5 );
+target = max_of_vals( target, (uint64_t)1 );
+
+uint64_t seen = 0;
+for( uint32_t i = 0; i < cnt_of_array( histogram->counts ); i++ )
+    {
+    seen += histogram->counts[ i ];
+    if( seen >= target )
+        {
+        uint64_t bound = i ? ( (uint64_t)1 << i ) - 1 : 0;
+        return( min_of_vals( bound, histogram->max ) );
+        }
+    }
+
+return( histogram->max );
+
+} /* StreamLoader_HistogramPercentile() */
+
+
+/*******************************************************************
+*
+*   StreamLoader_OpenFile()
+*
+*   DESCRIPTION:
+*       Open a file to read from.  Returns STREAM_LOADER_INVALID_FILE
+*       if it can't be opened, or too many files are open.
+*
+*******************************************************************/
+
+StreamLoaderFile StreamLoader_OpenFile( const char *file_path, StreamLoader *loader )
+{
+hard_assert( file_path );
+
+do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+StreamLoaderFile ret = STREAM_LOADER_INVALID_FILE;
+for( uint32_t i = 0; i < cnt_of_array( loader->files ); i++ )
+    {
+    if( loader->files[ i ] == INVALID_PLATFORM_FILE )
+        {
+        loader->files[ i ] = IoOpen( file_path, i, &loader->io );
+        if( loader->files[ i ] != INVALID_PLATFORM_FILE )
+            {
+            ret = i;
+            }
+
+        break;
+        }
+    }
+
+do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+return( ret );
+
+} /* StreamLoader_OpenFile() */
+
+
+/*******************************************************************
+*
+*   StreamLoader_Poll()
+*
+*   DESCRIPTION:
+*       Deliver finished requests to their done procs, on the
+*       calling thread, oldest first.  Delivery stops once the READY
+*       payloads delivered reach 'byte_budget' (the first is always
+*       delivered), or a done proc declines its payload.  A budget
+*       of zero delivers everything ready.
+*
+*       Not reentrant - done procs may submit and cancel, but not
+*       poll.
+*       Returns the number of requests delivered.
+*
+*******************************************************************/
+
+uint32_t StreamLoader_Poll( const uint32_t byte_budget, StreamLoader *loader )
+{
+uint32_t ret = 0;
+uint64_t delivered_sz = 0;
+bool is_released = false;
+
+do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+debug_assert( !loader->is_polling );
+loader->is_polling = true;
+
+while( loader->ready_head != NO_SLOT )
+    {
+    uint32_t slot_index = loader->ready_head;
+    StreamSlot *slot = &loader->slots[ slot_index ];
+    if( slot->status == STREAM_LOADER_STATUS_READY
+     && byte_budget
+     && delivered_sz
+     && delivered_sz + slot->request.size > byte_budget )
+        {
+        break;
+        }
+
+    /*------------------------------------------------
+    Call the done proc unlocked, so the I/O thread
+    keeps going while the payload is consumed
+    ------------------------------------------------*/
+    StreamLoaderHandle handle = ( (uint64_t)slot->generation << 32 ) | slot_index;
+    StreamLoaderStatus status = slot->status;
+    const void *data = ( status == STREAM_LOADER_STATUS_READY ) ? loader->landing + slot->landing_at : NULL;
+    slot->is_delivering = true;
+
+    do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+    bool is_consumed = slot->request.done( handle, status, data, slot->request.size, slot->request.user );
+    do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+
+    slot->is_delivering = false;
+    if( status == STREAM_LOADER_STATUS_READY
+     && !is_consumed )
+        {
+        break;
+        }
+
+    loader->ready_head = slot->next;
+    if( loader->ready_head == NO_SLOT )
+        {
+        loader->ready_tail = NO_SLOT;
+        }
+
+    switch( status )
+        {
+        case STREAM_LOADER_STATUS_READY:
+            ReleaseLanding( slot, loader );
+            is_released = true;
+            delivered_sz += slot->request.size;
+            loader->stats.delivered_count++;
+            HistogramRecord( ( Utilities_GetTimeNanoseconds() - slot->submit_ns ) / 1000, &loader->stats.latency_us );
+            break;
+
+        case STREAM_LOADER_STATUS_CANCELED:
+            loader->stats.canceled_count++;
+            break;
+
+        default:
+            loader->stats.failed_count++;
+            break;
+        }
+
+    FreeSlot( slot_index, loader );
+    ret++;
+    }
+
+if( is_released )
+    {
+    Kick( loader );
+    }
+
+loader->is_polling = false;
+do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+return( ret );
+
+} /* StreamLoader_Poll() */
+
+
+/*******************************************************************
+*
+*   StreamLoader_Reprioritize()
+*
+*   DESCRIPTION:
+*       Change the priority of a queued request.
+*       Returns FALSE if the request is no longer queued.
+*
+*******************************************************************/
+
+bool StreamLoader_Reprioritize( const StreamLoaderHandle handle, const int32_t priority, StreamLoader *loader )
+{
+bool ret = false;
+do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+
+StreamSlot *slot = LookupSlot( handle, loader );
+if( slot
+ && slot->status == STREAM_LOADER_STATUS_QUEUED )
+    {
+    slot->request.priority = priority;
+    HeapSift( slot->heap_index, loader );
+    ret = true;
+    }
+
+do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+return( ret );
+
+} /* StreamLoader_Reprioritize() */
+
+
+/*******************************************************************
+*
+*   StreamLoader_Submit()
+*
+*   DESCRIPTION:
+*       Queue a read of part of an open file.  The request is
+*       copied.  Returns STREAM_LOADER_INVALID_HANDLE if the request
+*       is bad (empty, or larger than the landing memory) or too
+*       many requests are outstanding.
+*
+*******************************************************************/
+
+StreamLoaderHandle StreamLoader_Submit( const StreamLoaderRequest *request, StreamLoader *loader )
+{
+if( !request->done
+ || request->size == 0
+ || request->size > loader->landing_sz
+ || request->file >= cnt_of_array( loader->files ) )
+    {
+    debug_assert_always();
+    return( STREAM_LOADER_INVALID_HANDLE );
+    }
+
+StreamLoaderHandle ret = STREAM_LOADER_INVALID_HANDLE;
+do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+if( loader->free_head != NO_SLOT
+ && loader->files[ request->file ] != INVALID_PLATFORM_FILE )
+    {
+    uint32_t slot_index = loader->free_head;
+    StreamSlot *slot = &loader->slots[ slot_index ];
+    loader->free_head = slot->next;
+
+    slot->request       = *request;
+    slot->status        = STREAM_LOADER_STATUS_QUEUED;
+    slot->next          = NO_SLOT;
+    slot->read_done     = 0;
+    slot->sequence      = loader->next_sequence++;
+    slot->submit_ns     = Utilities_GetTimeNanoseconds();
+    slot->is_canceled   = false;
+    slot->is_delivering = false;
+    HeapPush( slot_index, loader );
+
+    loader->stats.submitted_count++;
+    ret = ( (uint64_t)slot->generation << 32 ) | slot_index;
+    Kick( loader );
+    }
+
+do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+return( ret );
+
+} /* StreamLoader_Submit() */
+
+
+/*******************************************************************
+*
+*   AddReady()
+*
+*   DESCRIPTION:
+*       Append a finished request to the ready list.
+*
+*******************************************************************/
+
+static void AddReady( const uint32_t slot_index, StreamLoader *loader )
+{
+loader->slots[ slot_index ].next = NO_SLOT;
+if( loader->ready_tail != NO_SLOT )
+    {
+    loader->slots[ loader->ready_tail ].next = slot_index;
+    }
+else
+    {
+    loader->ready_head = slot_index;
+    }
+
+loader->ready_tail = slot_index;
+
+} /* AddReady() */
+
+
+/*******************************************************************
+*
+*   BeginRead()
+*
+*   DESCRIPTION:
+*       Count a read going in flight, and start the busy clock if
+*       it's the only one.
+*
+*******************************************************************/
+
+static void BeginRead( StreamLoader *loader )
+{
+if( loader->in_flight++ == 0 )
+    {
+    loader->busy_start_ns = Utilities_GetTimeNanoseconds();
+    }
+
+} /* BeginRead() */
+
+
+/*******************************************************************
+*
+*   EndRead()
+*
+*   DESCRIPTION:
+*       Count a read finishing, and stop the busy clock if it was
+*       the last one.
+*
+*******************************************************************/
+
+static void EndRead( StreamLoader *loader )
+{
+debug_assert( loader->in_flight );
+if( --loader->in_flight == 0 )
+    {
+    loader->stats.busy_ns += Utilities_GetTimeNanoseconds() - loader->busy_start_ns;
+    }
+
+} /* EndRead() */
+
+
+/*******************************************************************
+*
+*   FinishRead()
+*
+*   DESCRIPTION:
+*       Handle a finished read.  A short read is continued from
+*       where it stopped, unless it hit the end of the file.
+*
+*******************************************************************/
+
+static void FinishRead( const IoCompletion *completion, StreamLoader *loader )
+{
+StreamSlot *slot = &loader->slots[ completion->slot ];
+debug_assert( slot->status == STREAM_LOADER_STATUS_READING );
+
+bool is_failed = ( completion->result <= 0 );
+if( !is_failed )
+    {
+    slot->read_done += (uint32_t)completion->result;
+    loader->stats.bytes_read += (uint64_t)completion->result;
+    if( slot->read_done < slot->request.size
+     && !slot->is_canceled )
+        {
+        loader->reissues[ loader->reissue_count++ ] = completion->slot;
+        return;
+        }
+    }
+
+EndRead( loader );
+
+uint64_t read_ns = max_of_vals( Utilities_GetTimeNanoseconds() - slot->issue_ns, (uint64_t)1 );
+HistogramRecord( read_ns / 1000, &loader->stats.read_us );
+HistogramRecord( (uint64_t)slot->read_done * 1000000000 / 1024 / read_ns, &loader->stats.throughput_kbps );
+
+if( slot->is_canceled )
+    {
+    slot->status = STREAM_LOADER_STATUS_CANCELED;
+    }
+else if( is_failed )
+    {
+    slot->status = STREAM_LOADER_STATUS_FAILED;
+    }
+else
+    {
+    slot->status = STREAM_LOADER_STATUS_READY;
+    }
+
+if( slot->status != STREAM_LOADER_STATUS_READY )
+    {
+    ReleaseLanding( slot, loader );
+    }
+
+AddReady( completion->slot, loader );
+
+} /* FinishRead() */
+
+
+/*******************************************************************
+*
+*   FreeLanding()
+*
+*   DESCRIPTION:
+*       Free the landing memory, and give back the working set
+*       MakeLanding() took to pin it.
+*
+*******************************************************************/
+
+static void FreeLanding( uint8_t *landing, const uint64_t size, const bool is_pinned )
+{
+#if defined( _WIN32 )
+if( is_pinned )
+    {
+    HANDLE process = GetCurrentProcess();
+    SIZE_T min_working_set;
+    SIZE_T max_working_set;
+    VirtualUnlock( landing, (SIZE_T)size );
+    if( GetProcessWorkingSetSize( process, &min_working_set, &max_working_set ) )
+        {
+        SetProcessWorkingSetSize( process, min_working_set - (SIZE_T)size, max_working_set - (SIZE_T)size );
+        }
+    }
+
+VirtualFree( landing, 0, MEM_RELEASE );
+#else
+if( is_pinned )
+    {
+    munlock( landing, (size_t)size );
+    }
+
+munmap( landing, (size_t)size );
+#endif
+
+} /* FreeLanding() */
+
+
+/*******************************************************************
+*
+*   FreeSlot()
+*
+*   DESCRIPTION:
+*       Return a delivered request's slot to the free list, and
+*       make its handle stale.
+*
+*******************************************************************/
+
+static void FreeSlot( const uint32_t slot_index, StreamLoader *loader )
+{
+StreamSlot *slot = &loader->slots[ slot_index ];
+slot->status = STREAM_LOADER_STATUS_NONE;
+slot->generation++;
+if( slot->generation == 0 )
+    {
+    /* handles are never zero */
+    slot->generation = 1;
+    }
+
+slot->next = loader->free_head;
+loader->free_head = slot_index;
+
+} /* FreeSlot() */
+
+
+/*******************************************************************
+*
+*   HeapIsBefore()
+*
+*   DESCRIPTION:
+*       Should slot 'a' be read before slot 'b'?  Higher priority
+*       first, then the earlier submit.
+*
+*******************************************************************/
+
+static bool HeapIsBefore( const uint32_t a, const uint32_t b, const StreamLoader *loader )
+{
+const StreamSlot *slot_a = &loader->slots[ a ];
+const StreamSlot *slot_b = &loader->slots[ b ];
+if( slot_a->request.priority != slot_b->request.priority )
+    {
+    return( slot_a->request.priority > slot_b->request.priority );
+    }
+
+return( slot_a->sequence < slot_b->sequence );
+
+} /* HeapIsBefore() */
+
+
+/*******************************************************************
+*
+*   HeapPush()
+*
+*   DESCRIPTION:
+*       Add a slot to the priority queue.
+*
+*******************************************************************/
+
+static void HeapPush( const uint32_t slot_index, StreamLoader *loader )
+{
+debug_assert( loader->queue_count < cnt_of_array( loader->queue ) );
+uint32_t heap_index = loader->queue_count++;
+loader->queue[ heap_index ] = slot_index;
+loader->slots[ slot_index ].heap_index = heap_index;
+HeapSift( heap_index, loader );
+
+} /* HeapPush() */
+
+
+/*******************************************************************
+*
+*   HeapRemove()
+*
+*   DESCRIPTION:
+*       Remove the slot at the given position of the priority
+*       queue.  The last slot fills the hole and is sifted into
+*       place.
+*
+*******************************************************************/
+
+static void HeapRemove( const uint32_t heap_index, StreamLoader *loader )
+{
+debug_assert( heap_index < loader->queue_count );
+uint32_t last = --loader->queue_count;
+if( heap_index != last )
+    {
+    HeapSwap( heap_index, last, loader );
+    HeapSift( heap_index, loader );
+    }
+
+} /* HeapRemove() */
+
+
+/*******************************************************************
+*
+*   HeapSift()
+*
+*   DESCRIPTION:
+*       Move a slot up or down the priority queue to where it
+*       belongs, after its priority changed.
+*
+*******************************************************************/
+
+static void HeapSift( uint32_t heap_index, StreamLoader *loader )
+{
+while( heap_index > 0 )
+    {
+    uint32_t parent = ( heap_index - 1 ) / 2;
+    if( !HeapIsBefore( loader->queue[ heap_index ], loader->queue[ parent ], loader ) )
+        {
+        break;
+        }
+
+    HeapSwap( heap_index, parent, loader );
+    heap_index = parent;
+    }
+
+while( true )
+    {
+    uint32_t first = heap_index;
+    uint32_t left  = 2 * heap_index + 1;
+    uint32_t right = left + 1;
+    if( left < loader->queue_count
+     && HeapIsBefore( loader->queue[ left ], loader->queue[ first ], loader ) )
+        {
+        first = left;
+        }
+
+    if( right < loader->queue_count
+     && HeapIsBefore( loader->queue[ right ], loader->queue[ first ], loader ) )
+        {
+        first = right;
+        }
+
+    if( first == heap_index )
+        {
+        break;
+        }
+
+    HeapSwap( heap_index, first, loader );
+    heap_index = first;
+    }
+
+} /* HeapSift() */
+
+
+/*******************************************************************
+*
+*   HeapSwap()
+*
+*   DESCRIPTION:
+*       Swap two positions of the priority queue.
+*
+*******************************************************************/
+
+static void HeapSwap( const uint32_t a, const uint32_t b, StreamLoader *loader )
+{
+uint32_t slot_a = loader->queue[ a ];
+uint32_t slot_b = loader->queue[ b ];
+loader->queue[ a ] = slot_b;
+loader->queue[ b ] = slot_a;
+loader->slots[ slot_a ].heap_index = b;
+loader->slots[ slot_b ].heap_index = a;
+
+} /* HeapSwap() */
+
+
+/*******************************************************************
+*
+*   HistogramRecord()
+*
+*   DESCRIPTION:
+*       Add a sample to a power-of-two histogram.
+*
+*******************************************************************/
+
+static void HistogramRecord( const uint64_t value, StreamLoaderHistogram *histogram )
+{
+uint32_t bucket = 0;
+for( uint64_t rest = value; rest; rest >>= 1 )
+    {
+    bucket++;
+    }
+
+bucket = min_of_vals( bucket, (uint32_t)cnt_of_array( histogram->counts ) - 1 );
+histogram->counts[ bucket ]++;
+histogram->sample_count++;
+histogram->sum += value;
+histogram->max = max_of_vals( histogram->max, value );
+
+} /* HistogramRecord() */
+
+
+/*******************************************************************
+*
+*   IoMain()
+*
+*   DESCRIPTION:
+*       I/O thread entry point.  Issue the highest priority reads
+*       while there's depth and landing memory for them, then wait
+*       for reads to finish, or to be woken by a submit or poll.
+*       On shutdown the reads in flight are waited for, since they
+*       write into the landing memory.
+*
+*******************************************************************/
+
+static void * IoMain( void *arg )
+{
+StreamLoader *loader = (StreamLoader*)arg;
+IoIssue       issues[ STREAM_LOADER_MAX_READ_DEPTH ];
+IoCompletion  completions[ STREAM_LOADER_MAX_READ_DEPTH ];
+
+do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+while( true )
+    {
+    uint32_t issue_count = 0;
+    for( uint32_t i = 0; i < loader->reissue_count; i++ )
+        {
+        MakeIssue( loader->reissues[ i ], loader, &issues[ issue_count++ ] );
+        }
+
+    loader->reissue_count = 0;
+
+    /*------------------------------------------------
+    Take the highest priority reads.  Stop at the
+    first that doesn't fit rather than let smaller,
+    lower priority reads past it
+    ------------------------------------------------*/
+    while( !loader->is_shutting_down
+        && loader->queue_count
+        && loader->in_flight < loader->read_depth )
+        {
+        uint32_t slot_index = loader->queue[ 0 ];
+        StreamSlot *slot = &loader->slots[ slot_index ];
+        if( !ReserveLanding( slot->request.size, slot, loader ) )
+            {
+            break;
+            }
+
+        HeapRemove( 0, loader );
+        slot->status   = STREAM_LOADER_STATUS_READING;
+        slot->issue_ns = Utilities_GetTimeNanoseconds();
+        HistogramRecord( ( slot->issue_ns - slot->submit_ns ) / 1000, &loader->stats.queue_us );
+        BeginRead( loader );
+        MakeIssue( slot_index, loader, &issues[ issue_count++ ] );
+        }
+
+    if( loader->in_flight == 0 )
+        {
+        if( loader->is_shutting_down )
+            {
+            break;
+            }
+
+        pthread_cond_wait( &loader->cond, &loader->mutex );
+        continue;
+        }
+
+    /*------------------------------------------------
+    Issue and wait unlocked
+    ------------------------------------------------*/
+    loader->is_waiting_io = true;
+    const PlatformFile *files = loader->files;
+    do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+    for( uint32_t i = 0; i < issue_count; i++ )
+        {
+        IoIssueRead( &issues[ i ], &loader->io );
+        }
+
+    uint32_t completion_count = IoWait( true, files, &loader->io, completions );
+
+    do_debug_assert( !pthread_mutex_lock( &loader->mutex ) );
+    loader->is_waiting_io = false;
+    for( uint32_t i = 0; i < completion_count; i++ )
+        {
+        FinishRead( &completions[ i ], loader );
+        }
+    }
+
+do_debug_assert( !pthread_mutex_unlock( &loader->mutex ) );
+
+return( NULL );
+
+} /* IoMain() */
+
+
+/*******************************************************************
+*
+*   Kick()
+*
+*   DESCRIPTION:
+*       Wake the I/O thread to look at the queue again, wherever
+*       it's waiting.  Called with the mutex held.
+*
+*******************************************************************/
+
+static void Kick( StreamLoader *loader )
+{
+if( loader->is_waiting_io )
+    {
+    IoWake( &loader->io );
+    }
+else
+    {
+    do_debug_assert( !pthread_cond_signal( &loader->cond ) );
+    }
+
+} /* Kick() */
+
+
+/*******************************************************************
+*
+*   LookupSlot()
+*
+*   DESCRIPTION:
+*       Get the slot of a live request, or NULL if the handle is
+*       stale.  Called with the mutex held.
+*
+*******************************************************************/
+
+static StreamSlot * LookupSlot( const StreamLoaderHandle handle, StreamLoader *loader )
+{
+uint32_t slot_index = (uint32_t)( handle & SLOT_MASK );
+if( slot_index >= cnt_of_array( loader->slots ) )
+    {
+    return( NULL );
+    }
+
+StreamSlot *ret = &loader->slots[ slot_index ];
+if( ret->generation != (uint32_t)( handle >> 32 )
+ || ret->status == STREAM_LOADER_STATUS_NONE )
+    {
+    return( NULL );
+    }
+
+return( ret );
+
+} /* LookupSlot() */
+
+
+/*******************************************************************
+*
+*   MakeIssue()
+*
+*   DESCRIPTION:
+*       Describe the read of what's left of a request.
+*
+*******************************************************************/
+
+static void MakeIssue( const uint32_t slot_index, const StreamLoader *loader, IoIssue *out )
+{
+const StreamSlot *slot = &loader->slots[ slot_index ];
+out->slot   = slot_index;
+out->file   = loader->files[ slot->request.file ];
+out->offset = slot->request.offset + slot->read_done;
+out->buffer = loader->landing + slot->landing_at + slot->read_done;
+out->size   = slot->request.size - slot->read_done;
+
+} /* MakeIssue() */
+
+
+/*******************************************************************
+*
+*   MakeLanding()
+*
+*   DESCRIPTION:
+*       Allocate the landing memory, page-locked where the process
+*       is allowed to lock it, so the kernel copies reads straight
+*       into resident pages.
+*
+*       Windows only lets a process lock as much as its minimum
+*       working set, which defaults to well under a megabyte, so
+*       grow the working set by the landing size first.
+*
+*******************************************************************/
+
+static uint8_t * MakeLanding( const uint64_t size, bool *is_pinned )
+{
+#if defined( _WIN32 )
+void *ret = VirtualAlloc( NULL, (SIZE_T)size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+if( !ret )
+    {
+    return( NULL );
+    }
+
+HANDLE process = GetCurrentProcess();
+SIZE_T min_working_set;
+SIZE_T max_working_set;
+*is_pinned = false;
+if( GetProcessWorkingSetSize( process, &min_working_set, &max_working_set )
+ && SetProcessWorkingSetSize( process, min_working_set + (SIZE_T)size, max_working_set + (SIZE_T)size ) )
+    {
+    *is_pinned = ( VirtualLock( ret, (SIZE_T)size ) != FALSE );
+    if( !*is_pinned )
+        {
+        SetProcessWorkingSetSize( process, min_working_set, max_working_set );
+        }
+    }
+
+#else
+void *ret = mmap( NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+if( ret == MAP_FAILED )
+    {
+    return( NULL );
+    }
+
+*is_pinned = ( mlock( ret, (size_t)size ) == 0 );
+
+#endif
+return( (uint8_t*)ret );
+
+} /* MakeLanding() */
+
+
+/*******************************************************************
+*
+*   ReleaseLanding()
+*
+*   DESCRIPTION:
+*       Release a request's landing memory, and move the tail past
+*       every released reservation at the front of the ring.
+*
+*******************************************************************/
+
+static void ReleaseLanding( StreamSlot *slot, StreamLoader *loader )
+{
+loader->landing_orders[ slot->landing_order % cnt_of_array( loader->landing_orders ) ].is_released = true;
+while( loader->landing_order_tail != loader->landing_order_head )
+    {
+    LandingReservation *oldest = &loader->landing_orders[ loader->landing_order_tail % cnt_of_array( loader->landing_orders ) ];
+    if( !oldest->is_released )
+        {
+        break;
+        }
+
+    loader->landing_tail = oldest->end;
+    loader->landing_order_tail++;
+    }
+
+} /* ReleaseLanding() */
+
+
+/*******************************************************************
+*
+*   ReserveLanding()
+*
+*   DESCRIPTION:
+*       Reserve contiguous landing memory for a request, wrapping to
+*       the start of the ring if it won't fit before the end.
+*       Returns FALSE if there isn't room yet.
+*
+*******************************************************************/
+
+static bool ReserveLanding( const uint32_t size, StreamSlot *slot, StreamLoader *loader )
+{
+if( loader->landing_head == loader->landing_tail )
+    {
+    /* an empty ring - start over so any size that fits, fits */
+    loader->landing_head = 0;
+    loader->landing_tail = 0;
+    }
+
+uint64_t sz     = align_size_round_up( size, LANDING_ALIGNMENT );
+uint64_t at     = loader->landing_head % loader->landing_sz;
+uint64_t start  = at;
+uint64_t needed = sz;
+if( at + sz > loader->landing_sz )
+    {
+    start  = 0;
+    needed = loader->landing_sz - at + sz;
+    }
+
+if( loader->landing_sz - ( loader->landing_head - loader->landing_tail ) < needed
+ || loader->landing_order_head - loader->landing_order_tail == cnt_of_array( loader->landing_orders ) )
+    {
+    return( false );
+    }
+
+LandingReservation *reservation = &loader->landing_orders[ loader->landing_order_head % cnt_of_array( loader->landing_orders ) ];
+loader->landing_head += needed;
+reservation->end         = loader->landing_head;
+reservation->is_released = false;
+
+slot->landing_at    = start;
+slot->landing_order = loader->landing_order_head++;
+
+return( true );
+
+} /* ReserveLanding() */
+
+
+#if defined( _WIN32 )
+/*******************************************************************
+*
+*   IoClose()
+*
+*   DESCRIPTION:
+*       Close a file.
+*
+*******************************************************************/
+
+static void IoClose( const PlatformFile file )
+{
+CloseHandle( file );
+
+} /* IoClose() */
+
+
+/*******************************************************************
+*
+*   IoDestroy()
+*
+*   DESCRIPTION:
+*       Free the completion port.
+*
+*******************************************************************/
+
+static void IoDestroy( IoBackend *io )
+{
+if( io->port )
+    {
+    CloseHandle( io->port );
+    }
+
+} /* IoDestroy() */
+
+
+/*******************************************************************
+*
+*   IoInit()
+*
+*   DESCRIPTION:
+*       Make the completion port which overlapped reads finish on.
+*
+*******************************************************************/
+
+static bool IoInit( const uint32_t read_depth, IoBackend *io )
+{
+io->kind = STREAM_LOADER_BACKEND_OVERLAPPED;
+io->port = CreateIoCompletionPort( INVALID_HANDLE_VALUE, NULL, 0, 1 );
+
+return( io->port != NULL );
+
+} /* IoInit() */
+
+
+/*******************************************************************
+*
+*   IoIssueRead()
+*
+*   DESCRIPTION:
+*       Start an overlapped read.  It finishes on the completion
+*       port even if ReadFile() finishes it immediately.
+*
+*******************************************************************/
+
+static void IoIssueRead( const IoIssue *issue, IoBackend *io )
+{
+OVERLAPPED *overlapped = &io->overlapped[ issue->slot ];
+*overlapped = {};
+overlapped->Offset     = (DWORD)issue->offset;
+overlapped->OffsetHigh = (DWORD)( issue->offset >> 32 );
+
+if( !ReadFile( issue->file, issue->buffer, (DWORD)issue->size, NULL, overlapped )
+ && GetLastError() != ERROR_IO_PENDING )
+    {
+    IoCompletion *completion = &io->pending[ io->pending_count++ ];
+    completion->slot   = issue->slot;
+    completion->result = ( GetLastError() == ERROR_HANDLE_EOF ) ? 0 : -1;
+    }
+
+} /* IoIssueRead() */
+
+
+/*******************************************************************
+*
+*   IoOpen()
+*
+*   DESCRIPTION:
+*       Open a file for overlapped reads, and tie it to the
+*       completion port with its index as the key.
+*
+*******************************************************************/
+
+static PlatformFile IoOpen( const char *file_path, const StreamLoaderFile file, IoBackend *io )
+{
+HANDLE ret = CreateFileA( file_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, NULL );
+if( ret == INVALID_HANDLE_VALUE )
+    {
+    return( INVALID_PLATFORM_FILE );
+    }
+
+if( CreateIoCompletionPort( ret, io->port, (ULONG_PTR)file, 0 ) != io->port )
+    {
+    CloseHandle( ret );
+    return( INVALID_PLATFORM_FILE );
+    }
+
+return( ret );
+
+} /* IoOpen() */
+
+
+/*******************************************************************
+*
+*   IoWait()
+*
+*   DESCRIPTION:
+*       Collect finished reads, blocking for at least one (or a
+*       wake) if none have finished.
+*
+*******************************************************************/
+
+static uint32_t IoWait( const bool is_blocking, const PlatformFile *files, IoBackend *io, IoCompletion *completions )
+{
+uint32_t ret = 0;
+for( uint32_t i = 0; i < io->pending_count; i++ )
+    {
+    completions[ ret++ ] = io->pending[ i ];
+    }
+
+io->pending_count = 0;
+
+OVERLAPPED_ENTRY entries[ STREAM_LOADER_MAX_READ_DEPTH ];
+ULONG entry_count = 0;
+DWORD timeout = ( is_blocking && ret == 0 ) ? INFINITE : 0;
+if( !GetQueuedCompletionStatusEx( io->port, entries, cnt_of_array( entries ) - ret, &entry_count, timeout, FALSE ) )
+    {
+    return( ret );
+    }
+
+for( ULONG i = 0; i < entry_count; i++ )
+    {
+    if( !entries[ i ].lpOverlapped )
+        {
+        /* IoWake() */
+        continue;
+        }
+
+    DWORD read_sz = 0;
+    IoCompletion *completion = &completions[ ret++ ];
+    completion->slot = (uint32_t)( entries[ i ].lpOverlapped - io->overlapped );
+    if( GetOverlappedResult( files[ entries[ i ].lpCompletionKey ], entries[ i ].lpOverlapped, &read_sz, FALSE ) )
+        {
+        completion->result = (int64_t)read_sz;
+        }
+    else
+        {
+        completion->result = ( GetLastError() == ERROR_HANDLE_EOF ) ? 0 : -1;
+        }
+    }
+
+return( ret );
+
+} /* IoWait() */
+
+
+/*******************************************************************
+*
+*   IoWake()
+*
+*   DESCRIPTION:
+*       Wake the I/O thread from IoWait().  May be called from any
+*       thread.
+*
+*******************************************************************/
+
+static void IoWake( IoBackend *io )
+{
+PostQueuedCompletionStatus( io->port, 0, 0, NULL );
+
+} /* IoWake() */
+
+
+#else
+#if defined( __linux__ )
+static bool     UringEnter( const uint32_t min_complete, IoBackend *io );
+static void     UringPushPollWake( IoBackend *io );
+static bool     UringSetup( const uint32_t read_depth, IoBackend *io );
+static void     UringTeardown( IoBackend *io );
+#endif
+
+
+/*******************************************************************
+*
+*   IoClose()
+*
+*   DESCRIPTION:
+*       Close a file.
+*
+*******************************************************************/
+
+static void IoClose( const PlatformFile file )
+{
+close( file );
+
+} /* IoClose() */
+
+
+/*******************************************************************
+*
+*   IoDestroy()
+*
+*   DESCRIPTION:
+*       Free the io_uring, if there is one.
+*
+*******************************************************************/
+
+static void IoDestroy( IoBackend *io )
+{
+#if defined( __linux__ )
+if( io->kind == STREAM_LOADER_BACKEND_IO_URING )
+    {
+    UringTeardown( io );
+    }
+#endif
+
+} /* IoDestroy() */
+
+
+/*******************************************************************
+*
+*   IoInit()
+*
+*   DESCRIPTION:
+*       Set up an io_uring.  If the kernel doesn't have it, or
+*       doesn't allow it (seccomp in containers often doesn't), fall
+*       back to blocking reads.
+*
+*******************************************************************/
+
+static bool IoInit( const uint32_t read_depth, IoBackend *io )
+{
+io->kind = STREAM_LOADER_BACKEND_BLOCKING;
+#if defined( __linux__ )
+io->ring = -1;
+io->wake = -1;
+if( UringSetup( read_depth, io ) )
+    {
+    io->kind = STREAM_LOADER_BACKEND_IO_URING;
+    }
+#endif
+
+return( true );
+
+} /* IoInit() */
+
+
+/*******************************************************************
+*
+*   IoIssueRead()
+*
+*   DESCRIPTION:
+*       Queue a read on the io_uring, to be submitted by the next
+*       IoWait().  The blocking backend reads it now.
+*
+*******************************************************************/
+
+static void IoIssueRead( const IoIssue *issue, IoBackend *io )
+{
+#if defined( __linux__ )
+if( io->kind == STREAM_LOADER_BACKEND_IO_URING )
+    {
+    io->iovecs[ issue->slot ].iov_base = issue->buffer;
+    io->iovecs[ issue->slot ].iov_len  = issue->size;
+
+    uint32_t tail  = *io->sq_tail;
+    uint32_t index = tail & *io->sq_mask;
+    struct io_uring_sqe *sqe = &io->sqes[ index ];
+    *sqe = {};
+    sqe->opcode    = IORING_OP_READV;
+    sqe->fd        = issue->file;
+    sqe->off       = issue->offset;
+    sqe->addr      = (uint64_t)(uintptr_t)&io->iovecs[ issue->slot ];
+    sqe->len       = 1;
+    sqe->user_data = issue->slot;
+    io->sq_array[ index ] = index;
+    __atomic_store_n( io->sq_tail, tail + 1, __ATOMIC_RELEASE );
+    io->unsubmitted++;
+    return;
+    }
+#endif
+
+/*----------------------------------------------------
+Blocking read.  Loop over short reads so the only short
+result is the end of the file
+----------------------------------------------------*/
+int64_t done = 0;
+while( done < (int64_t)issue->size )
+    {
+    ssize_t read_sz = pread( issue->file, issue->buffer + done, (size_t)( issue->size - done ), (off_t)( issue->offset + done ) );
+    if( read_sz < 0
+     && errno == EINTR )
+        {
+        continue;
+        }
+
+    if( read_sz <= 0 )
+        {
+        done = ( read_sz < 0 ) ? -1 : done;
+        break;
+        }
+
+    done += read_sz;
+    }
+
+IoCompletion *completion = &io->pending[ io->pending_count++ ];
+completion->slot   = issue->slot;
+completion->result = done;
+
+} /* IoIssueRead() */
+
+
+/*******************************************************************
+*
+*   IoOpen()
+*
+*   DESCRIPTION:
+*       Open a file for reading.
+*
+*******************************************************************/
+
+static PlatformFile IoOpen( const char *file_path, const StreamLoaderFile file, IoBackend *io )
+{
+(void)file;
+(void)io;
+int ret = open( file_path, O_RDONLY | O_CLOEXEC );
+
+return( ret < 0 ? INVALID_PLATFORM_FILE : ret );
+
+} /* IoOpen() */
+
+
+/*******************************************************************
+*
+*   IoWait()
+*
+*   DESCRIPTION:
+*       Submit queued reads and collect finished ones, blocking for
+*       at least one (or a wake) if none have finished.
+*
+*******************************************************************/
+
+static uint32_t IoWait( const bool is_blocking, const PlatformFile *files, IoBackend *io, IoCompletion *completions )
+{
+(void)files;
+uint32_t ret = 0;
+for( uint32_t i = 0; i < io->pending_count; i++ )
+    {
+    completions[ ret++ ] = io->pending[ i ];
+    }
+
+io->pending_count = 0;
+
+#if defined( __linux__ )
+if( io->kind != STREAM_LOADER_BACKEND_IO_URING )
+    {
+    return( ret );
+    }
+
+if( !UringEnter( ( is_blocking && ret == 0 ) ? 1 : 0, io ) )
+    {
+    hard_assert_always();
+    return( ret );
+    }
+
+uint32_t head = *io->cq_head;
+uint32_t tail = __atomic_load_n( io->cq_tail, __ATOMIC_ACQUIRE );
+while( head != tail
+    && ret < STREAM_LOADER_MAX_READ_DEPTH )
+    {
+    const struct io_uring_cqe *cqe = &io->cqes[ head & *io->cq_mask ];
+    if( cqe->user_data == WAKE_TOKEN )
+        {
+        /* IoWake() - drain the eventfd and watch it again */
+        uint64_t count;
+        while( read( io->wake, &count, sizeof(count) ) > 0 );
+        UringPushPollWake( io );
+        }
+    else
+        {
+        IoCompletion *completion = &completions[ ret++ ];
+        completion->slot   = (uint32_t)cqe->user_data;
+        completion->result = cqe->res;
+        }
+
+    head++;
+    }
+
+__atomic_store_n( io->cq_head, head, __ATOMIC_RELEASE );
+#endif
+
+return( ret );
+
+} /* IoWait() */
+
+
+/*******************************************************************
+*
+*   IoWake()
+*
+*   DESCRIPTION:
+*       Wake the I/O thread from IoWait().  May be called from any
+*       thread.  The blocking backend never waits, so has nothing
+*       to wake.
+*
+*******************************************************************/
+
+static void IoWake( IoBackend *io )
+{
+#if defined( __linux__ )
+if( io->kind == STREAM_LOADER_BACKEND_IO_URING )
+    {
+    uint64_t one = 1;
+    do_debug_assert( write( io->wake, &one, sizeof(one) ) == sizeof(one) );
+    }
+#endif
+
+} /* IoWake() */
+
+
+#if defined( __linux__ )
+/*******************************************************************
+*
+*   UringEnter()
+*
+*   DESCRIPTION:
+*       Submit the queued entries, and wait for the given number of
+*       completions.
+*
+*******************************************************************/
+
+static bool UringEnter( const uint32_t min_complete, IoBackend *io )
+{
+while( true )
+    {
+    long submitted = syscall( __NR_io_uring_enter, io->ring, io->unsubmitted, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0, NULL, 0 );
+    if( submitted >= 0 )
+        {
+        io->unsubmitted -= (uint32_t)submitted;
+        return( true );
+        }
+
+    if( errno != EINTR )
+        {
+        return( false );
+        }
+    }
+
+} /* UringEnter() */
+
+
+/*******************************************************************
+*
+*   UringPushPollWake()
+*
+*   DESCRIPTION:
+*       Queue a one-shot poll of the wake eventfd, so IoWake() ends
+*       a blocking IoWait().
+*
+*******************************************************************/
+
+static void UringPushPollWake( IoBackend *io )
+{
+uint32_t tail  = *io->sq_tail;
+uint32_t index = tail & *io->sq_mask;
+struct io_uring_sqe *sqe = &io->sqes[ index ];
+*sqe = {};
+sqe->opcode      = IORING_OP_POLL_ADD;
+sqe->fd          = io->wake;
+sqe->poll_events = POLLIN;
+sqe->user_data   = WAKE_TOKEN;
+io->sq_array[ index ] = index;
+__atomic_store_n( io->sq_tail, tail + 1, __ATOMIC_RELEASE );
+io->unsubmitted++;
+
+} /* UringPushPollWake() */
+
+
+/*******************************************************************
+*
+*   UringSetup()
+*
+*   DESCRIPTION:
+*       Create the io_uring and map its rings.  There is one entry
+*       per read in flight, and one for the wake poll.
+*
+*******************************************************************/
+
+static bool UringSetup( const uint32_t read_depth, IoBackend *io )
+{
+struct io_uring_params params = {};
+io->ring = (int)syscall( __NR_io_uring_setup, read_depth + 1, &params );
+if( io->ring < 0 )
+    {
+    io->ring = -1;
+    return( false );
+    }
+
+io->sq_map_sz = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+io->cq_map_sz = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+if( params.features & IORING_FEAT_SINGLE_MMAP )
+    {
+    io->sq_map_sz = max_of_vals( io->sq_map_sz, io->cq_map_sz );
+    io->cq_map_sz = io->sq_map_sz;
+    }
+
+io->sq_map = mmap( NULL, io->sq_map_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring, IORING_OFF_SQ_RING );
+if( io->sq_map == MAP_FAILED )
+    {
+    io->sq_map = NULL;
+    UringTeardown( io );
+    return( false );
+    }
+
+if( params.features & IORING_FEAT_SINGLE_MMAP )
+    {
+    io->cq_map = io->sq_map;
+    }
+else
+    {
+    io->cq_map = mmap( NULL, io->cq_map_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring, IORING_OFF_CQ_RING );
+    if( io->cq_map == MAP_FAILED )
+        {
+        io->cq_map = NULL;
+        UringTeardown( io );
+        return( false );
+        }
+    }
+
+io->sqes_sz = params.sq_entries * sizeof(struct io_uring_sqe);
+io->sqes = (struct io_uring_sqe*)mmap( NULL, io->sqes_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring, IORING_OFF_SQES );
+if( io->sqes == MAP_FAILED )
+    {
+    io->sqes = NULL;
+    UringTeardown( io );
+    return( false );
+    }
+
+uint8_t *sq = (uint8_t*)io->sq_map;
+uint8_t *cq = (uint8_t*)io->cq_map;
+io->sq_head  = (uint32_t*)( sq + params.sq_off.head );
+io->sq_tail  = (uint32_t*)( sq + params.sq_off.tail );
+io->sq_mask  = (uint32_t*)( sq + params.sq_off.ring_mask );
+io->sq_array = (uint32_t*)( sq + params.sq_off.array );
+io->cq_head  = (uint32_t*)( cq + params.cq_off.head );
+io->cq_tail  = (uint32_t*)( cq + params.cq_off.tail );
+io->cq_mask  = (uint32_t*)( cq + params.cq_off.ring_mask );
+io->cqes     = (struct io_uring_cqe*)( cq + params.cq_off.cqes );
+
+io->wake = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+if( io->wake < 0 )
+    {
+    UringTeardown( io );
+    return( false );
+    }
+
+/*----------------------------------------------------
+Arm the wake poll.  A kernel which can't run it is as
+good as no io_uring
+----------------------------------------------------*/
+UringPushPollWake( io );
+if( !UringEnter( 0, io )
+ || io->unsubmitted )
+    {
+    UringTeardown( io );
+    return( false );
+    }
+
+return( true );
+
+} /* UringSetup() */
+
+
+/*******************************************************************
+*
+*   UringTeardown()
+*
+*   DESCRIPTION:
+*       Unmap and close whatever parts of the io_uring exist.
+*
+*******************************************************************/
+
+static void UringTeardown( IoBackend *io )
+{
+if( io->sqes )
+    {
+    munmap( io->sqes, io->sqes_sz );
+    }
+
+if( io->cq_map
+ && io->cq_map != io->sq_map )
+    {
+    munmap( io->cq_map, io->cq_map_sz );
+    }
+
+if( io->sq_map )
+    {
+    munmap( io->sq_map, io->sq_map_sz );
+    }
+
+if( io->wake >= 0 )
+    {
+    close( io->wake );
+    }
+
+if( io->ring >= 0 )
+    {
+    close( io->ring );
+    }
+
+io->sqes   = NULL;
+io->cq_map = NULL;
+io->sq_map = NULL;
+io->wake   = -1;
+io->ring   = -1;
+
+} /* UringTeardown() */
+#endif
+#endif
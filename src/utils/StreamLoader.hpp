@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+
+#include "Utilities.hpp"
+
+
+#define STREAM_LOADER_MAX_FILE_COUNT \
+                                    ( 8 )
+#define STREAM_LOADER_MAX_REQUEST_COUNT \
+                                    ( 1024 )
+#define STREAM_LOADER_MAX_READ_DEPTH \
+                                    ( 32 )
+#define STREAM_LOADER_DEFAULT_READ_DEPTH \
+                                    ( 16 )
+#define STREAM_LOADER_DEFAULT_LANDING_SIZE \
+                                    ( 32 * 1024 * 1024 )
+#define STREAM_LOADER_HISTOGRAM_BUCKET_COUNT \
+                                    ( 40 )
+#define STREAM_LOADER_INVALID_FILE  ( 0xffffffff )
+#define STREAM_LOADER_INVALID_HANDLE \
+                                    ( 0 )
+
+typedef uint32_t StreamLoaderFile;
+typedef uint64_t StreamLoaderHandle;    /* generation in the high bits, slot in the low */
+
+typedef uint32_t StreamLoaderStatus;
+enum
+    {
+    STREAM_LOADER_STATUS_NONE,          /* stale or invalid handle */
+    STREAM_LOADER_STATUS_QUEUED,        /* waiting in the priority queue */
+    STREAM_LOADER_STATUS_READING,       /* read issued to the platform */
+    STREAM_LOADER_STATUS_READY,         /* read finished, waiting for StreamLoader_Poll() */
+    STREAM_LOADER_STATUS_CANCELED,
+    STREAM_LOADER_STATUS_FAILED
+    };
+
+typedef uint32_t StreamLoaderBackend;
+enum
+    {
+    STREAM_LOADER_BACKEND_BLOCKING, /* pread on the I/O thread, one read at a time */
+    STREAM_LOADER_BACKEND_IO_URING,
+    STREAM_LOADER_BACKEND_OVERLAPPED
+    };
+
+/*******************************************************************
+*
+*   StreamLoaderDoneProc
+*
+*   DESCRIPTION:
+*       Called from StreamLoader_Poll() once per request, on the
+*       polling thread.  'data' is the payload as read from the
+*       file, in the loader's pinned landing memory, and is only
+*       valid during the call - decompress or copy it to where it
+*       belongs, e.g. straight into the mapping from the staging
+*       try_upload().  'data' is NULL unless the status is READY.
+*
+*       Return FALSE to leave a READY payload where it is and stop
+*       polling, e.g. when the staging ring has no room this frame.
+*       The request is delivered again by the next poll.
+*
+*******************************************************************/
+
+typedef bool StreamLoaderDoneProc( const StreamLoaderHandle handle, const StreamLoaderStatus status, const void *data, const uint32_t size, void *user );
+
+typedef struct _StreamLoaderRequest
+    {
+    StreamLoaderFile    file;
+    uint64_t            offset;         /* payload's offset in the file */
+    uint32_t            size;           /* payload's size in the file */
+    int32_t             priority;       /* higher is read first, ties in submit order */
+    StreamLoaderDoneProc
+                       *done;
+    void               *user;
+    } StreamLoaderRequest;
+
+/*******************************************************************
+*
+*   StreamLoaderHistogram
+*
+*   DESCRIPTION:
+*       Power-of-two histogram.  Bucket i counts the samples in
+*       [2^(i-1), 2^i), and bucket 0 counts the zeros.
+*
+*******************************************************************/
+
+typedef struct _StreamLoaderHistogram
+    {
+    uint64_t            counts[ STREAM_LOADER_HISTOGRAM_BUCKET_COUNT ];
+    uint64_t            sample_count;
+    uint64_t            sum;
+    uint64_t            max;
+    } StreamLoaderHistogram;
+
+typedef struct _StreamLoaderStats
+    {
+    StreamLoaderBackend backend;
+    bool                is_landing_pinned;
+    uint64_t            submitted_count;
+    uint64_t            delivered_count;    /* READY payloads consumed by a poll */
+    uint64_t            canceled_count;
+    uint64_t            failed_count;
+    uint64_t            bytes_read;
+    uint64_t            busy_ns;            /* time with at least one read in flight */
+    StreamLoaderHistogram
+                        queue_us;           /* submit until the read is issued */
+    StreamLoaderHistogram
+                        read_us;            /* read issued until it finished */
+    StreamLoaderHistogram
+                        latency_us;         /* submit until delivered */
+    StreamLoaderHistogram
+                        throughput_kbps;    /* per read, KiB per second */
+    } StreamLoaderStats;
+
+struct _StreamLoader;
+typedef struct _StreamLoader StreamLoader;
+
+bool               StreamLoader_Cancel( const StreamLoaderHandle handle, StreamLoader *loader );
+void               StreamLoader_CloseFile( const StreamLoaderFile file, StreamLoader *loader );
+StreamLoader *     StreamLoader_Create( const uint32_t read_depth, const uint32_t landing_size );
+void               StreamLoader_Destroy( StreamLoader *loader );
+StreamLoaderStatus StreamLoader_GetStatus( const StreamLoaderHandle handle, StreamLoader *loader );
+void               StreamLoader_GetStats( StreamLoader *loader, StreamLoaderStats *out );
+uint64_t           StreamLoader_HistogramPercentile( const StreamLoaderHistogram *histogram, const float fraction );
+StreamLoaderFile   StreamLoader_OpenFile( const char *file_path, StreamLoader *loader );
+uint32_t           StreamLoader_Poll( const uint32_t byte_budget, StreamLoader *loader );
+bool               StreamLoader_Reprioritize( const StreamLoaderHandle handle, const int32_t priority, StreamLoader *loader );
+StreamLoaderHandle StreamLoader_Submit( const StreamLoaderRequest *request, StreamLoader *loader );
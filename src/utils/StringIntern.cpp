@@ -0,0 +1,366 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "pthread.h"
+
+#include "FlatHashMap.hpp"
+#include "StringIntern.hpp"
+#include "Utilities.hpp"
+
+
+#define MAP_START_CAPACITY          ( 256 )
+#define DEDICATED_CHUNK_SIZE        ( STRING_INTERN_CHUNK_SIZE / 4 )    /* strings this big get a chunk of their own */
+
+typedef struct _StringInternChunk
+    {
+    struct _StringInternChunk
+                       *next;
+    uint32_t            capacity;
+    uint32_t            used;
+    } StringInternChunk;
+
+typedef struct _StringInternEntry
+    {
+    const char         *str;            /* null terminated, in a chunk */
+    uint32_t            length;
+    uint64_t            hash;
+    } StringInternEntry;
+
+typedef struct _StringInternKey
+    {
+    const char         *str;
+    uint32_t            length;
+    } StringInternKey;
+
+static StringInternChunk * CreateChunk( const uint32_t capacity );
+static bool                KeyEqual( const void *a, const void *b );
+static const char *        StoreString( const char *str, const uint32_t length );
+
+static pthread_mutex_t          s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool                     s_is_init;
+static FlatHashMap              s_map;      /* StringInternKey to StringId */
+static StringInternChunk       *s_chunks;   /* strings are stored in the first */
+static StringInternStats        s_stats;
+static StringInternEntry       *s_pages[ STRING_INTERN_MAX_PAGE_CNT ];
+
+
+/*******************************************************************
+*
+*   fold_hash()
+*
+*   DESCRIPTION:
+*       Fold a string's 64-bit hash to the map's 32-bit hash.
+*
+*******************************************************************/
+
+static inline uint32_t fold_hash( const uint64_t hash )
+{
+return( (uint32_t)( hash ^ ( hash >> 32 ) ) );
+
+} /* fold_hash() */
+
+
+/*******************************************************************
+*
+*   get_entry()
+*
+*   DESCRIPTION:
+*       Get the entry of a valid handle.  Pages never move, so this
+*       is safe without the lock.
+*
+*******************************************************************/
+
+static inline StringInternEntry * get_entry( const StringId id )
+{
+uint32_t index = id - 1;
+return( &s_pages[ index / STRING_INTERN_PAGE_ENTRY_CNT ][ index % STRING_INTERN_PAGE_ENTRY_CNT ] );
+
+} /* get_entry() */
+
+
+/*******************************************************************
+*
+*   StringIntern_Destroy()
+*
+*   DESCRIPTION:
+*       Free the pool.  Every handle and string it gave out becomes
+*       invalid.
+*
+*******************************************************************/
+
+void StringIntern_Destroy()
+{
+do_debug_assert( !pthread_mutex_lock( &s_mutex ) );
+
+if( s_is_init )
+    {
+    FlatHashMap_Destroy( &s_map );
+    }
+
+while( s_chunks )
+    {
+    StringInternChunk *next = s_chunks->next;
+    free( s_chunks );
+    s_chunks = next;
+    }
+
+for( uint32_t i = 0; i < cnt_of_array( s_pages ); i++ )
+    {
+    free( s_pages[ i ] );
+    s_pages[ i ] = NULL;
+    }
+
+s_stats   = {};
+s_is_init = false;
+
+do_debug_assert( !pthread_mutex_unlock( &s_mutex ) );
+
+} /* StringIntern_Destroy() */
+
+
+/*******************************************************************
+*
+*   StringIntern_Find()
+*
+*   DESCRIPTION:
+*       Find the handle of the given string, without interning it.
+*       Returns STRING_ID_INVALID if it was never interned.
+*
+*******************************************************************/
+
+StringId StringIntern_Find( const char *str, const uint32_t length )
+{
+StringInternKey key = { str, length };
+uint32_t hash = fold_hash( Utilities_HashBytes64( str, length, 0 ) );
+
+do_debug_assert( !pthread_mutex_lock( &s_mutex ) );
+
+StringId ret = STRING_ID_INVALID;
+if( s_is_init )
+    {
+    StringId *found = (StringId*)FlatHashMap_At( hash, &key, &s_map );
+    if( found )
+        {
+        ret = *found;
+        }
+    }
+
+do_debug_assert( !pthread_mutex_unlock( &s_mutex ) );
+
+return( ret );
+
+} /* StringIntern_Find() */
+
+
+/*******************************************************************
+*
+*   StringIntern_GetHash()
+*
+*   DESCRIPTION:
+*       Get the 64-bit hash of a handle's string.
+*
+*******************************************************************/
+
+uint64_t StringIntern_GetHash( const StringId id )
+{
+debug_assert( id != STRING_ID_INVALID );
+
+return( get_entry( id )->hash );
+
+} /* StringIntern_GetHash() */
+
+
+/*******************************************************************
+*
+*   StringIntern_GetStats()
+*
+*   DESCRIPTION:
+*       Get the pool's size.
+*
+*******************************************************************/
+
+void StringIntern_GetStats( StringInternStats *out )
+{
+do_debug_assert( !pthread_mutex_lock( &s_mutex ) );
+*out = s_stats;
+do_debug_assert( !pthread_mutex_unlock( &s_mutex ) );
+
+} /* StringIntern_GetStats() */
+
+
+/*******************************************************************
+*
+*   StringIntern_GetString()
+*
+*   DESCRIPTION:
+*       Get the null terminated string of a handle, and optionally
+*       its length.
+*
+*******************************************************************/
+
+const char * StringIntern_GetString( const StringId id, uint32_t *out_length )
+{
+debug_assert( id != STRING_ID_INVALID );
+const StringInternEntry *entry = get_entry( id );
+if( out_length )
+    {
+    *out_length = entry->length;
+    }
+
+return( entry->str );
+
+} /* StringIntern_GetString() */
+
+
+/*******************************************************************
+*
+*   StringIntern_Intern()
+*
+*   DESCRIPTION:
+*       Get the handle of the given string, adding a copy of it to
+*       the pool if it is new.  The string need not be null
+*       terminated.
+*
+*******************************************************************/
+
+StringId StringIntern_Intern( const char *str, const uint32_t length )
+{
+StringInternKey key = { str, length };
+uint64_t full_hash = Utilities_HashBytes64( str, length, 0 );
+uint32_t hash      = fold_hash( full_hash );
+
+do_debug_assert( !pthread_mutex_lock( &s_mutex ) );
+
+if( !s_is_init )
+    {
+    FlatHashMap_Init( MAP_START_CAPACITY, sizeof(StringInternKey), sizeof(StringId), KeyEqual, &s_map );
+    s_is_init = true;
+    }
+
+StringId *found = (StringId*)FlatHashMap_At( hash, &key, &s_map );
+if( found )
+    {
+    StringId ret = *found;
+    do_debug_assert( !pthread_mutex_unlock( &s_mutex ) );
+    return( ret );
+    }
+
+/* add an entry, in a new page if the last is full */
+uint32_t index = s_stats.string_count;
+uint32_t page  = index / STRING_INTERN_PAGE_ENTRY_CNT;
+hard_assert( page < STRING_INTERN_MAX_PAGE_CNT );
+if( !s_pages[ page ] )
+    {
+    s_pages[ page ] = (StringInternEntry*)malloc( STRING_INTERN_PAGE_ENTRY_CNT * sizeof(StringInternEntry) );
+    hard_assert( s_pages[ page ] );
+    }
+
+StringInternEntry *entry = &s_pages[ page ][ index % STRING_INTERN_PAGE_ENTRY_CNT ];
+entry->str    = StoreString( str, length );
+entry->length = length;
+entry->hash   = full_hash;
+
+StringId ret = (StringId)( index + 1 );
+key.str = entry->str;
+FlatHashMap_Insert( hash, &key, &ret, &s_map );
+
+s_stats.string_count++;
+s_stats.string_bytes += length + 1;
+
+do_debug_assert( !pthread_mutex_unlock( &s_mutex ) );
+
+return( ret );
+
+} /* StringIntern_Intern() */
+
+
+/*******************************************************************
+*
+*   CreateChunk()
+*
+*   DESCRIPTION:
+*       Allocate an empty chunk of string storage, with its bytes
+*       right after the header.
+*
+*******************************************************************/
+
+static StringInternChunk * CreateChunk( const uint32_t capacity )
+{
+StringInternChunk *chunk = (StringInternChunk*)malloc( sizeof(StringInternChunk) + capacity );
+hard_assert( chunk );
+
+chunk->next     = NULL;
+chunk->capacity = capacity;
+chunk->used     = 0;
+s_stats.chunk_count++;
+
+return( chunk );
+
+} /* CreateChunk() */
+
+
+/*******************************************************************
+*
+*   KeyEqual()
+*
+*   DESCRIPTION:
+*       Compare two map keys.
+*
+*******************************************************************/
+
+static bool KeyEqual( const void *a, const void *b )
+{
+const StringInternKey *key_a = (const StringInternKey*)a;
+const StringInternKey *key_b = (const StringInternKey*)b;
+
+return( key_a->length == key_b->length
+     && memcmp( key_a->str, key_b->str, key_a->length ) == 0 );
+
+} /* KeyEqual() */
+
+
+/*******************************************************************
+*
+*   StoreString()
+*
+*   DESCRIPTION:
+*       Copy a string into chunk storage, null terminated.  Stored
+*       strings never move.
+*
+*******************************************************************/
+
+static const char * StoreString( const char *str, const uint32_t length )
+{
+uint32_t sz = length + 1;
+StringInternChunk *chunk = s_chunks;
+if( sz > DEDICATED_CHUNK_SIZE )
+    {
+    /* link it in behind the current chunk, so that one keeps filling */
+    chunk = CreateChunk( sz );
+    if( s_chunks )
+        {
+        chunk->next    = s_chunks->next;
+        s_chunks->next = chunk;
+        }
+    else
+        {
+        s_chunks = chunk;
+        }
+    }
+else if( !chunk
+      || chunk->capacity - chunk->used < sz )
+    {
+    chunk = CreateChunk( STRING_INTERN_CHUNK_SIZE );
+    chunk->next = s_chunks;
+    s_chunks    = chunk;
+    }
+
+char *ret = (char*)( chunk + 1 ) + chunk->used;
+memcpy( ret, str, length );
+ret[ length ] = 0;
+chunk->used += sz;
+
+return( ret );
+
+} /* StoreString() */
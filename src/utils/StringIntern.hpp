@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+#include "Utilities.hpp"
+
+
+#define STRING_ID_INVALID           ( 0 )
+#define STRING_INTERN_PAGE_ENTRY_CNT \
+                                    ( 1024 )
+#define STRING_INTERN_MAX_PAGE_CNT  ( 1024 )        /* so at most a million distinct strings */
+#define STRING_INTERN_CHUNK_SIZE    ( 64 * 1024 )   /* string storage is allocated in chunks of this size */
+
+/*******************************************************************
+*
+*   StringId
+*
+*   DESCRIPTION:
+*       Handle to a string in the global intern pool.  Interning the
+*       same characters always gives the same handle, and different
+*       characters never do, so interned strings compare equal
+*       exactly when their handles do.  Handles stay valid until
+*       StringIntern_Destroy(), and zero is never a valid handle.
+*
+*       The pool is shared by every thread.  Interning and finding
+*       take a lock; getting a handle's string does not.
+*
+*******************************************************************/
+
+typedef uint32_t StringId;
+
+typedef struct _StringInternStats
+    {
+    uint32_t            string_count;
+    uint32_t            chunk_count;
+    uint64_t            string_bytes;   /* including terminators */
+    } StringInternStats;
+
+
+void         StringIntern_Destroy();
+StringId     StringIntern_Find( const char *str, const uint32_t length );
+uint64_t     StringIntern_GetHash( const StringId id );
+void         StringIntern_GetStats( StringInternStats *out );
+const char * StringIntern_GetString( const StringId id, uint32_t *out_length );
+StringId     StringIntern_Intern( const char *str, const uint32_t length );
+
+
+/*******************************************************************
+*
+*   StringIntern_Find2()
+*
+*   DESCRIPTION:
+*       Find the handle of a null terminated string, if interned.
+*
+*******************************************************************/
+
+#define StringIntern_Find2( _str ) \
+    StringIntern_Find( _str, (uint32_t)strlen( _str ) )
+
+
+/*******************************************************************
+*
+*   StringIntern_Intern2()
+*
+*   DESCRIPTION:
+*       Intern a null terminated string.
+*
+*******************************************************************/
+
+#define StringIntern_Intern2( _str ) \
+    StringIntern_Intern( _str, (uint32_t)strlen( _str ) )
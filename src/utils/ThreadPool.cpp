@@ -0,0 +1,446 @@
+#define HAVE_STRUCT_TIMESPEC
+#include "pthread.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+
+#include "ThreadPool.hpp"
+#include "Utilities.hpp"
+
+
+#define WORKER_QUEUE_CAPACITY       ( 1024 )
+#define WORKER_QUEUE_MASK           ( WORKER_QUEUE_CAPACITY - 1 )
+#define NOT_A_WORKER                ( -1 )
+
+compiler_assert( ( WORKER_QUEUE_CAPACITY & WORKER_QUEUE_MASK ) == 0, thread_pool_cpp );
+
+typedef struct _ThreadPoolJob
+    {
+    ThreadPoolJobProc  *proc;
+    void               *user;
+    ThreadPoolCounter  *counter;
+    } ThreadPoolJob;
+
+/*******************************************************************
+*
+*   WorkerQueue
+*
+*   DESCRIPTION:
+*       A worker's job deque.  The owning worker pushes and pops at
+*       the tail (newest first, for cache warmth), and idle workers
+*       steal from the head (oldest first).
+*
+*******************************************************************/
+
+typedef struct _WorkerQueue
+    {
+    pthread_mutex_t     mutex;
+    ThreadPoolJob       jobs[ WORKER_QUEUE_CAPACITY ];
+    uint32_t            head;
+    uint32_t            tail;
+    } WorkerQueue;
+
+typedef struct _WorkerStart
+    {
+    ThreadPool         *pool;
+    int32_t             index;
+    } WorkerStart;
+
+struct _ThreadPool
+    {
+    pthread_t           threads[ THREAD_POOL_MAX_WORKER_COUNT ];
+    WorkerStart         starts[ THREAD_POOL_MAX_WORKER_COUNT ];
+    WorkerQueue         queues[ THREAD_POOL_MAX_WORKER_COUNT ];
+    uint32_t            worker_count;
+    std::atomic<uint32_t>
+                        queued_count;
+    std::atomic<uint32_t>
+                        next_external;
+    pthread_mutex_t     sleep_mutex;
+    pthread_cond_t      sleep_cond;
+    bool                is_shutting_down;
+    };
+
+static thread_local ThreadPool *s_worker_pool  = NULL;
+static thread_local int32_t     s_worker_index = NOT_A_WORKER;
+
+
+static bool   PopJob( WorkerQueue *queue, const bool from_tail, ThreadPoolJob *out );
+static bool   PushJob( const ThreadPoolJob *job, WorkerQueue *queue );
+static void   RunJob( const ThreadPoolJob *job );
+static void * WorkerMain( void *arg );
+
+
+/*******************************************************************
+*
+*   ThreadPool_Create()
+*
+*   DESCRIPTION:
+*       Create a work-stealing thread pool with the given number of
+*       worker threads.  THREAD_POOL_DEFAULT_WORKER_COUNT uses one
+*       worker per hardware thread, less one for the caller.  A pool
+*       with zero workers runs every job on the submitting thread.
+*
+*******************************************************************/
+
+ThreadPool * ThreadPool_Create( const uint32_t worker_count )
+{
+uint32_t count = worker_count;
+if( count == THREAD_POOL_DEFAULT_WORKER_COUNT )
+    {
+    uint32_t hardware_count = (uint32_t)std::thread::hardware_concurrency();
+    count = hardware_count > 1 ? hardware_count - 1 : 0;
+    }
+
+count = min_of_vals( count, THREAD_POOL_MAX_WORKER_COUNT );
+
+ThreadPool *ret = (ThreadPool*)calloc( 1, sizeof(ThreadPool) );
+if( !ret )
+    {
+    debug_assert_always();
+    return( NULL );
+    }
+
+ret->queued_count.store( 0 );
+ret->next_external.store( 0 );
+do_debug_assert( !pthread_mutex_init( &ret->sleep_mutex, NULL ) );
+do_debug_assert( !pthread_cond_init( &ret->sleep_cond, NULL ) );
+for( uint32_t i = 0; i < cnt_of_array( ret->queues ); i++ )
+    {
+    do_debug_assert( !pthread_mutex_init( &ret->queues[ i ].mutex, NULL ) );
+    }
+
+for( uint32_t i = 0; i < count; i++ )
+    {
+    ret->starts[ i ].pool  = ret;
+    ret->starts[ i ].index = (int32_t)i;
+    if( pthread_create( &ret->threads[ i ], NULL, WorkerMain, &ret->starts[ i ] ) )
+        {
+        debug_assert_always();
+        break;
+        }
+
+    ret->worker_count++;
+    }
+
+return( ret );
+
+} /* ThreadPool_Create() */
+
+
+/*******************************************************************
+*
+*   ThreadPool_Destroy()
+*
+*   DESCRIPTION:
+*       Stop and join the worker threads, and free the pool.  Any
+*       jobs still queued are abandoned.
+*
+*******************************************************************/
+
+void ThreadPool_Destroy( ThreadPool *pool )
+{
+if( !pool )
+    {
+    return;
+    }
+
+do_debug_assert( !pthread_mutex_lock( &pool->sleep_mutex ) );
+pool->is_shutting_down = true;
+do_debug_assert( !pthread_cond_broadcast( &pool->sleep_cond ) );
+do_debug_assert( !pthread_mutex_unlock( &pool->sleep_mutex ) );
+
+for( uint32_t i = 0; i < pool->worker_count; i++ )
+    {
+    pthread_join( pool->threads[ i ], NULL );
+    }
+
+for( uint32_t i = 0; i < cnt_of_array( pool->queues ); i++ )
+    {
+    pthread_mutex_destroy( &pool->queues[ i ].mutex );
+    }
+
+pthread_cond_destroy( &pool->sleep_cond );
+pthread_mutex_destroy( &pool->sleep_mutex );
+
+free( pool );
+
+} /* ThreadPool_Destroy() */
+
+
+/*******************************************************************
+*
+*   ThreadPool_GetWorkerCount()
+*
+*   DESCRIPTION:
+*       Get the number of worker threads in the pool.
+*
+*******************************************************************/
+
+uint32_t ThreadPool_GetWorkerCount( const ThreadPool *pool )
+{
+return( pool ? pool->worker_count : 0 );
+
+} /* ThreadPool_GetWorkerCount() */
+
+
+/*******************************************************************
+*
+*   ThreadPool_InitCounter()
+*
+*   DESCRIPTION:
+*       Initialize a job completion counter as having no pending
+*       jobs.
+*
+*******************************************************************/
+
+void ThreadPool_InitCounter( ThreadPoolCounter *counter )
+{
+counter->pending.store( 0 );
+
+} /* ThreadPool_InitCounter() */
+
+
+/*******************************************************************
+*
+*   ThreadPool_Submit()
+*
+*   DESCRIPTION:
+*       Submit a job to the pool.  The optional counter is
+*       incremented now, and decremented once the job has run.
+*       When submitted from a worker the job goes on that worker's
+*       own queue, otherwise the workers are filled round-robin.
+*       If there are no workers, or the queue is full, the job is
+*       run immediately on the calling thread.
+*
+*******************************************************************/
+
+void ThreadPool_Submit( ThreadPoolJobProc *proc, void *user, ThreadPoolCounter *counter, ThreadPool *pool )
+{
+ThreadPoolJob job = {};
+job.proc    = proc;
+job.user    = user;
+job.counter = counter;
+
+if( counter )
+    {
+    counter->pending.fetch_add( 1 );
+    }
+
+if( !pool
+ || pool->worker_count == 0 )
+    {
+    RunJob( &job );
+    return;
+    }
+
+uint32_t queue_index = ( s_worker_pool == pool ) ? (uint32_t)s_worker_index : pool->next_external.fetch_add( 1 ) % pool->worker_count;
+if( !PushJob( &job, &pool->queues[ queue_index ] ) )
+    {
+    /* queue is full, so do it ourselves */
+    RunJob( &job );
+    return;
+    }
+
+pool->queued_count.fetch_add( 1 );
+
+do_debug_assert( !pthread_mutex_lock( &pool->sleep_mutex ) );
+do_debug_assert( !pthread_cond_signal( &pool->sleep_cond ) );
+do_debug_assert( !pthread_mutex_unlock( &pool->sleep_mutex ) );
+
+} /* ThreadPool_Submit() */
+
+
+/*******************************************************************
+*
+*   ThreadPool_TryRunOne()
+*
+*   DESCRIPTION:
+*       Run one queued job on the calling thread, if there is one.
+*       Workers take from their own queue first, then steal from
+*       the others.
+*       Returns TRUE if a job was run.
+*
+*******************************************************************/
+
+bool ThreadPool_TryRunOne( ThreadPool *pool )
+{
+if( !pool
+ || pool->queued_count.load() == 0 )
+    {
+    return( false );
+    }
+
+ThreadPoolJob job;
+bool is_own_pool = ( s_worker_pool == pool );
+uint32_t first = is_own_pool ? (uint32_t)s_worker_index : 0;
+
+for( uint32_t i = 0; i < pool->worker_count; i++ )
+    {
+    uint32_t queue_index = ( first + i ) % pool->worker_count;
+    bool from_tail = ( is_own_pool && i == 0 );
+    if( PopJob( &pool->queues[ queue_index ], from_tail, &job ) )
+        {
+        pool->queued_count.fetch_sub( 1 );
+        RunJob( &job );
+        return( true );
+        }
+    }
+
+return( false );
+
+} /* ThreadPool_TryRunOne() */
+
+
+/*******************************************************************
+*
+*   ThreadPool_WaitForCounter()
+*
+*   DESCRIPTION:
+*       Block until every job tracked by the counter has run.  The
+*       calling thread helps run queued jobs while it waits.
+*
+*******************************************************************/
+
+void ThreadPool_WaitForCounter( ThreadPoolCounter *counter, ThreadPool *pool )
+{
+while( counter->pending.load() > 0 )
+    {
+    if( !ThreadPool_TryRunOne( pool ) )
+        {
+        std::this_thread::yield();
+        }
+    }
+
+} /* ThreadPool_WaitForCounter() */
+
+
+/*******************************************************************
+*
+*   PopJob()
+*
+*   DESCRIPTION:
+*       Pop a job from the tail (owner) or head (thief) of a queue.
+*
+*******************************************************************/
+
+static bool PopJob( WorkerQueue *queue, const bool from_tail, ThreadPoolJob *out )
+{
+bool ret = false;
+do_debug_assert( !pthread_mutex_lock( &queue->mutex ) );
+if( queue->head != queue->tail )
+    {
+    if( from_tail )
+        {
+        queue->tail--;
+        *out = queue->jobs[ queue->tail & WORKER_QUEUE_MASK ];
+        }
+    else
+        {
+        *out = queue->jobs[ queue->head & WORKER_QUEUE_MASK ];
+        queue->head++;
+        }
+
+    ret = true;
+    }
+
+do_debug_assert( !pthread_mutex_unlock( &queue->mutex ) );
+
+return( ret );
+
+} /* PopJob() */
+
+
+/*******************************************************************
+*
+*   PushJob()
+*
+*   DESCRIPTION:
+*       Push a job onto the tail of the given queue.
+*       Returns FALSE if the queue is full.
+*
+*******************************************************************/
+
+static bool PushJob( const ThreadPoolJob *job, WorkerQueue *queue )
+{
+bool ret = false;
+do_debug_assert( !pthread_mutex_lock( &queue->mutex ) );
+if( queue->tail - queue->head < WORKER_QUEUE_CAPACITY )
+    {
+    queue->jobs[ queue->tail & WORKER_QUEUE_MASK ] = *job;
+    queue->tail++;
+    ret = true;
+    }
+
+do_debug_assert( !pthread_mutex_unlock( &queue->mutex ) );
+
+return( ret );
+
+} /* PushJob() */
+
+
+/*******************************************************************
+*
+*   RunJob()
+*
+*   DESCRIPTION:
+*       Run the job and signal its counter.
+*
+*******************************************************************/
+
+static void RunJob( const ThreadPoolJob *job )
+{
+job->proc( job->user );
+if( job->counter )
+    {
+    job->counter->pending.fetch_sub( 1 );
+    }
+
+} /* RunJob() */
+
+
+/*******************************************************************
+*
+*   WorkerMain()
+*
+*   DESCRIPTION:
+*       Worker thread entry point.  Run jobs until there are none,
+*       then sleep until more are submitted.
+*
+*******************************************************************/
+
+static void * WorkerMain( void *arg )
+{
+WorkerStart *start = (WorkerStart*)arg;
+ThreadPool  *pool  = start->pool;
+s_worker_pool  = pool;
+s_worker_index = start->index;
+
+while( true )
+    {
+    if( ThreadPool_TryRunOne( pool ) )
+        {
+        continue;
+        }
+
+    do_debug_assert( !pthread_mutex_lock( &pool->sleep_mutex ) );
+    while( pool->queued_count.load() == 0
+        && !pool->is_shutting_down )
+        {
+        pthread_cond_wait( &pool->sleep_cond, &pool->sleep_mutex );
+        }
+
+    bool is_shutting_down = pool->is_shutting_down;
+    do_debug_assert( !pthread_mutex_unlock( &pool->sleep_mutex ) );
+
+    if( is_shutting_down )
+        {
+        break;
+        }
+    }
+
+return( NULL );
+
+} /* WorkerMain() */
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+
+#define THREAD_POOL_MAX_WORKER_COUNT \
+                                    ( 32 )
+#define THREAD_POOL_DEFAULT_WORKER_COUNT \
+                                    ( 0xffffffff )
+
+typedef void ThreadPoolJobProc( void *user );
+
+typedef struct _ThreadPoolCounter
+    {
+    std::atomic<uint32_t>
+                        pending;
+    } ThreadPoolCounter;
+
+struct _ThreadPool;
+typedef struct _ThreadPool ThreadPool;
+
+ThreadPool * ThreadPool_Create( const uint32_t worker_count );
+void         ThreadPool_Destroy( ThreadPool *pool );
+uint32_t     ThreadPool_GetWorkerCount( const ThreadPool *pool );
+void         ThreadPool_InitCounter( ThreadPoolCounter *counter );
+void         ThreadPool_Submit( ThreadPoolJobProc *proc, void *user, ThreadPoolCounter *counter, ThreadPool *pool );
+bool         ThreadPool_TryRunOne( ThreadPool *pool );
+void         ThreadPool_WaitForCounter( ThreadPoolCounter *counter, ThreadPool *pool );
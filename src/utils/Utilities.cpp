@@ -1,8 +1,354 @@
-#include <cstdio>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined( UTILITIES_HASH_SCALAR )
+#if defined( __AVX2__ )
+#define UTILITIES_HASH_USE_AVX2
+#include <immintrin.h>
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define UTILITIES_HASH_USE_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
+#if defined( _MSC_VER ) && defined( _M_X64 )
+#include <intrin.h>
+#endif
+
+#if defined( _MSC_VER )
+#include <malloc.h>
+#endif
 
 #include "Utilities.hpp"
 
 
+#define HASH_STRIPE_SIZE            ( 64 )      /* bytes consumed by each accumulate step */
+#define HASH_STRIPES_PER_BLOCK      ( 16 )      /* stripes between scrambles */
+#define HASH_LONG_KEY_SIZE          ( 256 )     /* longer keys are hashed in stripes */
+#define HASH_SCRAMBLE_PRIME         ( 0x9e3779b1 )
+
+#define RADIX_SORT_MIN_COUNT        ( 64 )      /* shorter arrays are shell sorted */
+
+/* keys xor'd into the data - each stripe of a block starts one word further along */
+static const uint64_t HASH_SECRET[ HASH_STRIPES_PER_BLOCK + 8 ] =
+    {
+    0x2cb0f69f4abea221, 0x9417034723148989, 0xdd555950609dfe03, 0xdbafb150deb12800,
+    0x7e789b2e6c442cb6, 0xf41e5636c7e4f8c4, 0x0959d150f8fba7e4, 0xa97316f13cdb9eea,
+    0x74cd8258f9520068, 0x55c74a62e116868b, 0xd2f4c799a2023cbd, 0xdf98cb79a37b51b9,
+    0x396f5885524f3905, 0xaf1d56386ca3b276, 0xa9ffbe6b5104e85a, 0x6bd0c51b9fd533b3,
+    0x980ce91c50ab4b56, 0x28ac395780fe62c5, 0x768912e3a6bcedc7, 0x50b3e8c9332c7c88,
+    0xce3bbfe520bd47da, 0xcba6c8e8e0bb7c4f, 0xbf194db8434a346d, 0x7d8f2a7b60416d7f
+    };
+
+/* multiply-mix constants of the short key hash */
+static const uint64_t HASH_MIX[ 4 ] =
+    {
+    0x2d358dccaa6c78a5, 0x8bb84b93962eacc9, 0x4b33a62ed433d4a3, 0x4d5a2da51de1aa47
+    };
+
+static void     HashAccumulate( const uint8_t *data, const size_t stripe_count, uint64_t *acc );
+static uint64_t HashShort( const uint8_t *data, const size_t len, uint64_t seed );
+
+
+/*******************************************************************
+*
+*   hash_multiply()
+*
+*   DESCRIPTION:
+*       Full 64x64 bit multiply, returning the low half in a and the
+*       high half in b.
+*
+*******************************************************************/
+
+static inline void hash_multiply( uint64_t *a, uint64_t *b )
+{
+#if defined( __SIZEOF_INT128__ )
+__uint128_t product = (__uint128_t)*a * *b;
+*a = (uint64_t)product;
+*b = (uint64_t)( product >> 64 );
+#elif defined( _MSC_VER ) && defined( _M_X64 )
+*a = _umul128( *a, *b, b );
+#else
+uint64_t ha = *a >> 32;
+uint64_t hb = *b >> 32;
+uint64_t la = (uint32_t)*a;
+uint64_t lb = (uint32_t)*b;
+uint64_t rh = ha * hb;
+uint64_t rm0 = ha * lb;
+uint64_t rm1 = hb * la;
+uint64_t rl = la * lb;
+uint64_t t = rl + ( rm0 << 32 );
+uint64_t c = t < rl;
+uint64_t lo = t + ( rm1 << 32 );
+c += lo < t;
+*a = lo;
+*b = rh + ( rm0 >> 32 ) + ( rm1 >> 32 ) + c;
+#endif
+
+} /* hash_multiply() */
+
+
+/*******************************************************************
+*
+*   hash_mix()
+*
+*   DESCRIPTION:
+*       Fold the full product of two words into one word.
+*
+*******************************************************************/
+
+static inline uint64_t hash_mix( uint64_t a, uint64_t b )
+{
+hash_multiply( &a, &b );
+
+return( a ^ b );
+
+} /* hash_mix() */
+
+
+/*******************************************************************
+*
+*   hash_read32()
+*
+*   DESCRIPTION:
+*       Read an unaligned little endian 32-bit word.
+*
+*******************************************************************/
+
+static inline uint64_t hash_read32( const uint8_t *data )
+{
+uint32_t ret;
+memcpy( &ret, data, sizeof(ret) );
+
+return( ret );
+
+} /* hash_read32() */
+
+
+/*******************************************************************
+*
+*   hash_read64()
+*
+*   DESCRIPTION:
+*       Read an unaligned little endian 64-bit word.
+*
+*******************************************************************/
+
+static inline uint64_t hash_read64( const uint8_t *data )
+{
+uint64_t ret;
+memcpy( &ret, data, sizeof(ret) );
+
+return( ret );
+
+} /* hash_read64() */
+
+
+/*******************************************************************
+*
+*   Utilities_AlignedAlloc()
+*
+*   DESCRIPTION:
+*       Allocate memory at the given power of two alignment.  Free
+*       it with Utilities_AlignedFree(), never free().
+*
+*******************************************************************/
+
+void * Utilities_AlignedAlloc( const size_t size, const size_t alignment )
+{
+debug_assert( alignment && !( alignment & ( alignment - 1 ) ) );
+#if defined( _MSC_VER )
+return( _aligned_malloc( size, alignment ) );
+#else
+/* aligned_alloc wants a whole number of alignments, and at least a pointer's */
+size_t align = max_of_vals( alignment, sizeof(void*) );
+return( aligned_alloc( align, (size_t)align_size_round_up( max_of_vals( size, (size_t)1 ), align ) ) );
+#endif
+
+} /* Utilities_AlignedAlloc() */
+
+
+/*******************************************************************
+*
+*   Utilities_AlignedFree()
+*
+*   DESCRIPTION:
+*       Free memory from Utilities_AlignedAlloc() or
+*       Utilities_AlignedRealloc().
+*
+*******************************************************************/
+
+void Utilities_AlignedFree( void *ptr )
+{
+#if defined( _MSC_VER )
+_aligned_free( ptr );
+#else
+free( ptr );
+#endif
+
+} /* Utilities_AlignedFree() */
+
+
+/*******************************************************************
+*
+*   Utilities_AlignedRealloc()
+*
+*   DESCRIPTION:
+*       Resize aligned memory, keeping the first min( old_size,
+*       new_size ) bytes.  NULL behaves as an allocation.  On
+*       failure returns NULL and the old memory is left as it was.
+*
+*******************************************************************/
+
+void * Utilities_AlignedRealloc( void *ptr, const size_t old_size, const size_t new_size, const size_t alignment )
+{
+#if defined( _MSC_VER )
+(void)old_size;
+return( _aligned_realloc( ptr, new_size, alignment ) );
+#else
+void *ret = Utilities_AlignedAlloc( new_size, alignment );
+if( ret && ptr )
+    {
+    memcpy( ret, ptr, min_of_vals( old_size, new_size ) );
+    free( ptr );
+    }
+
+return( ret );
+#endif
+
+} /* Utilities_AlignedRealloc() */
+
+
+/*******************************************************************
+*
+*   Utilities_GetTimeNanoseconds()
+*
+*   DESCRIPTION:
+*       Read a monotonic clock, in nanoseconds.  Only the difference
+*       between two readings is meaningful.
+*
+*******************************************************************/
+
+uint64_t Utilities_GetTimeNanoseconds()
+{
+return( (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+
+} /* Utilities_GetTimeNanoseconds() */
+
+
+/*******************************************************************
+*
+*   Utilities_HashBytes64()
+*
+*   DESCRIPTION:
+*       Compute a 64-bit hash of the given bytes.  Short keys are
+*       hashed with a few wide multiplies.  Long keys are first
+*       folded down in 64 byte stripes, eight independent lanes at
+*       a time, so the work vectorizes; the vector and scalar paths
+*       give the same hash.
+*
+*******************************************************************/
+
+uint64_t Utilities_HashBytes64( const void *data, const size_t len, const uint64_t seed )
+{
+const uint8_t *bytes = (const uint8_t*)data;
+if( len <= HASH_LONG_KEY_SIZE )
+    {
+    return( HashShort( bytes, len, seed ) );
+    }
+
+uint64_t acc[ 8 ];
+for( uint32_t i = 0; i < cnt_of_array( acc ); i++ )
+    {
+    acc[ i ] = HASH_SECRET[ 8 + i ] ^ seed;
+    }
+
+size_t stripe_count = len / HASH_STRIPE_SIZE;
+HashAccumulate( bytes, stripe_count, acc );
+
+/* fold the lanes and the length, and finish with the bytes left over */
+uint64_t ret = seed ^ ( (uint64_t)len * HASH_MIX[ 0 ] );
+for( uint32_t i = 0; i < cnt_of_array( acc ); i += 2 )
+    {
+    ret = hash_mix( acc[ i ] ^ HASH_SECRET[ i ], acc[ i + 1 ] ^ HASH_SECRET[ i + 1 ] ^ ret );
+    }
+
+size_t consumed = stripe_count * HASH_STRIPE_SIZE;
+return( HashShort( &bytes[ consumed ], len - consumed, ret ) );
+
+} /* Utilities_HashBytes64() */
+
+
+/*******************************************************************
+*
+*   Utilities_RadixSortU32Ascending()
+*
+*   DESCRIPTION:
+*       Sort an array of 32-bit unsigned integers into ascending
+*       order in linear time, a byte per pass.  Passes where every
+*       key has the same byte are skipped, so small values (such as
+*       dense indices) only pay for the low bytes.  The scratch
+*       array must hold count entries.
+*
+*******************************************************************/
+
+void Utilities_RadixSortU32Ascending( const uint32_t count, uint32_t *arr, uint32_t *scratch )
+{
+if( count < RADIX_SORT_MIN_COUNT )
+    {
+    Utilities_ShellSortU32Ascending( count, arr );
+    return;
+    }
+
+/* count every byte of every key in one read */
+uint32_t histograms[ 4 ][ 256 ] = {};
+for( uint32_t i = 0; i < count; i++ )
+    {
+    uint32_t key = arr[ i ];
+    histograms[ 0 ][ key & 0xff ]++;
+    histograms[ 1 ][ ( key >> 8 ) & 0xff ]++;
+    histograms[ 2 ][ ( key >> 16 ) & 0xff ]++;
+    histograms[ 3 ][ key >> 24 ]++;
+    }
+
+uint32_t *src = arr;
+uint32_t *dst = scratch;
+for( uint32_t pass = 0; pass < cnt_of_array( histograms ); pass++ )
+    {
+    uint32_t  shift     = 8 * pass;
+    uint32_t *histogram = histograms[ pass ];
+    if( histogram[ ( src[ 0 ] >> shift ) & 0xff ] == count )
+        {
+        continue;
+        }
+
+    uint32_t offset = 0;
+    for( uint32_t i = 0; i < cnt_of_array( histograms[ 0 ] ); i++ )
+        {
+        uint32_t bucket_count = histogram[ i ];
+        histogram[ i ] = offset;
+        offset += bucket_count;
+        }
+
+    for( uint32_t i = 0; i < count; i++ )
+        {
+        dst[ histogram[ ( src[ i ] >> shift ) & 0xff ]++ ] = src[ i ];
+        }
+
+    uint32_t *swap = src;
+    src = dst;
+    dst = swap;
+    }
+
+if( src != arr )
+    {
+    memcpy( arr, src, count * sizeof(*arr) );
+    }
+
+} /* Utilities_RadixSortU32Ascending() */
+
+
 /*******************************************************************
 *
 *   Utilities_ReadLineFromBuffer()
@@ -79,63 +425,6 @@ return( !end_of_buffer );
 } /* Utilities_ReadLineFromBuffer() */
 
 
-/*******************************************************************
-*
-*   Utilities_ReadWholeTextFile()
-*
-*   DESCRIPTION:
-*       Read the given text file to a new malloc'd buffer.
-*       Returns TRUE if output buffer has a length.
-*
-*******************************************************************/
-
-char * Utilities_ReadWholeTextFile( const char *file_path, int *buffer_sz )
-{
-hard_assert( file_path );
-*buffer_sz = 0;
-
-FILE *fhnd = fopen( file_path, "r" );
-if( !fhnd )
-    {
-    return( nullptr );
-    }
-
-/* get the file size - would use fseek/ftell here, but it's reporting incorrect file length due to crlf (binary mode doesn't help) */
-int file_sz = 0;
-char dummy;
-while( fread( &dummy, 1, 1, fhnd ) )
-    {
-    file_sz++;
-    }
-
-rewind( fhnd );
-if( file_sz <= 0 )
-    {
-    fclose( fhnd );
-    return( nullptr );
-    }
-
-/* read the entire file in our buffer then close it */
-*buffer_sz = file_sz + 1;
-char *ret = (char*)malloc( *buffer_sz );
-if( !ret )
-    {
-    fclose( fhnd );
-    hard_assert_always();
-    return( nullptr );
-    }
-
-size_t read_sz = fread( ret, 1, file_sz, fhnd );
-ret[ file_sz ] = 0;
-hard_assert( (int)read_sz == file_sz );
-fclose( fhnd );
-fhnd = nullptr;
-
-return( ret );
-
-} /* Utilities_ReadWholeTextFile() */
-
-
 /*******************************************************************
 *
 *   Utilities_StrContainsStr()
@@ -193,3 +482,199 @@ for( int i = 0; str[ i ] != 0; i++ )
 return( false );
 
 } /* Utilities_StrContainsStr() */
+
+
+/*******************************************************************
+*
+*   HashAccumulate()
+*
+*   DESCRIPTION:
+*       Accumulate whole stripes into the eight lanes.  Each lane
+*       adds the product of the low and high halves of its keyed
+*       word, plus its neighbour's raw word, and the lanes are
+*       scrambled after every block of stripes.
+*
+*******************************************************************/
+
+static void HashAccumulate( const uint8_t *data, const size_t stripe_count, uint64_t *acc )
+{
+#if defined( UTILITIES_HASH_USE_AVX2 )
+__m256i lanes[ 2 ];
+lanes[ 0 ] = _mm256_loadu_si256( (const __m256i*)&acc[ 0 ] );
+lanes[ 1 ] = _mm256_loadu_si256( (const __m256i*)&acc[ 4 ] );
+
+const __m256i prime = _mm256_set1_epi32( (int)HASH_SCRAMBLE_PRIME );
+for( size_t n = 0; n < stripe_count; n++ )
+    {
+    const uint8_t  *stripe = &data[ n * HASH_STRIPE_SIZE ];
+    const uint64_t *secret = &HASH_SECRET[ n % HASH_STRIPES_PER_BLOCK ];
+    for( uint32_t i = 0; i < cnt_of_array( lanes ); i++ )
+        {
+        __m256i words   = _mm256_loadu_si256( (const __m256i*)&stripe[ 32 * i ] );
+        __m256i keyed   = _mm256_xor_si256( words, _mm256_loadu_si256( (const __m256i*)&secret[ 4 * i ] ) );
+        __m256i product = _mm256_mul_epu32( keyed, _mm256_shuffle_epi32( keyed, _MM_SHUFFLE( 0, 3, 0, 1 ) ) );
+        __m256i swapped = _mm256_shuffle_epi32( words, _MM_SHUFFLE( 1, 0, 3, 2 ) );
+        lanes[ i ] = _mm256_add_epi64( lanes[ i ], _mm256_add_epi64( product, swapped ) );
+        }
+
+    if( n % HASH_STRIPES_PER_BLOCK == HASH_STRIPES_PER_BLOCK - 1 )
+        {
+        for( uint32_t i = 0; i < cnt_of_array( lanes ); i++ )
+            {
+            __m256i mixed = _mm256_xor_si256( lanes[ i ], _mm256_srli_epi64( lanes[ i ], 47 ) );
+            mixed = _mm256_xor_si256( mixed, _mm256_loadu_si256( (const __m256i*)&HASH_SECRET[ HASH_STRIPES_PER_BLOCK + 4 * i ] ) );
+
+            /* 64-bit multiply by a 32-bit prime, from two 32x32 multiplies */
+            __m256i low  = _mm256_mul_epu32( mixed, prime );
+            __m256i high = _mm256_mul_epu32( _mm256_srli_epi64( mixed, 32 ), prime );
+            lanes[ i ] = _mm256_add_epi64( low, _mm256_slli_epi64( high, 32 ) );
+            }
+        }
+    }
+
+_mm256_storeu_si256( (__m256i*)&acc[ 0 ], lanes[ 0 ] );
+_mm256_storeu_si256( (__m256i*)&acc[ 4 ], lanes[ 1 ] );
+
+#elif defined( UTILITIES_HASH_USE_SSE2 )
+__m128i lanes[ 4 ];
+for( uint32_t i = 0; i < cnt_of_array( lanes ); i++ )
+    {
+    lanes[ i ] = _mm_loadu_si128( (const __m128i*)&acc[ 2 * i ] );
+    }
+
+const __m128i prime = _mm_set1_epi32( (int)HASH_SCRAMBLE_PRIME );
+for( size_t n = 0; n < stripe_count; n++ )
+    {
+    const uint8_t  *stripe = &data[ n * HASH_STRIPE_SIZE ];
+    const uint64_t *secret = &HASH_SECRET[ n % HASH_STRIPES_PER_BLOCK ];
+    for( uint32_t i = 0; i < cnt_of_array( lanes ); i++ )
+        {
+        __m128i words   = _mm_loadu_si128( (const __m128i*)&stripe[ 16 * i ] );
+        __m128i keyed   = _mm_xor_si128( words, _mm_loadu_si128( (const __m128i*)&secret[ 2 * i ] ) );
+        __m128i product = _mm_mul_epu32( keyed, _mm_shuffle_epi32( keyed, _MM_SHUFFLE( 0, 3, 0, 1 ) ) );
+        __m128i swapped = _mm_shuffle_epi32( words, _MM_SHUFFLE( 1, 0, 3, 2 ) );
+        lanes[ i ] = _mm_add_epi64( lanes[ i ], _mm_add_epi64( product, swapped ) );
+        }
+
+    if( n % HASH_STRIPES_PER_BLOCK == HASH_STRIPES_PER_BLOCK - 1 )
+        {
+        for( uint32_t i = 0; i < cnt_of_array( lanes ); i++ )
+            {
+            __m128i mixed = _mm_xor_si128( lanes[ i ], _mm_srli_epi64( lanes[ i ], 47 ) );
+            mixed = _mm_xor_si128( mixed, _mm_loadu_si128( (const __m128i*)&HASH_SECRET[ HASH_STRIPES_PER_BLOCK + 2 * i ] ) );
+
+            /* 64-bit multiply by a 32-bit prime, from two 32x32 multiplies */
+            __m128i low  = _mm_mul_epu32( mixed, prime );
+            __m128i high = _mm_mul_epu32( _mm_srli_epi64( mixed, 32 ), prime );
+            lanes[ i ] = _mm_add_epi64( low, _mm_slli_epi64( high, 32 ) );
+            }
+        }
+    }
+
+for( uint32_t i = 0; i < cnt_of_array( lanes ); i++ )
+    {
+    _mm_storeu_si128( (__m128i*)&acc[ 2 * i ], lanes[ i ] );
+    }
+
+#else
+for( size_t n = 0; n < stripe_count; n++ )
+    {
+    const uint8_t  *stripe = &data[ n * HASH_STRIPE_SIZE ];
+    const uint64_t *secret = &HASH_SECRET[ n % HASH_STRIPES_PER_BLOCK ];
+    for( uint32_t i = 0; i < 8; i++ )
+        {
+        uint64_t word  = hash_read64( &stripe[ 8 * i ] );
+        uint64_t keyed = word ^ secret[ i ];
+        acc[ i ^ 1 ] += word;
+        acc[ i ]     += ( keyed & 0xffffffff ) * ( keyed >> 32 );
+        }
+
+    if( n % HASH_STRIPES_PER_BLOCK == HASH_STRIPES_PER_BLOCK - 1 )
+        {
+        for( uint32_t i = 0; i < 8; i++ )
+            {
+            uint64_t mixed = acc[ i ] ^ ( acc[ i ] >> 47 );
+            acc[ i ] = ( mixed ^ HASH_SECRET[ HASH_STRIPES_PER_BLOCK + i ] ) * HASH_SCRAMBLE_PRIME;
+            }
+        }
+    }
+
+#endif
+} /* HashAccumulate() */
+
+
+/*******************************************************************
+*
+*   HashShort()
+*
+*   DESCRIPTION:
+*       Hash a key of any length, 48 bytes at a time in three
+*       independent chains.  Keys of up to 16 bytes are read in two
+*       (possibly overlapping) words, without a loop.
+*
+*******************************************************************/
+
+static uint64_t HashShort( const uint8_t *data, const size_t len, uint64_t seed )
+{
+seed ^= hash_mix( seed ^ HASH_MIX[ 0 ], HASH_MIX[ 1 ] );
+
+uint64_t a;
+uint64_t b;
+if( len <= 16 )
+    {
+    if( len >= 4 )
+        {
+        size_t step = ( len >> 3 ) << 2;
+        a = ( hash_read32( data ) << 32 ) | hash_read32( &data[ step ] );
+        b = ( hash_read32( &data[ len - 4 ] ) << 32 ) | hash_read32( &data[ len - 4 - step ] );
+        }
+    else if( len > 0 )
+        {
+        a = ( (uint64_t)data[ 0 ] << 16 ) | ( (uint64_t)data[ len >> 1 ] << 8 ) | data[ len - 1 ];
+        b = 0;
+        }
+    else
+        {
+        a = 0;
+        b = 0;
+        }
+    }
+else
+    {
+    const uint8_t *p = data;
+    size_t remain = len;
+    if( remain > 48 )
+        {
+        uint64_t chain1 = seed;
+        uint64_t chain2 = seed;
+        do
+            {
+            seed   = hash_mix( hash_read64( &p[  0 ] ) ^ HASH_MIX[ 1 ], hash_read64( &p[  8 ] ) ^ seed );
+            chain1 = hash_mix( hash_read64( &p[ 16 ] ) ^ HASH_MIX[ 2 ], hash_read64( &p[ 24 ] ) ^ chain1 );
+            chain2 = hash_mix( hash_read64( &p[ 32 ] ) ^ HASH_MIX[ 3 ], hash_read64( &p[ 40 ] ) ^ chain2 );
+            p      += 48;
+            remain -= 48;
+            } while( remain > 48 );
+
+        seed ^= chain1 ^ chain2;
+        }
+
+    while( remain > 16 )
+        {
+        seed    = hash_mix( hash_read64( &p[ 0 ] ) ^ HASH_MIX[ 1 ], hash_read64( &p[ 8 ] ) ^ seed );
+        p      += 16;
+        remain -= 16;
+        }
+
+    /* the last 16 bytes of the key, overlapping what was mixed */
+    a = hash_read64( &p[ remain - 16 ] );
+    b = hash_read64( &p[ remain - 8 ] );
+    }
+
+a ^= HASH_MIX[ 1 ];
+b ^= seed;
+hash_multiply( &a, &b );
+
+return( hash_mix( a ^ HASH_MIX[ 0 ] ^ len, b ^ HASH_MIX[ 1 ] ) );
+
+} /* HashShort() */
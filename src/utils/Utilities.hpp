@@ -594,28 +594,24 @@ return( ( sz + mask ) & ~mask );
     ( (_lower) - 0x20 )
 
 
+uint64_t Utilities_HashBytes64( const void *data, const size_t len, const uint64_t seed );
+
+
 /*******************************************************************
 *
 *   Utilities_HashString
 *
 *   DESCRIPTION:
-*       Compute a hash key from the given string.
+*       Compute a hash key from the given string.  This is the
+*       64-bit hash folded to 32 bits.
 *
 *******************************************************************/
 
 static inline u32 Utilities_HashString( const char *str, const size_t len )
 {
-static const u32 SEED  = 0x811c9dc5;
-static const u32 PRIME = 0x01000193;
+uint64_t hash = Utilities_HashBytes64( str, len, 0 );
 
-u32 ret = SEED;
-for( u32 i = 0; i < len; i++ )
-    {
-    ret ^= str[ i ];
-    ret *= PRIME;
-    }
-
-return( ret );
+return( (u32)( hash ^ ( hash >> 32 ) ) );
 
 } /* Utilities_HashString() */
 
@@ -791,6 +787,43 @@ for( u32 it_gap = 0; it_gap < cnt_of_array( CIURA_GAPS ); it_gap++ )
 } /* Utilities_ShellSortU32Ascending() */
 
 
-bool   Utilities_ReadLineFromBuffer( int *read_caret, const char *read, const int read_sz, char *out, const int out_sz );
-char * Utilities_ReadWholeTextFile( const char *file_path, int *buffer_sz );
-bool   Utilities_StrContainsStr( const char *str, const bool case_insensitive, const char *search );
+/*******************************************************************
+*
+*   Utilities_ShellSortU64Ascending
+*
+*   DESCRIPTION:
+*       Shell-sort an array of 64-bit unsigned integers into ascending
+*       order.
+*
+*******************************************************************/
+
+static inline void Utilities_ShellSortU64Ascending( const u32 count, u64 *arr )
+{
+static const u32 CIURA_GAPS[] = { 701, 301, 132, 57, 23, 10, 4, 1 };
+for( u32 it_gap = 0; it_gap < cnt_of_array( CIURA_GAPS ); it_gap++ )
+    {
+    u32 gap = CIURA_GAPS[ it_gap ];
+    u64 temp;
+    for( u32 i = gap; i < count; i++ )
+        {
+        temp = arr[ i ];
+        u32 j;
+        for( j = i; j >= gap && arr[ j - gap ] > temp; j -= gap )
+            {
+            arr[ j ] = arr[ j - gap ];
+            }
+
+        arr[ j ] = temp;
+        }
+    }
+
+} /* Utilities_ShellSortU64Ascending() */
+
+
+void *   Utilities_AlignedAlloc( const size_t size, const size_t alignment );
+void     Utilities_AlignedFree( void *ptr );
+void *   Utilities_AlignedRealloc( void *ptr, const size_t old_size, const size_t new_size, const size_t alignment );
+uint64_t Utilities_GetTimeNanoseconds();
+void     Utilities_RadixSortU32Ascending( const uint32_t count, uint32_t *arr, uint32_t *scratch );
+bool     Utilities_ReadLineFromBuffer( int *read_caret, const char *read, const int read_sz, char *out, const int out_sz );
+bool     Utilities_StrContainsStr( const char *str, const bool case_insensitive, const char *search );
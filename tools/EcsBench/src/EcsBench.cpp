@@ -0,0 +1,113 @@
+/*******************************************************************
+*
+*   EcsBench
+*
+*   DESCRIPTION:
+*       Timing benchmarks for the ECS storage paths, printing
+*       nanoseconds per item for each variant side by side:
+*
+*       - joins through an owning group against the same join
+*         through a non-owning group (EcsBenchGroups.cpp).
+*       - a position-only transform kernel over the structure-of-
+*         arrays position column against whole transform structs
+*         (EcsBenchColumns.cpp).
+*       - add/remove churn and a two-class join over the sparse
+*         set registries against archetype storage
+*         (EcsBenchStorage.cpp).
+*       - event bursts pushed through enqueue, dispatch and the
+*         cleanup frame, as messages per second
+*         (EcsBenchMessages.cpp).
+*
+*       Each measurement repeats its pass until MIN_SECONDS have
+*       elapsed, after one untimed warm-up pass.
+*
+*       Build from this directory with the flags the game uses,
+*       against the ECS and the utilities it needs, e.g.
+*           g++ -std=c++17 -O2 -I../../../src -I../../../src/ecs -I../../../src/utils
+*               EcsBench*.cpp ../../../src/ecs/{Archetype,Command,Component,Entity,
+*               EntityCommandBuffer,Event,NonOwningGroup,OwningGroup,Universe}.cpp
+*               ../../../src/utils/{FrameAllocator,LinearAllocator,MessageQueue,
+*               ThreadPool,Utilities}.cpp -lpthread
+*
+*******************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Utilities.hpp"
+
+#include "EcsBench.hpp"
+
+
+#define MIN_SECONDS                 ( 0.25 )
+
+static uint64_t s_random_state = 1;
+static volatile uint64_t s_sink;
+
+
+/*******************************************************************
+*
+*   main()
+*
+*******************************************************************/
+
+int main()
+{
+EcsBench_RunGroups();
+EcsBench_RunColumns();
+EcsBench_RunStorage();
+EcsBench_RunMessages();
+
+return( EXIT_SUCCESS );
+
+} /* main() */
+
+
+/*******************************************************************
+*
+*   EcsBench_NsPerItem()
+*
+*   DESCRIPTION:
+*       Time the procedure, and return the mean nanoseconds per
+*       item over the timed passes.
+*
+*******************************************************************/
+
+double EcsBench_NsPerItem( const uint64_t item_count, EcsBenchProc *proc, void *user )
+{
+s_sink += proc( user );
+
+uint64_t pass_count = 0;
+uint64_t start      = Utilities_GetTimeNanoseconds();
+uint64_t elapsed    = 0;
+do
+    {
+    s_sink += proc( user );
+    pass_count++;
+    elapsed = Utilities_GetTimeNanoseconds() - start;
+    } while( elapsed < (uint64_t)( MIN_SECONDS * 1e9 ) );
+
+return( (double)elapsed / (double)( pass_count * item_count ) );
+
+} /* EcsBench_NsPerItem() */
+
+
+/*******************************************************************
+*
+*   EcsBench_Random()
+*
+*   DESCRIPTION:
+*       xorshift64*, so every run builds the same worlds.
+*
+*******************************************************************/
+
+uint32_t EcsBench_Random( void )
+{
+s_random_state ^= s_random_state >> 12;
+s_random_state ^= s_random_state << 25;
+s_random_state ^= s_random_state >> 27;
+
+return( (uint32_t)( ( s_random_state * 0x2545f4914f6cdd1dull ) >> 32 ) );
+
+} /* EcsBench_Random() */
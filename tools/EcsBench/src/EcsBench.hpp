@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+/*******************************************************************
+*
+*   EcsBenchProc
+*
+*   DESCRIPTION:
+*       One pass of the measured work.  Returns a value derived from
+*       everything it touched, so the work can't be optimized away.
+*
+*******************************************************************/
+
+typedef uint64_t EcsBenchProc( void *user );
+
+double   EcsBench_NsPerItem( const uint64_t item_count, EcsBenchProc *proc, void *user );
+uint32_t EcsBench_Random( void );
+void     EcsBench_RunColumns( void );
+void     EcsBench_RunGroups( void );
+void     EcsBench_RunMessages( void );
+void     EcsBench_RunStorage( void );
@@ -0,0 +1,148 @@
+/*******************************************************************
+*
+*   EcsBenchColumns
+*
+*   DESCRIPTION:
+*       Translate every transform's position over worlds of 10k,
+*       100k and 1M entities.  The structure-of-arrays pass walks
+*       the registry's position column; the array-of-structures
+*       pass walks whole TransformComponent structs, the layout the
+*       registry stored before TransformComponent opted in.  The
+*       kernel touches 12 of every 48 bytes, so the difference is
+*       the memory traffic the other fields cost.
+*
+*******************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Component.hpp"
+#include "Universe.hpp"
+
+#include "EcsBench.hpp"
+
+using namespace ECS;
+
+
+static const uint32_t ENTITY_COUNTS[] = { 10000, 100000, 1000000 };
+
+typedef struct _ColumnsWorld
+    {
+    Universe           *universe;
+    TransformComponent *structs;        /* the same transforms, one struct each */
+    uint32_t            entity_count;
+    } ColumnsWorld;
+
+
+static void     BuildWorld( const uint32_t entity_count, ColumnsWorld *out );
+static uint64_t TranslateColumns( void *user );
+static uint64_t TranslateStructs( void *user );
+
+
+/*******************************************************************
+*
+*   EcsBench_RunColumns()
+*
+*******************************************************************/
+
+void EcsBench_RunColumns( void )
+{
+printf( "transform translate (position only), ns per entity\n" );
+printf( "  %9s %12s %12s %8s\n", "entities", "aos", "soa", "speedup" );
+for( uint32_t i = 0; i < cnt_of_array( ENTITY_COUNTS ); i++ )
+    {
+    ColumnsWorld world;
+    BuildWorld( ENTITY_COUNTS[ i ], &world );
+
+    double aos = EcsBench_NsPerItem( world.entity_count, TranslateStructs, &world );
+    double soa = EcsBench_NsPerItem( world.entity_count, TranslateColumns, &world );
+    printf( "  %9u %12.2f %12.2f %7.1fx\n", world.entity_count, aos, soa, aos / soa );
+
+    Universe_Destroy( world.universe );
+    free( world.universe );
+    free( world.structs );
+    }
+
+} /* EcsBench_RunColumns() */
+
+
+/*******************************************************************
+*
+*   BuildWorld()
+*
+*******************************************************************/
+
+static void BuildWorld( const uint32_t entity_count, ColumnsWorld *out )
+{
+*out = {};
+out->universe     = (Universe*)malloc( sizeof(*out->universe) );
+out->structs      = (TransformComponent*)malloc( entity_count * sizeof(*out->structs) );
+out->entity_count = entity_count;
+Universe_Init( UNIVERSE_STORAGE_SPARSE_SET, out->universe );
+
+for( uint32_t i = 0; i < entity_count; i++ )
+    {
+    EntityId entity = Universe_CreateNewEntity( out->universe );
+    Universe_AttachComponentToEntity( entity, COMPONENT_TRANSFORM, out->universe );
+
+    TransformComponent transform = {};
+    transform.position = Math_Float3Make( (float)i, 0.0f, 0.0f );
+    transform.rotation = QUATERNION_IDENTITY;
+    transform.scale    = Math_Float3Make( 1.0f, 1.0f, 1.0f );
+    *(Float3*)Universe_TryGetComponentFieldMut( entity, COMPONENT_TRANSFORM, TRANSFORM_FIELD_POSITION, out->universe ) = transform.position;
+    *(Quaternion*)Universe_TryGetComponentFieldMut( entity, COMPONENT_TRANSFORM, TRANSFORM_FIELD_ROTATION, out->universe ) = transform.rotation;
+    *(Float3*)Universe_TryGetComponentFieldMut( entity, COMPONENT_TRANSFORM, TRANSFORM_FIELD_SCALE, out->universe ) = transform.scale;
+    out->structs[ i ] = transform;
+    }
+
+} /* BuildWorld() */
+
+
+/*******************************************************************
+*
+*   TranslateColumns()
+*
+*******************************************************************/
+
+static uint64_t TranslateColumns( void *user )
+{
+ColumnsWorld      *world    = (ColumnsWorld*)user;
+ComponentRegistry *registry = &world->universe->components[ COMPONENT_TRANSFORM ];
+
+Float3 *positions = (Float3*)Component_GetColumn( TRANSFORM_FIELD_POSITION, registry );
+for( uint32_t i = 0; i < registry->dense_count; i++ )
+    {
+    positions[ i ].v.x += 1.0f;
+    positions[ i ].v.y += 0.5f;
+    }
+
+uint32_t bits;
+memcpy( &bits, &positions[ 0 ].v.y, sizeof(bits) );
+return( bits );
+
+} /* TranslateColumns() */
+
+
+/*******************************************************************
+*
+*   TranslateStructs()
+*
+*******************************************************************/
+
+static uint64_t TranslateStructs( void *user )
+{
+ColumnsWorld *world = (ColumnsWorld*)user;
+
+for( uint32_t i = 0; i < world->entity_count; i++ )
+    {
+    world->structs[ i ].position.v.x += 1.0f;
+    world->structs[ i ].position.v.y += 0.5f;
+    }
+
+uint32_t bits;
+memcpy( &bits, &world->structs[ 0 ].position.v.y, sizeof(bits) );
+return( bits );
+
+} /* TranslateStructs() */
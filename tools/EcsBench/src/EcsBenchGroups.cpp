@@ -0,0 +1,172 @@
+/*******************************************************************
+*
+*   EcsBenchGroups
+*
+*   DESCRIPTION:
+*       Join MODEL with SCENE over worlds of 10k, 100k and 1M
+*       entities.  Every entity has a model and a random half have
+*       a scene, attached in shuffled order so the two registries'
+*       dense orders are unrelated - the layout a running game
+*       drifts towards.
+*
+*       The non-owning join walks the model registry and probes the
+*       scene registry's sparse set per entity.  The owning join
+*       walks the packed front of both registries.
+*
+*******************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "NonOwningGroup.hpp"
+#include "OwningGroup.hpp"
+#include "Universe.hpp"
+
+#include "EcsBench.hpp"
+
+using namespace ECS;
+
+
+static const uint32_t ENTITY_COUNTS[] = { 10000, 100000, 1000000 };
+
+typedef struct _GroupsWorld
+    {
+    Universe           *universe;
+    OwningGroup        *group;          /* NULL for the non-owning world */
+    uint32_t            joined_count;
+    } GroupsWorld;
+
+
+static void     BuildWorld( const uint32_t entity_count, const bool is_owning, GroupsWorld *out );
+static uint64_t JoinNonOwning( void *user );
+static uint64_t JoinOwning( void *user );
+
+
+/*******************************************************************
+*
+*   EcsBench_RunGroups()
+*
+*******************************************************************/
+
+void EcsBench_RunGroups( void )
+{
+printf( "group join (MODEL x SCENE, half match), ns per joined entity\n" );
+printf( "  %9s %12s %12s %8s\n", "entities", "non-owning", "owning", "speedup" );
+for( uint32_t i = 0; i < cnt_of_array( ENTITY_COUNTS ); i++ )
+    {
+    GroupsWorld non_owning;
+    BuildWorld( ENTITY_COUNTS[ i ], false, &non_owning );
+    double non_owning_ns = EcsBench_NsPerItem( non_owning.joined_count, JoinNonOwning, &non_owning );
+    Universe_Destroy( non_owning.universe );
+    free( non_owning.universe );
+
+    GroupsWorld owning;
+    BuildWorld( ENTITY_COUNTS[ i ], true, &owning );
+    double owning_ns = EcsBench_NsPerItem( owning.joined_count, JoinOwning, &owning );
+    Universe_Destroy( owning.universe );
+    free( owning.universe );
+
+    printf( "  %9u %12.2f %12.2f %7.1fx\n", ENTITY_COUNTS[ i ], non_owning_ns, owning_ns, non_owning_ns / owning_ns );
+    }
+
+} /* EcsBench_RunGroups() */
+
+
+/*******************************************************************
+*
+*   BuildWorld()
+*
+*   DESCRIPTION:
+*       Create the entities, give each a model, then give a random
+*       half a scene in shuffled order.  The owning world creates
+*       its group first, so it is packed as the scenes arrive.
+*
+*******************************************************************/
+
+static void BuildWorld( const uint32_t entity_count, const bool is_owning, GroupsWorld *out )
+{
+*out = {};
+out->universe = (Universe*)malloc( sizeof(*out->universe) );
+Universe_Init( UNIVERSE_STORAGE_SPARSE_SET, out->universe );
+if( is_owning )
+    {
+    out->group = OwningGroup_Create( out->universe, OwningGroup_GroupIds( COMPONENT_MODEL, COMPONENT_SCENE ) );
+    }
+
+EntityId *entities = (EntityId*)malloc( entity_count * sizeof(*entities) );
+for( uint32_t i = 0; i < entity_count; i++ )
+    {
+    entities[ i ] = Universe_CreateNewEntity( out->universe );
+    ModelComponent *model = (ModelComponent*)Universe_AttachComponentToEntity( entities[ i ], COMPONENT_MODEL, out->universe );
+    model->scene_name_id = i;
+    }
+
+for( uint32_t i = entity_count - 1; i > 0; i-- )
+    {
+    uint32_t j    = EcsBench_Random() % ( i + 1 );
+    EntityId swap = entities[ i ];
+    entities[ i ] = entities[ j ];
+    entities[ j ] = swap;
+    }
+
+out->joined_count = entity_count / 2;
+for( uint32_t i = 0; i < out->joined_count; i++ )
+    {
+    SceneComponent *scene = (SceneComponent*)Universe_AttachComponentToEntity( entities[ i ], COMPONENT_SCENE, out->universe );
+    scene->draw_order = i;
+    }
+
+free( entities );
+
+} /* BuildWorld() */
+
+
+/*******************************************************************
+*
+*   JoinNonOwning()
+*
+*******************************************************************/
+
+static uint64_t JoinNonOwning( void *user )
+{
+GroupsWorld *world = (GroupsWorld*)user;
+uint64_t     sum   = 0;
+
+NonOwningGroupIterator iterator;
+NonOwningGroup_CreateIterator( world->universe, &iterator, NonOwningGroup_GroupIds( COMPONENT_MODEL, COMPONENT_SCENE ) );
+while( NonOwningGroup_GetNext( &iterator, NULL, NULL ) )
+    {
+    const ModelComponent *model = (const ModelComponent*)NonOwningGroup_GetComponent( COMPONENT_MODEL, &iterator );
+    const SceneComponent *scene = (const SceneComponent*)NonOwningGroup_GetComponent( COMPONENT_SCENE, &iterator );
+    sum += model->scene_name_id + scene->draw_order;
+    }
+
+return( sum );
+
+} /* JoinNonOwning() */
+
+
+/*******************************************************************
+*
+*   JoinOwning()
+*
+*******************************************************************/
+
+static uint64_t JoinOwning( void *user )
+{
+GroupsWorld *world = (GroupsWorld*)user;
+uint64_t     sum   = 0;
+
+OwningGroupIterator iterator;
+OwningGroup_CreateIterator( world->group, &iterator );
+while( OwningGroup_GetNext( &iterator, NULL ) )
+    {
+    const ModelComponent *model = (const ModelComponent*)OwningGroup_GetComponent( COMPONENT_MODEL, &iterator );
+    const SceneComponent *scene = (const SceneComponent*)OwningGroup_GetComponent( COMPONENT_SCENE, &iterator );
+    sum += model->scene_name_id + scene->draw_order;
+    }
+
+return( sum );
+
+} /* JoinOwning() */
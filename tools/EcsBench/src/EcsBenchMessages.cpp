@@ -0,0 +1,113 @@
+/*******************************************************************
+*
+*   EcsBenchMessages
+*
+*   DESCRIPTION:
+*       Push bursts of events through a frame - enqueue, dispatch
+*       to one listener, and the command frame that cleans up after
+*       them - and report the sustained messages per second.  Only
+*       the public Event_* / Command_* calls are used, so the same
+*       source times any implementation behind them.
+*
+*******************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Command.hpp"
+#include "Event.hpp"
+#include "Universe.hpp"
+
+#include "EcsBench.hpp"
+
+using namespace ECS;
+
+
+static const uint32_t BURST_COUNTS[] = { 100, 10000, 100000 };
+
+typedef struct _MessagesWorld
+    {
+    Universe           *universe;
+    uint32_t            burst_count;
+    } MessagesWorld;
+
+static uint64_t s_dispatched;
+
+
+static uint64_t DoBurst( void *user );
+static void     OnEvent( const EventNotificationComponent *evt, Universe *universe );
+
+
+/*******************************************************************
+*
+*   EcsBench_RunMessages()
+*
+*******************************************************************/
+
+void EcsBench_RunMessages( void )
+{
+printf( "event burst (enqueue + dispatch + cleanup frame)\n" );
+printf( "  %9s %12s %14s\n", "per frame", "ns/message", "messages/s" );
+for( uint32_t i = 0; i < cnt_of_array( BURST_COUNTS ); i++ )
+    {
+    MessagesWorld world = {};
+    world.universe    = (Universe*)malloc( sizeof(*world.universe) );
+    world.burst_count = BURST_COUNTS[ i ];
+    Universe_Init( UNIVERSE_STORAGE_SPARSE_SET, world.universe );
+    Command_Init( world.universe );
+    Event_Init( world.universe );
+    Event_RegisterEventListener( EVENT_LISTENER_GAME_MODE, OnEvent, world.universe );
+    Event_ListenToEvent( EVENT_LISTENER_GAME_MODE, EVENT_NOTIFICATION_GAME_MAIN_MODE_CHANGED, EVENT_LISTEN_ACTION_START_LISTENING, world.universe );
+
+    double ns = EcsBench_NsPerItem( world.burst_count, DoBurst, &world );
+    printf( "  %9u %12.2f %14.0f\n", world.burst_count, ns, 1e9 / ns );
+
+    Event_Destroy( world.universe );
+    Command_Destroy( world.universe );
+    Universe_Destroy( world.universe );
+    free( world.universe );
+    }
+
+} /* EcsBench_RunMessages() */
+
+
+/*******************************************************************
+*
+*   DoBurst()
+*
+*   DESCRIPTION:
+*       Enqueue one burst and run the frames that dispatch it.
+*
+*******************************************************************/
+
+static uint64_t DoBurst( void *user )
+{
+MessagesWorld *world = (MessagesWorld*)user;
+
+EventNotificationEvent evt;
+for( uint32_t i = 0; i < world->burst_count; i++ )
+    {
+    Event_Enqueue( EVENT_NOTIFICATION_GAME_MAIN_MODE_CHANGED, Event_MakeChangeGameMainMode( GAME_MODE_NONE, GAME_MODE_IN_GAME, &evt ), world->universe );
+    }
+
+Event_DoFrame( 0.0f, world->universe );
+Command_DoFrame( 0.0f, world->universe );
+
+return( s_dispatched );
+
+} /* DoBurst() */
+
+
+/*******************************************************************
+*
+*   OnEvent()
+*
+*******************************************************************/
+
+static void OnEvent( const EventNotificationComponent *evt, Universe *universe )
+{
+(void)universe;
+s_dispatched += evt->cls;
+
+} /* OnEvent() */
@@ -0,0 +1,165 @@
+/*******************************************************************
+*
+*   EcsBenchStorage
+*
+*   DESCRIPTION:
+*       Compare the sparse set registries with archetype storage,
+*       over worlds of 10k, 100k and 1M entities which all have a
+*       model and a scene - the fixed combination archetypes are
+*       built for.
+*
+*       Churn attaches a sound to every entity and removes it again,
+*       which moves each entity to another archetype and back.
+*       Iteration joins MODEL with SCENE through a non-owning group.
+*
+*******************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "NonOwningGroup.hpp"
+#include "Universe.hpp"
+
+#include "EcsBench.hpp"
+
+using namespace ECS;
+
+
+static const uint32_t ENTITY_COUNTS[] = { 10000, 100000, 1000000 };
+
+typedef struct _StorageWorld
+    {
+    Universe           *universe;
+    EntityId           *entities;
+    uint32_t            entity_count;
+    } StorageWorld;
+
+
+static void     BuildWorld( const uint32_t entity_count, const UniverseStorage storage, StorageWorld *out );
+static void     DestroyWorld( StorageWorld *world );
+static uint64_t DoChurn( void *user );
+static uint64_t DoIterate( void *user );
+
+
+/*******************************************************************
+*
+*   EcsBench_RunStorage()
+*
+*******************************************************************/
+
+void EcsBench_RunStorage( void )
+{
+printf( "storage (MODEL + SCENE on every entity), ns per entity\n" );
+printf( "  %9s %12s %12s %12s %12s\n", "entities", "churn sparse", "churn arch", "iter sparse", "iter arch" );
+for( uint32_t i = 0; i < cnt_of_array( ENTITY_COUNTS ); i++ )
+    {
+    StorageWorld sparse;
+    StorageWorld archetype;
+    BuildWorld( ENTITY_COUNTS[ i ], UNIVERSE_STORAGE_SPARSE_SET, &sparse );
+    BuildWorld( ENTITY_COUNTS[ i ], UNIVERSE_STORAGE_ARCHETYPE,  &archetype );
+
+    double churn_sparse    = EcsBench_NsPerItem( sparse.entity_count, DoChurn, &sparse );
+    double churn_archetype = EcsBench_NsPerItem( archetype.entity_count, DoChurn, &archetype );
+    double iter_sparse     = EcsBench_NsPerItem( sparse.entity_count, DoIterate, &sparse );
+    double iter_archetype  = EcsBench_NsPerItem( archetype.entity_count, DoIterate, &archetype );
+    printf( "  %9u %12.2f %12.2f %12.2f %12.2f\n", ENTITY_COUNTS[ i ], churn_sparse, churn_archetype, iter_sparse, iter_archetype );
+
+    DestroyWorld( &sparse );
+    DestroyWorld( &archetype );
+    }
+
+} /* EcsBench_RunStorage() */
+
+
+/*******************************************************************
+*
+*   BuildWorld()
+*
+*******************************************************************/
+
+static void BuildWorld( const uint32_t entity_count, const UniverseStorage storage, StorageWorld *out )
+{
+*out = {};
+out->universe     = (Universe*)malloc( sizeof(*out->universe) );
+out->entities     = (EntityId*)malloc( entity_count * sizeof(*out->entities) );
+out->entity_count = entity_count;
+Universe_Init( storage, out->universe );
+
+for( uint32_t i = 0; i < entity_count; i++ )
+    {
+    out->entities[ i ] = Universe_CreateNewEntity( out->universe );
+    ModelComponent *model = (ModelComponent*)Universe_AttachComponentToEntity( out->entities[ i ], COMPONENT_MODEL, out->universe );
+    model->scene_name_id = i;
+    SceneComponent *scene = (SceneComponent*)Universe_AttachComponentToEntity( out->entities[ i ], COMPONENT_SCENE, out->universe );
+    scene->draw_order = EcsBench_Random() % 64;
+    }
+
+} /* BuildWorld() */
+
+
+/*******************************************************************
+*
+*   DestroyWorld()
+*
+*******************************************************************/
+
+static void DestroyWorld( StorageWorld *world )
+{
+Universe_Destroy( world->universe );
+free( world->universe );
+free( world->entities );
+*world = {};
+
+} /* DestroyWorld() */
+
+
+/*******************************************************************
+*
+*   DoChurn()
+*
+*******************************************************************/
+
+static uint64_t DoChurn( void *user )
+{
+StorageWorld *world = (StorageWorld*)user;
+for( uint32_t i = 0; i < world->entity_count; i++ )
+    {
+    Universe_AttachComponentToEntity( world->entities[ i ], COMPONENT_SOUNDS, world->universe );
+    }
+
+for( uint32_t i = 0; i < world->entity_count; i++ )
+    {
+    Universe_RemoveComponentFromEntity( world->entities[ i ], COMPONENT_SOUNDS, world->universe );
+    }
+
+Universe_AdvanceFrame( world->universe );
+
+return( world->entity_count );
+
+} /* DoChurn() */
+
+
+/*******************************************************************
+*
+*   DoIterate()
+*
+*******************************************************************/
+
+static uint64_t DoIterate( void *user )
+{
+StorageWorld *world = (StorageWorld*)user;
+uint64_t      sum   = 0;
+
+NonOwningGroupIterator iterator;
+NonOwningGroup_CreateIterator( world->universe, &iterator, NonOwningGroup_GroupIds( COMPONENT_MODEL, COMPONENT_SCENE ) );
+while( NonOwningGroup_GetNext( &iterator, NULL, NULL ) )
+    {
+    const ModelComponent *model = (const ModelComponent*)NonOwningGroup_GetComponent( COMPONENT_MODEL, &iterator );
+    const SceneComponent *scene = (const SceneComponent*)NonOwningGroup_GetComponent( COMPONENT_SCENE, &iterator );
+    sum += model->scene_name_id + scene->draw_order;
+    }
+
+return( sum );
+
+} /* DoIterate() */
@@ -0,0 +1,627 @@
+/*******************************************************************
+*
+*   MathCheck
+*
+*   DESCRIPTION:
+*       Checks the inline math (src/utils/MathSimd.hpp) in two ways:
+*
+*       - against double precision references written out here, so
+*         the meaning of each operation is pinned down (cross
+*         product sign, C = A x B order and aliasing, (x, y, z, w)
+*         quaternions rotating column vectors, T x R x S);
+*       - the compiler's vector backend against the MATH_SCALAR
+*         reference build, within MAX_ULP units in the last place.
+*
+*       The batched transform and collision kernels
+*       (MathCheckBatch.cpp) are checked against the one at a time
+*       kernels they must match, then timed against them.
+*
+*       Returns zero if every check passes.
+*
+*       Build from this directory with the flags the game uses, e.g.
+*           g++ -std=c++17 -O2 -mavx2 -fpermissive -I../../../src/utils -I../../../src
+*               *.cpp ../../../src/utils/Math{Collision,Matrix,Vector}.cpp
+*           g++ -std=c++17 -O2 -msse4.1 -fpermissive -I../../../src/utils -I../../../src
+*               *.cpp ../../../src/utils/Math{Collision,Matrix,Vector}.cpp
+*           cl /std:c++17 /O2 /arch:AVX2 /I..\..\..\src\utils /I..\..\..\src *.cpp
+*               ..\..\..\src\utils\MathCollision.cpp ..\..\..\src\utils\MathMatrix.cpp
+*               ..\..\..\src\utils\MathVector.cpp
+*       (MathMatrix.cpp needs -fpermissive under g++.)
+*
+*******************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "MathCheck.hpp"
+#include "MathCheckKernels.hpp"
+
+
+#define RANDOM_CASE_CNT             ( 20000 )
+#define MAX_ULP                     ( 4 )
+#define MIN_SECONDS                 ( 0.25 )    /* per timing */
+#define REFERENCE_TOLERANCE         ( 2e-5 )    /* relative to the size of the terms */
+#define SPOT_TOLERANCE              ( 1e-6 )
+
+typedef struct _CheckCounts
+    {
+    uint32_t            passed;
+    uint32_t            failed;
+    } CheckCounts;
+
+static CheckCounts s_counts;
+static volatile uint64_t s_sink;
+
+
+static void     CheckBackendsAgree( const MathCheckKernels *scalar, const MathCheckKernels *vector );
+static void     CheckReferences( const MathCheckKernels *kernels );
+static void     CheckSpots( const MathCheckKernels *kernels );
+static bool     IsNear( const float *got, const double *expected, const uint32_t count, const double scale );
+static void     ReferenceRotate( const float *q, const double *v, double *out );
+static uint32_t UlpDistance( const float a, const float b );
+
+
+/*******************************************************************
+*
+*   main()
+*
+*******************************************************************/
+
+int main()
+{
+MathCheckKernels scalar = {};
+MathCheckKernels vector = {};
+MathCheck_GetScalarKernels( &scalar );
+MathCheck_GetVectorKernels( &vector );
+printf( "MathCheck - reference %s, vector backend %s\n", scalar.name, vector.name );
+
+srand( 1 );
+CheckSpots( &scalar );
+CheckSpots( &vector );
+CheckReferences( &scalar );
+CheckReferences( &vector );
+CheckBackendsAgree( &scalar, &vector );
+MathCheck_CheckTransformBatches( vector.name );
+MathCheck_CheckCollisionBatches( vector.name );
+MathCheck_TimeTransformBatches( vector.name );
+MathCheck_TimeCollisionBatches( vector.name );
+
+printf( "%u passed, %u failed\n", s_counts.passed, s_counts.failed );
+
+return( s_counts.failed ? EXIT_FAILURE : EXIT_SUCCESS );
+
+} /* main() */
+
+
+/*******************************************************************
+*
+*   MathCheck_Check()
+*
+*   DESCRIPTION:
+*       Count a check, and report it if it failed.
+*
+*******************************************************************/
+
+void MathCheck_Check( const bool is_passed, const char *what, const char *backend )
+{
+if( is_passed )
+    {
+    s_counts.passed++;
+    return;
+    }
+
+s_counts.failed++;
+printf( "FAILED [%s] %s\n", backend, what );
+
+} /* MathCheck_Check() */
+
+
+/*******************************************************************
+*
+*   MathCheck_NsPerItem()
+*
+*   DESCRIPTION:
+*       Time the procedure, and return the mean nanoseconds per
+*       item over the timed passes.  One untimed pass warms up
+*       first, then passes repeat until MIN_SECONDS have elapsed.
+*
+*******************************************************************/
+
+double MathCheck_NsPerItem( const uint64_t item_count, MathCheckProc *proc, void *user )
+{
+typedef std::chrono::steady_clock Clock;
+s_sink += proc( user );
+
+uint64_t pass_count = 0;
+Clock::time_point start = Clock::now();
+double elapsed = 0.0;
+do
+    {
+    s_sink += proc( user );
+    pass_count++;
+    elapsed = std::chrono::duration<double>( Clock::now() - start ).count();
+    } while( elapsed < MIN_SECONDS );
+
+return( elapsed * 1e9 / (double)( pass_count * item_count ) );
+
+} /* MathCheck_NsPerItem() */
+
+
+/*******************************************************************
+*
+*   MathCheck_RandomFloats()
+*
+*   DESCRIPTION:
+*       Uniform floats in [-range, range].
+*
+*******************************************************************/
+
+void MathCheck_RandomFloats( const float range, const uint32_t count, float *out )
+{
+for( uint32_t i = 0; i < count; i++ )
+    {
+    out[ i ] = range * ( 2.0f * (float)rand() / (float)RAND_MAX - 1.0f );
+    }
+
+} /* MathCheck_RandomFloats() */
+
+
+/*******************************************************************
+*
+*   MathCheck_RandomQuaternion()
+*
+*   DESCRIPTION:
+*       A random unit quaternion (x, y, z, w).
+*
+*******************************************************************/
+
+void MathCheck_RandomQuaternion( float *out )
+{
+double length = 0.0;
+do
+    {
+    MathCheck_RandomFloats( 1.0f, 4, out );
+    length = sqrt( (double)out[ 0 ] * out[ 0 ] + (double)out[ 1 ] * out[ 1 ] + (double)out[ 2 ] * out[ 2 ] + (double)out[ 3 ] * out[ 3 ] );
+    }
+while( length < 0.1 );
+
+for( uint32_t i = 0; i < 4; i++ )
+    {
+    out[ i ] = (float)( out[ i ] / length );
+    }
+
+} /* MathCheck_RandomQuaternion() */
+
+
+/*******************************************************************
+*
+*   CheckBackendsAgree()
+*
+*   DESCRIPTION:
+*       Run both backends on the same random inputs, and check every
+*       output lane is within MAX_ULP.  Reports the worst distance
+*       and how many outputs matched bit for bit.
+*
+*******************************************************************/
+
+static void CheckBackendsAgree( const MathCheckKernels *scalar, const MathCheckKernels *vector )
+{
+uint32_t worst    = 0;
+uint64_t exact    = 0;
+uint64_t compared = 0;
+
+#define COMPARE( _what, _a, _b, _count )                                        \
+    for( uint32_t lane = 0; lane < (_count); lane++ )                           \
+        {                                                                       \
+        uint32_t ulp = UlpDistance( (_a)[ lane ], (_b)[ lane ] );               \
+        worst = ulp > worst ? ulp : worst;                                      \
+        exact += ( ulp == 0 );                                                  \
+        compared++;                                                             \
+        if( ulp > MAX_ULP )                                                     \
+            {                                                                   \
+            MathCheck_Check( false, _what " differs from the scalar build", vector->name );\
+            break;                                                              \
+            }                                                                   \
+        }
+
+for( uint32_t i = 0; i < RANDOM_CASE_CNT; i++ )
+    {
+    float a[ 16 ], b[ 16 ], c[ 4 ], q[ 4 ];
+    float out_s[ 16 ], out_v[ 16 ];
+    MathCheck_RandomFloats( 10.0f, 16, a );
+    MathCheck_RandomFloats( 10.0f, 16, b );
+    MathCheck_RandomFloats( 10.0f, 4, c );
+    MathCheck_RandomQuaternion( q );
+
+    scalar->float3_cross( a, b, out_s );
+    vector->float3_cross( a, b, out_v );
+    COMPARE( "Float3CrossProduct", out_s, out_v, 3 );
+
+    scalar->float4_add( a, b, out_s );
+    vector->float4_add( a, b, out_v );
+    COMPARE( "Float4Addition", out_s, out_v, 4 );
+
+    scalar->float4_hadamard( a, b, out_s );
+    vector->float4_hadamard( a, b, out_v );
+    COMPARE( "Float4HadamardProduct", out_s, out_v, 4 );
+
+    scalar->float4_scale( a, c[ 0 ], out_s );
+    vector->float4_scale( a, c[ 0 ], out_v );
+    COMPARE( "Float4ScalarMultiply", out_s, out_v, 4 );
+
+    out_s[ 0 ] = scalar->float4_dot( a, b );
+    out_v[ 0 ] = vector->float4_dot( a, b );
+    COMPARE( "Float4DotProduct", out_s, out_v, 1 );
+
+    out_s[ 0 ] = scalar->float4_angle( a, b );
+    out_v[ 0 ] = vector->float4_angle( a, b );
+    COMPARE( "Float4AngleBetween", out_s, out_v, 1 );
+
+    scalar->float4_triple( a, b, c, out_s );
+    vector->float4_triple( a, b, c, out_v );
+    COMPARE( "Float4TripleProduct", out_s, out_v, 4 );
+
+    scalar->float4x4_multiply( a, b, out_s );
+    vector->float4x4_multiply( a, b, out_v );
+    COMPARE( "Float4x4MultiplyByFloat4x4", out_s, out_v, 16 );
+
+    scalar->quaternion_to_float4x4( q, out_s );
+    vector->quaternion_to_float4x4( q, out_v );
+    COMPARE( "QuaternionToFloat4x4", out_s, out_v, 16 );
+
+    scalar->float4x4_transform_spin( a, q, c, out_s );
+    vector->float4x4_transform_spin( a, q, c, out_v );
+    COMPARE( "Float4x4TransformSpin", out_s, out_v, 16 );
+    }
+
+#undef COMPARE
+
+MathCheck_Check( worst <= MAX_ULP, "backends agree", vector->name );
+printf( "[%s] vs scalar: %llu of %llu outputs bit-exact, worst %u ulp\n", vector->name, (unsigned long long)exact, (unsigned long long)compared, worst );
+
+} /* CheckBackendsAgree() */
+
+
+/*******************************************************************
+*
+*   CheckReferences()
+*
+*   DESCRIPTION:
+*       Compare a backend against double precision references on
+*       random inputs.
+*
+*******************************************************************/
+
+static void CheckReferences( const MathCheckKernels *kernels )
+{
+bool is_cross_ok    = true;
+bool is_arith_ok    = true;
+bool is_triple_ok   = true;
+bool is_multiply_ok = true;
+bool is_alias_ok    = true;
+bool is_rotation_ok = true;
+bool is_spin_ok     = true;
+
+for( uint32_t i = 0; i < RANDOM_CASE_CNT; i++ )
+    {
+    float  a[ 16 ], b[ 16 ], c[ 4 ], q[ 4 ], out[ 16 ];
+    double expected[ 16 ];
+    MathCheck_RandomFloats( 10.0f, 16, a );
+    MathCheck_RandomFloats( 10.0f, 16, b );
+    MathCheck_RandomFloats( 10.0f, 4, c );
+    MathCheck_RandomQuaternion( q );
+
+    /*------------------------------------------------
+    Float3 cross product
+    ------------------------------------------------*/
+    kernels->float3_cross( a, b, out );
+    expected[ 0 ] = (double)a[ 1 ] * b[ 2 ] - (double)a[ 2 ] * b[ 1 ];
+    expected[ 1 ] = (double)a[ 2 ] * b[ 0 ] - (double)a[ 0 ] * b[ 2 ];
+    expected[ 2 ] = (double)a[ 0 ] * b[ 1 ] - (double)a[ 1 ] * b[ 0 ];
+    is_cross_ok &= IsNear( out, expected, 3, 200.0 );
+
+    /*------------------------------------------------
+    Float4 arithmetic
+    ------------------------------------------------*/
+    kernels->float4_add( a, b, out );
+    for( uint32_t j = 0; j < 4; j++ )
+        {
+        expected[ j ] = (double)a[ j ] + b[ j ];
+        }
+
+    is_arith_ok &= IsNear( out, expected, 4, 20.0 );
+
+    kernels->float4_hadamard( a, b, out );
+    for( uint32_t j = 0; j < 4; j++ )
+        {
+        expected[ j ] = (double)a[ j ] * b[ j ];
+        }
+
+    is_arith_ok &= IsNear( out, expected, 4, 100.0 );
+
+    double dot_ab = 0.0;
+    double dot_ac = 0.0;
+    for( uint32_t j = 0; j < 4; j++ )
+        {
+        dot_ab += (double)a[ j ] * b[ j ];
+        dot_ac += (double)a[ j ] * c[ j ];
+        }
+
+    out[ 0 ] = kernels->float4_dot( a, b );
+    is_arith_ok &= IsNear( out, &dot_ab, 1, 400.0 );
+
+    /*------------------------------------------------
+    Triple product B (A . C) - C (A . B)
+    ------------------------------------------------*/
+    kernels->float4_triple( a, b, c, out );
+    for( uint32_t j = 0; j < 4; j++ )
+        {
+        expected[ j ] = b[ j ] * dot_ac - c[ j ] * dot_ab;
+        }
+
+    is_triple_ok &= IsNear( out, expected, 4, 8000.0 );
+
+    /*------------------------------------------------
+    C = A x B, then again with C written over A
+    ------------------------------------------------*/
+    kernels->float4x4_multiply( a, b, out );
+    for( uint32_t row = 0; row < 4; row++ )
+        {
+        for( uint32_t col = 0; col < 4; col++ )
+            {
+            expected[ 4 * row + col ] = 0.0;
+            for( uint32_t k = 0; k < 4; k++ )
+                {
+                expected[ 4 * row + col ] += (double)a[ 4 * row + k ] * b[ 4 * k + col ];
+                }
+            }
+        }
+
+    is_multiply_ok &= IsNear( out, expected, 16, 400.0 );
+
+    float in_place[ 16 ];
+    memcpy( in_place, a, sizeof(in_place) );
+    kernels->float4x4_multiply_in_place( in_place, b );
+    is_alias_ok &= ( memcmp( in_place, out, sizeof(in_place) ) == 0 );
+
+    /*------------------------------------------------
+    Rotation matrix - column j is the rotated axis j
+    ------------------------------------------------*/
+    kernels->quaternion_to_float4x4( q, out );
+    for( uint32_t col = 0; col < 3; col++ )
+        {
+        double axis[ 3 ] = {};
+        double rotated[ 3 ];
+        axis[ col ] = 1.0;
+        ReferenceRotate( q, axis, rotated );
+        for( uint32_t row = 0; row < 3; row++ )
+            {
+            expected[ 4 * row + col ] = rotated[ row ];
+            }
+
+        expected[ 4 * 3 + col ] = 0.0;
+        expected[ 4 * col + 3 ] = 0.0;
+        }
+
+    expected[ 15 ] = 1.0;
+    is_rotation_ok &= IsNear( out, expected, 16, 1.0 );
+
+    /*------------------------------------------------
+    T x R x S - rotated axes scaled, translation in
+    the last column
+    ------------------------------------------------*/
+    kernels->float4x4_transform_spin( a, q, c, out );
+    for( uint32_t col = 0; col < 3; col++ )
+        {
+        for( uint32_t row = 0; row < 3; row++ )
+            {
+            expected[ 4 * row + col ] *= c[ col ];
+            }
+        }
+
+    for( uint32_t row = 0; row < 3; row++ )
+        {
+        expected[ 4 * row + 3 ] = a[ row ];
+        }
+
+    is_spin_ok &= IsNear( out, expected, 16, 10.0 );
+    }
+
+MathCheck_Check( is_cross_ok,    "Float3CrossProduct matches A x B",                  kernels->name );
+MathCheck_Check( is_arith_ok,    "Float4 add, Hadamard and dot match",                kernels->name );
+MathCheck_Check( is_triple_ok,   "Float4TripleProduct matches B (A.C) - C (A.B)",     kernels->name );
+MathCheck_Check( is_multiply_ok, "Float4x4MultiplyByFloat4x4 matches A x B",          kernels->name );
+MathCheck_Check( is_alias_ok,    "Float4x4MultiplyByFloat4x4 allows out == a",        kernels->name );
+MathCheck_Check( is_rotation_ok, "QuaternionToFloat4x4 rotates column vectors",       kernels->name );
+MathCheck_Check( is_spin_ok,     "Float4x4TransformSpin matches T x R x S",           kernels->name );
+
+} /* CheckReferences() */
+
+
+/*******************************************************************
+*
+*   CheckSpots()
+*
+*   DESCRIPTION:
+*       Hand-worked cases for each of the semantic fixes.
+*
+*******************************************************************/
+
+static void CheckSpots( const MathCheckKernels *kernels )
+{
+const float x[ 3 ] = { 1.0f, 0.0f, 0.0f };
+const float y[ 3 ] = { 0.0f, 1.0f, 0.0f };
+const float z[ 3 ] = { 0.0f, 0.0f, 1.0f };
+float  out[ 16 ];
+double expected[ 16 ];
+
+/*----------------------------------------------------
+Right-handed cross product
+----------------------------------------------------*/
+kernels->float3_cross( x, y, out );
+expected[ 0 ] = 0.0; expected[ 1 ] = 0.0; expected[ 2 ] = 1.0;
+MathCheck_Check( IsNear( out, expected, 3, SPOT_TOLERANCE / REFERENCE_TOLERANCE ), "x cross y = z", kernels->name );
+
+kernels->float3_cross( y, z, out );
+expected[ 0 ] = 1.0; expected[ 1 ] = 0.0; expected[ 2 ] = 0.0;
+MathCheck_Check( IsNear( out, expected, 3, SPOT_TOLERANCE / REFERENCE_TOLERANCE ), "y cross z = x", kernels->name );
+
+kernels->float3_cross( z, x, out );
+expected[ 0 ] = 0.0; expected[ 1 ] = 1.0; expected[ 2 ] = 0.0;
+MathCheck_Check( IsNear( out, expected, 3, SPOT_TOLERANCE / REFERENCE_TOLERANCE ), "z cross x = y", kernels->name );
+
+/*----------------------------------------------------
+90 degrees about z takes x to y
+----------------------------------------------------*/
+const float half = (float)sqrt( 0.5 );
+const float about_z[ 4 ] = { 0.0f, 0.0f, half, half };
+kernels->quaternion_to_float4x4( about_z, out );
+const double rotation[ 16 ] =
+    {
+    0.0, -1.0, 0.0, 0.0,
+    1.0,  0.0, 0.0, 0.0,
+    0.0,  0.0, 1.0, 0.0,
+    0.0,  0.0, 0.0, 1.0
+    };
+
+MathCheck_Check( IsNear( out, rotation, 16, SPOT_TOLERANCE / REFERENCE_TOLERANCE ), "90 degrees about z", kernels->name );
+
+/*----------------------------------------------------
+T x S applied to (1, 1, 1) scales, then translates
+----------------------------------------------------*/
+const float translate[ 16 ] =
+    {
+    1.0f, 0.0f, 0.0f, 1.0f,
+    0.0f, 1.0f, 0.0f, 2.0f,
+    0.0f, 0.0f, 1.0f, 3.0f,
+    0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+const float scale[ 16 ] =
+    {
+    2.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 2.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 2.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+kernels->float4x4_multiply( translate, scale, out );
+bool is_order_ok = true;
+for( uint32_t row = 0; row < 3; row++ )
+    {
+    float point = out[ 4 * row + 0 ] + out[ 4 * row + 1 ] + out[ 4 * row + 2 ] + out[ 4 * row + 3 ];
+    is_order_ok &= ( point == 2.0f + translate[ 4 * row + 3 ] );
+    }
+
+MathCheck_Check( is_order_ok, "T x S scales before translating", kernels->name );
+
+/*----------------------------------------------------
+TRS of 90 degrees about z takes (1, 0, 0) to
+t + s.x * y
+----------------------------------------------------*/
+const float t[ 3 ] = { 5.0f, 6.0f, 7.0f };
+const float s[ 3 ] = { 3.0f, 1.0f, 1.0f };
+kernels->float4x4_transform_spin( t, about_z, s, out );
+expected[ 0 ] = 5.0; expected[ 1 ] = 9.0; expected[ 2 ] = 7.0;
+float moved[ 3 ];
+for( uint32_t row = 0; row < 3; row++ )
+    {
+    moved[ row ] = out[ 4 * row + 0 ] + out[ 4 * row + 3 ];
+    }
+
+MathCheck_Check( IsNear( moved, expected, 3, SPOT_TOLERANCE / REFERENCE_TOLERANCE ), "TRS x (1, 0, 0)", kernels->name );
+
+} /* CheckSpots() */
+
+
+/*******************************************************************
+*
+*   IsNear()
+*
+*   DESCRIPTION:
+*       Are the floats within REFERENCE_TOLERANCE of the expected
+*       values, scaled by the size of the terms that made them?
+*
+*******************************************************************/
+
+static bool IsNear( const float *got, const double *expected, const uint32_t count, const double scale )
+{
+for( uint32_t i = 0; i < count; i++ )
+    {
+    if( !( fabs( (double)got[ i ] - expected[ i ] ) <= REFERENCE_TOLERANCE * scale ) )
+        {
+        return( false );
+        }
+    }
+
+return( true );
+
+} /* IsNear() */
+
+
+/*******************************************************************
+*
+*   ReferenceRotate()
+*
+*   DESCRIPTION:
+*       Rotate v by the quaternion, as q v q*, in double precision.
+*       v' = v + 2w (u x v) + 2 u x (u x v), for q = (u, w).
+*
+*******************************************************************/
+
+static void ReferenceRotate( const float *q, const double *v, double *out )
+{
+const double u[ 3 ] = { q[ 0 ], q[ 1 ], q[ 2 ] };
+const double w = q[ 3 ];
+
+double uv[ 3 ];
+uv[ 0 ] = u[ 1 ] * v[ 2 ] - u[ 2 ] * v[ 1 ];
+uv[ 1 ] = u[ 2 ] * v[ 0 ] - u[ 0 ] * v[ 2 ];
+uv[ 2 ] = u[ 0 ] * v[ 1 ] - u[ 1 ] * v[ 0 ];
+
+double uuv[ 3 ];
+uuv[ 0 ] = u[ 1 ] * uv[ 2 ] - u[ 2 ] * uv[ 1 ];
+uuv[ 1 ] = u[ 2 ] * uv[ 0 ] - u[ 0 ] * uv[ 2 ];
+uuv[ 2 ] = u[ 0 ] * uv[ 1 ] - u[ 1 ] * uv[ 0 ];
+
+for( uint32_t i = 0; i < 3; i++ )
+    {
+    out[ i ] = v[ i ] + 2.0 * w * uv[ i ] + 2.0 * uuv[ i ];
+    }
+
+} /* ReferenceRotate() */
+
+
+/*******************************************************************
+*
+*   UlpDistance()
+*
+*   DESCRIPTION:
+*       How many representable floats apart two floats are.
+*
+*******************************************************************/
+
+static uint32_t UlpDistance( const float a, const float b )
+{
+if( a == b )
+    {
+    return( 0 );
+    }
+
+int32_t ia, ib;
+memcpy( &ia, &a, sizeof(ia) );
+memcpy( &ib, &b, sizeof(ib) );
+
+/* order the bit patterns like the values */
+ia = ( ia < 0 ) ? INT32_MIN - ia : ia;
+ib = ( ib < 0 ) ? INT32_MIN - ib : ib;
+
+int64_t distance = (int64_t)ia - (int64_t)ib;
+
+return( (uint32_t)( distance < 0 ? -distance : distance ) );
+
+} /* UlpDistance() */
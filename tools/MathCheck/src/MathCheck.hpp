@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+
+/*******************************************************************
+*
+*   MathCheckProc
+*
+*   DESCRIPTION:
+*       One pass of the timed work.  Returns a value derived from
+*       everything it wrote, so the work can't be optimized away.
+*
+*******************************************************************/
+
+typedef uint64_t MathCheckProc( void *user );
+
+void   MathCheck_Check( const bool is_passed, const char *what, const char *backend );
+void   MathCheck_CheckCollisionBatches( const char *backend );
+void   MathCheck_CheckTransformBatches( const char *backend );
+double MathCheck_NsPerItem( const uint64_t item_count, MathCheckProc *proc, void *user );
+void   MathCheck_RandomFloats( const float range, const uint32_t count, float *out );
+void   MathCheck_RandomQuaternion( float *out );
+void   MathCheck_TimeCollisionBatches( const char *backend );
+void   MathCheck_TimeTransformBatches( const char *backend );
@@ -0,0 +1,817 @@
+/*******************************************************************
+*
+*   MathCheckBatch
+*
+*   DESCRIPTION:
+*       The batched kernels, built for the compiler's vector backend
+*       like the game.  Each must give exactly what the kernel it
+*       batches gives one at a time, so the checks compare bit for
+*       bit, over every tail length and unaligned arrays.  The
+*       collision checks also place boxes exactly touching, and a
+*       float step apart, far from the origin, where the padded tile
+*       bounds of the all pairs tests could cull a real hit.  The
+*       timings report ns per item against the one at a time loop
+*       they replace.
+*
+*******************************************************************/
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Math.hpp"
+#include "MathCheck.hpp"
+
+
+#define TAIL_CHECK_CNT              ( 20 )      /* every tail length under two AVX batches, and then some */
+#define COLLISION_TAIL_CHECK_CNT    ( 70 )      /* every tail length over two hit words */
+#define COLLISION_QUERY_CNT         ( 8 )       /* queries per count */
+#define COLLISION_PAIRS_A_CNT       ( 100 )
+#define COLLISION_PAIRS_B_CNT       ( 150 )
+#define COLLISION_CHECK_RANGE       ( 30.0f )
+#define COLLISION_EDGE_CNT          ( 40 )      /* boxes in the exact touching cases - more than one tile */
+#define COLLISION_EDGE_POSITION     ( 10000.0f )
+#define COLLISION_BATCH_DENSITY     ( 0.01f )   /* boxes per cubic unit, so every count sees some hits */
+#define COLLISION_PAIRS_DENSITY     ( 0.05f )
+#define HIT_WORD_BIT_CNT            ( 32 )
+
+#define hit_word_count( _count ) \
+    ( ( (_count) + HIT_WORD_BIT_CNT - 1 ) / HIT_WORD_BIT_CNT )
+#define HIERARCHY_CHECK_CNT         ( 1000 )    /* a few hierarchy blocks */
+#define HIERARCHY_GROUP_CNT         ( 16 )      /* timed hierarchies are a root and its children */
+
+static const uint32_t TRANSFORM_COUNTS[]       = { 1000, 10000, 100000, 1000000 };
+static const uint32_t COLLISION_BATCH_COUNTS[] = { 1024, 16384, 262144 };
+static const uint32_t COLLISION_PAIRS_COUNTS[] = { 256, 1024, 4096 };
+
+typedef struct _BoxSet
+    {
+    float              *center[ 3 ];        /* columns, for the batches */
+    float              *half_extent[ 3 ];
+    float              *radius;
+    BoundingBoxAA3D    *boxes;              /* the same boxes one by one, for the scalar tests */
+    BoundingBoxSphere3D
+                       *spheres;
+    uint32_t            count;
+    } BoxSet;
+
+typedef struct _CollisionTiming
+    {
+    BoxSet              set;
+    BoundingBoxAA3D     query;
+    uint32_t           *hits;
+    } CollisionTiming;
+
+typedef struct _TransformBatch
+    {
+    Float3             *translation;
+    Quaternion         *rotation;
+    Float3             *scale;
+    uint32_t           *parent;
+    Float4x4           *out;
+    uint32_t            count;
+    } TransformBatch;
+
+
+static BoundingBoxAA3DArray
+                BoxColumns( const BoxSet *set, const uint32_t first );
+static void     DestroyBoxes( BoxSet *set );
+static void     DestroyTransforms( TransformBatch *batch );
+static void     InitBoxes( const uint32_t count, const float range, BoxSet *set );
+static void     InitTransforms( const uint32_t count, TransformBatch *batch );
+static bool     IsAllPairsExact( const BoxSet *a, const BoxSet *b, const bool is_spheres );
+static bool     IsBatchExact( const BoundingBoxAA3D query, const BoxSet *set, const uint32_t first, const bool is_spheres );
+static void     SetBox( const uint32_t index, const float x, const float y, const float z, const float half_extent, BoxSet *set );
+static BoundingBoxSphere3DArray
+                SphereColumns( const BoxSet *set, const uint32_t first );
+static uint64_t SumHits( const uint32_t *hits, const uint32_t word_count );
+static uint64_t SumTransforms( const TransformBatch *batch );
+static uint64_t TimeBoxAllPairs( void *user );
+static uint64_t TimeBoxBatch( void *user );
+static uint64_t TimeBoxPairsSingles( void *user );
+static uint64_t TimeBoxSingles( void *user );
+static uint64_t TimeSphereBatch( void *user );
+static uint64_t TimeSphereSingles( void *user );
+static uint64_t TimeTransformBatch( void *user );
+static uint64_t TimeTransformHierarchy( void *user );
+static uint64_t TimeTransformSingles( void *user );
+
+
+/*******************************************************************
+*
+*   MathCheck_CheckCollisionBatches()
+*
+*******************************************************************/
+
+void MathCheck_CheckCollisionBatches( const char *backend )
+{
+/*----------------------------------------------------
+One box against many - every count over two hit
+words, from one past the start of the columns
+----------------------------------------------------*/
+BoxSet set = {};
+InitBoxes( 1 + COLLISION_TAIL_CHECK_CNT, COLLISION_CHECK_RANGE / 4.0f, &set );
+
+bool is_box_exact    = true;
+bool is_sphere_exact = true;
+for( uint32_t count = 1; count <= COLLISION_TAIL_CHECK_CNT; count++ )
+    {
+    set.count = 1 + count;
+    for( uint32_t i = 0; i < COLLISION_QUERY_CNT; i++ )
+        {
+        BoundingBoxAA3D query = set.boxes[ rand() % set.count ];
+        query.center.v.x += (float)( rand() % 5 ) - 2.0f;
+        is_box_exact    &= IsBatchExact( query, &set, 1, false );
+        is_sphere_exact &= IsBatchExact( query, &set, 1, true );
+        }
+    }
+
+DestroyBoxes( &set );
+MathCheck_Check( is_box_exact,    "Float3CollisionAABBToAABBBatch matches Float3CollisionAABBToAABB",         backend );
+MathCheck_Check( is_sphere_exact, "Float3CollisionAABBToSphereBBBatch matches Float3CollisionAABBToSphereBB", backend );
+
+/*----------------------------------------------------
+All pairs - partial tiles, some culled and some not,
+and a set against itself
+----------------------------------------------------*/
+BoxSet a = {};
+BoxSet b = {};
+InitBoxes( COLLISION_PAIRS_A_CNT, COLLISION_CHECK_RANGE / 8.0f, &a );
+InitBoxes( COLLISION_PAIRS_B_CNT, COLLISION_CHECK_RANGE / 8.0f, &b );
+for( uint32_t i = 0; i < b.count; i++ )
+    {
+    /* sweep b along x, so its tiles are compact and those away from a are culled */
+    float x = 0.5f * COLLISION_CHECK_RANGE * ( 2.0f * (float)i / (float)b.count - 1.0f );
+    b.center[ 0 ][ i ] = b.boxes[ i ].center.v.x = b.spheres[ i ].center.v.x = x;
+    }
+
+MathCheck_Check( IsAllPairsExact( &a, &b, false ), "Float3CollisionAABBToAABBAllPairs matches one pair at a time",     backend );
+MathCheck_Check( IsAllPairsExact( &a, &b, true ),  "Float3CollisionAABBToSphereBBAllPairs matches one pair at a time", backend );
+MathCheck_Check( IsAllPairsExact( &b, &b, false ), "Float3CollisionAABBToAABBAllPairs of a set with itself",           backend );
+DestroyBoxes( &a );
+DestroyBoxes( &b );
+
+/*----------------------------------------------------
+Bounds - far from the origin, box 0 exactly touches
+the last box of the set and misses the one a float
+step further on.  Everything else is out of reach.
+----------------------------------------------------*/
+InitBoxes( 1, 0.0f, &a );
+InitBoxes( COLLISION_EDGE_CNT, 0.0f, &b );
+SetBox( 0, COLLISION_EDGE_POSITION, COLLISION_EDGE_POSITION, COLLISION_EDGE_POSITION, 0.5f, &a );
+for( uint32_t i = 0; i < b.count; i++ )
+    {
+    SetBox( i, -COLLISION_EDGE_POSITION, (float)i, 0.0f, 0.5f, &b );
+    }
+
+SetBox( b.count - 2, nextafterf( COLLISION_EDGE_POSITION + 1.0f, INFINITY ), COLLISION_EDGE_POSITION, COLLISION_EDGE_POSITION, 0.5f, &b );
+SetBox( b.count - 1, COLLISION_EDGE_POSITION + 1.0f, COLLISION_EDGE_POSITION, COLLISION_EDGE_POSITION, 0.5f, &b );
+
+bool is_touch_hit = Math_Float3CollisionAABBToAABB( a.boxes[ 0 ], b.boxes[ b.count - 1 ] )
+                && !Math_Float3CollisionAABBToAABB( a.boxes[ 0 ], b.boxes[ b.count - 2 ] );
+MathCheck_Check( is_touch_hit, "Float3CollisionAABBToAABB hits touching boxes", backend );
+MathCheck_Check( IsBatchExact( a.boxes[ 0 ], &b, 0, false ) && IsBatchExact( a.boxes[ 0 ], &b, 0, true ), "collision batches hit touching boxes", backend );
+MathCheck_Check( IsAllPairsExact( &a, &b, false ) && IsAllPairsExact( &a, &b, true ), "collision all pairs tiles keep touching boxes", backend );
+DestroyBoxes( &a );
+DestroyBoxes( &b );
+
+} /* MathCheck_CheckCollisionBatches() */
+
+
+/*******************************************************************
+*
+*   MathCheck_CheckTransformBatches()
+*
+*******************************************************************/
+
+void MathCheck_CheckTransformBatches( const char *backend )
+{
+/*----------------------------------------------------
+Math_Float4x4TransformSpinBatch() - one past the
+start, so the arrays are off their natural alignment
+----------------------------------------------------*/
+TransformBatch batch = {};
+InitTransforms( 1 + TAIL_CHECK_CNT + 1, &batch );
+
+bool is_batch_exact = true;
+bool is_end_kept    = true;
+for( uint32_t count = 0; count <= TAIL_CHECK_CNT; count++ )
+    {
+    memset( batch.out, 0xcd, batch.count * sizeof(*batch.out) );
+    Float4x4 end = batch.out[ 1 + count ];
+
+    Math_Float4x4TransformSpinBatch( &batch.translation[ 1 ], &batch.rotation[ 1 ], &batch.scale[ 1 ], count, &batch.out[ 1 ] );
+    for( uint32_t i = 1; i <= count; i++ )
+        {
+        Float4x4 expected;
+        Math_Float4x4TransformSpin( batch.translation[ i ], batch.rotation[ i ], batch.scale[ i ], &expected );
+        is_batch_exact &= ( memcmp( &expected, &batch.out[ i ], sizeof(expected) ) == 0 );
+        }
+
+    is_end_kept &= ( memcmp( &end, &batch.out[ 1 + count ], sizeof(end) ) == 0 );
+    }
+
+DestroyTransforms( &batch );
+MathCheck_Check( is_batch_exact, "Float4x4TransformSpinBatch matches Float4x4TransformSpin", backend );
+MathCheck_Check( is_end_kept,    "Float4x4TransformSpinBatch writes only count matrices",   backend );
+
+/*----------------------------------------------------
+Math_Float4x4TransformSpinHierarchy() - random
+parents, across several blocks
+----------------------------------------------------*/
+InitTransforms( HIERARCHY_CHECK_CNT, &batch );
+for( uint32_t i = 0; i < batch.count; i++ )
+    {
+    batch.parent[ i ] = ( i == 0 || rand() % 4 == 0 ) ? MATH_TRANSFORM_NO_PARENT : (uint32_t)rand() % i;
+    }
+
+Math_Float4x4TransformSpinHierarchy( batch.translation, batch.rotation, batch.scale, batch.parent, batch.count, batch.out );
+
+bool is_hierarchy_exact = true;
+Float4x4 *expected = (Float4x4*)malloc( batch.count * sizeof(*expected) );
+for( uint32_t i = 0; i < batch.count; i++ )
+    {
+    Math_Float4x4TransformSpin( batch.translation[ i ], batch.rotation[ i ], batch.scale[ i ], &expected[ i ] );
+    if( batch.parent[ i ] != MATH_TRANSFORM_NO_PARENT )
+        {
+        Math_Float4x4MultiplyByFloat4x4( &expected[ batch.parent[ i ] ], &expected[ i ], &expected[ i ] );
+        }
+
+    is_hierarchy_exact &= ( memcmp( &expected[ i ], &batch.out[ i ], sizeof(expected[ i ]) ) == 0 );
+    }
+
+free( expected );
+DestroyTransforms( &batch );
+MathCheck_Check( is_hierarchy_exact, "Float4x4TransformSpinHierarchy matches parent x local", backend );
+
+} /* MathCheck_CheckTransformBatches() */
+
+
+/*******************************************************************
+*
+*   MathCheck_TimeCollisionBatches()
+*
+*   DESCRIPTION:
+*       Boxes are scattered at a fixed density, so the hit rate
+*       stays about the same as the count grows.
+*
+*******************************************************************/
+
+void MathCheck_TimeCollisionBatches( const char *backend )
+{
+printf( "[%s] one box against many, ns per box\n", backend );
+printf( "  %9s %12s %12s %12s %12s\n", "count", "box single", "box batch", "sphere single", "sphere batch" );
+for( uint32_t i = 0; i < sizeof(COLLISION_BATCH_COUNTS) / sizeof(*COLLISION_BATCH_COUNTS); i++ )
+    {
+    CollisionTiming timing = {};
+    InitBoxes( COLLISION_BATCH_COUNTS[ i ], 0.5f * cbrtf( COLLISION_BATCH_COUNTS[ i ] / COLLISION_BATCH_DENSITY ), &timing.set );
+    timing.query = timing.set.boxes[ 0 ];
+    timing.hits  = (uint32_t*)malloc( hit_word_count( timing.set.count ) * sizeof(*timing.hits) );
+
+    double box_single    = MathCheck_NsPerItem( timing.set.count, TimeBoxSingles, &timing );
+    double box_batch     = MathCheck_NsPerItem( timing.set.count, TimeBoxBatch, &timing );
+    double sphere_single = MathCheck_NsPerItem( timing.set.count, TimeSphereSingles, &timing );
+    double sphere_batch  = MathCheck_NsPerItem( timing.set.count, TimeSphereBatch, &timing );
+    printf( "  %9u %12.2f %12.2f %12.2f %12.2f\n", timing.set.count, box_single, box_batch, sphere_single, sphere_batch );
+
+    free( timing.hits );
+    DestroyBoxes( &timing.set );
+    }
+
+printf( "[%s] all pairs of a set, ns per pair\n", backend );
+printf( "  %9s %12s %12s\n", "count", "single", "all pairs" );
+for( uint32_t i = 0; i < sizeof(COLLISION_PAIRS_COUNTS) / sizeof(*COLLISION_PAIRS_COUNTS); i++ )
+    {
+    CollisionTiming timing = {};
+    InitBoxes( COLLISION_PAIRS_COUNTS[ i ], 0.5f * cbrtf( COLLISION_PAIRS_COUNTS[ i ] / COLLISION_PAIRS_DENSITY ), &timing.set );
+    timing.hits = (uint32_t*)malloc( timing.set.count * hit_word_count( timing.set.count ) * sizeof(*timing.hits) );
+
+    uint64_t pair_count = (uint64_t)timing.set.count * timing.set.count;
+    double single    = MathCheck_NsPerItem( pair_count, TimeBoxPairsSingles, &timing );
+    double all_pairs = MathCheck_NsPerItem( pair_count, TimeBoxAllPairs, &timing );
+    printf( "  %9u %12.2f %12.2f\n", timing.set.count, single, all_pairs );
+
+    free( timing.hits );
+    DestroyBoxes( &timing.set );
+    }
+
+} /* MathCheck_TimeCollisionBatches() */
+
+
+/*******************************************************************
+*
+*   MathCheck_TimeTransformBatches()
+*
+*******************************************************************/
+
+void MathCheck_TimeTransformBatches( const char *backend )
+{
+printf( "[%s] world transforms, ns per transform (millions per second)\n", backend );
+printf( "  %9s %16s %16s %16s\n", "count", "one at a time", "batch", "hierarchy" );
+for( uint32_t i = 0; i < sizeof(TRANSFORM_COUNTS) / sizeof(*TRANSFORM_COUNTS); i++ )
+    {
+    TransformBatch batch = {};
+    InitTransforms( TRANSFORM_COUNTS[ i ], &batch );
+    for( uint32_t j = 0; j < batch.count; j++ )
+        {
+        uint32_t root = j - j % HIERARCHY_GROUP_CNT;
+        batch.parent[ j ] = ( j == root ) ? MATH_TRANSFORM_NO_PARENT : root;
+        }
+
+    double singles   = MathCheck_NsPerItem( batch.count, TimeTransformSingles, &batch );
+    double batched   = MathCheck_NsPerItem( batch.count, TimeTransformBatch, &batch );
+    double hierarchy = MathCheck_NsPerItem( batch.count, TimeTransformHierarchy, &batch );
+    printf( "  %9u %7.2f (%6.1f) %7.2f (%6.1f) %7.2f (%6.1f)\n", batch.count, singles, 1e3 / singles, batched, 1e3 / batched, hierarchy, 1e3 / hierarchy );
+
+    DestroyTransforms( &batch );
+    }
+
+} /* MathCheck_TimeTransformBatches() */
+
+
+/*******************************************************************
+*
+*   BoxColumns()
+*
+*******************************************************************/
+
+static BoundingBoxAA3DArray BoxColumns( const BoxSet *set, const uint32_t first )
+{
+BoundingBoxAA3DArray ret;
+for( uint32_t i = 0; i < 3; i++ )
+    {
+    ret.center[ i ]      = &set->center[ i ][ first ];
+    ret.half_extent[ i ] = &set->half_extent[ i ][ first ];
+    }
+
+ret.count = set->count - first;
+
+return( ret );
+
+} /* BoxColumns() */
+
+
+/*******************************************************************
+*
+*   DestroyBoxes()
+*
+*******************************************************************/
+
+static void DestroyBoxes( BoxSet *set )
+{
+for( uint32_t i = 0; i < 3; i++ )
+    {
+    free( set->center[ i ] );
+    free( set->half_extent[ i ] );
+    }
+
+free( set->radius );
+free( set->boxes );
+free( set->spheres );
+*set = {};
+
+} /* DestroyBoxes() */
+
+
+/*******************************************************************
+*
+*   DestroyTransforms()
+*
+*******************************************************************/
+
+static void DestroyTransforms( TransformBatch *batch )
+{
+free( batch->translation );
+free( batch->rotation );
+free( batch->scale );
+free( batch->parent );
+free( batch->out );
+*batch = {};
+
+} /* DestroyTransforms() */
+
+
+/*******************************************************************
+*
+*   InitBoxes()
+*
+*   DESCRIPTION:
+*       Boxes (and spheres of the same centers) scattered through a
+*       cube of half width range, sized 0.2 to 2 a side.
+*
+*******************************************************************/
+
+static void InitBoxes( const uint32_t count, const float range, BoxSet *set )
+{
+for( uint32_t i = 0; i < 3; i++ )
+    {
+    set->center[ i ]      = (float*)malloc( count * sizeof(*set->center[ i ]) );
+    set->half_extent[ i ] = (float*)malloc( count * sizeof(*set->half_extent[ i ]) );
+    }
+
+set->radius  = (float*)malloc( count * sizeof(*set->radius) );
+set->boxes   = (BoundingBoxAA3D*)malloc( count * sizeof(*set->boxes) );
+set->spheres = (BoundingBoxSphere3D*)malloc( count * sizeof(*set->spheres) );
+set->count   = count;
+
+for( uint32_t i = 0; i < count; i++ )
+    {
+    float center[ 3 ];
+    float half_extent[ 4 ];
+    MathCheck_RandomFloats( range, 3, center );
+    MathCheck_RandomFloats( 0.45f, 4, half_extent );
+    SetBox( i, center[ 0 ], center[ 1 ], center[ 2 ], 0.55f + half_extent[ 3 ], set );
+    for( uint32_t j = 0; j < 3; j++ )
+        {
+        set->half_extent[ j ][ i ] = set->boxes[ i ].half_extent.f[ j ] = 0.55f + half_extent[ j ];
+        }
+    }
+
+} /* InitBoxes() */
+
+
+/*******************************************************************
+*
+*   InitTransforms()
+*
+*   DESCRIPTION:
+*       Random translations, rotations and scales, with no parents.
+*
+*******************************************************************/
+
+static void InitTransforms( const uint32_t count, TransformBatch *batch )
+{
+batch->translation = (Float3*)malloc( count * sizeof(*batch->translation) );
+batch->rotation    = (Quaternion*)malloc( count * sizeof(*batch->rotation) );
+batch->scale       = (Float3*)malloc( count * sizeof(*batch->scale) );
+batch->parent      = (uint32_t*)malloc( count * sizeof(*batch->parent) );
+batch->out         = (Float4x4*)malloc( count * sizeof(*batch->out) );
+batch->count       = count;
+
+for( uint32_t i = 0; i < count; i++ )
+    {
+    MathCheck_RandomFloats( 100.0f, 3, batch->translation[ i ].f );
+    MathCheck_RandomQuaternion( batch->rotation[ i ].f );
+    MathCheck_RandomFloats( 4.0f, 3, batch->scale[ i ].f );
+    batch->parent[ i ] = MATH_TRANSFORM_NO_PARENT;
+    }
+
+} /* InitTransforms() */
+
+
+/*******************************************************************
+*
+*   IsAllPairsExact()
+*
+*   DESCRIPTION:
+*       Does the all pairs test of a against b (boxes or spheres)
+*       match testing each pair on its own?
+*
+*******************************************************************/
+
+static bool IsAllPairsExact( const BoxSet *a, const BoxSet *b, const bool is_spheres )
+{
+uint32_t  row_words = hit_word_count( b->count );
+uint32_t *hits      = (uint32_t*)malloc( a->count * row_words * sizeof(*hits) );
+memset( hits, 0xcd, a->count * row_words * sizeof(*hits) );
+
+BoundingBoxAA3DArray a_columns = BoxColumns( a, 0 );
+if( is_spheres )
+    {
+    BoundingBoxSphere3DArray b_columns = SphereColumns( b, 0 );
+    Math_Float3CollisionAABBToSphereBBAllPairs( &a_columns, &b_columns, hits );
+    }
+else
+    {
+    BoundingBoxAA3DArray b_columns = BoxColumns( b, 0 );
+    Math_Float3CollisionAABBToAABBAllPairs( &a_columns, &b_columns, hits );
+    }
+
+bool ret = true;
+for( uint32_t i = 0; i < a->count; i++ )
+    {
+    for( uint32_t j = 0; j < row_words * HIT_WORD_BIT_CNT; j++ )
+        {
+        bool is_hit = ( j < b->count )
+                   && ( is_spheres ? Math_Float3CollisionAABBToSphereBB( a->boxes[ i ], b->spheres[ j ] ) : Math_Float3CollisionAABBToAABB( a->boxes[ i ], b->boxes[ j ] ) );
+        ret &= ( is_hit == ( ( hits[ i * row_words + j / HIT_WORD_BIT_CNT ] >> ( j % HIT_WORD_BIT_CNT ) ) & 1 ) );
+        }
+    }
+
+free( hits );
+
+return( ret );
+
+} /* IsAllPairsExact() */
+
+
+/*******************************************************************
+*
+*   IsBatchExact()
+*
+*   DESCRIPTION:
+*       Does the batch test of the query against the set (boxes or
+*       spheres), starting at first, match testing each on its own?
+*       Bits past the end of the set must be clear.
+*
+*******************************************************************/
+
+static bool IsBatchExact( const BoundingBoxAA3D query, const BoxSet *set, const uint32_t first, const bool is_spheres )
+{
+uint32_t  count = set->count - first;
+uint32_t *hits  = (uint32_t*)malloc( hit_word_count( count ) * sizeof(*hits) );
+memset( hits, 0xcd, hit_word_count( count ) * sizeof(*hits) );
+
+if( is_spheres )
+    {
+    BoundingBoxSphere3DArray columns = SphereColumns( set, first );
+    Math_Float3CollisionAABBToSphereBBBatch( query, &columns, hits );
+    }
+else
+    {
+    BoundingBoxAA3DArray columns = BoxColumns( set, first );
+    Math_Float3CollisionAABBToAABBBatch( query, &columns, hits );
+    }
+
+bool ret = true;
+for( uint32_t i = 0; i < hit_word_count( count ) * HIT_WORD_BIT_CNT; i++ )
+    {
+    bool is_hit = ( i < count )
+               && ( is_spheres ? Math_Float3CollisionAABBToSphereBB( query, set->spheres[ first + i ] ) : Math_Float3CollisionAABBToAABB( query, set->boxes[ first + i ] ) );
+    ret &= ( is_hit == ( ( hits[ i / HIT_WORD_BIT_CNT ] >> ( i % HIT_WORD_BIT_CNT ) ) & 1 ) );
+    }
+
+free( hits );
+
+return( ret );
+
+} /* IsBatchExact() */
+
+
+/*******************************************************************
+*
+*   SetBox()
+*
+*   DESCRIPTION:
+*       Place a cube, and the sphere of the same radius, at the
+*       given index of the set.
+*
+*******************************************************************/
+
+static void SetBox( const uint32_t index, const float x, const float y, const float z, const float half_extent, BoxSet *set )
+{
+const float center[ 3 ] = { x, y, z };
+for( uint32_t i = 0; i < 3; i++ )
+    {
+    set->center[ i ][ index ]      = center[ i ];
+    set->half_extent[ i ][ index ] = half_extent;
+    set->boxes[ index ].center.f[ i ]      = center[ i ];
+    set->boxes[ index ].half_extent.f[ i ] = half_extent;
+    set->spheres[ index ].center.f[ i ]    = center[ i ];
+    }
+
+set->radius[ index ]          = half_extent;
+set->spheres[ index ].radius = half_extent;
+
+} /* SetBox() */
+
+
+/*******************************************************************
+*
+*   SphereColumns()
+*
+*******************************************************************/
+
+static BoundingBoxSphere3DArray SphereColumns( const BoxSet *set, const uint32_t first )
+{
+BoundingBoxSphere3DArray ret;
+for( uint32_t i = 0; i < 3; i++ )
+    {
+    ret.center[ i ] = &set->center[ i ][ first ];
+    }
+
+ret.radius = &set->radius[ first ];
+ret.count  = set->count - first;
+
+return( ret );
+
+} /* SphereColumns() */
+
+
+/*******************************************************************
+*
+*   SumHits()
+*
+*******************************************************************/
+
+static uint64_t SumHits( const uint32_t *hits, const uint32_t word_count )
+{
+uint64_t sum = 0;
+for( uint32_t i = 0; i < word_count; i += 16 )
+    {
+    sum += hits[ i ];
+    }
+
+return( sum );
+
+} /* SumHits() */
+
+
+/*******************************************************************
+*
+*   SumTransforms()
+*
+*   DESCRIPTION:
+*       Fold the output translations, so the timed work is kept.
+*
+*******************************************************************/
+
+static uint64_t SumTransforms( const TransformBatch *batch )
+{
+float sum = 0.0f;
+for( uint32_t i = 0; i < batch->count; i += 64 )
+    {
+    sum += batch->out[ i ].n._14;
+    }
+
+return( (uint64_t)(int64_t)sum );
+
+} /* SumTransforms() */
+
+
+/*******************************************************************
+*
+*   TimeBoxAllPairs()
+*
+*******************************************************************/
+
+static uint64_t TimeBoxAllPairs( void *user )
+{
+CollisionTiming     *timing  = (CollisionTiming*)user;
+BoundingBoxAA3DArray columns = BoxColumns( &timing->set, 0 );
+Math_Float3CollisionAABBToAABBAllPairs( &columns, &columns, timing->hits );
+
+return( SumHits( timing->hits, timing->set.count * hit_word_count( timing->set.count ) ) );
+
+} /* TimeBoxAllPairs() */
+
+
+/*******************************************************************
+*
+*   TimeBoxBatch()
+*
+*******************************************************************/
+
+static uint64_t TimeBoxBatch( void *user )
+{
+CollisionTiming     *timing  = (CollisionTiming*)user;
+BoundingBoxAA3DArray columns = BoxColumns( &timing->set, 0 );
+Math_Float3CollisionAABBToAABBBatch( timing->query, &columns, timing->hits );
+
+return( SumHits( timing->hits, hit_word_count( timing->set.count ) ) );
+
+} /* TimeBoxBatch() */
+
+
+/*******************************************************************
+*
+*   TimeBoxPairsSingles()
+*
+*******************************************************************/
+
+static uint64_t TimeBoxPairsSingles( void *user )
+{
+CollisionTiming *timing    = (CollisionTiming*)user;
+uint32_t         row_words = hit_word_count( timing->set.count );
+memset( timing->hits, 0, timing->set.count * row_words * sizeof(*timing->hits) );
+for( uint32_t i = 0; i < timing->set.count; i++ )
+    {
+    uint32_t *row = &timing->hits[ i * row_words ];
+    for( uint32_t j = 0; j < timing->set.count; j++ )
+        {
+        if( Math_Float3CollisionAABBToAABB( timing->set.boxes[ i ], timing->set.boxes[ j ] ) )
+            {
+            Math_BitArraySet( row, j );
+            }
+        }
+    }
+
+return( SumHits( timing->hits, timing->set.count * row_words ) );
+
+} /* TimeBoxPairsSingles() */
+
+
+/*******************************************************************
+*
+*   TimeBoxSingles()
+*
+*******************************************************************/
+
+static uint64_t TimeBoxSingles( void *user )
+{
+CollisionTiming *timing = (CollisionTiming*)user;
+memset( timing->hits, 0, hit_word_count( timing->set.count ) * sizeof(*timing->hits) );
+for( uint32_t i = 0; i < timing->set.count; i++ )
+    {
+    if( Math_Float3CollisionAABBToAABB( timing->query, timing->set.boxes[ i ] ) )
+        {
+        Math_BitArraySet( timing->hits, i );
+        }
+    }
+
+return( SumHits( timing->hits, hit_word_count( timing->set.count ) ) );
+
+} /* TimeBoxSingles() */
+
+
+/*******************************************************************
+*
+*   TimeSphereBatch()
+*
+*******************************************************************/
+
+static uint64_t TimeSphereBatch( void *user )
+{
+CollisionTiming         *timing  = (CollisionTiming*)user;
+BoundingBoxSphere3DArray columns = SphereColumns( &timing->set, 0 );
+Math_Float3CollisionAABBToSphereBBBatch( timing->query, &columns, timing->hits );
+
+return( SumHits( timing->hits, hit_word_count( timing->set.count ) ) );
+
+} /* TimeSphereBatch() */
+
+
+/*******************************************************************
+*
+*   TimeSphereSingles()
+*
+*******************************************************************/
+
+static uint64_t TimeSphereSingles( void *user )
+{
+CollisionTiming *timing = (CollisionTiming*)user;
+memset( timing->hits, 0, hit_word_count( timing->set.count ) * sizeof(*timing->hits) );
+for( uint32_t i = 0; i < timing->set.count; i++ )
+    {
+    if( Math_Float3CollisionAABBToSphereBB( timing->query, timing->set.spheres[ i ] ) )
+        {
+        Math_BitArraySet( timing->hits, i );
+        }
+    }
+
+return( SumHits( timing->hits, hit_word_count( timing->set.count ) ) );
+
+} /* TimeSphereSingles() */
+
+
+/*******************************************************************
+*
+*   TimeTransformBatch()
+*
+*******************************************************************/
+
+static uint64_t TimeTransformBatch( void *user )
+{
+TransformBatch *batch = (TransformBatch*)user;
+Math_Float4x4TransformSpinBatch( batch->translation, batch->rotation, batch->scale, batch->count, batch->out );
+
+return( SumTransforms( batch ) );
+
+} /* TimeTransformBatch() */
+
+
+/*******************************************************************
+*
+*   TimeTransformHierarchy()
+*
+*******************************************************************/
+
+static uint64_t TimeTransformHierarchy( void *user )
+{
+TransformBatch *batch = (TransformBatch*)user;
+Math_Float4x4TransformSpinHierarchy( batch->translation, batch->rotation, batch->scale, batch->parent, batch->count, batch->out );
+
+return( SumTransforms( batch ) );
+
+} /* TimeTransformHierarchy() */
+
+
+/*******************************************************************
+*
+*   TimeTransformSingles()
+*
+*******************************************************************/
+
+static uint64_t TimeTransformSingles( void *user )
+{
+TransformBatch *batch = (TransformBatch*)user;
+for( uint32_t i = 0; i < batch->count; i++ )
+    {
+    Math_Float4x4TransformSpin( batch->translation[ i ], batch->rotation[ i ], batch->scale[ i ], &batch->out[ i ] );
+    }
+
+return( SumTransforms( batch ) );
+
+} /* TimeTransformSingles() */
@@ -0,0 +1,35 @@
+#pragma once
+
+
+/*******************************************************************
+*
+*   MathCheckKernels
+*
+*   DESCRIPTION:
+*       The inline math operations of one backend, behind plain
+*       float arrays so the scalar and vector builds (whose Float4
+*       types differ) can be called from the same program.  Each
+*       table is filled by a translation unit built for that
+*       backend.
+*
+*******************************************************************/
+
+typedef struct _MathCheckKernels
+    {
+    const char         *name;
+    void              (*float3_cross)( const float *a, const float *b, float *out );
+    void              (*float4_add)( const float *a, const float *b, float *out );
+    void              (*float4_hadamard)( const float *a, const float *b, float *out );
+    void              (*float4_scale)( const float *a, const float scalar, float *out );
+    float             (*float4_dot)( const float *a, const float *b );
+    float             (*float4_angle)( const float *a, const float *b );
+    void              (*float4_triple)( const float *a, const float *b, const float *c, float *out );
+    void              (*float4x4_multiply)( const float *a, const float *b, float *out );
+    void              (*float4x4_multiply_in_place)( float *a, const float *b );
+    void              (*quaternion_to_float4x4)( const float *q, float *out );
+    void              (*float4x4_transform_spin)( const float *t, const float *q, const float *s, float *out );
+    } MathCheckKernels;
+
+
+void MathCheck_GetScalarKernels( MathCheckKernels *out );
+void MathCheck_GetVectorKernels( MathCheckKernels *out );
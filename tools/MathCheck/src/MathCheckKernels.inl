@@ -0,0 +1,173 @@
+/*******************************************************************
+*
+*   MathCheckKernels.inl
+*
+*   DESCRIPTION:
+*       Wrappers around the inline math, included once per backend.
+*       The including file picks the backend (MATH_SCALAR or not)
+*       and names the table getter with MATH_CHECK_GET_KERNELS.
+*
+*******************************************************************/
+
+#include <cstring>
+
+#include "Math.hpp"
+#include "MathCheckKernels.hpp"
+
+
+static void Float3Cross( const float *a, const float *b, float *out )
+{
+Float3 A, B;
+memcpy( A.f, a, sizeof(A.f) );
+memcpy( B.f, b, sizeof(B.f) );
+
+Float3 ret = Math_Float3CrossProduct( A, B );
+memcpy( out, ret.f, sizeof(ret.f) );
+
+} /* Float3Cross() */
+
+
+static void Float4Add( const float *a, const float *b, float *out )
+{
+Float4 A, B;
+memcpy( A.f, a, sizeof(A.f) );
+memcpy( B.f, b, sizeof(B.f) );
+
+Float4 ret = Math_Float4Addition( A, B );
+memcpy( out, ret.f, sizeof(ret.f) );
+
+} /* Float4Add() */
+
+
+static void Float4Hadamard( const float *a, const float *b, float *out )
+{
+Float4 A, B;
+memcpy( A.f, a, sizeof(A.f) );
+memcpy( B.f, b, sizeof(B.f) );
+
+Float4 ret = Math_Float4HadamardProduct( A, B );
+memcpy( out, ret.f, sizeof(ret.f) );
+
+} /* Float4Hadamard() */
+
+
+static void Float4Scale( const float *a, const float scalar, float *out )
+{
+Float4 A;
+memcpy( A.f, a, sizeof(A.f) );
+
+Float4 ret = Math_Float4ScalarMultiply( A, scalar );
+memcpy( out, ret.f, sizeof(ret.f) );
+
+} /* Float4Scale() */
+
+
+static float Float4Dot( const float *a, const float *b )
+{
+Float4 A, B;
+memcpy( A.f, a, sizeof(A.f) );
+memcpy( B.f, b, sizeof(B.f) );
+
+return( Math_Float4DotProduct( A, B ) );
+
+} /* Float4Dot() */
+
+
+static float Float4Angle( const float *a, const float *b )
+{
+Float4 A, B;
+memcpy( A.f, a, sizeof(A.f) );
+memcpy( B.f, b, sizeof(B.f) );
+
+return( Math_Float4AngleBetween( A, B ) );
+
+} /* Float4Angle() */
+
+
+static void Float4Triple( const float *a, const float *b, const float *c, float *out )
+{
+Float4 A, B, C;
+memcpy( A.f, a, sizeof(A.f) );
+memcpy( B.f, b, sizeof(B.f) );
+memcpy( C.f, c, sizeof(C.f) );
+
+Float4 ret = Math_Float4TripleProduct( A, B, C );
+memcpy( out, ret.f, sizeof(ret.f) );
+
+} /* Float4Triple() */
+
+
+static void Float4x4Multiply( const float *a, const float *b, float *out )
+{
+Float4x4 A, B, ret;
+memcpy( A.f, a, sizeof(A.f) );
+memcpy( B.f, b, sizeof(B.f) );
+
+Math_Float4x4MultiplyByFloat4x4( &A, &B, &ret );
+memcpy( out, ret.f, sizeof(ret.f) );
+
+} /* Float4x4Multiply() */
+
+
+static void Float4x4MultiplyInPlace( float *a, const float *b )
+{
+Float4x4 A, B;
+memcpy( A.f, a, sizeof(A.f) );
+memcpy( B.f, b, sizeof(B.f) );
+
+Math_Float4x4MultiplyByFloat4x4( &A, &B, &A );
+memcpy( a, A.f, sizeof(A.f) );
+
+} /* Float4x4MultiplyInPlace() */
+
+
+static void QuaternionToFloat4x4( const float *q, float *out )
+{
+Quaternion Q;
+memcpy( Q.f, q, sizeof(Q.f) );
+
+Float4x4 ret;
+Math_QuaternionToFloat4x4( Q, &ret );
+memcpy( out, ret.f, sizeof(ret.f) );
+
+} /* QuaternionToFloat4x4() */
+
+
+static void Float4x4TransformSpin( const float *t, const float *q, const float *s, float *out )
+{
+Float3 T, S;
+Quaternion Q;
+memcpy( T.f, t, sizeof(T.f) );
+memcpy( Q.f, q, sizeof(Q.f) );
+memcpy( S.f, s, sizeof(S.f) );
+
+Float4x4 ret;
+Math_Float4x4TransformSpin( T, Q, S, &ret );
+memcpy( out, ret.f, sizeof(ret.f) );
+
+} /* Float4x4TransformSpin() */
+
+
+void MATH_CHECK_GET_KERNELS( MathCheckKernels *out )
+{
+#if defined( MATH_USE_AVX )
+out->name = "avx";
+#elif defined( MATH_USE_SSE4 )
+out->name = "sse4.1";
+#else
+out->name = "scalar";
+#endif
+
+out->float3_cross               = Float3Cross;
+out->float4_add                 = Float4Add;
+out->float4_hadamard            = Float4Hadamard;
+out->float4_scale               = Float4Scale;
+out->float4_dot                 = Float4Dot;
+out->float4_angle               = Float4Angle;
+out->float4_triple              = Float4Triple;
+out->float4x4_multiply          = Float4x4Multiply;
+out->float4x4_multiply_in_place = Float4x4MultiplyInPlace;
+out->quaternion_to_float4x4     = QuaternionToFloat4x4;
+out->float4x4_transform_spin    = Float4x4TransformSpin;
+
+} /* MATH_CHECK_GET_KERNELS() */
@@ -0,0 +1,5 @@
+/* the reference build - scalar whatever the compiler targets */
+#define MATH_SCALAR
+#define MATH_CHECK_GET_KERNELS      MathCheck_GetScalarKernels
+
+#include "MathCheckKernels.inl"
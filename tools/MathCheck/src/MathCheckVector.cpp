@@ -0,0 +1,4 @@
+/* the backend Math.hpp picks for the compiler's target */
+#define MATH_CHECK_GET_KERNELS      MathCheck_GetVectorKernels
+
+#include "MathCheckKernels.inl"
@@ -0,0 +1,552 @@
+/*******************************************************************
+*
+*   StreamBench
+*
+*   DESCRIPTION:
+*       Runs the streaming loader (src/utils/StreamLoader.cpp)
+*       against a real file, the way the game streams assets: a
+*       frame loop keeps REQUEST_DEPTH_CNT requests outstanding,
+*       polls with a per-frame byte budget like the staging ring,
+*       now and then declines a payload as if staging were full,
+*       and cancels or reprioritizes requests still in flight.
+*
+*       Requests are 4 KiB - 1 MiB, log-uniform, at random 4 KiB
+*       aligned offsets of a DATA_FILE_SIZE file written first.  The
+*       same workload runs at several read depths, printing the
+*       throughput and latency percentiles of each, then the full
+*       latency and throughput histograms at the default depth.
+*       The file was just written, so reads mostly come from the
+*       page cache - evict it to measure the disk instead.
+*
+*       Every payload is checked against the pattern the file was
+*       written with, and every request must be delivered exactly
+*       once, canceled if the cancel took and READY otherwise.  One
+*       request per run straddles the end of the file and must fail.
+*       Returns zero if every check passes.
+*
+*       Build from this directory, e.g.
+*           g++ -std=c++17 -O2 -I../../../src -I../../../src/utils *.cpp
+*               ../../../src/utils/StreamLoader.cpp ../../../src/utils/Utilities.cpp -lpthread
+*
+*       Run with the data file's path, or it is written to
+*       StreamBench.bin in the current directory.  It is removed
+*       when the runs finish.
+*
+*******************************************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "Global.hpp"
+#include "StreamLoader.hpp"
+#include "Utilities.hpp"
+
+
+#define DATA_FILE_SIZE              ( 64ull * 1024 * 1024 )
+#define DEFAULT_DATA_FILE_PATH      "StreamBench.bin"
+#define REQUEST_CNT                 ( 4000 )    /* per run */
+#define REQUEST_DEPTH_CNT           ( 64 )      /* outstanding at once */
+#define REQUEST_ALIGNMENT           ( 4096 )
+#define MIN_REQUEST_SHIFT           ( 12 )      /* 4 KiB */
+#define MAX_REQUEST_SHIFT           ( 20 )      /* 1 MiB, exclusive */
+#define FRAME_BYTE_BUDGET           ( 8 * 1024 * 1024 )
+#define FRAME_SLEEP_US              ( 100 )     /* when a frame had nothing to deliver */
+#define CANCEL_ONE_IN               ( 16 )      /* frames */
+#define REPRIORITIZE_ONE_IN         ( 4 )       /* frames */
+#define DECLINE_ONE_IN              ( 64 )      /* payloads */
+#define PRIORITY_CNT                ( 4 )
+#define CHECK_STRIDE                ( 61 )      /* checking every byte would swamp the consumer */
+#define HISTOGRAM_BAR               "##################################################"
+
+static const uint32_t READ_DEPTHS[] = { 1, 4, STREAM_LOADER_DEFAULT_READ_DEPTH, STREAM_LOADER_MAX_READ_DEPTH };
+
+typedef struct _BenchRequest
+    {
+    StreamLoaderHandle  handle;
+    uint64_t            offset;
+    uint32_t            size;
+    bool                is_used;
+    bool                is_canceled;    /* StreamLoader_Cancel() took it */
+    bool                is_past_end;    /* must fail */
+    } BenchRequest;
+
+typedef struct _BenchRun
+    {
+    BenchRequest        requests[ REQUEST_DEPTH_CNT ];
+    uint32_t            outstanding_cnt;
+    uint64_t            canceled_cnt;
+    uint64_t            declined_cnt;
+    uint64_t            delivered_bytes;
+    bool                is_data_ok;
+    bool                is_status_ok;
+    } BenchRun;
+
+typedef struct _CheckCounts
+    {
+    uint32_t            passed;
+    uint32_t            failed;
+    } CheckCounts;
+
+static CheckCounts  s_counts;
+static uint32_t     s_random_state = 0x2545f491;
+static BenchRun     s_run;
+
+
+static void     Check( const bool is_passed, const char *what );
+static bool     Deliver( const StreamLoaderHandle handle, const StreamLoaderStatus status, const void *data, const uint32_t size, void *user );
+static uint8_t  PatternByte( const uint64_t offset );
+static void     PrintHistogram( const char *name, const StreamLoaderHistogram *histogram );
+static uint32_t Random( void );
+static void     RunDepth( const char *file_path, const uint32_t read_depth, StreamLoaderStats *out );
+static bool     WriteDataFile( const char *file_path );
+
+
+/*******************************************************************
+*
+*   main()
+*
+*******************************************************************/
+
+int main( int argc, char **argv )
+{
+const char *file_path = ( argc > 1 ) ? argv[ 1 ] : DEFAULT_DATA_FILE_PATH;
+if( !WriteDataFile( file_path ) )
+    {
+    printf( "FAILED to write %s\n", file_path );
+    return( EXIT_FAILURE );
+    }
+
+printf( "%u requests of 4 KiB - 1 MiB per run, %u outstanding, %u MiB poll budget, latencies in us\n", REQUEST_CNT, REQUEST_DEPTH_CNT, FRAME_BYTE_BUDGET / ( 1024 * 1024 ) );
+printf( "%5s %8s %8s %8s %8s %8s %8s %8s %8s\n", "depth", "MiB/s", "busy", "lat p50", "lat p90", "lat p99", "lat max", "read p50", "read p99" );
+
+StreamLoaderStats default_stats = {};
+for( uint32_t i = 0; i < cnt_of_array( READ_DEPTHS ); i++ )
+    {
+    StreamLoaderStats stats = {};
+    RunDepth( file_path, READ_DEPTHS[ i ], &stats );
+    if( READ_DEPTHS[ i ] == STREAM_LOADER_DEFAULT_READ_DEPTH )
+        {
+        default_stats = stats;
+        }
+    }
+
+remove( file_path );
+
+const char *backend = "blocking";
+switch( default_stats.backend )
+    {
+    case STREAM_LOADER_BACKEND_IO_URING:
+        backend = "io_uring";
+        break;
+
+    case STREAM_LOADER_BACKEND_OVERLAPPED:
+        backend = "overlapped";
+        break;
+
+    default:
+        break;
+    }
+
+printf( "\nread depth %u: %s backend, landing memory %s, %llu delivered, %llu canceled, %llu failed, %.1f MiB read\n",
+        STREAM_LOADER_DEFAULT_READ_DEPTH,
+        backend,
+        default_stats.is_landing_pinned ? "pinned" : "not pinned",
+        (unsigned long long)default_stats.delivered_count,
+        (unsigned long long)default_stats.canceled_count,
+        (unsigned long long)default_stats.failed_count,
+        (double)default_stats.bytes_read / ( 1024.0 * 1024.0 ) );
+PrintHistogram( "latency, submit to delivered (us)", &default_stats.latency_us );
+PrintHistogram( "queued, submit to read issued (us)", &default_stats.queue_us );
+PrintHistogram( "read, issued to finished (us)", &default_stats.read_us );
+PrintHistogram( "throughput per read (KiB/s)", &default_stats.throughput_kbps );
+
+printf( "%u passed, %u failed\n", s_counts.passed, s_counts.failed );
+
+return( s_counts.failed ? EXIT_FAILURE : EXIT_SUCCESS );
+
+} /* main() */
+
+
+/*******************************************************************
+*
+*   Check()
+*
+*   DESCRIPTION:
+*       Count a check, and report it if it failed.
+*
+*******************************************************************/
+
+static void Check( const bool is_passed, const char *what )
+{
+if( is_passed )
+    {
+    s_counts.passed++;
+    return;
+    }
+
+s_counts.failed++;
+printf( "FAILED %s\n", what );
+
+} /* Check() */
+
+
+/*******************************************************************
+*
+*   Deliver()
+*
+*   DESCRIPTION:
+*       The requests' done proc.  Checks the request was delivered
+*       with the status it was left in, and its payload against the
+*       file's pattern.  Declines the odd payload, like a full
+*       staging ring would, so it is delivered again.
+*
+*******************************************************************/
+
+static bool Deliver( const StreamLoaderHandle handle, const StreamLoaderStatus status, const void *data, const uint32_t size, void *user )
+{
+BenchRequest *request = (BenchRequest*)user;
+if( !request->is_used
+ || request->handle != handle
+ || request->size != size )
+    {
+    s_run.is_status_ok = false;
+    }
+
+switch( status )
+    {
+    case STREAM_LOADER_STATUS_READY:
+        if( request->is_canceled
+         || request->is_past_end
+         || !data )
+            {
+            s_run.is_status_ok = false;
+            break;
+            }
+
+        if( Random() % DECLINE_ONE_IN == 0 )
+            {
+            s_run.declined_cnt++;
+            return( false );
+            }
+
+        for( uint32_t i = 0; i < size; i += CHECK_STRIDE )
+            {
+            if( ( (const uint8_t*)data )[ i ] != PatternByte( request->offset + i ) )
+                {
+                s_run.is_data_ok = false;
+                break;
+                }
+            }
+
+        if( ( (const uint8_t*)data )[ size - 1 ] != PatternByte( request->offset + size - 1 ) )
+            {
+            s_run.is_data_ok = false;
+            }
+
+        s_run.delivered_bytes += size;
+        break;
+
+    case STREAM_LOADER_STATUS_CANCELED:
+        if( !request->is_canceled )
+            {
+            s_run.is_status_ok = false;
+            }
+        break;
+
+    default:
+        if( request->is_canceled
+         || !request->is_past_end )
+            {
+            s_run.is_status_ok = false;
+            }
+        break;
+    }
+
+request->is_used = false;
+s_run.outstanding_cnt--;
+
+return( true );
+
+} /* Deliver() */
+
+
+/*******************************************************************
+*
+*   PatternByte()
+*
+*   DESCRIPTION:
+*       The data file's byte at the given offset.
+*
+*******************************************************************/
+
+static uint8_t PatternByte( const uint64_t offset )
+{
+return( (uint8_t)( ( offset * 2654435761ull ) >> 13 ) );
+
+} /* PatternByte() */
+
+
+/*******************************************************************
+*
+*   PrintHistogram()
+*
+*   DESCRIPTION:
+*       Print a histogram's percentiles, then a bar per bucket from
+*       the first used bucket to the last.
+*
+*******************************************************************/
+
+static void PrintHistogram( const char *name, const StreamLoaderHistogram *histogram )
+{
+printf( "\n%s: %llu samples, mean %llu, p50 %llu, p90 %llu, p99 %llu, max %llu\n",
+        name,
+        (unsigned long long)histogram->sample_count,
+        (unsigned long long)( histogram->sample_count ? histogram->sum / histogram->sample_count : 0 ),
+        (unsigned long long)StreamLoader_HistogramPercentile( histogram, 0.50f ),
+        (unsigned long long)StreamLoader_HistogramPercentile( histogram, 0.90f ),
+        (unsigned long long)StreamLoader_HistogramPercentile( histogram, 0.99f ),
+        (unsigned long long)histogram->max );
+
+uint32_t first = cnt_of_array( histogram->counts );
+uint32_t last  = 0;
+uint64_t peak  = 0;
+for( uint32_t i = 0; i < cnt_of_array( histogram->counts ); i++ )
+    {
+    if( histogram->counts[ i ] )
+        {
+        first = min_of_vals( first, i );
+        last  = i;
+        peak  = max_of_vals( peak, histogram->counts[ i ] );
+        }
+    }
+
+for( uint32_t i = first; i <= last && peak; i++ )
+    {
+    uint64_t low  = i ? (uint64_t)1 << ( i - 1 ) : 0;
+    uint64_t high = i ? ( (uint64_t)1 << i ) - 1 : 0;
+    int bar = (int)( histogram->counts[ i ] * ( sizeof( HISTOGRAM_BAR ) - 1 ) / peak );
+    if( histogram->counts[ i ]
+     && !bar )
+        {
+        bar = 1;
+        }
+
+    printf( "  %10llu - %-10llu %8llu |%.*s\n", (unsigned long long)low, (unsigned long long)high, (unsigned long long)histogram->counts[ i ], bar, HISTOGRAM_BAR );
+    }
+
+} /* PrintHistogram() */
+
+
+/*******************************************************************
+*
+*   Random()
+*
+*   DESCRIPTION:
+*       Xorshift, so every run makes the same requests.
+*
+*******************************************************************/
+
+static uint32_t Random( void )
+{
+s_random_state ^= s_random_state << 13;
+s_random_state ^= s_random_state >> 17;
+s_random_state ^= s_random_state << 5;
+
+return( s_random_state );
+
+} /* Random() */
+
+
+/*******************************************************************
+*
+*   RunDepth()
+*
+*   DESCRIPTION:
+*       Run the workload at the given read depth, print its row of
+*       the table, and check every request came back as expected.
+*
+*******************************************************************/
+
+static void RunDepth( const char *file_path, const uint32_t read_depth, StreamLoaderStats *out )
+{
+s_run = {};
+s_run.is_data_ok   = true;
+s_run.is_status_ok = true;
+s_random_state = 0x2545f491;
+
+StreamLoader *loader = StreamLoader_Create( read_depth, 0 );
+StreamLoaderFile file = loader ? StreamLoader_OpenFile( file_path, loader ) : STREAM_LOADER_INVALID_FILE;
+Check( loader && file != STREAM_LOADER_INVALID_FILE, "stream loader create and open" );
+if( file == STREAM_LOADER_INVALID_FILE )
+    {
+    if( loader )
+        {
+        StreamLoader_Destroy( loader );
+        }
+    return;
+    }
+
+std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+uint32_t submitted_cnt = 0;
+bool is_submit_ok = true;
+StreamLoaderHandle last_handle = STREAM_LOADER_INVALID_HANDLE;
+while( submitted_cnt < REQUEST_CNT + 1
+    || s_run.outstanding_cnt )
+    {
+    /*------------------------------------------------
+    Top up the outstanding requests.  The first one
+    straddles the end of the file
+    ------------------------------------------------*/
+    for( uint32_t i = 0; i < cnt_of_array( s_run.requests ) && submitted_cnt < REQUEST_CNT + 1; i++ )
+        {
+        BenchRequest *request = &s_run.requests[ i ];
+        if( request->is_used )
+            {
+            continue;
+            }
+
+        *request = {};
+        request->is_past_end = ( submitted_cnt == 0 );
+        if( request->is_past_end )
+            {
+            request->size   = 2 * REQUEST_ALIGNMENT;
+            request->offset = DATA_FILE_SIZE - REQUEST_ALIGNMENT;
+            }
+        else
+            {
+            uint32_t shift = MIN_REQUEST_SHIFT + Random() % ( MAX_REQUEST_SHIFT - MIN_REQUEST_SHIFT );
+            request->size   = ( 1u << shift ) + Random() % ( 1u << shift );
+            request->offset = (uint64_t)( Random() % ( ( DATA_FILE_SIZE - request->size ) / REQUEST_ALIGNMENT ) ) * REQUEST_ALIGNMENT;
+            }
+
+        StreamLoaderRequest submit = {};
+        submit.file     = file;
+        submit.offset   = request->offset;
+        submit.size     = request->size;
+        submit.priority = (int32_t)( Random() % PRIORITY_CNT );
+        submit.done     = Deliver;
+        submit.user     = request;
+
+        request->handle = StreamLoader_Submit( &submit, loader );
+        if( request->handle == STREAM_LOADER_INVALID_HANDLE )
+            {
+            is_submit_ok = false;
+            break;
+            }
+
+        request->is_used = true;
+        last_handle = request->handle;
+        submitted_cnt++;
+        s_run.outstanding_cnt++;
+        }
+
+    if( !is_submit_ok )
+        {
+        break;
+        }
+
+    /*------------------------------------------------
+    Change our mind about a request now and then
+    ------------------------------------------------*/
+    if( Random() % CANCEL_ONE_IN == 0 )
+        {
+        BenchRequest *request = &s_run.requests[ Random() % cnt_of_array( s_run.requests ) ];
+        if( request->is_used
+         && !request->is_canceled
+         && !request->is_past_end
+         && StreamLoader_Cancel( request->handle, loader ) )
+            {
+            request->is_canceled = true;
+            s_run.canceled_cnt++;
+            }
+        }
+
+    if( Random() % REPRIORITIZE_ONE_IN == 0 )
+        {
+        BenchRequest *request = &s_run.requests[ Random() % cnt_of_array( s_run.requests ) ];
+        if( request->is_used )
+            {
+            StreamLoader_Reprioritize( request->handle, (int32_t)( Random() % PRIORITY_CNT ), loader );
+            }
+        }
+
+    if( !StreamLoader_Poll( FRAME_BYTE_BUDGET, loader ) )
+        {
+        std::this_thread::sleep_for( std::chrono::microseconds( FRAME_SLEEP_US ) );
+        }
+    }
+
+double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+StreamLoaderStats stats = {};
+StreamLoader_GetStats( loader, &stats );
+Check( is_submit_ok, "every submit was taken" );
+Check( s_run.is_data_ok, "every payload matched the file" );
+Check( s_run.is_status_ok, "every request delivered once, with the expected status" );
+Check( stats.submitted_count == REQUEST_CNT + 1, "submitted count" );
+Check( stats.delivered_count + stats.canceled_count + stats.failed_count == stats.submitted_count, "delivered, canceled and failed add up to submitted" );
+Check( stats.canceled_count == s_run.canceled_cnt && s_run.canceled_cnt, "canceled count" );
+Check( stats.failed_count == 1, "read past the end of the file failed" );
+Check( s_run.declined_cnt != 0, "declined payloads were delivered again" );
+Check( StreamLoader_GetStatus( last_handle, loader ) == STREAM_LOADER_STATUS_NONE, "delivered handle is stale" );
+
+StreamLoader_CloseFile( file, loader );
+StreamLoader_Destroy( loader );
+
+printf( "%5u %8.1f %8.1f %8llu %8llu %8llu %8llu %8llu %8llu\n",
+        read_depth,
+        (double)s_run.delivered_bytes / ( 1024.0 * 1024.0 ) / seconds,
+        stats.busy_ns ? (double)stats.bytes_read / ( 1024.0 * 1024.0 ) / ( (double)stats.busy_ns / 1e9 ) : 0.0,
+        (unsigned long long)StreamLoader_HistogramPercentile( &stats.latency_us, 0.50f ),
+        (unsigned long long)StreamLoader_HistogramPercentile( &stats.latency_us, 0.90f ),
+        (unsigned long long)StreamLoader_HistogramPercentile( &stats.latency_us, 0.99f ),
+        (unsigned long long)stats.latency_us.max,
+        (unsigned long long)StreamLoader_HistogramPercentile( &stats.read_us, 0.50f ),
+        (unsigned long long)StreamLoader_HistogramPercentile( &stats.read_us, 0.99f ) );
+
+*out = stats;
+
+} /* RunDepth() */
+
+
+/*******************************************************************
+*
+*   WriteDataFile()
+*
+*   DESCRIPTION:
+*       Write the file the requests read, DATA_FILE_SIZE bytes of
+*       PatternByte().
+*
+*******************************************************************/
+
+static bool WriteDataFile( const char *file_path )
+{
+const uint32_t chunk_sz = 1024 * 1024;
+uint8_t *chunk = (uint8_t*)malloc( chunk_sz );
+FILE *file = fopen( file_path, "wb" );
+bool ret = ( chunk && file );
+for( uint64_t at = 0; ret && at < DATA_FILE_SIZE; at += chunk_sz )
+    {
+    for( uint32_t i = 0; i < chunk_sz; i++ )
+        {
+        chunk[ i ] = PatternByte( at + i );
+        }
+
+    ret = ( fwrite( chunk, 1, chunk_sz, file ) == chunk_sz );
+    }
+
+if( file
+ && fclose( file ) )
+    {
+    ret = false;
+    }
+
+free( chunk );
+
+return( ret );
+
+} /* WriteDataFile() */
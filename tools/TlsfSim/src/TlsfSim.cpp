@@ -0,0 +1,656 @@
+/*******************************************************************
+*
+*   TlsfSim
+*
+*   DESCRIPTION:
+*       CPU-only simulation of a VKN memory pool's suballocator
+*       (src/render/vkn/memory/VknTlsf.cpp), replaying the same
+*       randomized frame workload against the TLSF allocator and a
+*       model of the linear block list it replaced.  Reports the
+*       throughput, the failed allocations and the occupancy at the
+*       first failure of each.
+*
+*       The workload is a 256 MiB pool held near 70% occupancy:
+*       log-uniform sizes from 256 B to 4 MiB, power of two
+*       alignments from 256 B to 64 KiB, and frees deferred two
+*       frames like the renderer's releaser.
+*
+*       Pass --check to also walk the TLSF block list, free lists
+*       and bitmaps every CHECK_INTERVAL frames, and verify every
+*       allocation's size and alignment.  Returns zero if every
+*       check passes.
+*
+*       Build from this directory, e.g.
+*           g++ -std=c++17 -O2 -I../../../src -I../../../src/utils -I../../../src/render/vkn/memory
+*               *.cpp ../../../src/render/vkn/memory/VknTlsf.cpp ../../../src/utils/SlabAllocator.cpp
+*               ../../../src/utils/Utilities.cpp
+*
+*******************************************************************/
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Global.hpp"
+#include "SlabAllocator.hpp"
+#include "Utilities.hpp"
+
+#include "VknTlsf.hpp"
+
+
+#define POOL_SIZE                   ( 256ull * 1024 * 1024 )
+#define GRANULARITY                 ( 64 )
+#define FRAME_CNT                   ( 20000 )
+#define OPS_PER_FRAME               ( 32 )
+#define FREE_DELAY_FRAMES           ( 2 )
+#define MAX_LIVE_CNT                ( 8192 )
+#define CHECK_INTERVAL              ( 16 )
+#define BLOCKS_PER_SLAB             ( 256 )
+#define LIST_BLOCK_CAP              ( 2000 )    /* the replaced scheme's fixed block array */
+#define LIST_MIN_SPLIT              ( 64 )
+#define NO_LIST_BLOCK               ( -1 )
+
+typedef uintptr_t SimHandle;                    /* 0 is a failed allocation */
+
+typedef SimHandle SimAllocateProc( const uint64_t size, const uint64_t alignment, void *user );
+typedef void SimFreeProc( const SimHandle handle, void *user );
+
+typedef struct _SimAllocator
+    {
+    const char         *name;
+    SimAllocateProc    *allocate;
+    SimFreeProc        *free;
+    void               *user;
+    } SimAllocator;
+
+typedef struct _SimAllocation
+    {
+    SimHandle           handle;
+    uint64_t            size;
+    } SimAllocation;
+
+typedef struct _SimResults
+    {
+    uint64_t            op_cnt;
+    uint64_t            failed_cnt;
+    double              first_failure_occupancy;
+    double              seconds;
+    } SimResults;
+
+typedef struct _ListBlock
+    {
+    uint64_t            offset;
+    uint64_t            size;
+    bool                is_used;
+    int32_t             prev;
+    int32_t             next;
+    } ListBlock;
+
+typedef struct _ListAllocator
+    {
+    ListBlock           blocks[ LIST_BLOCK_CAP ];
+    int32_t             unused[ LIST_BLOCK_CAP ];
+    uint32_t            unused_cnt;
+    } ListAllocator;
+
+typedef struct _CheckCounts
+    {
+    uint32_t            passed;
+    uint32_t            failed;
+    } CheckCounts;
+
+static CheckCounts   s_counts;
+static bool          s_is_checking;
+static uint64_t      s_random_state;
+static SimAllocation s_live[ MAX_LIVE_CNT ];
+static uint32_t      s_live_cnt;
+static SimAllocation s_pending[ FREE_DELAY_FRAMES ][ OPS_PER_FRAME ];
+static uint32_t      s_pending_cnt[ FREE_DELAY_FRAMES ];
+
+
+static void      Check( const bool is_passed, const char *what );
+static SimHandle ListAllocate( const uint64_t size, const uint64_t alignment, void *user );
+static void      ListFree( const SimHandle handle, void *user );
+static void      ListInit( const uint64_t size, ListAllocator *list );
+static uint32_t  ListUsedCount( const ListAllocator *list );
+static uint64_t  Random( void );
+static uint64_t  RandomAlignment( void );
+static uint64_t  RandomSize( void );
+static void      ReleaseAll( const SimAllocator *allocator );
+static void      Run( const SimAllocator *allocator, const VKN_tlsf_type *tlsf, SimResults *out );
+static SimHandle TlsfAllocate( const uint64_t size, const uint64_t alignment, void *user );
+static void      TlsfFree( const SimHandle handle, void *user );
+static void      ValidateTlsf( const VKN_tlsf_type *tlsf );
+
+
+/*******************************************************************
+*
+*   main()
+*
+*******************************************************************/
+
+int main( int argc, char **argv )
+{
+s_is_checking = ( argc > 1 && !strcmp( argv[ 1 ], "--check" ) );
+
+SlabAllocator block_slab;
+SlabAllocator_InitForType( VKN_tlsf_block_type, BLOCKS_PER_SLAB, SLAB_ALLOCATOR_FLAG_NONE, &block_slab );
+
+VKN_tlsf_type tlsf;
+if( !VKN_tlsf_create( POOL_SIZE, GRANULARITY, &block_slab, &tlsf ) )
+    {
+    printf( "FAILED to create the TLSF allocator\n" );
+    return( EXIT_FAILURE );
+    }
+
+SimAllocator tlsf_sim = { "tlsf", TlsfAllocate, TlsfFree, &tlsf };
+SimResults tlsf_results;
+Run( &tlsf_sim, &tlsf, &tlsf_results );
+
+VKN_tlsf_stats_type stats;
+VKN_tlsf_get_stats( &tlsf, &stats );
+printf( "%s: %5.2f Mops/s, %6llu failed allocations, first at %4.1f%% used, %u blocks (%u free), largest free block %.1f%% of free\n",
+        tlsf_sim.name,
+        tlsf_results.op_cnt / tlsf_results.seconds / 1e6,
+        (unsigned long long)tlsf_results.failed_cnt,
+        tlsf_results.first_failure_occupancy * 100.0,
+        stats.block_cnt,
+        stats.free_block_cnt,
+        stats.free_size ? 100.0 * stats.largest_free_size / stats.free_size : 0.0 );
+ReleaseAll( &tlsf_sim );
+if( s_is_checking )
+    {
+    ValidateTlsf( &tlsf );
+    Check( tlsf.free_size == tlsf.size && tlsf.block_cnt == 1, "everything freed coalesces to one block" );
+    }
+
+VKN_tlsf_destroy( &tlsf );
+
+ListAllocator *list = (ListAllocator*)malloc( sizeof(*list) );
+ListInit( POOL_SIZE, list );
+
+SimAllocator list_sim = { "list", ListAllocate, ListFree, list };
+SimResults list_results;
+Run( &list_sim, NULL, &list_results );
+printf( "%s: %5.2f Mops/s, %6llu failed allocations, first at %4.1f%% used, %u of %u blocks in use\n",
+        list_sim.name,
+        list_results.op_cnt / list_results.seconds / 1e6,
+        (unsigned long long)list_results.failed_cnt,
+        list_results.first_failure_occupancy * 100.0,
+        ListUsedCount( list ),
+        LIST_BLOCK_CAP );
+ReleaseAll( &list_sim );
+free( list );
+
+SlabAllocator_Destroy( &block_slab );
+
+if( s_is_checking )
+    {
+    printf( "%u passed, %u failed\n", s_counts.passed, s_counts.failed );
+    }
+
+return( s_counts.failed ? EXIT_FAILURE : EXIT_SUCCESS );
+
+} /* main() */
+
+
+/*******************************************************************
+*
+*   Check()
+*
+*   DESCRIPTION:
+*       Count a check, and report it if it failed.
+*
+*******************************************************************/
+
+static void Check( const bool is_passed, const char *what )
+{
+if( is_passed )
+    {
+    s_counts.passed++;
+    return;
+    }
+
+s_counts.failed++;
+printf( "FAILED %s\n", what );
+
+} /* Check() */
+
+
+/*******************************************************************
+*
+*   ListAllocate()
+*
+*   DESCRIPTION:
+*       The replaced scheme: first fit over the address ordered
+*       block list, the block rounded up to a power of two, and the
+*       remainder split off only while the fixed block array has
+*       room.
+*
+*******************************************************************/
+
+static SimHandle ListAllocate( const uint64_t size, const uint64_t alignment, void *user )
+{
+ListAllocator *list = (ListAllocator*)user;
+
+int32_t  found   = NO_LIST_BLOCK;
+uint64_t padding = 0;
+for( int32_t i = 0; i != NO_LIST_BLOCK; i = list->blocks[ i ].next )
+    {
+    ListBlock *block = &list->blocks[ i ];
+    padding = align_size_round_up( block->offset, alignment ) - block->offset;
+    if( !block->is_used
+     && block->size >= size + padding )
+        {
+        found = i;
+        break;
+        }
+    }
+
+if( found == NO_LIST_BLOCK )
+    {
+    return( 0 );
+    }
+
+ListBlock *block = &list->blocks[ found ];
+block->is_used = true;
+
+uint64_t rounded = 1;
+while( rounded < size + padding )
+    {
+    rounded *= 2;
+    }
+
+if( block->size > rounded
+ && block->size - rounded >= LIST_MIN_SPLIT
+ && list->unused_cnt > 0 )
+    {
+    int32_t split = list->unused[ --list->unused_cnt ];
+    ListBlock *tail = &list->blocks[ split ];
+    tail->offset  = block->offset + rounded;
+    tail->size    = block->size - rounded;
+    tail->is_used = false;
+    tail->prev    = found;
+    tail->next    = block->next;
+    if( block->next != NO_LIST_BLOCK )
+        {
+        list->blocks[ block->next ].prev = split;
+        }
+
+    block->next = split;
+    block->size = rounded;
+    }
+
+return( (SimHandle)found + 1 );
+
+} /* ListAllocate() */
+
+
+/*******************************************************************
+*
+*   ListFree()
+*
+*   DESCRIPTION:
+*       Free a block of the replaced scheme, coalescing it with its
+*       free neighbours.
+*
+*******************************************************************/
+
+static void ListFree( const SimHandle handle, void *user )
+{
+ListAllocator *list = (ListAllocator*)user;
+int32_t index = (int32_t)handle - 1;
+list->blocks[ index ].is_used = false;
+
+int32_t prev = list->blocks[ index ].prev;
+if( prev != NO_LIST_BLOCK
+ && !list->blocks[ prev ].is_used )
+    {
+    list->blocks[ prev ].size += list->blocks[ index ].size;
+    list->blocks[ prev ].next  = list->blocks[ index ].next;
+    if( list->blocks[ index ].next != NO_LIST_BLOCK )
+        {
+        list->blocks[ list->blocks[ index ].next ].prev = prev;
+        }
+
+    list->unused[ list->unused_cnt++ ] = index;
+    index = prev;
+    }
+
+int32_t next = list->blocks[ index ].next;
+if( next != NO_LIST_BLOCK
+ && !list->blocks[ next ].is_used )
+    {
+    list->blocks[ index ].size += list->blocks[ next ].size;
+    list->blocks[ index ].next  = list->blocks[ next ].next;
+    if( list->blocks[ next ].next != NO_LIST_BLOCK )
+        {
+        list->blocks[ list->blocks[ next ].next ].prev = index;
+        }
+
+    list->unused[ list->unused_cnt++ ] = next;
+    }
+
+} /* ListFree() */
+
+
+/*******************************************************************
+*
+*   ListInit()
+*
+*   DESCRIPTION:
+*       Start the replaced scheme with one free block covering the
+*       pool.
+*
+*******************************************************************/
+
+static void ListInit( const uint64_t size, ListAllocator *list )
+{
+memset( list, 0, sizeof(*list) );
+list->blocks[ 0 ].size = size;
+list->blocks[ 0 ].prev = NO_LIST_BLOCK;
+list->blocks[ 0 ].next = NO_LIST_BLOCK;
+for( int32_t i = LIST_BLOCK_CAP - 1; i > 0; i-- )
+    {
+    list->unused[ list->unused_cnt++ ] = i;
+    }
+
+} /* ListInit() */
+
+
+/*******************************************************************
+*
+*   ListUsedCount()
+*
+*   DESCRIPTION:
+*       Count the blocks of the fixed array in the block list.
+*
+*******************************************************************/
+
+static uint32_t ListUsedCount( const ListAllocator *list )
+{
+return( LIST_BLOCK_CAP - list->unused_cnt );
+
+} /* ListUsedCount() */
+
+
+/*******************************************************************
+*
+*   Random()
+*
+*   DESCRIPTION:
+*       xorshift64*, so every run replays the same workload.
+*
+*******************************************************************/
+
+static uint64_t Random( void )
+{
+s_random_state ^= s_random_state >> 12;
+s_random_state ^= s_random_state << 25;
+s_random_state ^= s_random_state >> 27;
+
+return( s_random_state * 0x2545f4914f6cdd1dull );
+
+} /* Random() */
+
+
+/*******************************************************************
+*
+*   RandomAlignment()
+*
+*   DESCRIPTION:
+*       A power of two alignment from 256 B to 64 KiB.
+*
+*******************************************************************/
+
+static uint64_t RandomAlignment( void )
+{
+return( 256ull << ( Random() % 9 ) );
+
+} /* RandomAlignment() */
+
+
+/*******************************************************************
+*
+*   RandomSize()
+*
+*   DESCRIPTION:
+*       A log-uniform size from 256 B to 4 MiB.
+*
+*******************************************************************/
+
+static uint64_t RandomSize( void )
+{
+double log2_size = 8.0 + 14.0 * (double)( Random() % 1000 ) / 1000.0;
+
+return( (uint64_t)exp2( log2_size ) );
+
+} /* RandomSize() */
+
+
+/*******************************************************************
+*
+*   ReleaseAll()
+*
+*   DESCRIPTION:
+*       Free everything the last Run() left allocated or pending.
+*
+*******************************************************************/
+
+static void ReleaseAll( const SimAllocator *allocator )
+{
+for( uint32_t slot = 0; slot < FREE_DELAY_FRAMES; slot++ )
+    {
+    for( uint32_t i = 0; i < s_pending_cnt[ slot ]; i++ )
+        {
+        allocator->free( s_pending[ slot ][ i ].handle, allocator->user );
+        }
+
+    s_pending_cnt[ slot ] = 0;
+    }
+
+for( uint32_t i = 0; i < s_live_cnt; i++ )
+    {
+    allocator->free( s_live[ i ].handle, allocator->user );
+    }
+
+s_live_cnt = 0;
+
+} /* ReleaseAll() */
+
+
+/*******************************************************************
+*
+*   Run()
+*
+*   DESCRIPTION:
+*       Replay the frame workload against one allocator.  Each frame
+*       first frees what was released FREE_DELAY_FRAMES ago, then
+*       makes OPS_PER_FRAME random allocations and releases, leaning
+*       towards allocating below 70% occupancy and releasing above
+*       it.  Pass the TLSF allocator to validate it when checking.
+*       What is still allocated at the end is left for ReleaseAll().
+*
+*******************************************************************/
+
+static void Run( const SimAllocator *allocator, const VKN_tlsf_type *tlsf, SimResults *out )
+{
+memset( out, 0, sizeof(*out) );
+s_random_state = 42;
+
+uint64_t live_size = 0;
+bool     is_failed = false;
+s_live_cnt = 0;
+memset( s_pending_cnt, 0, sizeof(s_pending_cnt) );
+
+uint64_t start = Utilities_GetTimeNanoseconds();
+for( uint32_t frame = 0; frame < FRAME_CNT; frame++ )
+    {
+    uint32_t slot = frame % FREE_DELAY_FRAMES;
+    for( uint32_t i = 0; i < s_pending_cnt[ slot ]; i++ )
+        {
+        allocator->free( s_pending[ slot ][ i ].handle, allocator->user );
+        out->op_cnt++;
+        }
+
+    s_pending_cnt[ slot ] = 0;
+    for( uint32_t i = 0; i < OPS_PER_FRAME; i++ )
+        {
+        uint32_t allocate_percent = ( live_size < POOL_SIZE * 7 / 10 ) ? 60 : 40;
+        bool     is_allocating    = ( s_live_cnt == 0 || Random() % 100 < allocate_percent );
+        if( is_allocating
+         && s_live_cnt < MAX_LIVE_CNT )
+            {
+            uint64_t size      = RandomSize();
+            uint64_t alignment = RandomAlignment();
+            SimHandle handle = allocator->allocate( size, alignment, allocator->user );
+            out->op_cnt++;
+            if( !handle )
+                {
+                if( !is_failed )
+                    {
+                    is_failed = true;
+                    out->first_failure_occupancy = (double)live_size / POOL_SIZE;
+                    }
+
+                out->failed_cnt++;
+                continue;
+                }
+
+            if( s_is_checking
+             && tlsf )
+                {
+                const VKN_tlsf_block_type *block = (const VKN_tlsf_block_type*)handle;
+                Check( block->size >= size, "allocation is smaller than requested" );
+                Check( ( block->offset & ( alignment - 1 ) ) == 0, "allocation is misaligned" );
+                }
+
+            s_live[ s_live_cnt ].handle = handle;
+            s_live[ s_live_cnt ].size   = size;
+            s_live_cnt++;
+            live_size += size;
+            }
+        else if( !is_allocating )
+            {
+            uint32_t victim = (uint32_t)( Random() % s_live_cnt );
+            s_pending[ slot ][ s_pending_cnt[ slot ]++ ] = s_live[ victim ];
+            live_size -= s_live[ victim ].size;
+            s_live[ victim ] = s_live[ --s_live_cnt ];
+            }
+        }
+
+    if( s_is_checking
+     && tlsf
+     && frame % CHECK_INTERVAL == 0 )
+        {
+        ValidateTlsf( tlsf );
+        }
+    }
+
+out->seconds = (double)( Utilities_GetTimeNanoseconds() - start ) / 1e9;
+
+} /* Run() */
+
+
+/*******************************************************************
+*
+*   TlsfAllocate()
+*
+*   DESCRIPTION:
+*       Allocate from the TLSF allocator.
+*
+*******************************************************************/
+
+static SimHandle TlsfAllocate( const uint64_t size, const uint64_t alignment, void *user )
+{
+return( (SimHandle)VKN_tlsf_allocate( size, alignment, (VKN_tlsf_type*)user ) );
+
+} /* TlsfAllocate() */
+
+
+/*******************************************************************
+*
+*   TlsfFree()
+*
+*   DESCRIPTION:
+*       Free to the TLSF allocator.
+*
+*******************************************************************/
+
+static void TlsfFree( const SimHandle handle, void *user )
+{
+(void)user;
+VKN_tlsf_free( (VKN_tlsf_block_type*)handle );
+
+} /* TlsfFree() */
+
+
+/*******************************************************************
+*
+*   ValidateTlsf()
+*
+*   DESCRIPTION:
+*       Walk the physical block list, the size class lists and both
+*       bitmap levels, and check they agree with each other and the
+*       allocator's counts.
+*
+*******************************************************************/
+
+static void ValidateTlsf( const VKN_tlsf_type *tlsf )
+{
+uint64_t offset         = 0;
+uint64_t free_size      = 0;
+uint32_t block_cnt      = 0;
+uint32_t free_block_cnt = 0;
+bool     is_linked      = true;
+bool     is_coalesced   = true;
+
+const VKN_tlsf_block_type *prev = NULL;
+for( const VKN_tlsf_block_type *block = tlsf->head_blocks; block; block = block->next )
+    {
+    is_linked &= ( block->prev == prev
+                && block->offset == offset
+                && block->size > 0
+                && block->size % tlsf->granularity == 0 );
+    is_coalesced &= !( prev && prev->is_free && block->is_free );
+    if( block->is_free )
+        {
+        free_size += block->size;
+        free_block_cnt++;
+        }
+
+    offset += block->size;
+    block_cnt++;
+    prev = block;
+    }
+
+Check( is_linked, "physical blocks are contiguous and linked" );
+Check( is_coalesced, "no two free blocks are neighbours" );
+Check( offset == tlsf->size, "physical blocks cover the pool" );
+Check( free_size == tlsf->free_size, "free size matches the free blocks" );
+Check( block_cnt == tlsf->block_cnt && free_block_cnt == tlsf->free_block_cnt, "block counts match" );
+
+uint32_t listed_cnt    = 0;
+bool     is_bitmap_set = true;
+bool     is_listed_free = true;
+for( uint32_t fl = 0; fl < VKN_TLSF_FL_CNT; fl++ )
+    {
+    is_bitmap_set &= ( ( ( tlsf->fl_bitmap >> fl ) & 1 ) != 0 ) == ( tlsf->sl_bitmap[ fl ] != 0 );
+    for( uint32_t sl = 0; sl < VKN_TLSF_SL_CNT; sl++ )
+        {
+        is_bitmap_set &= ( ( ( tlsf->sl_bitmap[ fl ] >> sl ) & 1 ) != 0 ) == ( tlsf->free_lists[ fl ][ sl ] != NULL );
+        for( const VKN_tlsf_block_type *block = tlsf->free_lists[ fl ][ sl ]; block; block = block->list.next )
+            {
+            is_listed_free &= block->is_free;
+            listed_cnt++;
+            }
+        }
+    }
+
+Check( is_bitmap_set, "bitmaps match the non-empty free lists" );
+Check( is_listed_free, "free lists hold only free blocks" );
+Check( listed_cnt == free_block_cnt, "every free block is listed once" );
+
+} /* ValidateTlsf() */
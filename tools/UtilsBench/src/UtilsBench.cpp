@@ -0,0 +1,142 @@
+/*******************************************************************
+*
+*   UtilsBench
+*
+*   DESCRIPTION:
+*       Stress checks and timing benchmarks for the utility
+*       allocators and containers, each against the thing it
+*       replaced or competes with:
+*
+*       - concurrent linear allocation from many threads, checked
+*         for overlap and alignment, against malloc
+*         (UtilsBenchLinear.cpp).
+*       - FlatHashMap against a random reference and against the
+*         fixed capacity HashMap (UtilsBenchFlatHashMap.cpp).
+*       - slab allocator churn against malloc (UtilsBenchSlab.cpp).
+*       - Utilities_HashBytes64 throughput against FNV-1a, checked
+*         against the scalar hashes (UtilsBenchHash.cpp).  Add
+*         -DUTILITIES_HASH_SCALAR or -mavx2 to pick the backend.
+*
+*       Each measurement repeats its pass until MIN_SECONDS have
+*       elapsed, after one untimed warm-up pass.  Returns zero if
+*       every check passes.
+*
+*       Build from this directory with the flags the game uses, e.g.
+*           g++ -std=c++17 -O2 -I../../../src -I../../../src/utils
+*               UtilsBench*.cpp ../../../src/utils/{FlatHashMap,HashMap,
+*               LinearAllocator,SlabAllocator,Utilities}.cpp -lpthread
+*
+*******************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Utilities.hpp"
+
+#include "UtilsBench.hpp"
+
+
+#define MIN_SECONDS                 ( 0.25 )
+
+typedef struct _CheckCounts
+    {
+    uint32_t            passed;
+    uint32_t            failed;
+    } CheckCounts;
+
+static CheckCounts s_counts;
+static uint64_t s_random_state = 1;
+static volatile uint64_t s_sink;
+
+
+/*******************************************************************
+*
+*   main()
+*
+*******************************************************************/
+
+int main()
+{
+UtilsBench_RunLinear();
+UtilsBench_RunFlatHashMap();
+UtilsBench_RunSlab();
+UtilsBench_RunHash();
+
+printf( "%u passed, %u failed\n", s_counts.passed, s_counts.failed );
+
+return( s_counts.failed ? EXIT_FAILURE : EXIT_SUCCESS );
+
+} /* main() */
+
+
+/*******************************************************************
+*
+*   UtilsBench_Check()
+*
+*   DESCRIPTION:
+*       Count a check, and report it if it failed.
+*
+*******************************************************************/
+
+void UtilsBench_Check( const bool is_passed, const char *what )
+{
+if( is_passed )
+    {
+    s_counts.passed++;
+    return;
+    }
+
+s_counts.failed++;
+printf( "FAILED %s\n", what );
+
+} /* UtilsBench_Check() */
+
+
+/*******************************************************************
+*
+*   UtilsBench_NsPerItem()
+*
+*   DESCRIPTION:
+*       Time the procedure, and return the mean nanoseconds per
+*       item over the timed passes.
+*
+*******************************************************************/
+
+double UtilsBench_NsPerItem( const uint64_t item_count, UtilsBenchProc *proc, void *user )
+{
+s_sink += proc( user );
+
+uint64_t pass_count = 0;
+uint64_t start      = Utilities_GetTimeNanoseconds();
+uint64_t elapsed    = 0;
+do
+    {
+    s_sink += proc( user );
+    pass_count++;
+    elapsed = Utilities_GetTimeNanoseconds() - start;
+    } while( elapsed < (uint64_t)( MIN_SECONDS * 1e9 ) );
+
+return( (double)elapsed / (double)( pass_count * item_count ) );
+
+} /* UtilsBench_NsPerItem() */
+
+
+/*******************************************************************
+*
+*   UtilsBench_Random()
+*
+*   DESCRIPTION:
+*       xorshift64*, so every run sees the same inputs.
+*
+*******************************************************************/
+
+uint32_t UtilsBench_Random( void )
+{
+s_random_state ^= s_random_state >> 12;
+s_random_state ^= s_random_state << 25;
+s_random_state ^= s_random_state >> 27;
+
+return( (uint32_t)( ( s_random_state * 0x2545f4914f6cdd1dull ) >> 32 ) );
+
+} /* UtilsBench_Random() */
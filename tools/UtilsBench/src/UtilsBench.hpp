@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+/*******************************************************************
+*
+*   UtilsBenchProc
+*
+*   DESCRIPTION:
+*       One pass of the measured work.  Returns a value derived from
+*       everything it touched, so the work can't be optimized away.
+*
+*******************************************************************/
+
+typedef uint64_t UtilsBenchProc( void *user );
+
+void     UtilsBench_Check( const bool is_passed, const char *what );
+double   UtilsBench_NsPerItem( const uint64_t item_count, UtilsBenchProc *proc, void *user );
+uint32_t UtilsBench_Random( void );
+void     UtilsBench_RunFlatHashMap( void );
+void     UtilsBench_RunHash( void );
+void     UtilsBench_RunLinear( void );
+void     UtilsBench_RunSlab( void );
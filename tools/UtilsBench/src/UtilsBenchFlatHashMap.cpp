@@ -0,0 +1,400 @@
+/*******************************************************************
+*
+*   UtilsBenchFlatHashMap
+*
+*   DESCRIPTION:
+*       FlatHashMap against the fixed capacity HashMap it stands in
+*       for.
+*
+*       The checks run random inserts, deletes and lookups against
+*       a plain array of every key, once with full keys whose hashes
+*       deliberately collide, and once with hash-only keys, growing
+*       from a near empty map so the incremental migration is live
+*       throughout.
+*
+*       The benchmark times insert, hit, miss, and delete (with the
+*       reinsert needed to repeat it) per key, with each map sized
+*       for the key count by its own rules, plus FlatHashMap inserts
+*       growing from 16 slots.
+*
+*******************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "FlatHashMap.hpp"
+#include "HashMap.hpp"
+#include "Utilities.hpp"
+
+#include "UtilsBench.hpp"
+
+
+#define CHECK_KEY_CNT               ( 50000 )
+#define CHECK_COLLIDING_HASH_CNT    ( 1000 )    /* distinct hashes the full keys share */
+#define CHECK_OP_CNT                ( 1000000 )
+#define KEY_SCRAMBLE                ( 0x9e3779b9u ) /* odd, so keys scramble without repeating */
+
+static const uint32_t KEY_COUNTS[] = { 1000, 100000 };
+
+typedef struct _HashBench
+    {
+    uint32_t            key_count;
+    uint32_t           *keys;
+    HashMap             hash_map;
+    HashMapKey         *hash_map_keys;
+    uint32_t           *hash_map_frees;
+    uint32_t           *hash_map_values;
+    FlatHashMap         flat_map;
+    } HashBench;
+
+typedef struct _HashCheck
+    {
+    bool                is_present[ CHECK_KEY_CNT ];
+    uint64_t            values[ CHECK_KEY_CNT ];
+    uint32_t            count;
+    } HashCheck;
+
+
+static void     CheckMap( const char *name, const bool is_hash_only );
+static uint64_t FlatDelete( void *user );
+static uint64_t FlatGrow( void *user );
+static uint64_t FlatHit( void *user );
+static uint64_t FlatInsert( void *user );
+static uint64_t FlatMiss( void *user );
+static uint64_t HashDelete( void *user );
+static uint64_t HashHit( void *user );
+static uint64_t HashInsert( void *user );
+static uint64_t HashMiss( void *user );
+
+
+/*******************************************************************
+*
+*   UtilsBench_RunFlatHashMap()
+*
+*******************************************************************/
+
+void UtilsBench_RunFlatHashMap( void )
+{
+CheckMap( "colliding keys", false );
+CheckMap( "hash only", true );
+
+printf( "hash maps, ns per key\n" );
+printf( "  %-12s %8s %6s %8s %8s %8s %8s %8s\n", "map", "keys", "load", "insert", "hit", "miss", "delete", "growing" );
+for( uint32_t i = 0; i < cnt_of_array( KEY_COUNTS ); i++ )
+    {
+    HashBench bench = {};
+    bench.key_count = KEY_COUNTS[ i ];
+    bench.keys      = (uint32_t*)malloc( bench.key_count * sizeof(*bench.keys) );
+    for( uint32_t j = 0; j < bench.key_count; j++ )
+        {
+        /* even multiples only, so the odd ones are certain misses */
+        bench.keys[ j ] = 2 * j * KEY_SCRAMBLE;
+        }
+
+    uint32_t capacity = HASH_MAP_ADJUST_RECOMMENDED_LUFT( bench.key_count );
+    bench.hash_map_keys   = (HashMapKey*)malloc( capacity * sizeof(*bench.hash_map_keys) );
+    bench.hash_map_frees  = (uint32_t*)malloc( capacity * sizeof(*bench.hash_map_frees) );
+    bench.hash_map_values = (uint32_t*)malloc( capacity * sizeof(*bench.hash_map_values) );
+    HashMap_Init( capacity, sizeof(*bench.hash_map_values), &bench.hash_map, bench.hash_map_keys, bench.hash_map_frees, bench.hash_map_values );
+    FlatHashMap_Init( bench.key_count, 0, sizeof(uint32_t), NULL, &bench.flat_map );
+
+    double insert   = UtilsBench_NsPerItem( bench.key_count, HashInsert, &bench );
+    double hit      = UtilsBench_NsPerItem( bench.key_count, HashHit, &bench );
+    double miss     = UtilsBench_NsPerItem( bench.key_count, HashMiss, &bench );
+    double deletion = UtilsBench_NsPerItem( bench.key_count / 2, HashDelete, &bench );
+    printf( "  %-12s %8u %6.2f %8.1f %8.1f %8.1f %8.1f %8s\n", "HashMap", bench.key_count, (double)bench.key_count / capacity, insert, hit, miss, deletion, "-" );
+
+    insert   = UtilsBench_NsPerItem( bench.key_count, FlatInsert, &bench );
+    hit      = UtilsBench_NsPerItem( bench.key_count, FlatHit, &bench );
+    miss     = UtilsBench_NsPerItem( bench.key_count, FlatMiss, &bench );
+    deletion = UtilsBench_NsPerItem( bench.key_count / 2, FlatDelete, &bench );
+    double growing = UtilsBench_NsPerItem( bench.key_count, FlatGrow, &bench );
+
+    FlatHashMapMetrics metrics;
+    FlatHashMap_ReportMetrics( &bench.flat_map, &metrics );
+    printf( "  %-12s %8u %6.2f %8.1f %8.1f %8.1f %8.1f %8.1f\n", "FlatHashMap", bench.key_count, metrics.load_factor, insert, hit, miss, deletion, growing );
+
+    FlatHashMap_Destroy( &bench.flat_map );
+    free( bench.hash_map_values );
+    free( bench.hash_map_frees );
+    free( bench.hash_map_keys );
+    free( bench.keys );
+    }
+
+} /* UtilsBench_RunFlatHashMap() */
+
+
+/*******************************************************************
+*
+*   CheckMap()
+*
+*   DESCRIPTION:
+*       Run random operations on a FlatHashMap and a plain array of
+*       every key side by side, checking they always agree.
+*
+*******************************************************************/
+
+static void CheckMap( const char *name, const bool is_hash_only )
+{
+HashCheck *check = (HashCheck*)calloc( 1, sizeof(*check) );
+FlatHashMap map;
+FlatHashMap_Init( 4, is_hash_only ? 0 : sizeof(uint32_t), sizeof(uint64_t), NULL, &map );
+
+bool is_found_agreed = true;
+bool is_value_agreed = true;
+bool is_count_agreed = true;
+for( uint32_t i = 0; i < CHECK_OP_CNT; i++ )
+    {
+    uint32_t key  = UtilsBench_Random() % CHECK_KEY_CNT;
+    uint32_t hash = is_hash_only ? key : key % CHECK_COLLIDING_HASH_CNT;
+    const void *map_key = is_hash_only ? NULL : &key;
+    switch( UtilsBench_Random() % 3 )
+        {
+        case 0:
+            {
+            uint64_t value = UtilsBench_Random();
+            FlatHashMap_Insert( hash, map_key, &value, &map );
+            check->count += !check->is_present[ key ];
+            check->is_present[ key ] = true;
+            check->values[ key ]     = value;
+            break;
+            }
+
+        case 1:
+            {
+            uint32_t out_key = ~key;
+            bool is_deleted = FlatHashMap_Delete( hash, map_key, is_hash_only ? NULL : &out_key, &map );
+            is_found_agreed &= ( is_deleted == check->is_present[ key ] );
+            is_value_agreed &= ( is_hash_only || !is_deleted || out_key == key );
+            check->count -= check->is_present[ key ];
+            check->is_present[ key ] = false;
+            break;
+            }
+
+        default:
+            {
+            uint64_t *value = (uint64_t*)FlatHashMap_At( hash, map_key, &map );
+            is_found_agreed &= ( ( value != NULL ) == check->is_present[ key ] );
+            is_value_agreed &= ( !value || *value == check->values[ key ] );
+            break;
+            }
+        }
+
+    is_count_agreed &= ( FlatHashMap_GetCount( &map ) == check->count );
+    }
+
+char what[ 128 ];
+snprintf( what, sizeof(what), "flat hash map %s: found the wrong keys", name );
+UtilsBench_Check( is_found_agreed, what );
+snprintf( what, sizeof(what), "flat hash map %s: wrong value or key", name );
+UtilsBench_Check( is_value_agreed, what );
+snprintf( what, sizeof(what), "flat hash map %s: wrong count", name );
+UtilsBench_Check( is_count_agreed, what );
+
+FlatHashMap_Destroy( &map );
+free( check );
+
+} /* CheckMap() */
+
+
+/*******************************************************************
+*
+*   FlatDelete()
+*
+*   DESCRIPTION:
+*       Delete a quarter of the keys and put them back, for a
+*       delete count of half the keys per pass.
+*
+*******************************************************************/
+
+static uint64_t FlatDelete( void *user )
+{
+HashBench *bench = (HashBench*)user;
+uint64_t   sum   = 0;
+for( uint32_t i = 0; i < bench->key_count / 4; i++ )
+    {
+    sum += FlatHashMap_Delete( bench->keys[ i ], NULL, NULL, &bench->flat_map );
+    }
+
+for( uint32_t i = 0; i < bench->key_count / 4; i++ )
+    {
+    FlatHashMap_Insert( bench->keys[ i ], NULL, &i, &bench->flat_map );
+    }
+
+return( sum );
+
+} /* FlatDelete() */
+
+
+/*******************************************************************
+*
+*   FlatGrow()
+*
+*******************************************************************/
+
+static uint64_t FlatGrow( void *user )
+{
+HashBench  *bench = (HashBench*)user;
+FlatHashMap map;
+FlatHashMap_Init( 16, 0, sizeof(uint32_t), NULL, &map );
+for( uint32_t i = 0; i < bench->key_count; i++ )
+    {
+    FlatHashMap_Insert( bench->keys[ i ], NULL, &i, &map );
+    }
+
+uint64_t count = FlatHashMap_GetCount( &map );
+FlatHashMap_Destroy( &map );
+
+return( count );
+
+} /* FlatGrow() */
+
+
+/*******************************************************************
+*
+*   FlatHit()
+*
+*******************************************************************/
+
+static uint64_t FlatHit( void *user )
+{
+HashBench *bench = (HashBench*)user;
+uint64_t   sum   = 0;
+for( uint32_t i = 0; i < bench->key_count; i++ )
+    {
+    sum += *(uint32_t*)FlatHashMap_At( bench->keys[ i ], NULL, &bench->flat_map );
+    }
+
+return( sum );
+
+} /* FlatHit() */
+
+
+/*******************************************************************
+*
+*   FlatInsert()
+*
+*******************************************************************/
+
+static uint64_t FlatInsert( void *user )
+{
+HashBench *bench = (HashBench*)user;
+FlatHashMap_Clear( &bench->flat_map );
+for( uint32_t i = 0; i < bench->key_count; i++ )
+    {
+    FlatHashMap_Insert( bench->keys[ i ], NULL, &i, &bench->flat_map );
+    }
+
+return( FlatHashMap_GetCount( &bench->flat_map ) );
+
+} /* FlatInsert() */
+
+
+/*******************************************************************
+*
+*   FlatMiss()
+*
+*******************************************************************/
+
+static uint64_t FlatMiss( void *user )
+{
+HashBench *bench = (HashBench*)user;
+uint64_t   sum   = 0;
+for( uint32_t i = 0; i < bench->key_count; i++ )
+    {
+    sum += ( FlatHashMap_At( bench->keys[ i ] + KEY_SCRAMBLE, NULL, &bench->flat_map ) != NULL );
+    }
+
+return( sum );
+
+} /* FlatMiss() */
+
+
+/*******************************************************************
+*
+*   HashDelete()
+*
+*   DESCRIPTION:
+*       Delete a quarter of the keys and put them back, for a
+*       delete count of half the keys per pass.
+*
+*******************************************************************/
+
+static uint64_t HashDelete( void *user )
+{
+HashBench *bench = (HashBench*)user;
+uint64_t   sum   = 0;
+for( uint32_t i = 0; i < bench->key_count / 4; i++ )
+    {
+    sum += HashMap_Delete( bench->keys[ i ], &bench->hash_map );
+    }
+
+for( uint32_t i = 0; i < bench->key_count / 4; i++ )
+    {
+    HashMap_Insert( bench->keys[ i ], &i, &bench->hash_map );
+    }
+
+return( sum );
+
+} /* HashDelete() */
+
+
+/*******************************************************************
+*
+*   HashHit()
+*
+*******************************************************************/
+
+static uint64_t HashHit( void *user )
+{
+HashBench *bench = (HashBench*)user;
+uint64_t   sum   = 0;
+for( uint32_t i = 0; i < bench->key_count; i++ )
+    {
+    sum += *(uint32_t*)HashMap_At( bench->keys[ i ], &bench->hash_map );
+    }
+
+return( sum );
+
+} /* HashHit() */
+
+
+/*******************************************************************
+*
+*   HashInsert()
+*
+*******************************************************************/
+
+static uint64_t HashInsert( void *user )
+{
+HashBench *bench = (HashBench*)user;
+HashMap_Init( bench->hash_map.capacity, sizeof(*bench->hash_map_values), &bench->hash_map, bench->hash_map_keys, bench->hash_map_frees, bench->hash_map_values );
+for( uint32_t i = 0; i < bench->key_count; i++ )
+    {
+    HashMap_Insert( bench->keys[ i ], &i, &bench->hash_map );
+    }
+
+return( bench->hash_map.size );
+
+} /* HashInsert() */
+
+
+/*******************************************************************
+*
+*   HashMiss()
+*
+*******************************************************************/
+
+static uint64_t HashMiss( void *user )
+{
+HashBench *bench = (HashBench*)user;
+uint64_t   sum   = 0;
+for( uint32_t i = 0; i < bench->key_count; i++ )
+    {
+    sum += ( HashMap_At( bench->keys[ i ] + KEY_SCRAMBLE, &bench->hash_map ) != NULL );
+    }
+
+return( sum );
+
+} /* HashMiss() */
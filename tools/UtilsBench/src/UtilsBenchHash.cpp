@@ -0,0 +1,285 @@
+/*******************************************************************
+*
+*   UtilsBenchHash
+*
+*   DESCRIPTION:
+*       Utilities_HashBytes64 throughput, against the byte at a time
+*       FNV-1a it replaced, over short and long keys.
+*
+*       The hash backend is picked when Utilities.cpp is compiled,
+*       so build once per backend with the same flags throughout:
+*           scalar  -DUTILITIES_HASH_SCALAR
+*           SSE2    the x86-64 default
+*           AVX2    -mavx2
+*
+*       Every backend must give the same hashes, so the checks
+*       compare against hashes recorded from the scalar build, and
+*       check that flipping any one input bit flips about half of
+*       the hash bits.
+*
+*******************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Utilities.hpp"
+
+#include "UtilsBench.hpp"
+
+
+#define BUFFER_SIZE                 ( 256 * 1024 )
+#define BENCH_BYTE_CNT              ( 1024 * 1024 )     /* per pass, so every length does similar work */
+#define SEED                        ( 0x9e3779b97f4a7c15ull )
+
+#if defined( UTILITIES_HASH_SCALAR )
+#define BACKEND_NAME                "scalar"
+#elif defined( __AVX2__ )
+#define BACKEND_NAME                "AVX2"
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define BACKEND_NAME                "SSE2"
+#else
+#define BACKEND_NAME                "scalar"
+#endif
+
+typedef struct _HashReference
+    {
+    uint32_t            len;
+    uint64_t            hash;
+    uint64_t            seeded_hash;
+    } HashReference;
+
+typedef struct _HashBench
+    {
+    const uint8_t      *buffer;
+    uint32_t            len;
+    uint32_t            key_count;
+    } HashBench;
+
+/* recorded from the scalar build, over FillBuffer() */
+static const HashReference REFERENCE_HASHES[] =
+    {
+    {    0, 0x93228a4de0eec5a2ull, 0x545f23ddcfe838c4ull },
+    {    1, 0x9676022bfd177d90ull, 0xfb3a5f6efb78178cull },
+    {    3, 0x2cb96fb680f039d3ull, 0x705531c936e48a22ull },
+    {    4, 0x00608f468834d3b2ull, 0xff924ac2387d1cb3ull },
+    {    7, 0x12078037f8e4e75eull, 0x14c5d35ccbc6aac6ull },
+    {    8, 0xa50955dcec919a0dull, 0x83b57536fbbc656aull },
+    {   15, 0x81a835d48a01bf6eull, 0xc87389b8d938a9f4ull },
+    {   16, 0x8b286f37c7e28104ull, 0xd5c53147438b5e5dull },
+    {   17, 0x352601c4b5eb6031ull, 0xbdd502ea86804c8eull },
+    {   31, 0xec10901eead37b64ull, 0xa432a4953928d5c3ull },
+    {   32, 0x4a799d4a3e942fd9ull, 0xe8010fd6d1775428ull },
+    {   33, 0xe8403e2b42d5d6acull, 0xefe9a4f20052e552ull },
+    {   63, 0xb9b8c695e151f4a5ull, 0x9b20e2d6099d487bull },
+    {   64, 0x2812d8b7e7124bfeull, 0x47d174e3cf60a40dull },
+    {   65, 0xe4e14fcdd94d4709ull, 0x7da289e988600a3cull },
+    {  127, 0xf267af0117de406cull, 0x627e62cede18a77cull },
+    {  128, 0x4e0c0c3a22884b20ull, 0x04933b83e96f5dc0ull },
+    {  129, 0x918fa3a934516c77ull, 0x78d4a587c6db46b6ull },
+    {  200, 0x4dace0841d1cc1eaull, 0x571184a1adbe2215ull },
+    {  255, 0xb4516a6ce1c5d86eull, 0x090782b6e2df7aa0ull },
+    {  256, 0x3088c4510defa456ull, 0x5a3f893e6e6aebb3ull },
+    {  257, 0x0399743313d62f83ull, 0x1258f484c7ca1bd8ull },
+    { 1000, 0xff89e06a86cd310bull, 0x3936085bc2a38d4aull },
+    { 4096, 0x289c8e1fce2b7ee6ull, 0xd4f7e8f8aa70b1c6ull },
+    { 4097, 0x1c04f084dc052845ull, 0x30f1b9d0a89c4d5dull }
+    };
+
+static const uint32_t AVALANCHE_LENS[] = { 4, 8, 16, 33, 64, 129, 1000 };
+static const uint32_t BENCH_LENS[]     = { 4, 8, 16, 32, 64, 256, 1024, 4096, 65536 };
+
+
+static uint64_t BenchFnv1a( void *user );
+static uint64_t BenchHashBytes64( void *user );
+static void     CheckAvalanche( uint8_t *buffer );
+static void     CheckReference( const uint8_t *buffer );
+static uint32_t Fnv1a( const uint8_t *bytes, const uint32_t len );
+static void     FillBuffer( uint8_t *buffer );
+
+
+/*******************************************************************
+*
+*   UtilsBench_RunHash()
+*
+*******************************************************************/
+
+void UtilsBench_RunHash( void )
+{
+uint8_t *buffer = (uint8_t*)malloc( BUFFER_SIZE );
+FillBuffer( buffer );
+
+CheckReference( buffer );
+CheckAvalanche( buffer );
+FillBuffer( buffer );
+
+printf( "string hashing (%s backend), ns per key and GB/s\n", BACKEND_NAME );
+printf( "  %8s %12s %8s %12s %8s\n", "bytes", "HashBytes64", "GB/s", "FNV-1a", "GB/s" );
+for( uint32_t i = 0; i < cnt_of_array( BENCH_LENS ); i++ )
+    {
+    HashBench bench = {};
+    bench.buffer    = buffer;
+    bench.len       = BENCH_LENS[ i ];
+    bench.key_count = max_of_vals( 1, BENCH_BYTE_CNT / bench.len );
+
+    double hash = UtilsBench_NsPerItem( bench.key_count, BenchHashBytes64, &bench );
+    double fnv  = UtilsBench_NsPerItem( bench.key_count, BenchFnv1a, &bench );
+    printf( "  %8u %12.1f %8.2f %12.1f %8.2f\n", bench.len, hash, bench.len / hash, fnv, bench.len / fnv );
+    }
+
+free( buffer );
+
+} /* UtilsBench_RunHash() */
+
+
+/*******************************************************************
+*
+*   BenchFnv1a()
+*
+*******************************************************************/
+
+static uint64_t BenchFnv1a( void *user )
+{
+HashBench *bench = (HashBench*)user;
+uint64_t   sum   = 0;
+uint32_t   start = 0;
+for( uint32_t i = 0; i < bench->key_count; i++ )
+    {
+    sum += Fnv1a( &bench->buffer[ start ], bench->len );
+    start = ( start + bench->len + 1 ) % ( BUFFER_SIZE - bench->len );
+    }
+
+return( sum );
+
+} /* BenchFnv1a() */
+
+
+/*******************************************************************
+*
+*   BenchHashBytes64()
+*
+*   DESCRIPTION:
+*       Hash keys of the bench length, each starting one byte past
+*       the end of the last, so the keys vary in their alignment.
+*
+*******************************************************************/
+
+static uint64_t BenchHashBytes64( void *user )
+{
+HashBench *bench = (HashBench*)user;
+uint64_t   sum   = 0;
+uint32_t   start = 0;
+for( uint32_t i = 0; i < bench->key_count; i++ )
+    {
+    sum += Utilities_HashBytes64( &bench->buffer[ start ], bench->len, 0 );
+    start = ( start + bench->len + 1 ) % ( BUFFER_SIZE - bench->len );
+    }
+
+return( sum );
+
+} /* BenchHashBytes64() */
+
+
+/*******************************************************************
+*
+*   CheckAvalanche()
+*
+*   DESCRIPTION:
+*       Flip each bit of the first and last eight bytes of a key in
+*       turn, and check the hash bits flipped average close to 32.
+*
+*******************************************************************/
+
+static void CheckAvalanche( uint8_t *buffer )
+{
+for( uint32_t i = 0; i < cnt_of_array( AVALANCHE_LENS ); i++ )
+    {
+    uint32_t len        = AVALANCHE_LENS[ i ];
+    uint64_t hash       = Utilities_HashBytes64( buffer, len, 0 );
+    uint32_t flip_count = 0;
+    uint32_t flip_total = 0;
+    for( uint32_t bit = 0; bit < 8 * len; bit++ )
+        {
+        if( bit >= 64 && bit < 8 * len - 64 )
+            {
+            continue;
+            }
+
+        buffer[ bit / 8 ] ^= (uint8_t)( 1 << ( bit % 8 ) );
+        uint64_t diff = hash ^ Utilities_HashBytes64( buffer, len, 0 );
+        buffer[ bit / 8 ] ^= (uint8_t)( 1 << ( bit % 8 ) );
+
+        for( ; diff; diff &= diff - 1 )
+            {
+            flip_total++;
+            }
+
+        flip_count++;
+        }
+
+    double mean = (double)flip_total / (double)flip_count;
+    char what[ 128 ];
+    snprintf( what, sizeof(what), "hash avalanche: %u byte keys flip %.1f bits on average", len, mean );
+    UtilsBench_Check( mean > 28.0 && mean < 36.0, what );
+    }
+
+} /* CheckAvalanche() */
+
+
+/*******************************************************************
+*
+*   CheckReference()
+*
+*******************************************************************/
+
+static void CheckReference( const uint8_t *buffer )
+{
+for( uint32_t i = 0; i < cnt_of_array( REFERENCE_HASHES ); i++ )
+    {
+    const HashReference *reference = &REFERENCE_HASHES[ i ];
+    char what[ 128 ];
+    snprintf( what, sizeof(what), "hash %s backend: %u byte key differs from scalar", BACKEND_NAME, reference->len );
+    UtilsBench_Check( Utilities_HashBytes64( buffer, reference->len, 0 ) == reference->hash
+                   && Utilities_HashBytes64( buffer, reference->len, SEED ) == reference->seeded_hash, what );
+    }
+
+} /* CheckReference() */
+
+
+/*******************************************************************
+*
+*   Fnv1a()
+*
+*   DESCRIPTION:
+*       The byte at a time hash Utilities_HashString used before.
+*
+*******************************************************************/
+
+static uint32_t Fnv1a( const uint8_t *bytes, const uint32_t len )
+{
+uint32_t hash = 2166136261u;
+for( uint32_t i = 0; i < len; i++ )
+    {
+    hash ^= bytes[ i ];
+    hash *= 16777619u;
+    }
+
+return( hash );
+
+} /* Fnv1a() */
+
+
+/*******************************************************************
+*
+*   FillBuffer()
+*
+*******************************************************************/
+
+static void FillBuffer( uint8_t *buffer )
+{
+for( uint32_t i = 0; i < BUFFER_SIZE; i++ )
+    {
+    buffer[ i ] = (uint8_t)( i * 131 + 7 );
+    }
+
+} /* FillBuffer() */
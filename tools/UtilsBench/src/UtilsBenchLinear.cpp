@@ -0,0 +1,331 @@
+/*******************************************************************
+*
+*   UtilsBenchLinear
+*
+*   DESCRIPTION:
+*       Concurrent linear allocation (LinearAllocator_AllocateConcurrent).
+*
+*       The stress check runs STRESS_THREAD_CNT threads allocating
+*       random sizes and alignments until the allocator is full, so
+*       many allocations race the end of the pool and take the
+*       rollback path.  Every allocation must be aligned, inside the
+*       pool, and clear of every other one, and the allocation count
+*       must match.  Owned, attached (deliberately misaligned) and
+*       detached allocators are all run.
+*
+*       The benchmark measures allocations per second from 1 to 8
+*       threads against malloc and free of the same size.
+*
+*******************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "LinearAllocator.hpp"
+#include "Utilities.hpp"
+
+#include "UtilsBench.hpp"
+
+
+#define STRESS_THREAD_CNT           ( 8 )
+#define STRESS_ROUND_CNT            ( 20 )
+#define STRESS_POOL_SIZE            ( 1024 * 1024 )
+#define STRESS_MAX_SIZE             ( 300 )
+#define STRESS_RETRY_CNT            ( 64 )      /* failed attempts, racing the full pool, before a thread stops */
+#define BENCH_ALLOCATION_SIZE       ( 64 )
+#define BENCH_ALLOCATION_CNT        ( 1000000 ) /* per thread */
+
+static const uint32_t THREAD_COUNTS[] = { 1, 2, 4, 8 };
+
+typedef struct _LinearRange
+    {
+    uint64_t            begin;
+    uint64_t            end;
+    } LinearRange;
+
+typedef struct _LinearStressThread
+    {
+    LinearAllocator    *allocator;
+    LinearRange        *ranges;
+    uint32_t            range_count;
+    uint32_t            range_capacity;
+    uint32_t            random_state;
+    uint8_t             fill;           /* 0 for a detached allocator - there is no memory */
+    bool                is_misaligned;
+    bool                is_out_of_bounds;
+    bool                is_overwritten;
+    } LinearStressThread;
+
+typedef struct _LinearBenchThread
+    {
+    LinearAllocator    *allocator;      /* NULL to use malloc */
+    void              **pointers;
+    } LinearBenchThread;
+
+
+static void   BenchThread( LinearBenchThread *thread );
+static double BenchThreads( const uint32_t thread_count, LinearAllocator *allocator );
+static int    CompareRanges( const void *a, const void *b );
+static void   StressAllocator( const char *name, const bool is_detached, LinearAllocator *allocator );
+static void   StressThread( LinearStressThread *thread );
+
+
+/*******************************************************************
+*
+*   UtilsBench_RunLinear()
+*
+*******************************************************************/
+
+void UtilsBench_RunLinear( void )
+{
+static uint8_t attached[ STRESS_POOL_SIZE / 4 ];
+
+for( uint32_t round = 0; round < STRESS_ROUND_CNT; round++ )
+    {
+    LinearAllocator allocator;
+    LinearAllocator_Init( STRESS_POOL_SIZE, &allocator );
+    StressAllocator( "owned", false, &allocator );
+
+    /* nothing is left to give, and a failure must not move the head */
+    uint64_t head = allocator.head;
+    UtilsBench_Check( !LinearAllocator_AllocateConcurrent( 2 * STRESS_POOL_SIZE, 1, &allocator ), "linear: oversized allocation succeeded" );
+    UtilsBench_Check( allocator.head == head, "linear: oversized allocation moved the head" );
+
+    LinearAllocator_Reset( &allocator );
+    StressAllocator( "owned after reset", false, &allocator );
+    LinearAllocator_Destroy( &allocator );
+
+    LinearAllocator_InitAttached( sizeof(attached) - 3, &attached[ 3 ], &allocator );
+    StressAllocator( "attached", false, &allocator );
+
+    LinearAllocator_InitDetached( STRESS_POOL_SIZE, &allocator );
+    StressAllocator( "detached", true, &allocator );
+    }
+
+/* a lone thread's failure is always rolled back */
+LinearAllocator allocator;
+LinearAllocator_Init( 1000, &allocator );
+LinearAllocator_AllocateConcurrent( 900, 1, &allocator );
+UtilsBench_Check( !LinearAllocator_AllocateConcurrent( 200, 1, &allocator ), "linear: allocation past the end succeeded" );
+UtilsBench_Check( allocator.head == 900, "linear: failed allocation was not rolled back" );
+UtilsBench_Check( LinearAllocator_AllocateConcurrent( 100, 1, &allocator ) != NULL, "linear: space after a rollback was lost" );
+LinearAllocator_Destroy( &allocator );
+
+printf( "concurrent linear allocation (%u bytes), million allocations per second\n", BENCH_ALLOCATION_SIZE );
+printf( "  %9s %12s %12s\n", "threads", "concurrent", "malloc+free" );
+for( uint32_t i = 0; i < cnt_of_array( THREAD_COUNTS ); i++ )
+    {
+    LinearAllocator_Init( (uint64_t)THREAD_COUNTS[ i ] * BENCH_ALLOCATION_CNT * ( BENCH_ALLOCATION_SIZE + 15 ), &allocator );
+    double concurrent = BenchThreads( THREAD_COUNTS[ i ], &allocator );
+    LinearAllocator_Destroy( &allocator );
+
+    double heap = BenchThreads( THREAD_COUNTS[ i ], NULL );
+    printf( "  %9u %12.1f %12.1f\n", THREAD_COUNTS[ i ], concurrent, heap );
+    }
+
+} /* UtilsBench_RunLinear() */
+
+
+/*******************************************************************
+*
+*   BenchThread()
+*
+*******************************************************************/
+
+static void BenchThread( LinearBenchThread *thread )
+{
+for( uint32_t i = 0; i < BENCH_ALLOCATION_CNT; i++ )
+    {
+    thread->pointers[ i ] = thread->allocator ? LinearAllocator_AllocateConcurrent( BENCH_ALLOCATION_SIZE, 16, thread->allocator ) : malloc( BENCH_ALLOCATION_SIZE );
+    *(volatile uint8_t*)thread->pointers[ i ] = 1;
+    }
+
+if( !thread->allocator )
+    {
+    for( uint32_t i = 0; i < BENCH_ALLOCATION_CNT; i++ )
+        {
+        free( thread->pointers[ i ] );
+        }
+    }
+
+} /* BenchThread() */
+
+
+/*******************************************************************
+*
+*   BenchThreads()
+*
+*   DESCRIPTION:
+*       Allocate from the given number of threads at once, and
+*       return the millions of allocations per second.
+*
+*******************************************************************/
+
+static double BenchThreads( const uint32_t thread_count, LinearAllocator *allocator )
+{
+LinearBenchThread threads[ STRESS_THREAD_CNT ];
+std::thread       handles[ STRESS_THREAD_CNT ];
+for( uint32_t i = 0; i < thread_count; i++ )
+    {
+    threads[ i ].allocator = allocator;
+    threads[ i ].pointers  = (void**)malloc( BENCH_ALLOCATION_CNT * sizeof(*threads[ i ].pointers) );
+    }
+
+uint64_t start = Utilities_GetTimeNanoseconds();
+for( uint32_t i = 0; i < thread_count; i++ )
+    {
+    handles[ i ] = std::thread( BenchThread, &threads[ i ] );
+    }
+
+for( uint32_t i = 0; i < thread_count; i++ )
+    {
+    handles[ i ].join();
+    }
+
+uint64_t elapsed = Utilities_GetTimeNanoseconds() - start;
+for( uint32_t i = 0; i < thread_count; i++ )
+    {
+    free( threads[ i ].pointers );
+    }
+
+return( (double)thread_count * BENCH_ALLOCATION_CNT * 1e3 / (double)elapsed );
+
+} /* BenchThreads() */
+
+
+/*******************************************************************
+*
+*   CompareRanges()
+*
+*******************************************************************/
+
+static int CompareRanges( const void *a, const void *b )
+{
+const LinearRange *range_a = (const LinearRange*)a;
+const LinearRange *range_b = (const LinearRange*)b;
+
+return( ( range_a->begin > range_b->begin ) - ( range_a->begin < range_b->begin ) );
+
+} /* CompareRanges() */
+
+
+/*******************************************************************
+*
+*   StressAllocator()
+*
+*   DESCRIPTION:
+*       Fill the allocator from STRESS_THREAD_CNT threads at once,
+*       then check what they were given.
+*
+*******************************************************************/
+
+static void StressAllocator( const char *name, const bool is_detached, LinearAllocator *allocator )
+{
+LinearStressThread threads[ STRESS_THREAD_CNT ] = {};
+std::thread        handles[ STRESS_THREAD_CNT ];
+uint32_t           range_capacity = (uint32_t)allocator->capacity;
+for( uint32_t i = 0; i < STRESS_THREAD_CNT; i++ )
+    {
+    threads[ i ].allocator      = allocator;
+    threads[ i ].ranges         = (LinearRange*)malloc( range_capacity * sizeof(*threads[ i ].ranges) );
+    threads[ i ].range_capacity = range_capacity;
+    threads[ i ].random_state   = UtilsBench_Random() | 1;
+    threads[ i ].fill           = is_detached ? 0 : (uint8_t)( i + 1 );
+    handles[ i ] = std::thread( StressThread, &threads[ i ] );
+    }
+
+uint32_t range_count = 0;
+for( uint32_t i = 0; i < STRESS_THREAD_CNT; i++ )
+    {
+    handles[ i ].join();
+    range_count += threads[ i ].range_count;
+    }
+
+LinearRange *ranges = (LinearRange*)malloc( range_count * sizeof(*ranges) );
+bool is_misaligned    = false;
+bool is_out_of_bounds = false;
+bool is_overwritten   = false;
+uint32_t write = 0;
+for( uint32_t i = 0; i < STRESS_THREAD_CNT; i++ )
+    {
+    is_misaligned    |= threads[ i ].is_misaligned;
+    is_out_of_bounds |= threads[ i ].is_out_of_bounds;
+
+    /* a neighbour writing over this thread's allocations shows as a changed fill */
+    for( uint32_t j = 0; j < threads[ i ].range_count; j++ )
+        {
+        LinearRange range = threads[ i ].ranges[ j ];
+        for( uint64_t k = range.begin; threads[ i ].fill && k < range.end; k++ )
+            {
+            is_overwritten |= ( allocator->pool[ k ] != threads[ i ].fill );
+            }
+
+        ranges[ write++ ] = range;
+        }
+
+    free( threads[ i ].ranges );
+    }
+
+qsort( ranges, range_count, sizeof(*ranges), CompareRanges );
+bool is_overlapped = false;
+for( uint32_t i = 1; i < range_count; i++ )
+    {
+    is_overlapped |= ( ranges[ i ].begin < ranges[ i - 1 ].end );
+    }
+
+free( ranges );
+
+char what[ 128 ];
+snprintf( what, sizeof(what), "linear %s: misaligned allocation", name );
+UtilsBench_Check( !is_misaligned, what );
+snprintf( what, sizeof(what), "linear %s: allocation outside the pool", name );
+UtilsBench_Check( !is_out_of_bounds, what );
+snprintf( what, sizeof(what), "linear %s: overlapping allocations", name );
+UtilsBench_Check( !is_overlapped && !is_overwritten, what );
+snprintf( what, sizeof(what), "linear %s: allocation count is off", name );
+UtilsBench_Check( range_count == allocator->allocations_cnt, what );
+
+} /* StressAllocator() */
+
+
+/*******************************************************************
+*
+*   StressThread()
+*
+*******************************************************************/
+
+static void StressThread( LinearStressThread *thread )
+{
+uint32_t failed_count = 0;
+while( failed_count < STRESS_RETRY_CNT
+    && thread->range_count < thread->range_capacity )
+    {
+    thread->random_state ^= thread->random_state << 13;
+    thread->random_state ^= thread->random_state >> 17;
+    thread->random_state ^= thread->random_state << 5;
+    uint64_t size      = 1 + thread->random_state % STRESS_MAX_SIZE;
+    uint64_t alignment = (uint64_t)1 << ( ( thread->random_state >> 16 ) % 7 );
+
+    uint8_t *ptr = (uint8_t*)LinearAllocator_AllocateConcurrent( size, alignment, thread->allocator );
+    if( !ptr )
+        {
+        failed_count++;
+        continue;
+        }
+
+    thread->is_misaligned    |= ( ( (uintptr_t)ptr & ( alignment - 1 ) ) != 0 );
+    thread->is_out_of_bounds |= ( ptr < thread->allocator->pool || ptr + size > thread->allocator->pool + thread->allocator->capacity );
+    if( thread->fill )
+        {
+        memset( ptr, thread->fill, size );
+        }
+
+    LinearRange *range = &thread->ranges[ thread->range_count++ ];
+    range->begin = (uint64_t)( ptr - thread->allocator->pool );
+    range->end   = range->begin + size;
+    }
+
+} /* StressThread() */
@@ -0,0 +1,304 @@
+/*******************************************************************
+*
+*   UtilsBenchSlab
+*
+*   DESCRIPTION:
+*       SlabAllocator churn.
+*
+*       The check frees and allocates random objects from a live set
+*       with poisoning on, stamping each object with its own address
+*       so a reused or overlapping object shows as a wrong stamp,
+*       and checks the live count and the leak report afterwards.
+*
+*       The benchmark times a free plus an allocation of a random
+*       live object, and a burst of allocations freed together,
+*       against malloc and free of the same size.
+*
+*******************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "SlabAllocator.hpp"
+#include "Utilities.hpp"
+
+#include "UtilsBench.hpp"
+
+
+#define CHECK_LIVE_CNT              ( 4096 )
+#define CHECK_OP_CNT                ( 200000 )
+#define BENCH_OBJECTS_PER_SLAB      ( 256 )
+#define BENCH_OP_CNT                ( 100000 )
+
+static const uint32_t LIVE_COUNTS[] = { 1024, 16384, 262144 };
+
+typedef struct _SlabObject
+    {
+    uint64_t            stamp;          /* the object's own address while allocated */
+    uint64_t            payload[ 2 ];
+    uint32_t            index;
+    } SlabObject;
+
+typedef struct _SlabBench
+    {
+    SlabObject        **objects;
+    uint32_t            live_count;
+    uint32_t            random_state;
+    SlabAllocator       allocator;
+    } SlabBench;
+
+
+static void     CheckChurn( void );
+static void     CountLeak( const void *object, void *user );
+static uint64_t HeapBurst( void *user );
+static uint64_t HeapChurn( void *user );
+static uint32_t NextIndex( SlabBench *bench );
+static uint64_t SlabBurst( void *user );
+static uint64_t SlabChurn( void *user );
+
+
+/*******************************************************************
+*
+*   UtilsBench_RunSlab()
+*
+*******************************************************************/
+
+void UtilsBench_RunSlab( void )
+{
+CheckChurn();
+
+printf( "slab allocator (%u byte objects), ns per free and allocation\n", (uint32_t)sizeof(SlabObject) );
+printf( "  %9s %10s %12s %10s %12s\n", "live", "slab churn", "malloc churn", "slab burst", "malloc burst" );
+for( uint32_t i = 0; i < cnt_of_array( LIVE_COUNTS ); i++ )
+    {
+    SlabBench bench = {};
+    bench.live_count   = LIVE_COUNTS[ i ];
+    bench.objects      = (SlabObject**)malloc( bench.live_count * sizeof(*bench.objects) );
+    bench.random_state = 1;
+    SlabAllocator_InitForType( SlabObject, BENCH_OBJECTS_PER_SLAB, SLAB_ALLOCATOR_FLAG_NONE, &bench.allocator );
+
+    for( uint32_t j = 0; j < bench.live_count; j++ )
+        {
+        bench.objects[ j ] = SlabAllocator_New( SlabObject, &bench.allocator );
+        bench.objects[ j ]->index = j;
+        }
+
+    double slab_churn = UtilsBench_NsPerItem( BENCH_OP_CNT, SlabChurn, &bench );
+    double slab_burst = UtilsBench_NsPerItem( bench.live_count, SlabBurst, &bench );
+    SlabAllocator_Destroy( &bench.allocator );
+
+    for( uint32_t j = 0; j < bench.live_count; j++ )
+        {
+        bench.objects[ j ] = (SlabObject*)malloc( sizeof(SlabObject) );
+        bench.objects[ j ]->index = j;
+        }
+
+    double heap_churn = UtilsBench_NsPerItem( BENCH_OP_CNT, HeapChurn, &bench );
+    double heap_burst = UtilsBench_NsPerItem( bench.live_count, HeapBurst, &bench );
+    for( uint32_t j = 0; j < bench.live_count; j++ )
+        {
+        free( bench.objects[ j ] );
+        }
+
+    printf( "  %9u %10.1f %12.1f %10.1f %12.1f\n", bench.live_count, slab_churn, heap_churn, slab_burst, heap_burst );
+    free( bench.objects );
+    }
+
+} /* UtilsBench_RunSlab() */
+
+
+/*******************************************************************
+*
+*   CheckChurn()
+*
+*******************************************************************/
+
+static void CheckChurn( void )
+{
+SlabAllocator allocator;
+SlabAllocator_InitForType( SlabObject, 64, SLAB_ALLOCATOR_FLAG_POISON, &allocator );
+
+SlabObject **live = (SlabObject**)malloc( CHECK_LIVE_CNT * sizeof(*live) );
+uint32_t live_count = 0;
+bool is_misaligned   = false;
+bool is_stamp_intact = true;
+for( uint32_t i = 0; i < CHECK_OP_CNT; i++ )
+    {
+    uint32_t random = UtilsBench_Random();
+    if( live_count == CHECK_LIVE_CNT
+     || ( live_count && random % 2 ) )
+        {
+        uint32_t index = ( random >> 1 ) % live_count;
+        is_stamp_intact &= ( live[ index ]->stamp == (uint64_t)(uintptr_t)live[ index ] );
+        live[ index ]->stamp = 0;
+        SlabAllocator_Free( live[ index ], &allocator );
+        live[ index ] = live[ --live_count ];
+        continue;
+        }
+
+    SlabObject *object = SlabAllocator_New( SlabObject, &allocator );
+    is_misaligned |= ( (uintptr_t)object % alignof(SlabObject) != 0 );
+    object->stamp = (uint64_t)(uintptr_t)object;
+    live[ live_count++ ] = object;
+    }
+
+for( uint32_t i = 0; i < live_count; i++ )
+    {
+    is_stamp_intact &= ( live[ i ]->stamp == (uint64_t)(uintptr_t)live[ i ] );
+    }
+
+uint32_t leak_count = 0;
+SlabAllocator_ReportLeaks( &allocator, CountLeak, &leak_count );
+
+UtilsBench_Check( !is_misaligned, "slab churn: misaligned object" );
+UtilsBench_Check( is_stamp_intact, "slab churn: object handed out twice" );
+UtilsBench_Check( allocator.live_count == live_count, "slab churn: wrong live count" );
+UtilsBench_Check( leak_count == live_count, "slab churn: wrong leak report" );
+UtilsBench_Check( allocator.peak_live_count <= CHECK_LIVE_CNT, "slab churn: wrong peak live count" );
+
+for( uint32_t i = 0; i < live_count; i++ )
+    {
+    SlabAllocator_Free( live[ i ], &allocator );
+    }
+
+UtilsBench_Check( allocator.live_count == 0, "slab churn: objects left after freeing all" );
+SlabAllocator_Destroy( &allocator );
+free( live );
+
+} /* CheckChurn() */
+
+
+/*******************************************************************
+*
+*   CountLeak()
+*
+*******************************************************************/
+
+static void CountLeak( const void *object, void *user )
+{
+(void)object;
+( *(uint32_t*)user )++;
+
+} /* CountLeak() */
+
+
+/*******************************************************************
+*
+*   HeapBurst()
+*
+*******************************************************************/
+
+static uint64_t HeapBurst( void *user )
+{
+SlabBench *bench = (SlabBench*)user;
+for( uint32_t i = 0; i < bench->live_count; i++ )
+    {
+    free( bench->objects[ i ] );
+    }
+
+uint64_t sum = 0;
+for( uint32_t i = 0; i < bench->live_count; i++ )
+    {
+    bench->objects[ i ] = (SlabObject*)malloc( sizeof(SlabObject) );
+    bench->objects[ i ]->index = i;
+    sum += (uintptr_t)bench->objects[ i ];
+    }
+
+return( sum );
+
+} /* HeapBurst() */
+
+
+/*******************************************************************
+*
+*   HeapChurn()
+*
+*******************************************************************/
+
+static uint64_t HeapChurn( void *user )
+{
+SlabBench *bench = (SlabBench*)user;
+uint64_t   sum   = 0;
+for( uint32_t i = 0; i < BENCH_OP_CNT; i++ )
+    {
+    uint32_t index = NextIndex( bench );
+    free( bench->objects[ index ] );
+    bench->objects[ index ] = (SlabObject*)malloc( sizeof(SlabObject) );
+    bench->objects[ index ]->index = index;
+    sum += (uintptr_t)bench->objects[ index ];
+    }
+
+return( sum );
+
+} /* HeapChurn() */
+
+
+/*******************************************************************
+*
+*   NextIndex()
+*
+*   DESCRIPTION:
+*       Pick the next live object to churn.  A private generator
+*       keeps the choice cheap next to the work being timed.
+*
+*******************************************************************/
+
+static uint32_t NextIndex( SlabBench *bench )
+{
+bench->random_state = bench->random_state * 1103515245 + 12345;
+
+return( ( bench->random_state >> 8 ) % bench->live_count );
+
+} /* NextIndex() */
+
+
+/*******************************************************************
+*
+*   SlabBurst()
+*
+*******************************************************************/
+
+static uint64_t SlabBurst( void *user )
+{
+SlabBench *bench = (SlabBench*)user;
+for( uint32_t i = 0; i < bench->live_count; i++ )
+    {
+    SlabAllocator_Free( bench->objects[ i ], &bench->allocator );
+    }
+
+uint64_t sum = 0;
+for( uint32_t i = 0; i < bench->live_count; i++ )
+    {
+    bench->objects[ i ] = SlabAllocator_New( SlabObject, &bench->allocator );
+    bench->objects[ i ]->index = i;
+    sum += (uintptr_t)bench->objects[ i ];
+    }
+
+return( sum );
+
+} /* SlabBurst() */
+
+
+/*******************************************************************
+*
+*   SlabChurn()
+*
+*******************************************************************/
+
+static uint64_t SlabChurn( void *user )
+{
+SlabBench *bench = (SlabBench*)user;
+uint64_t   sum   = 0;
+for( uint32_t i = 0; i < BENCH_OP_CNT; i++ )
+    {
+    uint32_t index = NextIndex( bench );
+    SlabAllocator_Free( bench->objects[ index ], &bench->allocator );
+    bench->objects[ index ] = SlabAllocator_New( SlabObject, &bench->allocator );
+    bench->objects[ index ]->index = index;
+    sum += (uintptr_t)bench->objects[ index ];
+    }
+
+return( sum );
+
+} /* SlabChurn() */